@@ -0,0 +1,475 @@
+/**
+ * @file AppSysEntropy.c
+ * @brief [SYSTEM] Entropy pool: health tested TRNG bytes, refilled in the background.
+ * @details TRNG seeding and reseeding, chunk generation, continuous health tests and the pool.
+ *          See AppSysEntropy.h.
+ * @author Chipsbank
+ * @date 2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "AppSysEntropy.h"
+
+#if (APP_ENTROPY_ENABLE == APP_TRUE)
+#include <string.h>
+#include "APP_common.h"
+#include "CB_trng.h"
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include "NonLIB_sharedUtils.h"
+#endif
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef APP_ENTROPY_NOW
+  #if (APP_FREERTOS_ENABLE == APP_TRUE)
+    #define APP_ENTROPY_NOW()       ((uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS))
+  #else
+    #define APP_ENTROPY_NOW()       cb_hal_get_tick()
+  #endif
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define APP_ENTROPY_CHUNK_BYTES       (APP_ENTROPY_CHUNK_WORDS * 4U)
+#define APP_ENTROPY_BLOCK_WORDS       4           // AES block, duplicate block test
+#define APP_ENTROPY_ADDIN_WORDS       12          // Additional input of AES-256: seed length, 384 bits
+
+#define APP_ENTROPY_LOCK(primask)     do { (primask) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define APP_ENTROPY_UNLOCK(primask)   __set_PRIMASK(primask)
+
+#if ((APP_ENTROPY_POOL_SIZE & (APP_ENTROPY_POOL_SIZE - 1)) != 0)
+#error "APP_ENTROPY_POOL_SIZE must be a power of 2"
+#endif
+#if (((APP_ENTROPY_CHUNK_WORDS % APP_ENTROPY_BLOCK_WORDS) != 0) || ((APP_ENTROPY_CHUNK_WORDS * 4) > APP_ENTROPY_POOL_SIZE))
+#error "APP_ENTROPY_CHUNK_WORDS must be a multiple of 4 and fit in the pool"
+#endif
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+enum
+{
+  APP_ENTROPY_HEALTH_PASS = 0,
+  APP_ENTROPY_HEALTH_RCT,
+  APP_ENTROPY_HEALTH_APT,
+  APP_ENTROPY_HEALTH_DUP,
+};
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/** Continuous health test state, over the chunks accepted since the last seeding */
+typedef struct
+{
+  uint8_t  rctValue;
+  uint8_t  rctRun;
+  uint8_t  aptValue;
+  uint8_t  aptCount;
+  uint16_t aptSeen;             // Bytes of the window, 0: new window
+  uint8_t  blockValid;
+  uint32_t block[APP_ENTROPY_BLOCK_WORDS];    // Last block
+} app_entropy_health_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void    app_entropy_wipe(void *data, uint32_t len);
+static uint8_t app_entropy_health(const uint32_t *chunk);
+static uint8_t app_entropy_seed(void);
+static uint8_t app_entropy_reseed(void);
+static void    app_entropy_fail(void);
+static void    app_entropy_stop(void);
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static const stTrngConfig   s_config = { .Alg = EN_CB_TRNG_AES256, .UseAddIn = APP_TRUE, .PredResist = APP_FALSE };
+static uint8_t              s_pool[APP_ENTROPY_POOL_SIZE];
+static uint32_t             s_poolRead;           // Oldest byte
+static volatile uint32_t    s_poolCount;
+static app_entropy_health_t s_health;
+static app_entropy_stats_t  s_stats;
+static volatile uint8_t     s_state = APP_ENTROPY_STATE_OFF;
+static uint8_t              s_failRun;            // Failures since the last chunk accepted
+static uint32_t             s_seedBytes;          // Generated since the last seeding
+static uint32_t             s_seedTick;
+static uint32_t             s_addinCounter;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Clears random bytes, not optimised away.
+ */
+static void app_entropy_wipe(void *data, uint32_t len)
+{
+  volatile uint8_t *bytes = (volatile uint8_t *)data;
+
+  while (len-- != 0U)
+  {
+    *bytes++ = 0;
+  }
+}
+
+/**
+ * @brief Continuous health tests of a chunk, the state is kept only if it passes.
+ *
+ * @return APP_ENTROPY_HEALTH_PASS, or the failed test.
+ */
+static uint8_t app_entropy_health(const uint32_t *chunk)
+{
+  app_entropy_health_t health = s_health;
+  const uint8_t       *bytes  = (const uint8_t *)chunk;
+
+  for (uint32_t i = 0; i < APP_ENTROPY_CHUNK_BYTES; i++)
+  {
+    // Repetition count
+    if ((health.rctRun != 0U) && (bytes[i] == health.rctValue))
+    {
+      if (++health.rctRun >= APP_ENTROPY_RCT_CUTOFF)
+      {
+        return APP_ENTROPY_HEALTH_RCT;
+      }
+    }
+    else
+    {
+      health.rctValue = bytes[i];
+      health.rctRun   = 1;
+    }
+
+    // Adaptive proportion: the first byte of the window is counted in the rest of it
+    if (health.aptSeen == 0U)
+    {
+      health.aptValue = bytes[i];
+      health.aptCount = 1;
+    }
+    else if (bytes[i] == health.aptValue)
+    {
+      if (++health.aptCount >= APP_ENTROPY_APT_CUTOFF)
+      {
+        return APP_ENTROPY_HEALTH_APT;
+      }
+    }
+    health.aptSeen = (uint16_t)((health.aptSeen + 1U) % APP_ENTROPY_APT_WINDOW);
+  }
+
+  // Duplicate block: a stuck DRBG repeats its output
+  for (uint32_t i = 0; i < APP_ENTROPY_CHUNK_WORDS; i += APP_ENTROPY_BLOCK_WORDS)
+  {
+    if ((health.blockValid == APP_TRUE) && (memcmp(health.block, &chunk[i], sizeof(health.block)) == 0))
+    {
+      return APP_ENTROPY_HEALTH_DUP;
+    }
+    memcpy(health.block, &chunk[i], sizeof(health.block));
+    health.blockValid = APP_TRUE;
+  }
+
+  s_health = health;
+  app_entropy_wipe(&health, sizeof(health));
+  return APP_ENTROPY_HEALTH_PASS;
+}
+
+/**
+ * @brief Known answer test, then seeding of the DRBG from the noise source.
+ *
+ * @return APP_TRUE, APP_FALSE if the KAT or the seeding failed.
+ */
+static uint8_t app_entropy_seed(void)
+{
+  uint32_t alarms = 0;
+
+  s_stats.katRuns++;
+  app_entropy_wipe(&s_health, sizeof(s_health));
+  if (CB_TRNG_RunKat(&alarms) != 0U)
+  {
+    return APP_FALSE;
+  }
+  // The KAT runs the DRBG on its own vectors: instantiate again
+  if (CB_TRNG_Snoise(&s_config) != EN_CB_TRNG_OK)
+  {
+    s_stats.trngErrors++;
+    return APP_FALSE;
+  }
+  s_seedBytes = 0;
+  s_seedTick  = APP_ENTROPY_NOW();
+  return APP_TRUE;
+}
+
+/**
+ * @brief Reseeds the DRBG from the noise source.
+ *
+ * @return APP_TRUE, APP_FALSE if the reseeding failed.
+ */
+static uint8_t app_entropy_reseed(void)
+{
+  if (CB_TRNG_ReSnoise(&s_config) != EN_CB_TRNG_OK)
+  {
+    s_stats.trngErrors++;
+    return APP_FALSE;
+  }
+  s_stats.reseeds++;
+  s_seedBytes = 0;
+  s_seedTick  = APP_ENTROPY_NOW();
+  return APP_TRUE;
+}
+
+/**
+ * @brief Recovers the TRNG after a failure, stops the pool if it keeps failing.
+ */
+static void app_entropy_fail(void)
+{
+  if ((++s_failRun >= APP_ENTROPY_FAIL_MAX) || (app_entropy_seed() != APP_TRUE))
+  {
+    app_entropy_stop();
+  }
+}
+
+/**
+ * @brief Stops serving: the pool is cleared.
+ */
+static void app_entropy_stop(void)
+{
+  uint32_t primask;
+
+  APP_ENTROPY_LOCK(primask);
+  s_state = APP_ENTROPY_STATE_FAILED;
+  app_entropy_wipe(s_pool, sizeof(s_pool));
+  s_poolRead  = 0;
+  s_poolCount = 0;
+  APP_ENTROPY_UNLOCK(primask);
+}
+
+/**
+ * @brief Starts the TRNG, runs the KAT, seeds and fills the pool.
+ *
+ * @return APP_TRUE, APP_FALSE if the TRNG failed: the pool is stopped.
+ */
+uint8_t app_entropy_init(void)
+{
+  s_state = APP_ENTROPY_STATE_OFF;
+  app_entropy_wipe(s_pool, sizeof(s_pool));
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_stats.lowWater = APP_ENTROPY_POOL_SIZE;
+  s_poolRead       = 0;
+  s_poolCount      = 0;
+  s_failRun        = 0;
+
+  CB_TRNG_Init();
+  if (app_entropy_seed() != APP_TRUE)
+  {
+    app_entropy_stop();
+    return APP_FALSE;
+  }
+  s_state = APP_ENTROPY_STATE_RUNNING;
+
+  for (uint32_t i = 0; i < (APP_ENTROPY_POOL_SIZE / APP_ENTROPY_CHUNK_BYTES); i++)
+  {
+    app_entropy_process();
+  }
+  return (s_state == APP_ENTROPY_STATE_RUNNING) ? APP_TRUE : APP_FALSE;
+}
+
+/**
+ * @brief Stops the pool and the TRNG.
+ */
+void app_entropy_deinit(void)
+{
+  app_entropy_stop();
+  s_state = APP_ENTROPY_STATE_OFF;
+  CB_TRNG_Deinit();
+}
+
+/**
+ * @brief Reseeds when due and generates a chunk if the pool has room for it.
+ *
+ * Not reentrant and blocking for one TRNG request: call from the main loop or a low priority task.
+ */
+void app_entropy_process(void)
+{
+  uint32_t chunk[APP_ENTROPY_CHUNK_WORDS];
+  uint32_t addin[APP_ENTROPY_ADDIN_WORDS] = {0};
+  uint32_t primask;
+  uint32_t write;
+  uint8_t  result;
+
+  if (s_state != APP_ENTROPY_STATE_RUNNING)
+  {
+    return;
+  }
+  if ((s_seedBytes >= APP_ENTROPY_RESEED_BYTES) ||
+      ((APP_ENTROPY_RESEED_MS != 0) && ((uint32_t)(APP_ENTROPY_NOW() - s_seedTick) >= APP_ENTROPY_RESEED_MS)))
+  {
+    if (app_entropy_reseed() != APP_TRUE)
+    {
+      app_entropy_fail();
+      return;
+    }
+  }
+  // Only app_entropy_get() changes the count meanwhile, and it only makes room
+  if ((APP_ENTROPY_POOL_SIZE - s_poolCount) < APP_ENTROPY_CHUNK_BYTES)
+  {
+    return;
+  }
+
+  // Additional input: unique per request, not secret
+  addin[0] = ++s_addinCounter;
+  addin[1] = APP_ENTROPY_NOW();
+  addin[2] = s_stats.generated;
+  addin[3] = s_stats.reseeds;
+  switch (CB_TRNG_GetRngWithAddin(chunk, APP_ENTROPY_CHUNK_WORDS, addin))
+  {
+    case EN_CB_TRNG_OK:
+      break;
+    case EN_CB_TRNG_RESEED:
+      if (app_entropy_reseed() != APP_TRUE)
+      {
+        app_entropy_fail();
+      }
+      return;
+    default:
+      s_stats.trngErrors++;
+      app_entropy_fail();
+      return;
+  }
+
+  result = app_entropy_health(chunk);
+  if (result != APP_ENTROPY_HEALTH_PASS)
+  {
+    if (result == APP_ENTROPY_HEALTH_RCT)
+    {
+      s_stats.rctFailures++;
+    }
+    else if (result == APP_ENTROPY_HEALTH_APT)
+    {
+      s_stats.aptFailures++;
+    }
+    else
+    {
+      s_stats.dupFailures++;
+    }
+    app_entropy_wipe(chunk, sizeof(chunk));
+    app_entropy_fail();
+    return;
+  }
+
+  APP_ENTROPY_LOCK(primask);
+  write = s_poolRead + s_poolCount;
+  for (uint32_t i = 0; i < APP_ENTROPY_CHUNK_BYTES; i++)
+  {
+    s_pool[(write + i) & (APP_ENTROPY_POOL_SIZE - 1U)] = ((const uint8_t *)chunk)[i];
+  }
+  s_poolCount += APP_ENTROPY_CHUNK_BYTES;
+  APP_ENTROPY_UNLOCK(primask);
+
+  app_entropy_wipe(chunk, sizeof(chunk));
+  s_failRun          = 0;
+  s_seedBytes       += APP_ENTROPY_CHUNK_BYTES;
+  s_stats.generated += APP_ENTROPY_CHUNK_BYTES;
+}
+
+/**
+ * @brief Takes random bytes from the pool. Any context, no TRNG access.
+ *
+ * @param out Random bytes.
+ * @param len Bytes, all or none are served.
+ * @return APP_TRUE, APP_FALSE if the pool has fewer bytes (counted as exhausted) or is stopped.
+ */
+uint8_t app_entropy_get(void *out, uint32_t len)
+{
+  uint8_t *bytes = (uint8_t *)out;
+  uint32_t primask;
+
+  APP_ENTROPY_LOCK(primask);
+  if ((s_state != APP_ENTROPY_STATE_RUNNING) || (s_poolCount < len))
+  {
+    if (s_state == APP_ENTROPY_STATE_RUNNING)
+    {
+      s_stats.exhausted++;
+    }
+    APP_ENTROPY_UNLOCK(primask);
+    return APP_FALSE;
+  }
+  for (uint32_t i = 0; i < len; i++)
+  {
+    uint32_t index = (s_poolRead + i) & (APP_ENTROPY_POOL_SIZE - 1U);
+    bytes[i]      = s_pool[index];
+    s_pool[index] = 0;
+  }
+  s_poolRead     = (s_poolRead + len) & (APP_ENTROPY_POOL_SIZE - 1U);
+  s_poolCount   -= len;
+  s_stats.served += len;
+  if (s_poolCount < s_stats.lowWater)
+  {
+    s_stats.lowWater = s_poolCount;
+  }
+  APP_ENTROPY_UNLOCK(primask);
+  return APP_TRUE;
+}
+
+/**
+ * @brief Takes a random word from the pool, see app_entropy_get().
+ */
+uint8_t app_entropy_get_u32(uint32_t *value)
+{
+  return app_entropy_get(value, sizeof(uint32_t));
+}
+
+/**
+ * @brief Bytes in the pool.
+ */
+uint32_t app_entropy_available(void)
+{
+  return s_poolCount;
+}
+
+/**
+ * @brief Runs the known answer test of the TRNG and seeds it again, e.g. periodically.
+ *
+ * Blocking, same context as app_entropy_process(). A failed test stops the pool.
+ *
+ * @return APP_TRUE, APP_FALSE if the test failed or the pool is not running.
+ */
+uint8_t app_entropy_run_kat(void)
+{
+  if (s_state != APP_ENTROPY_STATE_RUNNING)
+  {
+    return APP_FALSE;
+  }
+  if (app_entropy_seed() != APP_TRUE)
+  {
+    app_entropy_stop();
+    return APP_FALSE;
+  }
+  return APP_TRUE;
+}
+
+/**
+ * @brief Pool state.
+ */
+app_entropy_state_t app_entropy_get_state(void)
+{
+  return (app_entropy_state_t)s_state;
+}
+
+/**
+ * @brief Pool statistics since app_entropy_init().
+ */
+void app_entropy_get_stats(app_entropy_stats_t *stats)
+{
+  uint32_t primask;
+
+  APP_ENTROPY_LOCK(primask);
+  *stats           = s_stats;
+  stats->state     = (app_entropy_state_t)s_state;
+  stats->available = s_poolCount;
+  APP_ENTROPY_UNLOCK(primask);
+}
+
+#endif // APP_ENTROPY_ENABLE
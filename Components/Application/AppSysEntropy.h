@@ -0,0 +1,111 @@
+/**
+ * @file AppSysEntropy.h
+ * @brief [SYSTEM] Entropy pool: health tested TRNG bytes, refilled in the background.
+ * @details The pool owns the TRNG: app_entropy_init() runs the known answer test (CB_TRNG_RunKat)
+ *          and seeds the DRBG from the noise source (AES-256). app_entropy_process(), called from
+ *          the main loop or a low priority task, generates a chunk of APP_ENTROPY_CHUNK_WORDS with
+ *          CB_TRNG_GetRngWithAddin() per call while the pool has room, and reseeds
+ *          (CB_TRNG_ReSnoise) every APP_ENTROPY_RESEED_BYTES or APP_ENTROPY_RESEED_MS.
+ *          Each chunk passes continuous health tests before it enters the pool:
+ *          - repetition count: APP_ENTROPY_RCT_CUTOFF identical bytes in a row,
+ *          - adaptive proportion: APP_ENTROPY_APT_CUTOFF copies of the first byte of a window of
+ *            APP_ENTROPY_APT_WINDOW bytes,
+ *          - duplicate block: a 16-byte block equal to the previous one.
+ *          Cutoffs are those of NIST SP 800-90B 4.4 for 8 bits of entropy per byte. A failed
+ *          chunk is discarded and the TRNG recovered (KAT, seeding); APP_ENTROPY_FAIL_MAX failures
+ *          in a row, or a failed KAT, stop the pool (APP_ENTROPY_STATE_FAILED) until the next
+ *          app_entropy_init().
+ *          app_entropy_get() serves bytes from the pool, from any context: a copy under a short
+ *          interrupt lock, no TRNG access. A request larger than the pool content fails whole
+ *          and is counted as exhausted; served bytes are cleared from the pool.
+ *          Other users of CB_TRNG_* must stop while the pool runs.
+ *          With APP_ENTROPY_ENABLE (APP_CompileOption.h) set to APP_FALSE, AppSysEntropy.c is empty.
+ * @author Chipsbank
+ * @date 2024
+ */
+
+#ifndef __APP_SYS_ENTROPY_H
+#define __APP_SYS_ENTROPY_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "APP_CompileOption.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#ifndef APP_ENTROPY_ENABLE
+#define APP_ENTROPY_ENABLE APP_FALSE
+#endif
+
+#ifndef APP_ENTROPY_POOL_SIZE
+#define APP_ENTROPY_POOL_SIZE       256         /**< Bytes, power of 2 */
+#endif
+#ifndef APP_ENTROPY_CHUNK_WORDS
+#define APP_ENTROPY_CHUNK_WORDS     8           /**< Generated per app_entropy_process() call, multiple of 4 */
+#endif
+#ifndef APP_ENTROPY_RESEED_BYTES
+#define APP_ENTROPY_RESEED_BYTES    65536       /**< Generated between reseeds */
+#endif
+#ifndef APP_ENTROPY_RESEED_MS
+#define APP_ENTROPY_RESEED_MS       600000      /**< Time between reseeds, 0: by bytes only */
+#endif
+#define APP_ENTROPY_RCT_CUTOFF      6           /**< 1 + 40 / 8: false alarm 2^-40 */
+#define APP_ENTROPY_APT_WINDOW      512
+#define APP_ENTROPY_APT_CUTOFF      13          /**< Binomial(512, 2^-8): false alarm 2^-20 per window */
+#define APP_ENTROPY_FAIL_MAX        3           /**< Health or TRNG failures in a row stopping the pool */
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+typedef enum
+{
+  APP_ENTROPY_STATE_OFF = 0,                  /**< app_entropy_init() not called */
+  APP_ENTROPY_STATE_RUNNING,
+  APP_ENTROPY_STATE_FAILED,                   /**< KAT or health tests failed, nothing served */
+} app_entropy_state_t;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Pool statistics since app_entropy_init().
+ */
+typedef struct
+{
+  app_entropy_state_t state;
+  uint32_t available;                         /**< Bytes in the pool */
+  uint32_t lowWater;                          /**< Fewest bytes left after an app_entropy_get() */
+  uint32_t served;                            /**< Bytes */
+  uint32_t exhausted;                         /**< app_entropy_get() refused, pool too low */
+  uint32_t generated;                         /**< Bytes passing the health tests */
+  uint32_t reseeds;
+  uint32_t katRuns;
+  uint32_t rctFailures;                       /**< Chunks discarded by each health test */
+  uint32_t aptFailures;
+  uint32_t dupFailures;
+  uint32_t trngErrors;                        /**< CB_TRNG_* errors other than a reseed request */
+} app_entropy_stats_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+#if (APP_ENTROPY_ENABLE == APP_TRUE)
+uint8_t             app_entropy_init(void);
+void                app_entropy_deinit(void);
+void                app_entropy_process(void);
+uint8_t             app_entropy_get(void *out, uint32_t len);
+uint8_t             app_entropy_get_u32(uint32_t *value);
+uint32_t            app_entropy_available(void);
+uint8_t             app_entropy_run_kat(void);
+app_entropy_state_t app_entropy_get_state(void);
+void                app_entropy_get_stats(app_entropy_stats_t *stats);
+#endif
+
+#endif // __APP_SYS_ENTROPY_H
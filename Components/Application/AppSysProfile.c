@@ -0,0 +1,387 @@
+/**
+ * @file AppSysProfile.c
+ * @brief [SYSTEM] CPU profiling on the DWT cycle counter.
+ * @details Cycle counter extension, interrupt wrappers, region markers and the dump.
+ *          See AppSysProfile.h.
+ * @author Chipsbank
+ * @date 2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "AppSysProfile.h"
+
+#if (APP_PROFILE_ENABLE == APP_TRUE)
+#include <string.h>
+#include "APP_common.h"
+#include "app_uart.h"
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#define APP_PROF_TASK_MAX       8   // Tasks reported by the dump
+#define APP_PROF_NEST_MAX       9   // Interrupt nesting: preemption levels and thread
+
+#ifndef APP_PROF_CYCLES
+#define APP_PROF_CYCLES()       (DWT->CYCCNT)
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define APP_PROF_LOCK(primask)    do { (primask) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define APP_PROF_UNLOCK(primask)  __set_PRIMASK(primask)
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+#define APP_PROF_IRQ_ENUM(handler)  APP_PROF_IRQ_##handler,
+enum
+{
+  APP_PROF_IRQ_LIST(APP_PROF_IRQ_ENUM)
+  APP_PROF_IRQ_NUM
+};
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+typedef struct
+{
+  TaskHandle_t handle;
+  uint64_t runTime;
+} app_prof_task_mark_t;
+#endif
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+#define APP_PROF_IRQ_HANDLER_PROTOTYPE(handler)  void handler(void);
+APP_PROF_IRQ_LIST(APP_PROF_IRQ_HANDLER_PROTOTYPE)
+
+static void     app_prof_stat_add(app_prof_stat_t *stat, uint32_t cycles);
+static void     app_prof_stat_print(const char *name, const app_prof_stat_t *stat, uint64_t window);
+static uint32_t app_prof_isr_enter(void);
+static void     app_prof_isr_exit(uint32_t index, uint32_t start);
+static uint32_t app_prof_permille(uint64_t part, uint64_t whole);
+static uint32_t app_prof_us(uint64_t cycles);
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+#define APP_PROF_IRQ_NAME(handler)  #handler,
+static const char * const s_irqName[APP_PROF_IRQ_NUM] = { APP_PROF_IRQ_LIST(APP_PROF_IRQ_NAME) };
+
+static app_prof_stat_t    s_irqStat[APP_PROF_IRQ_NUM];
+static uint32_t           s_isrDepth;
+static uint32_t           s_isrNested[APP_PROF_NEST_MAX];  // Cycles of nested handlers, per depth
+static app_prof_region_t *s_regionList;
+static uint32_t           s_cyclesLast;
+static uint32_t           s_cyclesHigh;
+static uint64_t           s_windowStart;
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+static app_prof_task_mark_t s_taskMark[APP_PROF_TASK_MAX];
+static TaskStatus_t         s_taskStatus[APP_PROF_TASK_MAX];
+#endif
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Enables the cycle counter and starts the first window.
+ *
+ * Called by the kernel before the scheduler starts (portCONFIGURE_TIMER_FOR_RUN_TIME_STATS),
+ * or by the application in a bare metal build. The counter is not cleared: other users of
+ * DWT->CYCCNT only take differences.
+ */
+void app_prof_init(void)
+{
+#ifdef DWT
+  if (!(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk))
+  {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  }
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+  s_cyclesLast  = APP_PROF_CYCLES();
+  s_windowStart = app_prof_cycles64();
+}
+
+/**
+ * @brief Reads the cycle counter extended to 64 bits.
+ *
+ * The 32 bit counter wraps every 2^32 cycles (67 s at 64 MHz); a wrap is seen as long as this
+ * is called at least once per wrap. The tick does it with the run time stats hooks of the example
+ * FreeRTOSConfig.h (traceTASK_INCREMENT_TICK); without them, dump more often than every 67 s.
+ *
+ * @return CPU cycles.
+ */
+uint64_t app_prof_cycles64(void)
+{
+  uint32_t primask;
+  uint64_t cycles;
+
+  APP_PROF_LOCK(primask);
+  uint32_t now = APP_PROF_CYCLES();
+  if (now < s_cyclesLast)
+  {
+    s_cyclesHigh++;
+  }
+  s_cyclesLast = now;
+  cycles = ((uint64_t)s_cyclesHigh << 32) | now;
+  APP_PROF_UNLOCK(primask);
+  return cycles;
+}
+
+/**
+ * @brief Adds one duration to a statistic.
+ *
+ * @param stat   Statistic, count 0 when empty.
+ * @param cycles Duration.
+ */
+static void app_prof_stat_add(app_prof_stat_t *stat, uint32_t cycles)
+{
+  if ((stat->count == 0) || (cycles < stat->min))
+  {
+    stat->min = cycles;
+  }
+  if (cycles > stat->max)
+  {
+    stat->max = cycles;
+  }
+  stat->total += cycles;
+  stat->count++;
+}
+
+/**
+ * @brief Starts the time of an interrupt handler.
+ *
+ * @return Cycle counter at entry.
+ */
+static uint32_t app_prof_isr_enter(void)
+{
+  uint32_t primask;
+  uint32_t start;
+
+  APP_PROF_LOCK(primask);
+  if (s_isrDepth < APP_PROF_NEST_MAX)
+  {
+    s_isrNested[s_isrDepth] = 0;
+  }
+  s_isrDepth++;
+  start = APP_PROF_CYCLES();
+  APP_PROF_UNLOCK(primask);
+  return start;
+}
+
+/**
+ * @brief Ends the time of an interrupt handler.
+ *
+ * The handler is charged its time minus the time of the handlers that preempted it; its whole
+ * time is charged as nested time to the handler it preempted, if any.
+ *
+ * @param index Handler, APP_PROF_IRQ_*.
+ * @param start Cycle counter at entry.
+ */
+static void app_prof_isr_exit(uint32_t index, uint32_t start)
+{
+  uint32_t primask;
+
+  APP_PROF_LOCK(primask);
+  uint32_t elapsed = APP_PROF_CYCLES() - start;
+  uint32_t own = elapsed;
+  s_isrDepth--;
+  if (s_isrDepth < APP_PROF_NEST_MAX)
+  {
+    own -= s_isrNested[s_isrDepth];
+  }
+  if ((s_isrDepth > 0) && (s_isrDepth <= APP_PROF_NEST_MAX))
+  {
+    s_isrNested[s_isrDepth - 1] += elapsed;
+  }
+  app_prof_stat_add(&s_irqStat[index], own);
+  APP_PROF_UNLOCK(primask);
+}
+
+#define APP_PROF_IRQ_WRAPPER(handler)                     \
+  void app_prof_##handler(void)                           \
+  {                                                       \
+    uint32_t start = app_prof_isr_enter();                \
+    handler();                                            \
+    app_prof_isr_exit(APP_PROF_IRQ_##handler, start);     \
+  }
+APP_PROF_IRQ_LIST(APP_PROF_IRQ_WRAPPER)
+
+/**
+ * @brief Starts a region, see APP_PROF_REGION_BEGIN.
+ *
+ * @param region Region, linked to the dump list on its first use.
+ * @return Cycle counter at the start.
+ */
+uint32_t app_prof_region_begin(app_prof_region_t *region)
+{
+  if (region->linked == APP_FALSE)
+  {
+    uint32_t primask;
+    APP_PROF_LOCK(primask);
+    if (region->linked == APP_FALSE)
+    {
+      region->next   = s_regionList;
+      region->linked = APP_TRUE;
+      s_regionList   = region;
+    }
+    APP_PROF_UNLOCK(primask);
+  }
+  return APP_PROF_CYCLES();
+}
+
+/**
+ * @brief Ends a region, see APP_PROF_REGION_END.
+ *
+ * @param region Region.
+ * @param start  Cycle counter at the start.
+ */
+void app_prof_region_end(app_prof_region_t *region, uint32_t start)
+{
+  uint32_t primask;
+  uint32_t elapsed = APP_PROF_CYCLES() - start;
+
+  APP_PROF_LOCK(primask);
+  app_prof_stat_add(&region->stat, elapsed);
+  APP_PROF_UNLOCK(primask);
+}
+
+/**
+ * @brief Clears the interrupt and region statistics and starts a new window.
+ */
+void app_prof_reset(void)
+{
+  uint32_t primask;
+
+  APP_PROF_LOCK(primask);
+  memset(s_irqStat, 0, sizeof(s_irqStat));
+  for (app_prof_region_t *region = s_regionList; region != NULL; region = region->next)
+  {
+    memset(&region->stat, 0, sizeof(region->stat));
+  }
+  APP_PROF_UNLOCK(primask);
+
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+  uint32_t taskCount = uxTaskGetSystemState(s_taskStatus, APP_PROF_TASK_MAX, NULL);
+  memset(s_taskMark, 0, sizeof(s_taskMark));
+  for (uint32_t i = 0; i < taskCount; i++)
+  {
+    s_taskMark[i].handle  = s_taskStatus[i].xHandle;
+    s_taskMark[i].runTime = s_taskStatus[i].ulRunTimeCounter;
+  }
+#endif
+  s_windowStart = app_prof_cycles64();
+}
+
+/**
+ * @brief Part of a whole in 1/1000.
+ */
+static uint32_t app_prof_permille(uint64_t part, uint64_t whole)
+{
+  return (whole == 0) ? 0 : (uint32_t)((part * 1000) / whole);
+}
+
+/**
+ * @brief Cycles to microseconds.
+ */
+static uint32_t app_prof_us(uint64_t cycles)
+{
+  return (uint32_t)(cycles / (SystemCoreClock / 1000000));
+}
+
+/**
+ * @brief Prints one statistic line: calls, total, share of the window, average, min and max.
+ */
+static void app_prof_stat_print(const char *name, const app_prof_stat_t *stat, uint64_t window)
+{
+  uint32_t share = app_prof_permille(stat->total, window);
+  app_uart_printf("%-40s %8u %10u %3u.%u %8u %8u %8u\n", name, stat->count, app_prof_us(stat->total),
+                  share / 10, share % 10, (uint32_t)(stat->total / stat->count), stat->min, stat->max);
+}
+
+/**
+ * @brief Prints the statistics of the current window.
+ *
+ * Totals are in microseconds and shares in percent of the window; average, min and max in
+ * CPU cycles. Each statistic is copied with interrupts masked, then printed.
+ *
+ * @param reset APP_TRUE to start a new window after the print.
+ */
+void app_prof_dump(uint8_t reset)
+{
+  uint32_t primask;
+  app_prof_stat_t stat;
+  app_prof_stat_t isrTotal = {0};
+  uint64_t window = app_prof_cycles64() - s_windowStart;
+
+  app_uart_printf("profile: window %u us, %u MHz\n", app_prof_us(window), SystemCoreClock / 1000000);
+
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+  uint32_t taskCount = uxTaskGetSystemState(s_taskStatus, APP_PROF_TASK_MAX, NULL);
+  app_uart_printf("%-40s %10s %5s %6s\n", "task", "us", "%", "stack");
+  for (uint32_t i = 0; i < taskCount; i++)
+  {
+    uint64_t runTime = s_taskStatus[i].ulRunTimeCounter;
+    for (uint32_t j = 0; j < APP_PROF_TASK_MAX; j++)
+    {
+      if ((s_taskMark[j].handle == s_taskStatus[i].xHandle) && (s_taskMark[j].runTime <= runTime))
+      {
+        runTime -= s_taskMark[j].runTime;
+        break;
+      }
+    }
+    uint32_t share = app_prof_permille(runTime, window);
+    app_uart_printf("%-40s %10u %3u.%u %6u\n", s_taskStatus[i].pcTaskName, app_prof_us(runTime),
+                    share / 10, share % 10, (uint32_t)s_taskStatus[i].usStackHighWaterMark);
+  }
+#endif
+
+  app_uart_printf("%-40s %8s %10s %5s %8s %8s %8s\n", "irq", "calls", "us", "%", "avg", "min", "max");
+  for (uint32_t i = 0; i < APP_PROF_IRQ_NUM; i++)
+  {
+    APP_PROF_LOCK(primask);
+    stat = s_irqStat[i];
+    APP_PROF_UNLOCK(primask);
+    if (stat.count != 0)
+    {
+      app_prof_stat_print(s_irqName[i], &stat, window);
+      isrTotal.total += stat.total;
+      isrTotal.count += stat.count;
+      isrTotal.min = ((isrTotal.min == 0) || (stat.min < isrTotal.min)) ? stat.min : isrTotal.min;
+      isrTotal.max = (stat.max > isrTotal.max) ? stat.max : isrTotal.max;
+    }
+  }
+  if (isrTotal.count != 0)
+  {
+    app_prof_stat_print("all interrupts", &isrTotal, window);
+  }
+
+  app_uart_printf("%-40s %8s %10s %5s %8s %8s %8s\n", "region", "calls", "us", "%", "avg", "min", "max");
+  for (app_prof_region_t *region = s_regionList; region != NULL; region = region->next)
+  {
+    APP_PROF_LOCK(primask);
+    stat = region->stat;
+    APP_PROF_UNLOCK(primask);
+    if (stat.count != 0)
+    {
+      app_prof_stat_print(region->name, &stat, window);
+    }
+  }
+
+  if (reset == APP_TRUE)
+  {
+    app_prof_reset();
+  }
+}
+
+#endif // APP_PROFILE_ENABLE
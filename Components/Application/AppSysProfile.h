@@ -0,0 +1,139 @@
+/**
+ * @file AppSysProfile.h
+ * @brief [SYSTEM] CPU profiling on the DWT cycle counter.
+ * @details Where the CPU time goes, counted in CPU cycles:
+ *          - FreeRTOS run time stats: the kernel run time counter is the cycle counter extended
+ *            to 64 bits, so each task gets its own share. The hooks are in the FreeRTOSConfig.h of
+ *            the example (dfu_app, uwb_CLI); examples built with the shared config of
+ *            External/FreeRTOS get the interrupts and regions only.
+ *          - Interrupts: the UWB and peripheral vectors of startup_ARMCM33.c go through a
+ *            wrapper counting calls, total and longest time of each handler. Time spent in a
+ *            nested higher priority handler is charged to that handler only.
+ *          - Regions: APP_PROF_REGION_BEGIN/END around a named block of code, in task or
+ *            interrupt context.
+ *          Collection costs a few cycles per event and no print; app_prof_dump() prints the
+ *          totals over app_uart on demand. With APP_PROFILE_ENABLE (APP_CompileOption.h) set to
+ *          APP_FALSE, the markers expand to nothing, the vectors are unchanged and
+ *          AppSysProfile.c is empty.
+ * @author Chipsbank
+ * @date 2024
+ */
+
+#ifndef __APP_SYS_PROFILE_H
+#define __APP_SYS_PROFILE_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "APP_CompileOption.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#ifndef APP_PROFILE_ENABLE
+#define APP_PROFILE_ENABLE APP_FALSE
+#endif
+
+/**
+ * @brief Vectors accounted by the profiler, X(handler).
+ */
+#if __has_include(<CB_ble.h>)
+  #define APP_PROF_IRQ_LIST_BLE(X)  X(CB_BLE_IRQ_Handler)
+#else
+  #define APP_PROF_IRQ_LIST_BLE(X)
+#endif
+#define APP_PROF_IRQ_LIST(X)                       \
+  X(cb_dma_irqhandler)                             \
+  X(cb_crypto_irqhandler)                          \
+  X(cb_pka_irqhandler)                             \
+  X(cb_trng_irqhandler)                            \
+  X(cb_crc_irqhandler)                             \
+  X(cb_gpio_irqhandler)                            \
+  X(cb_spi_irqhandler)                             \
+  X(cb_uart_0_irqhandler)                          \
+  X(cb_uart_1_irqhandler)                          \
+  X(cb_i2c_irqhandler)                             \
+  X(cb_timer_0_irqhandler)                         \
+  X(cb_timer_1_irqhandler)                         \
+  X(cb_timer_2_irqhandler)                         \
+  X(cb_timer_3_irqhandler)                         \
+  APP_PROF_IRQ_LIST_BLE(X)                         \
+  X(cb_uwb_rx0_done_irqhandler)                    \
+  X(cb_uwb_rx0_preamble_detected_irqhandler)       \
+  X(cb_uwb_rx0_sfd_detected_irqhandler)            \
+  X(cb_uwb_rx1_done_irqhandler)                    \
+  X(cb_uwb_rx1_preamble_detected_irqhandler)       \
+  X(cb_uwb_rx1_sfd_detected_irqhandler)            \
+  X(cb_uwb_rx2_done_irqhandler)                    \
+  X(cb_uwb_rx2_preamble_detected_irqhandler)       \
+  X(cb_uwb_rx2_sfd_detected_irqhandler)            \
+  X(cb_uwb_rx_sts_cir_end_irqhandler)              \
+  X(cb_uwb_rx_phr_detected_irqhandler)             \
+  X(cb_uwb_rx_done_irqhandler)                     \
+  X(cb_uwb_tx_done_irqhandler)                     \
+  X(cb_uwb_tx_sfd_mark_irqhandler)
+
+#if (APP_PROFILE_ENABLE == APP_TRUE)
+  /** Vector table entry of a profiled handler */
+  #define APP_PROF_VECTOR(handler)    app_prof_##handler
+  /** Start timing the region tag, ended by APP_PROF_REGION_END(tag) in the same scope */
+  #define APP_PROF_REGION_BEGIN(tag)                                              \
+    static app_prof_region_t app_prof_region_##tag = {.name = #tag};               \
+    uint32_t app_prof_start_##tag = app_prof_region_begin(&app_prof_region_##tag)
+  #define APP_PROF_REGION_END(tag)    app_prof_region_end(&app_prof_region_##tag, app_prof_start_##tag)
+#else
+  #define APP_PROF_VECTOR(handler)    handler
+  #define APP_PROF_REGION_BEGIN(tag)
+  #define APP_PROF_REGION_END(tag)
+#endif
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Accumulated durations, in CPU cycles.
+ */
+typedef struct
+{
+  uint64_t total;
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+} app_prof_stat_t;
+
+/**
+ * @brief Named code region, linked on its first use.
+ */
+typedef struct app_prof_region
+{
+  const char *name;
+  app_prof_stat_t stat;
+  struct app_prof_region *next;
+  uint8_t linked;
+} app_prof_region_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+#if (APP_PROFILE_ENABLE == APP_TRUE)
+void     app_prof_init(void);
+uint64_t app_prof_cycles64(void);
+uint32_t app_prof_region_begin(app_prof_region_t *region);
+void     app_prof_region_end(app_prof_region_t *region, uint32_t start);
+void     app_prof_reset(void);
+void     app_prof_dump(uint8_t reset);
+
+#define APP_PROF_IRQ_WRAPPER_PROTOTYPE(handler)  void app_prof_##handler(void);
+APP_PROF_IRQ_LIST(APP_PROF_IRQ_WRAPPER_PROTOTYPE)
+#endif
+
+#endif // __APP_SYS_PROFILE_H
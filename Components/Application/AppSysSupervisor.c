@@ -0,0 +1,476 @@
+/**
+ * @file AppSysSupervisor.c
+ * @brief [SYSTEM] Task supervisor feeding the hardware watchdog.
+ * @details Client deadlines, check-in trace, watchdog feeding and the fault record.
+ *          See AppSysSupervisor.h.
+ * @author Chipsbank
+ * @date 2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "AppSysSupervisor.h"
+
+#if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+#include <stddef.h>
+#include <string.h>
+#include "APP_common.h"
+#include "CB_wdt.h"
+#include "app_uart.h"
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include "NonLIB_sharedUtils.h"
+#endif
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef APP_SUP_NOW
+  #if (APP_FREERTOS_ENABLE == APP_TRUE)
+    #define APP_SUP_NOW()       ((uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS))
+  #else
+    #define APP_SUP_NOW()       cb_hal_get_tick()
+  #endif
+#endif
+
+/** Not cleared at startup: RW_NOINIT_RAM of the scatter file (UNINIT) */
+#ifndef APP_SUP_NOINIT
+#define APP_SUP_NOINIT          __attribute__((section(".bss.noinit")))
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define APP_SUP_MAGIC             0x50555357  // "WSUP"
+
+#define APP_SUP_LOCK(primask)     do { (primask) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define APP_SUP_UNLOCK(primask)   __set_PRIMASK(primask)
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+enum
+{
+  APP_SUP_STATE_IDLE = 0,
+  APP_SUP_STATE_PENDING,        // Waiting for the watchdog to be free
+  APP_SUP_STATE_RUNNING,
+};
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  const char *name;
+  uint32_t    deadlineMs;       // 0: free
+  uint32_t    lastTick;
+  uint8_t     suspended;
+} app_sup_client_t;
+
+typedef struct
+{
+  uint32_t        magic;
+  app_sup_fault_t fault;
+  uint32_t        check;
+} app_sup_record_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+void            app_sup_nmi_capture(const uint32_t *frame);
+static uint32_t app_sup_checksum(const app_sup_record_t *record);
+static uint8_t  app_sup_overdue(uint32_t now, uint32_t *overdueMs);
+static void     app_sup_trace_add(uint8_t id, uint8_t mark, uint32_t now);
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static app_sup_record_t s_record APP_SUP_NOINIT;
+static app_sup_client_t s_client[APP_SUP_CLIENT_MAX];
+static app_sup_trace_t  s_trace[APP_SUP_TRACE_DEPTH];
+static uint32_t         s_traceNext;          // Ring: next entry
+static uint32_t         s_traceCount;
+static app_sup_fault_t  s_lastFault;          // Record found by app_sup_init()
+static uint8_t          s_lastFaultValid;
+static uint32_t         s_wdtTimeoutMs;
+static uint32_t         s_lastService;
+static uint8_t          s_state = APP_SUP_STATE_IDLE;
+static uint8_t          s_offender = APP_SUP_ID_NONE;  // First client seen overdue, latched
+static uint32_t         s_offenderOverdueMs;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Takes the fault record of the previous run and arms the supervisor.
+ *
+ * The watchdog is started by the first app_sup_service() that finds it free. Register the clients
+ * after this call: their deadlines are checked against the watchdog period.
+ *
+ * @param wdtTimeoutMs Watchdog period, longer than the app_sup_service() period and than every
+ *                     client deadline.
+ */
+void app_sup_init(uint32_t wdtTimeoutMs)
+{
+  s_lastFaultValid = APP_FALSE;
+  if ((s_record.magic == APP_SUP_MAGIC) && (s_record.check == app_sup_checksum(&s_record)))
+  {
+    s_lastFault      = s_record.fault;
+    s_lastFaultValid = APP_TRUE;
+  }
+  s_record.magic = 0;
+
+  memset(s_client, 0, sizeof(s_client));
+  memset(s_trace, 0, sizeof(s_trace));
+  s_traceNext         = 0;
+  s_traceCount        = 0;
+  s_offender          = APP_SUP_ID_NONE;
+  s_offenderOverdueMs = 0;
+  s_wdtTimeoutMs      = wdtTimeoutMs;
+  s_lastService       = APP_SUP_NOW();
+  s_state             = APP_SUP_STATE_PENDING;
+}
+
+/**
+ * @brief Registers a client, healthy until deadlineMs after now.
+ *
+ * The deadline must be shorter than the watchdog period: a client stuck in a call that also
+ * blocks app_sup_service() is then past its deadline when the watchdog runs out, and is named in
+ * the fault record instead of an overdue app_sup_service().
+ *
+ * @param name       Kept by reference, reported on a fault.
+ * @param deadlineMs Longest time between two check-ins, not 0, shorter than the watchdog period.
+ * @return Client id, APP_SUP_ID_NONE if the deadline is refused or the table is full.
+ */
+uint8_t app_sup_register(const char *name, uint32_t deadlineMs)
+{
+  uint32_t primask;
+  uint8_t  id = APP_SUP_ID_NONE;
+
+  if ((deadlineMs == 0) || ((s_wdtTimeoutMs != 0) && (deadlineMs >= s_wdtTimeoutMs)))
+  {
+    return APP_SUP_ID_NONE;
+  }
+  APP_SUP_LOCK(primask);
+  for (uint8_t i = 0; i < APP_SUP_CLIENT_MAX; i++)
+  {
+    if (s_client[i].deadlineMs == 0)
+    {
+      s_client[i].name       = name;
+      s_client[i].deadlineMs = deadlineMs;
+      s_client[i].lastTick   = APP_SUP_NOW();
+      s_client[i].suspended  = APP_FALSE;
+      id = i;
+      break;
+    }
+  }
+  APP_SUP_UNLOCK(primask);
+  return id;
+}
+
+/**
+ * @brief The client made progress: its deadline restarts.
+ *
+ * @param id   Client.
+ * @param mark Client defined value kept in the trace, e.g. its state.
+ */
+void app_sup_checkin(uint8_t id, uint8_t mark)
+{
+  if (id >= APP_SUP_CLIENT_MAX)
+  {
+    return;
+  }
+  uint32_t now = APP_SUP_NOW();
+  s_client[id].lastTick = now;
+  app_sup_trace_add(id, mark, now);
+}
+
+/**
+ * @brief Adds a trace entry without restarting the deadline, e.g. on a state change.
+ */
+void app_sup_mark(uint8_t id, uint8_t mark)
+{
+  if (id >= APP_SUP_CLIENT_MAX)
+  {
+    return;
+  }
+  app_sup_trace_add(id, mark, APP_SUP_NOW());
+}
+
+/**
+ * @brief Stops supervising a client, e.g. while it waits for an event with no time limit.
+ */
+void app_sup_suspend(uint8_t id)
+{
+  if (id < APP_SUP_CLIENT_MAX)
+  {
+    s_client[id].suspended = APP_TRUE;
+  }
+}
+
+/**
+ * @brief Supervises the client again, its deadline restarting now.
+ */
+void app_sup_resume(uint8_t id)
+{
+  if (id < APP_SUP_CLIENT_MAX)
+  {
+    s_client[id].lastTick  = APP_SUP_NOW();
+    s_client[id].suspended = APP_FALSE;
+  }
+}
+
+/**
+ * @brief Refreshes the watchdog if every client is within its deadline.
+ *
+ * Call it more often than the watchdog period, from a task, a loop or a periodic interrupt. Once
+ * a client has missed its deadline the watchdog is not refreshed anymore, even if the client
+ * recovers: the chip resets with that client in the fault record.
+ *
+ * @return APP_TRUE if the watchdog was refreshed.
+ */
+uint8_t app_sup_service(void)
+{
+  uint32_t primask;
+  uint32_t overdueMs;
+  uint32_t now = APP_SUP_NOW();
+
+  if (s_state == APP_SUP_STATE_PENDING)
+  {
+    if (cb_wdt_is_running())
+    {
+      return APP_FALSE;     // RC calibration
+    }
+    stWdtConfig config = {
+      .WdtMode       = EN_WDT_RESET,
+      .WdtRunInSleep = 0,
+      .WdtRunInHalt  = 0,
+      .GraceAfterInt = APP_SUP_WDT_GRACE_MS,
+      .Interval      = s_wdtTimeoutMs,
+    };
+    cb_wdt_init(&config);
+    cb_wdt_enable();
+    s_state = APP_SUP_STATE_RUNNING;
+  }
+  if (s_state != APP_SUP_STATE_RUNNING)
+  {
+    return APP_FALSE;
+  }
+
+  APP_SUP_LOCK(primask);
+  s_lastService = now;
+  if (s_offender == APP_SUP_ID_NONE)
+  {
+    s_offender = app_sup_overdue(now, &overdueMs);
+    s_offenderOverdueMs = overdueMs;
+  }
+  APP_SUP_UNLOCK(primask);
+
+  if (s_offender != APP_SUP_ID_NONE)
+  {
+    return APP_FALSE;
+  }
+  cb_wdt_refresh();
+  return APP_TRUE;
+}
+
+/**
+ * @brief Fault record of the run before the last reset.
+ *
+ * @param fault Copy of the record.
+ * @return APP_TRUE if app_sup_init() found one.
+ */
+uint8_t app_sup_get_fault(app_sup_fault_t *fault)
+{
+  if (s_lastFaultValid != APP_TRUE)
+  {
+    return APP_FALSE;
+  }
+  *fault = s_lastFault;
+  return APP_TRUE;
+}
+
+/**
+ * @brief Prints the fault record of the run before the last reset, if any.
+ */
+void app_sup_report(void)
+{
+  const app_sup_fault_t *fault = &s_lastFault;
+
+  if (s_lastFaultValid != APP_TRUE)
+  {
+    return;
+  }
+  if (fault->id == APP_SUP_ID_NONE)
+  {
+    app_uart_printf("Supervisor reset #%u at %u ms: app_sup_service() not called for %u ms\n",
+                    fault->resets, fault->tick, fault->overdueMs);
+  }
+  else
+  {
+    app_uart_printf("Supervisor reset #%u at %u ms: client %u \"%s\" %u ms over its deadline\n",
+                    fault->resets, fault->tick, fault->id, fault->name, fault->overdueMs);
+  }
+  app_uart_printf("  PC 0x%08X LR 0x%08X xPSR 0x%08X (%s %u)\n", fault->pc, fault->lr, fault->xpsr,
+                  ((fault->xpsr & 0x1FF) == 0) ? "thread" : "exception", fault->xpsr & 0x1FF);
+  for (uint32_t i = 0; i < APP_SUP_TRACE_DEPTH; i++)
+  {
+    const app_sup_trace_t *trace = &fault->trace[i];
+    if (trace->id != APP_SUP_ID_NONE)
+    {
+      app_uart_printf("  client %u mark %u x%u, last at %u ms\n", trace->id, trace->mark, trace->count, trace->tick);
+    }
+  }
+}
+
+#if defined(__arm__) || defined(__ICCARM__)
+/**
+ * @brief Watchdog NMI: passes the stacked exception frame to app_sup_nmi_capture(), then
+ *        goes on to NMI_Handler (interrupt clear, RC calibration and application callbacks).
+ */
+__attribute__((naked)) void app_sup_nmi_handler(void)
+{
+  __ASM volatile(
+    "tst   lr, #4               \n"
+    "ite   eq                   \n"
+    "mrseq r0, msp              \n"
+    "mrsne r0, psp              \n"
+    "push  {r0, lr}             \n"
+    "bl    app_sup_nmi_capture  \n"
+    "pop   {r0, lr}             \n"
+    "b     NMI_Handler          \n"
+  );
+}
+#endif // Cortex-M only: the host tests call app_sup_nmi_capture()
+
+/**
+ * @brief Saves the fault record, the watchdog resets the chip APP_SUP_WDT_GRACE_MS later.
+ *
+ * @param frame Exception frame: r0, r1, r2, r3, r12, lr, pc, xpsr.
+ */
+void app_sup_nmi_capture(const uint32_t *frame)
+{
+  app_sup_fault_t *fault = &s_record.fault;
+  uint32_t now = APP_SUP_NOW();
+  uint32_t overdueMs = s_offenderOverdueMs;
+  uint8_t  id = s_offender;
+
+  if (s_state != APP_SUP_STATE_RUNNING)
+  {
+    return;
+  }
+  if (id == APP_SUP_ID_NONE)
+  {
+    id = app_sup_overdue(now, &overdueMs);
+  }
+  if (id == APP_SUP_ID_NONE)
+  {
+    overdueMs = now - s_lastService;
+  }
+
+  memset(&s_record, 0, sizeof(s_record));
+  fault->resets    = (s_lastFaultValid == APP_TRUE) ? (s_lastFault.resets + 1) : 1;
+  fault->tick      = now;
+  fault->lr        = frame[5];
+  fault->pc        = frame[6];
+  fault->xpsr      = frame[7];
+  fault->overdueMs = overdueMs;
+  fault->id        = id;
+  if ((id != APP_SUP_ID_NONE) && (s_client[id].name != NULL))
+  {
+    strncpy(fault->name, s_client[id].name, APP_SUP_NAME_SIZE - 1);
+  }
+  for (uint32_t i = 0; i < APP_SUP_TRACE_DEPTH; i++)
+  {
+    if (i < s_traceCount)
+    {
+      fault->trace[i] = s_trace[(s_traceNext + APP_SUP_TRACE_DEPTH - s_traceCount + i) % APP_SUP_TRACE_DEPTH];
+    }
+    else
+    {
+      fault->trace[i].id = APP_SUP_ID_NONE;
+    }
+  }
+  s_record.magic = APP_SUP_MAGIC;
+  s_record.check = app_sup_checksum(&s_record);
+  s_state = APP_SUP_STATE_IDLE;   // One record per expiry
+}
+
+/**
+ * @brief Checksum of the magic and the fault, a stale or random record does not match.
+ */
+static uint32_t app_sup_checksum(const app_sup_record_t *record)
+{
+  const uint32_t *word = (const uint32_t *)record;
+  uint32_t sum = 0x5A5A5A5A;
+
+  for (uint32_t i = 0; i < (offsetof(app_sup_record_t, check) / sizeof(uint32_t)); i++)
+  {
+    sum = ((sum << 5) | (sum >> 27)) + word[i];
+  }
+  return sum;
+}
+
+/**
+ * @brief The active client furthest past its deadline.
+ *
+ * @param now       Current tick.
+ * @param overdueMs Time past the deadline of the client returned.
+ * @return Client id, APP_SUP_ID_NONE if all are within their deadline.
+ */
+static uint8_t app_sup_overdue(uint32_t now, uint32_t *overdueMs)
+{
+  uint8_t id = APP_SUP_ID_NONE;
+
+  *overdueMs = 0;
+  for (uint8_t i = 0; i < APP_SUP_CLIENT_MAX; i++)
+  {
+    const app_sup_client_t *client = &s_client[i];
+    uint32_t elapsed = now - client->lastTick;
+    if ((client->deadlineMs != 0) && (client->suspended != APP_TRUE) && (elapsed > client->deadlineMs) &&
+        ((id == APP_SUP_ID_NONE) || ((elapsed - client->deadlineMs) > *overdueMs)))
+    {
+      id = i;
+      *overdueMs = elapsed - client->deadlineMs;
+    }
+  }
+  return id;
+}
+
+/**
+ * @brief Adds a check-in to the trace ring, merged with the last entry if it is the same.
+ */
+static void app_sup_trace_add(uint8_t id, uint8_t mark, uint32_t now)
+{
+  uint32_t primask;
+
+  APP_SUP_LOCK(primask);
+  app_sup_trace_t *last = &s_trace[(s_traceNext + APP_SUP_TRACE_DEPTH - 1) % APP_SUP_TRACE_DEPTH];
+  if ((s_traceCount != 0) && (last->id == id) && (last->mark == mark))
+  {
+    last->tick = now;
+    if (last->count != 0xFFFF)
+    {
+      last->count++;
+    }
+  }
+  else
+  {
+    app_sup_trace_t *entry = &s_trace[s_traceNext];
+    entry->tick  = now;
+    entry->count = 1;
+    entry->id    = id;
+    entry->mark  = mark;
+    s_traceNext  = (s_traceNext + 1) % APP_SUP_TRACE_DEPTH;
+    if (s_traceCount < APP_SUP_TRACE_DEPTH)
+    {
+      s_traceCount++;
+    }
+  }
+  APP_SUP_UNLOCK(primask);
+}
+
+#endif // APP_SUPERVISOR_ENABLE
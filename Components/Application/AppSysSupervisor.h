@@ -0,0 +1,108 @@
+/**
+ * @file AppSysSupervisor.h
+ * @brief [SYSTEM] Task supervisor feeding the hardware watchdog.
+ * @details Each task or state machine registers a deadline and checks in when it makes progress.
+ *          app_sup_service() refreshes the watchdog only while every registered client has
+ *          checked in within its deadline; it is the only caller of cb_wdt_refresh() while the
+ *          supervisor runs. Deadlines are shorter than the watchdog period, so that a client
+ *          stuck inside its own code is already overdue when the watchdog runs out.
+ *          A stuck client, or a stuck app_sup_service() caller, lets the watchdog
+ *          run out: its interrupt (NMI) saves the offending client, the PC and LR interrupted by
+ *          the NMI and the last check-ins to a no-init RAM record (RW_NOINIT_RAM of the scatter
+ *          file), then the watchdog resets the chip after APP_SUP_WDT_GRACE_MS.
+ *          After the reset, app_sup_init() takes the record and app_sup_report() prints it.
+ *          The record survives a watchdog or software reset, not a power cycle; it is only
+ *          used if its magic and checksum match.
+ *          The watchdog is shared with the RC calibration (CB_system.c): the supervisor starts
+ *          it at the first app_sup_service() after the calibration has released it, and cannot
+ *          run with the periodic calibration.
+ *          With APP_SUPERVISOR_ENABLE (APP_CompileOption.h) set to APP_FALSE, the NMI vector is
+ *          unchanged and AppSysSupervisor.c is empty.
+ * @author Chipsbank
+ * @date 2024
+ */
+
+#ifndef __APP_SYS_SUPERVISOR_H
+#define __APP_SYS_SUPERVISOR_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "APP_CompileOption.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#ifndef APP_SUPERVISOR_ENABLE
+#define APP_SUPERVISOR_ENABLE APP_FALSE
+#endif
+
+#define APP_SUP_CLIENT_MAX      8       /**< Registered tasks or state machines */
+#define APP_SUP_TRACE_DEPTH     8       /**< Last check-ins kept in the fault record */
+#define APP_SUP_NAME_SIZE       12      /**< Client name kept in the fault record */
+#define APP_SUP_WDT_GRACE_MS    10      /**< Watchdog interrupt to reset: time to save the record */
+#define APP_SUP_ID_NONE         0xFF    /**< No client: registration failed, or overdue service */
+
+#if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+  /** NMI vector entry, saves the fault record before NMI_Handler */
+  #define APP_SUP_NMI_VECTOR    app_sup_nmi_handler
+#else
+  #define APP_SUP_NMI_VECTOR    NMI_Handler
+#endif
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Check-in of the trace. Repeated check-ins of a client with the same mark are one entry.
+ */
+typedef struct
+{
+  uint32_t tick;                        /**< Last check-in, ms */
+  uint16_t count;                       /**< Check-ins, saturated */
+  uint8_t  id;
+  uint8_t  mark;                        /**< Client defined, e.g. state */
+} app_sup_trace_t;
+
+/**
+ * @brief Watchdog expiry saved over the reset.
+ */
+typedef struct
+{
+  uint32_t        resets;               /**< Consecutive supervisor resets, this one included */
+  uint32_t        tick;                 /**< Expiry, ms since the supervisor started */
+  uint32_t        pc;                   /**< Interrupted by the watchdog NMI */
+  uint32_t        lr;
+  uint32_t        xpsr;                 /**< Exception number in bits 0..8: 0 thread, else handler */
+  uint32_t        overdueMs;            /**< Of the offending client */
+  uint8_t         id;                   /**< Offending client, APP_SUP_ID_NONE: app_sup_service() stopped */
+  char            name[APP_SUP_NAME_SIZE];
+  app_sup_trace_t trace[APP_SUP_TRACE_DEPTH]; /**< Oldest first */
+} app_sup_fault_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+#if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+void    app_sup_init(uint32_t wdtTimeoutMs);
+uint8_t app_sup_register(const char *name, uint32_t deadlineMs);
+void    app_sup_checkin(uint8_t id, uint8_t mark);
+void    app_sup_mark(uint8_t id, uint8_t mark);
+void    app_sup_suspend(uint8_t id);
+void    app_sup_resume(uint8_t id);
+uint8_t app_sup_service(void);
+uint8_t app_sup_get_fault(app_sup_fault_t *fault);
+void    app_sup_report(void);
+void    app_sup_nmi_handler(void);
+#endif
+
+#endif // __APP_SYS_SUPERVISOR_H
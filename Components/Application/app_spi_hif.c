@@ -0,0 +1,630 @@
+/**
+ * @file    app_spi_hif.c
+ * @brief   [CPU Subsystem] SPI slave host interface.
+ * @details Frame exchange in the SPI slave completion callback, register map, record FIFO and
+ *          statistics. See app_spi_hif.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "app_spi_hif.h"
+
+#if (APP_SPI_HIF_ENABLE == APP_TRUE)
+#include <string.h>
+#include "APP_common.h"
+#include "CB_spi.h"
+#include "CB_gpio.h"
+#include "CB_iomux.h"
+#include "CB_scr.h"
+#include "app_uart.h"
+#include "checksum.h"
+#if (APP_FREERTOS_ENABLE == APP_TRUE)
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include "NonLIB_sharedUtils.h"
+#endif
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+/** SPI slave pins of Examples/peripheral_spislaver, data ready output */
+#ifndef APP_HIF_DRDY_PIN
+#define APP_HIF_DRDY_PIN        EN_GPIO_PIN_4
+#define APP_HIF_DRDY_IOMUX      EN_IOMUX_GPIO_4
+#endif
+#define APP_HIF_CS_IOMUX        EN_IOMUX_GPIO_5
+#define APP_HIF_CLK_IOMUX       EN_IOMUX_GPIO_6
+#define APP_HIF_MISO_IOMUX      EN_IOMUX_GPIO_3
+#define APP_HIF_MOSI_IOMUX      EN_IOMUX_GPIO_7
+
+#ifndef APP_HIF_CYCLES
+#define APP_HIF_CYCLES()        (DWT->CYCCNT)
+#endif
+
+#ifndef APP_HIF_NOW_MS
+  #if (APP_FREERTOS_ENABLE == APP_TRUE)
+    #define APP_HIF_NOW_MS()    ((uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS))
+  #else
+    #define APP_HIF_NOW_MS()    cb_hal_get_tick()
+  #endif
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define APP_HIF_FIFO_MASK         (APP_HIF_FIFO_SIZE - 1)
+#define APP_HIF_BUF_SIZE          ((APP_HIF_XFER_SIZE + 3) & ~3)
+#define APP_HIF_CONTROL_MASK      (APP_HIF_CONTROL_STREAM | APP_HIF_CONTROL_DRDY)
+
+#define APP_HIF_LOCK(primask)     do { (primask) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define APP_HIF_UNLOCK(primask)   __set_PRIMASK(primask)
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  uint32_t frames;
+  uint32_t crcErrors;
+  uint32_t aborts;              // Transfers stopped halfway
+  uint32_t dropped;
+  uint32_t streamBytes;
+  uint32_t resentBytes;
+  uint32_t latencyMin;
+  uint32_t latencyMax;
+  uint64_t latencySum;
+  uint32_t latencyCount;
+  uint32_t turnaroundMax;
+  uint32_t startMs;
+} app_hif_stats_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void     app_hif_spi_complete(uint8_t status);
+static void     app_hif_prepare(const app_hif_host_hdr_t *request, uint16_t requestStatus);
+static uint16_t app_hif_check_request(const app_hif_host_hdr_t *request);
+static uint32_t app_hif_reg_read(uint16_t addr);
+static void     app_hif_reg_write(uint16_t addr, uint32_t value);
+static void     app_hif_fifo_read(uint16_t offset, void *dest, uint16_t size);
+static void     app_hif_fifo_write(const void *src, uint16_t size);
+static void     app_hif_update_drdy(void);
+static void     app_hif_stats_reset(void);
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static uint8_t  s_txBuf[APP_HIF_BUF_SIZE] __attribute__((aligned(4)));   // [0]: alignment byte
+static uint8_t  s_rxBuf[APP_HIF_BUF_SIZE] __attribute__((aligned(4)));
+static uint8_t  s_fifo[APP_HIF_FIFO_SIZE];
+
+// FIFO stream offsets, modulo 2^16
+static uint16_t s_head;                   // Next byte pushed
+static uint16_t s_tail;                   // First byte not acknowledged
+static uint16_t s_sent;                   // Next byte to send
+static uint16_t s_sentMax;                // Bytes below have been sent at least once
+static uint16_t s_recNext;                // Header of the first record not sent yet
+static uint16_t s_seenEnd;                // Host ack expected after the frame it has seen last
+static uint16_t s_armedEnd;               // s_sent after the frame armed
+
+static uint8_t  s_armedHasData;           // Frame armed carries registers or FIFO bytes
+static uint8_t  s_armedHasRecord;         // Frame armed carries a record header sent for the first time
+static uint32_t s_armedRecordCycles;      // Push time of the first one
+static uint8_t  s_lastSeq;
+static uint16_t s_recSeq;
+static uint16_t s_overflow;               // APP_HIF_STATUS_OVERFLOW until cleared
+static uint32_t s_control = APP_HIF_CONTROL_STREAM | APP_HIF_CONTROL_DRDY;
+static uint32_t s_recordMask = 0xFFFFFFFF;
+static uint32_t s_appReg[APP_HIF_APP_REG_NUM];
+static uint32_t s_appWrites;
+static uint16_t s_stallCount;
+static uint32_t s_stallMs;
+static app_hif_stats_t s_stats;
+
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief   Initializes the SPI slave, the data ready GPIO and the FIFO, and arms the first frame.
+ */
+void app_hif_init(void)
+{
+  stGPIO_InitTypeDef drdyPin;
+  stSPI_InitTypeDef  hspi;
+
+  cb_scr_gpio_module_on();
+  cb_iomux_config(APP_HIF_DRDY_IOMUX, &(stIomuxGpioMode){EN_IOMUX_GPIO_MODE_GPIO, 0});
+  drdyPin.Pin  = APP_HIF_DRDY_PIN;
+  drdyPin.Mode = EN_GPIO_MODE_OUTPUT;
+  drdyPin.Pull = EN_GPIO_NOPULL;
+  cb_gpio_init(&drdyPin);
+  cb_gpio_write_pin(APP_HIF_DRDY_PIN, EN_GPIO_PIN_RESET);
+
+  cb_iomux_config(APP_HIF_CS_IOMUX,   &(stIomuxGpioMode){EN_IOMUX_GPIO_MODE_SOC_PERIPHERALS, (uint8_t)EN_IOMUX_GPIO_AF_SPIS_CS});
+  cb_iomux_config(APP_HIF_CLK_IOMUX,  &(stIomuxGpioMode){EN_IOMUX_GPIO_MODE_SOC_PERIPHERALS, (uint8_t)EN_IOMUX_GPIO_AF_SPIS_CLK});
+  cb_iomux_config(APP_HIF_MISO_IOMUX, &(stIomuxGpioMode){EN_IOMUX_GPIO_MODE_SOC_PERIPHERALS, (uint8_t)EN_IOMUX_GPIO_AF_SPIS_MISO});
+  cb_iomux_config(APP_HIF_MOSI_IOMUX, &(stIomuxGpioMode){EN_IOMUX_GPIO_MODE_SOC_PERIPHERALS, (uint8_t)EN_IOMUX_GPIO_AF_SPIS_MOSI});
+  hspi.BitOrder  = EN_SPI_bitorder_msb_first;
+  hspi.ByteOrder = EN_SPI_byteorder_byte0_first;
+  hspi.Speed     = EN_SPI16MHz;     // Clocked by the host. From 32 MHz, 500 ohm pull-up on MISO
+  hspi.SpiMode   = EN_SPI_mode0;
+  cb_spi_init(&hspi);
+
+  s_head = s_tail = s_sent = s_sentMax = s_recNext = s_seenEnd = 0;
+  s_recSeq = 0;
+  s_overflow = 0;
+  s_stallCount = 0;
+  app_hif_stats_reset();
+
+  app_hif_prepare(NULL, 0);         // Also builds the LibCRC table before the first interrupt
+  cb_spi_slave_sdma_start(APP_HIF_XFER_SIZE, (uint32_t)&s_txBuf[0], (uint32_t)&s_rxBuf[0], &app_hif_spi_complete);
+}
+
+/**
+ * @brief   Drops a transfer the host stopped halfway, call periodically.
+ *
+ * The slave SDMA transfer only ends after APP_HIF_XFER_SIZE bytes: without this the bytes of the
+ * next transactions would complete it and every frame after would be split.
+ */
+void app_hif_process(void)
+{
+  uint32_t primask;
+  uint16_t count = cb_spi_get_sdma_rx_count();
+  uint32_t now = APP_HIF_NOW_MS();
+
+  if ((count == 0) || (count >= APP_HIF_XFER_SIZE) || (count != s_stallCount))
+  {
+    s_stallCount = count;
+    s_stallMs    = now;
+    return;
+  }
+  if ((now - s_stallMs) < APP_HIF_STALL_MS)
+  {
+    return;
+  }
+  APP_HIF_LOCK(primask);
+  if (cb_spi_get_sdma_rx_count() == count)
+  {
+    cb_spi_stop();
+    s_stats.aborts++;
+    cb_spi_slave_sdma_start(APP_HIF_XFER_SIZE, (uint32_t)&s_txBuf[0], (uint32_t)&s_rxBuf[0], &app_hif_spi_complete);
+  }
+  APP_HIF_UNLOCK(primask);
+  s_stallCount = 0;
+}
+
+/**
+ * @brief   Pushes a record into the FIFO.
+ *
+ * @param   type  APP_HIF_REC_*, dropped if masked by APP_HIF_REG_RECORD_MASK.
+ * @param   data  Record data.
+ * @param   len   Bytes of data.
+ * @return  APP_TRUE if queued, APP_FALSE if masked, streaming off or FIFO full.
+ */
+uint8_t app_hif_push(uint8_t type, const void *data, uint8_t len)
+{
+  uint32_t primask;
+  uint16_t size = sizeof(app_hif_rec_hdr_t) + len;
+  app_hif_rec_hdr_t hdr;
+
+  if (((s_control & APP_HIF_CONTROL_STREAM) == 0) || ((type < 32) && ((s_recordMask & (1UL << type)) == 0)))
+  {
+    return APP_FALSE;
+  }
+  APP_HIF_LOCK(primask);
+  if (size > (APP_HIF_FIFO_SIZE - (uint16_t)(s_head - s_tail)))
+  {
+    s_recSeq++;
+    s_stats.dropped++;
+    s_overflow = APP_HIF_STATUS_OVERFLOW;
+    APP_HIF_UNLOCK(primask);
+    return APP_FALSE;
+  }
+  hdr.type   = type;
+  hdr.len    = len;
+  hdr.seq    = s_recSeq++;
+  hdr.cycles = APP_HIF_CYCLES();
+  app_hif_fifo_write(&hdr, sizeof(hdr));
+  app_hif_fifo_write(data, len);
+  app_hif_update_drdy();
+  APP_HIF_UNLOCK(primask);
+  return APP_TRUE;
+}
+
+/**
+ * @brief   Pushes CIR samples as APP_HIF_REC_CIR records of up to APP_HIF_CIR_CHUNK samples.
+ *
+ * @param   port        RX port.
+ * @param   firstIndex  CIR index of iq[0].
+ * @param   iq          Samples.
+ * @param   count       Samples.
+ * @return  Samples queued, less than count if the FIFO is full.
+ */
+uint16_t app_hif_push_cir(uint8_t port, uint16_t firstIndex, const cb_uwbsystem_rx_cir_iqdata_st *iq, uint16_t count)
+{
+  uint8_t  record[sizeof(app_hif_rec_cir_t) + APP_HIF_CIR_CHUNK * sizeof(cb_uwbsystem_rx_cir_iqdata_st)];
+  app_hif_rec_cir_t *cir = (app_hif_rec_cir_t *)record;
+  uint16_t done = 0;
+
+  while (done < count)
+  {
+    uint16_t n = count - done;
+    if (n > APP_HIF_CIR_CHUNK)
+    {
+      n = APP_HIF_CIR_CHUNK;
+    }
+    cir->port       = port;
+    cir->count      = (uint8_t)n;
+    cir->firstIndex = firstIndex + done;
+    memcpy(&record[sizeof(app_hif_rec_cir_t)], &iq[done], n * sizeof(cb_uwbsystem_rx_cir_iqdata_st));
+    if (app_hif_push(APP_HIF_REC_CIR, record, (uint8_t)(sizeof(app_hif_rec_cir_t) + n * sizeof(cb_uwbsystem_rx_cir_iqdata_st))) != APP_TRUE)
+    {
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+/**
+ * @brief   Application register, APP_HIF_REG_APP + 4 * index.
+ */
+uint32_t app_hif_get_app_reg(uint8_t index)
+{
+  return (index < APP_HIF_APP_REG_NUM) ? s_appReg[index] : 0;
+}
+
+/**
+ * @brief   Sets an application register, e.g. a result or state read by the host.
+ */
+void app_hif_set_app_reg(uint8_t index, uint32_t value)
+{
+  if (index < APP_HIF_APP_REG_NUM)
+  {
+    s_appReg[index] = value;
+  }
+}
+
+/**
+ * @brief   Application registers written by the host since the last call.
+ *
+ * @return  Bit per register index.
+ */
+uint32_t app_hif_take_app_writes(void)
+{
+  uint32_t primask;
+  uint32_t writes;
+
+  APP_HIF_LOCK(primask);
+  writes = s_appWrites;
+  s_appWrites = 0;
+  APP_HIF_UNLOCK(primask);
+  return writes;
+}
+
+/**
+ * @brief   Prints the link statistics over app_uart.
+ *
+ * @param   reset  APP_TRUE: start a new measurement window.
+ */
+void app_hif_dump_stats(uint8_t reset)
+{
+  uint32_t primask;
+  app_hif_stats_t stats;
+  uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+
+  APP_HIF_LOCK(primask);
+  stats = s_stats;
+  if (reset == APP_TRUE)
+  {
+    app_hif_stats_reset();
+  }
+  APP_HIF_UNLOCK(primask);
+
+  uint32_t elapsedMs = APP_HIF_NOW_MS() - stats.startMs;
+  app_uart_printf("HIF: %u frames in %u ms, %u bytes/s, %u resent, %u CRC errors, %u aborted, %u records dropped\n",
+                  stats.frames, elapsedMs, (elapsedMs != 0) ? (uint32_t)(((uint64_t)stats.streamBytes * 1000) / elapsedMs) : 0,
+                  stats.resentBytes, stats.crcErrors, stats.aborts, stats.dropped);
+  if (stats.latencyCount != 0)
+  {
+    app_uart_printf("HIF: host read latency min %u avg %u max %u us (%u records), turnaround max %u us\n",
+                    stats.latencyMin / cyclesPerUs, (uint32_t)(stats.latencySum / stats.latencyCount) / cyclesPerUs,
+                    stats.latencyMax / cyclesPerUs, stats.latencyCount, stats.turnaroundMax / cyclesPerUs);
+  }
+}
+
+/**
+ * @brief   SPI slave SDMA completion: takes the host request, arms the next frame.
+ *
+ * @param   status  CB_PASS if the whole transaction was clocked.
+ */
+static void app_hif_spi_complete(uint8_t status)
+{
+  uint32_t start = APP_HIF_CYCLES();
+  const app_hif_host_hdr_t *request = (const app_hif_host_hdr_t *)&s_rxBuf[1];
+  uint16_t requestStatus;
+  uint16_t armedEnd = s_armedEnd;
+
+  s_stats.frames++;
+  if (s_armedHasRecord)
+  {
+    uint32_t latency = start - s_armedRecordCycles;
+    s_stats.latencySum += latency;
+    s_stats.latencyCount++;
+    s_stats.latencyMin = (latency < s_stats.latencyMin) ? latency : s_stats.latencyMin;
+    s_stats.latencyMax = (latency > s_stats.latencyMax) ? latency : s_stats.latencyMax;
+  }
+
+  requestStatus = (status == CB_PASS) ? app_hif_check_request(request) : APP_HIF_STATUS_CRC_ERR;
+  if (requestStatus == APP_HIF_STATUS_CRC_ERR)
+  {
+    s_stats.crcErrors++;
+    s_seenEnd = armedEnd;
+    request = NULL;
+  }
+  else
+  {
+    // The host has seen the frames before the one of this transaction: an ack behind their
+    // end is a frame it missed, the FIFO is sent again from there
+    uint16_t ack = request->ack;
+    s_lastSeq = request->seq;
+    if ((uint16_t)(ack - s_tail) <= (uint16_t)(s_seenEnd - s_tail))
+    {
+      s_tail = ack;
+      if (ack != s_seenEnd)
+      {
+        s_sent = ack;
+        armedEnd = ack;       // Frame of this transaction discarded by the host
+      }
+    }
+    s_seenEnd = armedEnd;
+  }
+
+  app_hif_prepare(request, requestStatus);
+  cb_spi_slave_sdma_start(APP_HIF_XFER_SIZE, (uint32_t)&s_txBuf[0], (uint32_t)&s_rxBuf[0], &app_hif_spi_complete);
+
+  uint32_t turnaround = APP_HIF_CYCLES() - start;
+  s_stats.turnaroundMax = (turnaround > s_stats.turnaroundMax) ? turnaround : s_stats.turnaroundMax;
+}
+
+/**
+ * @brief   Validates a host request and runs a register write.
+ *
+ * @return  0, APP_HIF_STATUS_CRC_ERR or APP_HIF_STATUS_CMD_ERR.
+ */
+static uint16_t app_hif_check_request(const app_hif_host_hdr_t *request)
+{
+  const uint8_t *frame = (const uint8_t *)request;
+  uint16_t crc;
+
+  if ((request->sync != APP_HIF_SYNC_HOST) || (request->len > APP_HIF_PAYLOAD_SIZE))
+  {
+    return APP_HIF_STATUS_CRC_ERR;
+  }
+  memcpy(&crc, &frame[APP_HIF_HEADER_SIZE + APP_HIF_PAYLOAD_SIZE], sizeof(crc));
+  if (crc != crc_ccitt_ffff(frame, APP_HIF_HEADER_SIZE + ((request->cmd == APP_HIF_CMD_WRITE) ? request->len : 0)))
+  {
+    return APP_HIF_STATUS_CRC_ERR;
+  }
+
+  switch (request->cmd)
+  {
+    case APP_HIF_CMD_NOP:
+      return 0;
+    case APP_HIF_CMD_READ:
+    case APP_HIF_CMD_WRITE:
+      if ((request->len == 0) || ((request->len & 3) != 0) || ((request->addr & 3) != 0) ||
+          ((request->addr + request->len) > APP_HIF_REG_MAP_SIZE))
+      {
+        return APP_HIF_STATUS_CMD_ERR;
+      }
+      break;
+    default:
+      return APP_HIF_STATUS_CMD_ERR;
+  }
+
+  if (request->cmd == APP_HIF_CMD_WRITE)
+  {
+    for (uint16_t addr = request->addr; addr < (request->addr + request->len); addr += 4)
+    {
+      if ((addr != APP_HIF_REG_CONTROL) && (addr != APP_HIF_REG_RECORD_MASK) && (addr < APP_HIF_REG_APP))
+      {
+        return APP_HIF_STATUS_CMD_ERR;    // Read only, nothing written
+      }
+    }
+    for (uint16_t i = 0; i < request->len; i += 4)
+    {
+      uint32_t value;
+      memcpy(&value, &frame[APP_HIF_HEADER_SIZE + i], sizeof(value));
+      app_hif_reg_write(request->addr + i, value);
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief   Builds the next slave frame: registers for a read request, FIFO bytes otherwise.
+ *
+ * @param   request        Valid host request, NULL if none.
+ * @param   requestStatus  APP_HIF_STATUS_CRC_ERR or APP_HIF_STATUS_CMD_ERR of the request.
+ */
+static void app_hif_prepare(const app_hif_host_hdr_t *request, uint16_t requestStatus)
+{
+  app_hif_slave_hdr_t *hdr = (app_hif_slave_hdr_t *)&s_txBuf[1];
+  uint8_t *payload = &s_txBuf[1 + APP_HIF_HEADER_SIZE];
+  uint16_t crc;
+  uint8_t  len = 0;
+
+  s_armedHasRecord = APP_FALSE;
+  if ((request != NULL) && (requestStatus == 0) && (request->cmd == APP_HIF_CMD_READ))
+  {
+    hdr->kind   = APP_HIF_KIND_REG;
+    hdr->offset = request->addr;
+    for (len = 0; len < request->len; len += 4)
+    {
+      uint32_t value = app_hif_reg_read(request->addr + len);
+      memcpy(&payload[len], &value, sizeof(value));
+    }
+  }
+  else
+  {
+    uint16_t start = s_sent;
+    uint16_t pending = s_head - s_sent;
+    len = (pending > APP_HIF_PAYLOAD_SIZE) ? APP_HIF_PAYLOAD_SIZE : (uint8_t)pending;
+    app_hif_fifo_read(start, payload, len);
+    s_sent = start + len;
+
+    if ((uint16_t)(s_sent - s_sentMax) <= (uint16_t)(s_head - s_sentMax))
+    {
+      s_stats.resentBytes += len - (uint16_t)(s_sent - s_sentMax);
+      s_stats.streamBytes += (uint16_t)(s_sent - s_sentMax);
+      s_sentMax = s_sent;
+    }
+    else
+    {
+      s_stats.resentBytes += len;
+    }
+    // Record headers sent for the first time: host read latency of the oldest
+    while ((uint16_t)(s_recNext - start) < len)
+    {
+      app_hif_rec_hdr_t rec;
+      app_hif_fifo_read(s_recNext, &rec, sizeof(rec));
+      if (s_armedHasRecord == APP_FALSE)
+      {
+        s_armedHasRecord    = APP_TRUE;
+        s_armedRecordCycles = rec.cycles;
+      }
+      s_recNext += sizeof(rec) + rec.len;
+    }
+    hdr->kind   = APP_HIF_KIND_STREAM;
+    hdr->offset = start;
+  }
+  s_armedEnd     = s_sent;
+  s_armedHasData = (len != 0);
+
+  s_txBuf[0]  = 0xFF;
+  hdr->sync   = APP_HIF_SYNC_SLAVE;
+  hdr->seq    = s_lastSeq;
+  hdr->len    = len;
+  hdr->status = requestStatus | s_overflow | ((s_head != s_sent) ? APP_HIF_STATUS_DATA : 0);
+  crc = crc_ccitt_ffff((const uint8_t *)hdr, APP_HIF_HEADER_SIZE + len);
+  memcpy(&s_txBuf[1 + APP_HIF_HEADER_SIZE + APP_HIF_PAYLOAD_SIZE], &crc, sizeof(crc));
+  app_hif_update_drdy();
+}
+
+/**
+ * @brief   Register value, see APP_HIF_REG_*.
+ */
+static uint32_t app_hif_reg_read(uint16_t addr)
+{
+  switch (addr)
+  {
+    case APP_HIF_REG_ID:             return APP_HIF_REG_ID_VALUE;
+    case APP_HIF_REG_STATUS:         return s_overflow | ((s_head != s_sent) ? APP_HIF_STATUS_DATA : 0) | ((uint32_t)(uint16_t)(s_head - s_sent) << 16);
+    case APP_HIF_REG_CONTROL:        return s_control;
+    case APP_HIF_REG_RECORD_MASK:    return s_recordMask;
+    case APP_HIF_REG_CLOCK_HZ:       return SystemCoreClock;
+    case APP_HIF_REG_FIFO_SIZE:      return APP_HIF_FIFO_SIZE;
+    case APP_HIF_REG_FIFO_USED:      return (uint16_t)(s_head - s_tail);
+    case APP_HIF_REG_FRAMES:         return s_stats.frames;
+    case APP_HIF_REG_CRC_ERRORS:     return s_stats.crcErrors;
+    case APP_HIF_REG_DROPPED:        return s_stats.dropped;
+    case APP_HIF_REG_STREAM_BYTES:   return s_stats.streamBytes;
+    case APP_HIF_REG_RESENT_BYTES:   return s_stats.resentBytes;
+    case APP_HIF_REG_LATENCY_MIN:    return (s_stats.latencyCount != 0) ? s_stats.latencyMin : 0;
+    case APP_HIF_REG_LATENCY_MAX:    return s_stats.latencyMax;
+    case APP_HIF_REG_LATENCY_AVG:    return (s_stats.latencyCount != 0) ? (uint32_t)(s_stats.latencySum / s_stats.latencyCount) : 0;
+    case APP_HIF_REG_TURNAROUND_MAX: return s_stats.turnaroundMax;
+    default:
+      return (addr >= APP_HIF_REG_APP) ? s_appReg[(addr - APP_HIF_REG_APP) / 4] : 0;
+  }
+}
+
+/**
+ * @brief   Writes a writable register, checked by app_hif_check_request().
+ */
+static void app_hif_reg_write(uint16_t addr, uint32_t value)
+{
+  if (addr == APP_HIF_REG_CONTROL)
+  {
+    if ((value & APP_HIF_CONTROL_CLEAR) != 0)
+    {
+      app_hif_stats_reset();
+      s_overflow = 0;
+    }
+    s_control = value & APP_HIF_CONTROL_MASK;
+  }
+  else if (addr == APP_HIF_REG_RECORD_MASK)
+  {
+    s_recordMask = value;
+  }
+  else
+  {
+    uint8_t index = (addr - APP_HIF_REG_APP) / 4;
+    s_appReg[index] = value;
+    s_appWrites |= 1UL << index;
+  }
+}
+
+/**
+ * @brief   Copies FIFO bytes from a stream offset.
+ */
+static void app_hif_fifo_read(uint16_t offset, void *dest, uint16_t size)
+{
+  uint16_t index = offset & APP_HIF_FIFO_MASK;
+  uint16_t first = APP_HIF_FIFO_SIZE - index;
+
+  if (first > size)
+  {
+    first = size;
+  }
+  memcpy(dest, &s_fifo[index], first);
+  memcpy((uint8_t *)dest + first, &s_fifo[0], size - first);
+}
+
+/**
+ * @brief   Appends bytes at the FIFO head, room checked by the caller.
+ */
+static void app_hif_fifo_write(const void *src, uint16_t size)
+{
+  uint16_t index = s_head & APP_HIF_FIFO_MASK;
+  uint16_t first = APP_HIF_FIFO_SIZE - index;
+
+  if (first > size)
+  {
+    first = size;
+  }
+  memcpy(&s_fifo[index], src, first);
+  memcpy(&s_fifo[0], (const uint8_t *)src + first, size - first);
+  s_head += size;
+}
+
+/**
+ * @brief   Data ready: the frame armed has data, or FIFO bytes are waiting for the next one.
+ */
+static void app_hif_update_drdy(void)
+{
+  uint8_t ready = (s_armedHasData || (s_head != s_sent)) && ((s_control & APP_HIF_CONTROL_DRDY) != 0);
+  cb_gpio_write_pin(APP_HIF_DRDY_PIN, ready ? EN_GPIO_PIN_SET : EN_GPIO_PIN_RESET);
+}
+
+/**
+ * @brief   Starts a new statistics window.
+ */
+static void app_hif_stats_reset(void)
+{
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_stats.latencyMin = 0xFFFFFFFF;
+  s_stats.startMs = APP_HIF_NOW_MS();
+}
+
+#endif // APP_SPI_HIF_ENABLE
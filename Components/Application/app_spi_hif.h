@@ -0,0 +1,196 @@
+/**
+ * @file    app_spi_hif.h
+ * @brief   [CPU Subsystem] SPI slave host interface.
+ * @details Framed link to a host MCU over the SPI slave (SDMA mode), for results and commands:
+ *          - Every transaction is one frame each way, APP_HIF_XFER_SIZE bytes: the SDMA alignment
+ *            byte (ignored both ways, see cb_spi_slave_sdma_start), then APP_HIF_FRAME_SIZE
+ *            bytes: header, payload, CRC-16/CCITT-FALSE of header and payload (crc_ccitt_ffff()
+ *            of External/LibCRC).
+ *          - The host sends a request (app_hif_host_hdr_t): NOP, register read or register write.
+ *            The slave frame of the same transaction was prepared when the previous one ended:
+ *            it answers the previous request and carries the status word (APP_HIF_STATUS_*).
+ *          - Results are records (app_hif_rec_hdr_t: ranging, AoA, CIR, application) pushed into
+ *            a byte FIFO. The slave frames not answering a register read carry the next FIFO
+ *            bytes, tagged with their stream offset. The host appends a payload whose offset is
+ *            the one it expects and acknowledges with that offset in each request; the slave
+ *            frees acknowledged bytes and sends again from the acknowledged offset when the host
+ *            missed a frame.
+ *          - Flow control by polling: the host sends NOP requests while the status word has
+ *            APP_HIF_STATUS_DATA. The data ready GPIO is high while the FIFO has bytes not yet
+ *            sent or a register read is answered; a frame prepared before a record was pushed
+ *            is empty, the record comes with the next one.
+ *          - The host waits at least the turnaround (APP_HIF_REG_TURNAROUND_MAX) between two
+ *            transactions and clocks whole frames; a transfer stopped halfway is dropped after
+ *            APP_HIF_STALL_MS by app_hif_process().
+ *          - Payload rate: at most APP_HIF_PAYLOAD_SIZE of APP_HIF_XFER_SIZE bytes per transaction,
+ *            about 1.8 MB/s at 16 MHz with no gap between transactions. Computed from the frame
+ *            format, not measured; app_hif_dump_stats() prints the rate and latency seen.
+ *          With APP_SPI_HIF_ENABLE (APP_CompileOption.h) set to APP_FALSE, app_spi_hif.c is empty.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __APP_SPI_HIF_H
+#define __APP_SPI_HIF_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "APP_CompileOption.h"
+#include "CB_system_types.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#ifndef APP_SPI_HIF_ENABLE
+#define APP_SPI_HIF_ENABLE APP_FALSE
+#endif
+
+#define APP_HIF_HEADER_SIZE         8
+#define APP_HIF_PAYLOAD_SIZE        118
+#define APP_HIF_CRC_SIZE            2
+#define APP_HIF_FRAME_SIZE          (APP_HIF_HEADER_SIZE + APP_HIF_PAYLOAD_SIZE + APP_HIF_CRC_SIZE)
+#define APP_HIF_XFER_SIZE           (1 + APP_HIF_FRAME_SIZE)    /**< SPI transaction: alignment byte and frame */
+#define APP_HIF_FIFO_SIZE           2048                        /**< Record FIFO, power of 2 */
+#define APP_HIF_STALL_MS            5                           /**< Transfer stopped halfway, dropped after */
+
+#define APP_HIF_SYNC_HOST           0xA5
+#define APP_HIF_SYNC_SLAVE          0x5A
+
+/** Host requests */
+#define APP_HIF_CMD_NOP             0x00    /**< Poll and acknowledge */
+#define APP_HIF_CMD_READ            0x01    /**< Read len bytes of registers from addr */
+#define APP_HIF_CMD_WRITE           0x02    /**< Write len bytes of payload to the registers from addr */
+
+/** Slave frame payload */
+#define APP_HIF_KIND_STREAM         0x00    /**< FIFO bytes from offset, len may be 0 */
+#define APP_HIF_KIND_REG            0x01    /**< Registers from offset (address), answers a read */
+
+/** Status word, in every slave frame and in APP_HIF_REG_STATUS */
+#define APP_HIF_STATUS_DATA         0x0001  /**< FIFO bytes not sent yet */
+#define APP_HIF_STATUS_OVERFLOW     0x0002  /**< Records dropped, FIFO full, since the last clear */
+#define APP_HIF_STATUS_CRC_ERR      0x0004  /**< Last request ignored: sync or CRC */
+#define APP_HIF_STATUS_CMD_ERR      0x0008  /**< Last request refused: command, address or length */
+
+/** Registers, 32 bit little endian; reads and writes are whole registers */
+#define APP_HIF_REG_ID              0x00    /**< RO "HIF1" */
+#define APP_HIF_REG_STATUS          0x04    /**< RO status word, FIFO bytes not sent in bits 16..31 */
+#define APP_HIF_REG_CONTROL         0x08    /**< RW APP_HIF_CONTROL_* */
+#define APP_HIF_REG_RECORD_MASK     0x0C    /**< RW record types 0..31 pushed, bit per type */
+#define APP_HIF_REG_CLOCK_HZ        0x10    /**< RO CPU clock of the cycle counts */
+#define APP_HIF_REG_FIFO_SIZE       0x14    /**< RO */
+#define APP_HIF_REG_FIFO_USED       0x18    /**< RO bytes not acknowledged */
+#define APP_HIF_REG_FRAMES          0x1C    /**< RO transactions */
+#define APP_HIF_REG_CRC_ERRORS      0x20    /**< RO requests ignored */
+#define APP_HIF_REG_DROPPED         0x24    /**< RO records dropped */
+#define APP_HIF_REG_STREAM_BYTES    0x28    /**< RO FIFO bytes sent once */
+#define APP_HIF_REG_RESENT_BYTES    0x2C    /**< RO FIFO bytes sent again */
+#define APP_HIF_REG_LATENCY_MIN     0x30    /**< RO record push to end of its first frame, cycles */
+#define APP_HIF_REG_LATENCY_MAX     0x34
+#define APP_HIF_REG_LATENCY_AVG     0x38
+#define APP_HIF_REG_TURNAROUND_MAX  0x3C    /**< RO end of a transaction to the next one armed, cycles */
+#define APP_HIF_REG_APP             0x40    /**< RW application registers, APP_HIF_APP_REG_NUM */
+#define APP_HIF_APP_REG_NUM         16
+#define APP_HIF_REG_MAP_SIZE        (APP_HIF_REG_APP + 4 * APP_HIF_APP_REG_NUM)
+
+#define APP_HIF_REG_ID_VALUE        0x31464948  // "HIF1"
+#define APP_HIF_CONTROL_STREAM      0x00000001  /**< Records are pushed */
+#define APP_HIF_CONTROL_DRDY        0x00000002  /**< Data ready GPIO driven */
+#define APP_HIF_CONTROL_CLEAR       0x80000000  /**< Write 1: clear the statistics and APP_HIF_STATUS_OVERFLOW */
+
+/** Record types */
+#define APP_HIF_REC_RANGING         0x01    /**< app_hif_rec_ranging_t */
+#define APP_HIF_REC_AOA             0x02    /**< app_hif_rec_aoa_t */
+#define APP_HIF_REC_CIR             0x03    /**< app_hif_rec_cir_t and count IQ samples */
+#define APP_HIF_REC_APP             0x80    /**< From 0x80: application defined */
+#define APP_HIF_REC_DATA_MAX        255
+#define APP_HIF_CIR_CHUNK           ((APP_HIF_REC_DATA_MAX - sizeof(app_hif_rec_cir_t)) / sizeof(cb_uwbsystem_rx_cir_iqdata_st))
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Request header, host to slave.
+ */
+typedef struct __attribute__((packed))
+{
+  uint8_t  sync;                  /**< APP_HIF_SYNC_HOST */
+  uint8_t  cmd;                   /**< APP_HIF_CMD_* */
+  uint8_t  seq;                   /**< Echoed by the slave frame answering it */
+  uint8_t  len;                   /**< Read: bytes to read. Write: payload bytes */
+  uint16_t addr;                  /**< Register address */
+  uint16_t ack;                   /**< Stream offset of the first FIFO byte not received */
+} app_hif_host_hdr_t;
+
+/**
+ * @brief Frame header, slave to host.
+ */
+typedef struct __attribute__((packed))
+{
+  uint8_t  sync;                  /**< APP_HIF_SYNC_SLAVE */
+  uint8_t  kind;                  /**< APP_HIF_KIND_* */
+  uint8_t  seq;                   /**< Of the last request processed */
+  uint8_t  len;                   /**< Payload bytes */
+  uint16_t status;                /**< APP_HIF_STATUS_* */
+  uint16_t offset;                /**< Stream offset of payload[0], or register address */
+} app_hif_slave_hdr_t;
+
+/**
+ * @brief Record header in the FIFO stream, followed by len bytes.
+ */
+typedef struct
+{
+  uint8_t  type;                  /**< APP_HIF_REC_* */
+  uint8_t  len;
+  uint16_t seq;                   /**< Record counter, a gap is a dropped record */
+  uint32_t cycles;                /**< CPU cycle counter at the push, APP_HIF_REG_CLOCK_HZ */
+} app_hif_rec_hdr_t;
+
+typedef struct
+{
+  uint32_t cycle;                 /**< Ranging cycle */
+  float    distanceCm;
+  uint8_t  valid;
+  uint8_t  reserved[3];
+} app_hif_rec_ranging_t;
+
+typedef struct
+{
+  float pd01;                     /**< Phase differences, degrees */
+  float pd02;
+  float pd12;
+  float azimuth;                  /**< Degrees */
+  float elevation;
+} app_hif_rec_aoa_t;
+
+typedef struct
+{
+  uint8_t  port;                  /**< RX port */
+  uint8_t  count;                 /**< IQ samples following */
+  uint16_t firstIndex;            /**< CIR index of the first sample */
+} app_hif_rec_cir_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+#if (APP_SPI_HIF_ENABLE == APP_TRUE)
+void     app_hif_init(void);
+void     app_hif_process(void);
+uint8_t  app_hif_push(uint8_t type, const void *data, uint8_t len);
+uint16_t app_hif_push_cir(uint8_t port, uint16_t firstIndex, const cb_uwbsystem_rx_cir_iqdata_st *iq, uint16_t count);
+uint32_t app_hif_get_app_reg(uint8_t index);
+void     app_hif_set_app_reg(uint8_t index, uint32_t value);
+uint32_t app_hif_take_app_writes(void);
+void     app_hif_dump_stats(uint8_t reset);
+#endif
+
+#endif // __APP_SPI_HIF_H
@@ -19,11 +19,14 @@
 #include "CB_iomux.h"
 #include "CB_Uart.h"
 #include "CB_system.h"
+#include "NonLIB_sharedUtils.h"
+#include "AppSysProfile.h"
 
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
 #define UART_RX_BUFFER_SIZE 0x100
+#define UART_TXQ_BUFFER_SIZE 0x100   // Two SDMA ping-pong buffers of 0x80 bytes
 //-------------------------------
 // ENUM SECTION
 //-------------------------------
@@ -52,6 +55,12 @@ stUartConfig uart_config;
  */
 uint8_t uart_txbuf[UART_RX_BUFFER_SIZE] __attribute__((section("SPECIFIC_UART_TX_SDMA_RAM")));
 uint8_t uart_rxbuf[UART_RX_BUFFER_SIZE] __attribute__((section("SPECIFIC_UART_RX_SDMA_RAM")));
+
+/**
+ * @brief SDMA buffers of the UART TX queue (cb_uart_txq_send), separate from uart_txbuf
+ *        so that queued frames and app_uart_printf() never overwrite each other.
+ */
+uint8_t uart_txq_buf[UART_TXQ_BUFFER_SIZE] __attribute__((section("SPECIFIC_UART_TX_SDMA_RAM")));
 //-------------------------------
 // FUNCTION PROTOTYPE SECTION
 //-------------------------------
@@ -102,6 +111,127 @@ void app_uart_echo_demo(void)
     }
 }
 
+static volatile uint8_t s_ringbufStressEvent = 0;
+
+/**
+ * @brief Ring buffer event callback used by app_uart_ringbuf_stress_demo().
+ */
+static void app_uart_ringbuf_stress_event(enUartChannel uartChannel, enUartRingBufEvent event, uint16_t numAvailable)
+{
+    s_ringbufStressEvent = 1;
+}
+
+/**
+ * @brief   Serial RX ring buffer stress example.
+ * @details The host streams an incrementing byte pattern (0x00, 0x01 ... 0xFF, 0x00 ...) at 921600 baud.
+ *          Data is drained from the circular SDMA buffer on threshold/idle events, every discontinuity
+ *          in the pattern is counted as lost bytes. Received, lost and overrun counters are printed once per second.
+ */
+void app_uart_ringbuf_stress_demo(void)
+{
+    uint8_t  chunk[64];
+    uint8_t  expected   = 0;
+    uint8_t  synced     = APP_FALSE;
+    uint32_t received   = 0;
+    uint32_t lost       = 0;
+    uint32_t last_print = cb_hal_get_tick();
+
+    app_uart_printf("%s\n",__func__);
+    while ((cb_uart_is_tx_busy(uart_config)));
+    uart_config.uartBaudrate = EN_UART_BAUDRATE_921600;
+    cb_uart_ringbuf_init(&uart_config, UART_RX_BUFFER_SIZE);
+    cb_uart_ringbuf_config_event(EN_UART_0, UART_RX_BUFFER_SIZE / 2, 10, app_uart_ringbuf_stress_event);
+
+    while(1)
+    {
+        cb_uart_ringbuf_service(EN_UART_0);
+        if (s_ringbufStressEvent)
+        {
+            s_ringbufStressEvent = 0;
+            uint16_t len;
+            while ((len = cb_uart_ringbuf_read(EN_UART_0, chunk, sizeof(chunk))) > 0)
+            {
+                for (uint16_t i = 0; i < len; i++)
+                {
+                    if ((synced == APP_TRUE) && (chunk[i] != expected))
+                    {
+                        lost += (uint8_t)(chunk[i] - expected);
+                    }
+                    synced   = APP_TRUE;
+                    expected = chunk[i] + 1;
+                }
+                received += len;
+            }
+        }
+        if ((cb_hal_get_tick() - last_print) >= 1000)
+        {
+            last_print = cb_hal_get_tick();
+            app_uart_printf("rx:%lu lost:%lu overruns:%lu\n", received, lost, cb_uart_ringbuf_get_overruns(EN_UART_0));
+        }
+        cb_system_delay_in_us(100);
+    }
+}
+
+static volatile uint32_t s_txqThroughputBytes = 0;
+
+/**
+ * @brief TX queue completion callback used by app_uart_tx_throughput_demo().
+ */
+static void app_uart_tx_throughput_done(enUartChannel uartChannel, void *context)
+{
+    s_txqThroughputBytes += (uint32_t)context;
+}
+
+/**
+ * @brief   Serial TX queue throughput example.
+ * @details For each supported baud rate, frames made of a header, a payload and a CRC segment are kept
+ *          queued for one second. The completed bytes are counted from the TXB empty IRQ callbacks.
+ *          The results are printed at 115200 baud once all rates are measured: the host only has to
+ *          ignore the data received at the other rates.
+ */
+void app_uart_tx_throughput_demo(void)
+{
+    static const enUartBaudrate baudrates[] = {EN_UART_BAUDRATE_115200, EN_UART_BAUDRATE_230400, EN_UART_BAUDRATE_460800,
+                                               EN_UART_BAUDRATE_921600, EN_UART_BAUDRATE_1536000};
+    static const uint32_t       bitrates[]  = {115200, 230400, 460800, 921600, 1536000};
+    static uint8_t              header[5]   = {0x5A, 0x00, 0x00, 0x00, 200};
+    static uint8_t              payload[200];
+    static uint8_t              crc[2]      = {0xA5, 0x5A};
+    uint32_t                    bytesPerSecond[sizeof(baudrates) / sizeof(baudrates[0])];
+    stUartTxSegment             segments[3] = {{header, sizeof(header)}, {payload, sizeof(payload)}, {crc, sizeof(crc)}};
+    uint32_t                    frameLength = sizeof(header) + sizeof(payload) + sizeof(crc);
+
+    for (uint16_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)i;
+    }
+    app_uart_printf("%s\n",__func__);
+
+    for (uint8_t rate = 0; rate < sizeof(baudrates) / sizeof(baudrates[0]); rate++)
+    {
+        app_uart_change_baudrate(baudrates[rate]);
+        s_txqThroughputBytes = 0;
+        uint32_t start = cb_hal_get_tick();
+        while ((cb_hal_get_tick() - start) < 1000)
+        {
+            while (cb_uart_txq_free_slots(EN_UART_0) > 0)
+            {
+                cb_uart_txq_send(EN_UART_0, segments, 3, app_uart_tx_throughput_done, (void *)frameLength);
+            }
+        }
+        bytesPerSecond[rate] = s_txqThroughputBytes;
+    }
+
+    app_uart_change_baudrate(EN_UART_BAUDRATE_115200);
+    cb_system_delay_in_ms(10);
+    for (uint8_t rate = 0; rate < sizeof(baudrates) / sizeof(baudrates[0]); rate++)
+    {
+        // 10 bits per byte on the line (start + 8 data + stop)
+        app_uart_printf("\n%7lu baud: %7lu B/s (%lu%% of line rate)\n", bitrates[rate], bytesPerSecond[rate],
+                        (bytesPerSecond[rate] * 1000UL) / bitrates[rate]);
+    }
+}
+
 /**
  * @brief   Initializes the UART module for communication.
  * @details This function turns on the UART0 module, configures the I/O multiplexer for UART0 RX and TX pins,
@@ -135,6 +265,7 @@ void app_uart_init(void)
     // app_irq_register_irqcallback(EN_IRQENTRY_UART_0_RXB_FULL_APP_IRQ, app_uart_0_rxb_full_callback);
 
     cb_uart_init(uart_config);  
+    cb_uart_txq_init(EN_UART_0, uart_txq_buf, UART_TXQ_BUFFER_SIZE);
 }
 
 /**
@@ -143,6 +274,8 @@ void app_uart_init(void)
  */
 void app_uart_change_baudrate(enUartBaudrate baudrate)
 {
+    while (cb_uart_txq_is_busy(EN_UART_0));                            // Let the TX queue drain
+    while (cb_uart_is_tx_busy(uart_config));
     // Configure UART settings
     uart_config.uartChannel        = EN_UART_0;                        // Set UART channel to UART0
     uart_config.uartMode           = EN_UART_MODE_SDMA;                // Set UART mode to SDMA (or set EN_UART_MODE_FIFO to FIFO)
@@ -184,6 +317,7 @@ void app_uart_printf(const char *format, ...)
 {
     va_list args;
     va_start(args, format);
+    APP_PROF_REGION_BEGIN(uart_printf);
     
     char transmitDataBuffer[256]; // Choose an appropriate buffer size
     vsnprintf((char *)transmitDataBuffer, sizeof(transmitDataBuffer), format, args);
@@ -197,4 +331,5 @@ void app_uart_printf(const char *format, ...)
     while ((cb_uart_is_tx_busy(uart_config) == CB_TRUE));
     cb_uart_transmit(uart_config, (uint8_t *) transmitDataBuffer, (uint16_t) len);
     va_end(args);
+    APP_PROF_REGION_END(uart_printf);
 }
@@ -48,6 +48,18 @@ void app_uart_init(void);
  */
 void app_uart_change_baudrate(enUartBaudrate baudrate);
 
+/**
+ * @brief   Serial RX ring buffer stress example.
+ * @details Expects an incrementing byte pattern from the host and reports received and lost byte counts.
+ */
+void app_uart_ringbuf_stress_demo(void);
+
+/**
+ * @brief   Serial TX queue throughput example.
+ * @details Measures the sustained SDMA TX queue throughput at each supported baud rate.
+ */
+void app_uart_tx_throughput_demo(void);
+
 /**
  * @brief Callback function for UART0 RXD ready interrupt.
  */
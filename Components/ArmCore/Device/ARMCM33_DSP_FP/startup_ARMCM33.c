@@ -36,6 +36,8 @@
 
 #include "APP_CompileOption.h"
 #include "APP_common.h"
+#include "AppSysProfile.h"
+#include "AppSysSupervisor.h"
 
 /*----------------------------------------------------------------------------
   External References
@@ -155,7 +157,7 @@ extern const VECTOR_TABLE_Type __VECTOR_TABLE[496];
        const VECTOR_TABLE_Type __VECTOR_TABLE[496] __VECTOR_TABLE_ATTRIBUTE = {
   (VECTOR_TABLE_Type)(&__INITIAL_SP),       /*     Initial Stack Pointer */
   Reset_Handler,                            /*     Reset Handler */
-  NMI_Handler,                              /* -14 NMI Handler */
+  APP_SUP_NMI_VECTOR,                       /* -14 NMI Handler */
   HardFault_Handler,                        /* -13 Hard Fault Handler */
   MemManage_Handler,                        /* -12 MPU Fault Handler */
   BusFault_Handler,                         /* -11 Bus Fault Handler */
@@ -173,43 +175,43 @@ extern const VECTOR_TABLE_Type __VECTOR_TABLE[496];
   /* Interrupts */
   Interrupt0_Handler,                       /*   0 Interrupt 0 */
   Interrupt1_Handler,                       /*   1 Interrupt 1 */
-  cb_dma_irqhandler,                        /*   2 Interrupt 2 */
-  cb_crypto_irqhandler,                     /*   3 Interrupt 3 */
-  cb_pka_irqhandler,                        /*   4 Interrupt 4 */
-  cb_trng_irqhandler,                       /*   5 Interrupt 5 */
-  cb_crc_irqhandler,                        /*   6 Interrupt 6 */
-  cb_gpio_irqhandler,                       /*   7 Interrupt 7 */
-  cb_spi_irqhandler,                        /*   8 Interrupt 8 */
-  cb_uart_0_irqhandler,                     /*   9  UART0_IRQn */
-  cb_uart_1_irqhandler,                     /*   10 UART1_IRQn */
-  cb_i2c_irqhandler,                        /*   11 Interrupt 11 */                              
-  cb_timer_0_irqhandler,                    /*   12 TIMER_0_IRQn */
-  cb_timer_1_irqhandler,                    /*   13 TIMER_1_IRQn */
-  cb_timer_2_irqhandler,                    /*   14 TIMER_2_IRQn */
-  cb_timer_3_irqhandler,                    /*   15 TIMER_3_IRQn */
+  APP_PROF_VECTOR(cb_dma_irqhandler),       /*   2 Interrupt 2 */
+  APP_PROF_VECTOR(cb_crypto_irqhandler),    /*   3 Interrupt 3 */
+  APP_PROF_VECTOR(cb_pka_irqhandler),       /*   4 Interrupt 4 */
+  APP_PROF_VECTOR(cb_trng_irqhandler),      /*   5 Interrupt 5 */
+  APP_PROF_VECTOR(cb_crc_irqhandler),       /*   6 Interrupt 6 */
+  APP_PROF_VECTOR(cb_gpio_irqhandler),      /*   7 Interrupt 7 */
+  APP_PROF_VECTOR(cb_spi_irqhandler),       /*   8 Interrupt 8 */
+  APP_PROF_VECTOR(cb_uart_0_irqhandler),    /*   9  UART0_IRQn */
+  APP_PROF_VECTOR(cb_uart_1_irqhandler),    /*   10 UART1_IRQn */
+  APP_PROF_VECTOR(cb_i2c_irqhandler),       /*   11 Interrupt 11 */                              
+  APP_PROF_VECTOR(cb_timer_0_irqhandler),   /*   12 TIMER_0_IRQn */
+  APP_PROF_VECTOR(cb_timer_1_irqhandler),   /*   13 TIMER_1_IRQn */
+  APP_PROF_VECTOR(cb_timer_2_irqhandler),   /*   14 TIMER_2_IRQn */
+  APP_PROF_VECTOR(cb_timer_3_irqhandler),   /*   15 TIMER_3_IRQn */
   Interrupt16_Handler,                      /*   16 Interrupt 16 */
   Interrupt17_Handler,                      /*   17 Interrupt 17 */
 #if __has_include(<CB_ble.h>)
-  CB_BLE_IRQ_Handler,                       /*   18 Interrupt 18 */
+  APP_PROF_VECTOR(CB_BLE_IRQ_Handler),      /*   18 Interrupt 18 */
 #else
   Interrupt18_Handler,
 #endif
   Interrupt19_Handler,                      /*   19 Interrupt 19 */
   Interrupt20_Handler,                      /*   20 Interrupt 20 */
-  cb_uwb_rx0_done_irqhandler,               /*   21 UWB_RX0_DONE_IRQn */
-  cb_uwb_rx0_preamble_detected_irqhandler,  /*   22 UWB_RX0_PD_DONE_IRQn */
-  cb_uwb_rx0_sfd_detected_irqhandler,       /*   23 UWB_RX0_SFD_DET_DONE */
-  cb_uwb_rx1_done_irqhandler,               /*   24 UWB_RX1_DONE_IRQn */
-  cb_uwb_rx1_preamble_detected_irqhandler,  /*   25 UWB_RX1_PD_DONE_IRQn */
-  cb_uwb_rx1_sfd_detected_irqhandler,       /*   26 UWB_RX1_SFD_DET_DONE */
-  cb_uwb_rx2_done_irqhandler,               /*   27 UWB_RX2_DONE_IRQn */
-  cb_uwb_rx2_preamble_detected_irqhandler,  /*   28 UWB_RX2_PD_DONE_IRQn */
-  cb_uwb_rx2_sfd_detected_irqhandler,       /*   29 UWB_RX2_SFD_DET_DONE */
-  cb_uwb_rx_sts_cir_end_irqhandler,         /*   30 UWB_RX_STS_CIR_END_IRQn */
-  cb_uwb_rx_phr_detected_irqhandler,        /*   31 UWB_RX_PHR_DETECTED_IRQn */
-  cb_uwb_rx_done_irqhandler,                /*   32 UWB_RX_DONE_IRQn */
-  cb_uwb_tx_done_irqhandler,                /*   33 UWB_TX_DONE_IRQn */
-  cb_uwb_tx_sfd_mark_irqhandler,            /*   34 UWB_TX_SFD_MARK_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx0_done_irqhandler),                /*   21 UWB_RX0_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx0_preamble_detected_irqhandler),   /*   22 UWB_RX0_PD_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx0_sfd_detected_irqhandler),        /*   23 UWB_RX0_SFD_DET_DONE */
+  APP_PROF_VECTOR(cb_uwb_rx1_done_irqhandler),                /*   24 UWB_RX1_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx1_preamble_detected_irqhandler),   /*   25 UWB_RX1_PD_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx1_sfd_detected_irqhandler),        /*   26 UWB_RX1_SFD_DET_DONE */
+  APP_PROF_VECTOR(cb_uwb_rx2_done_irqhandler),                /*   27 UWB_RX2_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx2_preamble_detected_irqhandler),   /*   28 UWB_RX2_PD_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx2_sfd_detected_irqhandler),        /*   29 UWB_RX2_SFD_DET_DONE */
+  APP_PROF_VECTOR(cb_uwb_rx_sts_cir_end_irqhandler),          /*   30 UWB_RX_STS_CIR_END_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx_phr_detected_irqhandler),         /*   31 UWB_RX_PHR_DETECTED_IRQn */
+  APP_PROF_VECTOR(cb_uwb_rx_done_irqhandler),                 /*   32 UWB_RX_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_tx_done_irqhandler),                 /*   33 UWB_TX_DONE_IRQn */
+  APP_PROF_VECTOR(cb_uwb_tx_sfd_mark_irqhandler),             /*   34 UWB_TX_SFD_MARK_IRQn */
   Interrupt35_Handler,                      /*   35 Interrupt 35 */
   Interrupt36_Handler,                      /*   36 Interrupt 36 */
   Interrupt37_Handler,                      /*   37 Interrupt 37 */
@@ -276,6 +278,9 @@ volatile uint32_t sysTickCounter = 0;// System tick counter
 void SysTick_Handler(void) 
 {
   sysTickCounter++;
+#if (APP_PROFILE_ENABLE == APP_TRUE)
+  (void)app_prof_cycles64(); // see the 32 bit counter wrap
+#endif
 }
 /*----------------------------------------------------------------------------
   Default Handler for Exceptions / Interrupts
@@ -46,6 +46,10 @@
 #define UART_RX_BUFFER_SIZE 0x100
 #define CMD_RX_BUF_SIZE 256
 #define CMD_TX_BUF_SIZE 32
+
+#ifndef CMD_PARSER_UART_RX_RINGBUF_ENABLE
+#define CMD_PARSER_UART_RX_RINGBUF_ENABLE APP_FALSE // Circular SDMA RX: no RX restart between frames
+#endif
 //-------------------------------
 // ENUM SECTION
 //-------------------------------
@@ -86,6 +90,9 @@ static uint8_t cmd_ready_flag = APP_FALSE;
 
 static stUartConfig uart_config;
 static uint8_t cmd_parser_uart_rxbuf[CMD_RX_BUF_SIZE];
+#if (CMD_PARSER_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+static uint16_t cmd_parser_uart_frame_len = 0;
+#endif
 
 
 //-------------------------------
@@ -131,7 +138,11 @@ static void cmd_parser_uart_configer(uint8_t tx_pin, uint8_t rx_pin)
     /* Callback IRQ register omitted in current SDK to improve IRQ processing time */
     // app_irq_deregister_irqcallback(EN_IRQENTRY_UART_0_RXB_FULL_APP_IRQ, app_uart_0_rxb_full_callback); // Register RX buffer full callback (omitted for performance)
       
+#if (CMD_PARSER_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+    cb_uart_ringbuf_init(&uart_config, UART_RX_BUFFER_SIZE);
+#else
     cb_uart_init(uart_config); // Initialize UART with the configured settings  
+#endif
 }
 
 /**
@@ -170,15 +181,78 @@ void cmd_parser_uart_deinit(void)
    cb_scr_uart0_module_off();
 }
 
+#if (CMD_PARSER_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+/**
+ * @brief Polls for valid commands in the UART RX ring buffer.
+ *        The function searches the marker byte, waits for the full frame and validates the checksum.
+ *        Bytes of an invalid frame are dropped one at a time to resynchronize on the next marker.
+ */
+uint8_t cmd_parser_uart_pooling_cmd(void)
+{
+    uint16_t available = 0;
+    uint16_t frame_len = 0;
+
+    cmd_ready_flag = APP_FALSE;
+
+    while (cmd_ready_flag != APP_TRUE)
+    {
+        available = cb_uart_ringbuf_available(EN_UART_0);
+        if (available == 0)
+        {
+            return cmd_ready_flag;
+        }
+        cb_uart_ringbuf_peek(EN_UART_0, &cmd_parser_uart_rxbuf[0], 0, DEF_RXMARKER_SIZE);
+        if (cmd_parser_uart_rxbuf[DEF_RXMARKER_POS] != DEF_RXMARKER_VAL)
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, 1); //Marker Mismtached
+            continue;
+        }
+        if (available < DEF_HEADER_SIZE)
+        {
+            continue; // Wait for the header
+        }
+        cb_uart_ringbuf_peek(EN_UART_0, &cmd_parser_uart_rxbuf[0], 0, DEF_HEADER_SIZE);
+        frame_len = DEF_HEADER_SIZE + cmd_parser_uart_rxbuf[DEF_DL_POS] + DEF_CHECKSUM_SIZE;
+        if ((frame_len > CMD_RX_BUF_SIZE) || (frame_len > UART_RX_BUFFER_SIZE))
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, 1); // Cannot be a valid frame
+            continue;
+        }
+        if (available < frame_len)
+        {
+            continue; // Wait for data and checksum
+        }
+        cb_uart_ringbuf_peek(EN_UART_0, &cmd_parser_uart_rxbuf[0], 0, frame_len);
+        uint8_t checksun = 0;
+        for (uint16_t i = 1; i < (frame_len - DEF_CHECKSUM_SIZE); i++)
+        {
+            checksun += cmd_parser_uart_rxbuf[i];
+        }
+        if (checksun == cmd_parser_uart_rxbuf[frame_len - DEF_CHECKSUM_SIZE])
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, frame_len);
+            cmd_parser_uart_frame_len = frame_len;
+            cmd_ready_flag = APP_TRUE;
+        }
+        else
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, 1);
+        }
+    }
+    return cmd_ready_flag;
+}
+#else
 /**
  * @brief Polls for valid commands in the UART receive buffer using a state machine.
  *        The function waits for a specific marker byte, reads command headers and data, and validates the checksum.
+ *        Only the bytes not yet copied are fetched from the SDMA buffer on each state transition.
  */
 uint8_t cmd_parser_uart_pooling_cmd(void)
 {
     uint16_t received_len = 0;
     uint16_t expected_len = 0;
     uint16_t checksum_pos = 0;
+    uint16_t copied_len   = 0;
 
     cmd_parser_uart_state = EN_UartRxWAITING;    
     cmd_ready_flag = APP_FALSE;
@@ -191,7 +265,8 @@ uint8_t cmd_parser_uart_pooling_cmd(void)
        
         if (received_len >= expected_len )
         {
-            cb_uart_get_rx_buffer(EN_UART_0,&cmd_parser_uart_rxbuf[0],expected_len); //updating the Buffer
+            memcpy(&cmd_parser_uart_rxbuf[copied_len], &uart_rxbuf[copied_len], expected_len - copied_len); //updating the Buffer with new bytes only
+            copied_len = expected_len;
             switch (cmd_parser_uart_state)
             {
                 case EN_UartRxWAITING:
@@ -205,6 +280,7 @@ uint8_t cmd_parser_uart_pooling_cmd(void)
                     {
                         //Marker Mismtached
                         cb_uart_rx_restart(EN_UART_0);
+                        copied_len = 0;
                     }
                 break;
                 case EN_UartRxMARKER_DONE:
@@ -222,6 +298,7 @@ uint8_t cmd_parser_uart_pooling_cmd(void)
 
                     //Marker Mismtached
                     cb_uart_rx_restart(EN_UART_0);
+                    copied_len = 0;
                 break;
 
                 case EN_UartRxHEADER_DONE:
@@ -241,11 +318,13 @@ uint8_t cmd_parser_uart_pooling_cmd(void)
                         expected_len = DEF_RXMARKER_SIZE;
                         cmd_parser_uart_state = EN_UartRxWAITING;
                         cb_uart_rx_restart(EN_UART_0);
+                        copied_len = 0;
                     }
                 break;
                 case EN_UartRxCHECKSUM_DONE:
                 default: //unexpected behaviour
-                   cb_uart_rx_restart(EN_UART_0);
+                    cb_uart_rx_restart(EN_UART_0);
+                    copied_len = 0;
                 break;
             }
         }
@@ -256,6 +335,7 @@ uint8_t cmd_parser_uart_pooling_cmd(void)
     }
     return cmd_ready_flag;
 }
+#endif
 
 /**
  * @brief Process UART receive buffer.
@@ -329,8 +409,12 @@ void cmd_parser_uart_responder(uint16_t command, uint8_t *buf, uint8_t len)
 
 uint16_t cmd_parser_uart_received_length(void)
 {
+#if (CMD_PARSER_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+    return cmd_parser_uart_frame_len;
+#else
     uint16_t received_length = cb_uart_check_num_received_bytes(EN_UART_0); 
     return received_length;
+#endif
 }
 uint8_t* cmd_parser_uart_received_buffer(void)
 {
@@ -339,7 +423,9 @@ uint8_t* cmd_parser_uart_received_buffer(void)
 
 void cmd_parser_uart_rx_restart(void)
 {
-    cb_uart_rx_restart(EN_UART_0);
+#if (CMD_PARSER_UART_RX_RINGBUF_ENABLE != APP_TRUE)
+    cb_uart_rx_restart(EN_UART_0); // Ring mode: frame already consumed, RX keeps running
+#endif
 }
 /**
  * @brief Initializes the UART driver.
@@ -13,5 +13,10 @@
 
 #define APP_FREERTOS_ENABLE           APP_FALSE
 #define APP_BLE_ENABLE                APP_FALSE
+#define APP_PROFILE_ENABLE            APP_FALSE     // DWT cycle profiling, see AppSysProfile.h
+#define APP_SUPERVISOR_ENABLE         APP_FALSE     // Task watchdog supervisor, see AppSysSupervisor.h
+#define APP_SPI_HIF_ENABLE            APP_FALSE     // SPI slave host interface, see app_spi_hif.h
+#define APP_ENTROPY_ENABLE            APP_FALSE     // TRNG entropy pool, see AppSysEntropy.h
+#define APP_TIMESYNC_ENABLE           APP_FALSE     // Wired anchor time sync of uwb_periodic_tx, see CB_uwbtimesync.h
 
 #endif /*__APP_COMPILE_OPTION_H*/
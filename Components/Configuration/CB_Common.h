@@ -17,6 +17,10 @@
 #define NULL 0
 #endif
 
+/* Function run from RAM, in the ER_RAM_CODE region of the scatter file (Tools/Ram_Code).
+   Without that region, the section is placed with the rest of the code in flash. */
+#define CB_RAM_CODE __attribute__((section("SPECIFIC_RAM_CODE")))
+
 typedef enum
 {
   CB_PASS   = 1,
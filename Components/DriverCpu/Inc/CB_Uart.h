@@ -154,6 +154,15 @@ typedef enum {
   EN_UART_FLAG_RXB_WR_ERR         = 0x20000,  /**< UART RX buffer write error occurred */
   EN_UART_FLAG_ALL                = 0x3FFFF   /**< All UART flags combined */
 } enUartFlag;
+
+/**
+ * @brief Enumeration defining UART RX ring buffer events.
+ */
+typedef enum {
+  EN_UART_RINGBUF_EVENT_THRESHOLD = 0, /**< Number of unread bytes reached the configured threshold */
+  EN_UART_RINGBUF_EVENT_IDLE,          /**< No new byte received for the configured number of service calls */
+  EN_UART_RINGBUF_EVENT_OVERRUN,       /**< Unread bytes were overwritten and have been dropped */
+} enUartRingBufEvent;
 //-------------------------------
 // STRUCT/UNION SECTION
 //-------------------------------
@@ -181,6 +190,32 @@ typedef struct
 
 } stUartConfig; 
 
+/**
+ * @brief UART RX ring buffer event callback.
+ *
+ * @param uartChannel  UART channel that raised the event.
+ * @param event        Event type.
+ * @param numAvailable Number of unread bytes in the ring buffer.
+ */
+typedef void (*cb_uart_ringbuf_event_cb_t)(enUartChannel uartChannel, enUartRingBufEvent event, uint16_t numAvailable);
+
+/**
+ * @brief UART TX queue segment (e.g. header, payload or CRC of one frame).
+ */
+typedef struct
+{
+  const uint8_t  *data;    /**< Segment data, must stay valid until the frame completion callback */
+  uint16_t        length;  /**< Segment length in bytes */
+} stUartTxSegment;
+
+/**
+ * @brief UART TX queue frame completion callback, called from the TXB empty IRQ.
+ *
+ * @param uartChannel UART channel of the frame.
+ * @param context     User context given to cb_uart_txq_send().
+ */
+typedef void (*cb_uart_txq_done_cb_t)(enUartChannel uartChannel, void *context);
+
 //-------------------------------
 // GLOBAL VARIABLE SECTION
 //-------------------------------
@@ -390,4 +425,144 @@ void cb_uart_1_rxb_full_app_irq_callback(void);
  */
 void cb_uart_1_txb_empty_app_irq_callback(void);
 
+/**
+ * @brief Initialize UART RX in circular SDMA mode.
+ *
+ * The SDMA RX buffer is used as a ring: reception runs continuously with buffer wrap-around
+ * enabled and is never restarted, so no byte is lost between two reads as long as the consumer
+ * keeps up with the buffer size. The write position is tracked from the RXB_NBYTE counter, the read
+ * position by the driver. The RX buffer full interrupt is not used in this mode.
+ *
+ * The ring must be read or serviced at least once per bufSize received bytes. Beyond that the
+ * SDMA overwrites unread bytes: the driver drops the unread content, counts an overrun
+ * (cb_uart_ringbuf_get_overruns()) and raises EN_UART_RINGBUF_EVENT_OVERRUN on the next service call.
+ * The counter update runs with interrupts masked, the other calls are for a single consumer.
+ *
+ * @param uartConfig Pointer to the UART configuration (SDMA mode, RXbuffer must hold bufSize bytes).
+ *                   uartRxBufWrap, uartRxMaxBytes and the RX buffer full interrupt are overridden.
+ * @param bufSize    Size of the RX buffer in bytes (max 0xFFF).
+ */
+void cb_uart_ringbuf_init(stUartConfig *uartConfig, uint16_t bufSize);
+
+/**
+ * @brief Get the number of unread bytes in the UART RX ring buffer.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return Number of unread bytes.
+ */
+uint16_t cb_uart_ringbuf_available(enUartChannel uartChannel);
+
+/**
+ * @brief Copy unread bytes from the UART RX ring buffer without consuming them.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param dest        Destination buffer.
+ * @param offset      Offset from the read position.
+ * @param numBytes    Number of bytes to copy.
+ * @return Number of bytes copied.
+ */
+uint16_t cb_uart_ringbuf_peek(enUartChannel uartChannel, uint8_t *dest, uint16_t offset, uint16_t numBytes);
+
+/**
+ * @brief Read and consume bytes from the UART RX ring buffer.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param dest        Destination buffer.
+ * @param maxBytes    Maximum number of bytes to read.
+ * @return Number of bytes read.
+ */
+uint16_t cb_uart_ringbuf_read(enUartChannel uartChannel, uint8_t *dest, uint16_t maxBytes);
+
+/**
+ * @brief Consume bytes from the UART RX ring buffer without copying them.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param numBytes    Number of bytes to drop.
+ * @return Number of bytes dropped.
+ */
+uint16_t cb_uart_ringbuf_skip(enUartChannel uartChannel, uint16_t numBytes);
+
+/**
+ * @brief Get the number of UART RX ring buffer overruns.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return Overruns detected since cb_uart_ringbuf_init().
+ */
+uint32_t cb_uart_ringbuf_get_overruns(enUartChannel uartChannel);
+
+/**
+ * @brief Configure the events of the UART RX ring buffer.
+ *
+ * Events are evaluated by cb_uart_ringbuf_service(), each event is raised once per burst.
+ *
+ * @param uartChannel   The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param threshold     Unread byte count raising EN_UART_RINGBUF_EVENT_THRESHOLD (0: disabled).
+ * @param idleServices  Number of service calls without new byte raising EN_UART_RINGBUF_EVENT_IDLE (0: disabled).
+ * @param callback      Event callback, NULL to disable events.
+ */
+void cb_uart_ringbuf_config_event(enUartChannel uartChannel, uint16_t threshold, uint16_t idleServices, cb_uart_ringbuf_event_cb_t callback);
+
+/**
+ * @brief Evaluate the UART RX ring buffer events.
+ *
+ * Call periodically (e.g. from a timer tick or the main loop); the idle-line time is
+ * idleServices times the call period.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ */
+void cb_uart_ringbuf_service(enUartChannel uartChannel);
+
+/**
+ * @brief Initialize the UART SDMA TX queue.
+ *
+ * The queue buffer is split in two halves used as SDMA ping-pong buffers: while one half is
+ * on the line, the segments of the next queued frames are gathered into the other half. The
+ * next half is started from the TXB empty IRQ, so the CPU never waits for the UART.
+ * The UART must already be initialized in SDMA mode and its IRQ enabled in the NVIC.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param buffer      SDMA accessible buffer, distinct from the TXbuffer of the UART configuration.
+ * @param bufSize     Size of the buffer in bytes (even, max 0xFFF * 2).
+ */
+void cb_uart_txq_init(enUartChannel uartChannel, uint8_t *buffer, uint16_t bufSize);
+
+/**
+ * @brief Stop using the UART TX queue. Queued frames are dropped without callback.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ */
+void cb_uart_txq_deinit(enUartChannel uartChannel);
+
+/**
+ * @brief Queue one frame made of several segments for transmission.
+ *
+ * Segments are referenced, not copied: their data must stay valid until the callback.
+ * Empty segments are ignored, a frame without any byte is refused.
+ * Can be called from thread or IRQ context (including from a completion callback).
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param segments    Segment list of the frame.
+ * @param numSegments Number of segments (1 to UART_TXQ_MAX_SEGMENTS).
+ * @param callback    Completion callback, NULL if not needed.
+ * @param context     User context passed to the callback.
+ * @return CB_PASS if the frame is queued, CB_FAIL if the queue is full, the frame is empty or the parameters are invalid.
+ */
+uint8_t cb_uart_txq_send(enUartChannel uartChannel, const stUartTxSegment *segments, uint8_t numSegments, cb_uart_txq_done_cb_t callback, void *context);
+
+/**
+ * @brief Get the number of free frame slots of the UART TX queue.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return Number of frames that can still be queued.
+ */
+uint8_t cb_uart_txq_free_slots(enUartChannel uartChannel);
+
+/**
+ * @brief Check if the UART TX queue is still transmitting.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return CB_TRUE if frames are pending or on the line, CB_FALSE otherwise.
+ */
+uint8_t cb_uart_txq_is_busy(enUartChannel uartChannel);
+
 #endif /* INC_UART_H_ */
@@ -256,6 +256,13 @@ void cb_dma_set_dest_request(stDMAConfig *DMAConfig);
  */
 void cb_dma_clear_dest_request(stDMAConfig *DMAConfig);
 
+/**
+ * @brief Checks if the DMA module is enabled.
+ * @details Lets a user of one channel skip cb_dma_init(), which clears the requests of every channel.
+ * @return Returns CB_TRUE if the DMA module is enabled, otherwise returns CB_FALSE.
+ */
+uint8_t cb_dma_is_enabled(void);
+
 /**
  * @brief Checks if a specified DMA channel is idle.
  * @details This function checks if a specified DMA channel is idle by examining the channel idle status register.
@@ -187,6 +187,15 @@ void cb_gpio_app_irq_callback(void);
  */
 void cb_gpio_irqhandler(void);
 
+/**
+ * @brief   Check whether a pin triggered the GPIO interrupt being handled.
+ * @details For use in cb_gpio_app_irq_callback(), the trigger status being cleared
+ *          before the callback runs.
+ * @param[in]   GPIO_Pin The pin to check.
+ * @return  1 if the pin triggered the interrupt, 0 otherwise.
+ */
+uint8_t cb_gpio_is_irq_triggered(enGpioPin GPIO_Pin);
+
 
 #endif /*INC_GPIO_H*/
 
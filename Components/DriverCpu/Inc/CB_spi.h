@@ -285,6 +285,16 @@ CB_STATUS cb_spi_slave_sdma_start(uint16_t Length,uint32_t TxBufAddr, uint32_t R
  */
 enTransmissonMode cb_spi_get_current_transmission_mode(void);
 
+/**
+ * @brief Retrieves the number of bytes received by the current SDMA transfer.
+ *
+ * In slave mode, a count that stays between 0 and the transfer length is a transfer the master
+ * stopped halfway.
+ *
+ * @return uint16_t Bytes received.
+ */
+uint16_t cb_spi_get_sdma_rx_count(void);
+
 /**
  * @brief Configures the SPI interrupts.
  *
@@ -24,10 +24,23 @@
 // CONFIGURATION SECTION
 //-------------------------------
 #define UART_TX_INTERRUPT_ENABLE  CB_FALSE
+#ifndef UART_TXQ_DEPTH
+#define UART_TXQ_DEPTH            8      //Number of queued frames, power of 2
+#endif
+#ifndef UART_TXQ_MAX_SEGMENTS
+#define UART_TXQ_MAX_SEGMENTS     4      //Number of segments per frame
+#endif
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
 #define MAX_NUM_BYTES_SDMA_BUF    256    //Just used as a send buff security limit
+#define MAX_NUM_BYTES_RING_BUF    0xFFF  //Limit of RXB_MAX_BYTES / RXB_NBYTE fields
+#define UART_RXB_NBYTE_WRAP       0x1000 //RXB_NBYTE is a 12-bit counter
+#define NUM_OF_UART_CHANNEL       2
+#define UART_TXQ_MASK             (UART_TXQ_DEPTH - 1)
+#define UART_TXQ_NUM_SLOT         2      //SDMA ping-pong buffers
+#define UART_RX_RESTART_EVENTS    (UART_EVENT_RXB_FULL | UART_EVENT_RXFIFO_OVF_ERR | UART_EVENT_PARITY_ERR \
+                                   | UART_EVENT_FRAME_ERR | UART_EVENT_BREAK_ERR | UART_EVENT_RXB_WR_ERR)
 //-------------------------------
 // ENUM SECTION
 //-------------------------------
@@ -35,6 +48,58 @@
 //-------------------------------
 // STRUCT/UNION SECTION
 //-------------------------------
+/**
+ * @brief UART RX ring buffer state.
+ */
+typedef struct
+{
+  const volatile uint8_t     *buffer;        /**< SDMA RX buffer */
+  uint16_t                   size;           /**< SDMA RX buffer size */
+  uint16_t                   tail;           /**< Read position, consumed % size */
+  uint16_t                   lastCount;      /**< RXB_NBYTE at the last update */
+  uint32_t                   received;       /**< Bytes written by the SDMA since init, free running */
+  uint32_t                   consumed;       /**< Bytes consumed or dropped since init, free running */
+  uint32_t                   overruns;       /**< Overruns detected since init */
+  uint8_t                    overrunPending; /**< Overrun not yet reported by the service call */
+  uint32_t                   lastReceived;   /**< Received count seen by the last service call */
+  uint16_t                   idleCount;      /**< Service calls without new byte */
+  uint16_t                   idleServices;   /**< Idle event after this many service calls */
+  uint16_t                   threshold;      /**< Threshold event level */
+  uint8_t                    thresholdRaised;/**< Threshold event raised for the current burst */
+  uint8_t                    idleRaised;     /**< Idle event raised for the current burst */
+  cb_uart_ringbuf_event_cb_t callback;       /**< Event callback */
+} stUartRingBuf;
+
+/**
+ * @brief UART TX queue frame.
+ */
+typedef struct
+{
+  stUartTxSegment            segments[UART_TXQ_MAX_SEGMENTS];
+  uint8_t                    numSegments;
+  cb_uart_txq_done_cb_t      callback;
+  void                       *context;
+} stUartTxFrame;
+
+/**
+ * @brief UART TX queue state.
+ *        head/tail are free running: tail is written by the producer only, head by the TXB empty IRQ only.
+ */
+typedef struct
+{
+  uint8_t                    *buffer;                        /**< SDMA ping-pong buffers */
+  uint16_t                   slotSize;                       /**< Size of one ping-pong buffer */
+  stUartTxFrame              frames[UART_TXQ_DEPTH];
+  volatile uint8_t           head;                           /**< Oldest frame not completed */
+  volatile uint8_t           tail;                           /**< Next free frame slot */
+  uint8_t                    packFrame;                      /**< Frame being gathered */
+  uint8_t                    packSegment;                    /**< Segment being gathered */
+  uint16_t                   packOffset;                     /**< Offset in the segment being gathered */
+  uint16_t                   slotLength[UART_TXQ_NUM_SLOT];  /**< Bytes gathered in each buffer */
+  uint8_t                    slotDone[UART_TXQ_NUM_SLOT];    /**< Frames completed by each buffer */
+  uint8_t                    activeSlot;                     /**< Buffer on the line */
+  volatile uint8_t           busy;                           /**< A buffer is on the line */
+} stUartTxQueue;
 
 //-------------------------------
 // GLOBAL VARIABLE SECTION
@@ -46,6 +111,12 @@ static UART_TypeDef *UART1 = (UART_TypeDef* ) UART1_BASE_ADDR;
 static enUartMode       enUart0ModeConfigured;
 static enUartMode       enUart1ModeConfigured;
 
+// for circular SDMA RX mode
+static stUartRingBuf    stUartRingBufState[NUM_OF_UART_CHANNEL];
+
+// for SDMA TX queue
+static stUartTxQueue    stUartTxQueueState[NUM_OF_UART_CHANNEL];
+
 // for SDMA mode
 // static uint8_t transmitDataBuffer0[MAX_NUM_BYTES_SDMA_BUF]  __attribute__((section("SPECIFIC_UART_TX_SDMA_RAM")));
 // static uint8_t receiveDataBuffer0[MAX_NUM_BYTES_SDMA_BUF]   __attribute__((section("SPECIFIC_UART_TX_SDMA_RAM")));
@@ -59,6 +130,7 @@ void cb_uart_0_rxb_full_irq_callback(void);
 void cb_uart_0_txb_empty_irq_callback(void);
 void cb_uart_1_rxb_full_irq_callback(void);
 void cb_uart_1_txb_empty_irq_callback(void);
+static void cb_uart_txq_irq_service(enUartChannel uartChannel);
 //-------------------------------
 // INLINE FUNCTION SECTION
 //-------------------------------
@@ -71,6 +143,61 @@ static inline UART_TypeDef* cb_uart_get_channel(enUartChannel uartChannel)
       default: return NULL; // Invalid channel
     }
 }
+static inline stUartRingBuf* cb_uart_get_ringbuf(enUartChannel uartChannel)
+{
+    switch (uartChannel)
+    {
+      case EN_UART_0: return &stUartRingBufState[0];
+      case EN_UART_1: return &stUartRingBufState[1];
+      default: return NULL; // Invalid channel
+    }
+}
+
+static inline stUartTxQueue* cb_uart_get_txq(enUartChannel uartChannel)
+{
+    switch (uartChannel)
+    {
+      case EN_UART_0: return &stUartTxQueueState[0];
+      case EN_UART_1: return &stUartTxQueueState[1];
+      default: return NULL; // Invalid channel
+    }
+}
+
+static inline uint8_t cb_uart_hw_tx_busy(UART_TypeDef *UART)
+{
+    return ((UART->EVENT & UART_EVENT_TXB_EMPTY_MSK) != UART_EVENT_TXB_EMPTY) && ((UART->EVENT & UART_EVENT_TX_ON_MSK) == UART_EVENT_TX_ON);
+}
+
+/**
+ * RXB_NBYTE keeps counting across the buffer wraps and wraps itself at 0x1000, which is not a
+ * multiple of every buffer size: the write position is not RXB_NBYTE % size. The counter delta
+ * since the last update is accumulated into the free running received count instead, and the
+ * write position is received % size. The delta is only exact if the ring is updated at least
+ * once per 0xFFF received bytes, which any consumer keeping up with the buffer size does.
+ * More than size unread bytes means the SDMA has overwritten unread data: the unread content is
+ * dropped (the overwritten part cannot be told apart from the rest) and the overrun is counted.
+ */
+static uint32_t cb_uart_ringbuf_update(UART_TypeDef *UART, stUartRingBuf *ring)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint16_t count = (uint16_t)((UART->TRX & UART_RXB_NBYTE_MSK) >> UART_RXB_NBYTE_POS);
+    ring->received += (uint16_t)(count - ring->lastCount) & (UART_RXB_NBYTE_WRAP - 1);
+    ring->lastCount = count;
+
+    uint32_t available = ring->received - ring->consumed;
+    if (available > ring->size)
+    {
+        ring->consumed       = ring->received;
+        ring->tail           = (uint16_t)(ring->received % ring->size);
+        ring->overruns++;
+        ring->overrunPending = CB_TRUE;
+        available            = 0;
+    }
+    __set_PRIMASK(primask);
+    return available;
+}
 //-------------------------------
 // FUNCTION BODY SECTION
 //-------------------------------
@@ -306,6 +433,7 @@ void cb_uart_transmit(stUartConfig uartConfig, uint8_t *data, uint16_t size)
     if (UART == NULL) {
             return; // Invalid channel
     }
+    while (cb_uart_get_txq(uartConfig.uartChannel)->busy);     // TX queue owns TXBUF until it is drained
     UART->TXBUF = uartConfig.TXbuffer;
 
     // Set the number of bytes to transmit
@@ -352,7 +480,11 @@ uint8_t cb_uart_is_tx_busy(stUartConfig uartConfig)
     {
             return CB_TRUE; // Invalid channel, consider TX as busy
     }
-    return ((UART->EVENT & UART_EVENT_TXB_EMPTY_MSK) != UART_EVENT_TXB_EMPTY) && ((UART->EVENT & UART_EVENT_TX_ON_MSK) == UART_EVENT_TX_ON);
+    if (cb_uart_get_txq(uartConfig.uartChannel)->busy)
+    {
+            return CB_TRUE; // TX queue transmitting
+    }
+    return cb_uart_hw_tx_busy(UART);
 }
 
 /**
@@ -490,6 +622,470 @@ void cb_uart_rx_restart(enUartChannel uartChannel)
     UART->RXCTRL |= UART_RXCTRL_START; // Start Pulse
 }
 
+/**
+ * @brief Initialize UART RX in circular SDMA mode.
+ *
+ * @param uartConfig Pointer to the UART configuration (SDMA mode, RXbuffer must hold bufSize bytes).
+ * @param bufSize    Size of the RX buffer in bytes (max 0xFFF).
+ */
+void cb_uart_ringbuf_init(stUartConfig *uartConfig, uint16_t bufSize)
+{
+    stUartRingBuf *ring = cb_uart_get_ringbuf(uartConfig->uartChannel);
+
+    if ((ring == NULL) || (bufSize == 0) || (bufSize > MAX_NUM_BYTES_RING_BUF) || (uartConfig->RXbuffer == 0)) 
+    {
+        return; // Invalid channel or buffer
+    }
+    memset(ring, 0, sizeof(stUartRingBuf));
+    ring->buffer = (const volatile uint8_t *)uartConfig->RXbuffer;
+
+    uartConfig->uartMode        = EN_UART_MODE_SDMA;
+    uartConfig->uartRxBufWrap   = EN_UART_RXBUF_WRAP_ENABLE;
+    uartConfig->uartRxMaxBytes  = bufSize;
+    uartConfig->uartInt        &= (uint16_t)~EN_UART_INT_RXB_FULL; // IRQ handler would restart RX
+    cb_uart_init(*uartConfig);
+
+    UART_TypeDef *UART = cb_uart_get_channel(uartConfig->uartChannel);
+    ring->lastCount = (uint16_t)((UART->TRX & UART_RXB_NBYTE_MSK) >> UART_RXB_NBYTE_POS);
+    ring->size      = bufSize;
+}
+
+/**
+ * @brief Get the number of unread bytes in the UART RX ring buffer.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return Number of unread bytes.
+ */
+uint16_t cb_uart_ringbuf_available(enUartChannel uartChannel)
+{
+    UART_TypeDef  *UART = cb_uart_get_channel(uartChannel);
+    stUartRingBuf *ring = cb_uart_get_ringbuf(uartChannel);
+
+    if ((UART == NULL) || (ring == NULL) || (ring->size == 0))
+    {
+        return 0;
+    }
+    return (uint16_t)cb_uart_ringbuf_update(UART, ring);
+}
+
+/**
+ * @brief Copy unread bytes from the UART RX ring buffer without consuming them.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param dest        Destination buffer.
+ * @param offset      Offset from the read position.
+ * @param numBytes    Number of bytes to copy.
+ * @return Number of bytes copied.
+ */
+uint16_t cb_uart_ringbuf_peek(enUartChannel uartChannel, uint8_t *dest, uint16_t offset, uint16_t numBytes)
+{
+    stUartRingBuf *ring      = cb_uart_get_ringbuf(uartChannel);
+    uint16_t      available  = cb_uart_ringbuf_available(uartChannel);
+
+    if ((dest == NULL) || (offset >= available))
+    {
+        return 0;
+    }
+    if (numBytes > (available - offset))
+    {
+        numBytes = available - offset;
+    }
+
+    uint16_t pos = ring->tail + offset;
+    if (pos >= ring->size)
+    {
+        pos -= ring->size;
+    }
+    uint16_t firstPart = ring->size - pos;   // bytes until buffer end
+    if (firstPart > numBytes)
+    {
+        firstPart = numBytes;
+    }
+    memcpy(dest, (const void *)&ring->buffer[pos], firstPart);
+    memcpy(dest + firstPart, (const void *)&ring->buffer[0], numBytes - firstPart);
+    return numBytes;
+}
+
+/**
+ * @brief Read and consume bytes from the UART RX ring buffer.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param dest        Destination buffer.
+ * @param maxBytes    Maximum number of bytes to read.
+ * @return Number of bytes read.
+ */
+uint16_t cb_uart_ringbuf_read(enUartChannel uartChannel, uint8_t *dest, uint16_t maxBytes)
+{
+    uint16_t numBytes = cb_uart_ringbuf_peek(uartChannel, dest, 0, maxBytes);
+    return cb_uart_ringbuf_skip(uartChannel, numBytes);
+}
+
+/**
+ * @brief Consume bytes from the UART RX ring buffer without copying them.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param numBytes    Number of bytes to drop.
+ * @return Number of bytes dropped.
+ */
+uint16_t cb_uart_ringbuf_skip(enUartChannel uartChannel, uint16_t numBytes)
+{
+    stUartRingBuf *ring      = cb_uart_get_ringbuf(uartChannel);
+    uint16_t      available  = cb_uart_ringbuf_available(uartChannel);
+
+    if (numBytes > available)
+    {
+        numBytes = available;
+    }
+    if (numBytes > 0)
+    {
+        uint16_t tail = ring->tail + numBytes;
+        ring->tail      = (tail >= ring->size) ? (uint16_t)(tail - ring->size) : tail;
+        ring->consumed += numBytes;
+        if ((available - numBytes) < ring->threshold)
+        {
+            ring->thresholdRaised = CB_FALSE;
+        }
+    }
+    return numBytes;
+}
+
+/**
+ * @brief Get the number of UART RX ring buffer overruns.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return Overruns detected since cb_uart_ringbuf_init().
+ */
+uint32_t cb_uart_ringbuf_get_overruns(enUartChannel uartChannel)
+{
+    stUartRingBuf *ring = cb_uart_get_ringbuf(uartChannel);
+
+    return (ring == NULL) ? 0 : ring->overruns;
+}
+
+/**
+ * @brief Configure the events of the UART RX ring buffer.
+ *
+ * @param uartChannel   The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param threshold     Unread byte count raising EN_UART_RINGBUF_EVENT_THRESHOLD (0: disabled).
+ * @param idleServices  Number of service calls without new byte raising EN_UART_RINGBUF_EVENT_IDLE (0: disabled).
+ * @param callback      Event callback, NULL to disable events.
+ */
+void cb_uart_ringbuf_config_event(enUartChannel uartChannel, uint16_t threshold, uint16_t idleServices, cb_uart_ringbuf_event_cb_t callback)
+{
+    stUartRingBuf *ring = cb_uart_get_ringbuf(uartChannel);
+
+    if (ring == NULL)
+    {
+        return;
+    }
+    ring->callback        = NULL;
+    ring->threshold       = threshold;
+    ring->idleServices    = idleServices;
+    ring->idleCount       = 0;
+    ring->thresholdRaised = CB_FALSE;
+    ring->idleRaised      = CB_FALSE;
+    ring->callback        = callback;
+}
+
+/**
+ * @brief Evaluate the UART RX ring buffer events.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ */
+void cb_uart_ringbuf_service(enUartChannel uartChannel)
+{
+    UART_TypeDef  *UART = cb_uart_get_channel(uartChannel);
+    stUartRingBuf *ring = cb_uart_get_ringbuf(uartChannel);
+
+    if ((UART == NULL) || (ring == NULL) || (ring->size == 0) || (ring->callback == NULL))
+    {
+        return;
+    }
+
+    uint16_t available = cb_uart_ringbuf_available(uartChannel);
+
+    if (ring->overrunPending == CB_TRUE)
+    {
+        ring->overrunPending  = CB_FALSE;
+        ring->thresholdRaised = CB_FALSE;
+        ring->callback(uartChannel, EN_UART_RINGBUF_EVENT_OVERRUN, available);
+    }
+    if (ring->received != ring->lastReceived)
+    {
+        ring->lastReceived = ring->received;
+        ring->idleCount  = 0;
+        ring->idleRaised = CB_FALSE;
+    }
+    else if (ring->idleCount < ring->idleServices)
+    {
+        ring->idleCount++;
+    }
+
+    if ((ring->threshold != 0) && (available >= ring->threshold) && (ring->thresholdRaised == CB_FALSE))
+    {
+        ring->thresholdRaised = CB_TRUE;
+        ring->callback(uartChannel, EN_UART_RINGBUF_EVENT_THRESHOLD, available);
+    }
+    if ((ring->idleServices != 0) && (available > 0) && (ring->idleCount >= ring->idleServices) && (ring->idleRaised == CB_FALSE))
+    {
+        ring->idleRaised = CB_TRUE;
+        ring->callback(uartChannel, EN_UART_RINGBUF_EVENT_IDLE, available);
+    }
+}
+
+/**
+ * @brief Gather the next queued segments into one SDMA TX buffer.
+ *
+ * @param txq  TX queue.
+ * @param slot Buffer index.
+ * @return Number of bytes gathered.
+ */
+static uint16_t cb_uart_txq_fill(stUartTxQueue *txq, uint8_t slot)
+{
+    uint8_t  *dest   = &txq->buffer[slot * txq->slotSize];
+    uint16_t length  = 0;
+    uint8_t  done    = 0;
+
+    while ((length < txq->slotSize) && (txq->packFrame != txq->tail))
+    {
+        const stUartTxFrame   *frame   = &txq->frames[txq->packFrame & UART_TXQ_MASK];
+        const stUartTxSegment *segment = &frame->segments[txq->packSegment];
+        uint16_t              numBytes = segment->length - txq->packOffset;
+
+        if (numBytes > (txq->slotSize - length))
+        {
+            numBytes = txq->slotSize - length;
+        }
+        memcpy(&dest[length], &segment->data[txq->packOffset], numBytes);
+        length          += numBytes;
+        txq->packOffset += numBytes;
+
+        if (txq->packOffset >= segment->length)
+        {
+            txq->packOffset = 0;
+            if (++txq->packSegment >= frame->numSegments)
+            {
+                txq->packSegment = 0;
+                txq->packFrame++;
+                done++;
+            }
+        }
+    }
+    txq->slotLength[slot] = length;
+    txq->slotDone[slot]   = done;
+    return length;
+}
+
+/**
+ * @brief Start the SDMA transmission of one TX queue buffer.
+ *
+ * @param UART UART registers.
+ * @param txq  TX queue.
+ * @param slot Buffer index.
+ */
+static void cb_uart_txq_start(UART_TypeDef *UART, stUartTxQueue *txq, uint8_t slot)
+{
+    txq->activeSlot = slot;
+    txq->busy       = CB_TRUE;
+    UART->TXBUF     = (uint32_t)&txq->buffer[slot * txq->slotSize];
+    UART->BUF_SIZE  = (UART->BUF_SIZE & ~(0xFFFUL)) | (uint32_t)txq->slotLength[slot];
+    UART->TXCTRL    = UART_TXCTRL_START;
+}
+
+/**
+ * @brief TX queue handling of the TXB empty interrupt.
+ *        Starts the already gathered buffer first, then refills the released one and
+ *        reports the frames completed by the released buffer.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ */
+static void cb_uart_txq_irq_service(enUartChannel uartChannel)
+{
+    UART_TypeDef  *UART = cb_uart_get_channel(uartChannel);
+    stUartTxQueue *txq  = cb_uart_get_txq(uartChannel);
+
+    if ((UART == NULL) || (txq == NULL) || (txq->buffer == NULL) || (txq->busy == CB_FALSE))
+    {
+        return;
+    }
+
+    uint8_t sentSlot = txq->activeSlot;
+    uint8_t nextSlot = sentSlot ^ 1;
+    uint8_t done     = txq->slotDone[sentSlot];
+
+    txq->slotLength[sentSlot] = 0;
+    txq->slotDone[sentSlot]   = 0;
+
+    if (txq->slotLength[nextSlot] > 0)
+    {
+        cb_uart_txq_start(UART, txq, nextSlot);
+        cb_uart_txq_fill(txq, sentSlot);
+    }
+    else
+    {
+        txq->busy     = CB_FALSE;
+        UART->INT_EN &= ~EN_UART_INT_TXB_EMPTY;               // Event stays set while idle
+    }
+
+    while (done-- > 0)
+    {
+        stUartTxFrame         *frame    = &txq->frames[txq->head & UART_TXQ_MASK];
+        cb_uart_txq_done_cb_t callback  = frame->callback;
+        void                  *context  = frame->context;
+
+        txq->head++;
+        if (callback != NULL)
+        {
+            callback(uartChannel, context);
+        }
+    }
+}
+
+/**
+ * @brief Initialize the UART SDMA TX queue.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param buffer      SDMA accessible buffer, distinct from the TXbuffer of the UART configuration.
+ * @param bufSize     Size of the buffer in bytes.
+ */
+void cb_uart_txq_init(enUartChannel uartChannel, uint8_t *buffer, uint16_t bufSize)
+{
+    UART_TypeDef  *UART = cb_uart_get_channel(uartChannel);
+    stUartTxQueue *txq  = cb_uart_get_txq(uartChannel);
+
+    if ((UART == NULL) || (txq == NULL) || (buffer == NULL) || ((bufSize / UART_TXQ_NUM_SLOT) == 0))
+    {
+        return;
+    }
+    UART->INT_EN &= ~EN_UART_INT_TXB_EMPTY;
+    memset(txq, 0, sizeof(stUartTxQueue));
+    txq->buffer   = buffer;
+    txq->slotSize = bufSize / UART_TXQ_NUM_SLOT;
+    if (txq->slotSize > MAX_NUM_BYTES_RING_BUF)
+    {
+        txq->slotSize = MAX_NUM_BYTES_RING_BUF;               // BUF_SIZE TX length field
+    }
+}
+
+/**
+ * @brief Stop using the UART TX queue.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ */
+void cb_uart_txq_deinit(enUartChannel uartChannel)
+{
+    UART_TypeDef  *UART = cb_uart_get_channel(uartChannel);
+    stUartTxQueue *txq  = cb_uart_get_txq(uartChannel);
+
+    if ((UART == NULL) || (txq == NULL))
+    {
+        return;
+    }
+    UART->INT_EN &= ~EN_UART_INT_TXB_EMPTY;
+    while (txq->busy && cb_uart_hw_tx_busy(UART));             // Let the buffer on the line finish
+    memset(txq, 0, sizeof(stUartTxQueue));
+}
+
+/**
+ * @brief Queue one frame made of several segments for transmission.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @param segments    Segment list of the frame.
+ * @param numSegments Number of segments.
+ * @param callback    Completion callback, NULL if not needed.
+ * @param context     User context passed to the callback.
+ * @return CB_PASS if the frame is queued, CB_FAIL otherwise.
+ */
+uint8_t cb_uart_txq_send(enUartChannel uartChannel, const stUartTxSegment *segments, uint8_t numSegments, cb_uart_txq_done_cb_t callback, void *context)
+{
+    UART_TypeDef  *UART = cb_uart_get_channel(uartChannel);
+    stUartTxQueue *txq  = cb_uart_get_txq(uartChannel);
+
+    if ((UART == NULL) || (txq == NULL) || (txq->buffer == NULL) || (segments == NULL) 
+        || (numSegments == 0) || (numSegments > UART_TXQ_MAX_SEGMENTS))
+    {
+        return CB_FAIL;
+    }
+    if ((uint8_t)(txq->tail - txq->head) >= UART_TXQ_DEPTH)
+    {
+        return CB_FAIL; // Queue full
+    }
+
+    // Empty segments are dropped: a frame is gathered and completed together with its last byte.
+    // A frame without any byte would never complete and would leave the queue busy.
+    stUartTxFrame *frame = &txq->frames[txq->tail & UART_TXQ_MASK];
+    frame->numSegments = 0;
+    for (uint8_t i = 0; i < numSegments; i++)
+    {
+        if (segments[i].length > 0)
+        {
+            frame->segments[frame->numSegments++] = segments[i];
+        }
+    }
+    if (frame->numSegments == 0)
+    {
+        return CB_FAIL;
+    }
+    frame->callback    = callback;
+    frame->context     = context;
+
+    // The TXB empty IRQ is the only other user of the queue state: mask it while kicking.
+    UART->INT_EN &= ~EN_UART_INT_TXB_EMPTY;
+    txq->tail++;
+    if (txq->busy == CB_FALSE)
+    {
+        while (cb_uart_hw_tx_busy(UART));                      // Transfer started by cb_uart_transmit()
+        if (cb_uart_txq_fill(txq, 0) > 0)
+        {
+            cb_uart_txq_start(UART, txq, 0);
+            cb_uart_txq_fill(txq, 1);
+        }
+    }
+    else if (txq->slotLength[txq->activeSlot ^ 1] == 0)
+    {
+        cb_uart_txq_fill(txq, txq->activeSlot ^ 1);
+    }
+    if (txq->busy)
+    {
+        UART->INT_EN |= EN_UART_INT_TXB_EMPTY;
+    }
+    return CB_PASS;
+}
+
+/**
+ * @brief Get the number of free frame slots of the UART TX queue.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return Number of frames that can still be queued.
+ */
+uint8_t cb_uart_txq_free_slots(enUartChannel uartChannel)
+{
+    stUartTxQueue *txq = cb_uart_get_txq(uartChannel);
+
+    if ((txq == NULL) || (txq->buffer == NULL))
+    {
+        return 0;
+    }
+    return (uint8_t)(UART_TXQ_DEPTH - (uint8_t)(txq->tail - txq->head));
+}
+
+/**
+ * @brief Check if the UART TX queue is still transmitting.
+ *
+ * @param uartChannel The UART channel. Use EN_UART_0 or EN_UART_1.
+ * @return CB_TRUE if frames are pending or on the line, CB_FALSE otherwise.
+ */
+uint8_t cb_uart_txq_is_busy(enUartChannel uartChannel)
+{
+    stUartTxQueue *txq = cb_uart_get_txq(uartChannel);
+
+    if (txq == NULL)
+    {
+        return CB_FALSE;
+    }
+    return ((txq->busy) || (txq->tail != txq->head)) ? CB_TRUE : CB_FALSE;
+}
+
 /**
  * @brief Configure UART interrupts for a specified UART channel.
  *
@@ -574,6 +1170,8 @@ void cb_uart_clear_irq(enUartChannel uartChannel)
  */
 void cb_uart_0_irqhandler(void) 
 {
+    uint32_t event = UART0->EVENT;
+
     if ((UART0->EVENT & UART_EVENT_RXB_FULL_MSK) == UART_EVENT_RXB_FULL && (UART0->INT_EN & EN_UART_INT_RXB_FULL)) 
     {
         cb_uart_0_rxb_full_irq_callback();
@@ -585,7 +1183,10 @@ void cb_uart_0_irqhandler(void)
     }
 
     UART0->INT_CLR  = UART_INT_CLR_INT_CLEAR;
-    UART0->RXCTRL   = UART_RXCTRL_START;
+    if ((stUartRingBufState[0].size == 0) && ((event & UART_RX_RESTART_EVENTS) != 0))
+    {
+        UART0->RXCTRL   = UART_RXCTRL_START;  // RX events only: a TX queue IRQ must not reset a reception, circular RX keeps running
+    }
 }
 
 /**
@@ -594,6 +1195,8 @@ void cb_uart_0_irqhandler(void)
  */
 void cb_uart_1_irqhandler(void) 
 {
+    uint32_t event = UART1->EVENT;
+
     if ((UART1->EVENT & UART_EVENT_RXB_FULL_MSK) == UART_EVENT_RXB_FULL && (UART1->INT_EN & EN_UART_INT_RXB_FULL)) 
     {
         cb_uart_1_rxb_full_irq_callback();
@@ -605,7 +1208,10 @@ void cb_uart_1_irqhandler(void)
     }
 
     UART1->INT_CLR  = UART_INT_CLR_INT_CLEAR;
-    UART1->RXCTRL   = UART_RXCTRL_START;
+    if ((stUartRingBufState[1].size == 0) && ((event & UART_RX_RESTART_EVENTS) != 0))
+    {
+        UART1->RXCTRL   = UART_RXCTRL_START;  // RX events only: a TX queue IRQ must not reset a reception, circular RX keeps running
+    }
 }
 
 /**
@@ -627,6 +1233,7 @@ __WEAK void cb_uart_0_rxb_full_app_irq_callback(void)
  */
 void cb_uart_0_txb_empty_irq_callback(void)
 {
+    cb_uart_txq_irq_service(EN_UART_0);
     cb_uart_0_txb_empty_app_irq_callback();
 }
 
@@ -653,6 +1260,7 @@ __WEAK void cb_uart_1_rxb_full_app_irq_callback(void)
  */
 void cb_uart_1_txb_empty_irq_callback(void)
 {
+    cb_uart_txq_irq_service(EN_UART_1);
     cb_uart_1_txb_empty_app_irq_callback();
 }
 
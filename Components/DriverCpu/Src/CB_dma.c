@@ -745,6 +745,16 @@ void cb_dma_clear_dest_request(stDMAConfig *DMAConfig)
     pDMA->dma_req_reg &= ~temp;
 }
 
+/**
+ * @brief Checks if the DMA module is enabled.
+ * @details Lets a user of one channel skip cb_dma_init(), which clears the requests of every channel.
+ * @return Returns CB_TRUE if the DMA module is enabled, otherwise returns CB_FALSE.
+ */
+uint8_t cb_dma_is_enabled(void)
+{
+    return ((pDMA->dma_en & DMA_ENABLE) == DMA_ENABLE) ? CB_TRUE : CB_FALSE;
+}
+
 /**
  * @brief Checks if a specified DMA channel is idle.
  * @details This function checks if a specified DMA channel is idle by examining the channel idle status register.
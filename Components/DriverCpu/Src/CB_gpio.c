@@ -35,6 +35,7 @@
 //-------------------------------
 static stGPIO_TypeDef  *pGPIO  = (stGPIO_TypeDef* ) GPIO_BASE_ADDR;
 extern stIOMUX_TypeDef  *pIOMUX;
+static uint32_t         s_gpioIrqTrigStatus;   /* Pins of the interrupt being handled */
 
 //-------------------------------
 // FUNCTION PROTOTYPE SECTION
@@ -383,10 +384,23 @@ void cb_gpio_irqhandler(void)
     uint32_t TrigStatus;
     TrigStatus = cb_gpio_trigger_status();
     cb_gpio_clear_trigger(TrigStatus);
+    s_gpioIrqTrigStatus = TrigStatus;
 
     cb_gpio_irq_callback();
 }
 
+/**
+ * @brief   Check whether a pin triggered the GPIO interrupt being handled.
+ * @details The trigger status is cleared before the callback runs; this returns the
+ *          status read by cb_gpio_irqhandler(), for use in cb_gpio_app_irq_callback().
+ * @param   GPIO_Pin The pin to check.
+ * @return  1 if the pin triggered the interrupt, 0 otherwise.
+ */
+uint8_t cb_gpio_is_irq_triggered(enGpioPin GPIO_Pin)
+{
+    return ((s_gpioIrqTrigStatus & cb_gpio_pin_select_mapping(GPIO_Pin)) != DRIVER_CLR) ? 1 : 0;
+}
+
 /**
  * @brief   Weakly defined GPIO interrupt callback function.
  * @details This function is intended to be overridden by the user to handle
@@ -1056,6 +1056,14 @@ enTransmissonMode cb_spi_get_current_transmission_mode(void)
     return UW1000_SPIMode;
 }
 
+/**
+ * @brief Retrieves the number of bytes received by the current SDMA transfer.
+ */
+uint16_t cb_spi_get_sdma_rx_count(void)
+{
+    return (uint16_t)((pSPI->SPI_TRX_ST & SPI_rxb_nbyte_Msk) >> SPI_rxb_nbyte_Pos);
+}
+
 /**
  * @brief Configures the SPI interrupts.
  *
@@ -155,7 +155,7 @@ void cb_uwb_tx_sfd_mark_irqcb(void);
  * a packet reception. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx0_done_irqhandler(void)          
+CB_RAM_CODE void cb_uwb_rx0_done_irqhandler(void)          
 {  
   //-----------------------
   // Disable RX EVENT IRQ - RX0 done
@@ -174,7 +174,7 @@ void cb_uwb_rx0_done_irqhandler(void)
  * a packet preamble. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx0_preamble_detected_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx0_preamble_detected_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX0 PD done
@@ -193,7 +193,7 @@ void cb_uwb_rx0_preamble_detected_irqhandler(void)
  * a start frame delimiter (SFD). It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx0_sfd_detected_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx0_sfd_detected_irqhandler(void)
 { 
   //-----------------------
   // Disable RX EVENT IRQ - RX0 SFD Detection Done
@@ -212,7 +212,7 @@ void cb_uwb_rx0_sfd_detected_irqhandler(void)
  * a packet reception. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx1_done_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx1_done_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX1 done
@@ -231,7 +231,7 @@ void cb_uwb_rx1_done_irqhandler(void)
  * a packet preamble. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx1_preamble_detected_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx1_preamble_detected_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX1 PD done
@@ -250,7 +250,7 @@ void cb_uwb_rx1_preamble_detected_irqhandler(void)
  * a start frame delimiter (SFD). It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx1_sfd_detected_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx1_sfd_detected_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX1 SFD Detection Done
@@ -269,7 +269,7 @@ void cb_uwb_rx1_sfd_detected_irqhandler(void)
  * a packet reception. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx2_done_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx2_done_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX2 done
@@ -288,7 +288,7 @@ void cb_uwb_rx2_done_irqhandler(void)
  * a packet preamble. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx2_preamble_detected_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx2_preamble_detected_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX2 PD done
@@ -307,7 +307,7 @@ void cb_uwb_rx2_preamble_detected_irqhandler(void)
  * a start frame delimiter (SFD). It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx2_sfd_detected_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx2_sfd_detected_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX2 SFD Detection Done
@@ -326,7 +326,7 @@ void cb_uwb_rx2_sfd_detected_irqhandler(void)
  * the STS (Scrambled Timestamp Sequence) CIR (Channel Impulse Response).
  * It disables the corresponding event and CPU IRQs, then calls the application callback.
  */
-void cb_uwb_rx_sts_cir_end_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx_sts_cir_end_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX STS CIR End
@@ -345,7 +345,7 @@ void cb_uwb_rx_sts_cir_end_irqhandler(void)
  * (PHY Header). It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx_phr_detected_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx_phr_detected_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX PHR Detected
@@ -364,7 +364,7 @@ void cb_uwb_rx_phr_detected_irqhandler(void)
  * a packet reception across all ports. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_rx_done_irqhandler(void)
+CB_RAM_CODE void cb_uwb_rx_done_irqhandler(void)
 {
   //-----------------------
   // Disable RX EVENT IRQ - RX Done
@@ -383,7 +383,7 @@ void cb_uwb_rx_done_irqhandler(void)
  * sending a packet. It disables the corresponding event and CPU IRQs,
  * then calls the application callback.
  */
-void cb_uwb_tx_done_irqhandler(void)
+CB_RAM_CODE void cb_uwb_tx_done_irqhandler(void)
 {  
   //-----------------------
   // Disable TX EVENT IRQ - TX Done
@@ -402,7 +402,7 @@ void cb_uwb_tx_done_irqhandler(void)
  * (Start Frame Delimiter) portion of a packet. It disables the corresponding event
  * and CPU IRQs, then calls the application callback.
  */
-void cb_uwb_tx_sfd_mark_irqhandler(void)
+CB_RAM_CODE void cb_uwb_tx_sfd_mark_irqhandler(void)
 {
   //-----------------------
   // Disable TX EVENT IRQ - TX SRD Mark
@@ -419,7 +419,7 @@ void cb_uwb_tx_sfd_mark_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx0_done_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx0_done_irqcb(void)
 {
   cb_uwbapp_rx0_done_irqcb();
 }
@@ -439,7 +439,7 @@ __WEAK void cb_uwbapp_rx0_done_irqcb(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx0_preamble_detected_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx0_preamble_detected_irqcb(void)
 {
   cb_uwbapp_rx0_preamble_detected_irqcb();
 }
@@ -459,7 +459,7 @@ __WEAK void cb_uwbapp_rx0_preamble_detected_irqcb(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx0_sfd_detected_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx0_sfd_detected_irqcb(void)
 {
   cb_uwbapp_rx0_sfd_detected_irqcb();
 }
@@ -479,7 +479,7 @@ __WEAK void cb_uwbapp_rx0_sfd_detected_irqcb(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx1_done_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx1_done_irqcb(void)
 {
   cb_uwbapp_rx1_done_irqhandler();
 }
@@ -499,7 +499,7 @@ __WEAK void cb_uwbapp_rx1_done_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx1_preamble_detected_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx1_preamble_detected_irqcb(void)
 {
   cb_uwbapp_rx1_preamble_detected_irqhandler();
 }
@@ -519,7 +519,7 @@ __WEAK void cb_uwbapp_rx1_preamble_detected_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx1_sfd_detected_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx1_sfd_detected_irqcb(void)
 {
   cb_uwbapp_rx1_sfd_detected_irqcb();
 }
@@ -539,7 +539,7 @@ __WEAK void cb_uwbapp_rx1_sfd_detected_irqcb(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx2_done_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx2_done_irqcb(void)
 {
   cb_uwbapp_rx2_done_irqcb();
 }
@@ -559,7 +559,7 @@ __WEAK void cb_uwbapp_rx2_done_irqcb(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx2_preamble_detected_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx2_preamble_detected_irqcb(void)
 {
   cb_uwbapp_rx2_preamble_detected_irqhandler();
 }
@@ -579,7 +579,7 @@ __WEAK void cb_uwbapp_rx2_preamble_detected_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx2_sfd_detected_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx2_sfd_detected_irqcb(void)
 {
   cb_uwbapp_rx2_sfd_detected_irqcb();
 }
@@ -599,7 +599,7 @@ __WEAK void cb_uwbapp_rx2_sfd_detected_irqcb(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx_sts_cir_end_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx_sts_cir_end_irqcb(void)
 {
   cb_uwbapp_rx_sts_cir_end_irqhandler();
 }
@@ -619,7 +619,7 @@ __WEAK void cb_uwbapp_rx_sts_cir_end_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx_phr_detected_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx_phr_detected_irqcb(void)
 {
   cb_uwbapp_rx_phr_detected_irqhandler();
 }
@@ -639,7 +639,7 @@ __WEAK void cb_uwbapp_rx_phr_detected_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_rx_done_irqcb(void)
+CB_RAM_CODE void cb_uwb_rx_done_irqcb(void)
 {
   cb_uwbapp_rx_done_irqhandler();
 }
@@ -659,7 +659,7 @@ __WEAK void cb_uwbapp_rx_done_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_tx_done_irqcb(void)
+CB_RAM_CODE void cb_uwb_tx_done_irqcb(void)
 {
   cb_uwbapp_tx_done_irqhandler();
 }
@@ -679,7 +679,7 @@ __WEAK void cb_uwbapp_tx_done_irqhandler(void)
  *
  * Called by the IRQ handler to invoke the application-specific callback.
  */
-void cb_uwb_tx_sfd_mark_irqcb(void)
+CB_RAM_CODE void cb_uwb_tx_sfd_mark_irqcb(void)
 {
   cb_uwbapp_tx_sfd_mark_irqhandler();
 }
@@ -0,0 +1,160 @@
+/**
+ * @file    dfu_abboot.c
+ * @brief   Dual-bank (A/B) boot: bank selection with trial boot, confirmation and rollback.
+ * @details Boot setting state machine, without flash access. See dfu_abboot.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "dfu_abboot.h"
+
+#if defined DFU_AB_BOOT
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_ABBOOT_MCU_OFFSET   0x1000      // FLASH_ADDR to MCU_ADDR
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static uint32_t dfu_abboot_is_bank(uint32_t address);
+static void     dfu_abboot_drop_trial(bootsetting_info_t *p_info);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint32_t dfu_abboot_is_bank(uint32_t address)
+{
+    return ((address == DFU_BANK_A_ADDRESS) || (address == DFU_BANK_B_ADDRESS)) ? APP_TRUE : APP_FALSE;
+}
+
+static void dfu_abboot_drop_trial(bootsetting_info_t *p_info)
+{
+    p_info->backup_bank.fw_active = APP_FALSE;
+    p_info->trial_state = DFU_TRIAL_NONE;
+}
+
+/**
+ * @brief Check if the backup bank holds an image staged for the copy of the legacy layout.
+ */
+uint32_t dfu_abboot_is_legacy(const bootsetting_info_t *p_info)
+{
+    return ((p_info->backup_bank.fw_active == APP_TRUE) &&
+            (p_info->backup_bank.fw_start_addr != p_info->backup_bank.fw_load_addr)) ? APP_TRUE : APP_FALSE;
+}
+
+/**
+ * @brief Select the bank to boot.
+ */
+uint32_t dfu_abboot_select(bootsetting_info_t *p_info, dfu_abboot_check_t check, uint32_t *p_changed)
+{
+    bank_info_t *p_app = &p_info->app_bank;
+    bank_info_t *p_new = &p_info->backup_bank;
+
+    *p_changed = APP_FALSE;
+    if (p_info->trial_state == DFU_TRIAL_PENDING)
+    {
+        if ((p_new->fw_active == APP_TRUE) && (dfu_abboot_is_bank(p_new->fw_start_addr) == APP_TRUE) &&
+            (p_new->fw_size != 0) && (check(p_new) == APP_TRUE))
+        {
+            // Recorded before the jump: a reset from the new image rolls back
+            p_info->trial_state = DFU_TRIAL_TESTING;
+            *p_changed = APP_TRUE;
+            return p_new->fw_start_addr;
+        }
+        dfu_abboot_drop_trial(p_info);
+        *p_changed = APP_TRUE;
+    }
+    else if (p_info->trial_state == DFU_TRIAL_TESTING)
+    {
+        // The new image did not confirm itself
+        dfu_abboot_drop_trial(p_info);
+        *p_changed = APP_TRUE;
+    }
+
+    if ((dfu_abboot_is_bank(p_app->fw_start_addr) == APP_TRUE) && (p_app->fw_size != 0) && (check(p_app) == APP_TRUE))
+    {
+        return p_app->fw_start_addr;
+    }
+
+    // Confirmed image damaged: boot the image of the other bank, if intact
+    if ((dfu_abboot_is_bank(p_new->fw_start_addr) == APP_TRUE) && (p_new->fw_start_addr == p_new->fw_load_addr) &&
+        (p_new->fw_start_addr != p_app->fw_start_addr) && (p_new->fw_size != 0) && (check(p_new) == APP_TRUE))
+    {
+        bank_info_t damaged = *p_app;
+        *p_app = *p_new;
+        p_app->fw_active = APP_TRUE;
+        *p_new = damaged;
+        dfu_abboot_drop_trial(p_info);
+        *p_changed = APP_TRUE;
+        return p_app->fw_start_addr;
+    }
+    return 0;
+}
+
+/**
+ * @brief Bank that receives an update.
+ */
+uint32_t dfu_abboot_target(const bootsetting_info_t *p_info, uint32_t running_addr)
+{
+    // Never the running image, never the confirmed one
+    if ((DFU_BANK_B_ADDRESS != running_addr) && (DFU_BANK_B_ADDRESS != p_info->app_bank.fw_start_addr))
+    {
+        return DFU_BANK_B_ADDRESS;
+    }
+    if ((DFU_BANK_A_ADDRESS != running_addr) && (DFU_BANK_A_ADDRESS != p_info->app_bank.fw_start_addr))
+    {
+        return DFU_BANK_A_ADDRESS;
+    }
+    return 0;
+}
+
+/**
+ * @brief Check that an image is built for a bank, from its reset vector.
+ */
+uint32_t dfu_abboot_image_fits(uint32_t bank, const uint8_t *vectors)
+{
+    uint32_t reset_handler = (uint32_t)(vectors[4] | (vectors[5] << 8) | (vectors[6] << 16) | ((uint32_t)vectors[7] << 24));
+    uint32_t base = bank - DFU_ABBOOT_MCU_OFFSET;
+
+    return ((reset_handler >= base) && (reset_handler < (base + DFU_BANK_SIZE))) ? APP_TRUE : APP_FALSE;
+}
+
+/**
+ * @brief Record a verified image as the next trial.
+ */
+void dfu_abboot_stage(bootsetting_info_t *p_info, uint32_t bank, uint32_t version, uint32_t size, uint32_t crc)
+{
+    p_info->backup_bank.fw_start_addr = bank;
+    p_info->backup_bank.fw_load_addr  = bank;
+    p_info->backup_bank.fw_size       = size;
+    p_info->backup_bank.fw_crc        = crc;
+    p_info->backup_bank.fw_verson     = version;
+    p_info->backup_bank.fw_active     = APP_TRUE;
+    p_info->trial_state = DFU_TRIAL_PENDING;
+}
+
+/**
+ * @brief Confirm the running trial image.
+ */
+uint32_t dfu_abboot_confirm(bootsetting_info_t *p_info, uint32_t running_addr)
+{
+    if ((p_info->trial_state != DFU_TRIAL_TESTING) || (p_info->backup_bank.fw_start_addr != running_addr))
+    {
+        return APP_FALSE;
+    }
+
+    bank_info_t previous = p_info->app_bank;
+    p_info->app_bank = p_info->backup_bank;
+    // Keep the previous image for the fallback; an image copied by the legacy flow runs where it is
+    p_info->backup_bank = previous;
+    p_info->backup_bank.fw_load_addr = previous.fw_start_addr;
+    p_info->backup_bank.fw_active = APP_FALSE;
+    p_info->trial_state = DFU_TRIAL_NONE;
+    return APP_TRUE;
+}
+
+#endif /* DFU_AB_BOOT */
@@ -0,0 +1,114 @@
+/**
+ * @file    dfu_abboot.h
+ * @brief   Dual-bank (A/B) boot: bank selection with trial boot, confirmation and rollback.
+ * @details With DFU_AB_BOOT the application is built for one of two banks (DFU_IMAGE_BANK_B selects
+ *          bank B in the sources and in the scatter file) and runs from where it is stored: an update
+ *          is written to the bank the running image does not use and nothing is copied at boot.
+ *          Banks are described in bootsetting_info_t:
+ *          - app_bank:    the confirmed image, booted by default.
+ *          - backup_bank: the other bank, fw_start_addr == fw_load_addr. fw_active marks a new image
+ *                         to try; otherwise it describes the previous image, kept for rollback.
+ *          trial_state follows a new image:
+ *          - DFU_TRIAL_PENDING: set when the image is verified. The next boot marks the trial
+ *                               DFU_TRIAL_TESTING, then jumps into the new bank.
+ *          - DFU_TRIAL_TESTING: the new image is running. dfu_boot_confirm() from the new image swaps
+ *                               app_bank and backup_bank. A reset before the confirmation boots
+ *                               app_bank again and drops the new image (rollback).
+ *          A backup_bank with fw_start_addr != fw_load_addr is an image staged by an application
+ *          without DFU_AB_BOOT; it is copied by the bootloader as before (dfu_bankcopy.h).
+ *          The functions only change the boot setting in RAM, the caller writes it.
+ *          Not defined in dfu_app and dfu_bootloader: the SDK has no bank-B target of the application
+ *          nor host tool that sends the image built for the bank of the start response. A product
+ *          enables it in both projects once it builds and ships both images.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __DFU_ABBOOT_H
+#define __DFU_ABBOOT_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "dfu_handler.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_BANK_A_ADDRESS      0x05000     /**< Flash address of bank A, MCU address 0x04000 */
+#define DFU_BANK_B_ADDRESS      0x3F000     /**< Flash address of bank B, MCU address 0x3E000 */
+#define DFU_BANK_SIZE           0x3A000
+
+#define DFU_TRIAL_NONE          0
+#define DFU_TRIAL_PENDING       1
+#define DFU_TRIAL_TESTING       2
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Image check, APP_TRUE if the bank holds the image it describes.
+ */
+typedef uint32_t (*dfu_abboot_check_t)(const bank_info_t *p_bank);
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Check if the backup bank holds an image staged for the copy of the legacy layout.
+ *
+ * @param p_info Boot setting.
+ * @return APP_TRUE for a legacy copy, left to the copy flow.
+ */
+uint32_t dfu_abboot_is_legacy(const bootsetting_info_t *p_info);
+
+/**
+ * @brief Select the bank to boot.
+ *
+ * @param p_info    Boot setting, updated.
+ * @param check     Image check.
+ * @param p_changed Set to APP_TRUE if the boot setting must be written before the jump.
+ * @return Flash address of the bank to jump to, 0 to stay in the bootloader.
+ */
+uint32_t dfu_abboot_select(bootsetting_info_t *p_info, dfu_abboot_check_t check, uint32_t *p_changed);
+
+/**
+ * @brief Bank that receives an update.
+ *
+ * @param p_info      Boot setting.
+ * @param running_addr Flash address of the running image, 0 in the bootloader.
+ * @return Flash address of the bank, 0 while the running image is an unconfirmed trial.
+ */
+uint32_t dfu_abboot_target(const bootsetting_info_t *p_info, uint32_t running_addr);
+
+/**
+ * @brief Check that an image is built for a bank, from its reset vector.
+ *
+ * @param bank    Flash address of the bank.
+ * @param vectors First 8 bytes of the image.
+ * @return APP_TRUE if the reset handler is in the bank.
+ */
+uint32_t dfu_abboot_image_fits(uint32_t bank, const uint8_t *vectors);
+
+/**
+ * @brief Record a verified image as the next trial.
+ *
+ * @param p_info  Boot setting, updated.
+ * @param bank    Flash address of the bank holding the image.
+ * @param version Firmware version.
+ * @param size    Image size.
+ * @param crc     Image CRC.
+ */
+void dfu_abboot_stage(bootsetting_info_t *p_info, uint32_t bank, uint32_t version, uint32_t size, uint32_t crc);
+
+/**
+ * @brief Confirm the running trial image.
+ *
+ * @param p_info       Boot setting, updated.
+ * @param running_addr Flash address of the running image.
+ * @return APP_TRUE if the boot setting changed and must be written.
+ */
+uint32_t dfu_abboot_confirm(bootsetting_info_t *p_info, uint32_t running_addr);
+
+#endif /*__DFU_ABBOOT_H*/
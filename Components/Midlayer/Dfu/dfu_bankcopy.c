@@ -0,0 +1,212 @@
+/**
+ * @file    dfu_bankcopy.c
+ * @brief   Power-fail-safe, resumable copy of the backup bank to the application bank.
+ * @details Sector copy with verification and append-only progress journal. See dfu_bankcopy.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "dfu_bankcopy.h"
+#include "dfu_handler.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_BANKCOPY_MAGIC          0x4A434B42  // "BKCJ"
+#define DFU_BANKCOPY_ENTRY_OFFSET   32          // Entries after the header
+#define DFU_BANKCOPY_ENTRY(sector)  (0xC3A50000UL | (sector))
+#define DFU_BANKCOPY_ERASED         0xFFFFFFFFUL
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Journal header, written once when the copy starts.
+ */
+typedef struct {
+    uint32_t           magic;
+    dfu_bankcopy_job_t job;
+    uint32_t           hdr_crc;   /**< CRC of the fields above */
+} dfu_bankcopy_header_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static uint32_t dfu_bankcopy_scan(const dfu_bankcopy_job_t *job, uint32_t *done, uint32_t *slot);
+static uint32_t dfu_bankcopy_sector(const dfu_bankcopy_job_t *job, uint32_t sector);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Read the journal of a job.
+ *
+ * Entries are appended in sector order. An entry that is not the expected one (programming
+ * interrupted by a reset) is skipped: its sector is copied again and recorded in the next slot.
+ *
+ * @param job  Copy job.
+ * @param done Sectors completed.
+ * @param slot Address of the first free entry.
+ * @return APP_TRUE if the journal belongs to the job.
+ */
+static uint32_t dfu_bankcopy_scan(const dfu_bankcopy_job_t *job, uint32_t *done, uint32_t *slot)
+{
+    uint32_t page[DFU_BANKCOPY_PAGE_SIZE / 4];
+    dfu_bankcopy_header_t header;
+
+    *done = 0;
+    *slot = DFU_BANKCOPY_JOURNAL_ADDR + DFU_BANKCOPY_ENTRY_OFFSET;
+
+    dfu_flash_read_port(DFU_BANKCOPY_JOURNAL_ADDR, (uint8_t *)page, DFU_BANKCOPY_PAGE_SIZE);
+    memcpy(&header, page, sizeof(header));
+    if ((header.magic != DFU_BANKCOPY_MAGIC) ||
+        (header.hdr_crc != dfu_crc_check_port((uint8_t *)&header, sizeof(header) - 4, 0)) ||
+        (memcmp(&header.job, job, sizeof(dfu_bankcopy_job_t)) != 0))
+    {
+        return APP_FALSE;
+    }
+
+    for (uint32_t addr = DFU_BANKCOPY_JOURNAL_ADDR; addr < (DFU_BANKCOPY_JOURNAL_ADDR + DFU_BANKCOPY_SECTOR_SIZE); addr += DFU_BANKCOPY_PAGE_SIZE)
+    {
+        if (addr != DFU_BANKCOPY_JOURNAL_ADDR)
+        {
+            dfu_flash_read_port(addr, (uint8_t *)page, DFU_BANKCOPY_PAGE_SIZE);
+        }
+        for (uint32_t i = 0; i < (DFU_BANKCOPY_PAGE_SIZE / 4); i++)
+        {
+            uint32_t entry_addr = addr + (i * 4);
+            if (entry_addr < *slot)
+            {
+                continue; // Header
+            }
+            if (page[i] == DFU_BANKCOPY_ERASED)
+            {
+                return APP_TRUE;
+            }
+            if (page[i] == DFU_BANKCOPY_ENTRY(*done))
+            {
+                (*done)++;
+            }
+            *slot = entry_addr + 4;
+        }
+    }
+    return APP_TRUE;
+}
+
+/**
+ * @brief Erase, copy and verify one destination sector.
+ *
+ * @param job    Copy job.
+ * @param sector Sector index in the job.
+ * @return APP_TRUE if the destination matches the source.
+ */
+static uint32_t dfu_bankcopy_sector(const dfu_bankcopy_job_t *job, uint32_t sector)
+{
+    uint8_t  readbuf[DFU_BANKCOPY_PAGE_SIZE];
+    uint32_t offset = sector * DFU_BANKCOPY_SECTOR_SIZE;
+    uint32_t len    = job->size - offset;
+    uint32_t crc    = 0;
+
+    if (len > DFU_BANKCOPY_SECTOR_SIZE)
+    {
+        len = DFU_BANKCOPY_SECTOR_SIZE;
+    }
+    // Size 1: only the sector holding the address
+    if (dfu_flash_erase_port(job->dst + offset, 1) != 0)
+    {
+        return APP_FALSE;
+    }
+    for (uint32_t done = 0; done < len; done += DFU_BANKCOPY_PAGE_SIZE)
+    {
+        uint32_t read_size = len - done;
+        if (read_size > DFU_BANKCOPY_PAGE_SIZE)
+        {
+            read_size = DFU_BANKCOPY_PAGE_SIZE;
+        }
+        dfu_flash_read_port(job->src + offset + done, readbuf, read_size);
+        crc = dfu_crc_check_port(readbuf, read_size, crc);
+        if (dfu_flash_write_port(job->dst + offset + done, readbuf, read_size) != 0)
+        {
+            return APP_FALSE;
+        }
+    }
+    return (dfu_firmware_crc_check(job->dst + offset, len) == crc) ? APP_TRUE : APP_FALSE;
+}
+
+/**
+ * @brief Number of sectors already copied for a job.
+ */
+uint32_t dfu_bankcopy_progress(const dfu_bankcopy_job_t *job)
+{
+    uint32_t done;
+    uint32_t slot;
+    return (dfu_bankcopy_scan(job, &done, &slot) == APP_TRUE) ? done : 0;
+}
+
+/**
+ * @brief Copy, or resume the copy of, a job.
+ */
+uint32_t dfu_bankcopy_run(const dfu_bankcopy_job_t *job)
+{
+    uint32_t sectors = (job->size + DFU_BANKCOPY_SECTOR_SIZE - 1) / DFU_BANKCOPY_SECTOR_SIZE;
+    uint32_t done;
+    uint32_t slot;
+
+    // An overlapping destination must start a sector before the source: erasing a destination
+    // sector then only destroys source data already copied
+    if ((job->size == 0) || ((job->dst % DFU_BANKCOPY_SECTOR_SIZE) != 0) || ((job->src % DFU_BANKCOPY_PAGE_SIZE) != 0) ||
+        ((job->dst < (job->src + job->size)) && (job->src < (job->dst + DFU_BANKCOPY_SECTOR_SIZE))))
+    {
+        return APP_FALSE;
+    }
+
+    if (dfu_bankcopy_scan(job, &done, &slot) != APP_TRUE)
+    {
+        // New copy: the source is checked once, the sectors are then verified one by one
+        if (dfu_firmware_crc_check(job->src, job->size) != job->crc)
+        {
+            return APP_FALSE;
+        }
+        dfu_bankcopy_header_t header;
+        header.magic   = DFU_BANKCOPY_MAGIC;
+        header.job     = *job;
+        header.hdr_crc = dfu_crc_check_port((uint8_t *)&header, sizeof(header) - 4, 0);
+        if ((dfu_flash_erase_port(DFU_BANKCOPY_JOURNAL_ADDR, 1) != 0) ||
+            (dfu_flash_write_port(DFU_BANKCOPY_JOURNAL_ADDR, (uint8_t *)&header, sizeof(header)) != 0))
+        {
+            return APP_FALSE;
+        }
+        done = 0;
+        slot = DFU_BANKCOPY_JOURNAL_ADDR + DFU_BANKCOPY_ENTRY_OFFSET;
+    }
+
+    for (uint32_t sector = done; sector < sectors; sector++)
+    {
+        uint32_t ok = APP_FALSE;
+        for (uint8_t retry = 0; (retry < DFU_BANKCOPY_SECTOR_RETRY) && (ok != APP_TRUE); retry++)
+        {
+            ok = dfu_bankcopy_sector(job, sector);
+        }
+        if ((ok != APP_TRUE) || (slot >= (DFU_BANKCOPY_JOURNAL_ADDR + DFU_BANKCOPY_SECTOR_SIZE)))
+        {
+            return APP_FALSE;
+        }
+
+        uint32_t entry = DFU_BANKCOPY_ENTRY(sector);
+        dfu_flash_write_port(slot, (uint8_t *)&entry, sizeof(entry));
+        slot += sizeof(entry);
+    }
+    return APP_TRUE;
+}
+
+/**
+ * @brief Erase the journal.
+ */
+void dfu_bankcopy_clear(void)
+{
+    dfu_flash_erase_port(DFU_BANKCOPY_JOURNAL_ADDR, 1);
+}
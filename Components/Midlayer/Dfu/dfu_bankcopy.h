@@ -0,0 +1,83 @@
+/**
+ * @file    dfu_bankcopy.h
+ * @brief   Power-fail-safe, resumable copy of the backup bank to the application bank.
+ * @details The copy runs sector by sector: each destination sector is erased, programmed from the
+ *          source and verified against the CRC of the source sector, then its completion is
+ *          appended to a journal in a dedicated flash sector (DFU_BANKCOPY_JOURNAL_ADDR).
+ *          The journal is append-only (one programmed word per sector, no erase), so it costs one
+ *          sector erase per copy. After a reset during the copy, the journal of the same job (source,
+ *          destination, size and CRC) is found and the copy resumes at the first sector without a
+ *          completion entry; the completed sectors are neither copied nor checked again.
+ *          The source is checked once, before the journal is started. An overlapping destination
+ *          must start at least one sector before the source, as the application bank before the
+ *          backup bank.
+ *          dfu_bootloader links it in its 16 KB: about 1.3 KB of Thumb code, estimated from a host
+ *          build (no armlink map), against 2.7 KB free in the baseline image.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __DFU_BANKCOPY_H
+#define __DFU_BANKCOPY_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DFU_BANKCOPY_JOURNAL_ADDR
+#define DFU_BANKCOPY_JOURNAL_ADDR   0x7C000   /**< Flash sector of the copy journal */
+#endif
+#ifndef DFU_BANKCOPY_SECTOR_RETRY
+#define DFU_BANKCOPY_SECTOR_RETRY   3         /**< Copies of a sector before giving up */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_BANKCOPY_SECTOR_SIZE    0x1000
+#define DFU_BANKCOPY_PAGE_SIZE      0x100
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Copy job, also the identity of its journal.
+ */
+typedef struct {
+    uint32_t src;     /**< Source address, page aligned */
+    uint32_t dst;     /**< Destination address, sector aligned */
+    uint32_t size;    /**< Bytes */
+    uint32_t crc;     /**< CRC of the source, as dfu_firmware_crc_check() */
+} dfu_bankcopy_job_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Check if an interrupted copy of this job is recorded in the journal.
+ *
+ * @param job Copy job.
+ * @return Number of sectors already copied and verified, 0 without journal for the job.
+ */
+uint32_t dfu_bankcopy_progress(const dfu_bankcopy_job_t *job);
+
+/**
+ * @brief Copy, or resume the copy of, a job.
+ *
+ * Without a journal for the job, the source CRC is checked and a new journal is started.
+ *
+ * @param job Copy job.
+ * @return APP_TRUE when all the sectors are copied and verified.
+ */
+uint32_t dfu_bankcopy_run(const dfu_bankcopy_job_t *job);
+
+/**
+ * @brief Erase the journal, after the boot setting records the copied image.
+ */
+void dfu_bankcopy_clear(void);
+
+#endif /*__DFU_BANKCOPY_H*/
@@ -0,0 +1,298 @@
+/**
+ * @file    dfu_delta.c
+ * @brief   Delta firmware update: streamed patch applied against the running image.
+ * @details Incremental patch parser; see dfu_delta.h for the format.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "dfu_delta.h"
+#include "dfu_handler.h"
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+enum {
+    DFU_DELTA_ST_HEADER = 0,
+    DFU_DELTA_ST_OP,
+    DFU_DELTA_ST_ARG0,
+    DFU_DELTA_ST_ARG1,
+    DFU_DELTA_ST_INSERT,
+    DFU_DELTA_ST_END,
+    DFU_DELTA_ST_ERROR,
+};
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static uint32_t dfu_delta_get32(const uint8_t *p);
+static uint32_t dfu_delta_flush(dfu_delta_t *ctx);
+static uint32_t dfu_delta_emit(dfu_delta_t *ctx, const uint8_t *data, uint32_t len);
+static uint32_t dfu_delta_copy(dfu_delta_t *ctx, uint32_t offset, uint32_t len);
+static uint32_t dfu_delta_header(dfu_delta_t *ctx);
+static uint32_t dfu_delta_varint(dfu_delta_t *ctx, uint32_t idx, uint8_t byte, uint32_t *p_done);
+static uint32_t dfu_delta_run_op(dfu_delta_t *ctx);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint32_t dfu_delta_get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t dfu_delta_flush(dfu_delta_t *ctx)
+{
+    if (ctx->out_used == 0)
+    {
+        return APP_TRUE;
+    }
+    if (ctx->write(ctx->out_offset, ctx->out, ctx->out_used) != 0)
+    {
+        return APP_FALSE;
+    }
+    ctx->out_offset += ctx->out_used;
+    ctx->out_used = 0;
+    return APP_TRUE;
+}
+
+/**
+ * @brief Append rebuilt image bytes, writing each full page.
+ */
+static uint32_t dfu_delta_emit(dfu_delta_t *ctx, const uint8_t *data, uint32_t len)
+{
+    if (len > (ctx->new_size - ctx->out_offset - ctx->out_used))
+    {
+        return APP_FALSE; // longer than announced
+    }
+    while (len > 0)
+    {
+        uint32_t chunk = DFU_DELTA_PAGE_SIZE - ctx->out_used;
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        memcpy(&ctx->out[ctx->out_used], data, chunk);
+        ctx->out_used += chunk;
+        data += chunk;
+        len -= chunk;
+        if ((ctx->out_used == DFU_DELTA_PAGE_SIZE) && (dfu_delta_flush(ctx) != APP_TRUE))
+        {
+            return APP_FALSE;
+        }
+    }
+    return APP_TRUE;
+}
+
+/**
+ * @brief Copy base bytes through the one page read window.
+ */
+static uint32_t dfu_delta_copy(dfu_delta_t *ctx, uint32_t offset, uint32_t len)
+{
+    if ((len == 0) || (len > DFU_DELTA_COPY_MAX) || (offset > ctx->base_size) || (len > (ctx->base_size - offset)))
+    {
+        return APP_FALSE;
+    }
+    // Base bytes in the bank being written are already erased or overwritten
+    if (((ctx->base_addr + offset) < (ctx->out_addr + ctx->out_size)) && (ctx->out_addr < (ctx->base_addr + offset + len)))
+    {
+        return APP_FALSE;
+    }
+    while (len > 0)
+    {
+        uint32_t addr = ctx->base_addr + offset;
+        uint32_t page = addr & ~(uint32_t)(DFU_DELTA_PAGE_SIZE - 1);
+        uint32_t chunk = DFU_DELTA_PAGE_SIZE - (addr - page);
+        if (ctx->window_addr != page)
+        {
+            if (dfu_flash_read_port(page, ctx->window, DFU_DELTA_PAGE_SIZE) != 0)
+            {
+                return APP_FALSE;
+            }
+            ctx->window_addr = page;
+        }
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        if (dfu_delta_emit(ctx, &ctx->window[addr - page], chunk) != APP_TRUE)
+        {
+            return APP_FALSE;
+        }
+        offset += chunk;
+        len -= chunk;
+    }
+    return APP_TRUE;
+}
+
+static uint32_t dfu_delta_header(dfu_delta_t *ctx)
+{
+    // The patch is only valid against the image it was made from
+    if ((dfu_delta_get32(&ctx->header[0]) != DFU_DELTA_MAGIC) ||
+        (dfu_delta_get32(&ctx->header[4]) != ctx->base_size) ||
+        (dfu_delta_get32(&ctx->header[8]) != ctx->base_crc))
+    {
+        return APP_FALSE;
+    }
+    ctx->new_size = dfu_delta_get32(&ctx->header[12]);
+    return APP_TRUE;
+}
+
+/**
+ * @brief Add one byte to a varint argument.
+ */
+static uint32_t dfu_delta_varint(dfu_delta_t *ctx, uint32_t idx, uint8_t byte, uint32_t *p_done)
+{
+    if (ctx->field > 28)
+    {
+        return APP_FALSE;
+    }
+    ctx->arg[idx] |= (uint32_t)(byte & 0x7F) << ctx->field;
+    ctx->field += 7;
+    *p_done = ((byte & 0x80) == 0) ? APP_TRUE : APP_FALSE;
+    if (*p_done == APP_TRUE)
+    {
+        ctx->field = 0;
+    }
+    return APP_TRUE;
+}
+
+/**
+ * @brief Run an operation once its arguments are complete.
+ */
+static uint32_t dfu_delta_run_op(dfu_delta_t *ctx)
+{
+    if (ctx->op == DFU_DELTA_OP_COPY)
+    {
+        ctx->state = DFU_DELTA_ST_OP;
+        return dfu_delta_copy(ctx, ctx->arg[0], ctx->arg[1]);
+    }
+    // INSERT, bytes follow
+    ctx->state = (ctx->arg[0] > 0) ? DFU_DELTA_ST_INSERT : DFU_DELTA_ST_OP;
+    return APP_TRUE;
+}
+
+/**
+ * @brief Start applying a patch.
+ */
+void dfu_delta_start(dfu_delta_t *ctx, uint32_t base_addr, uint32_t base_size, uint32_t base_crc,
+                     uint32_t out_addr, uint32_t out_size, dfu_delta_write_t write)
+{
+    memset(ctx, 0, sizeof(dfu_delta_t));
+    ctx->write       = write;
+    ctx->base_addr   = base_addr;
+    ctx->base_size   = base_size;
+    ctx->base_crc    = base_crc;
+    ctx->out_addr    = out_addr;
+    ctx->out_size    = out_size;
+    ctx->window_addr = 0xFFFFFFFF;
+    ctx->state       = DFU_DELTA_ST_HEADER;
+}
+
+/**
+ * @brief Apply the next patch bytes.
+ */
+uint32_t dfu_delta_feed(dfu_delta_t *ctx, const uint8_t *data, uint32_t len)
+{
+    uint32_t done;
+    uint32_t i = 0;
+
+    while ((i < len) && (ctx->state != DFU_DELTA_ST_ERROR))
+    {
+        uint32_t ok = APP_TRUE;
+        switch (ctx->state)
+        {
+        case DFU_DELTA_ST_HEADER:
+            ctx->header[ctx->field++] = data[i++];
+            if (ctx->field == DFU_DELTA_HEADER_SIZE)
+            {
+                ctx->field = 0;
+                ctx->state = DFU_DELTA_ST_OP;
+                ok = dfu_delta_header(ctx);
+            }
+            break;
+
+        case DFU_DELTA_ST_OP:
+            ctx->op = data[i++];
+            ctx->arg[0] = 0;
+            ctx->arg[1] = 0;
+            ctx->field = 0;
+            if (ctx->op == DFU_DELTA_OP_END)
+            {
+                ctx->state = DFU_DELTA_ST_END;
+                ok = dfu_delta_flush(ctx);
+            }
+            else if ((ctx->op == DFU_DELTA_OP_COPY) || (ctx->op == DFU_DELTA_OP_INSERT))
+            {
+                ctx->state = DFU_DELTA_ST_ARG0;
+            }
+            else
+            {
+                ok = APP_FALSE;
+            }
+            break;
+
+        case DFU_DELTA_ST_ARG0:
+            ok = dfu_delta_varint(ctx, 0, data[i++], &done);
+            if ((ok == APP_TRUE) && (done == APP_TRUE))
+            {
+                if (ctx->op == DFU_DELTA_OP_COPY)
+                {
+                    ctx->state = DFU_DELTA_ST_ARG1;
+                }
+                else
+                {
+                    ok = dfu_delta_run_op(ctx);
+                }
+            }
+            break;
+
+        case DFU_DELTA_ST_ARG1:
+            ok = dfu_delta_varint(ctx, 1, data[i++], &done);
+            if ((ok == APP_TRUE) && (done == APP_TRUE))
+            {
+                ok = dfu_delta_run_op(ctx);
+            }
+            break;
+
+        case DFU_DELTA_ST_INSERT:
+        {
+            uint32_t chunk = len - i;
+            if (chunk > ctx->arg[0])
+            {
+                chunk = ctx->arg[0];
+            }
+            ok = dfu_delta_emit(ctx, &data[i], chunk);
+            i += chunk;
+            ctx->arg[0] -= chunk;
+            if (ctx->arg[0] == 0)
+            {
+                ctx->state = DFU_DELTA_ST_OP;
+            }
+            break;
+        }
+
+        default:
+            ok = APP_FALSE; // data after END
+            break;
+        }
+        if (ok != APP_TRUE)
+        {
+            ctx->state = DFU_DELTA_ST_ERROR;
+        }
+    }
+    return (ctx->state == DFU_DELTA_ST_ERROR) ? APP_FALSE : APP_TRUE;
+}
+
+/**
+ * @brief Check that the whole patch was applied.
+ */
+uint32_t dfu_delta_finish(dfu_delta_t *ctx, uint32_t *p_size)
+{
+    *p_size = ctx->out_offset;
+    return ((ctx->state == DFU_DELTA_ST_END) && (ctx->out_offset == ctx->new_size)) ? APP_TRUE : APP_FALSE;
+}
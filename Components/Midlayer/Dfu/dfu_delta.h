@@ -0,0 +1,113 @@
+/**
+ * @file    dfu_delta.h
+ * @brief   Delta firmware update: streamed patch applied against the running image.
+ * @details A patch rebuilds the new image from the confirmed application bank (the base) and is
+ *          made by Tools/Dfu_Delta/dfu_delta.py. It is sent with the usual DFU packs in place of
+ *          the image; the rebuilt image is written to the update bank and verified with its CRC.
+ *          Format, little endian, varint = unsigned LEB128:
+ *          - header:  "DDF1", base size (4), base CRC (4), new size (4)
+ *          - 0x01 COPY:   varint base offset, varint length (1..DFU_DELTA_COPY_MAX)
+ *          - 0x02 INSERT: varint length, then the bytes
+ *          - 0x00 END
+ *          RAM is bounded to one flash page of the base (read window) and one page of output,
+ *          whatever the image or patch size. A COPY is limited so one pack never does more than
+ *          DFU_DELTA_COPY_MAX bytes of flash work.
+ *          Without DFU_AB_BOOT the backup bank, erased when the update starts, overlaps the end of
+ *          the application bank (flash 0x3E800..0x3F800): a COPY from base bytes in the bank being
+ *          written is refused, and the tool makes no such COPY.
+ *          Not defined in dfu_app: without DFU_DELTA_UPDATE a start command for a patch is refused
+ *          (status 0x05). A product adds it to the C defines once its host sends patches.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __DFU_DELTA_H
+#define __DFU_DELTA_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_DELTA_MAGIC         0x31464444  /**< "DDF1" */
+#define DFU_DELTA_HEADER_SIZE   16
+#define DFU_DELTA_PAGE_SIZE     0x100
+#define DFU_DELTA_COPY_MAX      0x1000
+
+#define DFU_DELTA_OP_END        0x00
+#define DFU_DELTA_OP_COPY       0x01
+#define DFU_DELTA_OP_INSERT     0x02
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Output of the rebuilt image, in order, page aligned chunks.
+ *
+ * @return 0 on success.
+ */
+typedef uint32_t (*dfu_delta_write_t)(uint32_t offset, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Patch applier state.
+ */
+typedef struct {
+    dfu_delta_write_t write;
+    uint32_t base_addr;
+    uint32_t base_size;
+    uint32_t base_crc;
+    uint32_t out_addr;                      /**< Flash range written, not a COPY source */
+    uint32_t out_size;
+    uint32_t new_size;
+    uint32_t state;
+    uint32_t op;
+    uint32_t field;                         /**< Header byte count or varint shift */
+    uint32_t arg[2];                        /**< Operation arguments */
+    uint32_t window_addr;                   /**< Base page in window */
+    uint32_t out_offset;                    /**< Image offset of out[0] */
+    uint32_t out_used;
+    uint8_t  header[DFU_DELTA_HEADER_SIZE];
+    uint8_t  window[DFU_DELTA_PAGE_SIZE];
+    uint8_t  out[DFU_DELTA_PAGE_SIZE];
+} dfu_delta_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Start applying a patch.
+ *
+ * @param ctx       Applier.
+ * @param base_addr Flash address of the base image, page aligned.
+ * @param base_size Base image size.
+ * @param base_crc  Base image CRC, checked against the patch header.
+ * @param out_addr  Flash address of the bank the image is written to.
+ * @param out_size  Size of that bank.
+ * @param write     Image output.
+ */
+void dfu_delta_start(dfu_delta_t *ctx, uint32_t base_addr, uint32_t base_size, uint32_t base_crc,
+                     uint32_t out_addr, uint32_t out_size, dfu_delta_write_t write);
+
+/**
+ * @brief Apply the next patch bytes.
+ *
+ * @param ctx  Applier.
+ * @param data Patch bytes.
+ * @param len  Length.
+ * @return APP_TRUE, APP_FALSE on a malformed patch, a patch for another base or a write error.
+ */
+uint32_t dfu_delta_feed(dfu_delta_t *ctx, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Check that the whole patch was applied.
+ *
+ * @param ctx    Applier.
+ * @param p_size Size of the rebuilt image.
+ * @return APP_TRUE if the patch ended and the image is complete.
+ */
+uint32_t dfu_delta_finish(dfu_delta_t *ctx, uint32_t *p_size);
+
+#endif /*__DFU_DELTA_H*/
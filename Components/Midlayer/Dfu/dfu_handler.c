@@ -20,6 +20,19 @@
 #include "CB_SleepDeepSleep.h"
 
 #include "dfu_handler.h"
+#include "dfu_bankcopy.h"
+#if defined DFU_SIGNED_IMAGE
+#include "dfu_sign.h"
+#endif
+#if defined DFU_AB_BOOT
+#include "dfu_abboot.h"
+#endif
+#if defined DFU_DELTA_UPDATE
+#include "dfu_delta.h"
+#endif
+#if defined DFU_LZ_IMAGE
+#include "dfu_lz.h"
+#endif
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
@@ -27,6 +40,8 @@
 #if defined BOOT
 #define BOOT_VERSION "\x00\x00\x00\x00" 
 const uint8_t FirmwareVersion[] = BOOT_VERSION;
+#elif defined DFU_IMAGE_BANK_B
+const uint8_t FirmwareVersion[] __attribute__((section(".ARM.__at_0x40000")))= FW_VERSION; // same offset in bank B
 #else
 const uint8_t FirmwareVersion[] __attribute__((section(".ARM.__at_0x6000")))= FW_VERSION;
 #endif
@@ -53,6 +68,11 @@ const uint8_t FirmwareVersion[] __attribute__((section(".ARM.__at_0x6000")))= FW
 #define FLASH_SECTOR_SIZE   0x1000
 #define FLASH_PAGE_SIZE     0x100
 
+//content of the packs, start command buf[2]
+#define DFU_PACK_IMAGE      0
+#define DFU_PACK_DELTA      1   //DFU_DELTA_UPDATE
+#define DFU_PACK_LZ         2   //DFU_LZ_IMAGE
+
 //#define FLASH_WRITE_BUFFER  //if need write in page
 
 #define BigLittleSwap16(A) ((((uint16_t)(A) & 0xff00) >> 8 ) |\
@@ -100,8 +120,15 @@ uint32_t dfu_bootsetting_read(bootsetting_info_t *p_info);
 uint32_t dfu_bootsetting_write(bootsetting_info_t *p_info);
 uint32_t dfu_bootsetting_update(uint32_t version, uint32_t size, uint32_t crc );
 uint32_t dfu_firmware_crc_check(uint32_t address, uint32_t size);
-void     boot_copy_firmware(uint32_t dest, uint32_t src, uint32_t size );
 uint32_t boot_move_backup_to_app(bootsetting_info_t *p_info);
+static void     boot_bank_copy_job(bank_info_t *p_bank, dfu_bankcopy_job_t *p_job);
+static uint32_t boot_backup_crc_check(bootsetting_info_t *p_info);
+#if defined DFU_AB_BOOT
+static uint32_t boot_bank_check(const bank_info_t *p_bank);
+static uint32_t dfu_running_bank(void);
+#endif
+static uint32_t dfu_image_write(uint32_t offset, const uint8_t *p_data, uint32_t size);
+static uint8_t  dfu_pack_mode_supported(uint8_t mode);
 //-------------------------------
 // GLOBAL VARIABLE SECTION
 //-------------------------------
@@ -109,6 +136,17 @@ static dfu_cfg_t g_dfu_cfg;
 static uint32_t dfu_addr_offset ;
 static uint32_t dfu_fw_ver =0;
 static uint8_t dfu_active_flag;
+static uint32_t dfu_bank_address = BACKUP_BANK_ADDRESS;
+#if defined DFU_AB_BOOT
+static uint32_t dfu_erased_size;
+#endif
+static uint8_t dfu_pack_mode;
+#if defined DFU_DELTA_UPDATE
+static dfu_delta_t dfu_delta;
+#endif
+#if defined DFU_LZ_IMAGE
+static dfu_lz_t dfu_lz;
+#endif
 
 #define CMD_READ_VER  0x0100 
 #define CMD_REST_DEV  0x0120 
@@ -280,7 +318,7 @@ uint32_t dfu_flash_write_buf_port(uint32_t offset, uint8_t *p_data, uint32_t pac
     pack_rec_idx += pack_size;
     if((pack_rec_idx >= FLASH_PAGE_SIZE) || ((pack_size == 0)&&(pack_rec_idx > 0)))
     {
-        FlashStatus = dfu_flash_write_page_port(BACKUP_BANK_ADDRESS+dfu_page_offset, &pack_rec_buf, FLASH_PAGE_SIZE); //write page
+        FlashStatus = dfu_flash_write_page_port(dfu_bank_address+dfu_page_offset, &pack_rec_buf, FLASH_PAGE_SIZE); //write page
         pack_rec_idx = 0;
         memset(pack_rec_buf,0,FLASH_PAGE_SIZE);    
     }
@@ -366,12 +404,17 @@ uint32_t dfu_bootsetting_update(uint32_t version, uint32_t size, uint32_t crc )
     bootsetting_info_t bootsetting;
     dfu_bootsetting_read(&bootsetting);
 
+    #if defined DFU_AB_BOOT
+    //the image runs from its bank, try it at the next boot
+    dfu_abboot_stage(&bootsetting, dfu_bank_address, version, size, crc);
+    #else
     bootsetting.backup_bank.fw_start_addr = APP_BANK_ADDRESS;
     bootsetting.backup_bank.fw_load_addr  = BACKUP_BANK_ADDRESS;
     bootsetting.backup_bank.fw_size       = size;
     bootsetting.backup_bank.fw_crc        = crc;
     bootsetting.backup_bank.fw_verson     = version;
     bootsetting.backup_bank.fw_active     = APP_TRUE;
+    #endif
 
     bootsetting.boot_mode = APP_FALSE;
     rt = dfu_bootsetting_write(&bootsetting);
@@ -539,11 +582,67 @@ void dfu_upgrade_start(uint16_t command, uint8_t *buf, uint8_t len)
     memcpy(&current_fw_ver,&FirmwareVersion,sizeof(current_fw_ver));
     //cmp fw version
     uint16_t new_fw_ver = (uint16_t)(buf[0]<<8|buf[1]);
-    if(new_fw_ver >= current_fw_ver) // debug
+    #if defined DFU_AB_BOOT || defined DFU_DELTA_UPDATE
+    bootsetting_info_t bootsetting;
+    dfu_bootsetting_read(&bootsetting);
+    #endif
+    //optional: buf[2] content of the packs, DFU_PACK_*
+    dfu_pack_mode = (len >= 3) ? buf[2] : DFU_PACK_IMAGE;
+    #if defined DFU_DELTA_UPDATE
+    //a patch is made against the image of CRC buf[3..6]
+    uint32_t base_crc = (len >= 7) ? (uint32_t)(buf[3]<<24|buf[4]<<16|buf[5]<<8|buf[6]) : 0;
+    #endif
+    #if defined DFU_AB_BOOT
+    dfu_bank_address = dfu_abboot_target(&bootsetting, dfu_running_bank());
+    if(dfu_bank_address == 0)
+    {
+        statuscode = 0x03; // running image not confirmed, no free bank
+    }
+    else
+    #endif
+    if(dfu_pack_mode_supported(dfu_pack_mode) != APP_TRUE)
+    {
+        statuscode = 0x05; // pack content not supported
+    }
+    #if defined DFU_DELTA_UPDATE
+    else if(dfu_pack_mode == DFU_PACK_DELTA && base_crc != bootsetting.app_bank.fw_crc)
+    {
+        statuscode = 0x04; // patch made for another image
+    }
+    #endif
+    else if(new_fw_ver >= current_fw_ver) // debug
     {
         dfu_active_flag = APP_TRUE;  
         dfu_addr_offset = 0;
         dfu_fw_ver = new_fw_ver;
+        #if defined DFU_AB_BOOT
+        dfu_erased_size = 0;
+        #endif
+        #if defined DFU_DELTA_UPDATE
+        if(dfu_pack_mode == DFU_PACK_DELTA)
+        {
+            #if defined DFU_AB_BOOT
+            dfu_delta_start(&dfu_delta, bootsetting.app_bank.fw_start_addr, bootsetting.app_bank.fw_size, base_crc,
+                            dfu_bank_address, DFU_BANK_SIZE, dfu_image_write);
+            #else
+            dfu_delta_start(&dfu_delta, bootsetting.app_bank.fw_start_addr, bootsetting.app_bank.fw_size, base_crc,
+                            dfu_bank_address, FIRMWARE_BANK_SIZE, dfu_image_write);
+            #endif
+        }
+        #endif
+        #if defined DFU_LZ_IMAGE
+        if(dfu_pack_mode == DFU_PACK_LZ)
+        {
+            #if defined DFU_AB_BOOT
+            dfu_lz_start(&dfu_lz, DFU_BANK_SIZE, dfu_image_write);
+            #else
+            dfu_lz_start(&dfu_lz, FIRMWARE_BANK_SIZE, dfu_image_write);
+            #endif
+        }
+        #endif
+        #if defined DFU_SIGNED_IMAGE
+        dfu_sign_start();
+        #endif
     }
     else if(new_fw_ver == current_fw_ver)
     {
@@ -553,8 +652,14 @@ void dfu_upgrade_start(uint16_t command, uint8_t *buf, uint8_t len)
         statuscode = 0x02; // lower version
     }
 
+    #if defined DFU_AB_BOOT
+    //status, then the bank the image must be built for: 0 bank A, 1 bank B
+    uint8_t respond[2] = {statuscode, (uint8_t)(dfu_bank_address == DFU_BANK_B_ADDRESS)};
+    dfu_command_respond_port(command,respond,sizeof(respond));
+    #else
     uint8_t respondLen = sizeof(statuscode);
     dfu_command_respond_port(command,&statuscode,respondLen);
+    #endif
 }
 
 
@@ -579,26 +684,52 @@ void dfu_upgrade_pack(uint16_t command, uint8_t *buf, uint8_t len)
     if(dfu_active_flag != APP_TRUE)
         return;
 
+    #if !defined DFU_AB_BOOT
     if(dfu_addr_offset == 0)
     {
         //erase backup bank
         dfu_flash_erase_port(BACKUP_BANK_ADDRESS, FIRMWARE_BANK_SIZE);
     }
+    #endif
 
     if(dfu_addr_offset != offser)
     {
         statuscode = 0x01; // offset err
     }
+    #if defined DFU_AB_BOOT
+    else if(pack_size > 0 && pack_size <= 128 && dfu_addr_offset + pack_size <= DFU_BANK_SIZE)
+    #else
     else if(pack_size > 0 && pack_size <= 128)
+    #endif
     {
         uint32_t crc_check = dfu_crc_check_port(p_data,pack_size,0);
         if(crc_check == pack_crc)
         {
-            #if defined FLASH_WRITE_BUFFER
-            dfu_flash_write_buf_port(dfu_addr_offset, p_data, (uint32_t)pack_size);
-            #else
-            dfu_flash_write_port(BACKUP_BANK_ADDRESS+dfu_addr_offset, p_data, (uint32_t)pack_size);
+            #if defined DFU_DELTA_UPDATE
+            if(dfu_pack_mode == DFU_PACK_DELTA)
+            {
+                //the pack is patch data, the image is rebuilt from the running one
+                if(dfu_delta_feed(&dfu_delta, p_data, pack_size) != APP_TRUE)
+                {
+                    statuscode = 0x04; //patch err, restart the update
+                }
+            }
+            else
+            #endif
+            #if defined DFU_LZ_IMAGE
+            if(dfu_pack_mode == DFU_PACK_LZ)
+            {
+                //the pack is compressed, decompressed into the update bank page by page
+                if(dfu_lz_feed(&dfu_lz, p_data, pack_size) != APP_TRUE)
+                {
+                    statuscode = 0x04; //stream err, restart the update
+                }
+            }
+            else
             #endif
+            {
+                dfu_image_write(dfu_addr_offset, p_data, pack_size);
+            }
             dfu_addr_offset += pack_size;
         }
         else{
@@ -612,6 +743,63 @@ void dfu_upgrade_pack(uint16_t command, uint8_t *buf, uint8_t len)
     dfu_command_respond_port(command,&statuscode,respondLen);
 }
 
+/**
+ * @brief Check if the build handles a content of the packs.
+ * 
+ * @param mode DFU_PACK_*.
+ * @return APP_TRUE if supported.
+ */
+static uint8_t dfu_pack_mode_supported(uint8_t mode)
+{
+    switch(mode)
+    {
+        case DFU_PACK_IMAGE:
+        #if defined DFU_DELTA_UPDATE
+        case DFU_PACK_DELTA:
+        #endif
+        #if defined DFU_LZ_IMAGE
+        case DFU_PACK_LZ:
+        #endif
+            return APP_TRUE;
+        default:
+            return APP_FALSE;
+    }
+}
+
+/**
+ * @brief Write image data to the update bank, from a pack, a patch or a compressed stream.
+ * 
+ * @param offset Image offset.
+ * @param p_data Data.
+ * @param size   Length.
+ * @return 0 on success.
+ */
+static uint32_t dfu_image_write(uint32_t offset, const uint8_t *p_data, uint32_t size)
+{
+    uint32_t rt;
+    #if defined DFU_AB_BOOT
+    if(offset + size > DFU_BANK_SIZE)
+    {
+        return EN_FLASH_INVALID_ADDRESS;
+    }
+    //erase the sectors the image reaches, not the whole bank
+    while(dfu_erased_size < offset + size)
+    {
+        dfu_flash_erase_port(dfu_bank_address + dfu_erased_size, 1);
+        dfu_erased_size += FLASH_SECTOR_SIZE;
+    }
+    #endif
+    #if defined FLASH_WRITE_BUFFER
+    rt = dfu_flash_write_buf_port(offset, (uint8_t*)p_data, size);
+    #else
+    rt = dfu_flash_write_port(dfu_bank_address+offset, (uint8_t*)p_data, size);
+    #endif
+    #if defined DFU_SIGNED_IMAGE
+    dfu_sign_update(p_data, size);
+    #endif
+    return rt;
+}
+
 /**
  * @brief 
  * 
@@ -627,21 +815,51 @@ void dfu_upgrade_verify(uint16_t command, uint8_t *buf, uint8_t len)
     uint32_t read_size = 0;
     uint32_t read_addr = 0;
     uint8_t readbuf[OTA_PACK_MAX];
+    uint32_t image_size = dfu_addr_offset;
 
+    #if defined DFU_DELTA_UPDATE
+    if(dfu_pack_mode == DFU_PACK_DELTA && dfu_delta_finish(&dfu_delta, &image_size) != APP_TRUE)
+    {
+        statuscode = 0x04; //patch incomplete
+    }
+    #endif
+    #if defined DFU_LZ_IMAGE
+    if(dfu_pack_mode == DFU_PACK_LZ && dfu_lz_finish(&dfu_lz, &image_size) != APP_TRUE)
+    {
+        statuscode = 0x04; //stream incomplete
+    }
+    #endif
     #if defined FLASH_WRITE_BUFFER
     //comfirm the last pack has been write
-    dfu_flash_write_buf_port(dfu_addr_offset, readbuf, 0);
+    dfu_flash_write_buf_port(image_size, readbuf, 0);
     #endif
 
-    uint32_t crc_check = dfu_firmware_crc_check(BACKUP_BANK_ADDRESS,dfu_addr_offset);
-    if(crc_check == fw_crc)
+    uint32_t crc_check = dfu_firmware_crc_check(dfu_bank_address,image_size);
+    if(statuscode != 0)
     {
-        //verify pass, update boot setting
-        dfu_bootsetting_update(dfu_fw_ver,dfu_addr_offset,fw_crc);
+        //patch err, boot setting not updated
     }
-    else{
+    else if(crc_check != fw_crc)
+    {
         statuscode = 0x01;
     }
+    #if defined DFU_AB_BOOT
+    else if(dfu_flash_read_port(dfu_bank_address, readbuf, 8) != 0 || dfu_abboot_image_fits(dfu_bank_address, readbuf) != APP_TRUE)
+    {
+        statuscode = 0x03; //image built for the other bank, boot setting not updated
+    }
+    #endif
+    #if defined DFU_SIGNED_IMAGE
+    else if(dfu_sign_finish() != APP_TRUE)
+    {
+        LOG("signature err, %d cycles\r\n", dfu_sign_get_verify_cycles());
+        statuscode = 0x02; //signature err, boot setting not updated
+    }
+    #endif
+    else{
+        //verify pass, update boot setting
+        dfu_bootsetting_update(dfu_fw_ver,image_size,fw_crc);
+    }
     uint8_t respondLen = sizeof(statuscode);
     dfu_command_respond_port(command,&statuscode,respondLen);
 }
@@ -692,54 +910,67 @@ void dfu_jump_application(uint16_t command, uint8_t *buf, uint8_t len)
     boot_jumpAddress(fw_addr); 
 }
 
-void boot_copy_firmware(uint32_t dest, uint32_t src, uint32_t size )
+static void boot_bank_copy_job(bank_info_t *p_bank, dfu_bankcopy_job_t *p_job)
 {
-    uint32_t read_size = 0;
-    uint32_t offset = 0;
-    uint8_t readbuf[FLASH_PAGE_SIZE];
-    //erase dest 
-    dfu_flash_erase_port(dest, size);
+    p_job->src  = p_bank->fw_load_addr;
+    p_job->dst  = p_bank->fw_start_addr;
+    p_job->size = p_bank->fw_size;
+    p_job->crc  = p_bank->fw_crc;
+}
 
-    //copy src to dest
-    while(offset < size)
+uint32_t boot_move_backup_to_app(bootsetting_info_t *p_info)
+{
+    dfu_bankcopy_job_t job;
+    boot_bank_copy_job(&p_info->backup_bank, &job);
+    //copy firmware data from backup to APP, sector by sector, resuming after a reset
+    if(dfu_bankcopy_run(&job) == APP_TRUE)
     {
-        read_size = size-offset;
-        if(read_size > FLASH_PAGE_SIZE) read_size = FLASH_PAGE_SIZE;
-        dfu_flash_read_port(src+offset, (uint8_t*)&readbuf, read_size);
-        dfu_flash_write_port(dest+offset, (uint8_t*)&readbuf, read_size);
-        offset += read_size;
+        //copy bootsetting info
+        memcpy(&p_info->app_bank,&p_info->backup_bank,sizeof(bank_info_t)); 
+        //disable backup bank
+        p_info->backup_bank.fw_active = APP_FALSE;
+        p_info->boot_mode = APP_FALSE;
+        //write bootsetting
+        dfu_bootsetting_write(p_info);
+        //the copy is recorded in bootsetting, drop its journal
+        dfu_bankcopy_clear();
+
+        // reply software reset command
+        uint8_t statuscode = 0;
+        dfu_command_respond_port(CMD_REST_DEV,&statuscode,1);
+        //reload from flash and reset
+        cb_deep_sleep_control(10);
+        return APP_TRUE;   
     }
+    return APP_FALSE;
 }
 
-uint32_t boot_move_backup_to_app(bootsetting_info_t *p_info)
+#if defined DFU_AB_BOOT
+static uint32_t boot_bank_check(const bank_info_t *p_bank)
 {
-    uint8_t copy_repeat = 3;
-    uint32_t crc_check;
-    while (--copy_repeat)
-    {
-        //copy firmware dato from backup to APP
-        boot_copy_firmware(p_info->backup_bank.fw_start_addr,p_info->backup_bank.fw_load_addr,p_info->backup_bank.fw_size);
-        //check crc after copy
-        crc_check = dfu_firmware_crc_check(p_info->backup_bank.fw_start_addr,p_info->backup_bank.fw_size);
-        if(crc_check == p_info->backup_bank.fw_crc)
-        {
-            //copy bootsetting info
-            memcpy(&p_info->app_bank,&p_info->backup_bank,sizeof(bank_info_t)); 
-            //disable backup bank
-            p_info->backup_bank.fw_active = APP_FALSE;
-            p_info->boot_mode = APP_FALSE;
-            //write bootsetting
-            dfu_bootsetting_write(p_info);
+    return (dfu_firmware_crc_check(p_bank->fw_start_addr,p_bank->fw_size) == p_bank->fw_crc) ? APP_TRUE : APP_FALSE;
+}
 
-            // reply software reset command
-            uint8_t statuscode = 0;
-            dfu_command_respond_port(CMD_REST_DEV,&statuscode,1);
-            //reload from flash and reset
-            cb_deep_sleep_control(10);
-            return APP_TRUE;   
-        }
+static uint32_t dfu_running_bank(void)
+{
+    #if defined BOOT
+    return 0;
+    #else
+    return SCB->VTOR + 0x1000; // MCU_ADDR to FLASH_ADDR
+    #endif
+}
+#endif
+
+static uint32_t boot_backup_crc_check(bootsetting_info_t *p_info)
+{
+    dfu_bankcopy_job_t job;
+    boot_bank_copy_job(&p_info->backup_bank, &job);
+    //the copy overwrites the backup head when the banks overlap
+    if(dfu_bankcopy_progress(&job) > 0)
+    {
+        return job.crc;
     }
-    return APP_FALSE;
+    return dfu_firmware_crc_check(job.src,job.size);
 }
 
 uint32_t dfu_boot_startup(void)
@@ -751,6 +982,22 @@ uint32_t dfu_boot_startup(void)
     {
         if(bootsetting.boot_mode != APP_TRUE)
         {
+            #if defined DFU_AB_BOOT
+            if(dfu_abboot_is_legacy(&bootsetting) != APP_TRUE)
+            {
+                uint32_t changed;
+                uint32_t bank = dfu_abboot_select(&bootsetting, boot_bank_check, &changed);
+                if(changed == APP_TRUE)
+                {
+                    dfu_bootsetting_write(&bootsetting);
+                }
+                if(bank != 0)
+                {
+                    boot_jumpAddress(bank); //jump to the selected bank, no copy
+                }
+                return APP_FALSE;
+            }
+            #endif
             if(bootsetting.backup_bank.fw_active != APP_TRUE)
             {
                 #if 1
@@ -761,11 +1008,18 @@ uint32_t dfu_boot_startup(void)
                 if(bootsetting.app_bank.fw_start_addr >= 0x1000)
                 #endif
                 {
+                    //journal left by a reset after the copy was recorded, a later copy must not skip it
+                    dfu_bankcopy_job_t job;
+                    boot_bank_copy_job(&bootsetting.app_bank, &job);
+                    if(dfu_bankcopy_progress(&job) > 0)
+                    {
+                        dfu_bankcopy_clear();
+                    }
                     boot_jumpAddress(bootsetting.app_bank.fw_start_addr); //jump to APP
                 }
                 else{
-                    //check backup bank
-                    crc_check = dfu_firmware_crc_check(bootsetting.backup_bank.fw_load_addr,bootsetting.backup_bank.fw_size);
+                    //check backup bank, already checked if its copy was interrupted
+                    crc_check = boot_backup_crc_check(&bootsetting);
                     if(crc_check == bootsetting.backup_bank.fw_crc && bootsetting.backup_bank.fw_start_addr >= 0x1000 && bootsetting.backup_bank.fw_size)
                     {
                         //copy backup to app
@@ -777,8 +1031,8 @@ uint32_t dfu_boot_startup(void)
                 }
             }
             else{
-                //check backup bank
-                crc_check = dfu_firmware_crc_check(bootsetting.backup_bank.fw_load_addr,bootsetting.backup_bank.fw_size);
+                //check backup bank, already checked if its copy was interrupted
+                crc_check = boot_backup_crc_check(&bootsetting);
                 if(crc_check == bootsetting.backup_bank.fw_crc && bootsetting.backup_bank.fw_start_addr >= 0x1000)
                 {
                     //copy backup to app
@@ -796,3 +1050,21 @@ uint32_t dfu_boot_startup(void)
 } 
 
 
+
+/**
+ * @brief Confirm the running image after a trial boot, so the next reset keeps it.
+ *        Without DFU_AB_BOOT, or when not in a trial, nothing is written.
+ *
+ * @return APP_TRUE if the running image was confirmed now.
+ */
+uint32_t dfu_boot_confirm(void)
+{
+    #if defined DFU_AB_BOOT
+    bootsetting_info_t bootsetting;
+    if(dfu_bootsetting_read(&bootsetting) == APP_TRUE && dfu_abboot_confirm(&bootsetting, dfu_running_bank()) == APP_TRUE)
+    {
+        return (dfu_bootsetting_write(&bootsetting) == 0) ? APP_TRUE : APP_FALSE;
+    }
+    #endif
+    return APP_FALSE;
+}
@@ -72,7 +72,8 @@ typedef struct {
     uint32_t      data_crc;
     uint32_t      boot_mode;
     bank_info_t   app_bank;
-    uint32_t      reserve0[4];
+    uint32_t      trial_state;      /**< A/B boot, DFU_TRIAL_* of dfu_abboot.h */
+    uint32_t      reserve0[3];
     bank_info_t   backup_bank;
     uint32_t      reserve1[4];
     uint32_t      ecc_public_key[64];
@@ -88,5 +89,11 @@ void    dfu_halder_init(dfu_cfg_t* p_cfg);
 uint8_t dfu_halder_get_state(void);
 uint8_t dfu_halder_polling(uint16_t command, uint8_t *prtData, uint16_t len, dfu_cmdhandler_t responder);
 void     dfu_software_enter_bootmode(void);
+uint32_t dfu_crc_check_port(uint8_t *p_data, uint32_t size, uint32_t prev_crc);
+uint32_t dfu_flash_erase_port(uint32_t address, uint32_t size);
+uint32_t dfu_flash_write_port(uint32_t address, uint8_t *p_data, uint32_t size);
+uint32_t dfu_flash_read_port(uint32_t address, uint8_t *p_data, uint32_t size);
+uint32_t dfu_firmware_crc_check(uint32_t address, uint32_t size);
 uint32_t dfu_boot_startup(void);
+uint32_t dfu_boot_confirm(void);
 #endif /*__APP_OTA_H*/
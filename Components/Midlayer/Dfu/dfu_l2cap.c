@@ -0,0 +1,434 @@
+/**
+ * @file    dfu_l2cap.c
+ * @brief   DFU and bulk data transport over a BLE L2CAP connection-oriented channel.
+ * @details L2CAP server, receive SDU pool, frame reassembly and transmit queue. See dfu_l2cap.h.
+ *
+ *          RAM: the receive pool holds DFU_L2CAP_RX_SDU_COUNT SDUs of DFU_L2CAP_SDU_MTU bytes plus
+ *          the mbuf headers (2 x 536 bytes by default), the reassembly buffer one DFU frame (261
+ *          bytes) and the response buffer one frame (261 bytes). Transmitted SDUs are taken from
+ *          msys while they wait for credits.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "host/ble_hs.h"
+#include "dfu_l2cap.h"
+#include "dfu_stream.h"
+#include "dfu_handler.h"
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM)
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_L2CAP_RX_BLOCK_SIZE (DFU_L2CAP_SDU_MTU + sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr))
+#define DFU_L2CAP_COPY_CHUNK    64      /**< Bytes copied from the SDU chain at a time */
+
+#if (LOG_ENABLE == APP_TRUE)
+  #include "app_uart.h"
+  #define LOG(...) app_uart_printf(__VA_ARGS__)
+#else
+  #define LOG(...)
+#endif
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static os_membuf_t dfu_l2cap_rx_mem[OS_MEMPOOL_SIZE(DFU_L2CAP_RX_SDU_COUNT, DFU_L2CAP_RX_BLOCK_SIZE)];
+static struct os_mempool dfu_l2cap_rx_mempool;
+static struct os_mbuf_pool dfu_l2cap_rx_mbuf_pool;
+
+static struct ble_l2cap_chan *dfu_l2cap_chan;
+static uint16_t dfu_l2cap_peer_mtu;
+static dfu_stream_rx_t dfu_l2cap_rx;
+
+static struct os_mbuf *dfu_l2cap_tx_queue[DFU_L2CAP_TX_QUEUE_LEN];
+static uint8_t dfu_l2cap_tx_head;
+static uint8_t dfu_l2cap_tx_count;
+static uint8_t dfu_l2cap_tx_stalled;
+static struct os_mbuf *dfu_l2cap_tx_resp;   // Responses to the SDU being processed
+static uint8_t dfu_l2cap_tx_frame[DEF_DFU_STREAM_FRAME_MAX];
+
+static dfu_l2cap_stats_t dfu_l2cap_stats;
+static uint32_t dfu_l2cap_rx_first_bytes;   // Received before rxFirstMs, not in the rate
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static int  dfu_l2cap_event(struct ble_l2cap_event *event, void *arg);
+static void dfu_l2cap_reset(void);
+static int  dfu_l2cap_rearm(void);
+static void dfu_l2cap_process_sdu(struct os_mbuf *sdu);
+static void dfu_l2cap_frame(uint16_t command, uint8_t *data, uint8_t len, void *arg);
+static void dfu_l2cap_responder(uint16_t command, uint8_t *buf, uint8_t len);
+static int  dfu_l2cap_enqueue(struct os_mbuf *om);
+static void dfu_l2cap_flush(void);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Free the queued SDUs and reset the channel state.
+ */
+static void dfu_l2cap_reset(void)
+{
+    while (dfu_l2cap_tx_count > 0)
+    {
+        os_mbuf_free_chain(dfu_l2cap_tx_queue[dfu_l2cap_tx_head]);
+        dfu_l2cap_tx_head = (dfu_l2cap_tx_head + 1) % DFU_L2CAP_TX_QUEUE_LEN;
+        dfu_l2cap_tx_count--;
+    }
+    if (dfu_l2cap_tx_resp != NULL)
+    {
+        os_mbuf_free_chain(dfu_l2cap_tx_resp);
+        dfu_l2cap_tx_resp = NULL;
+    }
+    dfu_l2cap_tx_head    = 0;
+    dfu_l2cap_tx_stalled = 0;
+    dfu_l2cap_chan       = NULL;
+    dfu_l2cap_peer_mtu   = 0;
+    dfu_stream_rx_init(&dfu_l2cap_rx);
+}
+
+/**
+ * @brief Give a receive SDU to the channel, which gives the credits back to the peer.
+ *
+ * @return 0 on success, NimBLE error code otherwise.
+ */
+static int dfu_l2cap_rearm(void)
+{
+    struct os_mbuf *sdu = os_mbuf_get_pkthdr(&dfu_l2cap_rx_mbuf_pool, 0);
+    if (sdu == NULL)
+    {
+        return BLE_HS_ENOMEM;
+    }
+    return ble_l2cap_recv_ready(dfu_l2cap_chan, sdu);
+}
+
+/**
+ * @brief Feed a received SDU to the frame reassembly and free it.
+ *
+ * @param sdu Received SDU.
+ */
+static void dfu_l2cap_process_sdu(struct os_mbuf *sdu)
+{
+    uint8_t  chunk[DFU_L2CAP_COPY_CHUNK];
+    uint16_t total = OS_MBUF_PKTLEN(sdu);
+    uint32_t now   = ble_npl_time_ticks_to_ms32(ble_npl_time_get());
+
+    if (dfu_l2cap_stats.rxSdus == 0)
+    {
+        dfu_l2cap_stats.rxFirstMs = now;
+        dfu_l2cap_rx_first_bytes  = total;
+    }
+    dfu_l2cap_stats.rxLastMs = now;
+    dfu_l2cap_stats.rxSdus++;
+    dfu_l2cap_stats.rxBytes += total;
+
+    for (uint16_t offset = 0; offset < total; )
+    {
+        uint16_t len = dfu_stream_tx_segment(total, offset, sizeof(chunk));
+        os_mbuf_copydata(sdu, offset, len, chunk);
+        dfu_stream_rx_feed(&dfu_l2cap_rx, chunk, len, dfu_l2cap_frame, NULL);
+        offset += len;
+    }
+    os_mbuf_free_chain(sdu);
+
+    dfu_l2cap_stats.rxFrames      = dfu_l2cap_rx.frames;
+    dfu_l2cap_stats.rxFrameErrors = dfu_l2cap_rx.checksumErrors;
+
+    // One response SDU for all the frames of the SDU
+    if (dfu_l2cap_tx_resp != NULL)
+    {
+        struct os_mbuf *resp = dfu_l2cap_tx_resp;
+        dfu_l2cap_tx_resp = NULL;
+        dfu_l2cap_enqueue(resp);
+    }
+    dfu_l2cap_flush();
+}
+
+/**
+ * @brief Pass a reassembled DFU frame to the DFU handler.
+ */
+static void dfu_l2cap_frame(uint16_t command, uint8_t *data, uint8_t len, void *arg)
+{
+    (void)arg;
+    dfu_halder_polling(command, data, len, dfu_l2cap_responder);
+}
+
+/**
+ * @brief Append a DFU response to the response SDU of the frame being processed.
+ */
+static void dfu_l2cap_responder(uint16_t command, uint8_t *buf, uint8_t len)
+{
+    uint16_t frameLen = dfu_stream_build_frame(dfu_l2cap_tx_frame, sizeof(dfu_l2cap_tx_frame), command, buf, len);
+
+    if ((dfu_l2cap_tx_resp != NULL) && ((OS_MBUF_PKTLEN(dfu_l2cap_tx_resp) + frameLen) > dfu_l2cap_peer_mtu))
+    {
+        struct os_mbuf *resp = dfu_l2cap_tx_resp;
+        dfu_l2cap_tx_resp = NULL;
+        dfu_l2cap_enqueue(resp);
+    }
+
+    if (dfu_l2cap_tx_resp == NULL)
+    {
+        dfu_l2cap_tx_resp = ble_hs_mbuf_from_flat(dfu_l2cap_tx_frame, frameLen);
+        if (dfu_l2cap_tx_resp == NULL)
+        {
+            dfu_l2cap_stats.txDropped++;
+        }
+    }
+    else if (os_mbuf_append(dfu_l2cap_tx_resp, dfu_l2cap_tx_frame, frameLen) != 0)
+    {
+        dfu_l2cap_stats.txDropped++;
+    }
+}
+
+/**
+ * @brief Queue an SDU for transmission, consumes the mbuf.
+ *
+ * @param om SDU.
+ * @return 0 on success, BLE_HS_ENOMEM if the queue is full.
+ */
+static int dfu_l2cap_enqueue(struct os_mbuf *om)
+{
+    if (dfu_l2cap_tx_count >= DFU_L2CAP_TX_QUEUE_LEN)
+    {
+        os_mbuf_free_chain(om);
+        dfu_l2cap_stats.txDropped++;
+        return BLE_HS_ENOMEM;
+    }
+    dfu_l2cap_tx_queue[(dfu_l2cap_tx_head + dfu_l2cap_tx_count) % DFU_L2CAP_TX_QUEUE_LEN] = om;
+    dfu_l2cap_tx_count++;
+    return 0;
+}
+
+/**
+ * @brief Send the queued SDUs while the peer has credits.
+ */
+static void dfu_l2cap_flush(void)
+{
+    while ((dfu_l2cap_tx_count > 0) && (dfu_l2cap_tx_stalled == 0) && (dfu_l2cap_chan != NULL))
+    {
+        struct os_mbuf *om  = dfu_l2cap_tx_queue[dfu_l2cap_tx_head];
+        uint16_t        len = OS_MBUF_PKTLEN(om);
+        int             rc  = ble_l2cap_send(dfu_l2cap_chan, om);
+
+        if (rc == BLE_HS_EBUSY)
+        {
+            break; // Previous SDU still in the host, retried on TX unstalled
+        }
+
+        dfu_l2cap_tx_head = (dfu_l2cap_tx_head + 1) % DFU_L2CAP_TX_QUEUE_LEN;
+        dfu_l2cap_tx_count--;
+
+        if ((rc == 0) || (rc == BLE_HS_ESTALLED))
+        {
+            // The host owns the SDU, stalled means it waits for credits
+            dfu_l2cap_stats.txSdus++;
+            dfu_l2cap_stats.txBytes += len;
+            if (rc == BLE_HS_ESTALLED)
+            {
+                dfu_l2cap_stats.txStalls++;
+                dfu_l2cap_tx_stalled = 1;
+            }
+        }
+        else
+        {
+            LOG("[DFU L2CAP] send failed rc=%d\n", rc);
+            os_mbuf_free_chain(om);
+            dfu_l2cap_stats.txDropped++;
+        }
+    }
+}
+
+/**
+ * @brief L2CAP channel event handler.
+ */
+static int dfu_l2cap_event(struct ble_l2cap_event *event, void *arg)
+{
+    struct ble_l2cap_chan_info info;
+    (void)arg;
+
+    switch (event->type)
+    {
+        case BLE_L2CAP_EVENT_COC_ACCEPT:
+            if (dfu_l2cap_chan != NULL)
+            {
+                return BLE_HS_ENOMEM; // One channel at a time
+            }
+            dfu_l2cap_reset();
+            memset(&dfu_l2cap_stats, 0, sizeof(dfu_l2cap_stats));
+            dfu_l2cap_chan     = event->accept.chan;
+            dfu_l2cap_peer_mtu = event->accept.peer_sdu_size;
+            return dfu_l2cap_rearm();
+
+        case BLE_L2CAP_EVENT_COC_CONNECTED:
+            if (event->connect.status != 0)
+            {
+                dfu_l2cap_reset();
+                return 0;
+            }
+            dfu_l2cap_chan = event->connect.chan;
+            if (ble_l2cap_get_chan_info(dfu_l2cap_chan, &info) == 0)
+            {
+                dfu_l2cap_peer_mtu = info.peer_coc_mtu;
+                LOG("[DFU L2CAP] connected, mtu %d / %d, mps %d / %d\n", info.our_coc_mtu, info.peer_coc_mtu,
+                    info.our_l2cap_mtu, info.peer_l2cap_mtu);
+            }
+            return 0;
+
+        case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+            if (event->disconnect.chan == dfu_l2cap_chan)
+            {
+                LOG("[DFU L2CAP] disconnected, rx %d bytes %d B/s\n", dfu_l2cap_stats.rxBytes, dfu_l2cap_get_rx_rate());
+                dfu_l2cap_reset();
+            }
+            return 0;
+
+        case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+            if (event->receive.sdu_rx == NULL)
+            {
+                return 0;
+            }
+            dfu_l2cap_process_sdu(event->receive.sdu_rx);
+            // Credits go back only now, after the flash writes of the SDU
+            if ((dfu_l2cap_chan != NULL) && (dfu_l2cap_rearm() != 0))
+            {
+                LOG("[DFU L2CAP] no rx buffer\n");
+            }
+            return 0;
+
+        case BLE_L2CAP_EVENT_COC_TX_UNSTALLED:
+            dfu_l2cap_tx_stalled = 0;
+            dfu_l2cap_flush();
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Create the L2CAP server.
+ */
+int dfu_l2cap_init(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&dfu_l2cap_rx_mempool, DFU_L2CAP_RX_SDU_COUNT, DFU_L2CAP_RX_BLOCK_SIZE,
+                         dfu_l2cap_rx_mem, "dfu_l2cap_rx");
+    if (rc != 0)
+    {
+        return rc;
+    }
+    rc = os_mbuf_pool_init(&dfu_l2cap_rx_mbuf_pool, &dfu_l2cap_rx_mempool, DFU_L2CAP_RX_BLOCK_SIZE,
+                           DFU_L2CAP_RX_SDU_COUNT);
+    if (rc != 0)
+    {
+        return rc;
+    }
+
+    dfu_l2cap_reset();
+    return ble_l2cap_create_server(DFU_L2CAP_PSM, DFU_L2CAP_SDU_MTU, dfu_l2cap_event, NULL);
+}
+
+/**
+ * @brief Check if a peer is connected on the channel.
+ */
+uint8_t dfu_l2cap_is_connected(void)
+{
+    return (dfu_l2cap_chan != NULL) ? 1 : 0;
+}
+
+/**
+ * @brief Send data to the peer, split into SDUs of the peer MTU.
+ */
+int dfu_l2cap_send(const uint8_t *buf, uint16_t len)
+{
+    if ((dfu_l2cap_chan == NULL) || (dfu_l2cap_peer_mtu == 0))
+    {
+        return BLE_HS_ENOTCONN;
+    }
+
+    uint16_t sdus = (len + dfu_l2cap_peer_mtu - 1) / dfu_l2cap_peer_mtu;
+    if ((dfu_l2cap_tx_count + sdus) > DFU_L2CAP_TX_QUEUE_LEN)
+    {
+        return BLE_HS_ENOMEM;
+    }
+
+    for (uint16_t offset = 0; offset < len; )
+    {
+        uint16_t segment = dfu_stream_tx_segment(len, offset, dfu_l2cap_peer_mtu);
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(&buf[offset], segment);
+        if (om == NULL)
+        {
+            // Already queued segments are sent, the caller resends from the start
+            dfu_l2cap_flush();
+            return BLE_HS_ENOMEM;
+        }
+        dfu_l2cap_enqueue(om);
+        offset += segment;
+    }
+    dfu_l2cap_flush();
+    return 0;
+}
+
+/**
+ * @brief Get the transfer counters of the current channel.
+ */
+void dfu_l2cap_get_stats(dfu_l2cap_stats_t *stats)
+{
+    *stats = dfu_l2cap_stats;
+}
+
+/**
+ * @brief Receive throughput of the current channel.
+ */
+uint32_t dfu_l2cap_get_rx_rate(void)
+{
+    uint32_t elapsed = dfu_l2cap_stats.rxLastMs - dfu_l2cap_stats.rxFirstMs;
+
+    if ((dfu_l2cap_stats.rxSdus < 2) || (elapsed == 0))
+    {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)(dfu_l2cap_stats.rxBytes - dfu_l2cap_rx_first_bytes) * 1000U) / elapsed);
+}
+
+#else
+
+int dfu_l2cap_init(void)
+{
+    return BLE_HS_ENOTSUP;
+}
+
+uint8_t dfu_l2cap_is_connected(void)
+{
+    return 0;
+}
+
+int dfu_l2cap_send(const uint8_t *buf, uint16_t len)
+{
+    (void)buf;
+    (void)len;
+    return BLE_HS_ENOTSUP;
+}
+
+void dfu_l2cap_get_stats(dfu_l2cap_stats_t *stats)
+{
+    memset(stats, 0, sizeof(dfu_l2cap_stats_t));
+}
+
+uint32_t dfu_l2cap_get_rx_rate(void)
+{
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) */
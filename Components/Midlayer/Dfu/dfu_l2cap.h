@@ -0,0 +1,109 @@
+/**
+ * @file    dfu_l2cap.h
+ * @brief   DFU and bulk data transport over a BLE L2CAP connection-oriented channel.
+ * @details Alternative to the GATT DFU service (dfu_blesvc.c): the peer opens an LE credit based
+ *          channel on DFU_L2CAP_PSM and writes the same DFU command frames as SDUs of up to
+ *          DFU_L2CAP_SDU_MTU bytes. An SDU can carry several frames, e.g. several CMD_PACK, and a
+ *          frame can span SDUs. Each SDU is reassembled by the host into a dedicated mbuf pool and
+ *          its frames are passed to dfu_halder_polling(); the credits are given back once the SDU
+ *          is processed, so the flash writes pace the peer without ATT round trips.
+ *          The responses of one SDU are sent back together in one SDU. Other producers can stream
+ *          data to the peer with dfu_l2cap_send().
+ *          Requires MYNEWT_VAL_BLE_L2CAP_COC_MAX_NUM > 0; all functions run in the BLE host task.
+ *          Not defined in dfu_app, where dfu_l2cap_init() then returns BLE_HS_ENOTSUP and the GATT
+ *          service is the only transport: a product adds MYNEWT_VAL_BLE_L2CAP_COC_MAX_NUM=1 to the C
+ *          defines once its host opens the channel.
+ *          The DFU throughput over the channel has not been measured on hardware and is not known to
+ *          be higher than over the GATT service; dfu_l2cap_get_rx_rate() reports it per connection.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __DFU_L2CAP_H
+#define __DFU_L2CAP_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DFU_L2CAP_PSM
+#define DFU_L2CAP_PSM           0x0080  /**< LE PSM of the channel, dynamic range */
+#endif
+#ifndef DFU_L2CAP_SDU_MTU
+#define DFU_L2CAP_SDU_MTU       512     /**< Largest SDU received, three CMD_PACK frames of 128 bytes */
+#endif
+#ifndef DFU_L2CAP_RX_SDU_COUNT
+#define DFU_L2CAP_RX_SDU_COUNT  2       /**< SDU buffers of the receive pool */
+#endif
+#ifndef DFU_L2CAP_TX_QUEUE_LEN
+#define DFU_L2CAP_TX_QUEUE_LEN  4       /**< SDUs waiting for credits, allocated from msys */
+#endif
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Transfer counters of the current channel.
+ */
+typedef struct {
+    uint32_t rxSdus;          /**< SDUs received */
+    uint32_t rxBytes;         /**< SDU payload bytes received */
+    uint32_t rxFrames;        /**< DFU frames passed to the handler */
+    uint32_t rxFrameErrors;   /**< Frames dropped on a checksum or type error */
+    uint32_t txSdus;          /**< SDUs accepted by the host */
+    uint32_t txBytes;         /**< SDU payload bytes accepted by the host */
+    uint32_t txStalls;        /**< Sends that waited for credits */
+    uint32_t txDropped;       /**< SDUs dropped, queue full or no mbuf */
+    uint32_t rxFirstMs;       /**< Time of the first SDU */
+    uint32_t rxLastMs;        /**< Time of the last SDU */
+} dfu_l2cap_stats_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Create the L2CAP server. Call after dfu_blesvc_gatt_svr_init(), which initializes the
+ *        DFU handler.
+ *
+ * @return 0 on success, NimBLE error code otherwise.
+ */
+int dfu_l2cap_init(void);
+
+/**
+ * @brief Check if a peer is connected on the channel.
+ *
+ * @return 1 if connected, 0 otherwise.
+ */
+uint8_t dfu_l2cap_is_connected(void);
+
+/**
+ * @brief Send data to the peer, split into SDUs of the peer MTU.
+ *
+ * The data is copied; it is queued while the peer has no credit.
+ *
+ * @param buf Data.
+ * @param len Length.
+ * @return 0 on success, BLE_HS_ENOTCONN without channel, BLE_HS_ENOMEM if the queue or msys is full
+ *         (nothing is queued).
+ */
+int dfu_l2cap_send(const uint8_t *buf, uint16_t len);
+
+/**
+ * @brief Get the transfer counters of the current channel.
+ *
+ * @param stats Counters.
+ */
+void dfu_l2cap_get_stats(dfu_l2cap_stats_t *stats);
+
+/**
+ * @brief Receive throughput of the current channel, between the first and the last SDU.
+ *
+ * @return Bytes per second, 0 with less than two SDUs.
+ */
+uint32_t dfu_l2cap_get_rx_rate(void);
+
+#endif /*__DFU_L2CAP_H*/
@@ -0,0 +1,216 @@
+/**
+ * @file    dfu_lz.c
+ * @brief   Compressed firmware image: LZSS stream decompressed as the DFU packs arrive.
+ * @details Incremental decoder; see dfu_lz.h for the format.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "dfu_lz.h"
+#include "dfu_handler.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_LZ_WINDOW_MASK      (DFU_LZ_WINDOW_SIZE - 1)
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+enum {
+    DFU_LZ_ST_HEADER = 0,
+    DFU_LZ_ST_FLAG,
+    DFU_LZ_ST_ITEM,
+    DFU_LZ_ST_MATCH,
+    DFU_LZ_ST_MATCH_EXT,
+    DFU_LZ_ST_END,
+    DFU_LZ_ST_DONE,                         // last page written
+    DFU_LZ_ST_ERROR,
+};
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static uint32_t dfu_lz_emit(dfu_lz_t *ctx, uint8_t byte);
+static uint32_t dfu_lz_copy(dfu_lz_t *ctx, uint32_t len);
+static void     dfu_lz_next_item(dfu_lz_t *ctx);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Append an image byte to the window, writing each completed page.
+ */
+static uint32_t dfu_lz_emit(dfu_lz_t *ctx, uint8_t byte)
+{
+    if (ctx->produced >= ctx->image_size)
+    {
+        return APP_FALSE;
+    }
+    ctx->window[ctx->produced & DFU_LZ_WINDOW_MASK] = byte;
+    ctx->produced++;
+    if ((ctx->produced % DFU_LZ_PAGE_SIZE) == 0)
+    {
+        uint32_t page = ctx->produced - DFU_LZ_PAGE_SIZE;
+        if (ctx->write(page, &ctx->window[page & DFU_LZ_WINDOW_MASK], DFU_LZ_PAGE_SIZE) != 0)
+        {
+            return APP_FALSE;
+        }
+    }
+    return APP_TRUE;
+}
+
+/**
+ * @brief Repeat earlier image bytes, the match code is in ctx->match.
+ */
+static uint32_t dfu_lz_copy(dfu_lz_t *ctx, uint32_t len)
+{
+    uint32_t distance = (ctx->match & 0x3FF) + 1;
+
+    if ((distance > ctx->produced) || (len > (ctx->image_size - ctx->produced)))
+    {
+        return APP_FALSE;
+    }
+    while (len--)
+    {
+        // Read before the write: a distance of the window size reads the slot being replaced
+        if (dfu_lz_emit(ctx, ctx->window[(ctx->produced - distance) & DFU_LZ_WINDOW_MASK]) != APP_TRUE)
+        {
+            return APP_FALSE;
+        }
+    }
+    return APP_TRUE;
+}
+
+static void dfu_lz_next_item(dfu_lz_t *ctx)
+{
+    if (ctx->produced == ctx->image_size)
+    {
+        ctx->state = DFU_LZ_ST_END; // unused flag bits of the last group are ignored
+    }
+    else
+    {
+        ctx->state = (ctx->items == 0) ? DFU_LZ_ST_FLAG : DFU_LZ_ST_ITEM;
+    }
+}
+
+/**
+ * @brief Start decompressing an image.
+ */
+void dfu_lz_start(dfu_lz_t *ctx, uint32_t max_size, dfu_lz_write_t write)
+{
+    ctx->write      = write;
+    ctx->image_size = max_size; // until the header
+    ctx->produced   = 0;
+    ctx->count      = 0;
+    ctx->items      = 0;
+    ctx->state      = DFU_LZ_ST_HEADER;
+}
+
+/**
+ * @brief Decompress the next stream bytes.
+ */
+uint32_t dfu_lz_feed(dfu_lz_t *ctx, const uint8_t *data, uint32_t len)
+{
+    for (uint32_t i = 0; (i < len) && (ctx->state != DFU_LZ_ST_ERROR); i++)
+    {
+        uint8_t  byte = data[i];
+        uint32_t ok = APP_TRUE;
+
+        switch (ctx->state)
+        {
+        case DFU_LZ_ST_HEADER:
+            ctx->header[ctx->count++] = byte;
+            if (ctx->count == DFU_LZ_HEADER_SIZE)
+            {
+                uint32_t magic = (uint32_t)ctx->header[0] | ((uint32_t)ctx->header[1] << 8) |
+                                 ((uint32_t)ctx->header[2] << 16) | ((uint32_t)ctx->header[3] << 24);
+                uint32_t size  = (uint32_t)ctx->header[4] | ((uint32_t)ctx->header[5] << 8) |
+                                 ((uint32_t)ctx->header[6] << 16) | ((uint32_t)ctx->header[7] << 24);
+                ok = ((magic == DFU_LZ_MAGIC) && (size != 0) && (size <= ctx->image_size)) ? APP_TRUE : APP_FALSE;
+                ctx->image_size = size;
+                ctx->state = DFU_LZ_ST_FLAG;
+            }
+            break;
+
+        case DFU_LZ_ST_FLAG:
+            ctx->flags = byte;
+            ctx->items = 8;
+            ctx->state = DFU_LZ_ST_ITEM;
+            break;
+
+        case DFU_LZ_ST_ITEM:
+            ctx->items--;
+            if (ctx->flags & 0x01)
+            {
+                ok = dfu_lz_emit(ctx, byte);
+                dfu_lz_next_item(ctx);
+            }
+            else
+            {
+                ctx->match = byte;
+                ctx->state = DFU_LZ_ST_MATCH;
+            }
+            ctx->flags >>= 1;
+            break;
+
+        case DFU_LZ_ST_MATCH:
+            ctx->match |= (uint32_t)byte << 8;
+            if ((ctx->match >> 10) == DFU_LZ_LEN_EXT)
+            {
+                ctx->state = DFU_LZ_ST_MATCH_EXT;
+            }
+            else
+            {
+                ok = dfu_lz_copy(ctx, (ctx->match >> 10) + DFU_LZ_MIN_MATCH);
+                dfu_lz_next_item(ctx);
+            }
+            break;
+
+        case DFU_LZ_ST_MATCH_EXT:
+            ok = dfu_lz_copy(ctx, DFU_LZ_LEN_EXT + DFU_LZ_MIN_MATCH + byte);
+            dfu_lz_next_item(ctx);
+            break;
+
+        default:
+            ok = APP_FALSE; // data after the image
+            break;
+        }
+        if (ok != APP_TRUE)
+        {
+            ctx->state = DFU_LZ_ST_ERROR;
+        }
+    }
+    return (ctx->state == DFU_LZ_ST_ERROR) ? APP_FALSE : APP_TRUE;
+}
+
+/**
+ * @brief Check that the image is complete and write its last page.
+ */
+uint32_t dfu_lz_finish(dfu_lz_t *ctx, uint32_t *p_size)
+{
+    uint32_t last = ctx->produced % DFU_LZ_PAGE_SIZE;
+
+    *p_size = ctx->produced;
+    if (ctx->state == DFU_LZ_ST_DONE)
+    {
+        return APP_TRUE;
+    }
+    if (ctx->state != DFU_LZ_ST_END)
+    {
+        return APP_FALSE;
+    }
+    ctx->state = DFU_LZ_ST_DONE;
+    if (last != 0)
+    {
+        uint32_t page = ctx->produced - last;
+        if (ctx->write(page, &ctx->window[page & DFU_LZ_WINDOW_MASK], last) != 0)
+        {
+            return APP_FALSE;
+        }
+    }
+    return APP_TRUE;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file    dfu_lz.h
+ * @brief   Compressed firmware image: LZSS stream decompressed as the DFU packs arrive.
+ * @details The stream is made by Tools/Dfu_Lz/dfu_lz.py and sent with the usual DFU packs in place of
+ *          the image. Size and CRC given to the DFU verify command are those of the decompressed
+ *          image, so the boot setting and the bootloader see a plain image.
+ *          Format, little endian:
+ *          - header: "DLZ1", image size (4)
+ *          - groups of one flag byte and up to 8 items, flag bit 0 first:
+ *            1: literal byte
+ *            0: match of 2 bytes, bits 0..9 distance - 1, bits 10..15 length - 3; a length code of
+ *               63 is followed by one byte added to the length (66..321)
+ *          The stream ends when the image is complete. Matches reach back at most
+ *          DFU_LZ_WINDOW_SIZE bytes: the history window is also the output buffer, written to flash
+ *          one page at a time, so RAM is the window plus a few words of state.
+ *          Not defined in dfu_app: without DFU_LZ_IMAGE a start command for a compressed image is
+ *          refused (status 0x05). A product adds it to the C defines once its host sends them.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __DFU_LZ_H
+#define __DFU_LZ_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_LZ_MAGIC            0x315A4C44  /**< "DLZ1" */
+#define DFU_LZ_HEADER_SIZE      8
+#define DFU_LZ_WINDOW_SIZE      0x400       /**< History, multiple of the page */
+#define DFU_LZ_PAGE_SIZE        0x100
+#define DFU_LZ_MIN_MATCH        3
+#define DFU_LZ_LEN_EXT          63          /**< Length code followed by an extra byte */
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Output of the image, in order, page aligned chunks.
+ *
+ * @return 0 on success.
+ */
+typedef uint32_t (*dfu_lz_write_t)(uint32_t offset, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Decompressor state.
+ */
+typedef struct {
+    dfu_lz_write_t write;
+    uint32_t image_size;
+    uint32_t produced;                      /**< Image bytes decompressed */
+    uint32_t state;
+    uint32_t count;                         /**< Header bytes */
+    uint32_t match;                         /**< Match code being read */
+    uint8_t  flags;
+    uint8_t  items;                         /**< Items left in the group */
+    uint8_t  header[DFU_LZ_HEADER_SIZE];
+    uint8_t  window[DFU_LZ_WINDOW_SIZE];
+} dfu_lz_t;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Start decompressing an image.
+ *
+ * @param ctx        Decompressor.
+ * @param max_size   Largest image accepted.
+ * @param write      Image output.
+ */
+void dfu_lz_start(dfu_lz_t *ctx, uint32_t max_size, dfu_lz_write_t write);
+
+/**
+ * @brief Decompress the next stream bytes.
+ *
+ * @param ctx  Decompressor.
+ * @param data Stream bytes.
+ * @param len  Length.
+ * @return APP_TRUE, APP_FALSE on a corrupt stream or a write error.
+ */
+uint32_t dfu_lz_feed(dfu_lz_t *ctx, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Check that the image is complete and write its last page.
+ *
+ * @param ctx    Decompressor.
+ * @param p_size Size of the image.
+ * @return APP_TRUE if the stream ended with the image.
+ */
+uint32_t dfu_lz_finish(dfu_lz_t *ctx, uint32_t *p_size);
+
+#endif /*__DFU_LZ_H*/
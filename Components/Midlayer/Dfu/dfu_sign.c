@@ -0,0 +1,353 @@
+/**
+ * @file    dfu_sign.c
+ * @brief   RSA signature verification of DFU images.
+ * @details Incremental SHA-256 of the received image, PKCS#1 v1.5 signature check with the PKA
+ *          and flash cache of the Montgomery constants of the key. See dfu_sign.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "dfu_sign.h"
+#include "dfu_handler.h"
+
+#if defined DFU_SIGNED_IMAGE
+#if !defined DFU_SIGN_PRODUCT_KEY
+#error "DFU_SIGNED_IMAGE: define the product dfu_sign_public_key, then DFU_SIGN_PRODUCT_KEY"
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_SIGN_KEYCACHE_MAGIC 0x314B5344  // "DSK1"
+
+#define ROTR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Flash record of the Montgomery constants.
+ */
+typedef struct {
+    uint32_t         data_crc;   /**< CRC of the fields below */
+    uint32_t         magic;
+    uint32_t         key_crc;    /**< CRC of the public key the constants were computed for */
+    stPkaPrecompVals precomp;
+} dfu_sign_keycache_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static const uint32_t dfu_sign_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// SHA-256 DigestInfo prefix of the PKCS#1 v1.5 encoding
+static const uint8_t dfu_sign_digest_info[] = {
+    0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20,
+};
+
+static stPkaRsaKey         dfu_sign_key;          // Little endian, as used by the PKA
+static dfu_sign_keycache_t dfu_sign_keycache;
+static uint8_t             dfu_sign_key_loaded;
+static dfu_sign_sha256_t   dfu_sign_hash;
+static uint8_t             dfu_sign_tail[DFU_SIGN_SIZE];  // Last received bytes, the signature at the end
+static uint16_t            dfu_sign_tail_len;
+static uint32_t            dfu_sign_verify_cycles;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void     dfu_sign_sha256_block(dfu_sign_sha256_t *ctx, const uint8_t *block);
+static void     dfu_sign_reverse(uint8_t *dst, const uint8_t *src, uint32_t len);
+static uint32_t dfu_sign_cycles(void);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Read the cycle counter, if the application has enabled it.
+ *
+ * @return CPU cycles, 0 if the cycle counter is not running.
+ */
+static uint32_t dfu_sign_cycles(void)
+{
+#if defined(DWT)
+    return (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) ? DWT->CYCCNT : 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Copy a byte array in reverse order.
+ */
+static void dfu_sign_reverse(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        dst[i] = src[len - 1 - i];
+    }
+}
+
+/**
+ * @brief Process one 64-byte block.
+ */
+static void dfu_sign_sha256_block(dfu_sign_sha256_t *ctx, const uint8_t *block)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (uint8_t i = 16; i < 64; i++)
+    {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    a = ctx->state[0]; b = ctx->state[1]; c = ctx->state[2]; d = ctx->state[3];
+    e = ctx->state[4]; f = ctx->state[5]; g = ctx->state[6]; h = ctx->state[7];
+    for (uint8_t i = 0; i < 64; i++)
+    {
+        uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + dfu_sign_sha256_k[i] + w[i];
+        uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+    ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+}
+
+/**
+ * @brief Start a SHA-256.
+ */
+void dfu_sign_sha256_init(dfu_sign_sha256_t *ctx)
+{
+    static const uint32_t init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(ctx->state, init, sizeof(init));
+    ctx->length = 0;
+    ctx->used   = 0;
+}
+
+/**
+ * @brief Add data to a SHA-256.
+ */
+void dfu_sign_sha256_update(dfu_sign_sha256_t *ctx, const uint8_t *data, uint32_t len)
+{
+    ctx->length += len;
+    if (ctx->used > 0)
+    {
+        uint32_t copy = sizeof(ctx->block) - ctx->used;
+        if (copy > len)
+        {
+            copy = len;
+        }
+        memcpy(&ctx->block[ctx->used], data, copy);
+        ctx->used += (uint8_t)copy;
+        data      += copy;
+        len       -= copy;
+        if (ctx->used < sizeof(ctx->block))
+        {
+            return;
+        }
+        dfu_sign_sha256_block(ctx, ctx->block);
+        ctx->used = 0;
+    }
+    while (len >= sizeof(ctx->block))
+    {
+        dfu_sign_sha256_block(ctx, data);
+        data += sizeof(ctx->block);
+        len  -= sizeof(ctx->block);
+    }
+    memcpy(ctx->block, data, len);
+    ctx->used = (uint8_t)len;
+}
+
+/**
+ * @brief Finish a SHA-256.
+ */
+void dfu_sign_sha256_final(dfu_sign_sha256_t *ctx, uint8_t digest[DFU_SIGN_HASH_SIZE])
+{
+    uint64_t bits = ctx->length * 8;
+
+    ctx->block[ctx->used++] = 0x80;
+    if (ctx->used > (sizeof(ctx->block) - 8))
+    {
+        memset(&ctx->block[ctx->used], 0, sizeof(ctx->block) - ctx->used);
+        dfu_sign_sha256_block(ctx, ctx->block);
+        ctx->used = 0;
+    }
+    memset(&ctx->block[ctx->used], 0, sizeof(ctx->block) - 8 - ctx->used);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        ctx->block[63 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    dfu_sign_sha256_block(ctx, ctx->block);
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        digest[i * 4]     = (uint8_t)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)(ctx->state[i]);
+    }
+}
+
+/**
+ * @brief Load the public key and its cached Montgomery constants.
+ */
+uint32_t dfu_sign_key_load(void)
+{
+    uint32_t key_crc = dfu_crc_check_port((uint8_t *)&dfu_sign_public_key, sizeof(dfu_sign_pubkey_t), 0);
+
+    memset(&dfu_sign_key, 0, sizeof(dfu_sign_key));
+    dfu_sign_reverse(dfu_sign_key.Modulus, dfu_sign_public_key.modulus, DFU_SIGN_SIZE);
+    dfu_sign_reverse(dfu_sign_key.Exp, dfu_sign_public_key.exponent, sizeof(dfu_sign_public_key.exponent));
+    dfu_sign_key.ModSize = DFU_SIGN_SIZE;
+
+    dfu_flash_read_port(DFU_SIGN_KEYCACHE_ADDR, (uint8_t *)&dfu_sign_keycache, sizeof(dfu_sign_keycache));
+    uint32_t crc_check = dfu_crc_check_port((uint8_t *)(&dfu_sign_keycache.data_crc + 1), sizeof(dfu_sign_keycache) - 4, 0);
+    if ((crc_check != dfu_sign_keycache.data_crc) || (dfu_sign_keycache.magic != DFU_SIGN_KEYCACHE_MAGIC) ||
+        (dfu_sign_keycache.key_crc != key_crc))
+    {
+        // First use of this key: compute the constants once
+        CB_PKA_Init();
+        CB_PKA_CalcRInv(dfu_sign_key.Modulus, dfu_sign_key.ModSize, dfu_sign_keycache.precomp.RInv);
+        CB_PKA_CalcMp(dfu_sign_key.Modulus, dfu_sign_key.ModSize, dfu_sign_keycache.precomp.RInv, dfu_sign_keycache.precomp.Mp);
+        CB_PKA_CalcRSqr(dfu_sign_key.Modulus, dfu_sign_key.ModSize, dfu_sign_keycache.precomp.RInv, dfu_sign_keycache.precomp.RSqr);
+        CB_PKA_Deinit();
+
+        dfu_sign_keycache.magic    = DFU_SIGN_KEYCACHE_MAGIC;
+        dfu_sign_keycache.key_crc  = key_crc;
+        dfu_sign_keycache.data_crc = dfu_crc_check_port((uint8_t *)(&dfu_sign_keycache.data_crc + 1), sizeof(dfu_sign_keycache) - 4, 0);
+        if ((dfu_flash_erase_port(DFU_SIGN_KEYCACHE_ADDR, sizeof(dfu_sign_keycache)) != 0) ||
+            (dfu_flash_write_port(DFU_SIGN_KEYCACHE_ADDR, (uint8_t *)&dfu_sign_keycache, sizeof(dfu_sign_keycache)) != 0))
+        {
+            // Constants are valid in RAM, the cache is rebuilt on the next load
+            dfu_sign_key_loaded = APP_TRUE;
+            return APP_FALSE;
+        }
+    }
+    dfu_sign_key_loaded = APP_TRUE;
+    return APP_TRUE;
+}
+
+/**
+ * @brief Start the hash of a new image.
+ */
+void dfu_sign_start(void)
+{
+    if (dfu_sign_key_loaded != APP_TRUE)
+    {
+        dfu_sign_key_load();
+    }
+    dfu_sign_sha256_init(&dfu_sign_hash);
+    dfu_sign_tail_len = 0;
+}
+
+/**
+ * @brief Add received image data, in order.
+ */
+void dfu_sign_update(const uint8_t *data, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t chunk = (len > DFU_SIGN_SIZE) ? DFU_SIGN_SIZE : len;
+
+        // Hash what can no longer be part of the signature, keep the last DFU_SIGN_SIZE bytes
+        uint32_t total = dfu_sign_tail_len + chunk;
+        if (total > DFU_SIGN_SIZE)
+        {
+            uint32_t from_tail = total - DFU_SIGN_SIZE;
+            if (from_tail > dfu_sign_tail_len)
+            {
+                from_tail = dfu_sign_tail_len;
+            }
+            uint32_t from_data = (total - DFU_SIGN_SIZE) - from_tail;
+
+            dfu_sign_sha256_update(&dfu_sign_hash, dfu_sign_tail, from_tail);
+            dfu_sign_sha256_update(&dfu_sign_hash, data, from_data);
+            memmove(dfu_sign_tail, &dfu_sign_tail[from_tail], dfu_sign_tail_len - from_tail);
+            dfu_sign_tail_len -= (uint16_t)from_tail;
+            data  += from_data;
+            len   -= from_data;
+            chunk -= from_data;
+        }
+        memcpy(&dfu_sign_tail[dfu_sign_tail_len], data, chunk);
+        dfu_sign_tail_len += (uint16_t)chunk;
+        data += chunk;
+        len  -= chunk;
+    }
+}
+
+/**
+ * @brief Finish the hash and verify the signature.
+ */
+uint32_t dfu_sign_finish(void)
+{
+    uint8_t  digest[DFU_SIGN_HASH_SIZE];
+    uint8_t  signature[DFU_SIGN_SIZE];
+    uint8_t  message[DFU_SIGN_SIZE];
+    uint32_t start = dfu_sign_cycles();
+
+    if ((dfu_sign_key_loaded != APP_TRUE) || (dfu_sign_tail_len != DFU_SIGN_SIZE) || (dfu_sign_hash.length == 0))
+    {
+        return APP_FALSE;
+    }
+    dfu_sign_sha256_final(&dfu_sign_hash, digest);
+
+    // Signature is big endian, the PKA works on little endian numbers
+    dfu_sign_reverse(signature, dfu_sign_tail, DFU_SIGN_SIZE);
+    CB_PKA_Init();
+    CB_PKA_RsaVerifyP(signature, DFU_SIGN_SIZE, &dfu_sign_keycache.precomp, message, &dfu_sign_key);
+    CB_PKA_Deinit();
+
+    // EM = 00 01 FF..FF 00 DigestInfo digest, compared from the most significant byte
+    uint32_t pos   = DFU_SIGN_SIZE - 1;
+    uint8_t  diff  = message[pos--] ^ 0x00;
+    diff |= message[pos--] ^ 0x01;
+    while (pos > (sizeof(dfu_sign_digest_info) + DFU_SIGN_HASH_SIZE))
+    {
+        diff |= message[pos--] ^ 0xFF;
+    }
+    diff |= message[pos--] ^ 0x00;
+    for (uint32_t i = 0; i < sizeof(dfu_sign_digest_info); i++)
+    {
+        diff |= message[pos--] ^ dfu_sign_digest_info[i];
+    }
+    for (uint32_t i = 0; i < DFU_SIGN_HASH_SIZE; i++)
+    {
+        diff |= message[DFU_SIGN_HASH_SIZE - 1 - i] ^ digest[i];
+    }
+
+    dfu_sign_verify_cycles = dfu_sign_cycles() - start;
+    return (diff == 0) ? APP_TRUE : APP_FALSE;
+}
+
+/**
+ * @brief Cycles of the last dfu_sign_finish().
+ */
+uint32_t dfu_sign_get_verify_cycles(void)
+{
+    return dfu_sign_verify_cycles;
+}
+
+#endif /* DFU_SIGNED_IMAGE */
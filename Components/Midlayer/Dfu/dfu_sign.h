@@ -0,0 +1,122 @@
+/**
+ * @file    dfu_sign.h
+ * @brief   RSA signature verification of DFU images.
+ * @details A signed image is the firmware followed by an RSASSA-PKCS1-v1_5 SHA-256 signature of
+ *          the firmware with an RSA-1024 key, as produced by "openssl dgst -sha256 -sign key.pem".
+ *          The image is transferred and CRC checked as before; the signature is the last
+ *          DFU_SIGN_SIZE bytes of the transfer.
+ *          The packs are hashed as they arrive, the hash trailing the received data by the size of
+ *          the signature, so at the end of the transfer only the last SHA-256 block and one PKA
+ *          exponentiation remain: there is no second pass over the flash.
+ *          The Montgomery constants of the public key are computed once with the PKA and cached in
+ *          flash (DFU_SIGN_KEYCACHE_ADDR), tagged with a CRC of the key, so a verification only runs
+ *          CB_PKA_RsaVerifyP().
+ *          The SDK has no signing key: a product enabling DFU_SIGNED_IMAGE defines its own
+ *          dfu_sign_public_key and DFU_SIGN_PRODUCT_KEY, the build fails otherwise.
+ *          The check runs where the image is received, in dfu_app. dfu_bootloader has no room for it
+ *          in its 16 KB and its UART update accepts unsigned images: a product that relies on
+ *          signatures disables that path.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __DFU_SIGN_H
+#define __DFU_SIGN_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_pka.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DFU_SIGN_KEYCACHE_ADDR
+#define DFU_SIGN_KEYCACHE_ADDR  0x7B000   /**< Flash sector of the cached Montgomery constants */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_SIGN_SIZE           128       /**< RSA-1024 signature */
+#define DFU_SIGN_HASH_SIZE      32        /**< SHA-256 digest */
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Public key, big endian as printed by "openssl rsa -pubin -text".
+ */
+typedef struct {
+    uint8_t modulus[DFU_SIGN_SIZE];
+    uint8_t exponent[4];
+} dfu_sign_pubkey_t;
+
+/**
+ * @brief Incremental SHA-256.
+ */
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;      /**< Bytes hashed */
+    uint8_t  block[64];
+    uint8_t  used;        /**< Bytes in block */
+} dfu_sign_sha256_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+/**
+ * @brief Image signing key, defined by the product. Never use the key of Examples/peripheral_pka:
+ *        its private half ships with the SDK.
+ */
+extern const dfu_sign_pubkey_t dfu_sign_public_key;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Load the public key and its cached Montgomery constants, computing and caching them
+ *        if the cache is missing or was made for another key.
+ *
+ * @return APP_TRUE on success.
+ */
+uint32_t dfu_sign_key_load(void);
+
+/**
+ * @brief Start the hash of a new image. Loads the key if not done yet.
+ */
+void dfu_sign_start(void);
+
+/**
+ * @brief Add received image data, in order.
+ *
+ * @param data Data.
+ * @param len  Length.
+ */
+void dfu_sign_update(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Finish the hash and verify the signature received at the end of the image.
+ *
+ * @return APP_TRUE if the signature is valid.
+ */
+uint32_t dfu_sign_finish(void);
+
+/**
+ * @brief Cycles of the last dfu_sign_finish(), hash completion and RSA verification.
+ *
+ * The DWT cycle counter is not enabled here: the application enables it to get a measurement.
+ *
+ * @return CPU cycles, 0 if the cycle counter is not running.
+ */
+uint32_t dfu_sign_get_verify_cycles(void);
+
+/**
+ * @brief Incremental SHA-256, FIPS 180-4.
+ */
+void dfu_sign_sha256_init(dfu_sign_sha256_t *ctx);
+void dfu_sign_sha256_update(dfu_sign_sha256_t *ctx, const uint8_t *data, uint32_t len);
+void dfu_sign_sha256_final(dfu_sign_sha256_t *ctx, uint8_t digest[DFU_SIGN_HASH_SIZE]);
+
+#endif /*__DFU_SIGN_H*/
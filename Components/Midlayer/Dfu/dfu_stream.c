@@ -0,0 +1,206 @@
+/**
+ * @file    dfu_stream.c
+ * @brief   DFU command frames over a byte stream.
+ * @details Frame reassembly, response framing and segmentation. See dfu_stream.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "dfu_stream.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_DFU_STREAM_REQ_TYPE   0x00  /**< Req:0x00 | Resp:0x01 */
+#define DEF_DFU_STREAM_RESP_TYPE  0x01
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static uint8_t  dfu_stream_checksum(const uint8_t *frame, uint16_t frameLen);
+static void     dfu_stream_rx_drop(dfu_stream_rx_t *rx, uint16_t count);
+static uint16_t dfu_stream_rx_parse(dfu_stream_rx_t *rx, dfu_stream_frame_cb_t cb, void *arg);
+static uint16_t dfu_stream_rx_needed(const dfu_stream_rx_t *rx);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Checksum of a frame, sum of the bytes after the marker and before the checksum.
+ *
+ * @param frame    Frame.
+ * @param frameLen Frame length, including the checksum.
+ * @return Checksum.
+ */
+static uint8_t dfu_stream_checksum(const uint8_t *frame, uint16_t frameLen)
+{
+    uint8_t checksum = 0;
+    for (uint16_t i = 1; i < (frameLen - DEF_CHECKSUM_SIZE); i++)
+    {
+        checksum += frame[i];
+    }
+    return checksum;
+}
+
+/**
+ * @brief Drop bytes at the start of the buffer, then up to the next marker.
+ *
+ * @param rx    Reassembly state.
+ * @param count Bytes to drop.
+ */
+static void dfu_stream_rx_drop(dfu_stream_rx_t *rx, uint16_t count)
+{
+    while ((count < rx->used) && (rx->buf[count] != DEF_RXMARKER_VAL))
+    {
+        count++;
+        rx->resyncBytes++;
+    }
+    if (count >= rx->used)
+    {
+        rx->used = 0;
+        return;
+    }
+    memmove(&rx->buf[0], &rx->buf[count], rx->used - count);
+    rx->used -= count;
+}
+
+/**
+ * @brief Deliver the complete frames held in the buffer.
+ *
+ * @param rx  Reassembly state.
+ * @param cb  Frame callback.
+ * @param arg Callback argument.
+ * @return Number of frames delivered.
+ */
+static uint16_t dfu_stream_rx_parse(dfu_stream_rx_t *rx, dfu_stream_frame_cb_t cb, void *arg)
+{
+    uint16_t delivered = 0;
+
+    while (rx->used >= DEF_HEADER_SIZE)
+    {
+        uint16_t frameLen = DEF_HEADER_SIZE + rx->buf[DEF_DL_POS] + DEF_CHECKSUM_SIZE;
+        if (rx->used < frameLen)
+        {
+            break; // Wait for data and checksum
+        }
+
+        if ((rx->buf[DEF_RESP_POS] != DEF_DFU_STREAM_REQ_TYPE) ||
+            (dfu_stream_checksum(rx->buf, frameLen) != rx->buf[frameLen - DEF_CHECKSUM_SIZE]))
+        {
+            // The marker may have been a data byte, search the next one inside the frame
+            rx->checksumErrors++;
+            rx->resyncBytes++;
+            dfu_stream_rx_drop(rx, 1);
+            continue;
+        }
+
+        uint16_t command = ((uint16_t)rx->buf[DEF_CMD_POS] << 8) | rx->buf[DEF_CMD_POS + 1];
+        rx->frames++;
+        delivered++;
+        cb(command, &rx->buf[DEF_DATA_POS], rx->buf[DEF_DL_POS], arg);
+        dfu_stream_rx_drop(rx, frameLen);
+    }
+    return delivered;
+}
+
+/**
+ * @brief Bytes to complete the header or the frame in the buffer.
+ *
+ * @param rx Reassembly state.
+ * @return Bytes needed, never 0.
+ */
+static uint16_t dfu_stream_rx_needed(const dfu_stream_rx_t *rx)
+{
+    if (rx->used < DEF_HEADER_SIZE)
+    {
+        return DEF_HEADER_SIZE - rx->used;
+    }
+    return (DEF_HEADER_SIZE + rx->buf[DEF_DL_POS] + DEF_CHECKSUM_SIZE) - rx->used;
+}
+
+/**
+ * @brief Reset the reassembly state and counters.
+ */
+void dfu_stream_rx_init(dfu_stream_rx_t *rx)
+{
+    rx->used           = 0;
+    rx->frames         = 0;
+    rx->checksumErrors = 0;
+    rx->resyncBytes    = 0;
+}
+
+/**
+ * @brief Feed a segment of the stream.
+ */
+uint16_t dfu_stream_rx_feed(dfu_stream_rx_t *rx, const uint8_t *data, uint16_t len, dfu_stream_frame_cb_t cb, void *arg)
+{
+    uint16_t delivered = 0;
+
+    while (len > 0)
+    {
+        if (rx->used == 0)
+        {
+            if (*data != DEF_RXMARKER_VAL)
+            {
+                rx->resyncBytes++;
+                data++;
+                len--;
+                continue;
+            }
+        }
+
+        // Only copy up to the end of the current header / frame: in sync, the buffer holds one frame
+        uint16_t copy = dfu_stream_rx_needed(rx);
+        if (copy > len)
+        {
+            copy = len;
+        }
+        memcpy(&rx->buf[rx->used], data, copy);
+        rx->used += copy;
+        data     += copy;
+        len      -= copy;
+
+        delivered += dfu_stream_rx_parse(rx, cb, arg);
+    }
+    return delivered;
+}
+
+/**
+ * @brief Build a response frame.
+ */
+uint16_t dfu_stream_build_frame(uint8_t *out, uint16_t size, uint16_t command, const uint8_t *data, uint8_t len)
+{
+    uint16_t frameLen = DEF_HEADER_SIZE + len + DEF_CHECKSUM_SIZE;
+    if (size < frameLen)
+    {
+        return 0;
+    }
+
+    out[DEF_RXMARKER_POS] = DEF_RXMARKER_VAL;
+    out[DEF_CMD_POS]      = command >> 8;
+    out[DEF_CMD_POS + 1]  = command & 0xff;
+    out[DEF_RESP_POS]     = DEF_DFU_STREAM_RESP_TYPE;
+    out[DEF_DL_POS]       = len;
+    if (len > 0)
+    {
+        memcpy(&out[DEF_DATA_POS], data, len);
+    }
+    out[frameLen - DEF_CHECKSUM_SIZE] = dfu_stream_checksum(out, frameLen);
+    return frameLen;
+}
+
+/**
+ * @brief Length of the segment starting at an offset of a buffer.
+ */
+uint16_t dfu_stream_tx_segment(uint32_t total, uint32_t offset, uint16_t mtu)
+{
+    if ((mtu == 0) || (offset >= total))
+    {
+        return 0;
+    }
+    return ((total - offset) > mtu) ? mtu : (uint16_t)(total - offset);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file    dfu_stream.h
+ * @brief   DFU command frames over a byte stream.
+ * @details Reassembly of DFU command frames (marker, command, type, length, data, checksum) from a
+ *          stream transport whose segments are not aligned with the frames, e.g. L2CAP CoC SDUs:
+ *          a segment can hold several frames and a frame can be split over several segments.
+ *          Frames are validated with their checksum; on an invalid frame one byte is dropped and
+ *          the search for the next marker restarts, like the UART command parser.
+ *          Also builds response frames and splits a buffer into transport-sized segments.
+ *          No BLE or hardware access: the module can be built and tested on a host.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __DFU_STREAM_H
+#define __DFU_STREAM_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "dfu_handler.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_DFU_STREAM_FRAME_MAX   (DEF_HEADER_SIZE + 0xFF + DEF_CHECKSUM_SIZE)  /**< Largest frame, 8-bit data length */
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Called for each valid request frame.
+ *
+ * @param command Command.
+ * @param data    Data of the frame.
+ * @param len     Data length.
+ * @param arg     Argument given to dfu_stream_rx_feed().
+ */
+typedef void (*dfu_stream_frame_cb_t)(uint16_t command, uint8_t *data, uint8_t len, void *arg);
+
+/**
+ * @brief Reassembly state of a stream.
+ */
+typedef struct {
+    uint8_t  buf[DEF_DFU_STREAM_FRAME_MAX]; /**< Partial frame, starts with the marker when not empty */
+    uint16_t used;                          /**< Bytes in buf */
+    uint32_t frames;                        /**< Valid frames delivered */
+    uint32_t checksumErrors;                /**< Frames dropped on a checksum or type error */
+    uint32_t resyncBytes;                   /**< Bytes dropped while searching for a marker */
+} dfu_stream_rx_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Reset the reassembly state and counters.
+ *
+ * @param rx Reassembly state.
+ */
+void dfu_stream_rx_init(dfu_stream_rx_t *rx);
+
+/**
+ * @brief Feed a segment of the stream.
+ *
+ * Every complete, valid request frame is passed to cb in stream order, before the function returns.
+ * The bytes of an incomplete frame are kept until the next segment.
+ *
+ * @param rx   Reassembly state.
+ * @param data Segment.
+ * @param len  Segment length.
+ * @param cb   Frame callback.
+ * @param arg  Callback argument.
+ * @return Number of frames delivered.
+ */
+uint16_t dfu_stream_rx_feed(dfu_stream_rx_t *rx, const uint8_t *data, uint16_t len, dfu_stream_frame_cb_t cb, void *arg);
+
+/**
+ * @brief Build a response frame, same layout as the GATT and UART transports.
+ *
+ * @param out     Output buffer.
+ * @param size    Size of the output buffer.
+ * @param command Command.
+ * @param data    Response data.
+ * @param len     Response data length.
+ * @return Frame length, 0 if the buffer is too small.
+ */
+uint16_t dfu_stream_build_frame(uint8_t *out, uint16_t size, uint16_t command, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Length of the segment starting at an offset of a buffer.
+ *
+ * @param total  Buffer length.
+ * @param offset Offset of the segment.
+ * @param mtu    Largest segment.
+ * @return Segment length, 0 at the end of the buffer or with a zero MTU.
+ */
+uint16_t dfu_stream_tx_segment(uint32_t total, uint32_t offset, uint16_t mtu);
+
+#endif /*__DFU_STREAM_H*/
@@ -51,6 +51,10 @@
 #define DUF_TX_BUF_SIZE 32
 
 #define UART_RX_BUFFER_SIZE 0x100
+
+#ifndef DFU_UART_RX_RINGBUF_ENABLE
+#define DFU_UART_RX_RINGBUF_ENABLE APP_FALSE // Circular SDMA RX: no RX restart between frames
+#endif
 //-------------------------------
 // ENUM SECTION
 //-------------------------------
@@ -109,6 +113,9 @@ uint8_t dfu_uart_cmd_ready_flag = APP_FALSE;
 
 static stUartConfig uartConfig;
 static uint8_t dfu_uart_rxbuf[DUF_RX_BUF_SIZE];
+#if (DFU_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+static uint16_t dfu_uart_frame_len = 0;
+#endif
 
 
 //-------------------------------
@@ -154,7 +161,11 @@ static void dfu_uart_configer(uint8_t role)
         /*SDMA Buffer address.*/
     uartConfig.TXbuffer           = (uint32_t)uart_txbuf;               // Set transmit buffer address
     uartConfig.RXbuffer           = (uint32_t)uart_rxbuf;               // Set receive buffer address
+#if (DFU_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+    cb_uart_ringbuf_init(&uartConfig, UART_RX_BUFFER_SIZE);
+#else
     cb_uart_init(uartConfig);  
+#endif
 
 }
 
@@ -179,6 +190,66 @@ static void dfu_uart_deinit(void)
 }
 
 
+#if (DFU_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+/**
+ * @brief Polls for valid commands in the UART RX ring buffer.
+ *        The function searches the marker byte, waits for the full frame and validates the checksum.
+ *        Bytes of an invalid frame are dropped one at a time to resynchronize on the next marker.
+ */
+static void dfu_uart_pooling_cmd(void)
+{
+    uint16_t available = 0;
+    uint16_t frame_len = 0;
+
+    dfu_uart_cmd_ready_flag = APP_FALSE;
+
+    while (dfu_uart_cmd_ready_flag != APP_TRUE)
+    {
+        available = cb_uart_ringbuf_available(EN_UART_0);
+        if (available == 0)
+        {
+            return;
+        }
+        cb_uart_ringbuf_peek(EN_UART_0, &dfu_uart_rxbuf[0], 0, DEF_RXMARKER_SIZE);
+        if (dfu_uart_rxbuf[DEF_RXMARKER_POS] != DEF_RXMARKER_VAL)
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, 1); //Marker Mismtached
+            continue;
+        }
+        if (available < DEF_HEADER_SIZE)
+        {
+            continue; // Wait for the header
+        }
+        cb_uart_ringbuf_peek(EN_UART_0, &dfu_uart_rxbuf[0], 0, DEF_HEADER_SIZE);
+        frame_len = DEF_HEADER_SIZE + dfu_uart_rxbuf[DEF_DL_POS] + DEF_CHECKSUM_SIZE;
+        if ((frame_len > DUF_RX_BUF_SIZE) || (frame_len > UART_RX_BUFFER_SIZE))
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, 1); // Cannot be a valid frame
+            continue;
+        }
+        if (available < frame_len)
+        {
+            continue; // Wait for data and checksum
+        }
+        cb_uart_ringbuf_peek(EN_UART_0, &dfu_uart_rxbuf[0], 0, frame_len);
+        uint8_t checksun = 0;
+        for (uint16_t i = 1; i < (frame_len - DEF_CHECKSUM_SIZE); i++)
+        {
+            checksun += dfu_uart_rxbuf[i];
+        }
+        if (checksun == dfu_uart_rxbuf[frame_len - DEF_CHECKSUM_SIZE])
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, frame_len);
+            dfu_uart_frame_len = frame_len;
+            dfu_uart_cmd_ready_flag = APP_TRUE;
+        }
+        else
+        {
+            cb_uart_ringbuf_skip(EN_UART_0, 1);
+        }
+    }
+}
+#else
 /**
  * @brief Polls for valid commands in the UART receive buffer using a state machine.
  *        The function waits for a specific marker byte, reads command headers and data, and validates the checksum.
@@ -263,6 +334,7 @@ static void dfu_uart_pooling_cmd(void)
         }
     }
 }
+#endif
 
 /**
  * @brief Process UART receive buffer.
@@ -336,11 +408,17 @@ void dfu_uart_polling(void)
     dfu_uart_pooling_cmd();
     if(dfu_uart_cmd_ready_flag)
     {
+#if (DFU_UART_RX_RINGBUF_ENABLE == APP_TRUE)
+        uint16_t received_length = dfu_uart_frame_len; // Frame already consumed from the ring, RX keeps running
+#else
         uint16_t received_length = cb_uart_check_num_received_bytes(EN_UART_0); 
+#endif
         //command ready to send
         dfu_uart_process_buffer(&dfu_uart_rxbuf[0],received_length);
         memset(dfu_uart_rxbuf, 0, sizeof(dfu_uart_rxbuf));// Reset buffer 
+#if (DFU_UART_RX_RINGBUF_ENABLE != APP_TRUE)
         cb_uart_rx_restart(EN_UART_0);
+#endif
     }
 
 }
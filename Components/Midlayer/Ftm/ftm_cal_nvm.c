@@ -16,6 +16,7 @@
 #include "CB_flash.h"
 #include "CB_system.h"
 #include "CB_crc.h"
+#include "CB_uwbtempcomp.h"
 #include <string.h>
 
 //-------------------------------
@@ -63,6 +64,7 @@ enum calDataPos{
   CAL_POWERCODE_POS,
   CAL_TOFCAL_POS,
   CAL_RANGAOAFREQ_POS,
+  CAL_SSTWRCFO_POS,
 };
 
 struct ftm_cal_nv_data_t{
@@ -75,7 +77,9 @@ struct ftm_cal_nv_data_t{
   uint8_t   freq_offset;
   uint8_t   power_code;
   uint8_t   rngaoa_freq;
-  uint8_t   reserved[23];//32-4-5
+  uint8_t   reserved[3];
+  stCaliSstwrCfo sstwr_cfo;//12, 4-byte aligned
+  uint8_t   reserved0[8];//32-4-5-3-12
     
   uint32_t  reserved1_mark;  
   uint8_t   reserved1[32];
@@ -84,11 +88,16 @@ struct ftm_cal_nv_data_t{
   uint16_t  aoa_idx_mark;
   stCaliAoa aoaCalAry[DEF_MAX_AOA_NUMBER];// 16*8 +4 = 132
  
-  uint8_t   reserved2[48];// 256 -132 - 36 - 36 - 4 = 48
+  uint8_t   tempcomp_idx_mark;
+  uint8_t   reserved2[7];
+  stCaliTempComp tempCompAry[DEF_MAX_TEMPCOMP_NUMBER];// 4*10 + 8 = 48, 256 -132 - 36 - 36 - 4 = 48
 };
 #if ((4*5+8*DEF_MAX_AOA_NUMBER) > 0x100)  //page size
 #error " sizeof(struct ftm_cal_nv_data_t) over 256bytes(page size)"
 #endif
+#if ((8+10*DEF_MAX_TEMPCOMP_NUMBER) > 48)
+#error " temperature compensation table over the 48 reserved bytes"
+#endif
 
 struct ftm_cal_nv_data_t g_cal_nv_data = {0};
 
@@ -433,6 +442,126 @@ enCALReturnCode ftm_cal_nvm_write_aoacal (uint8_t aoaindex,stCaliAoa CalAoa)//in
 }
 
 
+/**
+ * @brief Reads a temperature compensation point from NVM.
+ *
+ * @param[in]  TempCompIndex The index (0-3) of the point to be read.
+ * @param[out] CalTempComp   Pointer to a stCaliTempComp structure where the point will be stored.
+ *
+ * @return enCALReturnCode Returns EN_CAL_OK if the point is successfully read and the
+ *                           calibration data is valid. Returns EN_CAL_FAILED otherwise.
+ */
+enCALReturnCode ftm_cal_nvm_read_tempcomp(uint8_t TempCompIndex, stCaliTempComp* CalTempComp)
+{
+  if(TempCompIndex>=DEF_MAX_TEMPCOMP_NUMBER)
+  {
+    return EN_CAL_FAILED;
+  }
+  if (g_cal_nv_data.crc && (g_cal_nv_data.tempcomp_idx_mark&(1<<TempCompIndex)))
+  {
+    *CalTempComp = g_cal_nv_data.tempCompAry[TempCompIndex];
+    return EN_CAL_OK;
+  }
+  return EN_CAL_FAILED;
+}
+
+/**
+ * @brief Writes a temperature compensation point to NVM.
+ *
+ * @param[in] TempCompIndex The index (0-3) where the point should be stored
+ * @param[in] CalTempComp   The temperature compensation point to be written to NVM
+ *
+ * @return enCALReturnCode Returns EN_CAL_OK if the calibration data is successfully written
+ *                         and verified, or EN_CAL_FAILED if the index is invalid or storage
+ *                         update fails
+ */
+enCALReturnCode ftm_cal_nvm_write_tempcomp(uint8_t TempCompIndex, stCaliTempComp CalTempComp)
+{
+  if(TempCompIndex>=DEF_MAX_TEMPCOMP_NUMBER)
+  {
+    return EN_CAL_FAILED;
+  }
+  memcpy(&g_cal_nv_data.tempCompAry[TempCompIndex],&CalTempComp,sizeof(stCaliTempComp));
+  g_cal_nv_data.tempcomp_idx_mark |= 1<<TempCompIndex;
+  return ftm_cal_nvm_storage_update();
+}
+
+/**
+ * @brief Clears the temperature compensation table in NVM.
+ *
+ * @return enCALReturnCode Returns EN_CAL_OK if the calibration data is successfully written
+ *                         and verified, or EN_CAL_FAILED if the storage update fails
+ */
+enCALReturnCode ftm_cal_nvm_clear_tempcomp(void)
+{
+  memset(&g_cal_nv_data.tempCompAry[0],0,sizeof(g_cal_nv_data.tempCompAry));
+  g_cal_nv_data.tempcomp_idx_mark = 0;
+  return ftm_cal_nvm_storage_update();
+}
+
+/**
+ * @brief Loads the temperature compensation table from NVM into the compensation module.
+ *
+ * @return Returns `EN_CAL_OK` if the table is valid (possibly empty), `EN_CAL_FAILED` otherwise.
+ */
+enCALReturnCode ftm_cal_nvm_load_tempcomp(void)
+{
+  cb_uwbtempcomp_point_st points[DEF_MAX_TEMPCOMP_NUMBER];
+  uint8_t numPoints = 0;
+  stCaliTempComp calTempComp;
+
+  for (uint8_t i = 0; i < DEF_MAX_TEMPCOMP_NUMBER; i++)
+  {
+    if (ftm_cal_nvm_read_tempcomp(i, &calTempComp) == EN_CAL_OK)
+    {
+      points[numPoints].temperature  = (float)calTempComp.Temperature;
+      points[numPoints].rangeBias_cm = (float)calTempComp.CalRangeBias / 100.0f;
+      for (uint8_t pair = 0; pair < EN_UWB_TEMPCOMP_PD_NUM; pair++)
+      {
+        points[numPoints].pdoaBias_deg[pair] = (float)calTempComp.CalPdoa[pair] / 100.0f;
+      }
+      numPoints++;
+    }
+  }
+  return (cb_uwbtempcomp_init(points, numPoints) == CB_PASS) ? EN_CAL_OK : EN_CAL_FAILED;
+}
+
+/**
+ * @brief Reads the SS-TWR cfoEst to clock offset conversion from NVM.
+ *
+ * @param[out] CalSstwrCfo Pointer to a stCaliSstwrCfo structure where the conversion will be stored.
+ *
+ * @return enCALReturnCode Returns EN_CAL_OK if the conversion is successfully read and the
+ *                           calibration data is valid. Returns EN_CAL_FAILED otherwise.
+ */
+enCALReturnCode ftm_cal_nvm_read_sstwr_cfo(stCaliSstwrCfo* CalSstwrCfo)
+{
+  if (g_cal_nv_data.crc && (g_cal_nv_data.cal_mark & (1<<CAL_SSTWRCFO_POS)))
+  {
+    *CalSstwrCfo = g_cal_nv_data.sstwr_cfo;
+    return EN_CAL_OK;
+  }
+  else
+  {
+    return EN_CAL_FAILED;
+  }
+}
+
+/**
+ * @brief Writes the SS-TWR cfoEst to clock offset conversion to NVM.
+ *
+ * @param[in] CalSstwrCfo The conversion fitted against DS-TWR
+ *
+ * @return enCALReturnCode Returns EN_CAL_OK if the calibration data is successfully written
+ *                         and verified, or EN_CAL_FAILED if the storage update fails
+ */
+enCALReturnCode ftm_cal_nvm_write_sstwr_cfo(stCaliSstwrCfo CalSstwrCfo)
+{
+  g_cal_nv_data.sstwr_cfo = CalSstwrCfo;
+  g_cal_nv_data.cal_mark |= (1<<CAL_SSTWRCFO_POS);
+  return ftm_cal_nvm_storage_update();
+}
+
 /**
  * @brief Writes the device role calibration value to NVM.
  *
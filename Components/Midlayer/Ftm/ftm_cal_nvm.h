@@ -12,6 +12,7 @@
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
+#define DEF_MAX_TEMPCOMP_NUMBER                4
 
 
 //-------------------------------
@@ -46,6 +47,33 @@ typedef struct
   int16_t           Calpdoa2; 
 }stCaliAoa;
 
+/**
+ * @struct stCaliTempComp
+ * @brief Structure to hold one temperature compensation point.
+ *
+ * Corrections added to the static ranging bias (tof_cal) and PDoA biases at a chip temperature.
+ */
+typedef struct
+{
+  int8_t            Temperature;      /**< Chip temperature, degrees Celsius */
+  uint8_t           Reserved;
+  int16_t           CalRangeBias;     /**< 1/100 cm, same unit as tof_cal */
+  int16_t           CalPdoa[3];       /**< 1/100 degree, PD01, PD02, PD12 */
+}stCaliTempComp;
+
+/**
+ * @struct stCaliSstwrCfo
+ * @brief Structure to hold the SS-TWR cfoEst to clock offset conversion.
+ *
+ * Fitted against DS-TWR by cb_uwbsstwr_cal_solve(): offset_ppm = PpmPerLsb * signed(cfoEst) + PpmOffset.
+ */
+typedef struct
+{
+  float             PpmPerLsb;
+  float             PpmOffset;
+  float             ResidualPpm;      /**< RMS fit error, ppm */
+}stCaliSstwrCfo;
+
 //-------------------------------
 // GLOBAL VARIABLE SECTION
 //-------------------------------
@@ -66,6 +94,12 @@ enCALReturnCode ftm_cal_nvm_write_freqoffset(uint8_t CalFreOffsetVal);
 enCALReturnCode ftm_cal_nvm_write_powercode(uint8_t CalPowercode);
 enCALReturnCode ftm_cal_nvm_write_tofcal(int16_t CalTof);
 enCALReturnCode ftm_cal_nvm_write_aoacal(uint8_t aoaindex, stCaliAoa CalAoa);
+enCALReturnCode ftm_cal_nvm_read_tempcomp(uint8_t TempCompIndex, stCaliTempComp* CalTempComp);
+enCALReturnCode ftm_cal_nvm_write_tempcomp(uint8_t TempCompIndex, stCaliTempComp CalTempComp);
+enCALReturnCode ftm_cal_nvm_clear_tempcomp(void);
+enCALReturnCode ftm_cal_nvm_load_tempcomp(void);
+enCALReturnCode ftm_cal_nvm_read_sstwr_cfo(stCaliSstwrCfo* CalSstwrCfo);
+enCALReturnCode ftm_cal_nvm_write_sstwr_cfo(stCaliSstwrCfo CalSstwrCfo);
 enCALReturnCode ftm_cal_nvm_write_rngaoa_id(uint32_t DeviceId);
 enCALReturnCode ftm_cal_nvm_read_rngaoa_freq(uint8_t* freq);
 enCALReturnCode ftm_cal_nvm_write_rngaoa_freq(uint8_t freq);
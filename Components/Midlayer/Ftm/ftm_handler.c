@@ -79,6 +79,10 @@ void ftm_write_tof_cal(uint16_t command, uint8_t *buf, uint8_t len);
 void ftm_read_num_of_aoa(uint16_t command, uint8_t *buf, uint8_t len);
 void ftm_read_aoa_cal(uint16_t command, uint8_t *buf, uint8_t len);
 void ftm_write_aoa_cal(uint16_t command, uint8_t *buf, uint8_t len);
+void ftm_read_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len);
+void ftm_write_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len);
+void ftm_capture_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len);
+void ftm_clear_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len);
 void ftm_set_tx_num_of_packet(uint16_t command, uint8_t *buf, uint8_t len);
 void ftm_set_tx_interval(uint16_t command, uint8_t *buf, uint8_t len);
 void ftm_set_tx_on_off(uint16_t command, uint8_t *buf, uint8_t len);
@@ -126,6 +130,10 @@ static const ftCmd ftm_command_table[] =
     {0x0016, ftm_read_num_of_aoa}, 
     {0x0017, ftm_read_aoa_cal}, 
     {0x0018, ftm_write_aoa_cal}, 
+    {0x0019, ftm_read_tempcomp_cal}, 
+    {0x001A, ftm_write_tempcomp_cal}, 
+    {0x001B, ftm_capture_tempcomp_cal}, 
+    {0x001C, ftm_clear_tempcomp_cal}, 
     {0x0030, ftm_set_tx_num_of_packet}, 
     {0x0031, ftm_set_tx_interval}, 
     {0x0032, ftm_set_tx_on_off}, 
@@ -640,6 +648,127 @@ void ftm_write_aoa_cal(uint16_t command, uint8_t *buf, uint8_t len)
   ftm_command_respond(command,&statuscode,respondLen);
 }
 
+/**
+ * @brief Read the temperature compensation point for a specific index Command parser for customer.
+ * 
+ * @param command command ID.
+ * @param buf Pointer to the input data.
+ * @param len The len of input data.
+ */
+void ftm_read_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len)
+{
+  LOG("%s\r\n",__func__);
+  stCaliTempComp tempcomp1;
+  uint8_t index = buf[0];
+  uint8_t statuscode = ftm_cal_nvm_read_tempcomp(index, &tempcomp1);
+  if(statuscode != EN_CAL_OK)
+  {
+    tempcomp1.Temperature = (int8_t)0xff;
+    tempcomp1.CalRangeBias = (int16_t)0xffff;
+    tempcomp1.CalPdoa[0] = (int16_t)0xffff;
+    tempcomp1.CalPdoa[1] = (int16_t)0xffff;
+    tempcomp1.CalPdoa[2] = (int16_t)0xffff;
+  }
+  LOG("ftm_cal_nvm_read_tempcomp return: %d \n", statuscode);
+  LOG("TempCompValue, index: %x, temp: %d, range: %d, pd01: %d, pd02: %d, pd12: %d \n", \
+      index, tempcomp1.Temperature, tempcomp1.CalRangeBias, tempcomp1.CalPdoa[0], tempcomp1.CalPdoa[1], tempcomp1.CalPdoa[2]);
+
+  uint8_t respond[9];
+  respond[0] = (uint8_t)tempcomp1.Temperature;
+  respond[1] = (uint8_t)((uint16_t)tempcomp1.CalRangeBias >> 8);
+  respond[2] = (uint8_t)tempcomp1.CalRangeBias;
+  for (uint8_t pair = 0; pair < 3; pair++)
+  {
+    respond[3 + pair * 2] = (uint8_t)((uint16_t)tempcomp1.CalPdoa[pair] >> 8);
+    respond[4 + pair * 2] = (uint8_t)tempcomp1.CalPdoa[pair];
+  }
+  uint8_t respondLen = sizeof(respond);
+  ftm_command_respond(command,respond,respondLen);
+}
+
+/**
+ * @brief Write the temperature compensation point for a specific index Command parser for customer.
+ * 
+ * @param command command ID.
+ * @param buf Pointer to the input data: index, temperature, range bias, PDoA bias of PD01, PD02, PD12.
+ * @param len The len of input data.
+ */
+void ftm_write_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len)
+{
+  LOG("%s\r\n",__func__);
+
+  if(len != 10)
+  {
+    return;
+  }
+  stCaliTempComp tempcomp1 = {0};
+  uint8_t index = buf[0];
+  tempcomp1.Temperature = (int8_t)buf[1];
+  tempcomp1.CalRangeBias = (int16_t)(buf[2]<<8|buf[3]);
+  tempcomp1.CalPdoa[0] = (int16_t)(buf[4]<<8|buf[5]);
+  tempcomp1.CalPdoa[1] = (int16_t)(buf[6]<<8|buf[7]);
+  tempcomp1.CalPdoa[2] = (int16_t)(buf[8]<<8|buf[9]);
+  uint8_t statuscode = ftm_cal_nvm_write_tempcomp(index, tempcomp1);
+  LOG("ftm_cal_nvm_write_tempcomp return: %d \n", statuscode);
+  if(statuscode == EN_CAL_OK)
+  {
+    statuscode = ftm_cal_nvm_load_tempcomp();
+  }
+
+  uint8_t respondLen = sizeof(statuscode);
+  ftm_command_respond(command,&statuscode,respondLen);
+}
+
+/**
+ * @brief Capture the temperature compensation point for a specific index from the next RNGAOA RX results.
+ * 
+ * @param command command ID.
+ * @param buf Pointer to the input data: index, reference distance (cm), reference PDoA of PD01, PD02, PD12 (1/100 degree).
+ * @param len The len of input data.
+ */
+void ftm_capture_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len)
+{
+  LOG("%s\r\n",__func__);
+
+  if(len != 9)
+  {
+    return;
+  }
+  uint8_t index = buf[0];
+  int16_t refDistance = (int16_t)(buf[1]<<8|buf[2]);
+  int16_t refPdoa[3];
+  refPdoa[0] = (int16_t)(buf[3]<<8|buf[4]);
+  refPdoa[1] = (int16_t)(buf[5]<<8|buf[6]);
+  refPdoa[2] = (int16_t)(buf[7]<<8|buf[8]);
+  uint8_t statuscode = ftm_uwb_cal_tempcomp_capture(index, refDistance, refPdoa);
+  LOG("ftm_uwb_cal_tempcomp_capture return(0:ok, 1:fail): %d \n", statuscode);
+
+  uint8_t respondLen = sizeof(statuscode);
+  ftm_command_respond(command,&statuscode,respondLen);
+}
+
+/**
+ * @brief Clear the temperature compensation table Command parser for customer.
+ * 
+ * @param command command ID.
+ * @param buf Pointer to the input data.
+ * @param len The len of input data.
+ */
+void ftm_clear_tempcomp_cal(uint16_t command, uint8_t *buf, uint8_t len)
+{
+  LOG("%s\r\n",__func__);
+
+  uint8_t statuscode = ftm_cal_nvm_clear_tempcomp();
+  LOG("ftm_cal_nvm_clear_tempcomp return(0:ok, 1:fail): %d \n", statuscode);
+  if(statuscode == EN_CAL_OK)
+  {
+    statuscode = ftm_cal_nvm_load_tempcomp();
+  }
+
+  uint8_t respondLen = sizeof(statuscode);
+  ftm_command_respond(command,&statuscode,respondLen);
+}
+
 
 /**
  * @brief Sets the number of packets for transmission during calibration Command parser for customer.
@@ -9,6 +9,7 @@
 //-------------------------------
 // INCLUDE SECTION
 //-------------------------------
+#include <math.h>
 #include <string.h>
 #include "CB_efuse.h"
 #include "CB_system.h"
@@ -17,6 +18,7 @@
 #include "CB_aoa.h"
 #include "ftm_uwb_cal.h"
 #include "ftm_cal_nvm.h"
+#include "CB_uwbtempcomp.h"
 
 #include "CB_system.h"
 #include "CB_timer.h"
@@ -50,9 +52,11 @@ void ftm_uwb_cal_rngaoa_rx_sequence(void);
 void app_rngaoa_reset(void);
 uint8_t app_rngaoa_validate_sync_payload(void);
 void app_rngaoa_timer_off(void);
+static void ftm_uwb_cal_tempcomp_accumulate(void);
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
+#define DEF_TEMPCOMP_CAPTURE_CYCLES    32   // RNGAOA cycles averaged per temperature compensation point
 
 
 
@@ -91,7 +95,21 @@ static float  s_aziResult = 0.0f;
 static float  s_eleResult = 0.0f;
 static float  last_aziResult = 0.0f;
 static float  last_eleResult = 0.0f;
-static uint32_t distance;
+static int32_t  distance;                           // RNGAOA RX: distance sent by the initiator, 1/100 cm
+static float    s_initiatorRangeBiasTempComp_cm;    // RNGAOA RX: temperature correction in that distance, initiator side
+
+// Temperature compensation point capture, see ftm_uwb_cal_tempcomp_capture()
+static struct
+{
+  uint8_t  active;
+  uint8_t  index;
+  uint8_t  count;
+  int16_t  refDistance;
+  int16_t  refPdoa[EN_UWB_TEMPCOMP_PD_NUM];
+  float    sumTemperature;
+  float    sumRangeBias;
+  float    sumPdoaBias[EN_UWB_TEMPCOMP_PD_NUM];
+} s_stTempCompCapture;
 //-------------------------------
 // FUNCTION BODY SECTION
 //-------------------------------
@@ -577,6 +595,7 @@ typedef struct
 {
   cb_uwbframework_rangingdatacontainer_st   rangingDataContainer;
   cb_uwbframework_pdoadatacontainer_st      pdoaDataContainer;  
+  float                                     rangeBiasTempComp_cm;   // Responder temperature correction, see CB_uwbtempcomp.h
 } app_rngaoa_responderdatacontainer_st;
 
 
@@ -662,6 +681,7 @@ void ftm_uwb_cal_rngaoa_tx_sequence(void)
      distance_bias  = (cal_tof)/100;
      s_stInitiatorDataContainer.dstwrRangingBias = distance_bias;  
   }
+  ftm_cal_nvm_load_tempcomp();
   uint32_t rangAoaId ;
   uint8_t statuscode = ftm_cal_nvm_read_rngaoa_id(&rangAoaId);
   if(statuscode == EN_CAL_OK)
@@ -764,6 +784,7 @@ void ftm_uwb_cal_rngaoa_tx_sequence(void)
       //-------------------------------------        
       case EN_APP_STATE_IDLE:
         // Wait for next cycle
+        cb_uwbtempcomp_poll();
         if (cb_hal_is_time_elapsed(iterationTime, rangaoa_tx_freq))
         {
           s_enAppRngaoaState = EN_APP_STATE_SYNC_TRANSMIT;
@@ -958,9 +979,12 @@ void ftm_uwb_cal_rngaoa_tx_sequence(void)
           if (rxStatus.rx0_ok == CB_TRUE)
           {  
             uint16_t rxPayloadSize = cb_framework_uwb_get_rx_packet_size(&s_stUwbPacketConfig);
-            cb_framework_uwb_get_rx_payload                           ((uint8_t*)(&s_stResponderDataContainer), rxPayloadSize);
+            s_stResponderDataContainer.rangeBiasTempComp_cm = 0.0f;
+            cb_framework_uwb_get_rx_payload                           ((uint8_t*)(&s_stResponderDataContainer), (rxPayloadSize < sizeof(s_stResponderDataContainer)) ? rxPayloadSize : sizeof(s_stResponderDataContainer));
             cb_framework_uwb_calculate_initiator_tround_treply        (&s_stInitiatorDataContainer, s_stTxTsuTimestamp0, s_stTxTsuTimestamp1, s_stRxTsuTimestamp0);
-            s_measuredDistance = cb_framework_uwb_calculate_distance  (s_stInitiatorDataContainer, s_stResponderDataContainer.rangingDataContainer);
+            s_stInitiatorDataContainer.dstwrRangingBias = distance_bias;
+            s_measuredDistance = cb_framework_uwb_calculate_distance  (s_stInitiatorDataContainer, s_stResponderDataContainer.rangingDataContainer)
+                               + cb_uwbtempcomp_get_range_bias_cm() + s_stResponderDataContainer.rangeBiasTempComp_cm;
           }
           cb_framework_uwb_rx_end(EN_UWB_RX_0);
           s_enAppRngaoaState = EN_APP_STATE_DISTANCE_WAIT_TX_DONE;
@@ -969,12 +993,16 @@ void ftm_uwb_cal_rngaoa_tx_sequence(void)
         
       case EN_APP_STATE_DISTANCE_WAIT_TX_DONE:
         {
-           uint32_t dis = (uint32_t)s_measuredDistance;
-           uint8_t dis_buff[4];
+           // Distance and initiator temperature correction, 1/100 cm
+           uint32_t dis = (uint32_t)(int32_t)lround(s_measuredDistance * 100.0);
+           uint16_t tempComp = (uint16_t)(int16_t)lroundf(cb_uwbtempcomp_get_range_bias_cm() * 100.0f);
+           uint8_t dis_buff[6];
            dis_buff[0] = (dis >> 24) & 0xff;
            dis_buff[1] = (dis >> 16) & 0xff; 
            dis_buff[2] = (dis >> 8) & 0xff; 
            dis_buff[3] = dis & 0xff; 
+           dis_buff[4] = (tempComp >> 8) & 0xff;
+           dis_buff[5] = tempComp & 0xff;
            cb_uwbsystem_txpayload_st  dis_payload;
            dis_payload.ptrAddress = &dis_buff[0];
            dis_payload.payloadSize = sizeof(dis_buff);
@@ -1069,6 +1097,7 @@ void ftm_uwb_cal_rngaoa_rx_sequence(void)
      distance_bias  = (cal_tof)/100;
      s_stResponderDataContainer.rangingDataContainer.dstwrRangingBias = distance_bias;  
   }
+  ftm_cal_nvm_load_tempcomp();
   uint32_t rangAoaId ;
   uint8_t statuscode = ftm_cal_nvm_read_rngaoa_id(&rangAoaId);
   if(EN_CAL_OK == statuscode)
@@ -1175,6 +1204,7 @@ void ftm_uwb_cal_rngaoa_rx_sequence(void)
       // IDLE
       //-------------------------------------         
         // Wait for next cycle
+        cb_uwbtempcomp_poll();
         if (cb_hal_is_time_elapsed(iterationTime, rangaoa_rx_freq))
         {
           s_enAppRngaoaState = EN_APP_STATE_SYNC_RECEIVE;
@@ -1395,7 +1425,11 @@ void ftm_uwb_cal_rngaoa_rx_sequence(void)
         else
            cb_framework_uwb_pdoa_calculate_result(&s_stPdoaOutputResult,EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);        
         // AOA
-        cb_framework_uwb_pdoa_calculate_aoa(s_stPdoaOutputResult.median, s_pd01Bias, s_pd02Bias, s_pd12Bias, &s_aziResult, &s_eleResult);
+        cb_framework_uwb_pdoa_calculate_aoa(s_stPdoaOutputResult.median,
+                                            s_pd01Bias + cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD01),
+                                            s_pd02Bias + cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD02),
+                                            s_pd12Bias + cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD12),
+                                            &s_aziResult, &s_eleResult);
           
         last_aziResult = s_aziResult;
         last_eleResult = s_eleResult;
@@ -1411,6 +1445,8 @@ void ftm_uwb_cal_rngaoa_rx_sequence(void)
         if (cb_hal_is_time_elapsed(startTime, DEF_RNGAOA_RESULT_WAIT_TIME_MS))
         {
           cb_framework_uwb_calculate_responder_tround_treply(&s_stResponderDataContainer.rangingDataContainer, s_stTxTsuTimestamp0, s_stRxTsuTimestamp0, rxTsuTimestamp1);
+          s_stResponderDataContainer.rangingDataContainer.dstwrRangingBias = distance_bias;
+          s_stResponderDataContainer.rangeBiasTempComp_cm = cb_uwbtempcomp_get_range_bias_cm();
           s_stResponderDataContainer.pdoaDataContainer.rx0_rx1      = s_stPdoaOutputResult.median.rx0_rx1;
           s_stResponderDataContainer.pdoaDataContainer.rx0_rx2      = s_stPdoaOutputResult.median.rx0_rx2;
           s_stResponderDataContainer.pdoaDataContainer.rx1_rx2      = s_stPdoaOutputResult.median.rx1_rx2;
@@ -1445,9 +1481,10 @@ void ftm_uwb_cal_rngaoa_rx_sequence(void)
                uint8_t payload[10];
                s_stIrqStatus.Rx0Done = APP_FALSE;
                uint16_t rxPayloadSize = cb_framework_uwb_get_rx_packet_size(&s_stUwbPacketConfig);
-               cb_framework_uwb_get_rx_payload(payload, rxPayloadSize);
-               distance = payload[0] << 24 | payload[1] << 16 | payload[2]<< 8| payload[3];
-               
+               cb_framework_uwb_get_rx_payload(payload, (rxPayloadSize < sizeof(payload)) ? rxPayloadSize : sizeof(payload));
+               distance = (int32_t)((uint32_t)payload[0] << 24 | (uint32_t)payload[1] << 16 | (uint32_t)payload[2] << 8 | payload[3]);
+               s_initiatorRangeBiasTempComp_cm = (float)(int16_t)((uint16_t)payload[4] << 8 | payload[5]) / 100.0f;
+               ftm_uwb_cal_tempcomp_accumulate();
            }
            cb_framework_uwb_rx_end(EN_UWB_RX_0);
            s_enAppRngaoaState = EN_APP_STATE_TERMINATE;
@@ -1640,7 +1677,7 @@ enCALReturnCode ftm_uwb_cal_set_rngaoa_rx_onoff(enSwtich status)
 enCALReturnCode ftm_uwb_cal_get_rngaoa_rx_resulf(stRNGAOARx* stRNGAOARxDataContainer)
 {
     
-  stRNGAOARxDataContainer->dis = (distance*100);
+  stRNGAOARxDataContainer->dis = (int16_t)distance;
   stRNGAOARxDataContainer->aoah = (int16_t)last_aziResult;
   stRNGAOARxDataContainer->aoav = (int16_t)last_eleResult;
   stRNGAOARxDataContainer->pdoah = 0;
@@ -1653,6 +1690,86 @@ enCALReturnCode ftm_uwb_cal_get_rngaoa_rx_resulf(stRNGAOARx* stRNGAOARxDataConta
 }
 
 
+/**
+ * @brief Starts the capture of a temperature compensation point.
+ *
+ * The device runs RNGAOA RX (responder) on a fixture at a known distance and angle, at a stable
+ * temperature. The next DEF_TEMPCOMP_CAPTURE_CYCLES results are compared with the references:
+ * the corrections that bring them onto the references on top of the static calibration (tof_cal,
+ * AoA biases) are averaged and written to NVM at the given index, then the table is reloaded.
+ * A point at the static calibration temperature should give corrections close to zero.
+ *
+ * @param index       Table index (0-3).
+ * @param refDistance Fixture distance, in cm.
+ * @param refPdoa     Expected PDoA of PD01, PD02, PD12 after bias compensation, in 1/100 degree.
+ * @return Returns `EN_CAL_OK` if the capture is started, `EN_CAL_FAILED` if the index is invalid.
+ */
+enCALReturnCode ftm_uwb_cal_tempcomp_capture(uint8_t index, int16_t refDistance, const int16_t *refPdoa)
+{
+  if (index >= DEF_MAX_TEMPCOMP_NUMBER)
+  {
+    return EN_CAL_FAILED;
+  }
+  memset(&s_stTempCompCapture, 0, sizeof(s_stTempCompCapture));
+  s_stTempCompCapture.index       = index;
+  s_stTempCompCapture.refDistance = refDistance;
+  for (uint8_t pair = 0; pair < EN_UWB_TEMPCOMP_PD_NUM; pair++)
+  {
+    s_stTempCompCapture.refPdoa[pair] = refPdoa[pair];
+  }
+  s_stTempCompCapture.active      = APP_TRUE;
+  return EN_CAL_OK;
+}
+
+/**
+ * @brief Adds the last RNGAOA RX result to the temperature compensation capture.
+ *
+ * Called once the distance of the cycle is received, the PDoA median of the cycle is still valid.
+ */
+static void ftm_uwb_cal_tempcomp_accumulate(void)
+{
+  if (s_stTempCompCapture.active != APP_TRUE)
+  {
+    return;
+  }
+
+  double median[EN_UWB_TEMPCOMP_PD_NUM] = {s_stPdoaOutputResult.median.rx0_rx1, s_stPdoaOutputResult.median.rx0_rx2, s_stPdoaOutputResult.median.rx1_rx2};
+  float  staticBias[EN_UWB_TEMPCOMP_PD_NUM] = {s_pd01Bias, s_pd02Bias, s_pd12Bias};
+
+  // Distance was measured with the corrections of both devices in use (CB_uwbtempcomp.h), remove them:
+  // the point is the bias of this device on top of the static calibration, against an initiator kept
+  // at its calibration temperature
+  float staticDistance = ((float)distance / 100.0f) - s_initiatorRangeBiasTempComp_cm - s_stResponderDataContainer.rangeBiasTempComp_cm;
+  s_stTempCompCapture.sumRangeBias   += (float)s_stTempCompCapture.refDistance - staticDistance;
+  s_stTempCompCapture.sumTemperature += cb_system_get_chip_temperature();
+  for (uint8_t pair = 0; pair < EN_UWB_TEMPCOMP_PD_NUM; pair++)
+  {
+    // Bias convention of cb_framework_uwb_pdoa_calculate_aoa(): compensated = measured - bias
+    float bias = (float)median[pair] - ((float)s_stTempCompCapture.refPdoa[pair] / 100.0f) - staticBias[pair];
+    bias = fmodf(bias + 540.0f, 360.0f) - 180.0f;
+    s_stTempCompCapture.sumPdoaBias[pair] += bias;
+  }
+
+  if (++s_stTempCompCapture.count < DEF_TEMPCOMP_CAPTURE_CYCLES)
+  {
+    return;
+  }
+
+  stCaliTempComp calTempComp = {0};
+  calTempComp.Temperature  = (int8_t)lroundf(s_stTempCompCapture.sumTemperature / DEF_TEMPCOMP_CAPTURE_CYCLES);
+  calTempComp.CalRangeBias = (int16_t)lroundf(s_stTempCompCapture.sumRangeBias * 100.0f / DEF_TEMPCOMP_CAPTURE_CYCLES);
+  for (uint8_t pair = 0; pair < EN_UWB_TEMPCOMP_PD_NUM; pair++)
+  {
+    calTempComp.CalPdoa[pair] = (int16_t)lroundf(s_stTempCompCapture.sumPdoaBias[pair] * 100.0f / DEF_TEMPCOMP_CAPTURE_CYCLES);
+  }
+  s_stTempCompCapture.active = APP_FALSE;
+
+  uint8_t statuscode = ftm_cal_nvm_write_tempcomp(s_stTempCompCapture.index, calTempComp);
+  LOG("TempComp[%d] T:%d, range:%d, pd01:%d, pd02:%d, pd12:%d, status:%d\n", s_stTempCompCapture.index, calTempComp.Temperature,
+      calTempComp.CalRangeBias, calTempComp.CalPdoa[0], calTempComp.CalPdoa[1], calTempComp.CalPdoa[2], statuscode);
+  ftm_cal_nvm_load_tempcomp();
+}
+
 uint8_t app_rngaoa_validate_sync_ack_payload(void)
 {
   uint8_t  result = APP_TRUE;
@@ -100,6 +100,7 @@ enCALReturnCode ftm_uwb_cal_set_rngaoa_tx_onoff(enSwtich status);
 enCALReturnCode ftm_uwb_cal_set_rngaoa_rx_channel(enCALRxChannel RxChannel);
 enCALReturnCode ftm_uwb_cal_set_rngaoa_rx_onoff(enSwtich status);
 enCALReturnCode ftm_uwb_cal_get_rngaoa_rx_resulf(stRNGAOARx* stRNGAOARxDataContainer);
+enCALReturnCode ftm_uwb_cal_tempcomp_capture(uint8_t index, int16_t refDistance, const int16_t *refPdoa);
 
 void ftm_uwb_cal_periodic_tx(void);
 void ftm_uwb_cal_periodic_tx_Stop(void);
@@ -0,0 +1,738 @@
+/**
+ * @file    CB_radar.c
+ * @brief   UWB radar range-Doppler processing.
+ * @details Accumulates slow-time CIR frames, removes static clutter, runs the Doppler FFT per range bin
+ *          through cb_framework_fft() and extracts detections with a CA-CFAR on the power map.
+ *          The FFT buffer holds interleaved complex samples (real, imaginary), as expected by cb_framework_fft().
+ *          With fixedPointFft the Doppler FFT runs in Q15 with block-floating-point scaling (cb_radar_fft_q15()).
+ *          With DEF_RADAR_DOPPLER_ENABLE set to CB_FALSE (default) this file is empty.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "CB_radar.h"
+#include "CB_uwbframework.h"
+
+#if (DEF_RADAR_DOPPLER_ENABLE == CB_TRUE)
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_RADAR_PI                3.14159265f
+#define DEF_RADAR_FFT_MIN_LEN       16
+#define DEF_RADAR_Q15_MAX           32767
+#define DEF_RADAR_Q15_NORM_LEVEL    0x2000  // Input normalized to [0x2000, 0x3FFF]
+#define DEF_RADAR_Q15_STAGE_LIMIT   13573   // 32767 / (1 + sqrt(2)): max radix-2 butterfly growth per component
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Radar processing state.
+ */
+typedef struct
+{
+  cb_radar_config_st  config;
+  uint16_t            numChirps;         /**< Doppler FFT length */
+  uint16_t            chirpCount;        /**< Frames accumulated in the matrix */
+  uint16_t            processedBins;     /**< Range bins already through the Doppler FFT */
+  cb_radar_status_en  status;
+  uint32_t            processCycles;     /**< Cycles of the map being processed */
+} cb_radar_state_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static cb_radar_state_st              s_stRadar;
+static cb_radar_result_st             s_stRadarResult;
+static cb_uwbsystem_rx_cir_iqdata_st  s_radarMatrix[DEF_RADAR_MAX_RANGE_BINS][DEF_RADAR_MAX_CHIRPS];  // range x chirp
+static float                          s_radarPowerMap[DEF_RADAR_MAX_RANGE_BINS][DEF_RADAR_MAX_CHIRPS];
+static float                          s_radarFftBuf[2 * DEF_RADAR_MAX_CHIRPS];
+static float                          s_radarWindow[DEF_RADAR_MAX_CHIRPS];
+static cb_uwbsystem_rx_cir_iqdata_st  s_radarCirFrame[DEF_RADAR_MAX_CIR_SAMPLES];
+static int16_t                        s_radarFftBufQ15[2 * DEF_RADAR_MAX_CHIRPS];
+static int16_t                        s_radarWindowQ15[DEF_RADAR_MAX_CHIRPS];
+static int16_t                        s_radarTwiddleQ15[DEF_RADAR_Q15_FFT_MAX_LEN];  // (cos, -sin) for k < MAX_LEN / 2
+static uint8_t                        s_radarTwiddleReady = CB_FALSE;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void cb_radar_doppler_fft(uint16_t rangeBin);
+static void cb_radar_doppler_fft_q15(uint16_t rangeBin);
+static void cb_radar_twiddle_init_q15(void);
+static void cb_radar_cfar(void);
+static void cb_radar_add_detection(uint16_t rangeBin, uint16_t dopplerBin, float power, float noise);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Initialize the radar processing with the given configuration.
+ *
+ * @param config Processing configuration.
+ * @return CB_PASS on success, CB_FAIL if the configuration exceeds the compile-time limits.
+ */
+CB_STATUS cb_radar_init(const cb_radar_config_st *config)
+{
+  if (config == NULL)
+  {
+    return CB_FAIL;
+  }
+
+  uint16_t numChirps = (uint16_t)(DEF_RADAR_FFT_MIN_LEN << config->dopplerFftLen);
+  if ((config->numRangeBins == 0) || (config->numRangeBins > DEF_RADAR_MAX_RANGE_BINS) ||
+      ((config->firstRangeBin + config->numRangeBins) > DEF_RADAR_MAX_CIR_SAMPLES) ||
+      (numChirps > DEF_RADAR_MAX_CHIRPS))
+  {
+    return CB_FAIL;
+  }
+
+  memset(&s_stRadar, 0, sizeof(s_stRadar));
+  memset(&s_stRadarResult, 0, sizeof(s_stRadarResult));
+  s_stRadar.config    = *config;
+  s_stRadar.numChirps = numChirps;
+
+  // Hann window along slow time, limits the Doppler leakage of strong targets into the CFAR training cells
+  for (uint16_t n = 0; n < numChirps; n++)
+  {
+    s_radarWindow[n] = 0.5f - 0.5f * cosf((2.0f * DEF_RADAR_PI * n) / numChirps);
+  }
+  if (config->fixedPointFft == CB_TRUE)
+  {
+    if (numChirps > DEF_RADAR_Q15_FFT_MAX_LEN)
+    {
+      return CB_FAIL;
+    }
+    cb_radar_hann_q15(s_radarWindowQ15, numChirps);
+  }
+
+  s_stRadar.status = EN_RADAR_STATUS_ACCUMULATING;
+  return CB_PASS;
+}
+
+/**
+ * @brief Restart the accumulation of slow-time frames.
+ */
+void cb_radar_reset(void)
+{
+  if (s_stRadar.status == EN_RADAR_STATUS_IDLE)
+  {
+    return;
+  }
+  s_stRadar.chirpCount    = 0;
+  s_stRadar.processedBins = 0;
+  s_stRadar.processCycles = 0;
+  s_stRadar.status        = EN_RADAR_STATUS_ACCUMULATING;
+}
+
+/**
+ * @brief Add one slow-time CIR frame to the range x chirp matrix.
+ *
+ * @param cir CIR samples starting at CIR sample 0.
+ * @return EN_RADAR_STATUS_ACCUMULATING while frames are missing, EN_RADAR_STATUS_PROCESSING once the matrix is full.
+ */
+cb_radar_status_en cb_radar_push_frame(const cb_uwbsystem_rx_cir_iqdata_st *cir)
+{
+  if ((cir == NULL) || (s_stRadar.status == EN_RADAR_STATUS_IDLE))
+  {
+    return s_stRadar.status;
+  }
+  if (s_stRadar.status == EN_RADAR_STATUS_DONE)
+  {
+    cb_radar_reset(); // Previous result stays readable until the next map completes
+  }
+  if (s_stRadar.status != EN_RADAR_STATUS_ACCUMULATING)
+  {
+    return s_stRadar.status; // Matrix full, frame dropped
+  }
+
+  const cb_uwbsystem_rx_cir_iqdata_st *src = &cir[s_stRadar.config.firstRangeBin];
+  for (uint16_t r = 0; r < s_stRadar.config.numRangeBins; r++)
+  {
+    s_radarMatrix[r][s_stRadar.chirpCount] = src[r];
+  }
+
+  if (++s_stRadar.chirpCount >= s_stRadar.numChirps)
+  {
+    s_stRadar.status = EN_RADAR_STATUS_PROCESSING;
+  }
+  return s_stRadar.status;
+}
+
+/**
+ * @brief Read one CIR frame from the radar receiver and add it to the matrix.
+ *
+ * @param enRxPort UWB receiver port to read.
+ * @return Same as cb_radar_push_frame().
+ */
+cb_radar_status_en cb_radar_acquire_frame(cb_uwbsystem_rxport_en enRxPort)
+{
+  if (s_stRadar.status == EN_RADAR_STATUS_IDLE)
+  {
+    return s_stRadar.status;
+  }
+  cb_framework_radar_getcir(s_radarCirFrame, enRxPort, s_stRadar.config.firstRangeBin + s_stRadar.config.numRangeBins);
+  return cb_radar_push_frame(s_radarCirFrame);
+}
+
+/**
+ * @brief Run the range-Doppler processing in bounded steps.
+ *
+ * @param maxRangeBins Max range bins processed by this call, 0 for the whole map.
+ * @return EN_RADAR_STATUS_PROCESSING while range bins are left, EN_RADAR_STATUS_DONE when the result is available.
+ */
+cb_radar_status_en cb_radar_process(uint16_t maxRangeBins)
+{
+  if (s_stRadar.status != EN_RADAR_STATUS_PROCESSING)
+  {
+    return s_stRadar.status;
+  }
+
+  uint32_t startCycle = DWT->CYCCNT;
+  uint16_t lastBin    = s_stRadar.config.numRangeBins;
+
+  if ((maxRangeBins != 0) && ((s_stRadar.processedBins + maxRangeBins) < lastBin))
+  {
+    lastBin = s_stRadar.processedBins + maxRangeBins;
+  }
+  while (s_stRadar.processedBins < lastBin)
+  {
+    if (s_stRadar.config.fixedPointFft == CB_TRUE)
+    {
+      cb_radar_doppler_fft_q15(s_stRadar.processedBins++);
+    }
+    else
+    {
+      cb_radar_doppler_fft(s_stRadar.processedBins++);
+    }
+  }
+  if (s_stRadar.processedBins >= s_stRadar.config.numRangeBins)
+  {
+    cb_radar_cfar();
+  }
+
+  s_stRadar.processCycles += DWT->CYCCNT - startCycle;
+  if (s_stRadar.processedBins >= s_stRadar.config.numRangeBins)
+  {
+    s_stRadarResult.processCycles = s_stRadar.processCycles;
+    s_stRadar.status              = EN_RADAR_STATUS_DONE;
+  }
+  return s_stRadar.status;
+}
+
+/**
+ * @brief Get the current processing state.
+ *
+ * @return Processing state.
+ */
+cb_radar_status_en cb_radar_get_status(void)
+{
+  return s_stRadar.status;
+}
+
+/**
+ * @brief Get the result of the last completed map.
+ *
+ * @return Pointer to the result.
+ */
+const cb_radar_result_st* cb_radar_get_result(void)
+{
+  return &s_stRadarResult;
+}
+
+/**
+ * @brief Get the range-Doppler power map of the last completed map.
+ *
+ * @return Pointer to the power map.
+ */
+const float* cb_radar_get_power_map(void)
+{
+  return &s_radarPowerMap[0][0];
+}
+
+/**
+ * @brief Clutter removal, windowing and Doppler FFT of one range bin, result stored as power.
+ *
+ * @param rangeBin Range bin index.
+ */
+static void cb_radar_doppler_fft(uint16_t rangeBin)
+{
+  const cb_uwbsystem_rx_cir_iqdata_st *slowTime = s_radarMatrix[rangeBin];
+  uint16_t numChirps = s_stRadar.numChirps;
+  float    meanI     = 0.0f;
+  float    meanQ     = 0.0f;
+
+  if (s_stRadar.config.clutterRemoval == CB_TRUE)
+  {
+    int32_t sumI = 0;
+    int32_t sumQ = 0;
+    for (uint16_t n = 0; n < numChirps; n++)
+    {
+      sumI += slowTime[n].I_data;
+      sumQ += slowTime[n].Q_data;
+    }
+    meanI = (float)sumI / numChirps;
+    meanQ = (float)sumQ / numChirps;
+  }
+
+  for (uint16_t n = 0; n < numChirps; n++)
+  {
+    s_radarFftBuf[2 * n]     = ((float)slowTime[n].I_data - meanI) * s_radarWindow[n];
+    s_radarFftBuf[2 * n + 1] = ((float)slowTime[n].Q_data - meanQ) * s_radarWindow[n];
+  }
+
+  cb_framework_fft(s_stRadar.config.dopplerFftLen, s_radarFftBuf, 0, 1);
+
+  for (uint16_t k = 0; k < numChirps; k++)
+  {
+    float re = s_radarFftBuf[2 * k];
+    float im = s_radarFftBuf[2 * k + 1];
+    s_radarPowerMap[rangeBin][k] = re * re + im * im;
+  }
+}
+
+/**
+ * @brief Fixed-point clutter removal, windowing and Doppler FFT of one range bin, result stored as power.
+ *        Works on 4 bytes per chirp instead of the 8 bytes of the float path.
+ *
+ * @param rangeBin Range bin index.
+ */
+static void cb_radar_doppler_fft_q15(uint16_t rangeBin)
+{
+  const cb_uwbsystem_rx_cir_iqdata_st *slowTime = s_radarMatrix[rangeBin];
+  uint16_t numChirps = s_stRadar.numChirps;
+  int32_t  meanI     = 0;
+  int32_t  meanQ     = 0;
+  int8_t   exponent  = 0;
+
+  if (s_stRadar.config.clutterRemoval == CB_TRUE)
+  {
+    for (uint16_t n = 0; n < numChirps; n++)
+    {
+      meanI += slowTime[n].I_data;
+      meanQ += slowTime[n].Q_data;
+    }
+    meanI /= numChirps;
+    meanQ /= numChirps;
+  }
+
+  // Mean removal can need 17 bits: keep one bit of headroom, given back through the exponent
+  for (uint16_t n = 0; n < numChirps; n++)
+  {
+    s_radarFftBufQ15[2 * n]     = (int16_t)((slowTime[n].I_data - meanI) >> 1);
+    s_radarFftBufQ15[2 * n + 1] = (int16_t)((slowTime[n].Q_data - meanQ) >> 1);
+  }
+  cb_radar_window_q15(s_radarFftBufQ15, s_radarWindowQ15, numChirps);
+  cb_radar_fft_q15(s_stRadar.config.dopplerFftLen, s_radarFftBufQ15, &exponent);
+
+  for (uint16_t k = 0; k < numChirps; k++)
+  {
+    int32_t re = s_radarFftBufQ15[2 * k];
+    int32_t im = s_radarFftBufQ15[2 * k + 1];
+    // Each square is at most 2^30, their sum (2^31 for -32768, -32768) only fits unsigned
+    s_radarPowerMap[rangeBin][k] = ldexpf((float)((uint32_t)(re * re) + (uint32_t)(im * im)), 2 * (exponent + 1));
+  }
+}
+
+/**
+ * @brief Fill the Q15 twiddle table for DEF_RADAR_Q15_FFT_MAX_LEN, shorter FFTs use a stride.
+ */
+static void cb_radar_twiddle_init_q15(void)
+{
+  for (uint16_t k = 0; k < (DEF_RADAR_Q15_FFT_MAX_LEN / 2); k++)
+  {
+    float angle = (2.0f * DEF_RADAR_PI * k) / DEF_RADAR_Q15_FFT_MAX_LEN;
+    s_radarTwiddleQ15[2 * k]     = (int16_t)lrintf(DEF_RADAR_Q15_MAX * cosf(angle));
+    s_radarTwiddleQ15[2 * k + 1] = (int16_t)lrintf(-DEF_RADAR_Q15_MAX * sinf(angle));
+  }
+  s_radarTwiddleReady = CB_TRUE;
+}
+
+/**
+ * @brief In-place Q15 complex FFT with block-floating-point scaling.
+ *
+ * @param fftLen   FFT length, up to DEF_RADAR_Q15_FFT_MAX_LEN.
+ * @param pSrc     Interleaved complex samples, 2 * length int16.
+ * @param exponent Block exponent of the output.
+ * @return CB_PASS on success, CB_FAIL if the length is not supported.
+ */
+CB_STATUS cb_radar_fft_q15(cb_uwbradar_en fftLen, int16_t *pSrc, int8_t *exponent)
+{
+  uint16_t numPoints = (uint16_t)(DEF_RADAR_FFT_MIN_LEN << fftLen);
+  int8_t   blockExp  = 0;
+  int32_t  maxAbs    = 0;
+
+  if ((pSrc == NULL) || (exponent == NULL) || (numPoints > DEF_RADAR_Q15_FFT_MAX_LEN))
+  {
+    return CB_FAIL;
+  }
+  if (s_radarTwiddleReady == CB_FALSE)
+  {
+    cb_radar_twiddle_init_q15();
+  }
+
+  //------------------------
+  // Bit reversal, one 32-bit word per complex sample
+  //------------------------
+  uint32_t *pWord = (uint32_t *)pSrc;
+  for (uint16_t i = 1, j = 0; i < numPoints; i++)
+  {
+    uint16_t bit = numPoints >> 1;
+    for (; j & bit; bit >>= 1)
+    {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j)
+    {
+      uint32_t tmp = pWord[i];
+      pWord[i]     = pWord[j];
+      pWord[j]     = tmp;
+    }
+  }
+
+  //------------------------
+  // Normalize small inputs to the full range: keeps the quantization noise away from weak targets
+  //------------------------
+  for (uint16_t i = 0; i < (2 * numPoints); i++)
+  {
+    int32_t v = (pSrc[i] < 0) ? -pSrc[i] : pSrc[i];
+    maxAbs    = (v > maxAbs) ? v : maxAbs;
+  }
+  if (maxAbs == 0)
+  {
+    *exponent = 0;
+    return CB_PASS;
+  }
+  uint8_t upShift = 0;
+  while ((maxAbs << (upShift + 1)) < (2 * DEF_RADAR_Q15_NORM_LEVEL))
+  {
+    upShift++;
+  }
+  if (upShift > 0)
+  {
+    for (uint16_t i = 0; i < (2 * numPoints); i++)
+    {
+      pSrc[i] = (int16_t)(pSrc[i] * (1 << upShift));   // Multiply: left shift of a negative sample is undefined
+    }
+    maxAbs  <<= upShift;
+    blockExp -= (int8_t)upShift;
+  }
+
+  //------------------------
+  // Radix-2 stages, each scaled down only when its growth could overflow
+  //------------------------
+  for (uint16_t len = 2; len <= numPoints; len <<= 1)
+  {
+    uint8_t  shift  = 0;
+    uint16_t half   = len >> 1;
+    uint16_t stride = DEF_RADAR_Q15_FFT_MAX_LEN / len;
+    int32_t  nextMax = 0;
+
+    while ((maxAbs >> shift) > DEF_RADAR_Q15_STAGE_LIMIT)
+    {
+      shift++;
+    }
+    blockExp += (int8_t)shift;
+
+    for (uint16_t start = 0; start < numPoints; start += len)
+    {
+      for (uint16_t k = 0; k < half; k++)
+      {
+        int16_t *a  = &pSrc[2 * (start + k)];
+        int16_t *b  = &pSrc[2 * (start + k + half)];
+        int32_t  wr = s_radarTwiddleQ15[2 * k * stride];
+        int32_t  wi = s_radarTwiddleQ15[2 * k * stride + 1];
+        int32_t  ar = a[0] >> shift;
+        int32_t  ai = a[1] >> shift;
+        int32_t  br = b[0] >> shift;
+        int32_t  bi = b[1] >> shift;
+        int32_t  tr = (wr * br - wi * bi + 0x4000) >> 15;
+        int32_t  ti = (wr * bi + wi * br + 0x4000) >> 15;
+
+        a[0] = (int16_t)(ar + tr);
+        a[1] = (int16_t)(ai + ti);
+        b[0] = (int16_t)(ar - tr);
+        b[1] = (int16_t)(ai - ti);
+
+        int32_t m0 = (a[0] < 0) ? -a[0] : a[0];
+        int32_t m1 = (a[1] < 0) ? -a[1] : a[1];
+        int32_t m2 = (b[0] < 0) ? -b[0] : b[0];
+        int32_t m3 = (b[1] < 0) ? -b[1] : b[1];
+        m0 = (m1 > m0) ? m1 : m0;
+        m2 = (m3 > m2) ? m3 : m2;
+        m0 = (m2 > m0) ? m2 : m0;
+        nextMax = (m0 > nextMax) ? m0 : nextMax;
+      }
+    }
+    maxAbs = nextMax;
+  }
+
+  *exponent = blockExp;
+  return CB_PASS;
+}
+
+/**
+ * @brief Apply a Q15 window to interleaved int16 complex samples, in place.
+ *
+ * @param pSrc      Interleaved complex samples.
+ * @param pWindow   Q15 window, one coefficient per complex sample.
+ * @param numPoints Number of complex samples.
+ */
+void cb_radar_window_q15(int16_t *pSrc, const int16_t *pWindow, uint16_t numPoints)
+{
+  for (uint16_t n = 0; n < numPoints; n++)
+  {
+    int32_t w = pWindow[n];
+    pSrc[2 * n]     = (int16_t)((pSrc[2 * n] * w + 0x4000) >> 15);
+    pSrc[2 * n + 1] = (int16_t)((pSrc[2 * n + 1] * w + 0x4000) >> 15);
+  }
+}
+
+/**
+ * @brief Fill a Q15 Hann window.
+ *
+ * @param pWindow   Destination.
+ * @param numPoints Window length.
+ */
+void cb_radar_hann_q15(int16_t *pWindow, uint16_t numPoints)
+{
+  for (uint16_t n = 0; n < numPoints; n++)
+  {
+    pWindow[n] = (int16_t)lrintf(DEF_RADAR_Q15_MAX * (0.5f - 0.5f * cosf((2.0f * DEF_RADAR_PI * n) / numPoints)));
+  }
+}
+
+/**
+ * @brief Magnitude squared of a Q15 FFT output.
+ *
+ * @param pSrc      FFT output of cb_radar_fft_q15().
+ * @param pDst      Power per bin.
+ * @param numPoints FFT length.
+ * @param swappedIQ CB_TRUE if the FFT input was in (Q, I) order.
+ */
+void cb_radar_mag_squared_q15(const int16_t *pSrc, uint32_t *pDst, uint16_t numPoints, uint8_t swappedIQ)
+{
+  // FFT(Q + jI) = j * FFT(conj(I + jQ)): same magnitude, frequency axis reversed
+  for (uint16_t k = 0; k < numPoints; k++)
+  {
+    uint16_t src = ((swappedIQ == CB_TRUE) && (k != 0)) ? (numPoints - k) : k;
+    int32_t  re  = pSrc[2 * src];
+    int32_t  im  = pSrc[2 * src + 1];
+    pDst[k] = (uint32_t)(re * re) + (uint32_t)(im * im);   // Up to 2^31: the sum is done in uint32
+  }
+}
+
+#if (DEF_RADAR_FFT_BENCHMARK_ENABLE == CB_TRUE)
+/**
+ * @brief Tone peak over the strongest bin outside the main lobe, in dB.
+ */
+static float cb_radar_benchmark_dynamic_range(const float *power, uint16_t numPoints, uint16_t toneBin)
+{
+  float spur = 0.0f;
+  for (uint16_t k = 0; k < numPoints; k++)
+  {
+    uint16_t dist = (k > toneBin) ? (k - toneBin) : (toneBin - k);
+    if ((dist > 1) && (power[k] > spur))
+    {
+      spur = power[k];
+    }
+  }
+  return (spur > 0.0f) ? (10.0f * log10f(power[toneBin] / spur)) : 200.0f;
+}
+
+/**
+ * @brief Benchmark cb_framework_fft() against cb_radar_fft_q15() for each cb_uwbradar_en length.
+ *        Lengths above DEF_RADAR_Q15_FFT_MAX_LEN only run the float path.
+ *
+ * @param results    Result per FFT length.
+ * @param maxResults Size of the result array.
+ * @return Number of results filled.
+ */
+uint8_t cb_radar_fft_benchmark(cb_radar_fft_benchmark_st *results, uint8_t maxResults)
+{
+  static float   floatBuf[2 * DEF_RADAR_FFT_BENCHMARK_MAX_LEN];   // Also holds the power of each path
+  static int16_t q15Buf[2 * DEF_RADAR_Q15_FFT_MAX_LEN];
+  uint8_t        count = 0;
+
+  if (s_radarTwiddleReady == CB_FALSE)
+  {
+    cb_radar_twiddle_init_q15();
+  }
+
+  for (cb_uwbradar_en fftLen = EN_FFT_LEN16; (count < maxResults) && ((DEF_RADAR_FFT_MIN_LEN << fftLen) <= DEF_RADAR_FFT_BENCHMARK_MAX_LEN); fftLen++)
+  {
+    uint16_t numPoints = (uint16_t)(DEF_RADAR_FFT_MIN_LEN << fftLen);
+    uint16_t toneBin   = numPoints / 8;
+    uint8_t  q15Run    = (numPoints <= DEF_RADAR_Q15_FFT_MAX_LEN) ? CB_TRUE : CB_FALSE;
+    int8_t   exponent  = 0;
+    uint32_t start;
+
+    memset(&results[count], 0, sizeof(results[count]));
+
+    // On-bin tone with a 1 LSB dither, as the int16 CIR delivers it
+    for (uint16_t n = 0; n < numPoints; n++)
+    {
+      float   angle = (2.0f * DEF_RADAR_PI * toneBin * n) / numPoints;
+      int16_t re    = (int16_t)lrintf(8000.0f * cosf(angle) + (float)((n * 7) % 3) - 1.0f);
+      int16_t im    = (int16_t)lrintf(8000.0f * sinf(angle) + (float)((n * 5) % 3) - 1.0f);
+      floatBuf[2 * n]     = re;
+      floatBuf[2 * n + 1] = im;
+      if (q15Run == CB_TRUE)
+      {
+        q15Buf[2 * n]     = re;
+        q15Buf[2 * n + 1] = im;
+      }
+    }
+
+    start = DWT->CYCCNT;
+    cb_framework_fft(fftLen, floatBuf, 0, 1);
+    results[count].floatCycles = DWT->CYCCNT - start;
+
+    // Power in place: bin k only reads entries 2k and 2k + 1
+    for (uint16_t k = 0; k < numPoints; k++)
+    {
+      floatBuf[k] = floatBuf[2 * k] * floatBuf[2 * k] + floatBuf[2 * k + 1] * floatBuf[2 * k + 1];
+    }
+    results[count].floatDynamicRange_dB = cb_radar_benchmark_dynamic_range(floatBuf, numPoints, toneBin);
+    results[count].floatBufferBytes     = 2 * numPoints * sizeof(float);
+
+    if (q15Run == CB_TRUE)
+    {
+      start = DWT->CYCCNT;
+      cb_radar_fft_q15(fftLen, q15Buf, &exponent);
+      results[count].q15Cycles = DWT->CYCCNT - start;
+
+      cb_radar_mag_squared_q15(q15Buf, (uint32_t *)floatBuf, numPoints, CB_FALSE);
+      for (uint16_t k = 0; k < numPoints; k++)
+      {
+        floatBuf[k] = (float)((uint32_t *)floatBuf)[k];
+      }
+      results[count].q15DynamicRange_dB = cb_radar_benchmark_dynamic_range(floatBuf, numPoints, toneBin);
+      results[count].q15BufferBytes     = 2 * numPoints * sizeof(int16_t);
+    }
+
+    results[count].fftLen = numPoints;
+    count++;
+  }
+  return count;
+}
+#endif
+
+/**
+ * @brief Cell-averaging CFAR along the range axis of each Doppler bin.
+ *        A cell is reported if it exceeds the threshold and is a local maximum of the power map.
+ */
+static void cb_radar_cfar(void)
+{
+  uint16_t numBins   = s_stRadar.config.numRangeBins;
+  uint16_t numChirps = s_stRadar.numChirps;
+  uint16_t guard     = s_stRadar.config.cfarGuardCells;
+  uint16_t training  = s_stRadar.config.cfarTrainingCells;
+  uint16_t firstDop  = (s_stRadar.config.clutterRemoval == CB_TRUE) ? 1 : 0; // Static bin holds the removed clutter
+
+  s_stRadarResult.numDetections = 0;
+
+  for (uint16_t d = firstDop; d < numChirps; d++)
+  {
+    uint16_t dPrev = (d == 0) ? (numChirps - 1) : (d - 1);
+    uint16_t dNext = (d == (numChirps - 1)) ? 0 : (d + 1);
+
+    for (uint16_t r = 0; r < numBins; r++)
+    {
+      float power = s_radarPowerMap[r][d];
+
+      if ((power < s_radarPowerMap[r][dPrev]) || (power < s_radarPowerMap[r][dNext]) ||
+          ((r > 0) && (power < s_radarPowerMap[r - 1][d])) ||
+          ((r < (numBins - 1)) && (power < s_radarPowerMap[r + 1][d])))
+      {
+        continue;
+      }
+
+      // Training cells on both sides, one-sided at the map edges
+      float    noise = 0.0f;
+      uint16_t count = 0;
+      for (uint16_t t = guard + 1; t <= (guard + training); t++)
+      {
+        if (r >= t)
+        {
+          noise += s_radarPowerMap[r - t][d];
+          count++;
+        }
+        if ((r + t) < numBins)
+        {
+          noise += s_radarPowerMap[r + t][d];
+          count++;
+        }
+      }
+      if (count == 0)
+      {
+        continue;
+      }
+      noise /= count;
+
+      if ((noise > 0.0f) && (power > (s_stRadar.config.cfarThresholdScale * noise)))
+      {
+        cb_radar_add_detection(r, d, power, noise);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Add one detection to the result, keeping the strongest ones when the list is full.
+ *
+ * @param rangeBin   Range bin index.
+ * @param dopplerBin Doppler bin index in FFT order.
+ * @param power      Cell power.
+ * @param noise      CFAR noise estimate.
+ */
+static void cb_radar_add_detection(uint16_t rangeBin, uint16_t dopplerBin, float power, float noise)
+{
+  float    snr_dB = 10.0f * log10f(power / noise);
+  uint8_t  slot   = s_stRadarResult.numDetections;
+
+  if (slot >= DEF_RADAR_MAX_DETECTIONS)
+  {
+    slot = 0;
+    for (uint8_t i = 1; i < DEF_RADAR_MAX_DETECTIONS; i++)
+    {
+      if (s_stRadarResult.detections[i].snr_dB < s_stRadarResult.detections[slot].snr_dB)
+      {
+        slot = i;
+      }
+    }
+    if (snr_dB <= s_stRadarResult.detections[slot].snr_dB)
+    {
+      return;
+    }
+  }
+  else
+  {
+    s_stRadarResult.numDetections++;
+  }
+
+  int16_t                signedBin = (dopplerBin >= (s_stRadar.numChirps / 2)) ? (int16_t)(dopplerBin - s_stRadar.numChirps) : (int16_t)dopplerBin;
+  cb_radar_detection_st *detection = &s_stRadarResult.detections[slot];
+
+  detection->rangeBin     = rangeBin;
+  detection->dopplerBin   = signedBin;
+  detection->range_m      = (s_stRadar.config.firstRangeBin + rangeBin) * s_stRadar.config.rangeBinSize_m;
+  // Phase decreases with range: a receding target shows a negative Doppler frequency
+  detection->velocity_mps = -(float)signedBin * s_stRadar.config.wavelength_m / (2.0f * s_stRadar.numChirps * s_stRadar.config.chirpPeriod_s);
+  detection->snr_dB       = snr_dB;
+}
+#endif
@@ -0,0 +1,257 @@
+/**
+ * @file    CB_radar.h
+ * @brief   UWB radar range-Doppler processing.
+ * @details This module turns successive radar CIR snapshots (cb_framework_radar_getcir) into a list of
+ *          detections. N slow-time CIR frames are accumulated into a range bin x chirp matrix, static
+ *          clutter is removed by mean subtraction, a Doppler FFT (cb_framework_fft) is run per range bin
+ *          and CA-CFAR is applied on the range-Doppler power map.
+ *          Processing is split in bounded steps so that it fits in a fixed frame budget.
+ *          The processing functions exist only with DEF_RADAR_DOPPLER_ENABLE; the types and limits are
+ *          also used by CB_radar_vitals.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_RADAR_H
+#define __CB_RADAR_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_Common.h"
+#include "CB_system_types.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DEF_RADAR_DOPPLER_ENABLE
+#define DEF_RADAR_DOPPLER_ENABLE    CB_FALSE  /**< Range-Doppler map and Q15 FFT, about 10 KB of static RAM; CB_radar.c is empty when CB_FALSE */
+#endif
+#ifndef DEF_RADAR_MAX_RANGE_BINS
+#define DEF_RADAR_MAX_RANGE_BINS    32    /**< Max range bins kept per frame */
+#endif
+#ifndef DEF_RADAR_MAX_CHIRPS
+#define DEF_RADAR_MAX_CHIRPS        32    /**< Max slow-time frames (Doppler FFT length), power of 2 */
+#endif
+#ifndef DEF_RADAR_MAX_DETECTIONS
+#define DEF_RADAR_MAX_DETECTIONS    16    /**< Max detections reported per range-Doppler map */
+#endif
+#ifndef DEF_RADAR_Q15_FFT_MAX_LEN
+#define DEF_RADAR_Q15_FFT_MAX_LEN   256   /**< Max fixed-point FFT length (twiddle table size), power of 2 */
+#endif
+#ifndef DEF_RADAR_FFT_BENCHMARK_ENABLE
+#define DEF_RADAR_FFT_BENCHMARK_ENABLE  CB_FALSE /**< Float vs fixed-point FFT benchmark */
+#endif
+#ifndef DEF_RADAR_FFT_BENCHMARK_MAX_LEN
+#define DEF_RADAR_FFT_BENCHMARK_MAX_LEN 4096  /**< Longest benchmarked FFT (EN_FFT_LEN4096), 8 bytes of static RAM per point */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_RADAR_MAX_CIR_SAMPLES   256   /**< CIR register size */
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+/**
+ * @brief Radar processing state.
+ */
+typedef enum
+{
+  EN_RADAR_STATUS_IDLE = 0,       /**< Not initialized */
+  EN_RADAR_STATUS_ACCUMULATING,   /**< Collecting slow-time frames */
+  EN_RADAR_STATUS_PROCESSING,     /**< Matrix full, cb_radar_process() to be called */
+  EN_RADAR_STATUS_DONE,           /**< Detections available */
+} cb_radar_status_en;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Radar processing configuration.
+ */
+typedef struct
+{
+  uint16_t        firstRangeBin;       /**< First CIR sample kept (direct path / leakage excluded) */
+  uint16_t        numRangeBins;        /**< Number of CIR samples kept, up to DEF_RADAR_MAX_RANGE_BINS */
+  cb_uwbradar_en  dopplerFftLen;       /**< Number of chirps per map (EN_FFT_LEN16 or EN_FFT_LEN32 ...) */
+  uint8_t         clutterRemoval;      /**< CB_TRUE: subtract the slow-time mean of each range bin */
+  uint8_t         fixedPointFft;       /**< CB_TRUE: Q15 block-floating-point Doppler FFT instead of cb_framework_fft() */
+  uint8_t         cfarGuardCells;      /**< CA-CFAR guard cells on each side (range axis) */
+  uint8_t         cfarTrainingCells;   /**< CA-CFAR training cells on each side (range axis) */
+  float           cfarThresholdScale;  /**< CA-CFAR threshold, linear power ratio over the noise estimate */
+  float           rangeBinSize_m;      /**< Range covered by one CIR sample, in metres */
+  float           chirpPeriod_s;       /**< Slow-time frame period, in seconds */
+  float           wavelength_m;        /**< Carrier wavelength, in metres */
+} cb_radar_config_st;
+
+/**
+ * @brief One range-Doppler detection.
+ */
+typedef struct
+{
+  uint16_t  rangeBin;      /**< Range bin index (relative to firstRangeBin) */
+  int16_t   dopplerBin;    /**< Signed Doppler bin index, 0 is static */
+  float     range_m;       /**< Range in metres, from CIR sample 0 */
+  float     velocity_mps;  /**< Radial velocity in m/s, positive when moving away */
+  float     snr_dB;        /**< Cell power over CFAR noise estimate, in dB */
+} cb_radar_detection_st;
+
+/**
+ * @brief Result of one range-Doppler map.
+ */
+typedef struct
+{
+  cb_radar_detection_st detections[DEF_RADAR_MAX_DETECTIONS]; /**< Strongest detections */
+  uint8_t               numDetections;                        /**< Number of valid detections */
+  uint32_t              processCycles;                        /**< CPU cycles spent in cb_radar_process() for this map */
+} cb_radar_result_st;
+
+/**
+ * @brief Float vs fixed-point FFT benchmark result for one FFT length.
+ */
+typedef struct
+{
+  uint16_t  fftLen;              /**< FFT length */
+  uint32_t  floatCycles;         /**< cb_framework_fft() cycles */
+  uint32_t  q15Cycles;           /**< cb_radar_fft_q15() cycles, 0 above DEF_RADAR_Q15_FFT_MAX_LEN */
+  uint32_t  floatBufferBytes;    /**< Working buffer of the float path */
+  uint32_t  q15BufferBytes;      /**< Working buffer of the fixed-point path, 0 when not run */
+  float     floatDynamicRange_dB;/**< Tone peak over the strongest other bin */
+  float     q15DynamicRange_dB;  /**< Same for the fixed-point path, 0 when not run */
+} cb_radar_fft_benchmark_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+#if (DEF_RADAR_DOPPLER_ENABLE == CB_TRUE)
+/**
+ * @brief Initialize the radar processing with the given configuration.
+ *
+ * @param config Processing configuration.
+ * @return CB_PASS on success, CB_FAIL if the configuration exceeds the compile-time limits.
+ */
+CB_STATUS cb_radar_init(const cb_radar_config_st *config);
+
+/**
+ * @brief Restart the accumulation of slow-time frames.
+ */
+void cb_radar_reset(void);
+
+/**
+ * @brief Add one slow-time CIR frame to the range x chirp matrix.
+ *
+ * The frame can come from cb_framework_radar_getcir(), a recording or a synthetic generator.
+ *
+ * @param cir CIR samples starting at CIR sample 0, at least firstRangeBin + numRangeBins samples.
+ * @return EN_RADAR_STATUS_ACCUMULATING while frames are missing, EN_RADAR_STATUS_PROCESSING once the matrix is full.
+ */
+cb_radar_status_en cb_radar_push_frame(const cb_uwbsystem_rx_cir_iqdata_st *cir);
+
+/**
+ * @brief Read one CIR frame from the radar receiver and add it to the matrix.
+ *
+ * @param enRxPort UWB receiver port to read.
+ * @return Same as cb_radar_push_frame().
+ */
+cb_radar_status_en cb_radar_acquire_frame(cb_uwbsystem_rxport_en enRxPort);
+
+/**
+ * @brief Run the range-Doppler processing in bounded steps.
+ *
+ * Each call runs the Doppler FFT of at most maxRangeBins range bins; the call that completes the
+ * last range bin also runs CA-CFAR. Call it between two chirps to spread the processing over the
+ * frame period.
+ *
+ * @param maxRangeBins Max range bins processed by this call, 0 for the whole map.
+ * @return EN_RADAR_STATUS_PROCESSING while range bins are left, EN_RADAR_STATUS_DONE when the result is available.
+ */
+cb_radar_status_en cb_radar_process(uint16_t maxRangeBins);
+
+/**
+ * @brief Get the current processing state.
+ *
+ * @return Processing state.
+ */
+cb_radar_status_en cb_radar_get_status(void);
+
+/**
+ * @brief Get the result of the last completed map.
+ *
+ * @return Pointer to the result, valid until the next map completes.
+ */
+const cb_radar_result_st* cb_radar_get_result(void);
+
+/**
+ * @brief Get the range-Doppler power map of the last completed map.
+ *
+ * Row r holds the DEF_RADAR_MAX_CHIRPS Doppler bins of range bin r, in FFT order (bin 0 is static).
+ *
+ * @return Pointer to the power map.
+ */
+const float* cb_radar_get_power_map(void);
+
+/**
+ * @brief In-place Q15 complex FFT with block-floating-point scaling.
+ *
+ * The input is interleaved int16 (real, imaginary). It is first normalized to use the full Q15
+ * range, then each radix-2 stage is scaled down only as much as its growth requires. The true
+ * spectrum is the output times 2^exponent. A cb_uwbsystem_rx_cir_iqdata_st array (Q, I order)
+ * can be passed directly: the spectrum is then mirrored, see cb_radar_mag_squared_q15().
+ *
+ * @param fftLen   FFT length, up to DEF_RADAR_Q15_FFT_MAX_LEN.
+ * @param pSrc     Interleaved complex samples, 2 * length int16.
+ * @param exponent Block exponent of the output.
+ * @return CB_PASS on success, CB_FAIL if the length is not supported.
+ */
+CB_STATUS cb_radar_fft_q15(cb_uwbradar_en fftLen, int16_t *pSrc, int8_t *exponent);
+
+/**
+ * @brief Apply a Q15 window to interleaved int16 complex samples, in place.
+ *
+ * @param pSrc      Interleaved complex samples.
+ * @param pWindow   Q15 window, one coefficient per complex sample.
+ * @param numPoints Number of complex samples.
+ */
+void cb_radar_window_q15(int16_t *pSrc, const int16_t *pWindow, uint16_t numPoints);
+
+/**
+ * @brief Fill a Q15 Hann window.
+ *
+ * @param pWindow   Destination.
+ * @param numPoints Window length.
+ */
+void cb_radar_hann_q15(int16_t *pWindow, uint16_t numPoints);
+
+/**
+ * @brief Magnitude squared of a Q15 FFT output.
+ *
+ * @param pSrc      FFT output of cb_radar_fft_q15().
+ * @param pDst      Power per bin, true power is pDst[k] * 2^(2 * exponent).
+ * @param numPoints FFT length.
+ * @param swappedIQ CB_TRUE if the FFT input was in (Q, I) order: bin k is read from bin (N - k) mod N.
+ */
+void cb_radar_mag_squared_q15(const int16_t *pSrc, uint32_t *pDst, uint16_t numPoints, uint8_t swappedIQ);
+
+#if (DEF_RADAR_FFT_BENCHMARK_ENABLE == CB_TRUE)
+/**
+ * @brief Benchmark cb_framework_fft() against cb_radar_fft_q15() for each cb_uwbradar_en length, 16 to DEF_RADAR_FFT_BENCHMARK_MAX_LEN.
+ *
+ * A CIR-like tone (int16 I/Q) is transformed by both paths; lengths above DEF_RADAR_Q15_FFT_MAX_LEN only
+ * run the float path (cb_radar_fft_q15() has no twiddles for them). Cycles are read from the DWT cycle
+ * counter, which the caller must have enabled.
+ *
+ * @param results    Result per FFT length.
+ * @param maxResults Size of the result array.
+ * @return Number of results filled.
+ */
+uint8_t cb_radar_fft_benchmark(cb_radar_fft_benchmark_st *results, uint8_t maxResults);
+#endif
+#endif
+
+#endif /*__CB_RADAR_H*/
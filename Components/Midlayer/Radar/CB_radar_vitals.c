@@ -0,0 +1,488 @@
+/**
+ * @file    CB_radar_vitals.c
+ * @brief   UWB radar presence and vital-sign detection.
+ * @details Per frame: static background subtraction per range bin, presence state machine on the ratio
+ *          between the strongest and the mean moving energy, phase tracking of the strongest bin, motion
+ *          detection on the displacement speed and rate estimation from the band-passed displacement.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "CB_radar_vitals.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_RADAR_VITALS_PI              3.14159265f
+#define DEF_RADAR_VITALS_ENERGY_ALPHA    0.2f    // Smoothing of the per-bin moving energy
+#define DEF_RADAR_VITALS_SPEED_ALPHA     0.1f    // Smoothing of the displacement speed
+#define DEF_RADAR_VITALS_RMS_TIME_S      5.0f    // Time constant of the band RMS
+#define DEF_RADAR_VITALS_CROSS_LEVEL     0.3f    // Zero-crossing hysteresis, fraction of the band RMS
+#define DEF_RADAR_VITALS_BIN_SWITCH      2.0f    // Energy ratio required to move the tracked bin
+#define DEF_RADAR_VITALS_NUM_STAGES      2       // Band-pass biquads per band
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Biquad section, transposed direct form II.
+ */
+typedef struct
+{
+  float b0, b2, a1, a2;   // b1 is 0 for a band-pass
+  float z1, z2;
+} cb_radar_vitals_biquad_st;
+
+/**
+ * @brief Band-pass filter and rate estimator of one vital-sign band.
+ */
+typedef struct
+{
+  cb_radar_vitals_biquad_st stage[DEF_RADAR_VITALS_NUM_STAGES];
+  float     meanSquare;                              // Band power
+  float     minPeriod;                               // Accepted period range, in frames
+  float     maxPeriod;
+  uint32_t  lastCrossing;                            // Frame of the last rising crossing
+  uint8_t   armed;                                   // Signal went below the lower hysteresis level
+  uint8_t   hasCrossing;
+  uint8_t   numPeriods;
+  uint8_t   periodIdx;
+  float     periods[DEF_RADAR_VITALS_NUM_PERIODS];   // Last periods, in frames
+} cb_radar_vitals_band_st;
+
+/**
+ * @brief Presence and vital-sign processing state.
+ */
+typedef struct
+{
+  cb_radar_vitals_config_st   config;
+  cb_radar_vitals_event_cb_t  callback;
+  uint8_t                     initialized;
+  uint8_t                     backgroundValid;
+  uint32_t                    frameCount;
+  float                       bgI[DEF_RADAR_MAX_RANGE_BINS];
+  float                       bgQ[DEF_RADAR_MAX_RANGE_BINS];
+  float                       energy[DEF_RADAR_MAX_RANGE_BINS];
+  // Presence
+  uint8_t                     present;
+  uint16_t                    enterCount;
+  uint16_t                    exitCount;
+  // Tracking
+  uint8_t                     tracking;
+  uint16_t                    trackedBin;
+  uint8_t                     phaseValid;
+  float                       lastPhase;
+  float                       displacement;
+  float                       lastDisplacement;
+  float                       speed;
+  uint8_t                     moving;
+  uint16_t                    framesSinceReport;
+  cb_radar_vitals_band_st     breath;
+  cb_radar_vitals_band_st     heart;
+} cb_radar_vitals_state_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static cb_radar_vitals_state_st s_stVitals;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void  cb_radar_vitals_band_init(cb_radar_vitals_band_st *band, float low_Hz, float high_Hz);
+static void  cb_radar_vitals_band_reset(cb_radar_vitals_band_st *band);
+static float cb_radar_vitals_band_process(cb_radar_vitals_band_st *band, float sample);
+static float cb_radar_vitals_band_rate(const cb_radar_vitals_band_st *band);
+static void  cb_radar_vitals_track_reset(uint16_t rangeBin);
+static void  cb_radar_vitals_notify(cb_radar_vitals_event_en event);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Fill a configuration with defaults for a seated or lying person within a few metres.
+ *
+ * @param config       Configuration to fill.
+ * @param frameRate_Hz Slow-time frame rate.
+ */
+void cb_radar_vitals_default_config(cb_radar_vitals_config_st *config, float frameRate_Hz)
+{
+  config->firstRangeBin        = 0;
+  config->numRangeBins         = DEF_RADAR_MAX_RANGE_BINS;
+  config->rangeBinSize_m       = 0.15f;                 // ~1 ns CIR sample, round trip
+  config->wavelength_m         = 0.0375f;               // Channel 9, 7987.2 MHz
+  config->frameRate_Hz         = frameRate_Hz;
+  config->backgroundAlpha      = 1.0f / (10.0f * frameRate_Hz);   // 10 s time constant
+  config->breathLow_Hz         = 0.1f;
+  config->breathHigh_Hz        = 0.6f;
+  config->heartLow_Hz          = 0.8f;
+  config->heartHigh_Hz         = 2.0f;
+  config->presenceEnterLevel   = 8.0f;
+  config->presenceExitLevel    = 4.0f;
+  config->presenceEnterFrames  = (uint16_t)(frameRate_Hz * 1.0f);
+  config->presenceExitFrames   = (uint16_t)(frameRate_Hz * 10.0f);
+  config->motionLevel_mps      = 0.03f;
+  config->vitalsReportFrames   = (uint16_t)(frameRate_Hz * 5.0f);
+}
+
+/**
+ * @brief Initialize the presence and vital-sign processing.
+ *
+ * @param config   Configuration.
+ * @param callback Event callback.
+ * @return CB_PASS on success, CB_FAIL on invalid configuration.
+ */
+CB_STATUS cb_radar_vitals_init(const cb_radar_vitals_config_st *config, cb_radar_vitals_event_cb_t callback)
+{
+  if ((config == NULL) || (config->numRangeBins == 0) || (config->numRangeBins > DEF_RADAR_MAX_RANGE_BINS) ||
+      ((config->firstRangeBin + config->numRangeBins) > DEF_RADAR_MAX_CIR_SAMPLES) ||
+      (config->frameRate_Hz <= (2.0f * config->heartHigh_Hz)) ||
+      (config->breathLow_Hz >= config->breathHigh_Hz) || (config->heartLow_Hz >= config->heartHigh_Hz))
+  {
+    return CB_FAIL;
+  }
+
+  memset(&s_stVitals, 0, sizeof(s_stVitals));
+  s_stVitals.config   = *config;
+  s_stVitals.callback = callback;
+  cb_radar_vitals_band_init(&s_stVitals.breath, config->breathLow_Hz, config->breathHigh_Hz);
+  cb_radar_vitals_band_init(&s_stVitals.heart,  config->heartLow_Hz,  config->heartHigh_Hz);
+  s_stVitals.initialized = CB_TRUE;
+  return CB_PASS;
+}
+
+/**
+ * @brief Reset the tracking state: background, presence state machine and filters.
+ */
+void cb_radar_vitals_reset(void)
+{
+  if (s_stVitals.initialized == CB_FALSE)
+  {
+    return;
+  }
+  s_stVitals.backgroundValid = CB_FALSE;
+  s_stVitals.present         = CB_FALSE;
+  s_stVitals.enterCount      = 0;
+  s_stVitals.exitCount       = 0;
+  s_stVitals.tracking        = CB_FALSE;
+  memset(s_stVitals.energy, 0, sizeof(s_stVitals.energy));
+}
+
+/**
+ * @brief Process one slow-time CIR frame.
+ *
+ * @param cir CIR samples starting at CIR sample 0.
+ */
+void cb_radar_vitals_process_frame(const cb_uwbsystem_rx_cir_iqdata_st *cir)
+{
+  cb_radar_vitals_state_st *st = &s_stVitals;
+
+  if ((st->initialized == CB_FALSE) || (cir == NULL))
+  {
+    return;
+  }
+
+  const cb_uwbsystem_rx_cir_iqdata_st *bins = &cir[st->config.firstRangeBin];
+  uint16_t numBins = st->config.numRangeBins;
+  st->frameCount++;
+
+  //------------------------
+  // Static background removal and moving energy per bin
+  //------------------------
+  if (st->backgroundValid == CB_FALSE)
+  {
+    for (uint16_t r = 0; r < numBins; r++)
+    {
+      st->bgI[r] = bins[r].I_data;
+      st->bgQ[r] = bins[r].Q_data;
+    }
+    st->backgroundValid = CB_TRUE;
+    return;
+  }
+
+  float    peakEnergy = 0.0f;
+  float    sumEnergy  = 0.0f;
+  uint16_t peakBin    = 0;
+  for (uint16_t r = 0; r < numBins; r++)
+  {
+    float dI = bins[r].I_data - st->bgI[r];
+    float dQ = bins[r].Q_data - st->bgQ[r];
+    st->bgI[r]    += st->config.backgroundAlpha * dI;
+    st->bgQ[r]    += st->config.backgroundAlpha * dQ;
+    st->energy[r] += DEF_RADAR_VITALS_ENERGY_ALPHA * ((dI * dI + dQ * dQ) - st->energy[r]);
+    sumEnergy     += st->energy[r];
+    if (st->energy[r] > peakEnergy)
+    {
+      peakEnergy = st->energy[r];
+      peakBin    = r;
+    }
+  }
+
+  //------------------------
+  // Presence state machine with hysteresis
+  //------------------------
+  float ratio = (sumEnergy > 0.0f) ? (peakEnergy * numBins / sumEnergy) : 0.0f;
+  if (st->present == CB_FALSE)
+  {
+    st->enterCount = (ratio >= st->config.presenceEnterLevel) ? (st->enterCount + 1) : 0;
+    if (st->enterCount >= st->config.presenceEnterFrames)
+    {
+      st->present   = CB_TRUE;
+      st->exitCount = 0;
+      cb_radar_vitals_track_reset(peakBin);
+      cb_radar_vitals_notify(EN_RADAR_VITALS_EVENT_PRESENCE_ENTER);
+    }
+    return;
+  }
+  st->exitCount = (ratio < st->config.presenceExitLevel) ? (st->exitCount + 1) : 0;
+  if (st->exitCount >= st->config.presenceExitFrames)
+  {
+    st->present    = CB_FALSE;
+    st->enterCount = 0;
+    st->tracking   = CB_FALSE;
+    cb_radar_vitals_notify(EN_RADAR_VITALS_EVENT_PRESENCE_EXIT);
+    return;
+  }
+
+  //------------------------
+  // Strongest bin tracking, moved only on a clearly stronger bin
+  //------------------------
+  if ((st->tracking == CB_FALSE) || (peakEnergy > (DEF_RADAR_VITALS_BIN_SWITCH * st->energy[st->trackedBin])))
+  {
+    if ((st->tracking == CB_FALSE) || (peakBin != st->trackedBin))
+    {
+      cb_radar_vitals_track_reset(peakBin);
+    }
+  }
+
+  //------------------------
+  // Phase to displacement
+  //------------------------
+  const cb_uwbsystem_rx_cir_iqdata_st *sample = &bins[st->trackedBin];
+  float phase = atan2f((float)sample->Q_data, (float)sample->I_data);
+  float delta = (st->phaseValid == CB_TRUE) ? (phase - st->lastPhase) : 0.0f;
+  if (delta > DEF_RADAR_VITALS_PI)
+  {
+    delta -= 2.0f * DEF_RADAR_VITALS_PI;
+  }
+  else if (delta < -DEF_RADAR_VITALS_PI)
+  {
+    delta += 2.0f * DEF_RADAR_VITALS_PI;
+  }
+  st->lastPhase     = phase;
+  st->phaseValid    = CB_TRUE;
+  st->displacement += delta * st->config.wavelength_m / (4.0f * DEF_RADAR_VITALS_PI);
+
+  float speed = fabsf(st->displacement - st->lastDisplacement) * st->config.frameRate_Hz;
+  st->lastDisplacement = st->displacement;
+  st->speed += DEF_RADAR_VITALS_SPEED_ALPHA * (speed - st->speed);
+
+  //------------------------
+  // Motion state, vital signs are only meaningful on a static target
+  //------------------------
+  if ((st->moving == CB_FALSE) && (st->speed > st->config.motionLevel_mps))
+  {
+    st->moving = CB_TRUE;
+    cb_radar_vitals_notify(EN_RADAR_VITALS_EVENT_MOTION_START);
+  }
+  else if ((st->moving == CB_TRUE) && (st->speed < (0.5f * st->config.motionLevel_mps)))
+  {
+    st->moving           = CB_FALSE;
+    st->displacement     = 0.0f;          // Restart from the new rest position, no step into the filters
+    st->lastDisplacement = 0.0f;
+    cb_radar_vitals_band_reset(&st->breath);
+    cb_radar_vitals_band_reset(&st->heart);
+    st->framesSinceReport = 0;
+    cb_radar_vitals_notify(EN_RADAR_VITALS_EVENT_MOTION_STOP);
+  }
+
+  // Breathing is 10-20 times stronger than the heart beat: remove it before the heart band
+  float breath = cb_radar_vitals_band_process(&st->breath, st->displacement);
+  cb_radar_vitals_band_process(&st->heart, st->displacement - breath);
+
+  if ((st->moving == CB_FALSE) && (++st->framesSinceReport >= st->config.vitalsReportFrames))
+  {
+    st->framesSinceReport = 0;
+    cb_radar_vitals_notify(EN_RADAR_VITALS_EVENT_VITALS);
+  }
+}
+
+/**
+ * @brief Get the presence state.
+ *
+ * @return CB_TRUE if a target is present, CB_FALSE otherwise.
+ */
+uint8_t cb_radar_vitals_is_present(void)
+{
+  return s_stVitals.present;
+}
+
+/**
+ * @brief Design the band-pass filter of one band (RBJ band-pass, 0 dB peak, cascaded stages).
+ *
+ * @param band    Band state.
+ * @param low_Hz  Lower band edge.
+ * @param high_Hz Upper band edge.
+ */
+static void cb_radar_vitals_band_init(cb_radar_vitals_band_st *band, float low_Hz, float high_Hz)
+{
+  float fs    = s_stVitals.config.frameRate_Hz;
+  float f0    = sqrtf(low_Hz * high_Hz);
+  float w0    = 2.0f * DEF_RADAR_VITALS_PI * f0 / fs;
+  float alpha = sinf(w0) * (high_Hz - low_Hz) / (2.0f * f0);
+  float a0    = 1.0f + alpha;
+
+  for (uint8_t i = 0; i < DEF_RADAR_VITALS_NUM_STAGES; i++)
+  {
+    band->stage[i].b0 = alpha / a0;
+    band->stage[i].b2 = -alpha / a0;
+    band->stage[i].a1 = -2.0f * cosf(w0) / a0;
+    band->stage[i].a2 = (1.0f - alpha) / a0;
+  }
+  band->minPeriod = fs / (1.5f * high_Hz);
+  band->maxPeriod = 1.5f * fs / low_Hz;
+  cb_radar_vitals_band_reset(band);
+}
+
+/**
+ * @brief Reset the filter memory and the rate estimator of one band.
+ *
+ * @param band Band state.
+ */
+static void cb_radar_vitals_band_reset(cb_radar_vitals_band_st *band)
+{
+  for (uint8_t i = 0; i < DEF_RADAR_VITALS_NUM_STAGES; i++)
+  {
+    band->stage[i].z1 = 0.0f;
+    band->stage[i].z2 = 0.0f;
+  }
+  band->meanSquare  = 0.0f;
+  band->armed       = CB_FALSE;
+  band->hasCrossing = CB_FALSE;
+  band->numPeriods  = 0;
+  band->periodIdx   = 0;
+}
+
+/**
+ * @brief Filter one displacement sample and update the rising zero-crossing periods.
+ *
+ * @param band   Band state.
+ * @param sample Displacement in metres.
+ * @return Filtered sample.
+ */
+static float cb_radar_vitals_band_process(cb_radar_vitals_band_st *band, float sample)
+{
+  float y = sample;
+
+  for (uint8_t i = 0; i < DEF_RADAR_VITALS_NUM_STAGES; i++)
+  {
+    cb_radar_vitals_biquad_st *bq = &band->stage[i];
+    float out = bq->b0 * y + bq->z1;
+    bq->z1    = bq->z2 - bq->a1 * out;
+    bq->z2    = bq->b2 * y - bq->a2 * out;
+    y         = out;
+  }
+
+  band->meanSquare += (y * y - band->meanSquare) / (DEF_RADAR_VITALS_RMS_TIME_S * s_stVitals.config.frameRate_Hz);
+  float level = DEF_RADAR_VITALS_CROSS_LEVEL * sqrtf(band->meanSquare);
+
+  if (y < -level)
+  {
+    band->armed = CB_TRUE;
+  }
+  else if ((band->armed == CB_TRUE) && (y > level))
+  {
+    band->armed = CB_FALSE;
+    if (band->hasCrossing == CB_TRUE)
+    {
+      float period = (float)(s_stVitals.frameCount - band->lastCrossing);
+      if ((period >= band->minPeriod) && (period <= band->maxPeriod))
+      {
+        band->periods[band->periodIdx] = period;
+        band->periodIdx = (band->periodIdx + 1) % DEF_RADAR_VITALS_NUM_PERIODS;
+        if (band->numPeriods < DEF_RADAR_VITALS_NUM_PERIODS)
+        {
+          band->numPeriods++;
+        }
+      }
+    }
+    band->hasCrossing  = CB_TRUE;
+    band->lastCrossing = s_stVitals.frameCount;
+  }
+  return y;
+}
+
+/**
+ * @brief Rate of one band from the averaged crossing periods.
+ *
+ * @param band Band state.
+ * @return Rate per minute, 0 if less than two periods are known.
+ */
+static float cb_radar_vitals_band_rate(const cb_radar_vitals_band_st *band)
+{
+  if (band->numPeriods < 2)
+  {
+    return 0.0f;
+  }
+  float sum = 0.0f;
+  for (uint8_t i = 0; i < band->numPeriods; i++)
+  {
+    sum += band->periods[i];
+  }
+  return 60.0f * s_stVitals.config.frameRate_Hz * band->numPeriods / sum;
+}
+
+/**
+ * @brief Start tracking a new range bin.
+ *
+ * @param rangeBin Range bin index.
+ */
+static void cb_radar_vitals_track_reset(uint16_t rangeBin)
+{
+  s_stVitals.tracking          = CB_TRUE;
+  s_stVitals.trackedBin        = rangeBin;
+  s_stVitals.lastPhase         = 0.0f;
+  s_stVitals.displacement      = 0.0f;
+  s_stVitals.lastDisplacement  = 0.0f;
+  s_stVitals.speed             = 0.0f;
+  s_stVitals.moving            = CB_FALSE;
+  s_stVitals.framesSinceReport = 0;
+  s_stVitals.phaseValid        = CB_FALSE;   // First phase sample only sets the reference
+  cb_radar_vitals_band_reset(&s_stVitals.breath);
+  cb_radar_vitals_band_reset(&s_stVitals.heart);
+}
+
+/**
+ * @brief Report one event to the registered callback.
+ *
+ * @param event Event type.
+ */
+static void cb_radar_vitals_notify(cb_radar_vitals_event_en event)
+{
+  if (s_stVitals.callback == NULL)
+  {
+    return;
+  }
+
+  cb_radar_vitals_event_st data;
+  data.event              = event;
+  data.rangeBin           = s_stVitals.trackedBin;
+  data.range_m            = (s_stVitals.config.firstRangeBin + s_stVitals.trackedBin) * s_stVitals.config.rangeBinSize_m;
+  data.breathRate_bpm     = cb_radar_vitals_band_rate(&s_stVitals.breath);
+  data.heartRate_bpm      = cb_radar_vitals_band_rate(&s_stVitals.heart);
+  data.breathAmplitude_mm = 1000.0f * sqrtf(s_stVitals.breath.meanSquare);
+  s_stVitals.callback(&data);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file    CB_radar_vitals.h
+ * @brief   UWB radar presence and vital-sign detection.
+ * @details This module processes one radar CIR frame per slow-time period and reports events:
+ *          presence enter/exit (state machine with hysteresis), motion start/stop and periodic
+ *          breathing and heart rate updates. The strongest moving range bin is tracked, its phase
+ *          is unwrapped into a displacement and band-pass filtered in the breathing and heart bands.
+ *          The module has no hardware dependency, frames can come from the radar or from a generator.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_RADAR_VITALS_H
+#define __CB_RADAR_VITALS_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_Common.h"
+#include "CB_system_types.h"
+#include "CB_radar.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_RADAR_VITALS_NUM_PERIODS   6    /**< Zero-crossing periods averaged for a rate estimate */
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+/**
+ * @brief Radar vital-sign events.
+ */
+typedef enum
+{
+  EN_RADAR_VITALS_EVENT_PRESENCE_ENTER = 0, /**< Target detected */
+  EN_RADAR_VITALS_EVENT_PRESENCE_EXIT,      /**< Target left */
+  EN_RADAR_VITALS_EVENT_MOTION_START,       /**< Target moving, vital signs paused */
+  EN_RADAR_VITALS_EVENT_MOTION_STOP,        /**< Target static again */
+  EN_RADAR_VITALS_EVENT_VITALS,             /**< Breathing / heart rate update */
+} cb_radar_vitals_event_en;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Radar vital-sign configuration.
+ */
+typedef struct
+{
+  uint16_t  firstRangeBin;        /**< First CIR sample searched */
+  uint16_t  numRangeBins;         /**< Number of CIR samples searched, up to DEF_RADAR_MAX_RANGE_BINS */
+  float     rangeBinSize_m;       /**< Range covered by one CIR sample, in metres */
+  float     wavelength_m;         /**< Carrier wavelength, in metres */
+  float     frameRate_Hz;         /**< Slow-time frame rate */
+  float     backgroundAlpha;      /**< Static background update rate per frame (0..1) */
+  float     breathLow_Hz;         /**< Breathing band */
+  float     breathHigh_Hz;
+  float     heartLow_Hz;          /**< Heart band */
+  float     heartHigh_Hz;
+  float     presenceEnterLevel;   /**< Peak over mean moving energy ratio entering presence */
+  float     presenceExitLevel;    /**< Ratio below which presence is left (hysteresis) */
+  uint16_t  presenceEnterFrames;  /**< Consecutive frames above the enter level */
+  uint16_t  presenceExitFrames;   /**< Consecutive frames below the exit level */
+  float     motionLevel_mps;      /**< Smoothed displacement speed above which the target is moving */
+  uint16_t  vitalsReportFrames;   /**< Frames between two EN_RADAR_VITALS_EVENT_VITALS */
+} cb_radar_vitals_config_st;
+
+/**
+ * @brief Radar vital-sign event.
+ */
+typedef struct
+{
+  cb_radar_vitals_event_en  event;
+  uint16_t                  rangeBin;            /**< Tracked range bin (relative to firstRangeBin) */
+  float                     range_m;             /**< Tracked range, from CIR sample 0 */
+  float                     breathRate_bpm;      /**< Breaths per minute, 0 if not available yet */
+  float                     heartRate_bpm;       /**< Beats per minute, 0 if not available yet */
+  float                     breathAmplitude_mm;  /**< RMS chest displacement in the breathing band */
+} cb_radar_vitals_event_st;
+
+/**
+ * @brief Radar vital-sign event callback.
+ *
+ * @param event Event data, only valid during the call.
+ */
+typedef void (*cb_radar_vitals_event_cb_t)(const cb_radar_vitals_event_st *event);
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Fill a configuration with defaults for a seated or lying person within a few metres.
+ *
+ * @param config       Configuration to fill.
+ * @param frameRate_Hz Slow-time frame rate.
+ */
+void cb_radar_vitals_default_config(cb_radar_vitals_config_st *config, float frameRate_Hz);
+
+/**
+ * @brief Initialize the presence and vital-sign processing.
+ *
+ * @param config   Configuration.
+ * @param callback Event callback.
+ * @return CB_PASS on success, CB_FAIL on invalid configuration.
+ */
+CB_STATUS cb_radar_vitals_init(const cb_radar_vitals_config_st *config, cb_radar_vitals_event_cb_t callback);
+
+/**
+ * @brief Reset the tracking state: background, presence state machine and filters.
+ */
+void cb_radar_vitals_reset(void);
+
+/**
+ * @brief Process one slow-time CIR frame.
+ *
+ * @param cir CIR samples starting at CIR sample 0, at least firstRangeBin + numRangeBins samples.
+ */
+void cb_radar_vitals_process_frame(const cb_uwbsystem_rx_cir_iqdata_st *cir);
+
+/**
+ * @brief Get the presence state.
+ *
+ * @return CB_TRUE if a target is present, CB_FALSE otherwise.
+ */
+uint8_t cb_radar_vitals_is_present(void);
+
+#endif /*__CB_RADAR_VITALS_H*/
@@ -56,6 +56,12 @@ extern float RC_CompensateRatio;
 #define DEF_ABS_TIMER_MAX_TIMEOUT_US    34359738  // Maximum timeout: 34.36 seconds (34,359,738 us)
                                                   // 2^32 * 8ns (ABS count unit) = 34,359,738,368ns 
 
+// Not from the register map: the UWB library reads the CIR only in cb_uwbdriver_store_rx_cir_register.
+// Unverified on hardware, the DMA CIR snapshot (APP_PDOA_CIR_SNAPSHOT_DMA) ships off until it is.
+#define DEF_UWB_RX_CIR_REGISTER_BASE_ADDR     (0x41000800UL)  // RX0 CIR register memory
+#define DEF_UWB_RX_CIR_REGISTER_PORT_STRIDE   (0x800UL)       // Address stride between RX0/RX1/RX2 CIR memories
+#define DEF_UWB_RX_CIR_REGISTER_NUM_SAMPLES   (256UL)         // CIR samples per RX port (4 bytes per I/Q sample)
+
 //-------------------------------
 // STRUCT/UNION SECTION
 //-------------------------------
@@ -215,7 +221,7 @@ void cb_system_uwb_trx_init(void)
  *
  * @note This function must be called before starting a UWB transmission
  */
-void cb_system_uwb_config_tx(cb_uwbsystem_packetconfig_st* config, cb_uwbsystem_txpayload_st* txPayload, cb_uwbsystem_tx_irqenable_st* stTxIrqEnable)
+CB_RAM_CODE void cb_system_uwb_config_tx(cb_uwbsystem_packetconfig_st* config, cb_uwbsystem_txpayload_st* txPayload, cb_uwbsystem_tx_irqenable_st* stTxIrqEnable)
 {
   /*Copy Configure Parameter to Local Data Container */
   memcpy(&s_Local_UwbAllConfigContainer.CB_TxConfigContainer,config,sizeof (cb_uwbsystem_packetconfig_st));
@@ -364,7 +370,7 @@ void cb_system_uwb_rx_start(cb_uwbsystem_rxport_en enRxPort, cb_uwbsystem_rx_dbb
  *                 (EN_UWB_RX_0, EN_UWB_RX_1, EN_UWB_RX_2) or a combination of ports
  *                 (EN_UWB_RX_02, EN_UWB_RX_ALL)
  */
-void cb_system_uwb_rx_stop(cb_uwbsystem_rxport_en enRxPort)
+CB_RAM_CODE void cb_system_uwb_rx_stop(cb_uwbsystem_rxport_en enRxPort)
 {
   cb_uwbdriver_rx_stop(enRxPort);
 }
@@ -376,7 +382,7 @@ void cb_system_uwb_rx_stop(cb_uwbsystem_rxport_en enRxPort)
  *                 (EN_UWB_RX_0, EN_UWB_RX_1, EN_UWB_RX_2) or a combination of ports
  *                 (EN_UWB_RX_02, EN_UWB_RX_ALL)
  */
-void cb_system_uwb_rx_off(cb_uwbsystem_rxport_en enRxPort)
+CB_RAM_CODE void cb_system_uwb_rx_off(cb_uwbsystem_rxport_en enRxPort)
 {
   cb_uwbdriver_rx_off(enRxPort);
 }
@@ -391,7 +397,7 @@ void cb_system_uwb_rx_off(cb_uwbsystem_rxport_en enRxPort)
  *                  - txDone: If true, enables the transmission done interrupt.
  *                  - sfdDone: If true, enables the SFD mark interrupt.
  */
-void cb_system_uwb_configure_tx_irq(cb_uwbsystem_tx_irqenable_st* irqEnable)
+CB_RAM_CODE void cb_system_uwb_configure_tx_irq(cb_uwbsystem_tx_irqenable_st* irqEnable)
 {
   //----------------------------------
   // Reset register before configuring
@@ -525,7 +531,7 @@ void cb_system_uwb_configure_rx_irq(cb_uwbsystem_rx_irqenable_st* stRxIrqEnable)
  * @brief Initialize the UWB communication for TX
  *
  */
-void cb_system_uwb_tx_init(void)
+CB_RAM_CODE void cb_system_uwb_tx_init(void)
 {
   cb_uwbdriver_tx_init();
 }
@@ -550,7 +556,7 @@ void cb_system_uwb_rx_init(cb_uwbsystem_rxport_en enRxPort)
  * @brief Start the UWB communication for TX
  *
  */
-void cb_system_uwb_tx_start(void)
+CB_RAM_CODE void cb_system_uwb_tx_start(void)
 {
   cb_uwbdriver_tx_start();
 }
@@ -559,7 +565,7 @@ void cb_system_uwb_tx_start(void)
  * @brief Start the UWB communication for TX (For deferred TX)
  *
  */
-void cb_system_uwb_tx_start_prepare(void)
+CB_RAM_CODE void cb_system_uwb_tx_start_prepare(void)
 {
   cb_uwbdriver_tx_start_prepare();
 }
@@ -586,7 +592,7 @@ void cb_system_uwb_stage_tx_start(void)
  * @brief Stop the UWB communication for TX
  *
  */
-void cb_system_uwb_tx_stop(void)
+CB_RAM_CODE void cb_system_uwb_tx_stop(void)
 {
   cb_uwbdriver_tx_stop();
 }
@@ -603,7 +609,7 @@ void cb_system_uwb_trx_off(void)
 /**
  * @brief Turns off the UWB receiver top.
  */
-void cb_system_uwb_rx_top_off (void)
+CB_RAM_CODE void cb_system_uwb_rx_top_off (void)
 {
   cb_uwbdriver_rx_top_off();
 }
@@ -611,7 +617,7 @@ void cb_system_uwb_rx_top_off (void)
 /**
  * @brief Turns off the UWB transmitter.
  */
-void cb_system_uwb_tx_off(void)
+CB_RAM_CODE void cb_system_uwb_tx_off(void)
 {
   cb_uwbdriver_tx_off();
 }
@@ -659,7 +665,7 @@ void cb_system_delay_in_us(uint32_t microseconds)
 /**
  * @brief Prepare Payload/PSDU for UWB Tx Phy
  */
-void cb_system_uwb_tx_prepare_payload(uint8_t* pTxpayloadAddress, uint16_t SizeInByte)
+CB_RAM_CODE void cb_system_uwb_tx_prepare_payload(uint8_t* pTxpayloadAddress, uint16_t SizeInByte)
 {
   memcpy(cb_uwbdriver_get_uwb_tx_memory_start_addr(), pTxpayloadAddress, SizeInByte);
 }
@@ -667,7 +673,7 @@ void cb_system_uwb_tx_prepare_payload(uint8_t* pTxpayloadAddress, uint16_t SizeI
 /**
  * @brief Clear UWB Tx PSDU Memory
  */
-void cb_system_uwb_tx_memclr(void)
+CB_RAM_CODE void cb_system_uwb_tx_memclr(void)
 {
   memset(cb_uwbdriver_get_uwb_tx_memory_start_addr(), 0x00, cb_uwbdriver_get_uwb_tx_memory_size());
 }
@@ -1183,7 +1189,7 @@ void cb_system_uwb_get_tx_raw_timestamp(cb_uwbsystem_tx_timestamp_st* txTimestam
  *                                be stored. The structure will be updated with the integer and fractional 
  *                                components of the timestamp.
  */
-void cb_system_uwb_get_tx_tsu_timestamp(cb_uwbsystem_tx_tsutimestamp_st * outTxTsu)
+CB_RAM_CODE void cb_system_uwb_get_tx_tsu_timestamp(cb_uwbsystem_tx_tsutimestamp_st * outTxTsu)
 {
   cb_uwbdriver_get_tx_tsu_timestamp(outTxTsu);
 }
@@ -1220,7 +1226,7 @@ void cb_system_uwb_get_rx_raw_timestamp(cb_uwbsystem_rx_tsu_st* rxTsu)
  *                      RX TSU timestamp will be stored.
  * @param enRxPort        The RX port identifier used for fetching the RX TSU data.
  */
-void cb_system_uwb_get_rx_tsu_timestamp(cb_uwbsystem_rx_tsutimestamp_st* rxTsuTimestamp, cb_uwbsystem_rxport_en enRxPort)
+CB_RAM_CODE void cb_system_uwb_get_rx_tsu_timestamp(cb_uwbsystem_rx_tsutimestamp_st* rxTsuTimestamp, cb_uwbsystem_rxport_en enRxPort)
 {
   cb_uwbdriver_get_rx_tsu_timestamp(rxTsuTimestamp, enRxPort);
 }
@@ -1243,6 +1249,35 @@ void cb_system_uwb_store_rx_cir_register(cb_uwbsystem_rx_cir_iqdata_st* destArra
   cb_uwbdriver_store_rx_cir_register(destArray, enRxPort, startingPosition, numSamples);
 }
 
+/**
+ * @brief Get the bus address of a sample in the RX CIR register memory.
+ *
+ * @param enRxPort RX port number (EN_UWB_RX_0, EN_UWB_RX_1 or EN_UWB_RX_2).
+ * @param startingPosition Offset within the CIR register memory.
+ * @param numSamples Number of `cb_uwbsystem_rx_cir_iqdata_st` samples to be read.
+ *
+ * @return Address of the first sample, or 0 if the port or window is invalid.
+ */
+uint32_t cb_system_uwb_get_rx_cir_register_addr(cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples)
+{
+  uint32_t portIdx = 0;
+
+  if ((startingPosition + numSamples) > DEF_UWB_RX_CIR_REGISTER_NUM_SAMPLES)
+  {
+    return 0;
+  }
+
+  switch (enRxPort)
+  {
+    case EN_UWB_RX_0: portIdx = 0; break;
+    case EN_UWB_RX_1: portIdx = 1; break;
+    case EN_UWB_RX_2: portIdx = 2; break;
+    default:          return 0;
+  }
+
+  return DEF_UWB_RX_CIR_REGISTER_BASE_ADDR + (portIdx * DEF_UWB_RX_CIR_REGISTER_PORT_STRIDE) + (startingPosition * sizeof(cb_uwbsystem_rx_cir_iqdata_st));
+}
+
 cb_uwbalg_poa_outputperpacket_st cb_system_uwb_pdoa_cir_processing(enUwbPdoaCalType calType, uint8_t packageNum, const uint8_t numRxUsed, const cb_uwbsystem_rx_cir_iqdata_st *cirRegisterData, uint16_t cirDataSize)
 {
   return cb_uwbalg_pdoa_cir_post_processing(calType, packageNum, numRxUsed, cirRegisterData, cirDataSize);
@@ -1325,7 +1360,7 @@ void cb_system_uwb_get_rx_etc_status_register(cb_uwbsystem_rx_etc_statusregister
  *
  * @return Status register value.
  */
-cb_uwbsystem_rxstatus_un cb_system_uwb_get_rx_status(void)
+CB_RAM_CODE cb_uwbsystem_rxstatus_un cb_system_uwb_get_rx_status(void)
 {
   return cb_uwbdriver_get_uwb_rx_status_register();
 }
@@ -1346,7 +1381,7 @@ uint16_t cb_system_uwb_get_rx_cir_ctl_idx(void)
  * 
  * @param enAbsoluteTimer The absolute timer to enable.
  */
-void cb_system_uwb_abs_timer_on(enUwbAbsoluteTimer enAbsoluteTimer)
+CB_RAM_CODE void cb_system_uwb_abs_timer_on(enUwbAbsoluteTimer enAbsoluteTimer)
 {
   cb_uwbdriver_abs_timer_on(enAbsoluteTimer);
 }
@@ -1356,7 +1391,7 @@ void cb_system_uwb_abs_timer_on(enUwbAbsoluteTimer enAbsoluteTimer)
  * 
  * @param enAbsoluteTimer The absolute timer to disable.
  */
-void cb_system_uwb_abs_timer_off(enUwbAbsoluteTimer enAbsoluteTimer)
+CB_RAM_CODE void cb_system_uwb_abs_timer_off(enUwbAbsoluteTimer enAbsoluteTimer)
 {
   cb_uwbdriver_abs_timer_off(enAbsoluteTimer);
 }
@@ -1366,7 +1401,7 @@ void cb_system_uwb_abs_timer_off(enUwbAbsoluteTimer enAbsoluteTimer)
  * 
  * @param enAbsoluteTimer The absolute timer to clear.
  */
-void cb_system_uwb_abs_timer_clear_internal_occurence(enUwbAbsoluteTimer enAbsoluteTimer)
+CB_RAM_CODE void cb_system_uwb_abs_timer_clear_internal_occurence(enUwbAbsoluteTimer enAbsoluteTimer)
 {
   cb_uwbdriver_abs_timer_clear_internal_occurence (enAbsoluteTimer);
 }
@@ -1378,7 +1413,7 @@ void cb_system_uwb_abs_timer_clear_internal_occurence(enUwbAbsoluteTimer enAbsol
  * @param baseTime The base time for the timer.
  * @param targetTimeoutTime The target timeout time.
  */
-void cb_system_uwb_abs_timer_configure_timeout_value(enUwbAbsoluteTimer enAbsoluteTimer, uint32_t baseTime, uint32_t targetTimeoutTime)
+CB_RAM_CODE void cb_system_uwb_abs_timer_configure_timeout_value(enUwbAbsoluteTimer enAbsoluteTimer, uint32_t baseTime, uint32_t targetTimeoutTime)
 {
   uint32_t timeoutValue = 0;
   
@@ -1399,7 +1434,7 @@ void cb_system_uwb_abs_timer_configure_timeout_value(enUwbAbsoluteTimer enAbsolu
  * @param enAbsoluteTimer The absolute timer to configure.
  * @param uwbEventControl The event control settings.
  */
-void cb_system_uwb_abs_timer_configure_event_commander(enUwbEnable control, enUwbAbsoluteTimer enAbsoluteTimer, enUwbEventControl uwbEventControl)
+CB_RAM_CODE void cb_system_uwb_abs_timer_configure_event_commander(enUwbEnable control, enUwbAbsoluteTimer enAbsoluteTimer, enUwbEventControl uwbEventControl)
 {
   cb_uwbdriver_abs_timer_configure_event_commander(control, enAbsoluteTimer,uwbEventControl);  
 }
@@ -1409,7 +1444,7 @@ void cb_system_uwb_abs_timer_configure_event_commander(enUwbEnable control, enUw
  * 
  * @param enable Enable or disable control.
  */
-void cb_system_uwb_enable_event_timestamp(enUwbEnable enable)
+CB_RAM_CODE void cb_system_uwb_enable_event_timestamp(enUwbEnable enable)
 {
   cb_uwbdriver_enable_event_timestamp(enable);
 }
@@ -1420,7 +1455,7 @@ void cb_system_uwb_enable_event_timestamp(enUwbEnable enable)
  * @param eventTimestampMask The mask for the event timestamp.
  * @param uwbEventIndex The index of the UWB event.
  */
-void cb_system_uwb_configure_event_timestamp_mask(enUwbEventTimestampMask eventTimestampMask,enUwbEventIndex uwbEventIndex)
+CB_RAM_CODE void cb_system_uwb_configure_event_timestamp_mask(enUwbEventTimestampMask eventTimestampMask,enUwbEventIndex uwbEventIndex)
 {
   cb_uwbdriver_configure_event_timestamp_mask(eventTimestampMask, uwbEventIndex);
 }
@@ -1431,11 +1466,21 @@ void cb_system_uwb_configure_event_timestamp_mask(enUwbEventTimestampMask eventT
  * @param eventTimestampMask The mask for the event timestamp.
  * @return The value of the event timestamp.
  */
-uint32_t cb_system_uwb_get_event_timestamp_in_ns(enUwbEventTimestampMask eventTimestampMask)
+CB_RAM_CODE uint32_t cb_system_uwb_get_event_timestamp_in_ns(enUwbEventTimestampMask eventTimestampMask)
 {
   return cb_uwbdriver_get_event_timestamp_in_ns(eventTimestampMask);
 }
 
+/**
+ * @brief Inserts a UWB event from software, e.g. to timestamp it.
+ * 
+ * @param uwbEventIndex The index of the UWB event.
+ */
+CB_RAM_CODE void cb_system_uwb_insert_apb_event(enUwbEventIndex uwbEventIndex)
+{
+  cb_uwbdriver_insert_apb_event(uwbEventIndex);
+}
+
 /**
  * @brief Clears the TSU (Timestamp Unit).
  */
@@ -565,6 +565,22 @@ void cb_system_uwb_store_rx_tsu_status(cb_uwbsystem_rx_tsustatus_st* p_rxTsuStat
  */
 void cb_system_uwb_store_rx_cir_register(cb_uwbsystem_rx_cir_iqdata_st* destArray, cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples);
 
+/**
+ * @brief Get the bus address of a sample in the RX CIR register memory.
+ *
+ * Returns the address that `cb_system_uwb_store_rx_cir_register` reads from, so that
+ * the CIR window can be copied by a bus master (e.g. DMA) instead of the CPU.
+ * The CIR memory map is not documented by the UWB library: the address is not verified on
+ * hardware yet.
+ *
+ * @param enRxPort RX port number (EN_UWB_RX_0, EN_UWB_RX_1 or EN_UWB_RX_2).
+ * @param startingPosition Offset within the CIR register memory.
+ * @param numSamples Number of `cb_uwbsystem_rx_cir_iqdata_st` samples to be read.
+ *
+ * @return Address of the first sample, or 0 if the port or window is invalid.
+ */
+uint32_t cb_system_uwb_get_rx_cir_register_addr(cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples);
+
 /**
  * @brief Processes the CIR (Channel Impulse Response) data for UWB PDOA (Phase Difference of Arrival).
  *
@@ -758,6 +774,13 @@ void cb_system_uwb_configure_event_timestamp_mask(enUwbEventTimestampMask eventT
  */
 uint32_t cb_system_uwb_get_event_timestamp_in_ns(enUwbEventTimestampMask eventTimestampMask);
 
+/**
+ * @brief Inserts a UWB event from software, e.g. to timestamp it.
+ * 
+ * @param uwbEventIndex The index of the UWB event.
+ */
+void cb_system_uwb_insert_apb_event(enUwbEventIndex uwbEventIndex);
+
 /**
  * @brief Clears the TSU (Timestamp Unit).
  */
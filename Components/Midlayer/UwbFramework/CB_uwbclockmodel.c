@@ -0,0 +1,232 @@
+/**
+ * @file    CB_uwbclockmodel.c
+ * @brief   Clock model of a periodic sync pulse: offset and drift of the local clock.
+ * @details Pulse window, least squares fit, outlier rejection, statistics and time translation.
+ *          See CB_uwbclockmodel.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "CB_uwbclockmodel.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static int64_t cb_uwbclockmodel_round(double value);
+static void cb_uwbclockmodel_store(cb_uwbclockmodel_st *model, uint32_t index, int64_t localNs);
+static void cb_uwbclockmodel_fit(cb_uwbclockmodel_st *model);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Round to the nearest integer, halves away from zero.
+ */
+static int64_t cb_uwbclockmodel_round(double value)
+{
+  return (int64_t)((value >= 0.0) ? (value + 0.5) : (value - 0.5));
+}
+
+/**
+ * @brief Add a capture to the window, replacing the oldest when full.
+ */
+static void cb_uwbclockmodel_store(cb_uwbclockmodel_st *model, uint32_t index, int64_t localNs)
+{
+  model->newest = (model->count == 0U) ? 0U : (uint8_t)((model->newest + 1U) % DEF_UWB_CLOCKMODEL_WINDOW);
+  model->local[model->newest] = localNs;
+  model->index[model->newest] = index;
+  if (model->count < DEF_UWB_CLOCKMODEL_WINDOW)
+  {
+    model->count++;
+  }
+}
+
+/**
+ * @brief Least squares fit of the window, relative to the newest pulse to keep the precision.
+ */
+static void cb_uwbclockmodel_fit(cb_uwbclockmodel_st *model)
+{
+  double sumX  = 0.0;
+  double sumY  = 0.0;
+  double sumXX = 0.0;
+  double sumXY = 0.0;
+  double n     = (double)model->count;
+
+  if (model->count < 2U)
+  {
+    model->slope     = (double)model->periodNs;
+    model->intercept = 0.0;
+    return;
+  }
+  for (uint8_t i = 0; i < model->count; i++)
+  {
+    uint8_t slot = (uint8_t)((model->newest + DEF_UWB_CLOCKMODEL_WINDOW - i) % DEF_UWB_CLOCKMODEL_WINDOW);
+    double  x    = (double)(int32_t)(model->index[slot] - model->index[model->newest]);
+    double  y    = (double)(model->local[slot] - model->local[model->newest]);
+    sumX  += x;
+    sumY  += y;
+    sumXX += x * x;
+    sumXY += x * y;
+  }
+  model->slope     = ((n * sumXY) - (sumX * sumY)) / ((n * sumXX) - (sumX * sumX));
+  model->intercept = (sumY - (model->slope * sumX)) / n;
+}
+
+/**
+ * @brief Clear the model and its statistics.
+ */
+void cb_uwbclockmodel_reset(cb_uwbclockmodel_st *model, uint32_t periodNs)
+{
+  memset(model, 0, sizeof(cb_uwbclockmodel_st));
+  model->periodNs = periodNs;
+  model->slope    = (double)periodNs;
+}
+
+/**
+ * @brief Add the capture of a pulse.
+ */
+cb_uwbclockmodel_result_en cb_uwbclockmodel_add_pulse(cb_uwbclockmodel_st *model, int64_t localNs)
+{
+  cb_uwbclockmodel_stats_st *stats = &model->stats;
+  int64_t  interval;
+  int64_t  periods;
+  uint32_t index;
+  double   error;
+  double   tolerance;
+
+  stats->pulses++;
+  if (model->count == 0U)
+  {
+    stats->accepted++;
+    cb_uwbclockmodel_store(model, 0, localNs);
+    return EN_UWB_CLOCKMODEL_ACCEPTED;
+  }
+
+  // Periods since the last pulse, more than one if pulses were missed
+  interval = localNs - model->local[model->newest];
+  periods  = cb_uwbclockmodel_round((double)interval / model->slope);
+  if (model->locked)
+  {
+    error     = (double)interval - (model->intercept + (model->slope * (double)periods));
+    tolerance = (double)DEF_UWB_CLOCKMODEL_TRACK_TOL_NS * (double)periods;
+  }
+  else
+  {
+    error     = (double)interval - (model->slope * (double)periods);
+    tolerance = (double)DEF_UWB_CLOCKMODEL_ACQUIRE_TOL_NS * (double)periods;
+  }
+
+  if ((periods < 1) || (error > tolerance) || (error < -tolerance))
+  {
+    stats->outliers++;
+    if (++model->outlierRun < DEF_UWB_CLOCKMODEL_OUTLIER_MAX)
+    {
+      return EN_UWB_CLOCKMODEL_OUTLIER;
+    }
+    // The last fit no longer matches the pulses: start again from this one
+    index = model->index[model->newest] + (uint32_t)((periods < 1) ? 1 : periods);
+    stats->restarts++;
+    model->count      = 0;
+    model->locked     = 0;
+    model->outlierRun = 0;
+    cb_uwbclockmodel_store(model, index, localNs);
+    cb_uwbclockmodel_fit(model);
+    return EN_UWB_CLOCKMODEL_RESTARTED;
+  }
+
+  // Pulses between the last two accepted, not counting the rejected captures
+  stats->missed += ((uint32_t)(periods - 1) > model->outlierRun) ? ((uint32_t)(periods - 1) - model->outlierRun) : 0U;
+  model->outlierRun = 0;
+  stats->accepted++;
+  if (model->locked)
+  {
+    double absError = (error < 0.0) ? -error : error;
+    stats->residualCount++;
+    stats->residualSumSq += error * error;
+    if (absError > (double)stats->residualMaxNs)
+    {
+      stats->residualMaxNs = (uint32_t)absError;
+    }
+    if (periods == 1)
+    {
+      double jitter = (double)interval - model->slope;
+      jitter = (jitter < 0.0) ? -jitter : jitter;
+      stats->jitterCount++;
+      stats->jitterSumSq += jitter * jitter;
+      if (jitter > (double)stats->jitterMaxNs)
+      {
+        stats->jitterMaxNs = (uint32_t)jitter;
+      }
+    }
+  }
+
+  index = model->index[model->newest] + (uint32_t)periods;
+  cb_uwbclockmodel_store(model, index, localNs);
+  cb_uwbclockmodel_fit(model);
+  model->locked = (model->count >= DEF_UWB_CLOCKMODEL_MIN_PULSES) ? 1U : 0U;
+  return EN_UWB_CLOCKMODEL_ACCEPTED;
+}
+
+/**
+ * @brief Set the index of the last pulse.
+ */
+void cb_uwbclockmodel_set_pulse_index(cb_uwbclockmodel_st *model, uint32_t index)
+{
+  uint32_t shift = index - model->index[model->newest];
+
+  for (uint8_t i = 0; i < DEF_UWB_CLOCKMODEL_WINDOW; i++)
+  {
+    model->index[i] += shift;
+  }
+}
+
+/**
+ * @brief Network time of a local time.
+ */
+int64_t cb_uwbclockmodel_local_to_network(const cb_uwbclockmodel_st *model, int64_t localNs)
+{
+  double periods = ((double)(localNs - model->local[model->newest]) - model->intercept) / model->slope;
+
+  return ((int64_t)model->index[model->newest] * model->periodNs) + cb_uwbclockmodel_round(periods * (double)model->periodNs);
+}
+
+/**
+ * @brief Local time of a network time.
+ */
+int64_t cb_uwbclockmodel_network_to_local(const cb_uwbclockmodel_st *model, int64_t networkNs)
+{
+  double periods = (double)(networkNs - ((int64_t)model->index[model->newest] * model->periodNs)) / (double)model->periodNs;
+
+  return model->local[model->newest] + cb_uwbclockmodel_round(model->intercept + (periods * model->slope));
+}
+
+/**
+ * @brief Drift of the local clock against network time.
+ */
+float cb_uwbclockmodel_drift_ppm(const cb_uwbclockmodel_st *model)
+{
+  return (float)(((model->slope / (double)model->periodNs) - 1.0) * 1e6);
+}
@@ -0,0 +1,159 @@
+/**
+ * @file    CB_uwbclockmodel.h
+ * @brief   Clock model of a periodic sync pulse: offset and drift of the local clock.
+ * @details The captures of a sync pulse of nominal period periodNs, in local time (ns), are fitted
+ *          by least squares over the last DEF_UWB_CLOCKMODEL_WINDOW pulses:
+ *            local(k) = a + b * k
+ *          with k the pulse index and b the local duration of a period. Network time is the pulse
+ *          index scaled by the nominal period, network(k) = k * periodNs: the pulses define it, b
+ *          gives the drift of the local clock against it.
+ *          Missed pulses are counted from the gap to the previous one. A capture too far from the
+ *          nominal period (acquisition) or from the model (locked) is rejected as an outlier, and
+ *          DEF_UWB_CLOCKMODEL_OUTLIER_MAX consecutive ones restart the acquisition from the last.
+ *          Statistics while locked: period jitter (interval between consecutive pulses minus b) and
+ *          residual (capture minus the prediction of the model before it), RMS and maximum.
+ *          No hardware access: the module can be built and tested on a host.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_UWBCLOCKMODEL_H
+#define __CB_UWBCLOCKMODEL_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DEF_UWB_CLOCKMODEL_WINDOW
+#define DEF_UWB_CLOCKMODEL_WINDOW         8       /**< Pulses of the fit */
+#endif
+#ifndef DEF_UWB_CLOCKMODEL_MIN_PULSES
+#define DEF_UWB_CLOCKMODEL_MIN_PULSES     3       /**< Pulses of the fit to be locked */
+#endif
+#ifndef DEF_UWB_CLOCKMODEL_ACQUIRE_TOL_NS
+#define DEF_UWB_CLOCKMODEL_ACQUIRE_TOL_NS 200000  /**< Acquisition: interval to the nominal period(s), per period */
+#endif
+#ifndef DEF_UWB_CLOCKMODEL_TRACK_TOL_NS
+#define DEF_UWB_CLOCKMODEL_TRACK_TOL_NS   2000    /**< Locked: capture to the model, per period since the last pulse */
+#endif
+#ifndef DEF_UWB_CLOCKMODEL_OUTLIER_MAX
+#define DEF_UWB_CLOCKMODEL_OUTLIER_MAX    4       /**< Consecutive outliers restarting the acquisition */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+/**
+ * @brief Result of a pulse capture.
+ */
+typedef enum
+{
+  EN_UWB_CLOCKMODEL_ACCEPTED = 0,   /**< Added to the fit */
+  EN_UWB_CLOCKMODEL_OUTLIER,        /**< Rejected */
+  EN_UWB_CLOCKMODEL_RESTARTED,      /**< Rejected too many times: acquisition restarted from this pulse */
+} cb_uwbclockmodel_result_en;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Counters and running sums, since the reset.
+ */
+typedef struct
+{
+  uint32_t pulses;                /**< Captures */
+  uint32_t accepted;
+  uint32_t missed;                /**< Pulses not captured, from the gaps */
+  uint32_t outliers;
+  uint32_t restarts;
+  uint32_t jitterCount;           /**< Single period intervals while locked */
+  double   jitterSumSq;           /**< ns^2 */
+  uint32_t jitterMaxNs;
+  uint32_t residualCount;         /**< Captures accepted while locked */
+  double   residualSumSq;         /**< ns^2 */
+  uint32_t residualMaxNs;
+} cb_uwbclockmodel_stats_st;
+
+/**
+ * @brief Clock model, see cb_uwbclockmodel_reset().
+ */
+typedef struct
+{
+  uint32_t periodNs;                                /**< Nominal pulse period */
+  int64_t  local[DEF_UWB_CLOCKMODEL_WINDOW];        /**< Captures of the fit, ns */
+  uint32_t index[DEF_UWB_CLOCKMODEL_WINDOW];        /**< Their pulse index */
+  uint8_t  count;
+  uint8_t  newest;                                  /**< Slot of the last capture */
+  uint8_t  locked;
+  uint8_t  outlierRun;
+  double   slope;                                   /**< Local ns per period */
+  double   intercept;                               /**< Fit at the newest pulse minus its capture, ns */
+  cb_uwbclockmodel_stats_st stats;
+} cb_uwbclockmodel_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Clear the model and its statistics.
+ *
+ * @param model    Model.
+ * @param periodNs Nominal pulse period.
+ */
+void cb_uwbclockmodel_reset(cb_uwbclockmodel_st *model, uint32_t periodNs);
+
+/**
+ * @brief Add the capture of a pulse.
+ *
+ * @param model   Model.
+ * @param localNs Capture, local time increasing over the run (no wrap).
+ * @return Result of the capture.
+ */
+cb_uwbclockmodel_result_en cb_uwbclockmodel_add_pulse(cb_uwbclockmodel_st *model, int64_t localNs);
+
+/**
+ * @brief Set the index of the last pulse, e.g. received from the sync master, to agree on network time.
+ *
+ * @param model Model with at least a pulse.
+ * @param index Pulse index, network time index * periodNs. Indices start at 0 otherwise.
+ */
+void cb_uwbclockmodel_set_pulse_index(cb_uwbclockmodel_st *model, uint32_t index);
+
+/**
+ * @brief Network time of a local time.
+ *
+ * @param model   Model with at least a pulse.
+ * @param localNs Local time, same scale as the captures.
+ * @return Network time, ns.
+ */
+int64_t cb_uwbclockmodel_local_to_network(const cb_uwbclockmodel_st *model, int64_t localNs);
+
+/**
+ * @brief Local time of a network time.
+ *
+ * @param model     Model with at least a pulse.
+ * @param networkNs Network time, ns.
+ * @return Local time, same scale as the captures.
+ */
+int64_t cb_uwbclockmodel_network_to_local(const cb_uwbclockmodel_st *model, int64_t networkNs);
+
+/**
+ * @brief Drift of the local clock against network time.
+ *
+ * @param model Model.
+ * @return Parts per million, positive if the local clock is fast.
+ */
+float cb_uwbclockmodel_drift_ppm(const cb_uwbclockmodel_st *model);
+
+#endif /*__CB_UWBCLOCKMODEL_H*/
@@ -20,10 +20,13 @@
 #include "CB_system.h"
 #include "CB_UwbDrivers.h"
 #include "CB_aoa.h"
+#include "CB_dma.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
 //-------------------------------
+#define DEF_PDOA_CIR_SNAPSHOT_DMA_CHANNEL       EN_DMA_CHANNEL_2  // DMA channel reserved for PDoA CIR snapshot
+#define DEF_PDOA_CIR_SNAPSHOT_WAIT_TIMEOUT_US   200               // Max wait for an in-flight snapshot
 
 //-------------------------------
 // DEFINE SECTION
@@ -36,6 +39,19 @@
 //-------------------------------
 // STRUCT/UNION SECTION
 //-------------------------------
+/**
+ * @brief State of the DMA-backed PDoA CIR snapshot engine
+ */
+typedef struct
+{
+  struct stDMALinkedListHead stHead;                              /**< First RX port window */
+  struct stDMALinkedListNode stNode[DEF_PDOA_NUM_RX_USED - 1];    /**< Remaining RX port windows */
+  cb_uwbsystem_rxport_en     enRxPorts;                           /**< RX ports captured per snapshot */
+  uint8_t                    initialized;                         /**< Engine initialized */
+  volatile uint8_t           busy;                                /**< DMA transfer in flight */
+  volatile uint8_t           activeSlot;                          /**< Slot being written by the DMA */
+  volatile uint32_t          readyMask;                           /**< Bit n set: slot n holds a complete snapshot */
+} cb_uwbframework_cirsnapshot_st;
 
 //-------------------------------
 // GLOBAL VARIABLE SECTION
@@ -44,6 +60,9 @@ cb_uwbsystem_rx_cir_iqdata_st     g_stPdoaRxCirDataContainer[DEF_PDOA_NUMPKT_SUP
 cb_uwbalg_poa_outputperpacket_st  g_stPoaResult[DEF_PDOA_NUMPKT_SUPERFRAME_MAX];
 
 static cb_uwbsystem_rx_dbb_config_st s_stRxCfg_CfoGainBypass;
+static cb_uwbframework_cirsnapshot_st s_stCirSnapshot;
+static double s_pdoaPacketEstimated[3][DEF_PDOA_NUMPKT_SUPERFRAME_MAX];  // Per-pair PDoA of each processed packet (0:Rx0-Rx1, 1: Rx1-Rx2, 2: Rx0-Rx2)
+static uint32_t s_pdoaProcessedMask;                                     // Bit n set: packet n processed
 
 extern const uint8_t lut_binary_data_start[];
 
@@ -231,7 +250,7 @@ void cb_framework_uwb_qmode_rx_end (void)
  * @param stTxIrqEnable Interrupt enable configuration for transmission
  * @param trxStartMode Start mode (immediate or deferred)
  */
-void cb_framework_uwb_tx_start(cb_uwbsystem_packetconfig_st* txPacketConfig, cb_uwbsystem_txpayload_st* txPayload, cb_uwbsystem_tx_irqenable_st* stTxIrqEnable, cb_uwbframework_trx_startmode_en trxStartMode)
+CB_RAM_CODE void cb_framework_uwb_tx_start(cb_uwbsystem_packetconfig_st* txPacketConfig, cb_uwbsystem_txpayload_st* txPayload, cb_uwbsystem_tx_irqenable_st* stTxIrqEnable, cb_uwbframework_trx_startmode_en trxStartMode)
 {
   cb_system_uwb_tx_init     ();                                      // TX Init
   cb_system_uwb_config_tx   (txPacketConfig, txPayload, stTxIrqEnable);// TX Config
@@ -253,7 +272,7 @@ void cb_framework_uwb_tx_start(cb_uwbsystem_packetconfig_st* txPacketConfig, cb_
  * This function ends the UWB communication transmitter in normal mode by performing various cleanup steps.
  * It releases the allocated resources and resets the UWB communication system.
  */
-void cb_framework_uwb_tx_end(void)
+CB_RAM_CODE void cb_framework_uwb_tx_end(void)
 {
   cb_system_uwb_tx_stop();  // TX Stop
   cb_system_uwb_tx_off();   // TX Off
@@ -312,7 +331,7 @@ void cb_framework_uwb_rx_start(cb_uwbsystem_rxport_en enRxPort, cb_uwbsystem_pac
  * 
  * @param enRxPort The RX port to stop
  */
-void cb_framework_uwb_rx_end(cb_uwbsystem_rxport_en enRxPort)
+CB_RAM_CODE void cb_framework_uwb_rx_end(cb_uwbsystem_rxport_en enRxPort)
 {
   cb_system_uwb_rx_stop    (enRxPort);
   cb_system_uwb_rx_off     (enRxPort);
@@ -416,7 +435,7 @@ uint8_t cb_framework_uwb_get_rx_phr_ranging_bit(cb_uwbsystem_packetconfig_st* co
  * 
  * @return cb_uwbsystem_rxstatus_un The current RX status
  */
-cb_uwbsystem_rxstatus_un cb_framework_uwb_get_rx_status(void)
+CB_RAM_CODE cb_uwbsystem_rxstatus_un cb_framework_uwb_get_rx_status(void)
 {
   return cb_system_uwb_get_rx_status();
 }
@@ -460,7 +479,7 @@ void cb_framework_uwb_get_tx_raw_timestamp(cb_uwbsystem_tx_timestamp_st* txTimes
  * @param rxTsuTimestamp Pointer to store the RX TSU timestamp
  * @param enRxPort The RX port from which to get the timestamp
  */
-void cb_framework_uwb_get_rx_tsu_timestamp(cb_uwbsystem_rx_tsutimestamp_st* rxTsuTimestamp, cb_uwbsystem_rxport_en enRxPort)
+CB_RAM_CODE void cb_framework_uwb_get_rx_tsu_timestamp(cb_uwbsystem_rx_tsutimestamp_st* rxTsuTimestamp, cb_uwbsystem_rxport_en enRxPort)
 {
   cb_system_uwb_get_rx_tsu_timestamp(rxTsuTimestamp, enRxPort);
 }
@@ -470,7 +489,7 @@ void cb_framework_uwb_get_rx_tsu_timestamp(cb_uwbsystem_rx_tsutimestamp_st* rxTs
  * 
  * @param txTsuTimestamp Pointer to store the TX TSU timestamp
  */
-void cb_framework_uwb_get_tx_tsu_timestamp(cb_uwbsystem_tx_tsutimestamp_st *txTsuTimestamp)
+CB_RAM_CODE void cb_framework_uwb_get_tx_tsu_timestamp(cb_uwbsystem_tx_tsutimestamp_st *txTsuTimestamp)
 {
   cb_system_uwb_get_tx_tsu_timestamp(txTsuTimestamp);
 }
@@ -622,7 +641,7 @@ void cb_framework_uwb_configure_event_time_stamp_mask(enUwbEventTimestampMask ev
  * 
  * @param repeatedTrxConfig Configuration for scheduled transactions
  */
-void cb_framework_uwb_enable_scheduled_trx(cb_uwbframework_trx_scheduledconfig_st repeatedTrxConfig)
+CB_RAM_CODE void cb_framework_uwb_enable_scheduled_trx(cb_uwbframework_trx_scheduledconfig_st repeatedTrxConfig)
 {
   cb_system_uwb_configure_event_timestamp_mask (repeatedTrxConfig.eventTimestampMask, repeatedTrxConfig.eventIndex);  
   cb_system_uwb_enable_event_timestamp         (EN_UWB_ENABLE);
@@ -634,7 +653,7 @@ void cb_framework_uwb_enable_scheduled_trx(cb_uwbframework_trx_scheduledconfig_s
  * 
  * @param repeatedTrxConfig Configuration for scheduled transactions
  */
-void cb_framework_uwb_disable_scheduled_trx(cb_uwbframework_trx_scheduledconfig_st repeatedTrxConfig)
+CB_RAM_CODE void cb_framework_uwb_disable_scheduled_trx(cb_uwbframework_trx_scheduledconfig_st repeatedTrxConfig)
 {
   cb_system_uwb_abs_timer_configure_event_commander(EN_UWB_DISABLE,
                                                     repeatedTrxConfig.absTimer,
@@ -648,7 +667,7 @@ void cb_framework_uwb_disable_scheduled_trx(cb_uwbframework_trx_scheduledconfig_
  * 
  * @param repeatedTrxConfig Configuration for scheduled transactions
  */
-void cb_framework_uwb_configure_scheduled_trx(cb_uwbframework_trx_scheduledconfig_st repeatedTrxConfig)
+CB_RAM_CODE void cb_framework_uwb_configure_scheduled_trx(cb_uwbframework_trx_scheduledconfig_st repeatedTrxConfig)
 {  
   cb_system_uwb_abs_timer_configure_timeout_value  (repeatedTrxConfig.absTimer,
                                                     cb_system_uwb_get_event_timestamp_in_ns(repeatedTrxConfig.eventTimestampMask),
@@ -707,6 +726,216 @@ void cb_framework_uwb_pdoa_store_cir_data(uint8_t countOfPdoaScheduledRx)
   cb_system_uwb_store_rx_cir_register(g_stPdoaRxCirDataContainer[countOfPdoaScheduledRx][2], EN_UWB_RX_2, (cb_system_uwb_get_rx_cir_ctl_idx() - DEF_PDOA_CIR_DATASET_OFFSET), DEF_PDOA_NUM_CIR_DATASET);
 }
 
+//----------------------------------------------------------------//
+//                 PDOA CIR SNAPSHOT (DMA) API                    //
+//----------------------------------------------------------------//
+/**
+ * @brief Initialize the DMA-backed CIR snapshot engine for PDoA
+ *
+ * @param enRxPorts RX ports to be captured per snapshot (e.g. EN_UWB_RX_ALL or EN_UWB_RX_02)
+ */
+void cb_framework_uwb_pdoa_cir_snapshot_init(cb_uwbsystem_rxport_en enRxPorts)
+{
+  memset(&s_stCirSnapshot, 0x00, sizeof(s_stCirSnapshot));
+  s_stCirSnapshot.enRxPorts   = enRxPorts;
+  s_stCirSnapshot.initialized = CB_TRUE;
+  if (cb_dma_is_enabled() != CB_TRUE)
+  {
+    cb_dma_init(); // Only when off: cb_dma_init() clears the requests of every channel
+  }
+}
+
+/**
+ * @brief Stop the CIR snapshot engine and release its DMA channel
+ */
+void cb_framework_uwb_pdoa_cir_snapshot_deinit(void)
+{
+  if (s_stCirSnapshot.initialized == CB_TRUE)
+  {
+    cb_dma_disable_channel(&s_stCirSnapshot.stHead.DMAConfig);
+  }
+  memset(&s_stCirSnapshot, 0x00, sizeof(s_stCirSnapshot));
+}
+
+/**
+ * @brief Mark the in-flight snapshot as complete and release the DMA channel
+ */
+static void cb_framework_uwb_pdoa_cir_snapshot_complete(void)
+{
+  if (s_stCirSnapshot.busy == CB_TRUE)
+  {
+    cb_dma_disable_channel(&s_stCirSnapshot.stHead.DMAConfig);
+    s_stCirSnapshot.readyMask |= (1UL << s_stCirSnapshot.activeSlot);
+    s_stCirSnapshot.busy       = CB_FALSE;
+  }
+}
+
+/**
+ * @brief Copy the CIR of a slot by the CPU and mark it ready
+ *
+ * @param slot Slot of the CIR data container
+ */
+static void cb_framework_uwb_pdoa_cir_snapshot_cpu_copy(uint8_t slot)
+{
+  cb_framework_uwb_pdoa_store_cir_data(slot);
+  s_stCirSnapshot.readyMask |= (1UL << slot);
+}
+
+/**
+ * @brief Fill one DMA descriptor with a CIR window copy
+ *
+ * @param pDmaConfig Descriptor to be filled
+ * @param srcAddr CIR register memory address of the window
+ * @param destArray Destination slot for the window
+ * @param lliIdx Position of the descriptor in the list, selects the flow control pair
+ */
+static void cb_framework_uwb_pdoa_cir_snapshot_fill_desc(stDMAConfig* pDmaConfig, uint32_t srcAddr, cb_uwbsystem_rx_cir_iqdata_st* destArray, uint8_t lliIdx)
+{
+  pDmaConfig->DMAChannel      = DEF_PDOA_CIR_SNAPSHOT_DMA_CHANNEL;
+  pDmaConfig->IRQEnable       = EN_DMA_IRQ_ENABLE;
+  pDmaConfig->SrcAddr         = srcAddr;
+  pDmaConfig->DestAddr        = (uint32_t)destArray;
+  pDmaConfig->DataLen         = DEF_PDOA_NUM_CIR_DATASET * sizeof(cb_uwbsystem_rx_cir_iqdata_st);
+  pDmaConfig->DataWidth       = EN_DMA_DATA_WIDTH_WORD;
+  pDmaConfig->SrcInc          = EN_DMA_SRC_ADDR_INC_ENABLE;
+  pDmaConfig->DestInc         = EN_DMA_DEST_ADDR_INC_ENABLE;
+  pDmaConfig->ContinuousMode  = EN_DMA_CONTINUOUS_MODE_DISABLE;
+  pDmaConfig->TransferType    = EN_DMA_TRANSFER_TYPE_MULTI;
+  pDmaConfig->FlowControlSrc  = (enDMAFlowControlSrc)(EN_DMA_FLOW_CONTROL_SRC_SEL_0 + (2 * lliIdx));
+  pDmaConfig->FlowControlDest = (enDMAFlowControlDest)(EN_DMA_FLOW_CONTROL_DEST_SEL_1 + (2 * lliIdx));
+}
+
+/**
+ * @brief Start a background CIR snapshot for a scheduled PDoA reception
+ *
+ * @param countOfPdoaScheduledRx Count of scheduled PDoA receptions
+ * @return CB_TRUE if the snapshot was queued on DMA, CB_FALSE if it was copied by the CPU
+ */
+uint8_t cb_framework_uwb_pdoa_cir_snapshot_start(uint8_t countOfPdoaScheduledRx)
+{
+  static const cb_uwbsystem_rxport_en s_enPortList[DEF_PDOA_NUM_RX_USED] = { EN_UWB_RX_0, EN_UWB_RX_1, EN_UWB_RX_2 };
+  uint8_t  slot             = countOfPdoaScheduledRx % DEF_PDOA_NUMPKT_SUPERFRAME_MAX;
+  uint32_t startingPosition = cb_system_uwb_get_rx_cir_ctl_idx() - DEF_PDOA_CIR_DATASET_OFFSET;
+  stDMAConfig* pDesc[DEF_PDOA_NUM_RX_USED];
+  uint8_t  numDesc          = 0;
+
+  s_stCirSnapshot.readyMask &= ~(1UL << slot);
+
+  if ((s_stCirSnapshot.initialized != CB_TRUE) || (cb_framework_uwb_pdoa_cir_snapshot_wait(0) != CB_TRUE))
+  {
+    // Engine not available or previous snapshot stuck: copy synchronously
+    cb_framework_uwb_pdoa_cir_snapshot_cpu_copy(slot);
+    return CB_FALSE;
+  }
+
+  pDesc[0] = &s_stCirSnapshot.stHead.DMAConfig;
+  for (uint8_t i = 1; i < DEF_PDOA_NUM_RX_USED; i++)
+  {
+    pDesc[i] = &s_stCirSnapshot.stNode[i - 1].DMAConfig;
+  }
+
+  for (uint8_t port = 0; port < DEF_PDOA_NUM_RX_USED; port++)
+  {
+    if ((s_stCirSnapshot.enRxPorts & s_enPortList[port]) == 0)
+    {
+      continue;
+    }
+    uint32_t srcAddr = cb_system_uwb_get_rx_cir_register_addr(s_enPortList[port], startingPosition, DEF_PDOA_NUM_CIR_DATASET);
+    if (srcAddr == 0)
+    {
+      cb_framework_uwb_pdoa_cir_snapshot_cpu_copy(slot); // CIR window out of DMA range
+      return CB_FALSE;
+    }
+    cb_framework_uwb_pdoa_cir_snapshot_fill_desc(pDesc[numDesc], srcAddr, g_stPdoaRxCirDataContainer[slot][port], numDesc);
+    numDesc++;
+  }
+  if (numDesc == 0)
+  {
+    cb_framework_uwb_pdoa_cir_snapshot_cpu_copy(slot); // No RX port selected for DMA
+    return CB_FALSE;
+  }
+
+  // Chain descriptors: head -> node[0] -> node[1]
+  s_stCirSnapshot.stHead.NextNode = (numDesc > 1) ? &s_stCirSnapshot.stNode[0] : NULL;
+  for (uint8_t i = 1; i < numDesc; i++)
+  {
+    s_stCirSnapshot.stNode[i - 1].NextNode = (i < (numDesc - 1)) ? &s_stCirSnapshot.stNode[i] : NULL;
+  }
+
+  s_stCirSnapshot.activeSlot = slot;
+  s_stCirSnapshot.busy       = CB_TRUE;
+
+  cb_dma_enable_channel(&s_stCirSnapshot.stHead.DMAConfig);
+  cb_dma_lli_init(&s_stCirSnapshot.stHead);
+  for (uint8_t i = 1; i < numDesc; i++)
+  {
+    cb_dma_lli_setup(&s_stCirSnapshot.stHead, &s_stCirSnapshot.stNode[i - 1]);
+  }
+  for (uint8_t i = 0; i < numDesc; i++)
+  {
+    cb_dma_set_dest_request(pDesc[i]);
+  }
+  for (uint8_t i = 0; i < numDesc; i++)
+  {
+    cb_dma_set_src_request(pDesc[i]);
+  }
+  return CB_TRUE;
+}
+
+/**
+ * @brief Check whether the snapshot of a scheduled PDoA reception is complete
+ *
+ * @param countOfPdoaScheduledRx Count of scheduled PDoA receptions
+ * @return CB_TRUE if the slot holds a complete snapshot, CB_FALSE otherwise
+ */
+uint8_t cb_framework_uwb_pdoa_cir_snapshot_is_ready(uint8_t countOfPdoaScheduledRx)
+{
+  uint8_t slot = countOfPdoaScheduledRx % DEF_PDOA_NUMPKT_SUPERFRAME_MAX;
+  return ((s_stCirSnapshot.readyMask & (1UL << slot)) != 0) ? CB_TRUE : CB_FALSE;
+}
+
+/**
+ * @brief Wait until the in-flight CIR snapshot (if any) has completed
+ *
+ * @param NumOfPackage Number of packages expected in the slot ring
+ * @return CB_TRUE if all NumOfPackage slots hold a complete snapshot, CB_FALSE otherwise
+ */
+uint8_t cb_framework_uwb_pdoa_cir_snapshot_wait(uint8_t NumOfPackage)
+{
+  uint32_t waitUs = 0;
+
+  while (s_stCirSnapshot.busy == CB_TRUE)
+  {
+    if (cb_dma_is_channel_idle(&s_stCirSnapshot.stHead.DMAConfig) == CB_TRUE)
+    {
+      cb_framework_uwb_pdoa_cir_snapshot_complete(); // IRQ callback not registered or not yet served
+    }
+    else if (waitUs++ >= DEF_PDOA_CIR_SNAPSHOT_WAIT_TIMEOUT_US)
+    {
+      return CB_FALSE;
+    }
+    else
+    {
+      cb_system_delay_in_us(1);
+    }
+  }
+
+  if (NumOfPackage > DEF_PDOA_NUMPKT_SUPERFRAME_MAX)
+  {
+    NumOfPackage = DEF_PDOA_NUMPKT_SUPERFRAME_MAX;
+  }
+  uint32_t expectedMask = (1UL << NumOfPackage) - 1;
+  return ((s_stCirSnapshot.readyMask & expectedMask) == expectedMask) ? CB_TRUE : CB_FALSE;
+}
+
+/**
+ * @brief DMA channel IRQ callback of the CIR snapshot engine
+ */
+void cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback(void)
+{
+  cb_framework_uwb_pdoa_cir_snapshot_complete();
+}
+
 /**
  * @brief Calculate PDoA result
  * 
@@ -728,6 +957,10 @@ void cb_framework_uwb_pdoa_calculate_result(cb_uwbsystem_pdoaresult_st *s_stPdoa
     s_stPdoaOutputResult->stRxstatus = CB_FALSE; //Error
     return;
   }
+  if (s_stCirSnapshot.busy == CB_TRUE)
+  {
+    cb_framework_uwb_pdoa_cir_snapshot_wait(NumOfPackage); // Last snapshot may still be in flight
+  }
   if (CIR_CalculationType == EN_PDOA_2D_CALTYPE)
   {
     phaseIdx_startoffset = 2;//Default for single phase, Rx0-Rx2 only
@@ -765,6 +998,88 @@ void cb_framework_uwb_pdoa_calculate_result(cb_uwbsystem_pdoaresult_st *s_stPdoa
   s_stPdoaOutputResult->stRxstatus = CB_TRUE; //success
 }
 
+/**
+ * @brief Reset the per-packet PDoA processing state
+ */
+void cb_framework_uwb_pdoa_incremental_reset(void)
+{
+  memset(s_pdoaPacketEstimated, 0x00, sizeof(s_pdoaPacketEstimated));
+  s_pdoaProcessedMask = 0;
+}
+
+/**
+ * @brief Process the CIR of one PDoA packet as soon as it is stored
+ *
+ * @param CIR_CalculationType Type of CIR calculation
+ * @param countOfPdoaScheduledRx Count of scheduled PDoA receptions of the packet
+ * @return CB_TRUE if the packet was processed, CB_FALSE if its CIR is not available
+ */
+uint8_t cb_framework_uwb_pdoa_process_packet(enUwbPdoaCalType CIR_CalculationType, uint8_t countOfPdoaScheduledRx)
+{
+  uint8_t pktcnt = countOfPdoaScheduledRx % DEF_PDOA_NUMPKT_SUPERFRAME_MAX;
+
+  if ((s_stCirSnapshot.initialized == CB_TRUE) && (cb_framework_uwb_pdoa_cir_snapshot_is_ready(pktcnt) != CB_TRUE))
+  {
+    cb_framework_uwb_pdoa_cir_snapshot_wait(0);
+    if (cb_framework_uwb_pdoa_cir_snapshot_is_ready(pktcnt) != CB_TRUE)
+    {
+      return CB_FALSE;
+    }
+  }
+
+  g_stPoaResult[pktcnt] = cb_framework_uwb_pdoa_cir_processing(CIR_CalculationType, pktcnt, DEF_PDOA_NUM_RX_USED, &g_stPdoaRxCirDataContainer[0][0][0], DEF_PDOA_NUM_CIR_DATASET);
+
+  if (CIR_CalculationType != EN_PDOA_2D_CALTYPE)
+  {
+    s_pdoaPacketEstimated[0][pktcnt] = cb_system_uwb_alg_pdoa_estimation(g_stPoaResult[pktcnt].rx0, g_stPoaResult[pktcnt].rx1);
+    s_pdoaPacketEstimated[1][pktcnt] = cb_system_uwb_alg_pdoa_estimation(g_stPoaResult[pktcnt].rx1, g_stPoaResult[pktcnt].rx2);
+  }
+  s_pdoaPacketEstimated[2][pktcnt] = cb_system_uwb_alg_pdoa_estimation(g_stPoaResult[pktcnt].rx0, g_stPoaResult[pktcnt].rx2);
+
+  s_pdoaProcessedMask |= (1UL << pktcnt);
+  return CB_TRUE;
+}
+
+/**
+ * @brief Calculate PDoA result from packets processed by cb_framework_uwb_pdoa_process_packet
+ *
+ * @param s_stPdoaOutputResult Pointer to store the PDoA result
+ * @param CIR_CalculationType Type of CIR calculation
+ * @param NumOfPackage Number of packages
+ */
+void cb_framework_uwb_pdoa_calculate_result_incremental(cb_uwbsystem_pdoaresult_st *s_stPdoaOutputResult, enUwbPdoaCalType CIR_CalculationType, uint8_t NumOfPackage)
+{
+  if ((NumOfPackage == 0) || (NumOfPackage > DEF_PDOA_NUMPKT_SUPERFRAME_MAX))
+  {
+    s_stPdoaOutputResult->stRxstatus = CB_FALSE; //Error
+    return;
+  }
+
+  // Packets not processed during reception (normally the last one)
+  for (uint8_t pktcnt = 0; pktcnt < NumOfPackage; pktcnt++)
+  {
+    if ((s_pdoaProcessedMask & (1UL << pktcnt)) == 0)
+    {
+      if (cb_framework_uwb_pdoa_process_packet(CIR_CalculationType, pktcnt) != CB_TRUE)
+      {
+        s_stPdoaOutputResult->stRxstatus = CB_FALSE; //Error
+        return;
+      }
+    }
+  }
+
+  // Compute mean and median
+  if (CIR_CalculationType != EN_PDOA_2D_CALTYPE)
+  {
+    cb_framework_uwb_pdoa_calculate_mean_and_median(s_pdoaPacketEstimated[0], NumOfPackage, &s_stPdoaOutputResult->mean.rx0_rx1, &s_stPdoaOutputResult->median.rx0_rx1);
+    cb_framework_uwb_pdoa_calculate_mean_and_median(s_pdoaPacketEstimated[1], NumOfPackage, &s_stPdoaOutputResult->mean.rx1_rx2, &s_stPdoaOutputResult->median.rx1_rx2);
+  }
+  cb_framework_uwb_pdoa_calculate_mean_and_median(s_pdoaPacketEstimated[2], NumOfPackage, &s_stPdoaOutputResult->mean.rx0_rx2, &s_stPdoaOutputResult->median.rx0_rx2);
+
+  s_pdoaProcessedMask = 0;
+  s_stPdoaOutputResult->stRxstatus = CB_TRUE; //success
+}
+
 /**
  * @brief Calculate Angle of Arrival (AoA) from PDoA data
  * 
@@ -491,6 +491,38 @@ cb_uwbalg_poa_outputperpacket_st cb_framework_uwb_pdoa_cir_processing(enUwbPdoaC
  */
 void cb_framework_uwb_pdoa_calculate_result(cb_uwbsystem_pdoaresult_st *s_stPdoaOutputResult,enUwbPdoaCalType CIR_CalculationType, uint8_t NumOfPackage);
 
+/**
+ * @brief Reset the per-packet PDoA processing state
+ *
+ * Call before the first PDoA reception of a superframe when using
+ * cb_framework_uwb_pdoa_process_packet.
+ */
+void cb_framework_uwb_pdoa_incremental_reset(void);
+
+/**
+ * @brief Process the CIR of one PDoA packet as soon as it is stored
+ *
+ * Runs the per-packet POA and the per-pair PDoA estimation, so it can be called in the
+ * gap before the next scheduled reception. Waits for the CIR snapshot of the packet
+ * if it is still in flight on DMA.
+ *
+ * @param CIR_CalculationType Type of CIR calculation
+ * @param countOfPdoaScheduledRx Count of scheduled PDoA receptions of the packet
+ * @return CB_TRUE if the packet was processed, CB_FALSE if its CIR is not available
+ */
+uint8_t cb_framework_uwb_pdoa_process_packet(enUwbPdoaCalType CIR_CalculationType, uint8_t countOfPdoaScheduledRx);
+
+/**
+ * @brief Calculate PDoA result from packets processed by cb_framework_uwb_pdoa_process_packet
+ *
+ * Packets not processed yet are processed first, then only the mean/median reduction is run.
+ *
+ * @param s_stPdoaOutputResult Pointer to store the PDoA result
+ * @param CIR_CalculationType Type of CIR calculation
+ * @param NumOfPackage Number of packages
+ */
+void cb_framework_uwb_pdoa_calculate_result_incremental(cb_uwbsystem_pdoaresult_st *s_stPdoaOutputResult, enUwbPdoaCalType CIR_CalculationType, uint8_t NumOfPackage);
+
 /**
  * @brief Calculate Angle of Arrival (AoA) from PDoA data
  * 
@@ -579,6 +611,65 @@ void cb_framework_uwb_pdoa_reset_cir_data_container(void);
  */
 void cb_framework_uwb_pdoa_store_cir_data(uint8_t countOfPdoaScheduledRx);
 
+//----------------------------------------------------------------//
+//                 PDOA CIR SNAPSHOT (DMA) API                    //
+//----------------------------------------------------------------//
+
+/**
+ * @brief Initialize the DMA-backed CIR snapshot engine for PDoA
+ *
+ * The engine copies the PDoA CIR window of every active RX port into the
+ * `g_stPdoaRxCirDataContainer` slot ring with a single DMA linked-list transfer,
+ * so the CPU can re-arm the next reception while the copy runs in background.
+ * The application must register `cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback`
+ * on the DMA channel IRQ entry to get completion events; otherwise completion is
+ * detected by polling in `cb_framework_uwb_pdoa_cir_snapshot_wait`.
+ *
+ * @param enRxPorts RX ports to be captured per snapshot (e.g. EN_UWB_RX_ALL or EN_UWB_RX_02)
+ */
+void cb_framework_uwb_pdoa_cir_snapshot_init(cb_uwbsystem_rxport_en enRxPorts);
+
+/**
+ * @brief Stop the CIR snapshot engine and release its DMA channel
+ */
+void cb_framework_uwb_pdoa_cir_snapshot_deinit(void);
+
+/**
+ * @brief Start a background CIR snapshot for a scheduled PDoA reception
+ *
+ * The snapshot is written to slot (countOfPdoaScheduledRx % DEF_PDOA_NUMPKT_SUPERFRAME_MAX).
+ * If the engine is not initialized, the previous snapshot is still in flight, the CIR window is
+ * out of range or no RX port is selected, it falls back to a synchronous CPU copy: the slot is
+ * ready in every case.
+ *
+ * @param countOfPdoaScheduledRx Count of scheduled PDoA receptions
+ * @return CB_TRUE if the snapshot was queued on DMA, CB_FALSE if it was copied by the CPU
+ */
+uint8_t cb_framework_uwb_pdoa_cir_snapshot_start(uint8_t countOfPdoaScheduledRx);
+
+/**
+ * @brief Check whether the snapshot of a scheduled PDoA reception is complete
+ *
+ * @param countOfPdoaScheduledRx Count of scheduled PDoA receptions
+ * @return CB_TRUE if the slot holds a complete snapshot, CB_FALSE otherwise
+ */
+uint8_t cb_framework_uwb_pdoa_cir_snapshot_is_ready(uint8_t countOfPdoaScheduledRx);
+
+/**
+ * @brief Wait until the in-flight CIR snapshot (if any) has completed
+ *
+ * @param NumOfPackage Number of packages expected in the slot ring
+ * @return CB_TRUE if all NumOfPackage slots hold a complete snapshot, CB_FALSE otherwise
+ */
+uint8_t cb_framework_uwb_pdoa_cir_snapshot_wait(uint8_t NumOfPackage);
+
+/**
+ * @brief DMA channel IRQ callback of the CIR snapshot engine
+ *
+ * Register on the IRQ entry of the snapshot DMA channel (EN_IRQENTRY_DMA_CHANNEL_2_APP_IRQ).
+ */
+void cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback(void);
+
 void cb_framework_ftm_uwb_rx_restart(cb_uwbsystem_rxport_en enRxPort, cb_uwbsystem_packetconfig_st* rxPacketConfig, cb_uwbsystem_rx_irqenable_st* stRxIrqEnable, cb_uwbframework_trx_startmode_en trxStartMode);
 
 //----------------------------------------------------------------//
@@ -0,0 +1,312 @@
+/**
+ * @file    CB_uwblinkcache.c
+ * @brief   Per-peer UWB RX link-state cache.
+ * @details The cached gain index and CFO are applied through cb_framework_uwb_rxconfig_cfo_gain(),
+ *          which takes effect at the next cb_framework_uwb_rx_start().
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "CB_uwblinkcache.h"
+#include "CB_uwbframework.h"
+#include "CB_system.h"
+#include "NonLIB_sharedUtils.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_UWB_LINKCACHE_FP_SEARCH       2   // First path searched +/- around the CIR control index
+#define DEF_UWB_LINKCACHE_CIR_LEN         (DEF_UWB_LINKCACHE_FP_NOISE_OFFSET + DEF_UWB_LINKCACHE_FP_SEARCH + 1)
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static cb_uwblinkcache_peer_st        s_stLinkCachePeers[DEF_UWB_LINKCACHE_MAX_PEERS];
+static uint8_t                        s_linkCacheNumPeers;
+static cb_uwblinkcache_mode_en        s_enLinkCacheMode = EN_UWB_LINKCACHE_MODE_OFF;
+static uint8_t                        s_linkCacheAlternate;
+static cb_uwbsystem_rx_cir_iqdata_st  s_linkCacheCir[DEF_UWB_LINKCACHE_CIR_LEN];
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static cb_uwblinkcache_peer_st* cb_uwblinkcache_find_peer(uint16_t peerId, uint8_t create);
+static uint8_t cb_uwblinkcache_measure_fp_snr(cb_uwbsystem_rxport_en enRxPort, float *fpSnr_dB);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Clear the cache and select the seeding mode.
+ *
+ * @param enMode Seeding mode.
+ */
+void cb_uwblinkcache_init(cb_uwblinkcache_mode_en enMode)
+{
+  memset(s_stLinkCachePeers, 0, sizeof(s_stLinkCachePeers));
+  s_linkCacheNumPeers  = 0;
+  s_linkCacheAlternate = CB_FALSE;
+  s_enLinkCacheMode    = enMode;
+  cb_uwblinkcache_release();
+}
+
+/**
+ * @brief Start an exchange with a peer, decides whether its receptions are seeded.
+ *
+ * @param peerId Peer identifier.
+ */
+void cb_uwblinkcache_begin_exchange(uint16_t peerId)
+{
+  cb_uwblinkcache_peer_st *peer = cb_uwblinkcache_find_peer(peerId, CB_TRUE);
+
+  switch (s_enLinkCacheMode)
+  {
+    case EN_UWB_LINKCACHE_MODE_ON:
+      peer->seedExchange = CB_TRUE;
+      break;
+    case EN_UWB_LINKCACHE_MODE_ALTERNATE:
+      s_linkCacheAlternate ^= CB_TRUE;
+      peer->seedExchange = s_linkCacheAlternate;
+      break;
+    case EN_UWB_LINKCACHE_MODE_OFF:
+    default:
+      peer->seedExchange = CB_FALSE;
+      break;
+  }
+}
+
+/**
+ * @brief Configure the receiver for the next expected frame from a peer, before cb_framework_uwb_rx_start().
+ *
+ * @param peerId Peer identifier.
+ * @return CB_TRUE if the receiver was seeded.
+ */
+uint8_t cb_uwblinkcache_prepare_rx(uint16_t peerId)
+{
+  cb_uwblinkcache_peer_st *peer = cb_uwblinkcache_find_peer(peerId, CB_TRUE);
+
+  // A failed seeded reception is retried free-running: the cached state may be stale (peer moved, blocked).
+  // A due refresh also runs free-running, the only way to re-learn the gain and CFO.
+  if ((peer->seedExchange == CB_TRUE) && (peer->valid == CB_TRUE) && (peer->failures == 0) &&
+      (peer->refresh == CB_FALSE) && (peer->seededCount < DEF_UWB_LINKCACHE_REFRESH_INTERVAL) &&
+      (cb_hal_is_time_elapsed(peer->updateTick, DEF_UWB_LINKCACHE_MAX_AGE_MS) != CB_PASS))
+  {
+    cb_uwbsystem_rx_dbb_config_st stRxCfg_CfoGainBypass;
+
+    stRxCfg_CfoGainBypass.stRxGain = (cb_uwbsystem_rx_dbb_gain_st){
+        .enableBypass = CB_TRUE,
+        .gainValue    = peer->gainIdx
+    };
+    stRxCfg_CfoGainBypass.stRxCfo = (cb_uwbsystem_rx_dbb_cfo_st){
+        .enableBypass = CB_TRUE,
+        .cfoValue     = peer->cfoEst
+    };
+    cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_SET, &stRxCfg_CfoGainBypass);
+    peer->rxSeeded = CB_TRUE;
+  }
+  else
+  {
+    cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_RESET, NULL);
+    peer->rxSeeded = CB_FALSE;
+  }
+  return peer->rxSeeded;
+}
+
+/**
+ * @brief Report the outcome of a reception prepared by cb_uwblinkcache_prepare_rx().
+ *
+ * @param peerId   Peer identifier.
+ * @param rxOk     CB_TRUE if a valid frame was received, CB_FALSE on timeout or error.
+ * @param enRxPort RX port the gain and CFO are read from.
+ */
+void cb_uwblinkcache_rx_done(uint16_t peerId, uint8_t rxOk, cb_uwbsystem_rxport_en enRxPort)
+{
+  cb_uwblinkcache_peer_st  *peer  = cb_uwblinkcache_find_peer(peerId, CB_TRUE);
+  cb_uwblinkcache_stats_st *stats = &peer->stats[(peer->rxSeeded == CB_TRUE) ? EN_UWB_LINKCACHE_STATS_SEEDED : EN_UWB_LINKCACHE_STATS_FREE];
+
+  stats->rxAttempts++;
+  if (rxOk != CB_TRUE)
+  {
+    if (++peer->failures >= DEF_UWB_LINKCACHE_MAX_FAILURES)
+    {
+      peer->valid = CB_FALSE;
+    }
+    return;
+  }
+
+  stats->rxOk++;
+  peer->failures = 0;
+
+  cb_uwbsystem_rx_signalinfo_st stSignalInfo = cb_framework_uwb_get_rx_rssi(enRxPort);
+  if (peer->rxSeeded == CB_TRUE)
+  {
+    // In bypass the reported gain and CFO are the seeded ones: only the RSSI shows that the link changed
+    int32_t deviation = (int32_t)stSignalInfo.rssiRx - peer->rssi;
+    if ((deviation > DEF_UWB_LINKCACHE_RSSI_DEVIATION) || (deviation < -DEF_UWB_LINKCACHE_RSSI_DEVIATION))
+    {
+      peer->refresh = CB_TRUE;
+    }
+    peer->seededCount++;
+    return;
+  }
+
+  peer->gainIdx     = stSignalInfo.gainIdx;
+  peer->cfoEst      = stSignalInfo.cfoEst;
+  peer->rssi        = stSignalInfo.rssiRx;
+  peer->updateTick  = cb_hal_get_tick();
+  peer->seededCount = 0;
+  peer->refresh     = CB_FALSE;
+  peer->valid       = CB_TRUE;
+}
+
+/**
+ * @brief Measure the first-path SNR of the last valid frame and add it to the statistics.
+ *
+ * @param peerId   Peer identifier.
+ * @param enRxPort RX port the CIR is read from.
+ */
+void cb_uwblinkcache_record_fp_snr(uint16_t peerId, cb_uwbsystem_rxport_en enRxPort)
+{
+  cb_uwblinkcache_peer_st  *peer  = cb_uwblinkcache_find_peer(peerId, CB_TRUE);
+  cb_uwblinkcache_stats_st *stats = &peer->stats[(peer->rxSeeded == CB_TRUE) ? EN_UWB_LINKCACHE_STATS_SEEDED : EN_UWB_LINKCACHE_STATS_FREE];
+  float fpSnr_dB;
+
+  if (cb_uwblinkcache_measure_fp_snr(enRxPort, &fpSnr_dB) == CB_PASS)
+  {
+    stats->fpSnrCount++;
+    stats->fpSnrSum_dB += fpSnr_dB;
+  }
+}
+
+/**
+ * @brief Add a PDoA sample to the statistics of the current exchange.
+ *
+ * @param peerId   Peer identifier.
+ * @param pdoa_deg Phase difference of arrival, in degrees.
+ */
+void cb_uwblinkcache_record_pdoa(uint16_t peerId, float pdoa_deg)
+{
+  cb_uwblinkcache_peer_st  *peer  = cb_uwblinkcache_find_peer(peerId, CB_TRUE);
+  cb_uwblinkcache_stats_st *stats = &peer->stats[(peer->seedExchange == CB_TRUE) ? EN_UWB_LINKCACHE_STATS_SEEDED : EN_UWB_LINKCACHE_STATS_FREE];
+
+  // Welford running variance
+  float delta = pdoa_deg - stats->pdoaMean_deg;
+  stats->pdoaCount++;
+  stats->pdoaMean_deg += delta / stats->pdoaCount;
+  stats->pdoaM2       += delta * (pdoa_deg - stats->pdoaMean_deg);
+}
+
+/**
+ * @brief Return the receiver to the free-running AGC and CFO.
+ */
+void cb_uwblinkcache_release(void)
+{
+  cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_RESET, NULL);
+}
+
+/**
+ * @brief Get the cached state and statistics of a peer.
+ *
+ * @param peerId Peer identifier.
+ * @return Pointer to the peer entry, NULL if the peer is not in the cache.
+ */
+const cb_uwblinkcache_peer_st* cb_uwblinkcache_get_peer(uint16_t peerId)
+{
+  return cb_uwblinkcache_find_peer(peerId, CB_FALSE);
+}
+
+/**
+ * @brief Find the entry of a peer, optionally replacing the least recently updated entry.
+ *
+ * @param peerId Peer identifier.
+ * @param create CB_TRUE to add the peer when it is not in the cache.
+ * @return Peer entry, NULL if not found and create is CB_FALSE.
+ */
+static cb_uwblinkcache_peer_st* cb_uwblinkcache_find_peer(uint16_t peerId, uint8_t create)
+{
+  cb_uwblinkcache_peer_st *oldest = &s_stLinkCachePeers[0];
+
+  for (uint8_t i = 0; i < s_linkCacheNumPeers; i++)
+  {
+    if (s_stLinkCachePeers[i].peerId == peerId)
+    {
+      return &s_stLinkCachePeers[i];
+    }
+    if ((int32_t)(s_stLinkCachePeers[i].updateTick - oldest->updateTick) < 0)
+    {
+      oldest = &s_stLinkCachePeers[i];
+    }
+  }
+  if (create == CB_FALSE)
+  {
+    return NULL;
+  }
+  if (s_linkCacheNumPeers < DEF_UWB_LINKCACHE_MAX_PEERS)
+  {
+    oldest = &s_stLinkCachePeers[s_linkCacheNumPeers++];
+  }
+  memset(oldest, 0, sizeof(*oldest));
+  oldest->peerId     = peerId;
+  oldest->updateTick = cb_hal_get_tick();
+  return oldest;
+}
+
+/**
+ * @brief First-path power over the noise floor preceding it in the CIR.
+ *
+ * @param enRxPort RX port.
+ * @param fpSnr_dB First-path SNR, in dB.
+ * @return CB_PASS on success, CB_FAIL if the first path is too close to the CIR start.
+ */
+static uint8_t cb_uwblinkcache_measure_fp_snr(cb_uwbsystem_rxport_en enRxPort, float *fpSnr_dB)
+{
+  uint16_t ctlIdx = cb_system_uwb_get_rx_cir_ctl_idx();
+  float    noise  = 0.0f;
+  float    peak   = 0.0f;
+
+  if (ctlIdx < DEF_UWB_LINKCACHE_FP_NOISE_OFFSET)
+  {
+    return CB_FAIL;
+  }
+  // Only one port is read, the first of the mask
+  cb_uwbsystem_rxport_en enCirPort = (enRxPort & EN_UWB_RX_0) ? EN_UWB_RX_0 : ((enRxPort & EN_UWB_RX_1) ? EN_UWB_RX_1 : EN_UWB_RX_2);
+  cb_framework_uwb_store_rx_cir_register(s_linkCacheCir, enCirPort, ctlIdx - DEF_UWB_LINKCACHE_FP_NOISE_OFFSET, DEF_UWB_LINKCACHE_CIR_LEN);
+
+  for (uint16_t n = 0; n < DEF_UWB_LINKCACHE_FP_NOISE_LEN; n++)
+  {
+    float i = s_linkCacheCir[n].I_data;
+    float q = s_linkCacheCir[n].Q_data;
+    noise += i * i + q * q;
+  }
+  for (uint16_t n = DEF_UWB_LINKCACHE_FP_NOISE_OFFSET - DEF_UWB_LINKCACHE_FP_SEARCH; n < DEF_UWB_LINKCACHE_CIR_LEN; n++)
+  {
+    float i = s_linkCacheCir[n].I_data;
+    float q = s_linkCacheCir[n].Q_data;
+    float p = i * i + q * q;
+    peak = (p > peak) ? p : peak;
+  }
+  noise /= DEF_UWB_LINKCACHE_FP_NOISE_LEN;
+  if ((noise <= 0.0f) || (peak <= 0.0f))
+  {
+    return CB_FAIL;
+  }
+  *fpSnr_dB = 10.0f * log10f(peak / noise);
+  return CB_PASS;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file    CB_uwblinkcache.h
+ * @brief   Per-peer UWB RX link-state cache.
+ * @details After each valid frame from a peer, the RX gain index, CFO estimate and RSSI reported by
+ *          cb_framework_uwb_get_rx_rssi() are stored for that peer. Before the next scheduled
+ *          reception from the same peer, the receiver is pre-seeded with them through
+ *          cb_framework_uwb_rxconfig_cfo_gain(), so that the AGC and CFO loops start converged.
+ *          A failed seeded reception makes the next reception fall back to the free-running AGC/CFO,
+ *          and repeated failures drop the cached state.
+ *          In bypass the receiver reports the seeded gain and CFO back, so the state is only learned
+ *          from free-running receptions: one is forced after DEF_UWB_LINKCACHE_REFRESH_INTERVAL seeded
+ *          receptions, or as soon as the RSSI of a seeded frame moves by DEF_UWB_LINKCACHE_RSSI_DEVIATION.
+ *          Reception statistics are kept separately for seeded and free-running receptions, so that
+ *          both can be compared on the same link (EN_UWB_LINKCACHE_MODE_ALTERNATE).
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_UWBLINKCACHE_H
+#define __CB_UWBLINKCACHE_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_Common.h"
+#include "CB_system_types.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DEF_UWB_LINKCACHE_MAX_PEERS
+#define DEF_UWB_LINKCACHE_MAX_PEERS       8       /**< Peers kept, least recently updated is replaced */
+#endif
+#ifndef DEF_UWB_LINKCACHE_MAX_AGE_MS
+#define DEF_UWB_LINKCACHE_MAX_AGE_MS      2000    /**< Cached state older than this is not used */
+#endif
+#ifndef DEF_UWB_LINKCACHE_MAX_FAILURES
+#define DEF_UWB_LINKCACHE_MAX_FAILURES    3       /**< Consecutive failures before the cached state is dropped */
+#endif
+#ifndef DEF_UWB_LINKCACHE_REFRESH_INTERVAL
+#define DEF_UWB_LINKCACHE_REFRESH_INTERVAL 16     /**< Seeded receptions before a free-running one re-learns the gain and CFO */
+#endif
+#ifndef DEF_UWB_LINKCACHE_RSSI_DEVIATION
+#define DEF_UWB_LINKCACHE_RSSI_DEVIATION  6       /**< RSSI change of a seeded frame (dB) that forces a free-running reception */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_UWB_LINKCACHE_FP_NOISE_OFFSET 48      /**< Noise window start, CIR samples before the first path */
+#define DEF_UWB_LINKCACHE_FP_NOISE_LEN    32      /**< Noise window length, ends before the first path rising edge */
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+/**
+ * @brief Link-state cache mode.
+ */
+typedef enum
+{
+  EN_UWB_LINKCACHE_MODE_OFF = 0,    /**< Never seed, statistics only */
+  EN_UWB_LINKCACHE_MODE_ON,         /**< Seed each reception from a peer with a valid cached state */
+  EN_UWB_LINKCACHE_MODE_ALTERNATE,  /**< Seed every other exchange, to compare both on the same link */
+} cb_uwblinkcache_mode_en;
+
+/**
+ * @brief Index of the statistics.
+ */
+typedef enum
+{
+  EN_UWB_LINKCACHE_STATS_FREE = 0,  /**< Free-running AGC and CFO */
+  EN_UWB_LINKCACHE_STATS_SEEDED,    /**< Gain and CFO seeded from the cache */
+  EN_UWB_LINKCACHE_STATS_NUM,
+} cb_uwblinkcache_stats_en;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Reception statistics.
+ */
+typedef struct
+{
+  uint32_t  rxAttempts;     /**< Receptions from the peer */
+  uint32_t  rxOk;           /**< Valid frames */
+  uint32_t  fpSnrCount;     /**< First-path SNR samples */
+  float     fpSnrSum_dB;    /**< Sum of first-path SNR, in dB */
+  uint32_t  pdoaCount;      /**< PDoA samples */
+  float     pdoaMean_deg;   /**< Running PDoA mean */
+  float     pdoaM2;         /**< Running sum of squared PDoA deviations, variance = pdoaM2 / (pdoaCount - 1) */
+} cb_uwblinkcache_stats_st;
+
+/**
+ * @brief Cached link state of one peer.
+ */
+typedef struct
+{
+  uint16_t                  peerId;
+  uint8_t                   valid;          /**< CB_TRUE when gainIdx / cfoEst can be used */
+  uint8_t                   failures;       /**< Consecutive failed receptions */
+  uint8_t                   gainIdx;        /**< RX gain index of the last valid frame */
+  uint8_t                   seedExchange;   /**< CB_TRUE if the current exchange is seeded */
+  uint8_t                   rxSeeded;       /**< CB_TRUE if the current reception is seeded */
+  uint8_t                   seededCount;    /**< Seeded receptions since the state was learned */
+  uint8_t                   refresh;        /**< CB_TRUE: RSSI moved, the next reception is free-running */
+  int16_t                   rssi;           /**< RSSI of the last free-running valid frame */
+  uint32_t                  cfoEst;         /**< CFO estimate of the last free-running valid frame */
+  uint32_t                  updateTick;     /**< cb_hal_get_tick() when the state was learned */
+  cb_uwblinkcache_stats_st  stats[EN_UWB_LINKCACHE_STATS_NUM];
+} cb_uwblinkcache_peer_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Clear the cache and select the seeding mode.
+ *
+ * @param enMode Seeding mode.
+ */
+void cb_uwblinkcache_init(cb_uwblinkcache_mode_en enMode);
+
+/**
+ * @brief Start an exchange with a peer, decides whether its receptions are seeded.
+ *
+ * @param peerId Peer identifier.
+ */
+void cb_uwblinkcache_begin_exchange(uint16_t peerId);
+
+/**
+ * @brief Configure the receiver for the next expected frame from a peer, before cb_framework_uwb_rx_start().
+ *
+ * The cached gain and CFO are applied if the exchange is seeded, the state is recent, the previous
+ * reception did not fail and no refresh is due; otherwise the receiver is reset to the free-running
+ * AGC and CFO.
+ *
+ * @param peerId Peer identifier.
+ * @return CB_TRUE if the receiver was seeded.
+ */
+uint8_t cb_uwblinkcache_prepare_rx(uint16_t peerId);
+
+/**
+ * @brief Report the outcome of a reception prepared by cb_uwblinkcache_prepare_rx().
+ *
+ * On success of a free-running reception, the gain, CFO and RSSI of the frame are stored. On success
+ * of a seeded reception, only its RSSI is compared with the cached one. Only a few registers are
+ * read: it can run between a POLL reception and the scheduled RESPONSE. Call it before the RX is
+ * ended so that the RX registers are still valid.
+ *
+ * @param peerId   Peer identifier.
+ * @param rxOk     CB_TRUE if a valid frame was received, CB_FALSE on timeout or error.
+ * @param enRxPort RX port the gain and CFO are read from.
+ */
+void cb_uwblinkcache_rx_done(uint16_t peerId, uint8_t rxOk, cb_uwbsystem_rxport_en enRxPort);
+
+/**
+ * @brief Measure the first-path SNR of the last valid frame and add it to the statistics.
+ *
+ * Reads DEF_UWB_LINKCACHE_FP_NOISE_OFFSET + 3 CIR samples and computes a log10f: keep it out of
+ * time-critical paths (e.g. between POLL and RESPONSE), and call it before the next reception.
+ *
+ * @param peerId   Peer identifier.
+ * @param enRxPort RX port the CIR is read from, the first port of the mask.
+ */
+void cb_uwblinkcache_record_fp_snr(uint16_t peerId, cb_uwbsystem_rxport_en enRxPort);
+
+/**
+ * @brief Add a PDoA sample to the statistics of the current exchange.
+ *
+ * @param peerId   Peer identifier.
+ * @param pdoa_deg Phase difference of arrival, in degrees.
+ */
+void cb_uwblinkcache_record_pdoa(uint16_t peerId, float pdoa_deg);
+
+/**
+ * @brief Return the receiver to the free-running AGC and CFO, e.g. before listening to unknown peers.
+ */
+void cb_uwblinkcache_release(void);
+
+/**
+ * @brief Get the cached state and statistics of a peer.
+ *
+ * @param peerId Peer identifier.
+ * @return Pointer to the peer entry, NULL if the peer is not in the cache.
+ */
+const cb_uwblinkcache_peer_st* cb_uwblinkcache_get_peer(uint16_t peerId);
+
+#endif /*__CB_UWBLINKCACHE_H*/
@@ -0,0 +1,361 @@
+/**
+ * @file    CB_uwbrxstats.c
+ * @brief   UWB RX packet error rate and link-quality statistics.
+ * @details Outcome classification, histograms, IRQ-safe snapshots, PER confidence interval and
+ *          serialization. See CB_uwbrxstats.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "CB_uwbrxstats.h"
+#include "CB_uwbsstwr.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_RXSTATS_BARRIER()   __asm volatile("" ::: "memory")   /**< Keep the accesses on their side of the sequence counter */
+#define DEF_RXSTATS_CFO_BIN_OFFSET  (DEF_UWB_RXSTATS_HIST_BINS / 2)
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void cb_uwbrxstats_hist_add(cb_uwbrxstats_hist_st *hist, int32_t value, int32_t bin, uint8_t first);
+static uint8_t* cb_uwbrxstats_put32(uint8_t *p, uint32_t value);
+static uint8_t* cb_uwbrxstats_put64(uint8_t *p, uint64_t value);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Add a value to a histogram.
+ *
+ * @param hist  Histogram.
+ * @param value Value.
+ * @param bin   Bin of the value, clamped to the first / last bin.
+ * @param first CB_TRUE for the first value of the run.
+ */
+static void cb_uwbrxstats_hist_add(cb_uwbrxstats_hist_st *hist, int32_t value, int32_t bin, uint8_t first)
+{
+  if (bin < 0)
+  {
+    bin = 0;
+  }
+  else if (bin >= DEF_UWB_RXSTATS_HIST_BINS)
+  {
+    bin = DEF_UWB_RXSTATS_HIST_BINS - 1;
+  }
+  hist->bins[bin]++;
+  hist->sum   += value;
+  hist->sumSq += (uint64_t)((int64_t)value * value);
+  if ((first == CB_TRUE) || (value < hist->min))
+  {
+    hist->min = value;
+  }
+  if ((first == CB_TRUE) || (value > hist->max))
+  {
+    hist->max = value;
+  }
+}
+
+/**
+ * @brief Write a 32-bit value, little endian.
+ */
+static uint8_t* cb_uwbrxstats_put32(uint8_t *p, uint32_t value)
+{
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+  p[2] = (uint8_t)(value >> 16);
+  p[3] = (uint8_t)(value >> 24);
+  return p + 4;
+}
+
+/**
+ * @brief Write a 64-bit value, little endian.
+ */
+static uint8_t* cb_uwbrxstats_put64(uint8_t *p, uint64_t value)
+{
+  p = cb_uwbrxstats_put32(p, (uint32_t)value);
+  return cb_uwbrxstats_put32(p, (uint32_t)(value >> 32));
+}
+
+/**
+ * @brief Reset the statistics of a run.
+ */
+void cb_uwbrxstats_reset(cb_uwbrxstats_st *stats, cb_uwbsystem_rxport_en enPort)
+{
+  memset(stats, 0, sizeof(cb_uwbrxstats_st));
+  stats->rxPort = (uint8_t)enPort;
+}
+
+/**
+ * @brief Classify a reception from the RX status register.
+ */
+cb_uwbrxstats_outcome_en cb_uwbrxstats_classify(cb_uwbsystem_rxport_en enPort, cb_uwbsystem_rxstatus_un statusRegister)
+{
+  uint16_t rx_ok     = 0;
+  uint16_t pd_det    = 0;
+  uint16_t sfd_det   = 0;
+  uint16_t no_signal = 0;
+
+  switch (enPort)
+  {
+    case EN_UWB_RX_0:
+      rx_ok     = statusRegister.rx0_ok;
+      pd_det    = statusRegister.pd0_det;
+      sfd_det   = statusRegister.sfd0_det;
+      no_signal = statusRegister.no0_signal;
+      break;
+
+    case EN_UWB_RX_1:
+      rx_ok     = statusRegister.rx1_ok;
+      pd_det    = statusRegister.pd1_det;
+      sfd_det   = statusRegister.sfd1_det;
+      no_signal = statusRegister.no1_signal;
+      break;
+
+    case EN_UWB_RX_2:
+      rx_ok     = statusRegister.rx2_ok;
+      pd_det    = statusRegister.pd2_det;
+      sfd_det   = statusRegister.sfd2_det;
+      no_signal = statusRegister.no2_signal;
+      break;
+
+    default:
+      break;
+  }
+
+  if ((rx_ok == CB_TRUE) && (pd_det == CB_TRUE) && (sfd_det == CB_TRUE))
+  {
+    return EN_UWB_RXSTATS_OK;
+  }
+  if (no_signal == CB_TRUE)
+  {
+    return EN_UWB_RXSTATS_NO_SIGNAL;
+  }
+  if (pd_det != CB_TRUE)
+  {
+    return EN_UWB_RXSTATS_PD_FAIL;
+  }
+  if (sfd_det != CB_TRUE)
+  {
+    return EN_UWB_RXSTATS_SFD_FAIL;
+  }
+  if (statusRegister.phr_ded == CB_TRUE)
+  {
+    return EN_UWB_RXSTATS_PHR_ERROR;
+  }
+  if (statusRegister.crc_fail == CB_TRUE)
+  {
+    return EN_UWB_RXSTATS_CRC_FAIL;
+  }
+  if (statusRegister.dsr_ovf == CB_TRUE)
+  {
+    return EN_UWB_RXSTATS_DSR_OVF;
+  }
+  return EN_UWB_RXSTATS_OTHER_FAIL;
+}
+
+/**
+ * @brief Add a reception, constant time.
+ */
+cb_uwbrxstats_outcome_en cb_uwbrxstats_add_packet(cb_uwbrxstats_st *stats, cb_uwbsystem_rxstatus_un statusRegister,
+                                                  const cb_uwbsystem_rx_signalinfo_st *signalInfo)
+{
+  cb_uwbrxstats_outcome_en enOutcome = cb_uwbrxstats_classify((cb_uwbsystem_rxport_en)stats->rxPort, statusRegister);
+
+  stats->seq++;
+  DEF_RXSTATS_BARRIER();
+
+  stats->outcome[enOutcome]++;
+  if (statusRegister.phr_sec == CB_TRUE)
+  {
+    stats->phrCorrected++;
+  }
+
+  // The signal metrics are only meaningful once the receiver has locked on the frame
+  if ((signalInfo != NULL) && (enOutcome != EN_UWB_RXSTATS_NO_SIGNAL) && (enOutcome != EN_UWB_RXSTATS_PD_FAIL) &&
+      (enOutcome != EN_UWB_RXSTATS_SFD_FAIL))
+  {
+    uint8_t first = (stats->signalCount == 0U) ? CB_TRUE : CB_FALSE;
+    int32_t rssi  = signalInfo->rssiRx;
+    int32_t cfo   = cb_uwbsstwr_sign_extend(signalInfo->cfoEst, DEF_UWB_RXSTATS_CFO_BITS);
+    int32_t gain  = signalInfo->gainIdx;
+
+    cb_uwbrxstats_hist_add(&stats->metric[EN_UWB_RXSTATS_RSSI], rssi,
+                           (rssi >= DEF_UWB_RXSTATS_RSSI_MIN) ? ((rssi - DEF_UWB_RXSTATS_RSSI_MIN) / DEF_UWB_RXSTATS_RSSI_BIN_WIDTH) : -1, first);
+    // Arithmetic shift: negative values round towards -infinity, as wanted for the bins
+    cb_uwbrxstats_hist_add(&stats->metric[EN_UWB_RXSTATS_CFO], cfo, (cfo >> DEF_UWB_RXSTATS_CFO_BIN_SHIFT) + DEF_RXSTATS_CFO_BIN_OFFSET, first);
+    cb_uwbrxstats_hist_add(&stats->metric[EN_UWB_RXSTATS_GAIN], gain, gain - DEF_UWB_RXSTATS_GAIN_MIN, first);
+    stats->signalCount++;
+  }
+
+  DEF_RXSTATS_BARRIER();
+  stats->seq++;
+  return enOutcome;
+}
+
+/**
+ * @brief Add a reception without RX done (timeout).
+ */
+void cb_uwbrxstats_add_missed(cb_uwbrxstats_st *stats)
+{
+  stats->outcome[EN_UWB_RXSTATS_MISSED]++;
+}
+
+/**
+ * @brief Take a consistent copy of the statistics while the IRQ keeps updating them.
+ */
+CB_STATUS cb_uwbrxstats_snapshot(const cb_uwbrxstats_st *stats, cb_uwbrxstats_st *snapshot)
+{
+  for (uint8_t attempt = 0; attempt < DEF_UWB_RXSTATS_SNAPSHOT_RETRIES; attempt++)
+  {
+    uint32_t seq = stats->seq;
+    if ((seq & 1UL) != 0U)
+    {
+      continue;
+    }
+    DEF_RXSTATS_BARRIER();
+    memcpy(snapshot, (const void *)stats, sizeof(cb_uwbrxstats_st));
+    DEF_RXSTATS_BARRIER();
+    if (stats->seq == seq)
+    {
+      return CB_PASS;
+    }
+  }
+  return CB_FAIL;
+}
+
+/**
+ * @brief Packet error rate with its Wilson score confidence interval.
+ */
+void cb_uwbrxstats_per(const cb_uwbrxstats_st *snapshot, float z, cb_uwbrxstats_per_st *result)
+{
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < (uint8_t)EN_UWB_RXSTATS_OUTCOME_NUM; i++)
+  {
+    total += snapshot->outcome[i];
+  }
+  result->total  = total;
+  result->errors = total - snapshot->outcome[EN_UWB_RXSTATS_OK];
+
+  if (total == 0U)
+  {
+    result->per   = 0.0f;
+    result->lower = 0.0f;
+    result->upper = 1.0f;
+    return;
+  }
+
+  double n      = (double)total;
+  double p      = (double)result->errors / n;
+  double z2     = (double)z * (double)z;
+  double denom  = 1.0 + (z2 / n);
+  double centre = (p + (z2 / (2.0 * n))) / denom;
+  double half   = ((double)z / denom) * sqrt(((p * (1.0 - p)) / n) + (z2 / (4.0 * n * n)));
+
+  result->per   = (float)p;
+  result->lower = (float)(((centre - half) > 0.0) ? (centre - half) : 0.0);
+  result->upper = (float)(((centre + half) < 1.0) ? (centre + half) : 1.0);
+}
+
+/**
+ * @brief Mean and standard deviation of a metric.
+ */
+void cb_uwbrxstats_moments(const cb_uwbrxstats_st *snapshot, cb_uwbrxstats_metric_en enMetric, float *mean, float *stddev)
+{
+  *mean   = 0.0f;
+  *stddev = 0.0f;
+  if ((enMetric >= EN_UWB_RXSTATS_METRIC_NUM) || (snapshot->signalCount == 0U))
+  {
+    return;
+  }
+
+  const cb_uwbrxstats_hist_st *hist = &snapshot->metric[enMetric];
+  double n   = (double)snapshot->signalCount;
+  double m   = (double)hist->sum / n;
+  double var = ((double)hist->sumSq / n) - (m * m);
+
+  *mean = (float)m;
+  if ((snapshot->signalCount > 1U) && (var > 0.0))
+  {
+    *stddev = (float)sqrt(var);
+  }
+}
+
+/**
+ * @brief Value at the lower edge of a histogram bin.
+ */
+int32_t cb_uwbrxstats_bin_lower_edge(cb_uwbrxstats_metric_en enMetric, uint8_t bin)
+{
+  switch (enMetric)
+  {
+    case EN_UWB_RXSTATS_RSSI:
+      return DEF_UWB_RXSTATS_RSSI_MIN + ((int32_t)bin * DEF_UWB_RXSTATS_RSSI_BIN_WIDTH);
+
+    case EN_UWB_RXSTATS_CFO:
+      return ((int32_t)bin - DEF_RXSTATS_CFO_BIN_OFFSET) * (1L << DEF_UWB_RXSTATS_CFO_BIN_SHIFT);
+
+    case EN_UWB_RXSTATS_GAIN:
+      return DEF_UWB_RXSTATS_GAIN_MIN + (int32_t)bin;
+
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Serialize a snapshot, little endian, fixed layout.
+ */
+uint16_t cb_uwbrxstats_serialize(const cb_uwbrxstats_st *snapshot, uint8_t *buf, uint16_t bufSize)
+{
+  if (bufSize < DEF_UWB_RXSTATS_SERIALIZED_SIZE)
+  {
+    return 0;
+  }
+
+  uint8_t *p = buf;
+  *p++ = DEF_UWB_RXSTATS_FORMAT_VERSION;
+  *p++ = snapshot->rxPort;
+  *p++ = DEF_UWB_RXSTATS_HIST_BINS;
+  *p++ = 0;
+  p = cb_uwbrxstats_put32(p, snapshot->signalCount);
+  for (uint8_t i = 0; i < (uint8_t)EN_UWB_RXSTATS_OUTCOME_NUM; i++)
+  {
+    p = cb_uwbrxstats_put32(p, snapshot->outcome[i]);
+  }
+  p = cb_uwbrxstats_put32(p, snapshot->phrCorrected);
+  p = cb_uwbrxstats_put32(p, 0);
+  for (uint8_t metric = 0; metric < (uint8_t)EN_UWB_RXSTATS_METRIC_NUM; metric++)
+  {
+    const cb_uwbrxstats_hist_st *hist = &snapshot->metric[metric];
+    p = cb_uwbrxstats_put64(p, (uint64_t)hist->sum);
+    p = cb_uwbrxstats_put64(p, hist->sumSq);
+    p = cb_uwbrxstats_put32(p, (uint32_t)hist->min);
+    p = cb_uwbrxstats_put32(p, (uint32_t)hist->max);
+    for (uint8_t bin = 0; bin < DEF_UWB_RXSTATS_HIST_BINS; bin++)
+    {
+      p = cb_uwbrxstats_put32(p, hist->bins[bin]);
+    }
+  }
+  return (uint16_t)(p - buf);
+}
@@ -0,0 +1,225 @@
+/**
+ * @file    CB_uwbrxstats.h
+ * @brief   UWB RX packet error rate and link-quality statistics.
+ * @details Per-run statistics of a reception test: outcome of each reception from the RX status
+ *          register (cb_framework_uwb_get_rx_status()), with the first failing stage of the receiver
+ *          chain, and fixed-bin histograms with running moments of the RSSI, CFO estimate and gain
+ *          index reported by cb_framework_uwb_get_rx_rssi().
+ *          The update of a packet is constant-time and allocation free, so it can run in the RX done
+ *          IRQ. A snapshot can be taken at any time from the thread context without stopping the
+ *          reception: the IRQ updates are framed by a sequence counter and the copy is retried if an
+ *          update ran during it.
+ *          The PER is given with a Wilson score confidence interval, which stays inside [0, 1] and
+ *          is usable with few or no errors.
+ *          No hardware access: the module can be built and tested on a host.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_UWBRXSTATS_H
+#define __CB_UWBRXSTATS_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_Common.h"
+#include "CB_system_types.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DEF_UWB_RXSTATS_HIST_BINS
+#define DEF_UWB_RXSTATS_HIST_BINS         32      /**< Bins of each histogram, first and last bins hold the values out of range */
+#endif
+#ifndef DEF_UWB_RXSTATS_RSSI_MIN
+#define DEF_UWB_RXSTATS_RSSI_MIN          (-120)  /**< Lower edge of the RSSI histogram */
+#endif
+#ifndef DEF_UWB_RXSTATS_RSSI_BIN_WIDTH
+#define DEF_UWB_RXSTATS_RSSI_BIN_WIDTH    2       /**< RSSI histogram bin width */
+#endif
+#ifndef DEF_UWB_RXSTATS_CFO_BITS
+#define DEF_UWB_RXSTATS_CFO_BITS          16      /**< Significant bits of cfoEst, two's complement */
+#endif
+#ifndef DEF_UWB_RXSTATS_CFO_BIN_SHIFT
+#define DEF_UWB_RXSTATS_CFO_BIN_SHIFT     6       /**< CFO histogram bin width is 2^n cfoEst LSB, centred on 0 */
+#endif
+#ifndef DEF_UWB_RXSTATS_GAIN_MIN
+#define DEF_UWB_RXSTATS_GAIN_MIN          0       /**< Gain index of the first bin, one bin per index */
+#endif
+#ifndef DEF_UWB_RXSTATS_SNAPSHOT_RETRIES
+#define DEF_UWB_RXSTATS_SNAPSHOT_RETRIES  8       /**< Copies attempted by cb_uwbrxstats_snapshot() */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_UWB_RXSTATS_FORMAT_VERSION    1       /**< Version of the cb_uwbrxstats_serialize() layout */
+#define DEF_UWB_RXSTATS_SERIALIZED_SIZE   (8 + (EN_UWB_RXSTATS_OUTCOME_NUM * 4) + 8 + (EN_UWB_RXSTATS_METRIC_NUM * (24 + (DEF_UWB_RXSTATS_HIST_BINS * 4))))
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+/**
+ * @brief Outcome of a reception, first failing stage of the receiver chain.
+ */
+typedef enum
+{
+  EN_UWB_RXSTATS_OK = 0,          /**< rx_ok, preamble and SFD detected */
+  EN_UWB_RXSTATS_MISSED,          /**< No RX done before the timeout */
+  EN_UWB_RXSTATS_NO_SIGNAL,       /**< no_signal */
+  EN_UWB_RXSTATS_PD_FAIL,         /**< Preamble not detected */
+  EN_UWB_RXSTATS_SFD_FAIL,        /**< SFD not detected */
+  EN_UWB_RXSTATS_PHR_ERROR,       /**< PHR double error detected */
+  EN_UWB_RXSTATS_CRC_FAIL,        /**< Payload CRC failure */
+  EN_UWB_RXSTATS_DSR_OVF,         /**< DSR overflow */
+  EN_UWB_RXSTATS_OTHER_FAIL,      /**< rx_ok not set without other indication (e.g. STS) */
+  EN_UWB_RXSTATS_OUTCOME_NUM,
+} cb_uwbrxstats_outcome_en;
+
+/**
+ * @brief Signal metric with a histogram.
+ */
+typedef enum
+{
+  EN_UWB_RXSTATS_RSSI = 0,
+  EN_UWB_RXSTATS_CFO,
+  EN_UWB_RXSTATS_GAIN,
+  EN_UWB_RXSTATS_METRIC_NUM,
+} cb_uwbrxstats_metric_en;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Histogram and running moments of a metric, over the packets received.
+ */
+typedef struct
+{
+  int64_t   sum;
+  uint64_t  sumSq;
+  int32_t   min;
+  int32_t   max;
+  uint32_t  bins[DEF_UWB_RXSTATS_HIST_BINS];
+} cb_uwbrxstats_hist_st;
+
+/**
+ * @brief Statistics of a run.
+ */
+typedef struct
+{
+  volatile uint32_t     seq;                                      /**< Odd while an IRQ update is in progress */
+  uint8_t               rxPort;                                   /**< cb_uwbsystem_rxport_en of the status bits */
+  uint32_t              outcome[EN_UWB_RXSTATS_OUTCOME_NUM];      /**< Receptions per outcome */
+  uint32_t              phrCorrected;                             /**< PHR single error corrected, any outcome */
+  uint32_t              signalCount;                              /**< Packets in the histograms */
+  cb_uwbrxstats_hist_st metric[EN_UWB_RXSTATS_METRIC_NUM];
+} cb_uwbrxstats_st;
+
+/**
+ * @brief Packet error rate and confidence interval.
+ */
+typedef struct
+{
+  uint32_t  total;    /**< Receptions, including missed ones */
+  uint32_t  errors;   /**< Receptions not EN_UWB_RXSTATS_OK */
+  float     per;      /**< errors / total */
+  float     lower;    /**< Lower bound of the confidence interval */
+  float     upper;    /**< Upper bound of the confidence interval */
+} cb_uwbrxstats_per_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Reset the statistics of a run.
+ *
+ * @param stats  Statistics.
+ * @param enPort RX port whose status bits are used (EN_UWB_RX_0, EN_UWB_RX_1 or EN_UWB_RX_2).
+ */
+void cb_uwbrxstats_reset(cb_uwbrxstats_st *stats, cb_uwbsystem_rxport_en enPort);
+
+/**
+ * @brief Classify a reception from the RX status register.
+ *
+ * @param enPort       RX port.
+ * @param statusRegister RX status register.
+ * @return Outcome of the reception.
+ */
+cb_uwbrxstats_outcome_en cb_uwbrxstats_classify(cb_uwbsystem_rxport_en enPort, cb_uwbsystem_rxstatus_un statusRegister);
+
+/**
+ * @brief Add a reception, constant time. Can be called from the RX done IRQ.
+ *
+ * @param stats          Statistics.
+ * @param statusRegister RX status register of the reception.
+ * @param signalInfo     RSSI, CFO and gain of the reception, NULL if not read. Only added to the
+ *                       histograms when preamble and SFD were detected.
+ * @return Outcome of the reception.
+ */
+cb_uwbrxstats_outcome_en cb_uwbrxstats_add_packet(cb_uwbrxstats_st *stats, cb_uwbsystem_rxstatus_un statusRegister,
+                                                  const cb_uwbsystem_rx_signalinfo_st *signalInfo);
+
+/**
+ * @brief Add a reception without RX done (timeout).
+ *
+ * Only written outside of the sequence counter: call it from the context that takes the snapshots.
+ *
+ * @param stats Statistics.
+ */
+void cb_uwbrxstats_add_missed(cb_uwbrxstats_st *stats);
+
+/**
+ * @brief Take a consistent copy of the statistics while the IRQ keeps updating them.
+ *
+ * @param stats    Statistics.
+ * @param snapshot Copy.
+ * @return CB_PASS on success, CB_FAIL if every attempt was interrupted by an update.
+ */
+CB_STATUS cb_uwbrxstats_snapshot(const cb_uwbrxstats_st *stats, cb_uwbrxstats_st *snapshot);
+
+/**
+ * @brief Packet error rate with its Wilson score confidence interval.
+ *
+ * @param snapshot Statistics.
+ * @param z        Standard normal quantile of the confidence level, e.g. 1.96 for 95%.
+ * @param result   PER and interval, 0 to 1 with no reception.
+ */
+void cb_uwbrxstats_per(const cb_uwbrxstats_st *snapshot, float z, cb_uwbrxstats_per_st *result);
+
+/**
+ * @brief Mean and standard deviation of a metric.
+ *
+ * @param snapshot Statistics.
+ * @param enMetric Metric.
+ * @param mean     Mean, 0 with no packet.
+ * @param stddev   Population standard deviation, 0 with less than 2 packets.
+ */
+void cb_uwbrxstats_moments(const cb_uwbrxstats_st *snapshot, cb_uwbrxstats_metric_en enMetric, float *mean, float *stddev);
+
+/**
+ * @brief Value at the lower edge of a histogram bin.
+ *
+ * @param enMetric Metric.
+ * @param bin      Bin index.
+ * @return Lower edge, in the unit of the metric.
+ */
+int32_t cb_uwbrxstats_bin_lower_edge(cb_uwbrxstats_metric_en enMetric, uint8_t bin);
+
+/**
+ * @brief Serialize a snapshot, little endian, fixed layout:
+ *        version (1), rx port (1), histogram bins (1), reserved (1), signal count (4),
+ *        outcome counters (4 each), PHR corrected (4), reserved (4), then for each metric
+ *        sum (8), sum of squares (8), min (4), max (4) and the bins (4 each).
+ *
+ * @param snapshot Statistics.
+ * @param buf      Output buffer.
+ * @param bufSize  Size of the buffer.
+ * @return Bytes written (DEF_UWB_RXSTATS_SERIALIZED_SIZE), 0 if the buffer is too small.
+ */
+uint16_t cb_uwbrxstats_serialize(const cb_uwbrxstats_st *snapshot, uint8_t *buf, uint16_t bufSize);
+
+#endif /*__CB_UWBRXSTATS_H*/
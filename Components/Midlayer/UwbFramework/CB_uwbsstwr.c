@@ -0,0 +1,245 @@
+/**
+ * @file    CB_uwbsstwr.c
+ * @brief   Clock-offset compensated single-sided two-way ranging (SS-TWR).
+ * @details Reply time clock offset correction, cfoEst to ppm calibration against DS-TWR, bias error
+ *          model and responder reply time prediction. See CB_uwbsstwr.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "CB_uwbsstwr.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_SSTWR_PPM                     1.0e-6
+#define DEF_SSTWR_PREDICTOR_SHIFT         3         /**< TX delay learning rate, 1/8 */
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static double cb_uwbsstwr_ticks(uint32_t intCount, int16_t fracCount);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief TSU interval in integer counts.
+ *
+ * @param intCount  Integer counts.
+ * @param fracCount Fractional counts.
+ * @return Interval in integer counts.
+ */
+static double cb_uwbsstwr_ticks(uint32_t intCount, int16_t fracCount)
+{
+  return (double)intCount + ((double)fracCount / DEF_UWB_SSTWR_TSU_FRAC_COUNTS);
+}
+
+/**
+ * @brief Sign-extend a two's complement field.
+ */
+int32_t cb_uwbsstwr_sign_extend(uint32_t value, uint8_t bits)
+{
+  if ((bits == 0U) || (bits >= 32U))
+  {
+    return (int32_t)value;
+  }
+  uint32_t signBit = 1UL << (bits - 1U);
+  value &= (signBit << 1) - 1UL;
+  return (int32_t)(value ^ signBit) - (int32_t)signBit;
+}
+
+/**
+ * @brief Fill an uncalibrated cfoEst conversion.
+ */
+void cb_uwbsstwr_default_cfo_calibration(cb_uwbsstwr_cfocal_st *cal)
+{
+  cal->ppmPerLsb   = DEF_UWB_SSTWR_CFO_PPM_PER_LSB;
+  cal->ppmOffset   = 0.0f;
+  cal->residualPpm = DEF_UWB_SSTWR_RESIDUAL_PPM;
+  cal->cfoBits     = DEF_UWB_SSTWR_CFO_BITS;
+  cal->calibrated  = CB_FALSE;
+}
+
+/**
+ * @brief Convert a TSU interval to ns.
+ */
+double cb_uwbsstwr_tsu_to_ns(uint32_t intCount, int16_t fracCount)
+{
+  return cb_uwbsstwr_ticks(intCount, fracCount) * DEF_UWB_SSTWR_TSU_TICK_NS;
+}
+
+/**
+ * @brief Convert cfoEst to the responder clock offset, in ppm.
+ */
+float cb_uwbsstwr_cfo_to_ppm(const cb_uwbsstwr_cfocal_st *cal, uint32_t cfoEst)
+{
+  return (cal->ppmPerLsb * (float)cb_uwbsstwr_sign_extend(cfoEst, cal->cfoBits)) + cal->ppmOffset;
+}
+
+/**
+ * @brief Clock-offset compensated SS-TWR.
+ */
+void cb_uwbsstwr_calculate(const cb_uwbsstwr_cfocal_st *cal, const cb_uwbsystem_rangingtroundtreply_st *initiator,
+                           const cb_uwbsystem_rangingtroundtreply_st *responder, uint32_t cfoEst, int32_t bias_cm,
+                           cb_uwbsstwr_result_st *result)
+{
+  double tround_ns = cb_uwbsstwr_tsu_to_ns(initiator->T_round_int, initiator->T_round_frac);
+  double treply_ns = cb_uwbsstwr_tsu_to_ns(responder->T_reply_int, responder->T_reply_frac);
+  float  offset    = cb_uwbsstwr_cfo_to_ppm(cal, cfoEst);
+
+  // Reply time in the initiator time base
+  result->tof_ns          = (tround_ns - (treply_ns / (1.0 + ((double)offset * DEF_SSTWR_PPM)))) * 0.5;
+  result->distance_cm     = (result->tof_ns * DEF_UWB_SSTWR_CM_PER_NS) - DEF_UWB_SSTWR_RANGING_OFFSET_CM + (double)bias_cm;
+  result->clockOffset_ppm = offset;
+  result->expectedBias_cm = cb_uwbsstwr_expected_bias_cm((float)(treply_ns * 1.0e-3), cal->residualPpm);
+}
+
+/**
+ * @brief Distance bias left by a clock offset error over a reply time.
+ */
+float cb_uwbsstwr_expected_bias_cm(float treply_us, float ppmError)
+{
+  // Treply[ns] * ppmError * 1e-6 / 2 * 30 cm/ns, with Treply[ns] = Treply[us] * 1e3
+  return fabsf(treply_us * ppmError) * (float)(DEF_UWB_SSTWR_CM_PER_NS * 1.0e-3 * 0.5);
+}
+
+/**
+ * @brief Reset a calibration accumulator.
+ */
+void cb_uwbsstwr_cal_reset(cb_uwbsstwr_calaccum_st *acc)
+{
+  memset(acc, 0, sizeof(cb_uwbsstwr_calaccum_st));
+}
+
+/**
+ * @brief Add one DS-TWR exchange to the calibration.
+ */
+void cb_uwbsstwr_cal_add(cb_uwbsstwr_calaccum_st *acc, const cb_uwbsstwr_cfocal_st *cal, uint32_t cfoEst,
+                         const cb_uwbsystem_rangingtroundtreply_st *initiator,
+                         const cb_uwbsystem_rangingtroundtreply_st *responder, double dstwrTof_ns)
+{
+  double tround_ns = cb_uwbsstwr_tsu_to_ns(initiator->T_round_int, initiator->T_round_frac);
+  double treply_ns = cb_uwbsstwr_tsu_to_ns(responder->T_reply_int, responder->T_reply_frac);
+  double treplyInit_ns = tround_ns - (2.0 * dstwrTof_ns);
+
+  if (treplyInit_ns <= 0.0)
+  {
+    return;
+  }
+
+  double x = (double)cb_uwbsstwr_sign_extend(cfoEst, cal->cfoBits);
+  double y = ((treply_ns / treplyInit_ns) - 1.0) / DEF_SSTWR_PPM;
+
+  acc->count++;
+  acc->sumX  += x;
+  acc->sumY  += y;
+  acc->sumXX += x * x;
+  acc->sumXY += x * y;
+  acc->sumYY += y * y;
+}
+
+/**
+ * @brief Least-squares fit of the cfoEst conversion.
+ */
+CB_STATUS cb_uwbsstwr_cal_solve(const cb_uwbsstwr_calaccum_st *acc, cb_uwbsstwr_cfocal_st *cal)
+{
+  if (acc->count < DEF_UWB_SSTWR_CAL_MIN_SAMPLES)
+  {
+    return CB_FAIL;
+  }
+
+  double n     = (double)acc->count;
+  double varX  = acc->sumXX - ((acc->sumX * acc->sumX) / n);
+  double covXY = acc->sumXY - ((acc->sumX * acc->sumY) / n);
+  double varY  = acc->sumYY - ((acc->sumY * acc->sumY) / n);
+
+  // Needs several clock offsets, e.g. devices at different temperatures or a trimmed crystal
+  if (varX <= 0.0)
+  {
+    return CB_FAIL;
+  }
+
+  double slope  = covXY / varX;
+  double offset = (acc->sumY - (slope * acc->sumX)) / n;
+  double sse    = varY - (slope * covXY);
+
+  cal->ppmPerLsb   = (float)slope;
+  cal->ppmOffset   = (float)offset;
+  cal->residualPpm = (float)sqrt((sse > 0.0) ? (sse / n) : 0.0);
+  cal->calibrated  = CB_TRUE;
+  return CB_PASS;
+}
+
+/**
+ * @brief Reset a reply time predictor.
+ */
+void cb_uwbsstwr_reply_predictor_reset(cb_uwbsstwr_replypredictor_st *predictor)
+{
+  memset(predictor, 0, sizeof(cb_uwbsstwr_replypredictor_st));
+}
+
+/**
+ * @brief Predict the reply time of a scheduled RESPONSE.
+ */
+CB_STATUS cb_uwbsstwr_reply_predict(const cb_uwbsstwr_replypredictor_st *predictor, const cb_uwbsystem_rx_tsutimestamp_st *rxPoll,
+                                    cb_uwbsystem_rangingtroundtreply_st *treply)
+{
+  if (predictor->count == 0U)
+  {
+    return CB_FAIL;
+  }
+
+  // TX = RX integer count + TX delay, so Treply = TX delay - RX fractional count
+  double   delayInt  = floor(predictor->txDelay_ticks);
+  int32_t  delayFrac = (int32_t)lround((predictor->txDelay_ticks - delayInt) * DEF_UWB_SSTWR_TSU_FRAC_COUNTS);
+
+  treply->T_reply_int  = (uint32_t)delayInt;
+  treply->T_reply_frac = (int16_t)(delayFrac - (int32_t)rxPoll->rxTsuFrac);
+  return CB_PASS;
+}
+
+/**
+ * @brief Learn the TX delay from the actual RESPONSE TX timestamp.
+ */
+void cb_uwbsstwr_reply_learn(cb_uwbsstwr_replypredictor_st *predictor, const cb_uwbsystem_rx_tsutimestamp_st *rxPoll,
+                             const cb_uwbsystem_tx_tsutimestamp_st *txResp)
+{
+  double delay = cb_uwbsstwr_ticks(txResp->txTsuInt - rxPoll->rxTsuInt, (int16_t)txResp->txTsuFrac);
+
+  if (predictor->count == 0U)
+  {
+    predictor->txDelay_ticks = delay;
+    predictor->jitter_ticks  = 0.0;
+  }
+  else
+  {
+    double error = delay - predictor->txDelay_ticks;
+    predictor->jitter_ticks  += (fabs(error) - predictor->jitter_ticks) / (double)(1U << DEF_SSTWR_PREDICTOR_SHIFT);
+    predictor->txDelay_ticks += error / (double)(1U << DEF_SSTWR_PREDICTOR_SHIFT);
+  }
+  if (predictor->count < UINT32_MAX)
+  {
+    predictor->count++;
+  }
+}
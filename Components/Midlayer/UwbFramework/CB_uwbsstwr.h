@@ -0,0 +1,239 @@
+/**
+ * @file    CB_uwbsstwr.h
+ * @brief   Clock-offset compensated single-sided two-way ranging (SS-TWR).
+ * @details SS-TWR needs two messages (POLL, RESPONSE) instead of the three of DS-TWR, but the reply
+ *          time measured by the responder clock is scaled by the clock offset between both devices:
+ *          an offset e gives a ToF error of Treply * e / 2, i.e. ~1 m for 700 us and 10 ppm.
+ *          The initiator measures that offset on the RESPONSE frame (cfoEst of
+ *          cb_uwbsystem_rx_signalinfo_st) and corrects the reply time:
+ *
+ *              ToF = (Tround - Treply / (1 + e)) / 2
+ *
+ *          The cfoEst to ppm conversion is linear and calibrated against DS-TWR, which is not
+ *          sensitive to the clock offset. The error model gives the bias left for a reply time and a
+ *          residual ppm error.
+ *          The responder can only send its reply time in the RESPONSE if it knows its TX timestamp
+ *          before transmitting: with a scheduled TX, it is predicted from the RX timestamp and a
+ *          learnt TX delay (cb_uwbsstwr_replypredictor_st).
+ *          No hardware access: the module can be built and tested on a host.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_UWBSSTWR_H
+#define __CB_UWBSSTWR_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_Common.h"
+#include "CB_system_types.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DEF_UWB_SSTWR_CFO_BITS
+#define DEF_UWB_SSTWR_CFO_BITS            16        /**< Significant bits of cfoEst, two's complement */
+#endif
+#ifndef DEF_UWB_SSTWR_CFO_PPM_PER_LSB
+#define DEF_UWB_SSTWR_CFO_PPM_PER_LSB     0.01f     /**< Placeholder cfoEst to ppm slope, replaced by the cb_uwbsstwr_cal_solve() fit (e.g. stored in the FTM calibration page) */
+#endif
+#ifndef DEF_UWB_SSTWR_RESIDUAL_PPM
+#define DEF_UWB_SSTWR_RESIDUAL_PPM        1.0f      /**< Uncalibrated residual clock offset error, in ppm */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_UWB_SSTWR_TSU_TICK_NS         (1000.0 / 124.8)  /**< TSU integer count, 1/124.8MHz */
+#define DEF_UWB_SSTWR_TSU_FRAC_COUNTS     512               /**< TSU fractional counts per integer count */
+#define DEF_UWB_SSTWR_CM_PER_NS           30.0              /**< Same scale as cb_framework_uwb_calculate_distance() */
+#define DEF_UWB_SSTWR_RANGING_OFFSET_CM   18617             /**< TRX delay offset, same as cb_framework_uwb_calculate_distance() */
+#define DEF_UWB_SSTWR_CAL_MIN_SAMPLES     8                 /**< Samples needed by cb_uwbsstwr_cal_solve() */
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief cfoEst to clock offset conversion: offset_ppm = ppmPerLsb * signed(cfoEst) + ppmOffset.
+ *
+ * The offset is the responder clock relative to the initiator clock, (f_resp - f_init) / f_init.
+ */
+typedef struct
+{
+  float     ppmPerLsb;      /**< Slope, its sign absorbs the CFO estimator convention */
+  float     ppmOffset;      /**< Estimator bias */
+  float     residualPpm;    /**< RMS clock offset error after conversion, input of the error model */
+  uint8_t   cfoBits;        /**< Significant bits of cfoEst */
+  uint8_t   calibrated;     /**< CB_TRUE once fitted against DS-TWR */
+} cb_uwbsstwr_cfocal_st;
+
+/**
+ * @brief Calibration accumulator: clock offsets measured by DS-TWR against cfoEst.
+ */
+typedef struct
+{
+  uint32_t  count;
+  double    sumX;           /**< Signed cfoEst */
+  double    sumY;           /**< Clock offset from DS-TWR, in ppm */
+  double    sumXX;
+  double    sumXY;
+  double    sumYY;
+} cb_uwbsstwr_calaccum_st;
+
+/**
+ * @brief Responder reply time predictor for a scheduled RESPONSE.
+ *
+ * The abs timer starts the TX a fixed delay after a coarse RX event, so the TX timestamp is the RX
+ * integer count plus a constant; the reply time then only depends on the RX fractional count.
+ */
+typedef struct
+{
+  double    txDelay_ticks;  /**< Learnt TX timestamp - RX integer count, in TSU ticks */
+  double    jitter_ticks;   /**< Running mean absolute prediction error */
+  uint32_t  count;          /**< Exchanges learnt */
+} cb_uwbsstwr_replypredictor_st;
+
+/**
+ * @brief SS-TWR result.
+ */
+typedef struct
+{
+  double    tof_ns;           /**< Compensated time of flight, including the TRX delays */
+  double    distance_cm;      /**< Distance, same scale and offset as cb_framework_uwb_calculate_distance() */
+  float     clockOffset_ppm;  /**< Clock offset applied */
+  float     expectedBias_cm;  /**< Error model: bias left by the residual clock offset error */
+} cb_uwbsstwr_result_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Fill an uncalibrated cfoEst conversion.
+ *
+ * @param cal Conversion to fill.
+ */
+void cb_uwbsstwr_default_cfo_calibration(cb_uwbsstwr_cfocal_st *cal);
+
+/**
+ * @brief Sign-extend a two's complement field, e.g. cfoEst of cb_uwbsystem_rx_signalinfo_st.
+ *
+ * @param value Raw value, bits above the field are ignored.
+ * @param bits  Field width, 1 to 32.
+ * @return Signed value.
+ */
+int32_t cb_uwbsstwr_sign_extend(uint32_t value, uint8_t bits);
+
+/**
+ * @brief Convert a TSU interval (integer, fractional counts) to ns.
+ *
+ * @param intCount  Integer counts, 1/124.8MHz.
+ * @param fracCount Fractional counts, 1/512 of an integer count.
+ * @return Interval in ns.
+ */
+double cb_uwbsstwr_tsu_to_ns(uint32_t intCount, int16_t fracCount);
+
+/**
+ * @brief Convert cfoEst to the responder clock offset.
+ *
+ * @param cal    Conversion.
+ * @param cfoEst cfoEst of the RESPONSE frame.
+ * @return Clock offset, in ppm.
+ */
+float cb_uwbsstwr_cfo_to_ppm(const cb_uwbsstwr_cfocal_st *cal, uint32_t cfoEst);
+
+/**
+ * @brief Clock-offset compensated SS-TWR.
+ *
+ * @param cal       cfoEst conversion.
+ * @param initiator Initiator times, T_round_int/T_round_frac: RESPONSE RX - POLL TX.
+ * @param responder Responder times, T_reply_int/T_reply_frac: RESPONSE TX - POLL RX.
+ * @param cfoEst    cfoEst of the RESPONSE frame, measured by the initiator.
+ * @param bias_cm   Ranging bias of both devices.
+ * @param result    Result.
+ */
+void cb_uwbsstwr_calculate(const cb_uwbsstwr_cfocal_st *cal, const cb_uwbsystem_rangingtroundtreply_st *initiator,
+                           const cb_uwbsystem_rangingtroundtreply_st *responder, uint32_t cfoEst, int32_t bias_cm,
+                           cb_uwbsstwr_result_st *result);
+
+/**
+ * @brief Error model: distance bias left by a clock offset error over a reply time.
+ *
+ * bias = c * Treply * ppmError / 2, e.g. 1.05 cm for 700 us and 0.1 ppm; DS-TWR is not affected.
+ *
+ * @param treply_us Reply time, in us.
+ * @param ppmError  Clock offset error, in ppm (the full offset when not compensated).
+ * @return Distance bias, in cm.
+ */
+float cb_uwbsstwr_expected_bias_cm(float treply_us, float ppmError);
+
+/**
+ * @brief Reset a calibration accumulator.
+ *
+ * @param acc Accumulator.
+ */
+void cb_uwbsstwr_cal_reset(cb_uwbsstwr_calaccum_st *acc);
+
+/**
+ * @brief Add one DS-TWR exchange to the calibration.
+ *
+ * The clock offset is Treply1 / (Tround1 - 2 * ToF) - 1, where Tround1 / Treply1 are the first
+ * round (POLL, RESPONSE) and ToF is the DS-TWR result, not sensitive to the offset.
+ *
+ * @param acc       Accumulator.
+ * @param cal       Conversion, for cfoBits.
+ * @param cfoEst    cfoEst of the RESPONSE frame.
+ * @param initiator Initiator times (T_round: RESPONSE RX - POLL TX).
+ * @param responder Responder times (T_reply: RESPONSE TX - POLL RX).
+ * @param dstwrTof_ns DS-TWR time of flight on the same exchange, same scale as tof_ns.
+ */
+void cb_uwbsstwr_cal_add(cb_uwbsstwr_calaccum_st *acc, const cb_uwbsstwr_cfocal_st *cal, uint32_t cfoEst,
+                         const cb_uwbsystem_rangingtroundtreply_st *initiator,
+                         const cb_uwbsystem_rangingtroundtreply_st *responder, double dstwrTof_ns);
+
+/**
+ * @brief Least-squares fit of the cfoEst conversion.
+ *
+ * @param acc Accumulator, at least DEF_UWB_SSTWR_CAL_MIN_SAMPLES samples.
+ * @param cal Conversion updated on success, residualPpm is the RMS fit error.
+ * @return CB_PASS on success, CB_FAIL with too few samples or no cfoEst spread.
+ */
+CB_STATUS cb_uwbsstwr_cal_solve(const cb_uwbsstwr_calaccum_st *acc, cb_uwbsstwr_cfocal_st *cal);
+
+/**
+ * @brief Reset a reply time predictor.
+ *
+ * @param predictor Predictor.
+ */
+void cb_uwbsstwr_reply_predictor_reset(cb_uwbsstwr_replypredictor_st *predictor);
+
+/**
+ * @brief Predict the reply time of a scheduled RESPONSE, before it is transmitted.
+ *
+ * @param predictor Predictor.
+ * @param rxPoll    POLL RX timestamp.
+ * @param treply    Predicted T_reply_int / T_reply_frac.
+ * @return CB_PASS if the predictor has learnt the TX delay, CB_FAIL otherwise.
+ */
+CB_STATUS cb_uwbsstwr_reply_predict(const cb_uwbsstwr_replypredictor_st *predictor, const cb_uwbsystem_rx_tsutimestamp_st *rxPoll,
+                                    cb_uwbsystem_rangingtroundtreply_st *treply);
+
+/**
+ * @brief Learn the TX delay from the actual RESPONSE TX timestamp.
+ *
+ * @param predictor Predictor.
+ * @param rxPoll    POLL RX timestamp.
+ * @param txResp    RESPONSE TX timestamp.
+ */
+void cb_uwbsstwr_reply_learn(cb_uwbsstwr_replypredictor_st *predictor, const cb_uwbsystem_rx_tsutimestamp_st *rxPoll,
+                             const cb_uwbsystem_tx_tsutimestamp_st *txResp);
+
+#endif /*__CB_UWBSSTWR_H*/
@@ -0,0 +1,196 @@
+/**
+ * @file    CB_uwbtempcomp.c
+ * @brief   Temperature-tracked ranging and PDoA bias compensation.
+ * @details Table interpolation and periodic temperature sampling. See CB_uwbtempcomp.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "CB_uwbtempcomp.h"
+#include "CB_system.h"
+#include "NonLIB_sharedUtils.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static cb_uwbtempcomp_point_st  s_stTempCompTable[DEF_UWB_TEMPCOMP_MAX_POINTS];
+static uint8_t                  s_tempCompNumPoints;
+static cb_uwbtempcomp_point_st  s_stTempCompCorrection;
+static uint32_t                 s_tempCompSampleTick;
+static uint8_t                  s_tempCompSampled;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Load the calibration table and reset the corrections to zero.
+ *
+ * @param points    Calibration points.
+ * @param numPoints Number of points.
+ * @return CB_PASS on success, CB_FAIL on an invalid table.
+ */
+CB_STATUS cb_uwbtempcomp_init(const cb_uwbtempcomp_point_st *points, uint8_t numPoints)
+{
+  memset(&s_stTempCompCorrection, 0, sizeof(s_stTempCompCorrection));
+  s_tempCompSampled      = CB_FALSE;
+  s_tempCompNumPoints    = 0;
+
+  if ((numPoints > DEF_UWB_TEMPCOMP_MAX_POINTS) || ((numPoints > 0U) && (points == NULL)))
+  {
+    return CB_FAIL;
+  }
+
+  // Insertion sort by temperature, few points
+  for (uint8_t i = 0; i < numPoints; i++)
+  {
+    uint8_t j = i;
+    while ((j > 0U) && (s_stTempCompTable[j - 1U].temperature > points[i].temperature))
+    {
+      s_stTempCompTable[j] = s_stTempCompTable[j - 1U];
+      j--;
+    }
+    if ((j > 0U) && (s_stTempCompTable[j - 1U].temperature == points[i].temperature))
+    {
+      return CB_FAIL;
+    }
+    s_stTempCompTable[j] = points[i];
+  }
+  s_tempCompNumPoints = numPoints;
+  return CB_PASS;
+}
+
+/**
+ * @brief Sample the chip temperature periodically and update the corrections.
+ *
+ * @return CB_TRUE if the corrections were updated.
+ */
+uint8_t cb_uwbtempcomp_poll(void)
+{
+  if ((s_tempCompSampled == CB_TRUE) && !cb_hal_is_time_elapsed(s_tempCompSampleTick, DEF_UWB_TEMPCOMP_PERIOD_MS))
+  {
+    return CB_FALSE;
+  }
+  s_tempCompSampleTick = cb_hal_get_tick();
+
+  float temperature = cb_system_get_chip_temperature();
+  if (s_tempCompSampled == CB_TRUE)
+  {
+    float filtered = s_stTempCompCorrection.temperature;
+    temperature = filtered + ((temperature - filtered) / (float)(1U << DEF_UWB_TEMPCOMP_FILTER_SHIFT));
+  }
+  s_tempCompSampled = CB_TRUE;
+
+  cb_uwbtempcomp_update(temperature);
+  return CB_TRUE;
+}
+
+/**
+ * @brief Update the corrections for a given temperature.
+ *
+ * @param temperature Temperature, in degrees Celsius.
+ */
+void cb_uwbtempcomp_update(float temperature)
+{
+  cb_uwbtempcomp_interpolate(temperature, &s_stTempCompCorrection);
+}
+
+/**
+ * @brief Interpolate the corrections of the table at a temperature.
+ *
+ * @param temperature Temperature, in degrees Celsius.
+ * @param result      Interpolated corrections.
+ */
+void cb_uwbtempcomp_interpolate(float temperature, cb_uwbtempcomp_point_st *result)
+{
+  memset(result, 0, sizeof(cb_uwbtempcomp_point_st));
+  result->temperature = temperature;
+
+  if (s_tempCompNumPoints == 0U)
+  {
+    return;
+  }
+
+  const cb_uwbtempcomp_point_st *lower = &s_stTempCompTable[0];
+  const cb_uwbtempcomp_point_st *upper = &s_stTempCompTable[s_tempCompNumPoints - 1U];
+  float weight = 0.0f;
+
+  if (temperature <= lower->temperature)
+  {
+    upper = lower;
+  }
+  else if (temperature >= upper->temperature)
+  {
+    lower = upper;
+  }
+  else
+  {
+    uint8_t i = 1;
+    while (s_stTempCompTable[i].temperature < temperature)
+    {
+      i++;
+    }
+    lower  = &s_stTempCompTable[i - 1U];
+    upper  = &s_stTempCompTable[i];
+    weight = (temperature - lower->temperature) / (upper->temperature - lower->temperature);
+  }
+
+  result->rangeBias_cm = lower->rangeBias_cm + (weight * (upper->rangeBias_cm - lower->rangeBias_cm));
+  for (uint8_t pair = 0; pair < (uint8_t)EN_UWB_TEMPCOMP_PD_NUM; pair++)
+  {
+    result->pdoaBias_deg[pair] = lower->pdoaBias_deg[pair] + (weight * (upper->pdoaBias_deg[pair] - lower->pdoaBias_deg[pair]));
+  }
+}
+
+/**
+ * @brief Get the current corrections.
+ *
+ * @return Corrections of the last update.
+ */
+const cb_uwbtempcomp_point_st* cb_uwbtempcomp_get_correction(void)
+{
+  return &s_stTempCompCorrection;
+}
+
+/**
+ * @brief Get the current ranging bias correction.
+ *
+ * @return Correction in cm.
+ */
+float cb_uwbtempcomp_get_range_bias_cm(void)
+{
+  return s_stTempCompCorrection.rangeBias_cm;
+}
+
+/**
+ * @brief Get the current PDoA bias correction of an antenna pair.
+ *
+ * @param enPair Antenna pair.
+ * @return Correction in degrees.
+ */
+float cb_uwbtempcomp_get_pdoa_bias_deg(cb_uwbtempcomp_pdpair_en enPair)
+{
+  return (enPair < EN_UWB_TEMPCOMP_PD_NUM) ? s_stTempCompCorrection.pdoaBias_deg[enPair] : 0.0f;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file    CB_uwbtempcomp.h
+ * @brief   Temperature-tracked ranging and PDoA bias compensation.
+ * @details The static ranging bias and PDoA biases are calibrated at one temperature and drift with
+ *          the chip and antenna temperature. This module samples cb_system_get_chip_temperature()
+ *          periodically and interpolates bias corrections from a per-device table of calibration
+ *          points (range bias and one PDoA bias per antenna pair at each temperature).
+ *          The corrections are computed when the temperature is sampled, not per packet: the result
+ *          path only adds the cached values to the distance and to the static PDoA biases.
+ *          Each device compensates its own drift: the device computing the distance adds its own
+ *          range correction and the one reported by its peer, in cm with a fractional part (the
+ *          integer dstwrRangingBias of cb_framework_uwb_calculate_distance() stays the static bias).
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_UWBTEMPCOMP_H
+#define __CB_UWBTEMPCOMP_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_Common.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DEF_UWB_TEMPCOMP_MAX_POINTS
+#define DEF_UWB_TEMPCOMP_MAX_POINTS       8       /**< Calibration points in the table */
+#endif
+#ifndef DEF_UWB_TEMPCOMP_PERIOD_MS
+#define DEF_UWB_TEMPCOMP_PERIOD_MS        1000    /**< Temperature sampling period */
+#endif
+#ifndef DEF_UWB_TEMPCOMP_FILTER_SHIFT
+#define DEF_UWB_TEMPCOMP_FILTER_SHIFT     2       /**< Temperature smoothing, weight of a new sample is 1/2^n */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+/**
+ * @brief PDoA antenna pair, same order as the biases of cb_framework_uwb_pdoa_calculate_aoa().
+ */
+typedef enum
+{
+  EN_UWB_TEMPCOMP_PD01 = 0,
+  EN_UWB_TEMPCOMP_PD02,
+  EN_UWB_TEMPCOMP_PD12,
+  EN_UWB_TEMPCOMP_PD_NUM,
+} cb_uwbtempcomp_pdpair_en;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Bias corrections at one temperature, added to the static calibration.
+ */
+typedef struct
+{
+  float temperature;                          /**< Chip temperature, in degrees Celsius */
+  float rangeBias_cm;                         /**< Added to the ranging bias */
+  float pdoaBias_deg[EN_UWB_TEMPCOMP_PD_NUM]; /**< Added to the PDoA bias of each antenna pair */
+} cb_uwbtempcomp_point_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Load the calibration table and reset the corrections to zero.
+ *
+ * Points can be given in any order; they are sorted by temperature. With no point, the corrections
+ * stay zero.
+ *
+ * @param points    Calibration points.
+ * @param numPoints Number of points, up to DEF_UWB_TEMPCOMP_MAX_POINTS.
+ * @return CB_PASS on success, CB_FAIL if there are too many points or two share a temperature.
+ */
+CB_STATUS cb_uwbtempcomp_init(const cb_uwbtempcomp_point_st *points, uint8_t numPoints);
+
+/**
+ * @brief Sample the chip temperature if DEF_UWB_TEMPCOMP_PERIOD_MS has elapsed and update the corrections.
+ *
+ * Call it outside of the ranging exchange, e.g. in the idle state of the application.
+ *
+ * @return CB_TRUE if the corrections were updated.
+ */
+uint8_t cb_uwbtempcomp_poll(void);
+
+/**
+ * @brief Update the corrections for a given temperature, without sampling the sensor.
+ *
+ * @param temperature Temperature, in degrees Celsius.
+ */
+void cb_uwbtempcomp_update(float temperature);
+
+/**
+ * @brief Interpolate the corrections of the table at a temperature.
+ *
+ * Linear between the two surrounding points, held at the first / last point outside the table.
+ *
+ * @param temperature Temperature, in degrees Celsius.
+ * @param result      Interpolated corrections.
+ */
+void cb_uwbtempcomp_interpolate(float temperature, cb_uwbtempcomp_point_st *result);
+
+/**
+ * @brief Get the current corrections.
+ *
+ * @return Corrections of the last update, temperature is the filtered chip temperature.
+ */
+const cb_uwbtempcomp_point_st* cb_uwbtempcomp_get_correction(void);
+
+/**
+ * @brief Get the current ranging bias correction.
+ *
+ * @return Correction in cm, to add to the distance.
+ */
+float cb_uwbtempcomp_get_range_bias_cm(void);
+
+/**
+ * @brief Get the current PDoA bias correction of an antenna pair.
+ *
+ * @param enPair Antenna pair.
+ * @return Correction in degrees, to add to the PDoA bias.
+ */
+float cb_uwbtempcomp_get_pdoa_bias_deg(cb_uwbtempcomp_pdpair_en enPair);
+
+#endif /*__CB_UWBTEMPCOMP_H*/
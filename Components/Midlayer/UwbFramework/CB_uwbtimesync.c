@@ -0,0 +1,385 @@
+/**
+ * @file    CB_uwbtimesync.c
+ * @brief   Wired time synchronisation of anchors from a shared GPIO sync pulse.
+ * @details Pulse capture in the UWB time base, wrap counting, clock model update and network time
+ *          translation. See CB_uwbtimesync.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "CB_uwbtimesync.h"
+#include "CB_system.h"
+#include "CB_scr.h"
+#include "NonLIB_sharedUtils.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_TIMESYNC_WRAP_NS          4294967296LL      /**< Wrap of the 32-bit UWB time */
+#define DEF_TIMESYNC_RANGE_NS         2000000000LL      /**< Translation around now, within half a wrap */
+#define DEF_TIMESYNC_PERIOD_MS        (DEF_UWB_TIMESYNC_PERIOD_NS / 1000000UL)
+
+#define DEF_TIMESYNC_LOCK(primask)    do { (primask) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define DEF_TIMESYNC_UNLOCK(primask)  __set_PRIMASK(primask)
+
+#if ((DEF_UWB_TIMESYNC_CAPTURE_NUM & (DEF_UWB_TIMESYNC_CAPTURE_NUM - 1)) != 0)
+#error "DEF_UWB_TIMESYNC_CAPTURE_NUM must be a power of 2"
+#endif
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  uint32_t localNs;             // UWB time
+  uint32_t tick;                // CPU tick, ms
+} cb_uwbtimesync_capture_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static cb_uwbclockmodel_st        s_timeSyncModel;
+static int64_t                    s_timeSyncLastLocal;      // Last capture, unwrapped: reference of the wrap count
+static uint32_t                   s_timeSyncLastTick;
+static uint8_t                    s_timeSyncHasLast;
+static uint32_t                   s_timeSyncPulseTick;      // Last capture accepted by the model
+static cb_uwbtimesync_capture_st  s_timeSyncCapture[DEF_UWB_TIMESYNC_CAPTURE_NUM];
+static volatile uint8_t           s_timeSyncCaptureHead;
+static volatile uint8_t           s_timeSyncCaptureTail;
+static uint32_t                   s_timeSyncCaptureLost;
+static cb_uwbtimesync_role_en     s_timeSyncRole;
+static cb_uwbtimesync_state_en    s_timeSyncState;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void cb_uwbtimesync_read_local(uint32_t *localNs, uint32_t *tick);
+static void cb_uwbtimesync_capture(void);
+static int64_t cb_uwbtimesync_unwrap(int64_t baseLocal, uint32_t baseTick, uint32_t localNs, uint32_t tick);
+static void cb_uwbtimesync_snapshot(cb_uwbclockmodel_st *model, int64_t *lastLocal, uint32_t *lastTick);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Read the UWB time now: timestamp of an event inserted by software, and the CPU tick.
+ */
+CB_RAM_CODE static void cb_uwbtimesync_read_local(uint32_t *localNs, uint32_t *tick)
+{
+  uint32_t primask;
+
+  DEF_TIMESYNC_LOCK(primask);
+  cb_system_uwb_enable_event_timestamp(EN_UWB_ENABLE);
+  cb_system_uwb_insert_apb_event(DEF_UWB_TIMESYNC_EVENT);
+  *localNs = cb_system_uwb_get_event_timestamp_in_ns(DEF_UWB_TIMESYNC_TIMESTAMP_MASK);
+  *tick    = cb_hal_get_tick();
+  DEF_TIMESYNC_UNLOCK(primask);
+}
+
+/**
+ * @brief Capture a sync pulse for cb_uwbtimesync_process().
+ */
+CB_RAM_CODE static void cb_uwbtimesync_capture(void)
+{
+  uint8_t  head = s_timeSyncCaptureHead;
+  uint32_t localNs;
+  uint32_t tick;
+
+  cb_uwbtimesync_read_local(&localNs, &tick);
+  if ((uint8_t)(head - s_timeSyncCaptureTail) >= DEF_UWB_TIMESYNC_CAPTURE_NUM)
+  {
+    s_timeSyncCaptureLost++;
+    return;
+  }
+  s_timeSyncCapture[head % DEF_UWB_TIMESYNC_CAPTURE_NUM].localNs = localNs;
+  s_timeSyncCapture[head % DEF_UWB_TIMESYNC_CAPTURE_NUM].tick    = tick;
+  s_timeSyncCaptureHead = head + 1U;
+}
+
+/**
+ * @brief Unwrap a 32-bit UWB time from a reference: the wraps are counted from the CPU ticks.
+ *
+ * @param baseLocal Reference, unwrapped.
+ * @param baseTick  CPU tick of the reference.
+ * @param localNs   UWB time.
+ * @param tick      CPU tick of localNs, within DEF_TIMESYNC_RANGE_NS.
+ * @return localNs unwrapped.
+ */
+static int64_t cb_uwbtimesync_unwrap(int64_t baseLocal, uint32_t baseTick, uint32_t localNs, uint32_t tick)
+{
+  int64_t delta   = (int64_t)(uint32_t)(localNs - (uint32_t)baseLocal);
+  int64_t elapsed = (int64_t)(int32_t)(tick - baseTick) * 1000000LL;
+
+  return baseLocal + delta + (DEF_TIMESYNC_WRAP_NS * (int64_t)floor((double)(elapsed - delta) / (double)DEF_TIMESYNC_WRAP_NS + 0.5));
+}
+
+/**
+ * @brief Copy of the model and the wrap reference, consistent with cb_uwbtimesync_process().
+ */
+static void cb_uwbtimesync_snapshot(cb_uwbclockmodel_st *model, int64_t *lastLocal, uint32_t *lastTick)
+{
+  uint32_t primask;
+
+  DEF_TIMESYNC_LOCK(primask);
+  *model     = s_timeSyncModel;
+  *lastLocal = s_timeSyncLastLocal;
+  *lastTick  = s_timeSyncLastTick;
+  DEF_TIMESYNC_UNLOCK(primask);
+}
+
+/**
+ * @brief Configure the sync pin and the event timestamp, and reset the clock model.
+ */
+void cb_uwbtimesync_init(cb_uwbtimesync_role_en enRole)
+{
+  stGPIO_InitTypeDef syncPin;
+
+  NVIC_DisableIRQ(GPIO_IRQn);
+  s_timeSyncRole        = enRole;
+  s_timeSyncState       = EN_UWB_TIMESYNC_UNSYNCED;
+  s_timeSyncHasLast     = CB_FALSE;
+  s_timeSyncCaptureHead = 0;
+  s_timeSyncCaptureTail = 0;
+  s_timeSyncCaptureLost = 0;
+  cb_uwbclockmodel_reset(&s_timeSyncModel, DEF_UWB_TIMESYNC_PERIOD_NS);
+
+  cb_system_uwb_configure_event_timestamp_mask(DEF_UWB_TIMESYNC_TIMESTAMP_MASK, DEF_UWB_TIMESYNC_EVENT);
+  cb_system_uwb_enable_event_timestamp(EN_UWB_ENABLE);
+
+  cb_scr_gpio_module_on();
+  cb_iomux_config(DEF_UWB_TIMESYNC_IOMUX, &(stIomuxGpioMode){EN_IOMUX_GPIO_MODE_GPIO, 0});
+  syncPin.Pin  = DEF_UWB_TIMESYNC_PIN;
+  syncPin.Mode = (enRole == EN_UWB_TIMESYNC_MASTER) ? EN_GPIO_MODE_OUTPUT : EN_GPIO_MODE_IT_RISING;
+  syncPin.Pull = EN_GPIO_NOPULL;
+  cb_gpio_init(&syncPin);
+  if (enRole == EN_UWB_TIMESYNC_MASTER)
+  {
+    cb_gpio_write_pin(DEF_UWB_TIMESYNC_PIN, EN_GPIO_PIN_RESET);
+  }
+  else
+  {
+    NVIC_SetPriority(GPIO_IRQn, 0);     // Interrupt entry latency is the capture jitter
+    NVIC_EnableIRQ(GPIO_IRQn);
+  }
+}
+
+/**
+ * @brief GPIO application IRQ callback of a slave: captures the sync pulse.
+ */
+CB_RAM_CODE void cb_uwbtimesync_gpio_irqcb(void)
+{
+  if ((s_timeSyncRole == EN_UWB_TIMESYNC_SLAVE) && (cb_gpio_is_irq_triggered(DEF_UWB_TIMESYNC_PIN) != 0U))
+  {
+    cb_uwbtimesync_capture();
+  }
+}
+
+/**
+ * @brief Master: drive a sync pulse and capture it.
+ */
+CB_RAM_CODE void cb_uwbtimesync_master_pulse(void)
+{
+  cb_gpio_write_pin(DEF_UWB_TIMESYNC_PIN, EN_GPIO_PIN_SET);
+  cb_uwbtimesync_capture();
+  cb_gpio_write_pin(DEF_UWB_TIMESYNC_PIN, EN_GPIO_PIN_RESET);
+}
+
+/**
+ * @brief Run the clock model on the captures and update the state.
+ */
+void cb_uwbtimesync_process(void)
+{
+  cb_uwbclockmodel_st model;
+  uint32_t primask;
+
+  while (s_timeSyncCaptureTail != s_timeSyncCaptureHead)
+  {
+    cb_uwbtimesync_capture_st capture = s_timeSyncCapture[s_timeSyncCaptureTail % DEF_UWB_TIMESYNC_CAPTURE_NUM];
+    int64_t localNs;
+
+    s_timeSyncCaptureTail++;
+    localNs = (s_timeSyncHasLast == CB_TRUE) ? cb_uwbtimesync_unwrap(s_timeSyncLastLocal, s_timeSyncLastTick, capture.localNs, capture.tick)
+                                             : (int64_t)capture.localNs;
+    // The fit runs on a copy: translations in IRQs see the model before or after it
+    model = s_timeSyncModel;
+    if (cb_uwbclockmodel_add_pulse(&model, localNs) != EN_UWB_CLOCKMODEL_OUTLIER)
+    {
+      s_timeSyncPulseTick = capture.tick;
+    }
+    DEF_TIMESYNC_LOCK(primask);
+    s_timeSyncModel     = model;
+    s_timeSyncLastLocal = localNs;
+    s_timeSyncLastTick  = capture.tick;
+    s_timeSyncHasLast   = CB_TRUE;
+    DEF_TIMESYNC_UNLOCK(primask);
+  }
+
+  if (s_timeSyncModel.locked == 0U)
+  {
+    s_timeSyncState = EN_UWB_TIMESYNC_UNSYNCED;
+  }
+  else if ((cb_hal_get_tick() - s_timeSyncPulseTick) > (DEF_UWB_TIMESYNC_HOLDOVER_PERIODS * DEF_TIMESYNC_PERIOD_MS))
+  {
+    s_timeSyncState = EN_UWB_TIMESYNC_HOLDOVER;
+  }
+  else
+  {
+    s_timeSyncState = EN_UWB_TIMESYNC_SYNCED;
+  }
+}
+
+/**
+ * @brief Synchronisation state.
+ */
+cb_uwbtimesync_state_en cb_uwbtimesync_get_state(void)
+{
+  return s_timeSyncState;
+}
+
+/**
+ * @brief Set the index of the last pulse.
+ */
+CB_STATUS cb_uwbtimesync_set_pulse_index(uint32_t index)
+{
+  uint32_t primask;
+
+  if (s_timeSyncModel.count == 0U)
+  {
+    return CB_FAIL;
+  }
+  DEF_TIMESYNC_LOCK(primask);
+  cb_uwbclockmodel_set_pulse_index(&s_timeSyncModel, index);
+  DEF_TIMESYNC_UNLOCK(primask);
+  return CB_PASS;
+}
+
+/**
+ * @brief Network time of a UWB time.
+ */
+CB_STATUS cb_uwbtimesync_local_to_network(uint32_t localNs, uint64_t *networkNs)
+{
+  cb_uwbclockmodel_st model;
+  int64_t  lastLocal;
+  uint32_t lastTick;
+  int64_t  network;
+
+  if (s_timeSyncState == EN_UWB_TIMESYNC_UNSYNCED)
+  {
+    return CB_FAIL;
+  }
+  cb_uwbtimesync_snapshot(&model, &lastLocal, &lastTick);
+  network = cb_uwbclockmodel_local_to_network(&model, cb_uwbtimesync_unwrap(lastLocal, lastTick, localNs, cb_hal_get_tick()));
+  if (network < 0)
+  {
+    return CB_FAIL;
+  }
+  *networkNs = (uint64_t)network;
+  return CB_PASS;
+}
+
+/**
+ * @brief UWB time of a network time.
+ */
+CB_STATUS cb_uwbtimesync_network_to_local(uint64_t networkNs, uint32_t *localNs)
+{
+  cb_uwbclockmodel_st model;
+  int64_t  lastLocal;
+  uint32_t lastTick;
+
+  if (s_timeSyncState == EN_UWB_TIMESYNC_UNSYNCED)
+  {
+    return CB_FAIL;
+  }
+  cb_uwbtimesync_snapshot(&model, &lastLocal, &lastTick);
+  *localNs = (uint32_t)cb_uwbclockmodel_network_to_local(&model, (int64_t)networkNs);
+  return CB_PASS;
+}
+
+/**
+ * @brief Current network time.
+ */
+CB_STATUS cb_uwbtimesync_now(uint64_t *networkNs)
+{
+  uint32_t localNs;
+  uint32_t tick;
+
+  cb_uwbtimesync_read_local(&localNs, &tick);
+  return cb_uwbtimesync_local_to_network(localNs, networkNs);
+}
+
+/**
+ * @brief Schedule a TX or RX start at a network time with an ABS timer.
+ */
+CB_STATUS cb_uwbtimesync_configure_scheduled_trx(const cb_uwbframework_trx_scheduledconfig_st *config, uint64_t networkNs)
+{
+  cb_uwbclockmodel_st model;
+  int64_t  lastLocal;
+  uint32_t lastTick;
+  uint32_t nowNs;
+  uint32_t nowTick;
+  int64_t  targetNs;
+  int64_t  aheadNs;
+  uint32_t timeoutUs;
+
+  if (s_timeSyncState == EN_UWB_TIMESYNC_UNSYNCED)
+  {
+    return CB_FAIL;
+  }
+  cb_uwbtimesync_read_local(&nowNs, &nowTick);
+  cb_uwbtimesync_snapshot(&model, &lastLocal, &lastTick);
+  targetNs = cb_uwbclockmodel_network_to_local(&model, (int64_t)networkNs);
+  aheadNs  = targetNs - cb_uwbtimesync_unwrap(lastLocal, lastTick, nowNs, nowTick);
+  if ((aheadNs <= 0) || (aheadNs > DEF_TIMESYNC_RANGE_NS))
+  {
+    return CB_FAIL;
+  }
+
+  // The timeout is in us: the base is moved back from now so that base + timeout is the target
+  timeoutUs = (uint32_t)((aheadNs + 999) / 1000);
+  cb_system_uwb_abs_timer_configure_timeout_value  (config->absTimer, (uint32_t)(targetNs - ((int64_t)timeoutUs * 1000)), timeoutUs);
+  cb_system_uwb_abs_timer_configure_event_commander(EN_UWB_ENABLE, config->absTimer, config->eventCtrlMask);
+  cb_system_uwb_abs_timer_clear_internal_occurence (config->absTimer);
+  cb_system_uwb_abs_timer_on                       (config->absTimer);
+  return CB_PASS;
+}
+
+/**
+ * @brief Synchronisation statistics since cb_uwbtimesync_init().
+ */
+void cb_uwbtimesync_get_stats(cb_uwbtimesync_stats_st *stats)
+{
+  cb_uwbclockmodel_st model;
+  int64_t  lastLocal;
+  uint32_t lastTick;
+
+  cb_uwbtimesync_snapshot(&model, &lastLocal, &lastTick);
+  memset(stats, 0, sizeof(cb_uwbtimesync_stats_st));
+  stats->state       = s_timeSyncState;
+  stats->captureLost = s_timeSyncCaptureLost;
+  stats->model       = model.stats;
+  if (model.count != 0U)
+  {
+    stats->driftPpm = cb_uwbclockmodel_drift_ppm(&model);
+    stats->offsetNs = model.local[model.newest] + (int64_t)model.intercept - ((int64_t)model.index[model.newest] * model.periodNs);
+  }
+  if (model.stats.jitterCount != 0U)
+  {
+    stats->jitterRmsNs = (float)sqrt(model.stats.jitterSumSq / model.stats.jitterCount);
+  }
+  if (model.stats.residualCount != 0U)
+  {
+    stats->residualRmsNs = (float)sqrt(model.stats.residualSumSq / model.stats.residualCount);
+  }
+}
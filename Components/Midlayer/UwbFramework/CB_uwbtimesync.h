@@ -0,0 +1,192 @@
+/**
+ * @file    CB_uwbtimesync.h
+ * @brief   Wired time synchronisation of anchors from a shared GPIO sync pulse.
+ * @details A sync master drives a pulse every DEF_UWB_TIMESYNC_PERIOD_NS on a line wired to the
+ *          DEF_UWB_TIMESYNC_PIN of every anchor. Each anchor captures the rising edge in its UWB
+ *          time base: the GPIO interrupt inserts DEF_UWB_TIMESYNC_EVENT, timestamped by the event
+ *          timestamp DEF_UWB_TIMESYNC_TIMESTAMP_MASK (ns, 32-bit, the time base of the ABS timers),
+ *          and the CPU tick is read with it to count the wraps of the 32-bit time between pulses.
+ *          cb_uwbtimesync_process() feeds the captures to a clock model (CB_uwbclockmodel.h):
+ *          offset and drift of the UWB time base against network time, the pulse index scaled by
+ *          the period. Network time translates to and from UWB time, for the ABS timers
+ *          scheduling TX and RX (cb_uwbtimesync_configure_scheduled_trx()).
+ *          The pulse index starts at 0 on the first capture; anchors started at different times
+ *          agree on it with cb_uwbtimesync_set_pulse_index(), e.g. from the master over the air or
+ *          a host link. Within a period, network time is common without it.
+ *          Cable delay and interrupt entry latency are a constant offset per anchor, not corrected;
+ *          their variation is the jitter of the statistics. Give the GPIO interrupt the highest
+ *          priority and register cb_uwbtimesync_gpio_irqcb() as its application callback.
+ *          cb_framework_uwb_disable_scheduled_trx() turns the event timestamps off: each capture
+ *          turns them back on.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_UWBTIMESYNC_H
+#define __CB_UWBTIMESYNC_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include "CB_Common.h"
+#include "CB_gpio.h"
+#include "CB_iomux.h"
+#include "CB_uwbframework.h"
+#include "CB_uwbclockmodel.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#ifndef DEF_UWB_TIMESYNC_PERIOD_NS
+#define DEF_UWB_TIMESYNC_PERIOD_NS        1000000000UL                    /**< Sync pulse period */
+#endif
+#ifndef DEF_UWB_TIMESYNC_PIN
+#define DEF_UWB_TIMESYNC_PIN              EN_GPIO_PIN_8                   /**< Sync pulse, input (slave) or output (master) */
+#define DEF_UWB_TIMESYNC_IOMUX            EN_IOMUX_GPIO_8
+#endif
+#ifndef DEF_UWB_TIMESYNC_TIMESTAMP_MASK
+#define DEF_UWB_TIMESYNC_TIMESTAMP_MASK   EN_UWBEVENT_TIMESTAMP_MASK_15   /**< Not used by the scheduled TRX of the examples */
+#define DEF_UWB_TIMESYNC_EVENT            EN_UWBEVENT_9_DELTA_TIMER_FULL  /**< Inserted by the capture, no timer uses it */
+#endif
+#ifndef DEF_UWB_TIMESYNC_CAPTURE_NUM
+#define DEF_UWB_TIMESYNC_CAPTURE_NUM      4                               /**< Captures waiting for cb_uwbtimesync_process() */
+#endif
+#ifndef DEF_UWB_TIMESYNC_HOLDOVER_PERIODS
+#define DEF_UWB_TIMESYNC_HOLDOVER_PERIODS 3                               /**< Periods without a pulse before holdover */
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+/**
+ * @brief Role of the anchor on the sync line.
+ */
+typedef enum
+{
+  EN_UWB_TIMESYNC_SLAVE = 0,      /**< Captures the pulse of the line */
+  EN_UWB_TIMESYNC_MASTER,         /**< Drives the pulse, cb_uwbtimesync_master_pulse(), and captures it */
+} cb_uwbtimesync_role_en;
+
+/**
+ * @brief Synchronisation state.
+ */
+typedef enum
+{
+  EN_UWB_TIMESYNC_UNSYNCED = 0,   /**< Acquiring, network time not available */
+  EN_UWB_TIMESYNC_SYNCED,         /**< Locked on the pulses */
+  EN_UWB_TIMESYNC_HOLDOVER,       /**< Locked, pulses missing: the model is extrapolated */
+} cb_uwbtimesync_state_en;
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Synchronisation statistics, cb_uwbtimesync_get_stats().
+ */
+typedef struct
+{
+  cb_uwbtimesync_state_en   state;
+  float                     driftPpm;       /**< UWB time base against network time */
+  int64_t                   offsetNs;       /**< UWB time minus network time at the last pulse, UWB time unwrapped */
+  float                     jitterRmsNs;    /**< Pulse interval minus the period estimate */
+  float                     residualRmsNs;  /**< Capture minus the model prediction */
+  uint32_t                  captureLost;    /**< Captures dropped, cb_uwbtimesync_process() not called */
+  cb_uwbclockmodel_stats_st model;          /**< Counters and maxima */
+} cb_uwbtimesync_stats_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Configure the sync pin and the event timestamp, and reset the clock model.
+ *
+ * @param enRole Slave or master of the sync line.
+ */
+void cb_uwbtimesync_init(cb_uwbtimesync_role_en enRole);
+
+/**
+ * @brief GPIO application IRQ callback of a slave: captures the sync pulse.
+ *
+ * Register with app_irq_register_irqcallback(EN_IRQENTRY_GPIO_APP_IRQ, cb_uwbtimesync_gpio_irqcb), or call
+ * it from cb_gpio_app_irq_callback() without AppSysIrqCallback.c, as uwb_periodic_tx does.
+ */
+void cb_uwbtimesync_gpio_irqcb(void);
+
+/**
+ * @brief Master: drive a sync pulse and capture it. Call every DEF_UWB_TIMESYNC_PERIOD_NS, from a timer IRQ.
+ */
+void cb_uwbtimesync_master_pulse(void);
+
+/**
+ * @brief Run the clock model on the captures and update the state. Call from the main loop or a task.
+ */
+void cb_uwbtimesync_process(void);
+
+/**
+ * @brief Synchronisation state.
+ */
+cb_uwbtimesync_state_en cb_uwbtimesync_get_state(void);
+
+/**
+ * @brief Set the index of the last pulse, to agree on network time with the other anchors.
+ *
+ * @param index Pulse index, network time index * DEF_UWB_TIMESYNC_PERIOD_NS.
+ * @return CB_PASS, CB_FAIL if no pulse was captured.
+ */
+CB_STATUS cb_uwbtimesync_set_pulse_index(uint32_t index);
+
+/**
+ * @brief Network time of a UWB time, e.g. an event timestamp.
+ *
+ * @param localNs   UWB time, within 2 s of now.
+ * @param networkNs Network time.
+ * @return CB_PASS, CB_FAIL if not synchronised.
+ */
+CB_STATUS cb_uwbtimesync_local_to_network(uint32_t localNs, uint64_t *networkNs);
+
+/**
+ * @brief UWB time of a network time.
+ *
+ * @param networkNs Network time, within 2 s of now.
+ * @param localNs   UWB time.
+ * @return CB_PASS, CB_FAIL if not synchronised.
+ */
+CB_STATUS cb_uwbtimesync_network_to_local(uint64_t networkNs, uint32_t *localNs);
+
+/**
+ * @brief Current network time, from a UWB time captured now.
+ *
+ * @param networkNs Network time.
+ * @return CB_PASS, CB_FAIL if not synchronised.
+ */
+CB_STATUS cb_uwbtimesync_now(uint64_t *networkNs);
+
+/**
+ * @brief Schedule a TX or RX start at a network time with an ABS timer.
+ *
+ * Replaces cb_framework_uwb_configure_scheduled_trx() and cb_framework_uwb_enable_scheduled_trx():
+ * the ABS timer base is taken from the sync captures, the event timestamp fields of config are not
+ * used. cb_framework_uwb_disable_scheduled_trx() stops it.
+ *
+ * @param config    ABS timer and action (absTimer, eventCtrlMask).
+ * @param networkNs Start, in the next 2 s.
+ * @return CB_PASS, CB_FAIL if not synchronised or networkNs is not in the next 2 s.
+ */
+CB_STATUS cb_uwbtimesync_configure_scheduled_trx(const cb_uwbframework_trx_scheduledconfig_st *config, uint64_t networkNs);
+
+/**
+ * @brief Synchronisation statistics since cb_uwbtimesync_init().
+ *
+ * @param stats Statistics.
+ */
+void cb_uwbtimesync_get_stats(cb_uwbtimesync_stats_st *stats);
+
+#endif /*__CB_UWBTIMESYNC_H*/
@@ -17,6 +17,7 @@
 #include "dfu_uart.h"
 #include "dfu_handler.h"
 #include "dfu_blesvc.h"
+#include "dfu_l2cap.h"
 // BLE controller
 #include "CB_ble.h"
 // BLE nimble host
@@ -293,6 +294,11 @@ void app_ble_dfu_app_init(void)
 
     rc = dfu_blesvc_gatt_svr_init();
     assert(rc == 0);
+    rc = dfu_l2cap_init();
+    if ((rc != 0) && (rc != BLE_HS_ENOTSUP))
+    {
+        LOG("[WARN] DFU L2CAP channel not available; rc = %d\n", rc);
+    }
     /* Set the default device name. */
     rc = ble_svc_gap_device_name_set(BLE_DEVICE_NAME);
     assert(rc == 0);
@@ -326,6 +332,11 @@ void app_task_uart_dfu(void *pvParameters)
     uart_cfg.responder = cmd_parser_uart_responder;
     uart_cfg.reinit = cmd_parser_uart_deinit;
     dfu_halder_init(&uart_cfg);
+    // Running and able to take the next update: keep this image after a trial boot
+    if (dfu_boot_confirm() == APP_TRUE)
+    {
+        LOG("[INFO] Firmware confirmed\n");
+    }
     
     ftm_handler_init();
     while (1)
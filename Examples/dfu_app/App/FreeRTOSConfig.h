@@ -149,6 +149,20 @@ extern uint32_t SystemCoreClock;
 #define INCLUDE_xTaskGetSchedulerState        1
 #define INCLUDE_xTaskGetCurrentTaskHandle     1
 
+/* Run time stats on the DWT cycle counter, extended to 64 bits (AppSysProfile.h).
+ * The Keil project force-includes this file (-include FreeRTOSConfig.h): FreeRTOS.h would
+ * otherwise pick the shared External/FreeRTOS/Source/include/FreeRTOSConfig.h next to it. */
+#if (defined(__ARMCC_VERSION) || defined(__GNUC__) || defined(__ICCARM__))
+#include "AppSysProfile.h"
+#endif
+#if defined(APP_PROFILE_ENABLE) && (APP_PROFILE_ENABLE == APP_TRUE)
+  #define configGENERATE_RUN_TIME_STATS             1
+  #define configRUN_TIME_COUNTER_TYPE               uint64_t
+  #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()  app_prof_init()
+  #define portGET_RUN_TIME_COUNTER_VALUE()          app_prof_cycles64()
+  #define traceTASK_INCREMENT_TICK(xTickCount)      (void)app_prof_cycles64()
+#endif
+
 /* Map the FreeRTOS port interrupt handlers to their CMSIS standard names. */
 #define xPortPendSVHandler                    PendSV_Handler
 #define vPortSVCHandler                       SVC_Handler
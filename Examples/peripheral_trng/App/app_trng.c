@@ -5,6 +5,7 @@
  *          Get an RN with hardware entropy (Noise)
  *          Get an RN with user-provided seed (Nonce)
  *          Run healthcheck on hardware entropy source (KAT)
+ *          Take nonces from the entropy pool (APP_ENTROPY_ENABLE)
  * @author Chipsbank
  * @date 2024
  */
@@ -13,6 +14,7 @@
 //-------------------------------
 #include "app_trng.h"
 #include "CB_trng.h"
+#include "AppSysEntropy.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
@@ -345,6 +347,46 @@ void app_trng_run_kat(void)
 }
 
 
+#if (APP_ENTROPY_ENABLE == APP_TRUE)
+/**
+ * @brief Take nonces from the entropy pool, refilled between the requests.
+ * @details The pool runs the KAT, seeds the TRNG and fills itself in app_entropy_init().
+ */
+void app_trng_entropy_pool(void)
+{
+    uint32_t nonce[4] = {0};
+    app_entropy_stats_t stats;
+
+    if (app_entropy_init() != APP_TRUE)
+    {
+        app_trng_print("[ERROR] Entropy pool failed to start\n\n");
+        return;
+    }
+
+    app_trng_print("entropy pool:\n");
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        if (app_entropy_get(nonce, sizeof(nonce)) == APP_TRUE)
+        {
+            app_trng_print("[app_trng] Nonce: %08x %08x %08x %08x\n", nonce[0], nonce[1], nonce[2], nonce[3]);
+        }
+        else
+        {
+            app_trng_print("[app_trng] Pool exhausted\n");
+        }
+        // Background refill: one chunk per call
+        app_entropy_process();
+    }
+
+    app_entropy_get_stats(&stats);
+    app_trng_print("[app_trng] Pool %u bytes, low %u, served %u, exhausted %u, generated %u, health failures %u/%u/%u\n\n",
+                   stats.available, stats.lowWater, stats.served, stats.exhausted, stats.generated,
+                   stats.rctFailures, stats.aptFailures, stats.dupFailures);
+
+    app_entropy_deinit();
+}
+#endif
+
 /**
  * @brief Main function for executing TRNG (True Random Number Generator) peripheral operations.
  */
@@ -367,4 +409,9 @@ void app_peripheral_trng_init(void)
     
     // Run Known Answer Test (KAT) for TRNG
     app_trng_run_kat();  
+
+#if (APP_ENTROPY_ENABLE == APP_TRUE)
+    // Take nonces from the entropy pool
+    app_trng_entropy_pool();
+#endif
 }
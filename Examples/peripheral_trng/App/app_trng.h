@@ -11,6 +11,7 @@
 // INCLUDE
 //-------------------------------
 #include "APP_common.h"
+#include "AppSysEntropy.h"
 //-------------------------------
 // DEFINE
 //-------------------------------
@@ -50,6 +51,13 @@ void app_trng_gen_with_addin(void); // seeding can be either nonce or noise
  */
 void app_trng_run_kat(void); 
 
+#if (APP_ENTROPY_ENABLE == APP_TRUE)
+/**
+ * @brief Take nonces from the entropy pool, refilled between the requests.
+ */
+void app_trng_entropy_pool(void);
+#endif
+
 /**
  * @brief Main function for executing TRNG (True Random Number Generator) peripheral operations.
  */
@@ -17,6 +17,7 @@
  *     2. Generate random numbers based on noise and print them via UART
  *     3. Generate a one-time random number without a seed and print it via UART
  *     4. Generate random numbers based on input and print them via UART
+ *     5. With APP_ENTROPY_ENABLE, take nonces from the entropy pool and print them with its statistics
  * Expected Output:
  *     1. After power-on, the UART prints a power-on reset message
  *     2. It then prints random numbers generated by the three different methods
@@ -20,12 +20,15 @@
 #include "CB_system.h"
 #include "TaskHandler.h" /**< For task flags */
 #include "CB_Uart.h"
+#include "NonLIB_sharedUtils.h"
 #include "CB_uwbframework.h"
 #include "CB_aoa.h"
 #include "AppUwbCommTrx.h"
 #include "AppUwbDstwr.h"
 #include "AppUwbPdoa.h"
 #include "AppUwbRngAoa.h"
+#include "AppUwbRadar.h"
+#include "AppSysProfile.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
@@ -54,20 +57,29 @@
 // FUNCTION PROTOTYPE SECTION
 //-------------------------------
 void processUartRxBuffer(uint8_t *buf);
+static void app_uart_commander_rx_byte(uint8_t received);
+static void app_uart_commander_rx_binary_byte(uint8_t received);
+static const app_uart_cmd_st *app_uart_commander_lookup(char command);
+static uint8_t app_uart_commander_parse_args(const app_uart_cmd_st *ptrCmd, const uint8_t *ptrArgs, uint16_t len, uint32_t *args, uint8_t *argc);
 
 //-------------------------------
 // GLOBAL VARIABLE SECTION
 //-------------------------------
-static uint8_t s_receivedByteLength;
-static uint8_t s_uartRxBuffer[256];
+static uint8_t  s_receivedByteLength;
+static uint16_t s_binaryFrameLength;
+static uint32_t s_binaryFrameTick;      // Last byte of the binary frame
+static uint8_t  s_uartRxBuffer[256];
 
-static app_uart_cmd_st commandTable[] = 
+/* Indexed by DEF_UART_CMD_HASH(command): lookup is a single table access, built at compile time. */
+static const app_uart_cmd_st commandTable[DEF_UART_CMD_HASH_SIZE] = 
 {
-    {'a', APP_UART_Func_a},  // TRX
-    {'b', APP_UART_Func_b},  // DSTWR
-    {'c', APP_UART_Func_c},  // PDOA
-    {'d', APP_UART_Func_d},  // RNGAOA
-    {'e', APP_UART_Func_e},  // unused
+    [DEF_UART_CMD_HASH('a')] = {'a', APP_UART_Func_a, 1, "u"},  // TRX
+    [DEF_UART_CMD_HASH('b')] = {'b', APP_UART_Func_b, 1, "u"},  // DSTWR
+    [DEF_UART_CMD_HASH('c')] = {'c', APP_UART_Func_c, 1, "u"},  // PDOA
+    [DEF_UART_CMD_HASH('d')] = {'d', APP_UART_Func_d, 1, "u"},  // RNGAOA
+    [DEF_UART_CMD_HASH('e')] = {'e', APP_UART_Func_e, 0, "u"},  // unused
+    [DEF_UART_CMD_HASH('g')] = {'g', APP_UART_Func_g, 1, "u"},  // RADAR
+    [DEF_UART_CMD_HASH('p')] = {'p', APP_UART_Func_p, 1, "u"},  // PROFILE
     // Add more commands and handlers as needed
 };
 extern uint8_t CB_GetCBLibMajorVersion(void);
@@ -86,8 +98,38 @@ extern uint8_t CB_GetCBLibPatchVersion(void);
  */
 void app_uart_0_rxd_ready_callback(void)
 {
-  uint8_t received = cb_uart_get_rx_byte(EN_UART_0);
-  if (received == '\b' && s_receivedByteLength > 0) 
+  app_uart_commander_rx_byte(cb_uart_get_rx_byte(EN_UART_0));
+}
+
+
+void app_uart_0_rxb_full_callback(void)
+{
+  uint8_t received;
+  cb_uart_get_rx_buffer(EN_UART_0,&received, 1);
+  app_uart_commander_rx_byte(received);
+}
+
+/**
+ * @brief Feed one received byte to the command assembler.
+ *
+ * Text commands are terminated by '\r'. A frame starting with DEF_UART_CMD_BIN_MARKER
+ * at the beginning of a command is handled as a binary command. A binary frame left
+ * incomplete for DEF_UART_CMD_BIN_TIMEOUT_MS is dropped, e.g. a stray marker byte, so
+ * that text commands are accepted again.
+ *
+ * @param received The byte received on UART.
+ */
+static void app_uart_commander_rx_byte(uint8_t received)
+{
+  if ((s_binaryFrameLength != 0) && ((uint32_t)(cb_hal_get_tick() - s_binaryFrameTick) > DEF_UART_CMD_BIN_TIMEOUT_MS))
+  {
+    s_binaryFrameLength = 0;
+  }
+  if ((s_binaryFrameLength != 0) || ((s_receivedByteLength == 0) && (received == DEF_UART_CMD_BIN_MARKER)))
+  {
+    app_uart_commander_rx_binary_byte(received);
+  }
+  else if (received == '\b' && s_receivedByteLength > 0) 
   {
     s_receivedByteLength--;    // Handle backspace: remove the last character from the buffer
   } 
@@ -98,79 +140,178 @@ void app_uart_0_rxd_ready_callback(void)
     processUartRxBuffer(s_uartRxBuffer);
     s_receivedByteLength = 0; // Reset buffer
   } 
-  else if (!isspace(received)) // Skip spaces
+  else if (!isspace(received) && (s_receivedByteLength < (sizeof(s_uartRxBuffer) - 1))) // Skip spaces
   {
     s_uartRxBuffer[s_receivedByteLength++] = received;  // Add received character to buffer
   }
 }
 
-
-void app_uart_0_rxb_full_callback(void)
+/**
+ * @brief Assemble and execute a binary command frame.
+ *
+ * @param received The byte received on UART.
+ */
+static void app_uart_commander_rx_binary_byte(uint8_t received)
 {
-  uint8_t received;
-  cb_uart_get_rx_buffer(EN_UART_0,&received, 1);
+  uint32_t args[DEF_UART_CMD_MAX_ARGS];
+  uint16_t frameLength;
+  uint8_t  argCount;
+  uint8_t  checksum = 0;
 
-  if (received == '\b' && s_receivedByteLength > 0) 
+  s_uartRxBuffer[s_binaryFrameLength++] = received;
+  s_binaryFrameTick = cb_hal_get_tick();
+  if (s_binaryFrameLength < DEF_UART_CMD_BIN_HEADER_SIZE)
   {
-      s_receivedByteLength--;    // Handle backspace: remove the last character from the buffer
-  } 
-  else if (received == '\r') 
+    return;
+  }
+
+  argCount = s_uartRxBuffer[2];
+  if (argCount > DEF_UART_CMD_MAX_ARGS)
   {
-    // End of command, parse and execute
-    s_uartRxBuffer[s_receivedByteLength] = '\0'; // Null-terminate the string
-    processUartRxBuffer(s_uartRxBuffer);
-    s_receivedByteLength = 0; // Reset buffer
-  } 
-  else if (!isspace(received)) // Skip spaces
+    s_binaryFrameLength = 0; // Invalid frame, drop
+    return;
+  }
+  frameLength = DEF_UART_CMD_BIN_HEADER_SIZE + (argCount * sizeof(uint32_t)) + 1;
+  if (s_binaryFrameLength < frameLength)
   {
-    s_uartRxBuffer[s_receivedByteLength++] = received;  // Add received character to buffer
+    return;
+  }
+  s_binaryFrameLength = 0;
+
+  for (uint16_t i = 1; i < (frameLength - 1); i++)
+  {
+    checksum += s_uartRxBuffer[i];
+  }
+  const app_uart_cmd_st *ptrCmd = app_uart_commander_lookup((char)s_uartRxBuffer[1]);
+  if ((checksum != s_uartRxBuffer[frameLength - 1]) || (ptrCmd == NULL) || (argCount < ptrCmd->minArgs))
+  {
+    return;
+  }
+
+  const uint8_t *ptrArg = &s_uartRxBuffer[DEF_UART_CMD_BIN_HEADER_SIZE];
+  for (uint8_t i = 0; i < argCount; i++, ptrArg += sizeof(uint32_t))
+  {
+    args[i] = (uint32_t)ptrArg[0] | ((uint32_t)ptrArg[1] << 8) | ((uint32_t)ptrArg[2] << 16) | ((uint32_t)ptrArg[3] << 24);
+  }
+  ptrCmd->handler(argCount, args);
+}
+
+/**
+ * @brief Find a command in the lookup table.
+ *
+ * @param command Command character.
+ * @return Pointer to the command entry, or NULL if the command is unknown.
+ */
+static const app_uart_cmd_st *app_uart_commander_lookup(char command)
+{
+  const app_uart_cmd_st *ptrCmd = &commandTable[DEF_UART_CMD_HASH(command)];
+
+  return ((ptrCmd->handler != NULL) && (ptrCmd->command == command)) ? ptrCmd : NULL;
+}
+
+/**
+ * @brief Parse the comma separated arguments of a text command.
+ *
+ * Single pass over the buffer, which is left unmodified. Each argument is converted
+ * according to the argument spec of the command.
+ *
+ * @param ptrCmd  Command entry.
+ * @param ptrArgs Argument string, starting at the first ',' (not null-terminated).
+ * @param len     Length of the argument string.
+ * @param args    Output argument array (DEF_UART_CMD_MAX_ARGS entries).
+ * @param argc    Output number of arguments.
+ * @return APP_TRUE on success, APP_FALSE on malformed arguments.
+ */
+static uint8_t app_uart_commander_parse_args(const app_uart_cmd_st *ptrCmd, const uint8_t *ptrArgs, uint16_t len, uint32_t *args, uint8_t *argc)
+{
+  const char *spec = (ptrCmd->argSpec != NULL) ? ptrCmd->argSpec : "u";
+  uint8_t  count   = 0;
+  uint16_t pos     = 0;
+
+  while (pos < len)
+  {
+    if ((ptrArgs[pos++] != ',') || (count >= DEF_UART_CMD_MAX_ARGS))
+    {
+      return APP_FALSE;
+    }
+
+    char     type     = *spec;
+    uint32_t value    = 0;
+    uint8_t  negative = APP_FALSE;
+    uint16_t digitPos;
+
+    if (spec[1] != '\0')
+    {
+      spec++; // Last type repeats
+    }
+    if ((type == 'i') && (pos < len) && (ptrArgs[pos] == '-'))
+    {
+      negative = APP_TRUE;
+      pos++;
+    }
+    if ((type == 'x') && ((pos + 1) < len) && (ptrArgs[pos] == '0') && ((ptrArgs[pos + 1] | 0x20) == 'x'))
+    {
+      pos += 2;
+    }
+    digitPos = pos;
+    while ((pos < len) && (ptrArgs[pos] != ','))
+    {
+      uint8_t c = ptrArgs[pos];
+      if (isdigit(c))
+      {
+        value = (type == 'x') ? ((value << 4) | (uint32_t)(c - '0')) : ((value * 10) + (uint32_t)(c - '0'));
+      }
+      else if ((type == 'x') && isxdigit(c))
+      {
+        value = (value << 4) | (uint32_t)((c | 0x20) - 'a' + 10);
+      }
+      else
+      {
+        return APP_FALSE;
+      }
+      pos++;
+    }
+    if (pos == digitPos)
+    {
+      return APP_FALSE; // Empty argument
+    }
+    args[count++] = (negative == APP_TRUE) ? (uint32_t)(-(int32_t)value) : value;
   }
+  *argc = count;
+  return APP_TRUE;
 }
 
 /**
  * @brief Process UART receive buffer.
  * 
- * This function processes the UART receive buffer by separating the command
- * and arguments, converting argument strings to integers, and then executing
+ * This function looks the command up in the hashed command table, parses its
+ * arguments according to the command argument spec, and then executes
  * the corresponding command handler function.
  * 
- * @param ptrUartRxBuffer Pointer to the UART receive buffer.
+ * @param ptrUartRxBuffer Pointer to the UART receive buffer (null-terminated).
  */
 void processUartRxBuffer(uint8_t *ptrUartRxBuffer)
 {
-  char *command;
-  uint32_t args[16]; // reduce number of args to 10
-  uint32_t *argPtr;
-  uint8_t argCount = 0;
-  
-  // Separate command and arguments using strtok
-  char *token = strtok((char*)ptrUartRxBuffer, ",");
-  if (token != NULL) 
+  uint32_t args[DEF_UART_CMD_MAX_ARGS];
+  uint8_t  argCount = 0;
+  uint16_t len      = (uint16_t)strlen((const char *)ptrUartRxBuffer);
+
+  if (len > 0)
   {
-    command = token; // Extract the first character as the command
-    argPtr = args;
-    while ((token = strtok(NULL, ",")) != NULL && argCount < sizeof(args)/sizeof(args[0]))
-    {
-      int argInt = atoi(token);     // Convert argument string to int
-      *argPtr++ = (uint32_t)argInt; // Convert int to uint32_t and store in args
-      argCount++;
-    }
-    
-    static uint32_t commandTblSize = sizeof(commandTable) / sizeof(commandTable[0]);
-    commandTblSize = sizeof(commandTable) / sizeof(commandTable[0]);
-    // Find command in the lookup table
-    for (uint8_t i = 0; i < commandTblSize; i++) 
+    const app_uart_cmd_st *ptrCmd = app_uart_commander_lookup((char)ptrUartRxBuffer[0]);
+    if (ptrCmd != NULL)
     {
-      if (commandTable[i].command == *command) 
+      if ((app_uart_commander_parse_args(ptrCmd, &ptrUartRxBuffer[1], len - 1, args, &argCount) == APP_TRUE) && (argCount >= ptrCmd->minArgs))
       {
         APP_SYS_UARTCOMMANDER_PRINT("\n");
-        commandTable[i].handler(argCount, args);
-        break;
+        ptrCmd->handler(argCount, args);
       }
-    }    
+      else
+      {
+        APP_SYS_UARTCOMMANDER_PRINT("\ninvalid arguments");
+      }
+    }
   }
-  memset(s_uartRxBuffer, 0, sizeof(s_uartRxBuffer));
-  memset(args,0,sizeof(args));
   APP_SYS_UARTCOMMANDER_PRINT("\n>");
 }
 
@@ -388,6 +529,71 @@ void APP_UART_Func_e(uint32_t const argc, uint32_t *args)
     /* usage: unused  */  
 }
 
+/**
+ * @brief Handles UART command processing for radar presence / vital-sign detection.
+ *
+ * @param[in] argc The number of arguments passed to the function. Must be 1.
+ * @param[in] args A pointer to the array of arguments:
+ *                 - args[0]: Radar operation mode:
+ *                   - `0`: Suspend
+ *                   - `1`: Presence and vital-sign detection
+ */
+void APP_UART_Func_g(uint32_t const argc, uint32_t *args)
+{
+  /* usage: g,arg1
+  (arg1) Mode     0: SUSPEND
+                  1: PRESENCE
+                  2: FFT BENCHMARK (float vs Q15)
+  */
+  #define RADAR_OPERATION_MODE_Suspend       0
+  #define RADAR_OPERATION_MODE_Presence      1
+  #define RADAR_OPERATION_MODE_FftBenchmark  2
+
+  uint8_t radarOperationMode = (uint8_t)(*(args + 0));
+  switch (radarOperationMode)
+  {
+    case RADAR_OPERATION_MODE_Suspend:
+    {
+      app_radar_suspend();
+    }
+    break;
+    case RADAR_OPERATION_MODE_Presence:
+    {
+      g_task_g_execute = APP_TRUE;
+    }
+    break;
+    case RADAR_OPERATION_MODE_FftBenchmark:
+    {
+      app_radar_fft_benchmark();
+    }
+    break;
+    default:
+    break;
+  }
+}
+
+/**
+ * @brief Handles UART command processing for the CPU profile.
+ *
+ * @param[in] argc The number of arguments passed to the function. Must be 1.
+ * @param[in] args A pointer to the array of arguments:
+ *                 - args[0]: After the print:
+ *                   - `0`: Keep counting
+ *                   - `1`: Start a new window
+ */
+void APP_UART_Func_p(uint32_t const argc, uint32_t *args)
+{
+  /* usage: p,arg1
+  (arg1) 0: PRINT
+         1: PRINT AND RESET
+  */
+#if (APP_PROFILE_ENABLE == APP_TRUE)
+  app_prof_dump((*(args + 0) == 1) ? APP_TRUE : APP_FALSE);
+#else
+  APP_SYS_UARTCOMMANDER_PRINT("profiling not built, see APP_PROFILE_ENABLE\n");
+#endif
+}
+
 /**
  * @brief   Prints the version of the CB Library.
  * 
@@ -19,6 +19,18 @@
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
+#define DEF_UART_CMD_MAX_ARGS         16    /**< Maximum number of arguments per command */
+#define DEF_UART_CMD_HASH_SIZE        32    /**< Command lookup table size (power of 2) */
+#define DEF_UART_CMD_HASH(cmd)        ((uint8_t)(cmd) & (DEF_UART_CMD_HASH_SIZE - 1)) /**< Collision-free for 'a'..'z' */
+
+/**
+ * Binary fast-path frame, shares the handlers of the text commands:
+ * | 0xA5 | command | argc | argc x uint32 (little endian) | checksum |
+ * checksum = 8-bit sum of command, argc and argument bytes.
+ */
+#define DEF_UART_CMD_BIN_MARKER       0xA5
+#define DEF_UART_CMD_BIN_HEADER_SIZE  3
+#define DEF_UART_CMD_BIN_TIMEOUT_MS   20    /**< Gap ending an incomplete binary frame, back to text commands */
 
 
 //-------------------------------
@@ -30,9 +42,17 @@
 //-------------------------------
 typedef void (*ptrFunction)(uint32_t const argc, uint32_t  *args);
 
+/**
+ * @brief Command table entry.
+ *
+ * argSpec lists the type of each argument, the last type applies to any further argument:
+ * 'u' unsigned decimal, 'i' signed decimal (stored as two's complement), 'x' hexadecimal.
+ */
 typedef struct {
     char command;
     ptrFunction handler;
+    uint8_t minArgs;
+    const char *argSpec;
 } app_uart_cmd_st;
 
 //-------------------------------
@@ -208,6 +228,13 @@ void APP_UART_Func_h(uint32_t const argc, uint32_t  *args);
  */
 void APP_UART_Func_i(uint32_t const argc, uint32_t  *args);
 
+/**
+ * @brief CPU profile Command parser: prints the task, interrupt and region times.
+ * 
+ * @param args Pointer to the array of arguments.
+ */
+void APP_UART_Func_p(uint32_t const argc, uint32_t  *args);
+
 /**
  * @brief Configures the UWB system parameters via UART command.
  * 
@@ -483,6 +483,11 @@ void app_dstwr_initiator(void)
           if (rxStatus.rx0_ok == CB_TRUE)
           {  
             uint16_t rxPayloadSize = cb_framework_uwb_get_rx_packet_size(&s_stUwbPacketConfig);
+            // Limited to the container: responders may append fields, e.g. their temperature correction
+            if (rxPayloadSize > sizeof(s_stIniResponderDataContainer))
+            {
+              rxPayloadSize = sizeof(s_stIniResponderDataContainer);
+            }
             cb_framework_uwb_get_rx_payload                          ((uint8_t*)(&s_stIniResponderDataContainer), rxPayloadSize);
             cb_framework_uwb_calculate_initiator_tround_treply        (&s_stInitiatorDataContainer, s_stIniTxTsuTimestamp0, s_stIniTxTsuTimestamp1, s_stIniRxTsuTimestamp0);
             s_measuredDistance = cb_framework_uwb_calculate_distance  (s_stInitiatorDataContainer, s_stIniResponderDataContainer);
@@ -17,6 +17,7 @@
 #include "CB_timer.h"
 #include "CB_scr.h"
 #include "NonLIB_sharedUtils.h"
+#include "AppSysProfile.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
@@ -59,6 +60,10 @@ typedef enum{
 
 // PDOA Mode Configuration:
 #define APP_PDOA_HIGH_ACCURACY_MODE   APP_FALSE // PDOA High Accuracy Mode: End then restart for better accuracy
+#define APP_PDOA_CIR_SNAPSHOT_DMA     APP_FALSE // CIR snapshot by DMA: copy CIR in background while next RX is re-armed (CIR address not verified on hardware)
+#define APP_PDOA_REARM_GAP_TRACE      APP_FALSE // Print RX re-arm gap (SFD handled -> next RX armed) per packet
+#define APP_PDOA_INCREMENTAL_PROCESS  APP_TRUE  // Per-packet PDoA processing in the gap before next RX, only reduction after last packet
+#define APP_PDOA_PROCESS_TIME_TRACE   APP_FALSE // Print per-packet processing time and last PDoA RX -> result latency
 
 typedef enum{
   // IDLE STATE
@@ -164,6 +169,13 @@ static float s_pd02Bias                                           = DEF_PDOA_PD0
 static float s_pd12Bias                                           = DEF_PDOA_PD12_BIAS;
 static float s_aziResult                                          = 0.0f;
 static float s_eleResult                                          = 0.0f;
+#if (APP_PDOA_REARM_GAP_TRACE == APP_TRUE)
+static uint32_t s_rearmGapCycles[DEF_PDOA_NUMPKT_SUPERFRAME_MAX]  = {0};
+#endif
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+static uint32_t s_pdoaProcessCycles[DEF_PDOA_NUMPKT_SUPERFRAME_MAX] = {0};
+static uint32_t s_lastPdoaRxCycle                                 = 0;
+#endif
 
 //-------------------------------
 // PDOA: RESPONDER SETUP
@@ -426,6 +438,10 @@ void app_pdoa_responder(void)
   stPdoaRxIrqEnable.rx2SfdDetDone = CB_TRUE;  
   
   app_uwb_pdoa_register_irqcallbacks();
+#if (APP_PDOA_CIR_SNAPSHOT_DMA == APP_TRUE)
+  cb_framework_uwb_pdoa_cir_snapshot_init(EN_UWB_RX_ALL);
+  app_irq_register_irqcallback(EN_IRQENTRY_DMA_CHANNEL_2_APP_IRQ, cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback);
+#endif
   s_pdoaRunningFlag = APP_TRUE;
   
   s_enAppPdoaResponderState = EN_APP_RESP_STATE_SYNC_RECEIVE;
@@ -520,8 +536,15 @@ void app_pdoa_responder(void)
           s_stIrqStatus.Rx0SfdDetected = APP_FALSE; 
           s_stIrqStatus.Rx1SfdDetected = APP_FALSE; 
           s_stIrqStatus.Rx2SfdDetected = APP_FALSE;
+#if (APP_PDOA_REARM_GAP_TRACE == APP_TRUE)
+          uint32_t rearmStartCycle = DWT->CYCCNT;
+#endif
           
+#if (APP_PDOA_CIR_SNAPSHOT_DMA == APP_TRUE)
+          cb_framework_uwb_pdoa_cir_snapshot_start(s_countOfPdoaScheduledRx);
+#else
           cb_framework_uwb_pdoa_store_cir_data(s_countOfPdoaScheduledRx);          
+#endif
 
           s_countOfPdoaScheduledRx++;
           if (s_countOfPdoaScheduledRx < DEF_NUMBER_OF_PDOA_REPEATED_RX)
@@ -531,10 +554,26 @@ void app_pdoa_responder(void)
             cb_framework_uwb_rx_start(EN_UWB_RX_ALL, &s_stUwbPacketConfig, &stPdoaRxIrqEnable, EN_TRX_START_NON_DEFERRED);
 #else
             cb_framework_uwb_rx_restart(EN_UWB_RX_ALL, &s_stUwbPacketConfig, &stPdoaRxIrqEnable, EN_TRX_START_NON_DEFERRED);
+#endif
+#if (APP_PDOA_REARM_GAP_TRACE == APP_TRUE)
+            s_rearmGapCycles[s_countOfPdoaScheduledRx - 1] = DWT->CYCCNT - rearmStartCycle;
+#endif
+#if (APP_PDOA_INCREMENTAL_PROCESS == APP_TRUE)
+            // Process this packet while the next one is being received
+  #if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            uint32_t processStartCycle = DWT->CYCCNT;
+  #endif
+            cb_framework_uwb_pdoa_process_packet(EN_PDOA_3D_CALTYPE, s_countOfPdoaScheduledRx - 1);
+  #if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            s_pdoaProcessCycles[s_countOfPdoaScheduledRx - 1] = DWT->CYCCNT - processStartCycle;
+  #endif
 #endif
           }
           else 
           {
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            s_lastPdoaRxCycle = DWT->CYCCNT;
+#endif
             cb_framework_uwb_rx_end(EN_UWB_RX_ALL);
             cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_RESET, NULL);
             s_countOfPdoaScheduledRx = 0;
@@ -544,16 +583,48 @@ void app_pdoa_responder(void)
         break;
         
       case EN_APP_RESP_STATE_PDOA_POSTINGPROCESSING:
+      {
         // PDOA
+#if (APP_PDOA_CIR_SNAPSHOT_DMA == APP_TRUE)
+        if (cb_framework_uwb_pdoa_cir_snapshot_wait(DEF_NUMBER_OF_PDOA_REPEATED_RX) != CB_TRUE)
+        {
+          app_uwb_pdoa_print("PDOA CIR snapshot incomplete\n");
+        }
+#endif
+#if (APP_PDOA_REARM_GAP_TRACE == APP_TRUE)
+        for (uint8_t i = 0; i < (DEF_NUMBER_OF_PDOA_REPEATED_RX - 1); i++)
+        {
+          app_uwb_pdoa_print("RX re-arm gap[%d]: %u cycles, %u us\n", i, s_rearmGapCycles[i], s_rearmGapCycles[i] / (SystemCoreClock / 1000000U));
+        }
+#endif
+        APP_PROF_REGION_BEGIN(pdoa_result);
+#if (APP_PDOA_INCREMENTAL_PROCESS == APP_TRUE)
+        cb_framework_uwb_pdoa_calculate_result_incremental(&s_stPdoaOutputResult, EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);
+#else
         cb_framework_uwb_pdoa_calculate_result(&s_stPdoaOutputResult,EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);
+#endif
+        APP_PROF_REGION_END(pdoa_result);
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+        uint32_t resultLatencyCycles = DWT->CYCCNT - s_lastPdoaRxCycle;
+#endif
         app_uwb_pdoa_print("PD01:%f, PD02:%f, PD12:%f (in degrees)\n",s_stPdoaOutputResult.median.rx0_rx1,s_stPdoaOutputResult.median.rx0_rx2,s_stPdoaOutputResult.median.rx1_rx2);          
         
         // AOA
+        APP_PROF_REGION_BEGIN(pdoa_aoa);
         cb_framework_uwb_pdoa_calculate_aoa(s_stPdoaOutputResult.median, s_pd01Bias, s_pd02Bias, s_pd12Bias, &s_aziResult, &s_eleResult);
+        APP_PROF_REGION_END(pdoa_aoa);
         app_uwb_pdoa_print("azimuth: %f degrees\nelevation: %f degrees\n", (double)s_aziResult,(double)s_eleResult);    
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+        for (uint8_t i = 0; i < (DEF_NUMBER_OF_PDOA_REPEATED_RX - 1); i++)
+        {
+          app_uwb_pdoa_print("PDOA process[%d] (overlapped with RX): %u us\n", i, s_pdoaProcessCycles[i] / (SystemCoreClock / 1000000U));
+        }
+        app_uwb_pdoa_print("Last PDOA RX -> PDOA result: %u us\n", resultLatencyCycles / (SystemCoreClock / 1000000U));
+#endif
         
         s_enAppPdoaResponderState = EN_APP_RESP_STATE_TERMINATE;
         break;
+      }
       case EN_APP_RESP_STATE_TERMINATE:
         app_pdoa_timer_off();
         iterationTime = cb_hal_get_tick();
@@ -565,6 +636,10 @@ void app_pdoa_responder(void)
     }
   }
   app_uwb_pdoa_deregister_irqcallbacks();
+#if (APP_PDOA_CIR_SNAPSHOT_DMA == APP_TRUE)
+  app_irq_deregister_irqcallback(EN_IRQENTRY_DMA_CHANNEL_2_APP_IRQ, cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback);
+  cb_framework_uwb_pdoa_cir_snapshot_deinit();
+#endif
   app_pdoa_timer_off();
   app_pdoa_reset();
   cb_framework_uwb_off();
@@ -573,6 +648,7 @@ void app_pdoa_responder(void)
 void app_pdoa_reset(void)
 {
   cb_framework_uwb_pdoa_reset_cir_data_container();
+  cb_framework_uwb_pdoa_incremental_reset();
   memset(&s_stIrqStatus, APP_FALSE, sizeof(s_stIrqStatus));
   s_applicationTimeout       = APP_FALSE;
   s_countOfPdoaScheduledRx   = 0;
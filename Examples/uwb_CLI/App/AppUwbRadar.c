@@ -0,0 +1,170 @@
+/**
+ * @file    AppUwbRadar.c
+ * @brief   [UWB] Radar Presence and Vital-Sign Feature Module
+ * @details One radar CIR burst is taken every frame period; the radar is stopped and the CPU sleeps
+ *          in between. Frames are processed by CB_radar_vitals, only events are printed.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "AppUwbRadar.h"
+#include "CB_uwbframework.h"
+#include "CB_system.h"
+#include "CB_radar_vitals.h"
+#include "CB_radar.h"
+#include "NonLIB_sharedUtils.h"
+
+//-------------------------------
+// CONFIGURATION SECTION
+//-------------------------------
+#define APP_UWB_RADAR_UARTPRINT_ENABLE APP_TRUE
+#if (APP_UWB_RADAR_UARTPRINT_ENABLE == APP_TRUE)
+  #include "app_uart.h"
+  #define app_uwb_radar_print(...) app_uart_printf(__VA_ARGS__)
+#else
+  #define app_uwb_radar_print(...)
+#endif
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_RADAR_FRAME_PERIOD_MS   50    // 20 Hz slow time, above twice the heart band
+#define DEF_RADAR_PA_CODE           31    // Radar TX power (0-31)
+#define DEF_RADAR_SCALE_BIT         4     // Radar signal scaling (0-7)
+#define DEF_RADAR_GAIN_IDX          4     // Radar RX gain index (0-7)
+#define DEF_RADAR_SETTLE_US         200   // Radar start to CIR readout
+#define DEF_RADAR_FIRST_RANGE_BIN   4     // Skip TX leakage
+#define DEF_RADAR_RX_PORT           EN_UWB_RX_0
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static volatile uint8_t s_radarRunningFlag = APP_FALSE;
+static cb_uwbsystem_rx_cir_iqdata_st s_radarCir[DEF_RADAR_FIRST_RANGE_BIN + DEF_RADAR_MAX_RANGE_BINS];
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+static void app_radar_event_callback(const cb_radar_vitals_event_st *event);
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief   Radar presence and vital-sign detection.
+ * @details Runs until app_radar_suspend() is called.
+ */
+void app_radar_presence(void)
+{
+  cb_radar_vitals_config_st stVitalsConfig;
+
+  cb_radar_vitals_default_config(&stVitalsConfig, 1000.0f / DEF_RADAR_FRAME_PERIOD_MS);
+  stVitalsConfig.firstRangeBin = DEF_RADAR_FIRST_RANGE_BIN;
+  if (cb_radar_vitals_init(&stVitalsConfig, app_radar_event_callback) != CB_PASS)
+  {
+    app_uwb_radar_print("radar config error\n");
+    return;
+  }
+
+  cb_framework_uwb_init();
+  cb_framework_radar_config(DEF_RADAR_PA_CODE, DEF_RADAR_SCALE_BIT);
+
+  s_radarRunningFlag = APP_TRUE;
+  uint32_t nextFrameTick = cb_hal_get_tick();
+
+  while (s_radarRunningFlag == APP_TRUE)
+  {
+    //--------------------------------
+    // One burst per frame
+    //--------------------------------
+    cb_framework_radar_start(DEF_RADAR_GAIN_IDX);
+    cb_system_delay_in_us(DEF_RADAR_SETTLE_US);
+    cb_framework_radar_getcir(s_radarCir, DEF_RADAR_RX_PORT, DEF_RADAR_FIRST_RANGE_BIN + stVitalsConfig.numRangeBins);
+    cb_framework_radar_stop();
+
+    cb_radar_vitals_process_frame(s_radarCir);
+
+    //--------------------------------
+    // Sleep until the next frame, SysTick wakes the core every ms
+    //--------------------------------
+    nextFrameTick += DEF_RADAR_FRAME_PERIOD_MS;
+    while (((int32_t)(cb_hal_get_tick() - nextFrameTick) < 0) && (s_radarRunningFlag == APP_TRUE))
+    {
+      __WFI();
+    }
+  }
+
+  cb_framework_radar_off();
+  app_uwb_radar_print("radar stopped\n");
+}
+
+void app_radar_suspend(void)
+{
+  s_radarRunningFlag = APP_FALSE;
+}
+
+/**
+ * @brief   Float vs Q15 Doppler FFT benchmark.
+ * @details Prints cycles, working buffer size and dynamic range for each FFT length, 16 to 4096 points.
+ *          The Q15 columns are 0 above DEF_RADAR_Q15_FFT_MAX_LEN.
+ */
+void app_radar_fft_benchmark(void)
+{
+#if (DEF_RADAR_DOPPLER_ENABLE == CB_TRUE) && (DEF_RADAR_FFT_BENCHMARK_ENABLE == CB_TRUE)
+  cb_radar_fft_benchmark_st stResults[EN_FFT_LEN4096 + 1];
+  uint8_t numResults = cb_radar_fft_benchmark(stResults, sizeof(stResults) / sizeof(stResults[0]));
+
+  app_uwb_radar_print("len  float_cyc  q15_cyc  float_B  q15_B  float_dB  q15_dB\n");
+  for (uint8_t i = 0; i < numResults; i++)
+  {
+    app_uwb_radar_print("%4d  %9d  %7d  %7d  %5d  %8d  %6d\n", stResults[i].fftLen, stResults[i].floatCycles,
+                        stResults[i].q15Cycles, stResults[i].floatBufferBytes, stResults[i].q15BufferBytes,
+                        (int)stResults[i].floatDynamicRange_dB, (int)stResults[i].q15DynamicRange_dB);
+  }
+#else
+  app_uwb_radar_print("radar FFT benchmark disabled\n");
+#endif
+}
+
+/**
+ * @brief Prints the radar events.
+ *
+ * @param event Event data.
+ */
+static void app_radar_event_callback(const cb_radar_vitals_event_st *event)
+{
+  switch (event->event)
+  {
+    case EN_RADAR_VITALS_EVENT_PRESENCE_ENTER:
+      app_uwb_radar_print("[RADAR] presence: range %d cm\n", (int)(event->range_m * 100.0f));
+      break;
+    case EN_RADAR_VITALS_EVENT_PRESENCE_EXIT:
+      app_uwb_radar_print("[RADAR] empty\n");
+      break;
+    case EN_RADAR_VITALS_EVENT_MOTION_START:
+      app_uwb_radar_print("[RADAR] motion\n");
+      break;
+    case EN_RADAR_VITALS_EVENT_MOTION_STOP:
+      app_uwb_radar_print("[RADAR] still\n");
+      break;
+    case EN_RADAR_VITALS_EVENT_VITALS:
+      app_uwb_radar_print("[RADAR] breath %d bpm (%d.%02d mm), heart %d bpm\n", (int)(event->breathRate_bpm + 0.5f),
+                          (int)event->breathAmplitude_mm, (int)(event->breathAmplitude_mm * 100.0f) % 100,
+                          (int)(event->heartRate_bpm + 0.5f));
+      break;
+    default:
+      break;
+  }
+}
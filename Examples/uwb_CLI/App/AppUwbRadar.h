@@ -0,0 +1,41 @@
+/**
+ * @file    AppUwbRadar.h
+ * @brief   [UWB] Radar Presence and Vital-Sign Feature Module
+ * @details This module runs the UWB radar at a low duty cycle and reports presence, motion,
+ *          breathing and heart rate events.
+ * @author  Chipsbank
+ * @date    2024
+ */
+
+#ifndef __APP_UWB_RADAR_H
+#define __APP_UWB_RADAR_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+void app_radar_presence(void);
+void app_radar_suspend(void);
+void app_radar_fft_benchmark(void);
+
+#endif // __APP_UWB_RADAR_H
@@ -51,6 +51,8 @@
 
 // PDOA Mode Configuration:
 #define APP_PDOA_HIGH_ACCURACY_MODE   APP_FALSE // PDOA High Accuracy Mode: End then restart for better accuracy
+#define APP_PDOA_INCREMENTAL_PROCESS  APP_TRUE  // Per-packet PDoA processing in the gap before next RX, only reduction after last packet
+#define APP_PDOA_PROCESS_TIME_TRACE   APP_FALSE // Log per-packet processing time and last PDoA RX -> result latency
 
 //-------------------------------
 // ENUM SECTION
@@ -250,6 +252,11 @@ static float                              s_pd02Bias                  = DEF_PDOA
 static float                              s_pd12Bias                  = DEF_PDOA_PD12_BIAS;
 static float                              s_aziResult                 = 0.0f;
 static float                              s_eleResult                 = 0.0f;
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+static uint32_t                           s_pdoaProcessCycles[DEF_PDOA_NUMPKT_SUPERFRAME_MAX] = {0};
+static uint32_t                           s_lastPdoaRxCycle          = 0;
+static uint32_t                           s_pdoaResultLatencyCycles  = 0;
+#endif
 
 app_rngaoa_responderdatacontainer_st s_stRespResponderDataContainer = {
   .rangingDataContainer = { .dstwrRangingBias   = DEF_RESPONDER_RANGING_BIAS,
@@ -599,6 +606,11 @@ void app_rngaoa_initiator(void)
           if (rxStatus.rx0_ok == CB_TRUE)
           {  
             uint16_t rxPayloadSize = cb_framework_uwb_get_rx_packet_size(&s_stUwbPacketConfig);
+            // Limited to the container: responders may append fields, e.g. their temperature correction
+            if (rxPayloadSize > sizeof(s_stIniResponderDataContainer))
+            {
+              rxPayloadSize = sizeof(s_stIniResponderDataContainer);
+            }
             cb_framework_uwb_get_rx_payload                           ((uint8_t*)(&s_stIniResponderDataContainer), rxPayloadSize);
             cb_framework_uwb_calculate_initiator_tround_treply        (&s_stInitiatorDataContainer, s_stIniTxTsuTimestamp0, s_stIniTxTsuTimestamp1, s_stIniRxTsuTimestamp0);
             s_measuredDistance = cb_framework_uwb_calculate_distance  (s_stInitiatorDataContainer, s_stIniResponderDataContainer.rangingDataContainer);
@@ -932,10 +944,23 @@ void app_rngaoa_responder(void)
             cb_framework_uwb_rx_start(EN_UWB_RX_ALL, &s_stUwbPacketConfig, &stPdoaRxIrqEnable, EN_TRX_START_NON_DEFERRED);
 #else
             cb_framework_uwb_rx_restart(EN_UWB_RX_ALL, &s_stUwbPacketConfig, &stPdoaRxIrqEnable, EN_TRX_START_NON_DEFERRED);
+#endif
+#if (APP_PDOA_INCREMENTAL_PROCESS == APP_TRUE)
+            // Process this packet while the next one is being received
+  #if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            uint32_t processStartCycle = DWT->CYCCNT;
+  #endif
+            cb_framework_uwb_pdoa_process_packet(EN_PDOA_3D_CALTYPE, s_countOfPdoaScheduledRx - 1);
+  #if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            s_pdoaProcessCycles[s_countOfPdoaScheduledRx - 1] = DWT->CYCCNT - processStartCycle;
+  #endif
 #endif
           }
           else 
           {
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            s_lastPdoaRxCycle = DWT->CYCCNT;
+#endif
             cb_framework_uwb_rx_end(EN_UWB_RX_ALL);    
             s_countOfPdoaScheduledRx = 0;
             cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_RESET, NULL);
@@ -947,9 +972,16 @@ void app_rngaoa_responder(void)
       case EN_APP_RESP_STATE_PDOA_POSTINGPROCESSING:
       {
         // PDOA
+#if (APP_PDOA_INCREMENTAL_PROCESS == APP_TRUE)
+        cb_framework_uwb_pdoa_calculate_result_incremental(&s_stPdoaOutputResult, EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);
+#else
         cb_framework_uwb_pdoa_calculate_result(&s_stPdoaOutputResult,EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);        
+#endif
         // AOA
         cb_framework_uwb_pdoa_calculate_aoa(s_stPdoaOutputResult.median, s_pd01Bias, s_pd02Bias, s_pd12Bias, &s_aziResult, &s_eleResult);
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+        s_pdoaResultLatencyCycles = DWT->CYCCNT - s_lastPdoaRxCycle;
+#endif
         
         appRngaoaResponderState = EN_APP_RESP_STATE_RESULT_TRANSMIT;
         startTime = cb_hal_get_tick();
@@ -1060,6 +1092,7 @@ void app_rngaoa_responder_reset(void)
   s_eleResult = 0.0f;
   memset(&s_stPdoaOutputResult, 0, sizeof(s_stPdoaOutputResult));
   cb_framework_uwb_pdoa_reset_cir_data_container();
+  cb_framework_uwb_pdoa_incremental_reset();
   cb_framework_uwb_tsu_clear();
   cb_framework_uwb_tx_end();            // ensure propoer TX end upon abnormal condition
   cb_framework_uwb_rx_end(EN_UWB_RX_0); // ensure propoer RX end upon abnormal condition
@@ -1340,6 +1373,13 @@ void app_rngaoa_responder_log(void)
     /*Printout*/
     app_uwb_rngaoa_print("PD01:%f, PD02:%f, PD12:%f (in degrees),",s_stPdoaOutputResult.median.rx0_rx1,s_stPdoaOutputResult.median.rx0_rx2,s_stPdoaOutputResult.median.rx1_rx2);          
     app_uwb_rngaoa_print("azimuth: %f degrees,elevation: %f degrees\n", (double)s_aziResult,(double)s_eleResult);      
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+    for (uint8_t i = 0; i < (DEF_NUMBER_OF_PDOA_REPEATED_RX - 1); i++)
+    {
+      app_uwb_rngaoa_print("PDOA process[%d] (overlapped with RX): %u us\n", i, s_pdoaProcessCycles[i] / (SystemCoreClock / 1000000U));
+    }
+    app_uwb_rngaoa_print("Last PDOA RX -> PDOA result: %u us\n", s_pdoaResultLatencyCycles / (SystemCoreClock / 1000000U));
+#endif
   }
   else
   {
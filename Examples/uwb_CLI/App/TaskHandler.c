@@ -16,6 +16,7 @@
 #include "AppUwbDstwr.h"
 #include "AppUwbPdoa.h"
 #include "AppUwbRngAoa.h"
+#include "AppUwbRadar.h"
 
 #include <string.h>
 
@@ -186,7 +187,9 @@ void TaskHandler(void)
   //------------------------
   if(g_task_g_execute == APP_TRUE) 
   {
-
+    taskhandler_print("[app_radar_presence]\n");
+    app_radar_presence();
+    g_task_g_execute = APP_FALSE;
   }  
 
 }
@@ -22,6 +22,7 @@
 #include "AppSysUartCommander.h"
 #include "CB_system.h"
 #include "CB_SleepDeepSleep.h"
+#include "AppSysProfile.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
@@ -68,6 +69,9 @@ int main(void)
 {  
   // Initializes the Data Watchpoint and Trace (DWT) 
   DWT_Init();
+#if (APP_PROFILE_ENABLE == APP_TRUE)
+  app_prof_init();
+#endif
   
   // Run RC Timing Calibration once. Calibration done in background after 100ms (NMI handler).
   cb_system_rc_calibration();
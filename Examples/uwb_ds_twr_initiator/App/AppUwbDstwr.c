@@ -16,12 +16,20 @@
 #include "CB_scr.h"
 #include "NonLIB_sharedUtils.h"
 #include "CB_uwbframework.h"
+#include "CB_uwbsstwr.h"
+#include "CB_uwbtempcomp.h"
+#include "CB_flash.h"
+#include "ftm_cal_nvm.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
 //-------------------------------
 #define APP_DSTWR_USE_ABSOLUTE_TIMER   APP_TRUE
+#define APP_DSTWR_SSTWR_MODE           APP_FALSE  // APP_TRUE: clock-offset compensated SS-TWR (POLL, RESPONSE), same setting on the responder
+#define APP_DSTWR_SSTWR_CALIBRATION    APP_FALSE  // DS-TWR mode: fit the cfoEst to ppm conversion and store it in the FTM calibration page, loaded in SS-TWR mode
+#define APP_DSTWR_TEMPCOMP_ENABLE      APP_TRUE   // Range bias temperature compensation, table of the FTM calibration page (CB_uwbtempcomp.h)
 #define APP_UWB_DSTWR_UARTPRINT_ENABLE APP_TRUE
+#define APP_DSTWR_TURNAROUND_TRACE     APP_FALSE  // Log the RESPONSE RX0 done IRQ -> FINAL TX armed time, e.g. with and without ram_code.sct
 
 #if (APP_UWB_DSTWR_UARTPRINT_ENABLE == APP_TRUE)
   #include "app_uart.h"
@@ -39,6 +47,9 @@
 #define DEF_SYNC_TX_PAYLOAD_SIZE       4
 #define DEF_SYNC_ACK_RX_PAYLOAD_SIZE   3
 
+#define DEF_DSTWR_TURNAROUND_REPORT_CYCLES 100   // Turnaround statistics printed every n cycles
+#define DEF_DSTWR_SSTWR_CAL_STORE_SAMPLES  256   // Calibration exchanges fitted before the conversion is stored, once per run
+
 //-------------------------------
 // ENUM SECTION
 //-------------------------------
@@ -74,6 +85,21 @@ typedef struct
   volatile uint8_t Rx0Done;
 }app_uwbdstwr_irqstatus_st;
 
+typedef struct
+{
+  volatile uint32_t rx0DoneCycle;   // DWT cycle count in the RX0 done callback
+  uint64_t          sum;
+  uint32_t          min;
+  uint32_t          max;
+  uint32_t          count;
+}app_uwbdstwr_turnaround_st;
+
+typedef struct
+{
+  cb_uwbframework_rangingdatacontainer_st rangingDataContainer;
+  float                                   rangeBiasTempComp_cm;   // Responder temperature correction (CB_uwbtempcomp.h), 0 if not sent
+}app_dstwr_responderdatacontainer_st;
+
 //-------------------------------
 // GLOBAL VARIABLE SECTION
 //-------------------------------
@@ -116,10 +142,19 @@ static cb_uwbframework_rangingdatacontainer_st   s_stInitiatorDataContainer =
   .dstwrRangingBias = DEF_INITIATOR_RANGING_BIAS,
   .dstwrTroundTreply = {0}
 };
-static cb_uwbframework_rangingdatacontainer_st  s_stResponderDataContainer = {0};
+static app_dstwr_responderdatacontainer_st      s_stResponderDataContainer = {0};
 
 static double s_measuredDistance      = 0.0; // Measured Distance between Initiator and Responder
+static uint32_t s_responseCfoEst      = 0;   // cfoEst of the RESPONSE frame
+
+static cb_uwbsstwr_cfocal_st    s_stSstwrCfoCal;
+static cb_uwbsstwr_calaccum_st  s_stSstwrCalAccum;
+static cb_uwbsstwr_result_st    s_stSstwrResult;
+static uint8_t                  s_sstwrCalStored = APP_FALSE;
 static uint32_t s_appCycleCount       = 0;   // Logging Purpose: cycle count
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+static app_uwbdstwr_turnaround_st s_stTurnaround = {.min = UINT32_MAX};
+#endif
 
 //-------------------------------
 // DS-TWR: INITIATOR SETUP
@@ -135,6 +170,10 @@ static uint32_t s_appCycleCount       = 0;   // Logging Purpose: cycle count
 //       |<--------6. RESULT ----------------|
 //     Terminate                         Terminate  
 //
+// SS-TWR (APP_DSTWR_SSTWR_MODE): 5 and 6 are skipped, the RESPONSE carries the responder's
+// predicted Treply_1 and the initiator corrects it with the clock offset measured on the RESPONSE:
+//            ToF = (Tround_1 - Treply_1 / (1 + offset)) / 2
+//
 // DEF_DSTWR_SYNC_ACK_TIMEOUT_MS       : 1 + 2
 // DEF_DSTWR_OVERALL_PROCESS_TIMEOUT_MS: 3 + 4 + 5 + 6
 // DEF_DSTWR_APP_CYCLE_TIME_MS         : Idle
@@ -165,6 +204,12 @@ void    app_dstwr_reset(void);
 void    app_dstwr_timeout_error_message_print(void);
 uint8_t app_dstwr_validate_sync_ack_payload(void);
 void    app_dstwr_log(void);
+void    app_sstwr_calculate(void);
+void    app_sstwr_calibrate(void);
+void    app_sstwr_load_calibration(void);
+void    app_dstwr_get_responder_data(void);
+float   app_dstwr_tempcomp_correction(void);
+void    app_dstwr_turnaround_log(void);
  
 //-------------------------------
 // FUNCTION BODY SECTION
@@ -223,6 +268,19 @@ void app_dstwr_initiator(void)
   .eventCtrlMask        = EN_UWBCTRL_TX_START_MASK,     // tx start  :: (action)    select action upon abs timeout 
   };   
   
+  cb_uwbsstwr_default_cfo_calibration(&s_stSstwrCfoCal);
+  cb_uwbsstwr_cal_reset(&s_stSstwrCalAccum);
+  #if (APP_DSTWR_SSTWR_MODE == APP_TRUE) || (APP_DSTWR_TEMPCOMP_ENABLE == APP_TRUE)
+  cb_flash_init();
+  ftm_cal_nvm_init();
+  #endif
+  #if (APP_DSTWR_SSTWR_MODE == APP_TRUE)
+  app_sstwr_load_calibration();
+  #endif
+  #if (APP_DSTWR_TEMPCOMP_ENABLE == APP_TRUE)
+  ftm_cal_nvm_load_tempcomp();
+  #endif
+
   s_enAppDstwrState = EN_APP_STATE_SYNC_TRANSMIT;
   
   while(1)
@@ -234,6 +292,9 @@ void app_dstwr_initiator(void)
       //-------------------------------------        
       case EN_APP_STATE_IDLE:
         // Wait for next cycle
+        #if (APP_DSTWR_TEMPCOMP_ENABLE == APP_TRUE)
+        cb_uwbtempcomp_poll();
+        #endif
         if (cb_hal_is_time_elapsed(iterationTime, DEF_DSTWR_APP_CYCLE_TIME_MS))
         {
           s_enAppDstwrState = EN_APP_STATE_SYNC_TRANSMIT;
@@ -321,7 +382,9 @@ void app_dstwr_initiator(void)
       //-------------------------------------       
       case EN_APP_STATE_DSTWR_RECEIVE_RESPONSE:
         #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE)
+          #if (APP_DSTWR_SSTWR_MODE == APP_FALSE)
           cb_framework_uwb_enable_scheduled_trx(s_stDstwrTreply2Config);
+          #endif
           cb_framework_uwb_configure_scheduled_trx(s_stDstwrTround1Config);
           cb_framework_uwb_rx_start(EN_UWB_RX_0, &s_stUwbPacketConfig, &stRxIrqEnable, EN_TRX_START_DEFERRED);
 
@@ -338,13 +401,20 @@ void app_dstwr_initiator(void)
         if (s_stIrqStatus.Rx0Done == APP_TRUE)
         {
           s_stIrqStatus.Rx0Done = APP_FALSE;
-          #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE)
+          #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE) && (APP_DSTWR_SSTWR_MODE == APP_FALSE)
           cb_framework_uwb_configure_scheduled_trx(s_stDstwrTreply2Config);
           #endif
           cb_framework_uwb_get_rx_tsu_timestamp(&s_stRxTsuTimestamp0, EN_UWB_RX_0);
+          s_responseCfoEst = cb_framework_uwb_get_rx_rssi(EN_UWB_RX_0).cfoEst;
+          #if (APP_DSTWR_SSTWR_MODE == APP_TRUE)
+          app_sstwr_calculate();
+          cb_framework_uwb_rx_end(EN_UWB_RX_0);
+          s_enAppDstwrState = EN_APP_STATE_TERMINATE;
+          #else
           cb_framework_uwb_rx_end(EN_UWB_RX_0);
           s_enAppDstwrState = EN_APP_STATE_DSTWR_TRANSMIT_FINAL;
           startTime = cb_hal_get_tick(); 
+          #endif
         }
         break;
       //-------------------------------------
@@ -353,6 +423,15 @@ void app_dstwr_initiator(void)
       case EN_APP_STATE_DSTWR_TRANSMIT_FINAL:
         #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE)
           cb_framework_uwb_tx_start(&s_stUwbPacketConfig, &stDstwrTxPayloadPack, &stTxIrqEnable, EN_TRX_START_DEFERRED);
+          #if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+          {
+            uint32_t turnaroundCycles = DWT->CYCCNT - s_stTurnaround.rx0DoneCycle;
+            s_stTurnaround.sum += turnaroundCycles;
+            s_stTurnaround.min  = (turnaroundCycles < s_stTurnaround.min) ? turnaroundCycles : s_stTurnaround.min;
+            s_stTurnaround.max  = (turnaroundCycles > s_stTurnaround.max) ? turnaroundCycles : s_stTurnaround.max;
+            s_stTurnaround.count++;
+          }
+          #endif
           s_enAppDstwrState = EN_APP_STATE_DSTWR_TRANSMIT_FINAL_WAIT_TX_DONE;
         #else
         if (cb_hal_is_time_elapsed(startTime, DEF_DSTWR_FINAL_WAIT_TIME_MS))
@@ -388,10 +467,13 @@ void app_dstwr_initiator(void)
           cb_uwbsystem_rxstatus_un rxStatus = cb_framework_uwb_get_rx_status();    
           if (rxStatus.rx0_ok == CB_TRUE)
           {  
-            uint16_t rxPayloadSize = cb_framework_uwb_get_rx_packet_size(&s_stUwbPacketConfig);
-            cb_framework_uwb_get_rx_payload                           ((uint8_t*)(&s_stResponderDataContainer), rxPayloadSize);
+            app_dstwr_get_responder_data();
             cb_framework_uwb_calculate_initiator_tround_treply        (&s_stInitiatorDataContainer, s_stTxTsuTimestamp0, s_stTxTsuTimestamp1, s_stRxTsuTimestamp0);
-            s_measuredDistance = cb_framework_uwb_calculate_distance  (s_stInitiatorDataContainer, s_stResponderDataContainer);
+            s_measuredDistance = cb_framework_uwb_calculate_distance  (s_stInitiatorDataContainer, s_stResponderDataContainer.rangingDataContainer);
+            #if (APP_DSTWR_SSTWR_CALIBRATION == APP_TRUE)
+            app_sstwr_calibrate();
+            #endif
+            s_measuredDistance += app_dstwr_tempcomp_correction();
           }
           cb_framework_uwb_rx_end(EN_UWB_RX_0);
           s_enAppDstwrState = EN_APP_STATE_TERMINATE;
@@ -423,13 +505,14 @@ void app_dstwr_initiator(void)
 void app_dstwr_reset(void)
 {
   s_measuredDistance            = 0.0;
+  s_responseCfoEst              = 0;
 
   s_stIrqStatus.TxDone          = APP_FALSE;
   s_stIrqStatus.Rx0Done         = APP_FALSE;
   s_applicationTimeout          = APP_FALSE;
   s_enAppDstwrFailureState      = EN_APP_STATE_IDLE;
   memset(&s_stInitiatorDataContainer,   0, sizeof(s_stInitiatorDataContainer)); 
-  memset(&s_stResponderDataContainer,   0, sizeof(cb_uwbframework_rangingdatacontainer_st));
+  memset(&s_stResponderDataContainer,   0, sizeof(s_stResponderDataContainer));
   cb_framework_uwb_tsu_clear();
   cb_framework_uwb_tx_end();            // ensure propoer TX end upon abnormal condition
   cb_framework_uwb_rx_end(EN_UWB_RX_0); // ensure propoer RX end upon abnormal condition
@@ -529,6 +612,9 @@ void cb_uwbapp_tx_done_irqhandler(void)
  */
 void cb_uwbapp_rx0_done_irqcb(void)
 {
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+  s_stTurnaround.rx0DoneCycle = DWT->CYCCNT;
+#endif
   s_stIrqStatus.Rx0Done = APP_TRUE; 
 }
 
@@ -556,13 +642,159 @@ void app_dstwr_log(void)
 {
   if (!s_applicationTimeout)
   {
+    #if (APP_DSTWR_SSTWR_MODE == APP_TRUE)
+    app_uwb_dstwr_print("Cycle:%u, D:%fcm, CFO:%fppm, Bias:%fcm\n", s_appCycleCount++, s_measuredDistance,
+                        s_stSstwrResult.clockOffset_ppm, s_stSstwrResult.expectedBias_cm);
+    #else
     app_uwb_dstwr_print("Cycle:%u, D:%fcm\n", s_appCycleCount++, s_measuredDistance);      
+    #endif
   }
   else
   {
     app_dstwr_timeout_error_message_print();
     return;
   } 
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+  if (s_stTurnaround.count >= DEF_DSTWR_TURNAROUND_REPORT_CYCLES)
+  {
+    app_dstwr_turnaround_log();
+  }
+#endif
+}
+
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+/**
+ * @brief Prints the RESPONSE RX0 done IRQ -> FINAL TX armed time and restarts the statistics.
+ * @details The FINAL leaves at the absolute timer (s_stDstwrTreply2Config), the time printed is
+ *          the part of it taken by the CPU; the jitter (max - min) comes from the flash accesses
+ *          and the interrupts.
+ */
+void app_dstwr_turnaround_log(void)
+{
+  uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+  uint32_t avg         = (uint32_t)(s_stTurnaround.sum / s_stTurnaround.count);
+
+  app_uwb_dstwr_print("Turnaround (%u): avg %u, min %u, max %u, jitter %u cycles (avg %u us, jitter %u us)\n",
+                      s_stTurnaround.count, avg, s_stTurnaround.min, s_stTurnaround.max,
+                      s_stTurnaround.max - s_stTurnaround.min, avg / cyclesPerUs,
+                      (s_stTurnaround.max - s_stTurnaround.min) / cyclesPerUs);
+  s_stTurnaround.sum   = 0;
+  s_stTurnaround.min   = UINT32_MAX;
+  s_stTurnaround.max   = 0;
+  s_stTurnaround.count = 0;
+}
+#endif
+
+/**
+ * @brief   SS-TWR distance from the RESPONSE.
+ * @details The RESPONSE payload holds the responder's predicted Treply_1 (success is CB_FALSE until
+ *          the responder has learnt its TX delay). Call it before the RX is ended.
+ */
+void app_sstwr_calculate(void)
+{
+  cb_uwbsystem_rxstatus_un rxStatus = cb_framework_uwb_get_rx_status();
+  if (rxStatus.rx0_ok == CB_TRUE)
+  {
+    app_dstwr_get_responder_data();
+    if (s_stResponderDataContainer.rangingDataContainer.dstwrTroundTreply.success == CB_TRUE)
+    {
+      cb_framework_uwb_calculate_initiator_tround_treply(&s_stInitiatorDataContainer, s_stTxTsuTimestamp0, s_stTxTsuTimestamp1, s_stRxTsuTimestamp0);
+      cb_uwbsstwr_calculate(&s_stSstwrCfoCal, &s_stInitiatorDataContainer.dstwrTroundTreply, &s_stResponderDataContainer.rangingDataContainer.dstwrTroundTreply,
+                            s_responseCfoEst, s_stInitiatorDataContainer.dstwrRangingBias + s_stResponderDataContainer.rangingDataContainer.dstwrRangingBias,
+                            &s_stSstwrResult);
+      s_measuredDistance = s_stSstwrResult.distance_cm + app_dstwr_tempcomp_correction();
+    }
+  }
+}
+
+/**
+ * @brief   Read the responder container from the RX payload.
+ * @details The read is limited to the container: a responder with a longer payload does not overrun
+ *          it, and a responder without the temperature correction field leaves it at 0.
+ */
+void app_dstwr_get_responder_data(void)
+{
+  uint16_t rxPayloadSize = cb_framework_uwb_get_rx_packet_size(&s_stUwbPacketConfig);
+
+  memset(&s_stResponderDataContainer, 0, sizeof(s_stResponderDataContainer));
+  if (rxPayloadSize > sizeof(s_stResponderDataContainer))
+  {
+    rxPayloadSize = sizeof(s_stResponderDataContainer);
+  }
+  cb_framework_uwb_get_rx_payload((uint8_t*)(&s_stResponderDataContainer), rxPayloadSize);
+}
+
+/**
+ * @brief   Temperature correction of the measured distance, in cm.
+ * @details Each device compensates its own TX/RX delay drift: the initiator correction plus the one
+ *          sent by the responder. The static dstwrRangingBias values are applied by the framework.
+ */
+float app_dstwr_tempcomp_correction(void)
+{
+  #if (APP_DSTWR_TEMPCOMP_ENABLE == APP_TRUE)
+  return cb_uwbtempcomp_get_range_bias_cm() + s_stResponderDataContainer.rangeBiasTempComp_cm;
+  #else
+  return 0.0f;
+  #endif
+}
+
+/**
+ * @brief   Add the DS-TWR exchange to the SS-TWR cfoEst calibration.
+ * @details The first round (POLL, RESPONSE) is the SS-TWR exchange and the DS-TWR time of flight is
+ *          the reference. The conversion is refitted once enough samples are collected; it needs
+ *          exchanges at several clock offsets, e.g. over a temperature sweep.
+ */
+void app_sstwr_calibrate(void)
+{
+  double dstwrTof_ns = (s_measuredDistance + DEF_UWB_SSTWR_RANGING_OFFSET_CM
+                        - (double)s_stInitiatorDataContainer.dstwrRangingBias
+                        - (double)s_stResponderDataContainer.rangingDataContainer.dstwrRangingBias) / DEF_UWB_SSTWR_CM_PER_NS;
+
+  cb_uwbsstwr_cal_add(&s_stSstwrCalAccum, &s_stSstwrCfoCal, s_responseCfoEst,
+                      &s_stInitiatorDataContainer.dstwrTroundTreply, &s_stResponderDataContainer.rangingDataContainer.dstwrTroundTreply, dstwrTof_ns);
+  if ((s_stSstwrCalAccum.count % DEF_UWB_SSTWR_CAL_MIN_SAMPLES) == 0U)
+  {
+    if (cb_uwbsstwr_cal_solve(&s_stSstwrCalAccum, &s_stSstwrCfoCal) == CB_PASS)
+    {
+      app_uwb_dstwr_print("SS-TWR cal: %fppm/lsb, offset:%fppm, residual:%fppm\n",
+                          s_stSstwrCfoCal.ppmPerLsb, s_stSstwrCfoCal.ppmOffset, s_stSstwrCfoCal.residualPpm);
+      if ((s_sstwrCalStored == APP_FALSE) && (s_stSstwrCalAccum.count >= DEF_DSTWR_SSTWR_CAL_STORE_SAMPLES))
+      {
+        stCaliSstwrCfo stCalSstwrCfo = {s_stSstwrCfoCal.ppmPerLsb, s_stSstwrCfoCal.ppmOffset, s_stSstwrCfoCal.residualPpm};
+
+        cb_flash_init();
+        if ((ftm_cal_nvm_init() == EN_CAL_OK) && (ftm_cal_nvm_write_sstwr_cfo(stCalSstwrCfo) == EN_CAL_OK))
+        {
+          s_sstwrCalStored = APP_TRUE;
+          app_uwb_dstwr_print("SS-TWR cal: stored\n");
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief   Load the SS-TWR cfoEst conversion stored by app_sstwr_calibrate().
+ * @details Without a stored conversion, SS-TWR runs with the uncalibrated DEF_UWB_SSTWR_CFO_PPM_PER_LSB
+ *          and its residual error.
+ */
+void app_sstwr_load_calibration(void)
+{
+  stCaliSstwrCfo stCalSstwrCfo;
+
+  if (ftm_cal_nvm_read_sstwr_cfo(&stCalSstwrCfo) == EN_CAL_OK)
+  {
+    s_stSstwrCfoCal.ppmPerLsb   = stCalSstwrCfo.PpmPerLsb;
+    s_stSstwrCfoCal.ppmOffset   = stCalSstwrCfo.PpmOffset;
+    s_stSstwrCfoCal.residualPpm = stCalSstwrCfo.ResidualPpm;
+    s_stSstwrCfoCal.calibrated  = CB_TRUE;
+    app_uwb_dstwr_print("SS-TWR cal: loaded %fppm/lsb, offset:%fppm, residual:%fppm\n",
+                        s_stSstwrCfoCal.ppmPerLsb, s_stSstwrCfoCal.ppmOffset, s_stSstwrCfoCal.residualPpm);
+  }
+  else
+  {
+    app_uwb_dstwr_print("SS-TWR cal: none stored, uncalibrated conversion\n");
+  }
 }
 
 /**
@@ -16,12 +16,21 @@
 #include "CB_scr.h"
 #include "NonLIB_sharedUtils.h"
 #include "CB_uwbframework.h"
+#include "CB_uwblinkcache.h"
+#include "CB_uwbsstwr.h"
+#include "CB_uwbtempcomp.h"
+#include "CB_flash.h"
+#include "ftm_cal_nvm.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
 //-------------------------------
 #define APP_DSTWR_USE_ABSOLUTE_TIMER   APP_TRUE
+#define APP_DSTWR_LINKCACHE_MODE       EN_UWB_LINKCACHE_MODE_OFF // RX gain/CFO seeding: _ON, or _ALTERNATE to compare with/without
+#define APP_DSTWR_SSTWR_MODE           APP_FALSE  // APP_TRUE: clock-offset compensated SS-TWR (POLL, RESPONSE), same setting on the initiator
+#define APP_DSTWR_TEMPCOMP_ENABLE      APP_TRUE   // Range bias temperature compensation, table of the FTM calibration page (CB_uwbtempcomp.h)
 #define APP_UWB_DSTWR_UARTPRINT_ENABLE APP_TRUE
+#define APP_DSTWR_TURNAROUND_TRACE     APP_FALSE  // Log the POLL RX0 done IRQ -> RESPONSE TX armed time, e.g. with and without ram_code.sct
 
 #if (APP_UWB_DSTWR_UARTPRINT_ENABLE == APP_TRUE)
   #include "app_uart.h"
@@ -30,6 +39,10 @@
   #define app_uwb_dstwr_print(...)
 #endif
 
+#if (APP_DSTWR_SSTWR_MODE == APP_TRUE) && (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_FALSE)
+  #error "SS-TWR needs the scheduled RESPONSE to predict Treply_1"
+#endif
+
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
@@ -39,6 +52,10 @@
 #define DEF_SYNC_RX_PAYLOAD_SIZE       4
 #define DEF_SYNC_ACK_TX_PAYLOAD_SIZE   3
 
+#define DEF_DSTWR_PEER_ID              0     // Single initiator
+#define DEF_DSTWR_LINKCACHE_REPORT_CYCLES  100   // Link statistics printed every n cycles
+#define DEF_DSTWR_TURNAROUND_REPORT_CYCLES 100   // Turnaround statistics printed every n cycles
+
 //-------------------------------
 // ENUM SECTION
 //-------------------------------
@@ -73,6 +90,21 @@ typedef struct
   volatile uint8_t Rx0Done;
 }app_uwbdstwr_irqstatus_st;
 
+typedef struct
+{
+  volatile uint32_t rx0DoneCycle;   // DWT cycle count in the RX0 done callback
+  uint64_t          sum;
+  uint32_t          min;
+  uint32_t          max;
+  uint32_t          count;
+}app_uwbdstwr_turnaround_st;
+
+typedef struct
+{
+  cb_uwbframework_rangingdatacontainer_st rangingDataContainer;
+  float                                   rangeBiasTempComp_cm;   // Responder temperature correction, added by the initiator
+}app_dstwr_responderdatacontainer_st;
+
 //-------------------------------
 // GLOBAL VARIABLE SECTION
 //-------------------------------
@@ -111,13 +143,19 @@ static cb_uwbsystem_txpayload_st uwbResultTxPayload;
 static cb_uwbsystem_tx_tsutimestamp_st  s_stTxTsuTimestamp0;
 static cb_uwbsystem_rx_tsutimestamp_st  s_stRxTsuTimestamp0;
 static cb_uwbsystem_rx_tsutimestamp_st  rxTsuTimestamp1;
-static cb_uwbframework_rangingdatacontainer_st s_stResponderDataContainer = 
+static app_dstwr_responderdatacontainer_st s_stResponderDataContainer = 
 {
-  .dstwrRangingBias = DEF_RESPONDER_RANGING_BIAS,
-  .dstwrTroundTreply = {0}
+  .rangingDataContainer = { .dstwrRangingBias  = DEF_RESPONDER_RANGING_BIAS,
+                            .dstwrTroundTreply = {0}},
+  .rangeBiasTempComp_cm = 0.0f
 };
 
 static uint32_t s_appCycleCount = 0;   // Logging Purpose: cycle count
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+static app_uwbdstwr_turnaround_st s_stTurnaround = {.min = UINT32_MAX};
+#endif
+
+static cb_uwbsstwr_replypredictor_st s_stSstwrReplyPredictor;
 
 //-------------------------------
 // DS-TWR: RESPONDER SETUP
@@ -148,6 +186,9 @@ static uint32_t s_appCycleCount = 0;   // Logging Purpose: cycle count
 //  a: -        d: s_stRxTsuTimestamp0
 //  b: -        e: s_stTxTsuTimestamp0
 //  c: -        f: rxTsuTimestamp1
+//
+// SS-TWR (APP_DSTWR_SSTWR_MODE): 5 and 6 are skipped. e is not known when the RESPONSE payload is
+// written, so Treply_1 is predicted from d and the TX delay learnt on the previous RESPONSEs.
 //-------------------------------------------------------
 #define DEF_DSTWR_OVERALL_PROCESS_TIMEOUT_MS    10 
 #define DEF_DSTWR_SYNC_RX_RESTART_TIMEOUT_MS    4
@@ -163,6 +204,8 @@ void    app_dstwr_reset                         (void);
 void    app_dstwr_timeout_error_message_print   (void);
 uint8_t app_dstwr_validate_sync_payload         (void);
 void    app_dstwr_log                           (void);
+void    app_dstwr_linkcache_log                 (void);
+void    app_dstwr_turnaround_log                (void);
 
 //-------------------------------
 // FUNCTION BODY SECTION
@@ -176,6 +219,11 @@ void app_dstwr_responder(void)
   // Init
   //--------------------------------
   cb_framework_uwb_init();
+  #if (APP_DSTWR_TEMPCOMP_ENABLE == APP_TRUE)
+  cb_flash_init();
+  ftm_cal_nvm_init();
+  ftm_cal_nvm_load_tempcomp();
+  #endif
   
   //--------------------------------
   // Configure Payload and IRQ
@@ -189,6 +237,12 @@ void app_dstwr_responder(void)
   static uint8_t s_dstwrPayload[1]    = {0x1};
   stDstwrTxPayloadPack.ptrAddress     = &s_dstwrPayload[0];
   stDstwrTxPayloadPack.payloadSize    = sizeof(s_dstwrPayload);  
+  #if (APP_DSTWR_SSTWR_MODE == APP_TRUE)
+  //  SS-TWR: RESPONSE carries the predicted Treply_1
+  stDstwrTxPayloadPack.ptrAddress     = (uint8_t*)(&s_stResponderDataContainer);
+  stDstwrTxPayloadPack.payloadSize    = sizeof(s_stResponderDataContainer);
+  cb_uwbsstwr_reply_predictor_reset(&s_stSstwrReplyPredictor);
+  #endif
 
   //--------------------------------
   // Configure IRQ
@@ -221,6 +275,8 @@ void app_dstwr_responder(void)
   .eventCtrlMask        = EN_UWBCTRL_RX0_START_MASK,    // rx0 start :: (action)    select action upon abs timeout 
   };  
   
+  cb_uwblinkcache_init(APP_DSTWR_LINKCACHE_MODE);
+  cb_uwblinkcache_begin_exchange(DEF_DSTWR_PEER_ID);
   s_enAppDstwrState = EN_APP_STATE_SYNC_RECEIVE;
  
   while(1)
@@ -232,8 +288,12 @@ void app_dstwr_responder(void)
       // IDLE
       //-------------------------------------         
         // Wait for next cycle
+        #if (APP_DSTWR_TEMPCOMP_ENABLE == APP_TRUE)
+        cb_uwbtempcomp_poll();
+        #endif
         if (cb_hal_is_time_elapsed(iterationTime, DEF_DSTWR_APP_CYCLE_TIME_MS))
         {
+          cb_uwblinkcache_begin_exchange(DEF_DSTWR_PEER_ID);
           s_enAppDstwrState = EN_APP_STATE_SYNC_RECEIVE;
         }
         break;
@@ -242,6 +302,7 @@ void app_dstwr_responder(void)
       // SYNC: RX
       //-------------------------------------       
       case EN_APP_STATE_SYNC_RECEIVE:
+        cb_uwblinkcache_prepare_rx(DEF_DSTWR_PEER_ID);
         cb_framework_uwb_rx_start(EN_UWB_RX_0, &s_stUwbPacketConfig, &stRxIrqEnable, EN_TRX_START_NON_DEFERRED);
         s_enAppDstwrState = EN_APP_STATE_SYNC_WAIT_RX_DONE;
         startTime = cb_hal_get_tick();
@@ -256,6 +317,11 @@ void app_dstwr_responder(void)
         {
           s_stIrqStatus.Rx0Done = APP_FALSE;
           uint32_t syncValidateResult = app_dstwr_validate_sync_payload();
+          cb_uwblinkcache_rx_done(DEF_DSTWR_PEER_ID, syncValidateResult, EN_UWB_RX_0);
+          if (syncValidateResult == APP_TRUE)
+          {
+            cb_uwblinkcache_record_fp_snr(DEF_DSTWR_PEER_ID, EN_UWB_RX_0);
+          }
           cb_framework_uwb_rx_end(EN_UWB_RX_0);
           if (syncValidateResult == APP_TRUE)
           {
@@ -293,6 +359,7 @@ void app_dstwr_responder(void)
         cb_framework_uwb_enable_scheduled_trx(s_stDstwrTreply1Config);
         #endif
       
+        cb_uwblinkcache_prepare_rx(DEF_DSTWR_PEER_ID);
         cb_framework_uwb_rx_start(EN_UWB_RX_0, &s_stUwbPacketConfig, &stRxIrqEnable, EN_TRX_START_NON_DEFERRED);
         s_enAppDstwrState = EN_APP_STATE_DSTWR_RECEIVE_POLL_WAIT_RX_DONE;
         break;
@@ -302,7 +369,14 @@ void app_dstwr_responder(void)
           s_stIrqStatus.Rx0Done = APP_FALSE;
 
           cb_framework_uwb_get_rx_tsu_timestamp(&s_stRxTsuTimestamp0, EN_UWB_RX_0);
+          cb_uwblinkcache_rx_done(DEF_DSTWR_PEER_ID, cb_framework_uwb_get_rx_status().rx0_ok, EN_UWB_RX_0);
           cb_framework_uwb_rx_end(EN_UWB_RX_0);
+          #if (APP_DSTWR_SSTWR_MODE == APP_TRUE)
+          s_stResponderDataContainer.rangingDataContainer.dstwrRangingBias = DEF_RESPONDER_RANGING_BIAS;
+          s_stResponderDataContainer.rangeBiasTempComp_cm = cb_uwbtempcomp_get_range_bias_cm();
+          s_stResponderDataContainer.rangingDataContainer.dstwrTroundTreply.success =
+            (cb_uwbsstwr_reply_predict(&s_stSstwrReplyPredictor, &s_stRxTsuTimestamp0, &s_stResponderDataContainer.rangingDataContainer.dstwrTroundTreply) == CB_PASS) ? CB_TRUE : CB_FALSE;
+          #endif
           s_enAppDstwrState = EN_APP_STATE_DSTWR_TRANSMIT_RESPONSE;
           startTime = cb_hal_get_tick();
         }
@@ -312,10 +386,21 @@ void app_dstwr_responder(void)
       //-------------------------------------            
       case EN_APP_STATE_DSTWR_TRANSMIT_RESPONSE:
         #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE)
+          #if (APP_DSTWR_SSTWR_MODE == APP_FALSE)
           cb_framework_uwb_enable_scheduled_trx(s_stDstwrTround2Config);
+          #endif
       
           cb_framework_uwb_configure_scheduled_trx(s_stDstwrTreply1Config);
           cb_framework_uwb_tx_start(&s_stUwbPacketConfig, &stDstwrTxPayloadPack, &stTxIrqEnable, EN_TRX_START_DEFERRED);
+          #if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+          {
+            uint32_t turnaroundCycles = DWT->CYCCNT - s_stTurnaround.rx0DoneCycle;
+            s_stTurnaround.sum += turnaroundCycles;
+            s_stTurnaround.min  = (turnaroundCycles < s_stTurnaround.min) ? turnaroundCycles : s_stTurnaround.min;
+            s_stTurnaround.max  = (turnaroundCycles > s_stTurnaround.max) ? turnaroundCycles : s_stTurnaround.max;
+            s_stTurnaround.count++;
+          }
+          #endif
           s_enAppDstwrState = EN_APP_STATE_DSTWR_TRANSMIT_RESPONSE_WAIT_TX_DONE;
         #else
         if (cb_hal_is_time_elapsed(startTime, DEF_DSTWR_RESPONSE_WAIT_TIME_MS))
@@ -330,14 +415,19 @@ void app_dstwr_responder(void)
         {
           s_stIrqStatus.TxDone = APP_FALSE;
           
-          #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE)
+          #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE) && (APP_DSTWR_SSTWR_MODE == APP_FALSE)
           cb_framework_uwb_configure_scheduled_trx(s_stDstwrTround2Config);
           #endif
           
           cb_framework_uwb_get_tx_tsu_timestamp(&s_stTxTsuTimestamp0);
           cb_framework_uwb_tx_end();
+          #if (APP_DSTWR_SSTWR_MODE == APP_TRUE)
+          cb_uwbsstwr_reply_learn(&s_stSstwrReplyPredictor, &s_stRxTsuTimestamp0, &s_stTxTsuTimestamp0);
+          s_enAppDstwrState = EN_APP_STATE_TERMINATE;
+          #else
           s_enAppDstwrState = EN_APP_STATE_DSTWR_RECEIVE_FINAL;
           startTime = cb_hal_get_tick();
+          #endif
         }
         break;
       //-------------------------------------
@@ -345,6 +435,7 @@ void app_dstwr_responder(void)
       //-------------------------------------         
       case EN_APP_STATE_DSTWR_RECEIVE_FINAL:
       {
+        cb_uwblinkcache_prepare_rx(DEF_DSTWR_PEER_ID);
         #if (APP_DSTWR_USE_ABSOLUTE_TIMER == APP_TRUE)
           cb_framework_uwb_rx_start(EN_UWB_RX_0, &s_stUwbPacketConfig, &stRxIrqEnable, EN_TRX_START_DEFERRED);
           s_enAppDstwrState = EN_APP_STATE_DSTWR_RECEIVE_FINAL_WAIT_RX_DONE;
@@ -368,6 +459,15 @@ void app_dstwr_responder(void)
           #endif
           
           cb_framework_uwb_get_rx_tsu_timestamp(&rxTsuTimestamp1, EN_UWB_RX_0);
+          {
+            uint8_t finalRxOk = cb_framework_uwb_get_rx_status().rx0_ok;
+            cb_uwblinkcache_rx_done(DEF_DSTWR_PEER_ID, finalRxOk, EN_UWB_RX_0);
+            if (finalRxOk == CB_TRUE)
+            {
+              // First-path SNR after FINAL only: its CIR read and log10f would delay the RESPONSE after POLL
+              cb_uwblinkcache_record_fp_snr(DEF_DSTWR_PEER_ID, EN_UWB_RX_0);
+            }
+          }
           cb_framework_uwb_rx_end(EN_UWB_RX_0);
           s_enAppDstwrState = EN_APP_STATE_RESULT_TRANSMIT;
           startTime = cb_hal_get_tick();
@@ -381,9 +481,10 @@ void app_dstwr_responder(void)
       {
         if (cb_hal_is_time_elapsed(startTime, DEF_DSTWR_RESULT_WAIT_TIME_MS))
         {
-          cb_framework_uwb_calculate_responder_tround_treply(&s_stResponderDataContainer, s_stTxTsuTimestamp0, s_stRxTsuTimestamp0, rxTsuTimestamp1);
-          uwbResultTxPayload.ptrAddress = (uint8_t*)(&s_stResponderDataContainer.dstwrTroundTreply);
-          uwbResultTxPayload.payloadSize = sizeof(cb_uwbframework_rangingdatacontainer_st);
+          cb_framework_uwb_calculate_responder_tround_treply(&s_stResponderDataContainer.rangingDataContainer, s_stTxTsuTimestamp0, s_stRxTsuTimestamp0, rxTsuTimestamp1);
+          s_stResponderDataContainer.rangeBiasTempComp_cm = cb_uwbtempcomp_get_range_bias_cm();
+          uwbResultTxPayload.ptrAddress = (uint8_t*)(&s_stResponderDataContainer);
+          uwbResultTxPayload.payloadSize = sizeof(s_stResponderDataContainer);
           
           cb_framework_uwb_tx_start(&s_stUwbPacketConfig, &uwbResultTxPayload, &stTxIrqEnable, EN_TRX_START_NON_DEFERRED);
           s_enAppDstwrState = EN_APP_STATE_RESULT_WAIT_TX_DONE;
@@ -405,6 +506,12 @@ void app_dstwr_responder(void)
       //-------------------------------------  
       case EN_APP_STATE_TERMINATE:
       {
+        if ((s_applicationTimeout == APP_TRUE) &&
+            ((s_enAppDstwrFailureState == EN_APP_STATE_DSTWR_RECEIVE_POLL_WAIT_RX_DONE) || (s_enAppDstwrFailureState == EN_APP_STATE_DSTWR_RECEIVE_FINAL_WAIT_RX_DONE)))
+        {
+          cb_uwblinkcache_rx_done(DEF_DSTWR_PEER_ID, APP_FALSE, EN_UWB_RX_0);
+        }
+        cb_uwblinkcache_release();
         #if (DEF_DSTWR_ENABLE_LOG == APP_TRUE)
           app_dstwr_log();
         #endif   
@@ -431,7 +538,7 @@ void app_dstwr_reset(void)
   s_stIrqStatus.Rx0Done        = APP_FALSE;
   s_applicationTimeout       = APP_FALSE;
   s_enAppDstwrFailureState          = EN_APP_STATE_IDLE;
-  memset(&s_stResponderDataContainer,   0, sizeof(cb_uwbframework_rangingdatacontainer_st));
+  memset(&s_stResponderDataContainer,   0, sizeof(s_stResponderDataContainer));
   cb_framework_uwb_tsu_clear();
   cb_framework_uwb_tx_end();            // ensure propoer TX end upon abnormal condition
   cb_framework_uwb_rx_end(EN_UWB_RX_0); // ensure propoer RX end upon abnormal condition
@@ -534,6 +641,9 @@ void cb_uwbapp_tx_done_irqhandler(void)
  */
 void cb_uwbapp_rx0_done_irqcb(void)
 {
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+  s_stTurnaround.rx0DoneCycle = DWT->CYCCNT;
+#endif
   s_stIrqStatus.Rx0Done = APP_TRUE;
 }
 
@@ -545,6 +655,7 @@ void cb_uwbapp_rx0_done_irqcb(void)
 void cb_timer_0_app_irq_callback (void)
 {
   s_applicationTimeout = APP_TRUE;
+  s_enAppDstwrFailureState = s_enAppDstwrState;
   s_enAppDstwrState = EN_APP_STATE_TERMINATE;
 }
 
@@ -558,6 +669,8 @@ void cb_timer_0_app_irq_callback (void)
  */
 void app_dstwr_log(void) 
 {
+  static uint32_t s_linkCacheReportCount = 0;
+
   if (!s_applicationTimeout)
   {
     app_uwb_dstwr_print("Cycle:%u - Ranging Successful\n", s_appCycleCount++); 
@@ -565,8 +678,59 @@ void app_dstwr_log(void)
   else
   {
     app_dstwr_timeout_error_message_print();
+  }
+  if ((++s_linkCacheReportCount % DEF_DSTWR_LINKCACHE_REPORT_CYCLES) == 0)
+  {
+    app_dstwr_linkcache_log();
+  }
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+  if (s_stTurnaround.count >= DEF_DSTWR_TURNAROUND_REPORT_CYCLES)
+  {
+    app_dstwr_turnaround_log();
+  }
+#endif
+}
+
+#if (APP_DSTWR_TURNAROUND_TRACE == APP_TRUE)
+/**
+ * @brief Prints the POLL RX0 done IRQ -> RESPONSE TX armed time and restarts the statistics.
+ * @details The RESPONSE leaves at the absolute timer (s_stDstwrTreply1Config), the time printed
+ *          is the part of it taken by the CPU; the jitter (max - min) comes from the flash
+ *          accesses and the interrupts.
+ */
+void app_dstwr_turnaround_log(void)
+{
+  uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+  uint32_t avg         = (uint32_t)(s_stTurnaround.sum / s_stTurnaround.count);
+
+  app_uwb_dstwr_print("Turnaround (%u): avg %u, min %u, max %u, jitter %u cycles (avg %u us, jitter %u us)\n",
+                      s_stTurnaround.count, avg, s_stTurnaround.min, s_stTurnaround.max,
+                      s_stTurnaround.max - s_stTurnaround.min, avg / cyclesPerUs,
+                      (s_stTurnaround.max - s_stTurnaround.min) / cyclesPerUs);
+  s_stTurnaround.sum   = 0;
+  s_stTurnaround.min   = UINT32_MAX;
+  s_stTurnaround.max   = 0;
+  s_stTurnaround.count = 0;
+}
+#endif
+
+/**
+ * @brief Prints the reception statistics of the initiator, with and without gain/CFO seeding.
+ */
+void app_dstwr_linkcache_log(void)
+{
+  const cb_uwblinkcache_peer_st *peer = cb_uwblinkcache_get_peer(DEF_DSTWR_PEER_ID);
+  if (peer == NULL)
+  {
     return;
   }
+  for (uint8_t i = 0; i < EN_UWB_LINKCACHE_STATS_NUM; i++)
+  {
+    const cb_uwblinkcache_stats_st *stats = &peer->stats[i];
+    app_uwb_dstwr_print("[%s] RX ok %u/%u, FP SNR %f dB\n", (i == EN_UWB_LINKCACHE_STATS_SEEDED) ? "seeded" : "free",
+                        stats->rxOk, stats->rxAttempts,
+                        (stats->fpSnrCount != 0) ? (double)(stats->fpSnrSum_dB / stats->fpSnrCount) : 0.0);
+  }
 }
 
 /**
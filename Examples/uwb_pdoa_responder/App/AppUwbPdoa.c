@@ -13,6 +13,7 @@
 #include "AppUwbPdoa.h"
 #include "CB_system_types.h"
 #include "CB_uwbframework.h"
+#include "CB_uwblinkcache.h"
 #include "NonLIB_sharedUtils.h"
 
 #include "CB_timer.h"
@@ -41,6 +42,11 @@
 // PDOA Mode Configuration:
 #define APP_PDOA_HIGH_ACCURACY_MODE   APP_FALSE // PDOA High Accuracy Mode: End then restart for better accuracy
 
+// RX gain/CFO seeding from the previous frames of the initiator, EN_UWB_LINKCACHE_MODE_ALTERNATE to compare with/without
+#define APP_PDOA_LINKCACHE_MODE       EN_UWB_LINKCACHE_MODE_ON
+#define DEF_PDOA_PEER_ID              0         // Single initiator
+#define DEF_PDOA_LINKCACHE_REPORT_CYCLES  100   // Link statistics printed every n cycles
+
 typedef enum {
   // IDLE STATE
   EN_APP_STATE_IDLE = 0,
@@ -74,7 +80,6 @@ typedef struct
 // GLOBAL VARIABLE SECTION
 //-------------------------------
 static uint8_t s_applicationTimeout                 = APP_FALSE;
-static cb_uwbsystem_rx_dbb_config_st s_stRxCfg_CfoGainBypass  = { 0 };
 
 /* Default Rx packet configuration.*/
 static cb_uwbsystem_packetconfig_st s_stUwbPacketConfig = 
@@ -97,6 +102,8 @@ static cb_uwbsystem_packetconfig_st s_stUwbPacketConfig =
 
 static app_uwbpdoa_irqstatus_st       s_stIrqStatus                = { APP_FALSE };
 static app_uwbpdoa_responderstate_en  s_enAppPdoaResponderState    = EN_APP_STATE_IDLE;
+static app_uwbpdoa_responderstate_en  s_enAppPdoaFailureState      = EN_APP_STATE_IDLE;
+static uint32_t                       s_appCycleCount              = 0;
 
 //  SYNC RX Payload                                                 'S'  'Y'  'N'  'C'
 static uint8_t s_syncExpectedRxPayload[DEF_SYNC_RX_PAYLOAD_SIZE]   = {0x53,0x59,0x4E,0x43}; 
@@ -104,7 +111,6 @@ static uint8_t s_syncExpectedRxPayload[DEF_SYNC_RX_PAYLOAD_SIZE]   = {0x53,0x59,
 static uint8_t s_syncAckPayload[DEF_SYNC_ACK_TX_PAYLOAD_SIZE]      = {0x41,0x43,0x4B};
 
 static uint8_t                          s_countOfPdoaScheduledRx   = 0;
-static cb_uwbsystem_rx_signalinfo_st    s_stRssiResults            = {0};
 static cb_uwbsystem_pdoaresult_st       s_stPdoaOutputResult       = {0};
 static float                            s_pd01Bias                 = DEF_PDOA_PD01_BIAS;
 static float                            s_pd02Bias                 = DEF_PDOA_PD02_BIAS;
@@ -139,6 +145,7 @@ static float                            s_eleResult                = 0.0f;
 //-------------------------------
 uint8_t app_pdoa_validate_sync_ack_payload(void);
 void app_pdoa_reset(void);
+void app_pdoa_linkcache_log(void);
 
 //-------------------------------
 // FUNCTION BODY SECTION
@@ -177,6 +184,8 @@ void app_pdoa_responder(void)
   stPdoaRxIrqEnable.rx1SfdDetDone                   = CB_TRUE;  
   stPdoaRxIrqEnable.rx2SfdDetDone                   = CB_TRUE;  
   
+  cb_uwblinkcache_init(APP_PDOA_LINKCACHE_MODE);
+  cb_uwblinkcache_begin_exchange(DEF_PDOA_PEER_ID);
   s_enAppPdoaResponderState = EN_APP_STATE_SYNC_RECEIVE;
   
   while(1)
@@ -190,6 +199,7 @@ void app_pdoa_responder(void)
         // Wait for next cycle
         if (cb_hal_is_time_elapsed(iterationTime, DEF_PDOA_APP_CYCLE_TIME_MS))
         {
+          cb_uwblinkcache_begin_exchange(DEF_PDOA_PEER_ID);
           s_enAppPdoaResponderState = EN_APP_STATE_SYNC_RECEIVE;
         }
       break;
@@ -198,6 +208,7 @@ void app_pdoa_responder(void)
       // SYNC: RX 
       //-------------------------------------      
       case EN_APP_STATE_SYNC_RECEIVE:
+        cb_uwblinkcache_prepare_rx(DEF_PDOA_PEER_ID);
         cb_framework_uwb_rx_start(EN_UWB_RX_0, &s_stUwbPacketConfig, &stSyncRxIrqEnable, EN_TRX_START_NON_DEFERRED); // RX START
         s_enAppPdoaResponderState = EN_APP_STATE_SYNC_WAIT_RX_DONE;
         startTime = cb_hal_get_tick();
@@ -212,9 +223,10 @@ void app_pdoa_responder(void)
         {
           s_stIrqStatus.Rx0Done = APP_FALSE;    
           uint8_t syncValidationResult = app_pdoa_validate_sync_ack_payload();
+          cb_uwblinkcache_rx_done(DEF_PDOA_PEER_ID, syncValidationResult, EN_UWB_RX_0);
           if (syncValidationResult == APP_TRUE)
           {
-            s_stRssiResults = cb_framework_uwb_get_rx_rssi(EN_UWB_RX_0);
+            cb_uwblinkcache_record_fp_snr(DEF_PDOA_PEER_ID, EN_UWB_RX_0);
             s_enAppPdoaResponderState = EN_APP_STATE_SYNC_TRANSMIT;
           }
           else
@@ -246,16 +258,8 @@ void app_pdoa_responder(void)
       //-------------------------------------  
       case EN_APP_STATE_PDOA_PREPARE:
         app_pdoa_timer_init(DEF_PDOA_OVERALL_PROCESS_TIMEOUT_MS);  
-        s_stRxCfg_CfoGainBypass.stRxGain = (cb_uwbsystem_rx_dbb_gain_st){
-            .enableBypass = APP_TRUE,
-            .gainValue    = s_stRssiResults.gainIdx
-        };
-
-        s_stRxCfg_CfoGainBypass.stRxCfo = (cb_uwbsystem_rx_dbb_cfo_st){
-            .enableBypass = APP_TRUE,
-            .cfoValue     = s_stRssiResults.cfoEst
-        };
-        cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_SET, &s_stRxCfg_CfoGainBypass);
+        // Gain and CFO of the SYNC frame just received, held for the whole burst
+        cb_uwblinkcache_prepare_rx(DEF_PDOA_PEER_ID);
         s_enAppPdoaResponderState = EN_APP_STATE_PDOA_RECEIVE;
         break;
         
@@ -285,9 +289,11 @@ void app_pdoa_responder(void)
           }
           else 
           {
+            cb_uwblinkcache_rx_done(DEF_PDOA_PEER_ID, APP_TRUE, EN_UWB_RX_0);
+            cb_uwblinkcache_record_fp_snr(DEF_PDOA_PEER_ID, EN_UWB_RX_0);
             cb_framework_uwb_rx_end(EN_UWB_RX_ALL);   
             s_countOfPdoaScheduledRx = 0;
-            cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_RESET, NULL);
+            cb_uwblinkcache_release();
             s_enAppPdoaResponderState = EN_APP_STATE_PDOA_POSTINGPROCESSING;
           }
         }
@@ -297,6 +303,7 @@ void app_pdoa_responder(void)
         // PDOA
         cb_framework_uwb_pdoa_calculate_result(&s_stPdoaOutputResult,EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);
         app_uwb_pdoa_print("PD01:%f, PD02:%f, PD12:%f (in degrees)\n",s_stPdoaOutputResult.median.rx0_rx1,s_stPdoaOutputResult.median.rx0_rx2,s_stPdoaOutputResult.median.rx1_rx2);          
+        cb_uwblinkcache_record_pdoa(DEF_PDOA_PEER_ID, (float)s_stPdoaOutputResult.median.rx0_rx2);
         
         // AOA
         cb_framework_uwb_pdoa_calculate_aoa(s_stPdoaOutputResult.median, s_pd01Bias, s_pd02Bias, s_pd12Bias, &s_aziResult, &s_eleResult);
@@ -310,6 +317,14 @@ void app_pdoa_responder(void)
         s_enAppPdoaResponderState = EN_APP_STATE_TERMINATE;
         break;
       case EN_APP_STATE_TERMINATE:
+        if ((s_applicationTimeout == APP_TRUE) && (s_enAppPdoaFailureState == EN_APP_STATE_PDOA_WAIT_RX_DONE))
+        {
+          cb_uwblinkcache_rx_done(DEF_PDOA_PEER_ID, APP_FALSE, EN_UWB_RX_0);
+        }
+        if ((++s_appCycleCount % DEF_PDOA_LINKCACHE_REPORT_CYCLES) == 0)
+        {
+          app_pdoa_linkcache_log();
+        }
         app_pdoa_timer_off();
         iterationTime = cb_hal_get_tick();
         s_enAppPdoaResponderState = EN_APP_STATE_IDLE;
@@ -326,10 +341,11 @@ void app_pdoa_reset(void)
   cb_framework_uwb_pdoa_reset_cir_data_container();
   memset(&s_stIrqStatus, APP_FALSE, sizeof(s_stIrqStatus));
   s_applicationTimeout       = APP_FALSE;
+  s_enAppPdoaFailureState    = EN_APP_STATE_IDLE;
   s_countOfPdoaScheduledRx   = 0;
   cb_framework_uwb_tx_end();            // ensure propoer TX end upon abnormal condition
   cb_framework_uwb_rx_end(EN_UWB_RX_0); // ensure propoer RX end upon abnormal condition
-  cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_RESET, NULL); // ensure CFO and gain settings are reset upon abnormal condition
+  cb_uwblinkcache_release();            // ensure CFO and gain settings are reset upon abnormal condition
 
 }
 
@@ -431,5 +447,26 @@ void cb_uwbapp_rx2_sfd_detected_irqcb(void)
 void cb_timer_0_app_irq_callback (void)
 {
   s_applicationTimeout = APP_TRUE;
+  s_enAppPdoaFailureState = s_enAppPdoaResponderState;
   s_enAppPdoaResponderState = EN_APP_STATE_TERMINATE;
 }
+
+/**
+ * @brief Prints the reception statistics of the initiator, with and without gain/CFO seeding.
+ */
+void app_pdoa_linkcache_log(void)
+{
+  const cb_uwblinkcache_peer_st *peer = cb_uwblinkcache_get_peer(DEF_PDOA_PEER_ID);
+  if (peer == NULL)
+  {
+    return;
+  }
+  for (uint8_t i = 0; i < EN_UWB_LINKCACHE_STATS_NUM; i++)
+  {
+    const cb_uwblinkcache_stats_st *stats = &peer->stats[i];
+    app_uwb_pdoa_print("[%s] RX ok %u/%u, FP SNR %f dB, PD02 var %f deg2 (%u bursts)\n", (i == EN_UWB_LINKCACHE_STATS_SEEDED) ? "seeded" : "free",
+                       stats->rxOk, stats->rxAttempts,
+                       (stats->fpSnrCount != 0) ? (double)(stats->fpSnrSum_dB / stats->fpSnrCount) : 0.0,
+                       (stats->pdoaCount > 1) ? (double)(stats->pdoaM2 / (stats->pdoaCount - 1)) : 0.0, stats->pdoaCount);
+  }
+}
@@ -15,6 +15,9 @@
 #include "AppSysIrqCallback.h"
 #include "APP_common.h"
 #include "CB_uwbframework.h"
+#if (APP_TIMESYNC_ENABLE == APP_TRUE)
+  #include "CB_uwbtimesync.h"
+#endif
 #define APP_UWB_PERIODICTRX_UARTPRINT_ENABLE APP_TRUE
 #if (APP_UWB_PERIODICTRX_UARTPRINT_ENABLE == APP_TRUE)
   #include "app_uart.h"
@@ -43,7 +46,12 @@ static cb_uwbsystem_packetconfig_st Txpacketconfig = {
 //-------------------------------
 // CONFIGURATION SECTION
 //-------------------------------
-
+#if (APP_TIMESYNC_ENABLE == APP_TRUE)
+#define DEF_PERIODIC_TX_INTERVAL_NS   100000000ULL  // Network time between two packets of an anchor
+#define DEF_PERIODIC_TX_SLOT_NS       0ULL          // Offset of this anchor in the interval, one slot per anchor
+#define DEF_PERIODIC_TX_LEAD_NS       2000000ULL    // Scheduled at least this long ahead of the start
+#define DEF_PERIODIC_TX_STATS_PACKETS 100           // Packets between two sync status prints
+#endif
 
 //-------------------------------
 // DEFINE SECTION
@@ -61,6 +69,7 @@ static cb_uwbsystem_packetconfig_st Txpacketconfig = {
 // FUNCTION PROTOTYPE SECTION
 //-------------------------------
 void app_periodictx_timestamp_and_payload_printout(void);
+static void app_uwb_periodic_tx_start(cb_uwbsystem_txpayload_st *txPayload);
 
 //-------------------------------
 // GLOBAL VARIABLE SECTION
@@ -99,7 +108,11 @@ void app_uwb_periodic_tx_transmitpacket(void)
   stTxIrqEnable.txDone  = CB_TRUE;
   stTxIrqEnable.sfdDone = CB_FALSE;
   
-  cb_framework_uwb_tx_start(&Txpacketconfig, &txPayload, &stTxIrqEnable, EN_TRX_START_NON_DEFERRED);  // TX START
+#if (APP_TIMESYNC_ENABLE == APP_TRUE)
+  cb_uwbtimesync_init(EN_UWB_TIMESYNC_SLAVE);
+  app_uwb_periodictrx_print("Waiting for the sync pulses\n");
+#endif
+  app_uwb_periodic_tx_start(&txPayload);                                                          // TX START
   app_uwb_periodictrx_print("Start Periodic TRX with payload size: %d\n", txPayload.payloadSize);
   
   s_periodic_tx_on_flag = APP_TRUE;
@@ -107,17 +120,66 @@ void app_uwb_periodic_tx_transmitpacket(void)
   
   while(s_periodic_tx_on_flag) 
   {
+#if (APP_TIMESYNC_ENABLE == APP_TRUE)
+    cb_uwbtimesync_process();
+#endif
     if(s_prev_tx_done)
     {
       cb_framework_uwb_tx_end();                        // TX END
       b_send_packet_total++;
       app_uwb_periodictrx_print("packet index:%d\n",b_send_packet_total);
-      cb_framework_uwb_tx_start(&Txpacketconfig, &txPayload, &stTxIrqEnable, EN_TRX_START_NON_DEFERRED);  // TX RESTART
+#if (APP_TIMESYNC_ENABLE == APP_TRUE)
+      if ((b_send_packet_total % DEF_PERIODIC_TX_STATS_PACKETS) == 0)
+      {
+        cb_uwbtimesync_stats_st stats;
+        cb_uwbtimesync_get_stats(&stats);
+        app_uwb_periodictrx_print("sync state:%d drift:%d ppb jitter:%d ns missed:%d outliers:%d\n", stats.state,
+                                  (int)(stats.driftPpm * 1000.0f), (int)stats.jitterRmsNs, stats.model.missed, stats.model.outliers);
+      }
+#endif
+      app_uwb_periodic_tx_start(&txPayload);                                                      // TX RESTART
       s_prev_tx_done = APP_FALSE;
     }
   }
 }
 
+/**
+ * @brief Starts a TX of the payload.
+ * 
+ * With APP_TIMESYNC_ENABLE, the TX starts on ABS timer 0 at the next slot of this anchor in
+ * network time, DEF_PERIODIC_TX_SLOT_NS in every DEF_PERIODIC_TX_INTERVAL_NS: the anchors on the
+ * sync line transmit in turn. Until synchronised, this waits for the sync pulses.
+ * 
+ * @param txPayload Payload to transmit.
+ */
+static void app_uwb_periodic_tx_start(cb_uwbsystem_txpayload_st *txPayload)
+{
+#if (APP_TIMESYNC_ENABLE == APP_TRUE)
+  cb_uwbframework_trx_scheduledconfig_st txConfig = {
+    .absTimer      = EN_UWB_ABSOLUTE_TIMER_0,         // Use absolute timer 0
+    .eventCtrlMask = EN_UWBCTRL_TX_START_MASK,        // Start TX on timeout
+  };
+  uint64_t nowNs;
+  uint64_t slotNs;
+
+  while (1)
+  {
+    cb_uwbtimesync_process();
+    if (cb_uwbtimesync_now(&nowNs) == CB_PASS)
+    {
+      slotNs = ((((nowNs + DEF_PERIODIC_TX_LEAD_NS) / DEF_PERIODIC_TX_INTERVAL_NS) + 1) * DEF_PERIODIC_TX_INTERVAL_NS) + DEF_PERIODIC_TX_SLOT_NS;
+      if (cb_uwbtimesync_configure_scheduled_trx(&txConfig, slotNs) == CB_PASS)
+      {
+        break;
+      }
+    }
+  }
+  cb_framework_uwb_tx_start(&Txpacketconfig, txPayload, &stTxIrqEnable, EN_TRX_START_DEFERRED);
+#else
+  cb_framework_uwb_tx_start(&Txpacketconfig, txPayload, &stTxIrqEnable, EN_TRX_START_NON_DEFERRED);
+#endif
+}
+
 /**
  * @brief Callback function for the UWB TX Done IRQ.
  * 
@@ -129,3 +191,12 @@ void cb_uwbapp_tx_done_irqhandler(void)
   s_prev_tx_done = APP_TRUE;
 }
 
+#if (APP_TIMESYNC_ENABLE == APP_TRUE)
+/**
+ * @brief Callback function for the GPIO IRQ: captures the sync pulse.
+ */
+void cb_gpio_app_irq_callback(void)
+{
+  cb_uwbtimesync_gpio_irqcb();
+}
+#endif
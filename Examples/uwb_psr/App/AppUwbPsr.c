@@ -25,13 +25,19 @@
   #define app_uwb_psr_print(...)
 #endif
 
+#define APP_UWB_PSR_DISCOVERY_BENCHMARK_ENABLE APP_FALSE
+
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
 #define RX_PACKET_PHR_VERIFICATION_VALUE 4417
 #define PREAMBLE_CODE_IDX_MIN 9
 #define PREAMBLE_CODE_IDX_MAX 24
-#define PREAMBLE_CODE_IDX_SIZE (PREAMBLE_CODE_IDX_MAX - PREAMBLE_CODE_IDX_MIN)
+#define PREAMBLE_CODE_IDX_COUNT (PREAMBLE_CODE_IDX_MAX - PREAMBLE_CODE_IDX_MIN + 1)
+#define PREAMBLE_CODE_IDX_NONE 0
+
+#define PSR_FAST_DWELL_MIN_MS 2     // First round dwell per code
+#define PSR_FAST_CONFIRM_MS   3     // Preamble detected to RX done, longer than one frame
 
 //-------------------------------
 // ENUM SECTION
@@ -60,7 +66,15 @@ static stAppUwbPsrIRQStatus s_IrqStatus;
 
 static cb_uwbsystem_rx_irqenable_st stRxIrqEnable;
 
-static uint8_t s_PreambleCodeStatus[PREAMBLE_CODE_IDX_SIZE];
+static uint8_t s_PreambleCodeStatus[PREAMBLE_CODE_IDX_COUNT];
+
+static stPsrCodeStatistics s_PsrCodeStatistics[PREAMBLE_CODE_IDX_COUNT];
+
+static uint8_t s_PsrScanOrder[PREAMBLE_CODE_IDX_COUNT];
+
+static uint32_t s_PsrSequenceFirstFoundTick;
+
+static cb_uwbsystem_rx_irqenable_st stFastRxIrqEnable;
 
 /* Default Rx packet configuration.*/
 static cb_uwbsystem_packetconfig_st Rxpacketconfig = 
@@ -92,6 +106,9 @@ void cb_system_set_preamble_index(cb_uwbsystem_preamblecodeidx_en index)
 //-------------------------------
 // FUNCTION PROTOTYPE SECTION
 //-------------------------------
+static void app_uwb_psr_clear_irq_status(void);
+static void app_uwb_psr_build_scan_order(void);
+static uint8_t app_uwb_psr_dwell(uint8_t preambleCodeIdx, uint32_t dwellMs);
 
 //-------------------------------
 // FUNCTION BODY SECTION
@@ -147,7 +164,19 @@ void app_uwb_psr_init(stPreambleScanningParameters params)
   */
 void app_uwb_psr_deal(void)
 {
-  app_uwb_psr_sequence();	
+#if (APP_UWB_PSR_DISCOVERY_BENCHMARK_ENABLE == APP_TRUE)
+  app_uwb_psr_discovery_benchmark();
+#else
+  if(s_PreambleScanningParams.psrMode == EN_PSR_FAST_MODE)
+  {
+    app_uwb_psr_fast_scan();
+    app_uwb_psr_display_statistics();
+  }
+  else
+  {
+    app_uwb_psr_sequence();	
+  }
+#endif
 }
 
 
@@ -250,6 +279,10 @@ cb_uwbsystem_preamblecodeidx_en app_uwb_psr_sequence(void)
 			else
 			{
 			   s_PreambleCodeStatus[cb_system_get_preamble_index() - PREAMBLE_CODE_IDX_MIN] = APP_TRUE;	
+			   if(s_PsrSequenceFirstFoundTick == 0)
+			   {
+			      s_PsrSequenceFirstFoundTick = cb_hal_get_tick();
+			   }
 			   break;
 			}
 		}
@@ -273,6 +306,216 @@ cb_uwbsystem_preamblecodeidx_en app_uwb_psr_sequence(void)
 
 
 
+/**
+ * @brief Fast preamble scan: short preamble-detect dwells, early exit on the first confirmed code.
+ * 
+ * Round 0 listens to each code for PSR_FAST_DWELL_MIN_MS, which finds a busy network at once.
+ * Every further round doubles the dwell, capped at scanDuration. The most recently seen codes are
+ * visited first, and get the full scanDuration from round 0. The scan gives up after the time of
+ * the linear scan, usually before the dwell reaches scanDuration: a network sending one frame per
+ * scanDuration can be missed, the linear scan (EN_PSR_FULL_MODE) always listens that long.
+ * 
+ * @return The first confirmed preamble code index, PREAMBLE_CODE_IDX_NONE if none was found.
+ */
+uint8_t app_uwb_psr_fast_scan(void)
+{
+  cb_uwbsystem_preamblecodeidx_en originalPreambleCodeIdx = cb_system_get_preamble_index();
+  uint8_t  foundPreambleCodeIdx = PREAMBLE_CODE_IDX_NONE;
+  uint32_t dwellMs   = PSR_FAST_DWELL_MIN_MS;
+  uint32_t timeoutMs = s_PreambleScanningParams.scanDuration * PREAMBLE_CODE_IDX_COUNT;
+  uint32_t startTime = cb_hal_get_tick();
+
+  memset(&stFastRxIrqEnable, 0, sizeof(stFastRxIrqEnable));
+  stFastRxIrqEnable.rx0PdDone     = CB_TRUE;
+  stFastRxIrqEnable.rx0SfdDetDone = CB_TRUE;
+  stFastRxIrqEnable.rx0Done       = CB_TRUE;
+
+  app_uwb_psr_build_scan_order();
+
+  cb_framework_uwb_init();
+  app_uwb_psr_print("Fast scanning\r\n");
+
+  for (uint8_t round = 0; foundPreambleCodeIdx == PREAMBLE_CODE_IDX_NONE; round++)
+  {
+    for (uint8_t i = 0; i < PREAMBLE_CODE_IDX_COUNT; i++)
+    {
+      uint8_t  preambleCodeIdx = s_PsrScanOrder[i];
+      uint32_t codeDwellMs     = dwellMs;
+
+      if ((round == 0) && (s_PsrCodeStatistics[preambleCodeIdx - PREAMBLE_CODE_IDX_MIN].rxOkCount != 0))
+      {
+        codeDwellMs = s_PreambleScanningParams.scanDuration;
+      }
+      if (app_uwb_psr_dwell(preambleCodeIdx, codeDwellMs) == APP_TRUE)
+      {
+        foundPreambleCodeIdx = preambleCodeIdx;
+        break;
+      }
+      if (cb_hal_is_time_elapsed(startTime, timeoutMs) == CB_PASS)
+      {
+        break;
+      }
+    }
+    if (cb_hal_is_time_elapsed(startTime, timeoutMs) == CB_PASS)
+    {
+      break;
+    }
+    dwellMs = ((dwellMs * 2) < s_PreambleScanningParams.scanDuration) ? (dwellMs * 2) : s_PreambleScanningParams.scanDuration;
+  }
+
+  cb_framework_uwb_off();
+  cb_system_set_preamble_index(originalPreambleCodeIdx);
+
+  if (foundPreambleCodeIdx != PREAMBLE_CODE_IDX_NONE)
+  {
+    app_uwb_psr_print("Preamble code %u found in %u ms\n", foundPreambleCodeIdx, cb_hal_get_tick() - startTime);
+  }
+  else
+  {
+    app_uwb_psr_print("No preamble code found\n");
+  }
+  return foundPreambleCodeIdx;
+}
+
+/**
+ * @brief Listens to one preamble code, ends early on preamble detection.
+ * 
+ * @param preambleCodeIdx Preamble code index.
+ * @param dwellMs         Max time waiting for a preamble.
+ * @return APP_TRUE if a frame with a valid PHR was received on this code.
+ */
+static uint8_t app_uwb_psr_dwell(uint8_t preambleCodeIdx, uint32_t dwellMs)
+{
+  stPsrCodeStatistics *stats = &s_PsrCodeStatistics[preambleCodeIdx - PREAMBLE_CODE_IDX_MIN];
+  uint8_t  confirmed = APP_FALSE;
+  uint32_t startTime = cb_hal_get_tick();
+
+  cb_system_set_preamble_index((cb_uwbsystem_preamblecodeidx_en)preambleCodeIdx);
+  app_uwb_psr_clear_irq_status();
+  stats->dwellCount++;
+
+  cb_framework_uwb_rx_start(EN_UWB_RX_0, &Rxpacketconfig, &stFastRxIrqEnable, EN_TRX_START_NON_DEFERRED);
+  while ((s_IrqStatus.Rx0PdDone == APP_FALSE) && (cb_hal_is_time_elapsed(startTime, dwellMs) != CB_PASS));
+
+  if (s_IrqStatus.Rx0PdDone == APP_TRUE)
+  {
+    uint32_t confirmTime = cb_hal_get_tick();
+    stats->pdCount++;
+
+    // Preamble detection alone can be a cross-correlation with a neighbour code: wait for the frame
+    while ((s_IrqStatus.Rx0Done == APP_FALSE) && (cb_hal_is_time_elapsed(confirmTime, PSR_FAST_CONFIRM_MS) != CB_PASS));
+    if (s_IrqStatus.Rx0SfdDetected == APP_TRUE)
+    {
+      stats->sfdCount++;
+    }
+    if (s_IrqStatus.Rx0Done == APP_TRUE)
+    {
+      cb_uwbsystem_rx_phrstatus_st phrStatus = cb_framework_uwb_get_rx_phr_status();
+      if ((phrStatus.phrSec == APP_FALSE) && (phrStatus.phrDed == APP_FALSE) && (phrStatus.rx0Ok == APP_TRUE) &&
+          (cb_framework_uwb_is_rx_phr_empty() == APP_FALSE))
+      {
+        confirmed = APP_TRUE;
+        stats->rxOkCount++;
+        stats->lastSeenTick = cb_hal_get_tick();
+      }
+    }
+  }
+
+  cb_framework_uwb_rx_end(EN_UWB_RX_0);
+  app_uwb_psr_clear_irq_status();
+  stats->dwellTimeMs += cb_hal_get_tick() - startTime;
+  return confirmed;
+}
+
+/**
+ * @brief Orders the codes most recently seen first, codes never seen keep their natural order.
+ */
+static void app_uwb_psr_build_scan_order(void)
+{
+  for (uint8_t i = 0; i < PREAMBLE_CODE_IDX_COUNT; i++)
+  {
+    uint8_t preambleCodeIdx = PREAMBLE_CODE_IDX_MIN + i;
+    const stPsrCodeStatistics *stats = &s_PsrCodeStatistics[i];
+    uint8_t j = i;
+
+    // Insertion sort, stable for codes never seen
+    while ((j > 0) && (stats->rxOkCount != 0))
+    {
+      const stPsrCodeStatistics *prev = &s_PsrCodeStatistics[s_PsrScanOrder[j - 1] - PREAMBLE_CODE_IDX_MIN];
+      if ((prev->rxOkCount != 0) && ((int32_t)(stats->lastSeenTick - prev->lastSeenTick) <= 0))
+      {
+        break;
+      }
+      s_PsrScanOrder[j] = s_PsrScanOrder[j - 1];
+      j--;
+    }
+    s_PsrScanOrder[j] = preambleCodeIdx;
+  }
+}
+
+static void app_uwb_psr_clear_irq_status(void)
+{
+  s_IrqStatus.Rx0PdDone = APP_FALSE;
+  s_IrqStatus.Rx0SfdDetected = APP_FALSE;
+  s_IrqStatus.Rx0Done = APP_FALSE;
+}
+
+/**
+ * @brief Measures the time to discover the active preamble code with the linear and the fast scan.
+ * 
+ * The linear scan is app_uwb_psr_sequence() in full mode, its discovery time is the time of its
+ * first valid frame. Both scans run against the same transmitter, one after the other.
+ */
+void app_uwb_psr_discovery_benchmark(void)
+{
+  stPreambleScanningParameters savedParams = s_PreambleScanningParams;
+  uint32_t startTime;
+  uint32_t linearTotalMs;
+  uint32_t linearFoundMs = 0;
+  uint32_t fastMs;
+  uint8_t  fastPreambleCodeIdx;
+
+  s_PreambleScanningParams.psrMode = EN_PSR_FULL_MODE;
+  s_PsrSequenceFirstFoundTick = 0;
+  startTime = cb_hal_get_tick();
+  app_uwb_psr_sequence();
+  linearTotalMs = cb_hal_get_tick() - startTime;
+  if (s_PsrSequenceFirstFoundTick != 0)
+  {
+    linearFoundMs = s_PsrSequenceFirstFoundTick - startTime;
+  }
+
+  s_PreambleScanningParams.psrMode = EN_PSR_FAST_MODE;
+  startTime = cb_hal_get_tick();
+  fastPreambleCodeIdx = app_uwb_psr_fast_scan();
+  fastMs = cb_hal_get_tick() - startTime;
+
+  s_PreambleScanningParams = savedParams;
+
+  app_uwb_psr_print("| Scan   | Discovery (ms) | Scan time (ms) |\n");
+  app_uwb_psr_print("+--------+----------------+----------------+\n");
+  app_uwb_psr_print("| Linear | %14u | %14u |\n", linearFoundMs, linearTotalMs);
+  app_uwb_psr_print("| Fast   | %14u | %14u |\n", (fastPreambleCodeIdx != PREAMBLE_CODE_IDX_NONE) ? fastMs : 0, fastMs);
+  app_uwb_psr_print("+--------+----------------+----------------+\n");
+  app_uwb_psr_display_statistics();
+}
+
+/**
+ * @brief Displays the per preamble code statistics of the fast scan.
+ */
+void app_uwb_psr_display_statistics(void)
+{
+  app_uwb_psr_print("| Code | Dwells | Time (ms) |  PD  | SFD  |  OK  |\n");
+  app_uwb_psr_print("+------+--------+-----------+------+------+------+\n");
+  for (uint8_t i = 0; i < PREAMBLE_CODE_IDX_COUNT; i++)
+  {
+    const stPsrCodeStatistics *stats = &s_PsrCodeStatistics[i];
+    app_uwb_psr_print("|  %2u  | %6u | %9u | %4u | %4u | %4u |\n", PREAMBLE_CODE_IDX_MIN + i, stats->dwellCount,
+                      stats->dwellTimeMs, stats->pdCount, stats->sfdCount, stats->rxOkCount);
+  }
+  app_uwb_psr_print("+------+--------+-----------+------+------+------+\n");
+}
+
 /**
  * @brief Displays the status table of the UWB preamble code index.
  * 
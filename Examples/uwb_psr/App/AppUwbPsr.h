@@ -31,7 +31,8 @@ typedef enum
 typedef enum
 {
 	EN_PSR_SINGLE_MODE = 1,
-	EN_PSR_FULL_MODE = 2
+	EN_PSR_FULL_MODE = 2,
+	EN_PSR_FAST_MODE = 3
 }enUwbPsrMode;
 
 //-------------------------------
@@ -44,6 +45,19 @@ typedef struct
 	uint32_t scanDuration;
 } stPreambleScanningParameters;
 
+/**
+ * @brief Per preamble code statistics of the fast scan, kept across scans.
+ */
+typedef struct
+{
+	uint32_t dwellCount;     // Dwells spent on the code
+	uint32_t dwellTimeMs;    // Time spent on the code
+	uint32_t pdCount;        // Preamble detected
+	uint32_t sfdCount;       // SFD detected after a preamble detection
+	uint32_t rxOkCount;      // Valid frame received: code confirmed
+	uint32_t lastSeenTick;   // cb_hal_get_tick() of the last confirmation
+} stPsrCodeStatistics;
+
 //-------------------------------
 // GLOBAL VARIABLE SECTION
 //-------------------------------
@@ -98,6 +112,28 @@ void app_uwb_psr_deal(void);
  */
 cb_uwbsystem_preamblecodeidx_en app_uwb_psr_sequence(void);
 
+/**
+ * @brief Fast preamble scan: short preamble-detect dwells, early exit on the first confirmed code.
+ * 
+ * Codes are visited most recently seen first. Each code is listened to for a short dwell with the
+ * preamble detect IRQ enabled; the dwell ends as soon as a preamble is detected, and the code is
+ * confirmed by the reception of a frame with a valid PHR. Each round doubles the dwell, up to
+ * scanDuration. The scan gives up after scanDuration for each code, the time of a linear scan.
+ * 
+ * @return The first confirmed preamble code index, 0 if none was found.
+ */
+uint8_t app_uwb_psr_fast_scan(void);
+
+/**
+ * @brief Measures the time to discover the active preamble code with the linear and the fast scan.
+ */
+void app_uwb_psr_discovery_benchmark(void);
+
+/**
+ * @brief Displays the per preamble code statistics of the fast scan.
+ */
+void app_uwb_psr_display_statistics(void);
+
 /**
  * @brief Suspends the UWB Preamble Scanning Receiver (PSR) operation.
  * 
@@ -16,11 +16,17 @@
 #include "CB_scr.h"
 #include "NonLIB_sharedUtils.h"
 #include "CB_uwbframework.h"
+#include "CB_uwbtempcomp.h"
+#include "CB_flash.h"
+#include "ftm_cal_nvm.h"
+#include "AppSysSupervisor.h"
+#include "app_spi_hif.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
 //-------------------------------
 #define DEF_APP_RNGAOA_USE_ABSOLUTE_TIMER   APP_TRUE
+#define APP_RNGAOA_TEMPCOMP_ENABLE      APP_TRUE   // Range/PDoA bias temperature compensation, table of the FTM calibration page (CB_uwbtempcomp.h)
 #define APP_UWB_RNGAOA_UARTPRINT_ENABLE APP_TRUE
 
 #if (APP_UWB_RNGAOA_UARTPRINT_ENABLE == APP_TRUE)
@@ -85,6 +91,7 @@ typedef struct
 {
   cb_uwbframework_rangingdatacontainer_st   rangingDataContainer;
   cb_uwbframework_pdoadatacontainer_st      pdoaDataContainer;  
+  float                                     rangeBiasTempComp_cm;   // Responder temperature correction (CB_uwbtempcomp.h), 0 if not sent
 } app_rngaoa_responderdatacontainer_st;
 
 //-------------------------------
@@ -138,7 +145,8 @@ app_rngaoa_responderdatacontainer_st s_stResponderDataContainer = {
                             .rx0_rx2 = 0.0f,
                             .rx1_rx2 = 0.0f,
                             .elevationEst = 0.0f,
-                            .azimuthEst = 0.0f }
+                            .azimuthEst = 0.0f },
+  .rangeBiasTempComp_cm = 0.0f
 };
 
 static double s_measuredDistance = 0.0; // Measured Distance
@@ -181,6 +189,7 @@ static uint8_t s_countOfPdoaScheduledTx = 0;
 #define DEF_RNGAOA_SYNC_ACK_TIMEOUT_MS           10
 #define DEF_RNGAOA_OVERALL_PROCESS_TIMEOUT_MS    10 
 #define DEF_RNGAOA_APP_CYCLE_TIME_MS             500
+#define DEF_RNGAOA_SUP_DEADLINE_MS               750     // Supervisor: longest time without a new cycle or retry, below DEF_APP_SUP_WDT_TIMEOUT_MS
 #define DEF_DSTWR_POLL_WAIT_TIME_MS              1
 #define DEF_DSTWR_RESPONSE_WAIT_TIME_MS          0
 #define DEF_DSTWR_FINAL_WAIT_TIME_MS             1  
@@ -194,6 +203,7 @@ void    app_rngaoa_reset                        (void);
 void    app_rngaoa_timeout_error_message_print  (void);
 uint8_t app_rngaoa_validate_sync_ack_payload    (void);
 void    app_rngaoa_log                          (void);
+void    app_rngaoa_hif_push                     (void);
  
 //-------------------------------
 // FUNCTION BODY SECTION
@@ -202,11 +212,20 @@ void app_rngaoa_initiator(void)
 {  
   uint32_t startTime      = 0;
   uint32_t iterationTime  = 0;  
+  #if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+  uint8_t supId    = app_sup_register("rngaoa", DEF_RNGAOA_SUP_DEADLINE_MS);
+  uint8_t supState = EN_APP_STATE_IDLE;
+  #endif
   
   //--------------------------------
   // Init
   //--------------------------------
   cb_framework_uwb_init();
+  #if (APP_RNGAOA_TEMPCOMP_ENABLE == APP_TRUE)
+  cb_flash_init();
+  ftm_cal_nvm_init();
+  ftm_cal_nvm_load_tempcomp();
+  #endif
   
   //--------------------------------
   // Configure Payload
@@ -276,6 +295,17 @@ void app_rngaoa_initiator(void)
   
   while(1)
   {
+    #if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+    if (s_enAppRngaoaState != supState)
+    {
+      supState = s_enAppRngaoaState;
+      app_sup_mark(supId, supState);
+    }
+    app_sup_service();
+    #endif
+    #if (APP_SPI_HIF_ENABLE == APP_TRUE)
+    app_hif_process();
+    #endif
     switch (s_enAppRngaoaState)
     {
       //-------------------------------------
@@ -283,6 +313,9 @@ void app_rngaoa_initiator(void)
       //-------------------------------------        
       case EN_APP_STATE_IDLE:
         // Wait for next cycle
+        #if (APP_RNGAOA_TEMPCOMP_ENABLE == APP_TRUE)
+        cb_uwbtempcomp_poll();
+        #endif
         if (cb_hal_is_time_elapsed(iterationTime, DEF_RNGAOA_APP_CYCLE_TIME_MS))
         {
           s_enAppRngaoaState = EN_APP_STATE_SYNC_TRANSMIT;
@@ -293,6 +326,9 @@ void app_rngaoa_initiator(void)
       // SYNC: TX
       //-------------------------------------        
       case EN_APP_STATE_SYNC_TRANSMIT:
+        #if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+        app_sup_checkin(supId, EN_APP_STATE_SYNC_TRANSMIT);
+        #endif
         cb_framework_uwb_tx_start(&s_stUwbPacketConfig, &stSyncTxPayloadPack, &stTxIrqEnable, EN_TRX_START_NON_DEFERRED);
         s_enAppRngaoaState = EN_APP_STATE_SYNC_WAIT_TX_DONE;
         break;
@@ -476,9 +512,19 @@ void app_rngaoa_initiator(void)
           if (rxStatus.rx0_ok == CB_TRUE)
           {  
             uint16_t rxPayloadSize = cb_framework_uwb_get_rx_packet_size(&s_stUwbPacketConfig);
+            // Limited to the container: a responder without the temperature correction leaves it at 0
+            memset(&s_stResponderDataContainer, 0, sizeof(s_stResponderDataContainer));
+            if (rxPayloadSize > sizeof(s_stResponderDataContainer))
+            {
+              rxPayloadSize = sizeof(s_stResponderDataContainer);
+            }
             cb_framework_uwb_get_rx_payload                           ((uint8_t*)(&s_stResponderDataContainer), rxPayloadSize);
             cb_framework_uwb_calculate_initiator_tround_treply        (&s_stInitiatorDataContainer, s_stTxTsuTimestamp0, s_stTxTsuTimestamp1, s_stRxTsuTimestamp0);
             s_measuredDistance = cb_framework_uwb_calculate_distance  (s_stInitiatorDataContainer, s_stResponderDataContainer.rangingDataContainer);
+            #if (APP_RNGAOA_TEMPCOMP_ENABLE == APP_TRUE)
+            // Each device compensates its own delay drift, the static biases are applied by the framework
+            s_measuredDistance += cb_uwbtempcomp_get_range_bias_cm() + s_stResponderDataContainer.rangeBiasTempComp_cm;
+            #endif
           }
           cb_framework_uwb_rx_end(EN_UWB_RX_0);
           s_enAppRngaoaState = EN_APP_STATE_TERMINATE;
@@ -488,6 +534,9 @@ void app_rngaoa_initiator(void)
       // Terminate
       //-------------------------------------       
       case EN_APP_STATE_TERMINATE:
+        #if (APP_SPI_HIF_ENABLE == APP_TRUE)
+          app_rngaoa_hif_push();
+        #endif
         #if (DEF_RNGAOA_ENABLE_LOG == APP_TRUE)
           app_rngaoa_log();
         #endif        
@@ -658,6 +707,27 @@ void app_rngaoa_log(void)
   } 
 }
 
+/**
+ * @brief Pushes the result of the cycle to the SPI host interface, before app_rngaoa_log() counts it.
+ */
+void app_rngaoa_hif_push(void)
+{
+  #if (APP_SPI_HIF_ENABLE == APP_TRUE)
+  if (!s_applicationTimeout)
+  {
+    app_hif_rec_ranging_t ranging = { .cycle = s_appCycleCount, .distanceCm = (float)s_measuredDistance, .valid = APP_TRUE };
+    app_hif_rec_aoa_t     aoa     = { .pd01      = s_stResponderDataContainer.pdoaDataContainer.rx0_rx1,
+                                      .pd02      = s_stResponderDataContainer.pdoaDataContainer.rx0_rx2,
+                                      .pd12      = s_stResponderDataContainer.pdoaDataContainer.rx1_rx2,
+                                      .azimuth   = s_stResponderDataContainer.pdoaDataContainer.azimuthEst,
+                                      .elevation = s_stResponderDataContainer.pdoaDataContainer.elevationEst };
+
+    app_hif_push(APP_HIF_REC_RANGING, &ranging, sizeof(ranging));
+    app_hif_push(APP_HIF_REC_AOA, &aoa, sizeof(aoa));
+  }
+  #endif
+}
+
 /**
  * @brief Prints a timeout error message based on the current process state.
  *
@@ -22,11 +22,14 @@
 #include "CB_system.h"
 #include "CB_SleepDeepSleep.h"
 #include "AppUwbRngAoa.h"
+#include "AppSysSupervisor.h"
+#include "app_spi_hif.h"
 #include "CB_uwbframework.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
 //-------------------------------
+#define DEF_APP_SUP_WDT_TIMEOUT_MS    1000    // Supervisor watchdog period, longer than every client deadline
 
 //-------------------------------
 // FUNCTION PROTOTYPE SECTION
@@ -91,6 +94,16 @@ int main(void)
   
   app_uart_printf("RNGAOA INITIATOR\n");
   
+  #if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+  // Watchdog reset of the previous run, if any. The watchdog starts after the RC calibration.
+  app_sup_init(DEF_APP_SUP_WDT_TIMEOUT_MS);
+  app_sup_report();
+  #endif
+  
+  #if (APP_SPI_HIF_ENABLE == APP_TRUE)
+  app_hif_init();
+  #endif
+  
   cb_system_uwb_set_system_config(&uwbSystemConfig);
   
   cb_system_uwb_ram_init(&g_UWB_TXBANKMEMORY,&g_UWB_RXBANKMEMORY,sizeof (g_UWB_TXBANKMEMORY), sizeof (g_UWB_RXBANKMEMORY)); //Initializes only once upon start-up. 
@@ -17,12 +17,17 @@
 #include "CB_scr.h"
 #include "NonLIB_sharedUtils.h"
 #include "CB_uwbframework.h"
+#include "CB_uwbtempcomp.h"
+#include "CB_flash.h"
+#include "ftm_cal_nvm.h"
+#include "AppSysSupervisor.h"
 #include "CB_aoa.h"
 
 //-------------------------------
 // CONFIGURATION SECTION
 //-------------------------------
 #define DEF_APP_RNGAOA_USE_ABSOLUTE_TIMER   APP_TRUE
+#define APP_RNGAOA_TEMPCOMP_ENABLE      APP_TRUE   // Range/PDoA bias temperature compensation, table of the FTM calibration page (CB_uwbtempcomp.h)
 #define APP_UWB_RNGAOA_UARTPRINT_ENABLE APP_TRUE
 
 #if (APP_UWB_RNGAOA_UARTPRINT_ENABLE == APP_TRUE)
@@ -48,6 +53,8 @@
 
 // PDOA Mode Configuration:
 #define APP_PDOA_HIGH_ACCURACY_MODE   APP_FALSE // PDOA High Accuracy Mode: RX end then start again for better accuracy
+#define APP_PDOA_INCREMENTAL_PROCESS  APP_TRUE  // Per-packet PDoA processing in the gap before next RX, only reduction after last packet
+#define APP_PDOA_PROCESS_TIME_TRACE   APP_FALSE // Log per-packet processing time and last PDoA RX -> result latency
 
 //-------------------------------
 // ENUM SECTION
@@ -95,6 +102,7 @@ typedef struct
 {
   cb_uwbframework_rangingdatacontainer_st rangingDataContainer;
   cb_uwbframework_pdoadatacontainer_st pdoaDataContainer;  
+  float rangeBiasTempComp_cm;   // Responder temperature correction, added by the initiator
 } app_rngaoa_responderdatacontainer_st;
 
 //-------------------------------
@@ -147,6 +155,11 @@ static float                              s_pd02Bias                 = DEF_PDOA_
 static float                              s_pd12Bias                 = DEF_PDOA_PD12_BIAS;
 static float                              s_aziResult                = 0.0f;
 static float                              s_eleResult                = 0.0f;
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+static uint32_t                           s_pdoaProcessCycles[DEF_PDOA_NUMPKT_SUPERFRAME_MAX] = {0};
+static uint32_t                           s_lastPdoaRxCycle          = 0;
+static uint32_t                           s_pdoaResultLatencyCycles  = 0;
+#endif
 
 static uint32_t s_appCycleCount = 0;   // Logging Purpose: cycle count
 
@@ -158,7 +171,8 @@ app_rngaoa_responderdatacontainer_st s_stResponderDataContainer =
                             .rx0_rx2 = 0.0f,
                             .rx1_rx2 = 0.0f,
                             .elevationEst = 0.0f,
-                            .azimuthEst = 0.0f }
+                            .azimuthEst = 0.0f },
+  .rangeBiasTempComp_cm = 0.0f
 };
   
 //-------------------------------
@@ -196,6 +210,7 @@ app_rngaoa_responderdatacontainer_st s_stResponderDataContainer =
 #define DEF_RNGAOA_OVERALL_PROCESS_TIMEOUT_MS    10
 #define DEF_RNGAOA_SYNC_RX_RESTART_TIMEOUT_MS    4
 #define DEF_RNGAOA_APP_CYCLE_TIME_MS             498
+#define DEF_RNGAOA_SUP_DEADLINE_MS               750     // Supervisor: longest time without a new cycle or retry, below DEF_APP_SUP_WDT_TIMEOUT_MS
 #define DEF_DSTWR_RESPONSE_WAIT_TIME_MS          1
 #define DEF_DSTWR_FINAL_WAIT_TIME_MS             0
 #define DEF_NUMBER_OF_PDOA_REPEATED_RX           DEF_PDOA_NUMPKT_SUPERFRAME_MAX
@@ -216,6 +231,10 @@ void app_rngaoa_responder(void)
 {  
   uint32_t startTime      = 0;
   uint32_t iterationTime  = 0;  
+  #if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+  uint8_t supId    = app_sup_register("rngaoa", DEF_RNGAOA_SUP_DEADLINE_MS);
+  uint8_t supState = EN_APP_STATE_IDLE;
+  #endif
   
   cb_uwbalg_poa_outputperpacket_st g_stPoaResult[DEF_PDOA_NUMPKT_SUPERFRAME_MAX];
   
@@ -223,6 +242,11 @@ void app_rngaoa_responder(void)
   // Init
   //--------------------------------
   cb_framework_uwb_init();
+  #if (APP_RNGAOA_TEMPCOMP_ENABLE == APP_TRUE)
+  cb_flash_init();
+  ftm_cal_nvm_init();
+  ftm_cal_nvm_load_tempcomp();
+  #endif
   
   //--------------------------------
   // Configure Payload and IRQ
@@ -276,6 +300,14 @@ void app_rngaoa_responder(void)
   
   while(1)
   {
+    #if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+    if (s_enAppRngaoaState != supState)
+    {
+      supState = s_enAppRngaoaState;
+      app_sup_mark(supId, supState);
+    }
+    app_sup_service();
+    #endif
     switch (s_enAppRngaoaState)
     {
       case EN_APP_STATE_IDLE:
@@ -283,6 +315,9 @@ void app_rngaoa_responder(void)
       // IDLE
       //-------------------------------------         
         // Wait for next cycle
+        #if (APP_RNGAOA_TEMPCOMP_ENABLE == APP_TRUE)
+        cb_uwbtempcomp_poll();
+        #endif
         if (cb_hal_is_time_elapsed(iterationTime, DEF_RNGAOA_APP_CYCLE_TIME_MS))
         {
           s_enAppRngaoaState = EN_APP_STATE_SYNC_RECEIVE;
@@ -292,6 +327,9 @@ void app_rngaoa_responder(void)
       // SYNC: RX
       //-------------------------------------       
       case EN_APP_STATE_SYNC_RECEIVE:
+        #if (APP_SUPERVISOR_ENABLE == APP_TRUE)
+        app_sup_checkin(supId, EN_APP_STATE_SYNC_RECEIVE);
+        #endif
         cb_framework_uwb_rx_start(EN_UWB_RX_0, &s_stUwbPacketConfig, &stRxIrqEnable, EN_TRX_START_NON_DEFERRED);
         s_enAppRngaoaState = EN_APP_STATE_SYNC_WAIT_RX_DONE;
         startTime = cb_hal_get_tick();
@@ -464,10 +502,23 @@ void app_rngaoa_responder(void)
             cb_framework_uwb_rx_start(EN_UWB_RX_ALL, &s_stUwbPacketConfig, &stPdoaRxIrqEnable, EN_TRX_START_NON_DEFERRED);
 #else
             cb_framework_uwb_rx_restart(EN_UWB_RX_ALL, &s_stUwbPacketConfig, &stPdoaRxIrqEnable, EN_TRX_START_NON_DEFERRED);
+#endif
+#if (APP_PDOA_INCREMENTAL_PROCESS == APP_TRUE)
+            // Process this packet while the next one is being received
+  #if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            uint32_t processStartCycle = DWT->CYCCNT;
+  #endif
+            cb_framework_uwb_pdoa_process_packet(EN_PDOA_3D_CALTYPE, s_countOfPdoaScheduledRx - 1);
+  #if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            s_pdoaProcessCycles[s_countOfPdoaScheduledRx - 1] = DWT->CYCCNT - processStartCycle;
+  #endif
 #endif
           }
           else 
           {
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+            s_lastPdoaRxCycle = DWT->CYCCNT;
+#endif
             cb_framework_uwb_rx_end(EN_UWB_RX_ALL);    
             s_countOfPdoaScheduledRx = 0;
             cb_framework_uwb_rxconfig_cfo_gain(EN_UWB_CFO_GAIN_RESET, NULL);
@@ -479,9 +530,24 @@ void app_rngaoa_responder(void)
       case EN_APP_STATE_PDOA_POSTINGPROCESSING:
       {
         // PDOA
+#if (APP_PDOA_INCREMENTAL_PROCESS == APP_TRUE)
+        cb_framework_uwb_pdoa_calculate_result_incremental(&s_stPdoaOutputResult, EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);
+#else
         cb_framework_uwb_pdoa_calculate_result(&s_stPdoaOutputResult,EN_PDOA_3D_CALTYPE, DEF_NUMBER_OF_PDOA_REPEATED_RX);        
+#endif
         // AOA
+        #if (APP_RNGAOA_TEMPCOMP_ENABLE == APP_TRUE)
+        cb_framework_uwb_pdoa_calculate_aoa(s_stPdoaOutputResult.median,
+                                            s_pd01Bias + cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD01),
+                                            s_pd02Bias + cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD02),
+                                            s_pd12Bias + cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD12),
+                                            &s_aziResult, &s_eleResult);
+        #else
         cb_framework_uwb_pdoa_calculate_aoa(s_stPdoaOutputResult.median, s_pd01Bias, s_pd02Bias, s_pd12Bias, &s_aziResult, &s_eleResult);
+        #endif
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+        s_pdoaResultLatencyCycles = DWT->CYCCNT - s_lastPdoaRxCycle;
+#endif
         
         s_enAppRngaoaState = EN_APP_STATE_RESULT_TRANSMIT;
         startTime = cb_hal_get_tick();
@@ -500,6 +566,7 @@ void app_rngaoa_responder(void)
           s_stResponderDataContainer.pdoaDataContainer.rx1_rx2      = s_stPdoaOutputResult.median.rx1_rx2;
           s_stResponderDataContainer.pdoaDataContainer.azimuthEst   = s_aziResult;
           s_stResponderDataContainer.pdoaDataContainer.elevationEst = s_eleResult;
+          s_stResponderDataContainer.rangeBiasTempComp_cm           = cb_uwbtempcomp_get_range_bias_cm();
           s_stResultTxPayload.ptrAddress = (uint8_t*)(&s_stResponderDataContainer);
           s_stResultTxPayload.payloadSize = sizeof(s_stResponderDataContainer);
           
@@ -552,12 +619,13 @@ void app_rngaoa_reset(void)
   s_stIrqStatus.Rx2SfdDetected = APP_FALSE;
   s_applicationTimeout       = APP_FALSE;
   s_enAppRngAoaFailureState          = EN_APP_STATE_IDLE;
-  memset(&s_stResponderDataContainer, 0, sizeof(cb_uwbframework_rangingdatacontainer_st));
+  memset(&s_stResponderDataContainer, 0, sizeof(s_stResponderDataContainer));
   s_stResponderDataContainer.rangingDataContainer.dstwrRangingBias = DEF_RESPONDER_RANGING_BIAS;
   s_aziResult = 0.0f;
   s_eleResult = 0.0f;
   memset(&s_stPdoaOutputResult, 0, sizeof(s_stPdoaOutputResult));
   cb_framework_uwb_pdoa_reset_cir_data_container();
+  cb_framework_uwb_pdoa_incremental_reset();
   cb_framework_uwb_tsu_clear();
   cb_framework_uwb_tx_end();            // ensure propoer TX end upon abnormal condition
   cb_framework_uwb_rx_end(EN_UWB_RX_0); // ensure propoer RX end upon abnormal condition
@@ -709,6 +777,13 @@ void app_rngaoa_log(void)
     /*Printout*/
     app_uwb_rngaoa_print("PD01:%f, PD02:%f, PD12:%f (in degrees),",s_stPdoaOutputResult.median.rx0_rx1,s_stPdoaOutputResult.median.rx0_rx2,s_stPdoaOutputResult.median.rx1_rx2);          
     app_uwb_rngaoa_print("azimuth: %f degrees,elevation: %f degrees\n", (double)s_aziResult,(double)s_eleResult);      
+#if (APP_PDOA_PROCESS_TIME_TRACE == APP_TRUE)
+    for (uint8_t i = 0; i < (DEF_NUMBER_OF_PDOA_REPEATED_RX - 1); i++)
+    {
+      app_uwb_rngaoa_print("PDOA process[%d] (overlapped with RX): %u us\n", i, s_pdoaProcessCycles[i] / (SystemCoreClock / 1000000U));
+    }
+    app_uwb_rngaoa_print("Last PDOA RX -> PDOA result: %u us\n", s_pdoaResultLatencyCycles / (SystemCoreClock / 1000000U));
+#endif
   }
   else
   {
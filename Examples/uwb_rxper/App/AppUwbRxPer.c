@@ -4,6 +4,10 @@
  * @details This file contains the implementation of UWB TRX RX PER (Packet Error Rate) measurement.
  *          It includes functions for initializing the measurement, handling IRQ callbacks,
  *          logging packet counts, and checking for timer timeout events.
+ *          Each reception is also added to a CB_uwbrxstats run (outcome breakdown, RSSI / CFO / gain
+ *          histograms). A snapshot can be queried over UART0 during the run without stopping the
+ *          reception: 's' returns a text summary line, 'b' a binary frame (0x5A, 'S', length LE16,
+ *          cb_uwbrxstats_serialize() layout). Both are sent through the UART TX queue.
  * @author  Chipsbank
  * @date    2024
  */
@@ -11,6 +15,7 @@
 //-------------------------------
 // INCLUDE SECTION
 //-------------------------------
+#include <stdio.h>
 #include <string.h>
 #include "AppUwbRxPer.h"
 #include "CB_timer.h"
@@ -18,6 +23,8 @@
 #include "AppSysIrqCallback.h"
 #include "CB_system_types.h"
 #include "CB_uwbframework.h"
+#include "CB_uwbrxstats.h"
+#include "CB_Uart.h"
 #include "NonLIB_sharedUtils.h"
 //-------------------------------
 // CONFIGURATION SECTION
@@ -30,6 +37,8 @@
   #define app_uwb_rxper_print(...)
 #endif
 
+#define APP_UWB_RXPER_STATS_QUERY_ENABLE APP_TRUE   // Answer 's' / 'b' snapshot queries on UART0 during the run
+
 //-------------------------------
 // DEFINE SECTION
 //-------------------------------
@@ -51,6 +60,12 @@ static cb_uwbsystem_packetconfig_st Rxpacketconfig = {
 
 static  cb_uwbsystem_rx_irqenable_st stRxIrqEnable;
 
+#define DEF_RXPER_STATS_CONFIDENCE_Z    1.96f   // 95% confidence interval of the PER
+#define DEF_RXPER_STATS_QUERY_TEXT      's'
+#define DEF_RXPER_STATS_QUERY_BINARY    'b'
+#define DEF_RXPER_STATS_FRAME_HEADER    0x5A
+#define DEF_RXPER_STATS_FRAME_TYPE      'S'
+
 //-------------------------------
 // ENUM SECTION
 //-------------------------------
@@ -63,6 +78,9 @@ static  cb_uwbsystem_rx_irqenable_st stRxIrqEnable;
 // FUNCTION PROTOTYPE SECTION
 //-------------------------------
 void app_uwb_rxper_packet_count_logging(cb_uwbsystem_rxport_en enRxPort);
+static void app_uwb_rxper_stats_query_process(void);
+static void app_uwb_rxper_stats_query_done(enUartChannel uartChannel, void *context);
+static uint16_t app_uwb_rxper_stats_format_summary(const cb_uwbrxstats_st *snapshot, char *buf, uint16_t bufSize);
 
 //-------------------------------
 // GLOBAL VARIABLE SECTION
@@ -75,6 +93,11 @@ static uint32_t rxPacketNotReceived;
 static uint8_t is_timer_timeout_flag;
 static cb_uwbsystem_rxstatus_un statusRegisterNotOK;
 static uint32_t countPositionWhenStatusRegisterNotOK;
+static cb_uwbrxstats_st s_stRxStats;
+static cb_uwbrxstats_st s_stRxStatsSnapshot;
+static volatile uint8_t s_rxStatsQuery;
+static volatile uint8_t s_rxStatsQueryBusy;
+static uint8_t s_rxStatsFrame[4 + DEF_UWB_RXSTATS_SERIALIZED_SIZE];
 
 //-------------------------------
 // FUNCTION BODY SECTION
@@ -146,9 +169,38 @@ void rx_print_log_message(uint32_t interval_time)
   app_uwb_rxper_print("  >> crc_fail    %d\n", statusRegisterNotOK.crc_fail     );
   app_uwb_rxper_print("  >> dsr_ovf     %d\n", statusRegisterNotOK.dsr_ovf      );
 
+  while (s_rxStatsQueryBusy == APP_TRUE);   // Last queried snapshot still on the line
+  if (cb_uwbrxstats_snapshot(&s_stRxStats, &s_stRxStatsSnapshot) == CB_PASS)
+  {
+    static const char *outcomeName[EN_UWB_RXSTATS_OUTCOME_NUM] = {"ok", "missed", "no_signal", "pd_fail", "sfd_fail",
+                                                                  "phr_error", "crc_fail", "dsr_ovf", "other_fail"};
+    static const char *metricName[EN_UWB_RXSTATS_METRIC_NUM]   = {"rssi", "cfo", "gain"};
+    cb_uwbrxstats_per_st stPer;
+    cb_uwbrxstats_per(&s_stRxStatsSnapshot, DEF_RXPER_STATS_CONFIDENCE_Z, &stPer);
 
-
-
+    app_uwb_rxper_print("\n> PER: %d/%d = %f, 95%% CI [%f, %f]\n", stPer.errors, stPer.total,
+                        (double)stPer.per, (double)stPer.lower, (double)stPer.upper);
+    for (uint8_t i = 0; i < (uint8_t)EN_UWB_RXSTATS_OUTCOME_NUM; i++)
+    {
+      app_uwb_rxper_print("  >> %-10s %d\n", outcomeName[i], s_stRxStatsSnapshot.outcome[i]);
+    }
+    app_uwb_rxper_print("  >> phr_corr   %d\n", s_stRxStatsSnapshot.phrCorrected);
+    for (uint8_t metric = 0; metric < (uint8_t)EN_UWB_RXSTATS_METRIC_NUM; metric++)
+    {
+      float mean, stddev;
+      cb_uwbrxstats_moments(&s_stRxStatsSnapshot, (cb_uwbrxstats_metric_en)metric, &mean, &stddev);
+      app_uwb_rxper_print("> %s: mean %f, std %f, min %d, max %d\n", metricName[metric], (double)mean, (double)stddev,
+                          s_stRxStatsSnapshot.metric[metric].min, s_stRxStatsSnapshot.metric[metric].max);
+      for (uint8_t bin = 0; bin < DEF_UWB_RXSTATS_HIST_BINS; bin++)
+      {
+        if (s_stRxStatsSnapshot.metric[metric].bins[bin] != 0U)
+        {
+          app_uwb_rxper_print("  >> [%d] %d\n", cb_uwbrxstats_bin_lower_edge((cb_uwbrxstats_metric_en)metric, bin),
+                              s_stRxStatsSnapshot.metric[metric].bins[bin]);
+        }
+      }
+    }
+  }
 }
 
 void per_param_init(cb_uwbsystem_rxport_en enRxPort)
@@ -160,6 +212,8 @@ void per_param_init(cb_uwbsystem_rxport_en enRxPort)
   rxPacketNotReceived = 0;
   statusRegisterNotOK.value = 0;
   countPositionWhenStatusRegisterNotOK = 0;
+  cb_uwbrxstats_reset(&s_stRxStats, enRxPort);
+  s_rxStatsQuery = 0;
   memset(&stRxIrqEnable, 0, sizeof(cb_uwbsystem_rx_irqenable_st));
   switch (enRxPort)
   {
@@ -215,9 +269,11 @@ void app_uwbtrx_rx_per(cb_uwbsystem_rxport_en enRxPort, uint32_t rxTimeIntervalI
     cb_framework_uwb_rx_start(enRxPort, &Rxpacketconfig, &stRxIrqEnable, EN_TRX_START_NON_DEFERRED); // RX START
     while ((rxPacketCount == rxPacketCountBuf)&&(is_timer_timeout_flag == CB_FALSE))
     {
+       app_uwb_rxper_stats_query_process();
        if(cb_hal_is_time_elapsed(startTime, 3) == CB_PASS)   // Delay 3ms
        {
           rxPacketNotReceived++;
+          cb_uwbrxstats_add_missed(&s_stRxStats);
           break;
        }
     }
@@ -245,6 +301,8 @@ void app_uwbtrx_rx_per(cb_uwbsystem_rxport_en enRxPort, uint32_t rxTimeIntervalI
 void app_uwb_rxper_packet_count_logging(cb_uwbsystem_rxport_en enRxPort)
 {
   cb_uwbsystem_rxstatus_un statusRegister = cb_framework_uwb_get_rx_status();
+  cb_uwbsystem_rx_signalinfo_st stSignalInfo = cb_framework_uwb_get_rx_rssi(enRxPort);
+  cb_uwbrxstats_add_packet(&s_stRxStats, statusRegister, &stSignalInfo);
 
   uint16_t rx_ok     = 0;
   uint16_t sfd_det   = 0;
@@ -291,6 +349,94 @@ void app_uwb_rxper_packet_count_logging(cb_uwbsystem_rxport_en enRxPort)
 
 
 
+/**
+ * @brief Formats the one-line text summary of a statistics snapshot.
+ *
+ * @param snapshot Statistics snapshot.
+ * @param buf      Output buffer.
+ * @param bufSize  Size of the buffer.
+ * @return Length of the line.
+ */
+static uint16_t app_uwb_rxper_stats_format_summary(const cb_uwbrxstats_st *snapshot, char *buf, uint16_t bufSize)
+{
+  cb_uwbrxstats_per_st stPer;
+  float rssiMean, rssiStd, cfoMean, cfoStd, gainMean, gainStd;
+
+  cb_uwbrxstats_per(snapshot, DEF_RXPER_STATS_CONFIDENCE_Z, &stPer);
+  cb_uwbrxstats_moments(snapshot, EN_UWB_RXSTATS_RSSI, &rssiMean, &rssiStd);
+  cb_uwbrxstats_moments(snapshot, EN_UWB_RXSTATS_CFO,  &cfoMean,  &cfoStd);
+  cb_uwbrxstats_moments(snapshot, EN_UWB_RXSTATS_GAIN, &gainMean, &gainStd);
+
+  int len = snprintf(buf, bufSize, "PER %u/%u %d ppm [%d,%d] ok %u miss %u nosig %u pd %u sfd %u phr %u crc %u dsr %u oth %u"
+                     " rssi %d/%d cfo %d/%d gain %d/%d\n",
+                     stPer.errors, stPer.total, (int32_t)(stPer.per * 1e6f), (int32_t)(stPer.lower * 1e6f), (int32_t)(stPer.upper * 1e6f),
+                     snapshot->outcome[EN_UWB_RXSTATS_OK], snapshot->outcome[EN_UWB_RXSTATS_MISSED], snapshot->outcome[EN_UWB_RXSTATS_NO_SIGNAL],
+                     snapshot->outcome[EN_UWB_RXSTATS_PD_FAIL], snapshot->outcome[EN_UWB_RXSTATS_SFD_FAIL], snapshot->outcome[EN_UWB_RXSTATS_PHR_ERROR],
+                     snapshot->outcome[EN_UWB_RXSTATS_CRC_FAIL], snapshot->outcome[EN_UWB_RXSTATS_DSR_OVF], snapshot->outcome[EN_UWB_RXSTATS_OTHER_FAIL],
+                     (int32_t)rssiMean, (int32_t)rssiStd, (int32_t)cfoMean, (int32_t)cfoStd, (int32_t)gainMean, (int32_t)gainStd);
+  if (len < 0)
+  {
+    return 0;
+  }
+  return (len < bufSize) ? (uint16_t)len : (uint16_t)(bufSize - 1U);
+}
+
+/**
+ * @brief TX queue completion callback of a snapshot query.
+ */
+static void app_uwb_rxper_stats_query_done(enUartChannel uartChannel, void *context)
+{
+  s_rxStatsQueryBusy = APP_FALSE;
+}
+
+/**
+ * @brief Answers a pending snapshot query.
+ * 
+ * Called from the RX loop: the snapshot copy and the formatting take a few tens of us and the
+ * answer is sent by the UART TX queue, so the reception is not stopped.
+ */
+static void app_uwb_rxper_stats_query_process(void)
+{
+#if (APP_UWB_RXPER_STATS_QUERY_ENABLE == APP_TRUE)
+  uint8_t query = s_rxStatsQuery;
+  uint16_t length = 0;
+
+  if ((query == 0U) || (s_rxStatsQueryBusy == APP_TRUE))
+  {
+    return;
+  }
+  s_rxStatsQuery = 0;
+
+  if (cb_uwbrxstats_snapshot(&s_stRxStats, &s_stRxStatsSnapshot) != CB_PASS)
+  {
+    return;
+  }
+  if (query == DEF_RXPER_STATS_QUERY_TEXT)
+  {
+    length = app_uwb_rxper_stats_format_summary(&s_stRxStatsSnapshot, (char *)s_rxStatsFrame, sizeof(s_rxStatsFrame));
+  }
+  else if (query == DEF_RXPER_STATS_QUERY_BINARY)
+  {
+    uint16_t payloadLength = cb_uwbrxstats_serialize(&s_stRxStatsSnapshot, &s_rxStatsFrame[4], sizeof(s_rxStatsFrame) - 4U);
+    s_rxStatsFrame[0] = DEF_RXPER_STATS_FRAME_HEADER;
+    s_rxStatsFrame[1] = DEF_RXPER_STATS_FRAME_TYPE;
+    s_rxStatsFrame[2] = (uint8_t)payloadLength;
+    s_rxStatsFrame[3] = (uint8_t)(payloadLength >> 8);
+    length = 4U + payloadLength;
+  }
+
+  if (length > 0U)
+  {
+    stUartTxSegment segment = {s_rxStatsFrame, length};
+    s_rxStatsQueryBusy = APP_TRUE;
+    if (cb_uart_txq_send(EN_UART_0, &segment, 1, app_uwb_rxper_stats_query_done, NULL) != CB_PASS)
+    {
+      s_rxStatsQueryBusy = APP_FALSE;
+    }
+  }
+#endif
+}
+
 /**
  * @brief Handler for rx0 done interrupt.
  * @detail Call logger and flip global flag to let device continue receiving.
@@ -323,3 +469,15 @@ void cb_timer_0_app_irq_callback(void)
 {
    is_timer_timeout_flag = CB_TRUE;
 }
+
+/**
+ * @brief Handler for UART0 RX buffer full interrupt (one byte).
+ * @detail Latch the snapshot query, answered from the RX loop.
+ */
+void cb_uart_0_rxb_full_app_irq_callback(void)
+{
+  uint8_t query;
+  cb_uart_get_rx_buffer(EN_UART_0, &query, 1);
+  cb_uart_rx_restart(EN_UART_0);
+  s_rxStatsQuery = query;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file    APP_CompileOption.h
+ * @brief   Host test version of Components/Configuration/APP_CompileOption.h.
+ * @details Bare metal, no BLE. Each test turns on the option of the module it builds with
+ *          DEFINES; the other options stay off.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __APP_COMPILE_OPTION_H
+#define __APP_COMPILE_OPTION_H
+#include "APP_common.h"
+
+#define APP_FREERTOS_ENABLE           APP_FALSE
+#define APP_BLE_ENABLE                APP_FALSE
+#ifndef APP_PROFILE_ENABLE
+#define APP_PROFILE_ENABLE            APP_FALSE
+#endif
+#ifndef APP_SUPERVISOR_ENABLE
+#define APP_SUPERVISOR_ENABLE         APP_FALSE
+#endif
+#ifndef APP_SPI_HIF_ENABLE
+#define APP_SPI_HIF_ENABLE            APP_FALSE
+#endif
+#ifndef APP_ENTROPY_ENABLE
+#define APP_ENTROPY_ENABLE            APP_FALSE
+#endif
+
+#endif /*__APP_COMPILE_OPTION_H*/
@@ -0,0 +1,334 @@
+/**
+ * @file    test_app_entropy.c
+ * @brief   Host test of the AppSysEntropy pool, reseeding and health tests.
+ * @details The TRNG driver is a test xorshift stream with fault injection: stuck bytes, a repeated
+ *          block, a biased source, a reseed request, driver errors and a failing KAT. Served bytes
+ *          are compared with a copy of the generated stream.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "cb_test.h"
+#include "AppSysEntropy.h"
+#include "CB_trng.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_MIRROR_SIZE    (256U * 1024U)
+#define TEST_LONG_RUN       131072U        // 4 MB served 32 bytes at a time
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+typedef enum
+{
+  TEST_TRNG_OK = 0,
+  TEST_TRNG_STUCK_BYTE,                   // 6 identical bytes: repetition count
+  TEST_TRNG_REPEAT_BLOCK,                 // Last block of the previous output: duplicate block
+  TEST_TRNG_BIASED,                       // Every other byte 0x5A: adaptive proportion
+  TEST_TRNG_RESEED_ONCE,                  // EN_CB_TRNG_RESEED, then OK
+  TEST_TRNG_BAD,                          // EN_CB_TRNG_BAD
+  TEST_TRNG_ZERO,                         // All zero
+} test_trng_mode_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static uint64_t         s_xorshift = 88172645463325252ULL;
+static uint32_t         s_tick;
+static uint8_t          s_seeded;
+static test_trng_mode_t s_mode;
+static uint8_t          s_katFail;
+static uint32_t         s_katRuns;
+static uint32_t         s_snoise;
+static uint32_t         s_resnoise;
+static uint32_t         s_lastAddin0;
+static uint32_t         s_addinRepeats;
+static uint32_t         s_previous[4];
+static uint8_t          s_mirror[TEST_MIRROR_SIZE];
+static uint32_t         s_mirrorWrite;
+static uint8_t          s_mirrorOn;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint32_t cb_hal_get_tick(void)  { return s_tick; }
+void     CB_TRNG_Init(void)     { }
+void     CB_TRNG_Deinit(void)   { s_seeded = 0; }
+
+uint32_t CB_TRNG_Snoise(const stTrngConfig* const Config)
+{
+  s_snoise++;
+  s_seeded = (Config->Alg == EN_CB_TRNG_AES256) && (Config->UseAddIn != 0);
+  return 0;
+}
+
+uint32_t CB_TRNG_ReSnoise(const stTrngConfig* const Config)
+{
+  s_resnoise++;
+  return 0;
+}
+
+uint32_t CB_TRNG_RunKat(uint32_t* const Output)
+{
+  s_katRuns++;
+  s_seeded = 0;                                        // The KAT leaves the DRBG unseeded
+  *Output  = s_katFail ? 0x10 : 0;
+  return s_katFail ? 1 : 0;
+}
+
+static uint32_t test_xorshift(void)
+{
+  s_xorshift ^= s_xorshift << 13;
+  s_xorshift ^= s_xorshift >> 7;
+  s_xorshift ^= s_xorshift << 17;
+  return (uint32_t)s_xorshift;
+}
+
+enTrngErrCode CB_TRNG_GetRngWithAddin(uint32_t* Output, uint32_t OutputSize, uint32_t const AddIn[])
+{
+  uint8_t *bytes = (uint8_t *)Output;
+
+  if (!s_seeded)
+  {
+    return EN_CB_TRNG_REJECTED;
+  }
+  s_addinRepeats += (AddIn[0] == s_lastAddin0);
+  s_lastAddin0    = AddIn[0];
+  if (s_mode == TEST_TRNG_RESEED_ONCE)
+  {
+    s_mode = TEST_TRNG_OK;
+    return EN_CB_TRNG_RESEED;
+  }
+  if (s_mode == TEST_TRNG_BAD)
+  {
+    return EN_CB_TRNG_BAD;
+  }
+  for (uint32_t i = 0; i < OutputSize; i++)
+  {
+    Output[i] = test_xorshift();
+  }
+  switch (s_mode)
+  {
+    case TEST_TRNG_STUCK_BYTE:   memset(&bytes[5], 0xAB, 6);                     break;
+    case TEST_TRNG_REPEAT_BLOCK: memcpy(Output, s_previous, sizeof(s_previous)); break;
+    case TEST_TRNG_ZERO:         memset(Output, 0, OutputSize * 4);              break;
+    case TEST_TRNG_BIASED:
+      for (uint32_t i = 0; i < (OutputSize * 4); i += 2)
+      {
+        bytes[i] = 0x5A;
+      }
+      break;
+    default:
+      break;
+  }
+  memcpy(s_previous, &Output[OutputSize - 4], sizeof(s_previous));
+  if (s_mirrorOn && ((s_mirrorWrite + (OutputSize * 4)) <= sizeof(s_mirror)))
+  {
+    memcpy(&s_mirror[s_mirrorWrite], Output, OutputSize * 4);
+    s_mirrorWrite += OutputSize * 4;
+  }
+  return EN_CB_TRNG_OK;
+}
+
+/**
+ * @brief Empties the pool 32 bytes at a time.
+ */
+static void test_drain(void)
+{
+  uint8_t buf[32];
+
+  while (app_entropy_available() > 0)
+  {
+    (void)app_entropy_get(buf, sizeof(buf));
+  }
+}
+
+static void test_pool(void)
+{
+  app_entropy_stats_t stats;
+  uint8_t  buf[APP_ENTROPY_POOL_SIZE + 44];
+  uint32_t word;
+
+  cb_test_case("init fills the pool, all or nothing, refill");
+  CB_TEST_CHECK(app_entropy_get_state() == APP_ENTROPY_STATE_OFF);
+  CB_TEST_CHECK(app_entropy_init() == APP_TRUE);
+  CB_TEST_CHECK(app_entropy_available() == APP_ENTROPY_POOL_SIZE);
+  CB_TEST_CHECK((s_katRuns == 1) && (s_snoise == 1));
+  CB_TEST_CHECK(app_entropy_get(buf, 32) == APP_TRUE);
+  CB_TEST_CHECK(app_entropy_available() == (APP_ENTROPY_POOL_SIZE - 32));
+  CB_TEST_CHECK(app_entropy_get(buf, sizeof(buf)) == APP_FALSE);
+  CB_TEST_CHECK(app_entropy_available() == (APP_ENTROPY_POOL_SIZE - 32));
+  app_entropy_get_stats(&stats);
+  CB_TEST_CHECK(stats.exhausted == 1);
+
+  CB_TEST_CHECK(app_entropy_get(buf, APP_ENTROPY_POOL_SIZE - 32) == APP_TRUE);
+  CB_TEST_CHECK(app_entropy_get_u32(&word) == APP_FALSE);
+  app_entropy_get_stats(&stats);
+  CB_TEST_CHECK((stats.lowWater == 0) && (stats.exhausted == 2));
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    app_entropy_process();
+  }
+  CB_TEST_CHECK(app_entropy_available() == (3 * APP_ENTROPY_CHUNK_WORDS * 4));
+  app_entropy_deinit();
+  CB_TEST_CHECK(app_entropy_get_state() == APP_ENTROPY_STATE_OFF);
+}
+
+static void test_order(void)
+{
+  uint8_t  buf[64];
+  uint32_t read  = 0;
+  uint32_t wrong = 0;
+
+  cb_test_case("bytes served in generation order across the ring wrap");
+  s_mirrorWrite = 0;
+  s_mirrorOn    = APP_TRUE;
+  CB_TEST_CHECK(app_entropy_init() == APP_TRUE);
+  for (uint32_t i = 0; (i < 8000) && (s_mirrorWrite < (sizeof(s_mirror) - 64)); i++)
+  {
+    uint32_t len = 1 + ((i * 7) % 61);
+    if (app_entropy_get(buf, len) == APP_TRUE)
+    {
+      wrong += (memcmp(buf, &s_mirror[read], len) != 0);
+      read  += len;
+    }
+    app_entropy_process();
+  }
+  s_mirrorOn = APP_FALSE;
+  printf("served %u bytes\n", read);
+  CB_TEST_CHECK((read > (100U * APP_ENTROPY_POOL_SIZE)) && (wrong == 0));
+}
+
+static void test_long_run(void)
+{
+  app_entropy_stats_t stats;
+  uint8_t  buf[32];
+  uint32_t refused = 0;
+  uint32_t resnoise;
+  uint32_t available;
+
+  cb_test_case("no false alarm over 4 MB, reseed by bytes, time and request");
+  CB_TEST_CHECK(app_entropy_init() == APP_TRUE);
+  for (uint32_t i = 0; i < TEST_LONG_RUN; i++)
+  {
+    app_entropy_process();
+    refused += (app_entropy_get(buf, sizeof(buf)) != APP_TRUE);
+  }
+  app_entropy_get_stats(&stats);
+  printf("generated %u served %u reseeds %u rct %u apt %u dup %u err %u\n", stats.generated, stats.served,
+         stats.reseeds, stats.rctFailures, stats.aptFailures, stats.dupFailures, stats.trngErrors);
+  CB_TEST_CHECK(refused == 0);
+  CB_TEST_CHECK((stats.rctFailures == 0) && (stats.aptFailures == 0) && (stats.dupFailures == 0) && (stats.trngErrors == 0));
+  CB_TEST_CHECK(stats.reseeds == (stats.generated / APP_ENTROPY_RESEED_BYTES));
+
+  resnoise = s_resnoise;
+  s_tick  += APP_ENTROPY_RESEED_MS;
+  (void)app_entropy_get(buf, sizeof(buf));
+  app_entropy_process();
+  CB_TEST_CHECK(s_resnoise == (resnoise + 1));
+
+  // The refused chunk is generated again after the reseed
+  resnoise  = s_resnoise;
+  s_mode    = TEST_TRNG_RESEED_ONCE;
+  (void)app_entropy_get(buf, sizeof(buf));
+  (void)app_entropy_get(buf, sizeof(buf));
+  available = app_entropy_available();
+  app_entropy_process();
+  CB_TEST_CHECK((s_resnoise == (resnoise + 1)) && (app_entropy_available() == available));
+  app_entropy_process();
+  CB_TEST_CHECK(app_entropy_available() == (available + (APP_ENTROPY_CHUNK_WORDS * 4)));
+  CB_TEST_CHECK(s_addinRepeats == 0);
+}
+
+static void test_health(void)
+{
+  static const test_trng_mode_t modes[] = { TEST_TRNG_STUCK_BYTE, TEST_TRNG_REPEAT_BLOCK };
+  app_entropy_stats_t stats;
+  uint8_t  buf[32];
+  uint32_t katRuns;
+
+  cb_test_case("failed chunk discarded, TRNG recovered, pool running");
+  for (uint8_t m = 0; m < (sizeof(modes) / sizeof(modes[0])); m++)
+  {
+    test_drain();
+    katRuns = s_katRuns;
+    s_mode  = modes[m];
+    app_entropy_process();
+    s_mode  = TEST_TRNG_OK;
+    CB_TEST_CHECK((app_entropy_available() == 0) && (s_katRuns == (katRuns + 1)));
+    CB_TEST_CHECK(app_entropy_get_state() == APP_ENTROPY_STATE_RUNNING);
+    app_entropy_process();
+    CB_TEST_CHECK(app_entropy_available() == (APP_ENTROPY_CHUNK_WORDS * 4));
+  }
+  app_entropy_get_stats(&stats);
+  CB_TEST_CHECK((stats.rctFailures == 1) && (stats.dupFailures == 1) && (stats.aptFailures == 0));
+
+  // A biased source passes chunk by chunk until a window is full
+  s_mode = TEST_TRNG_BIASED;
+  for (uint8_t i = 0; (i < 40) && (stats.aptFailures == 0); i++)
+  {
+    (void)app_entropy_get(buf, sizeof(buf));
+    app_entropy_process();
+    app_entropy_get_stats(&stats);
+  }
+  s_mode = TEST_TRNG_OK;
+  CB_TEST_CHECK(stats.aptFailures == 1);
+  CB_TEST_CHECK(app_entropy_get_state() == APP_ENTROPY_STATE_RUNNING);
+}
+
+static void test_failures(void)
+{
+  app_entropy_stats_t stats;
+  uint8_t buf[32];
+
+  cb_test_case("persistent failure, KAT failure and driver errors stop the pool");
+  s_mode = TEST_TRNG_ZERO;
+  for (uint8_t i = 0; i < 10; i++)
+  {
+    (void)app_entropy_get(buf, sizeof(buf));
+    app_entropy_process();
+  }
+  s_mode = TEST_TRNG_OK;
+  CB_TEST_CHECK(app_entropy_get_state() == APP_ENTROPY_STATE_FAILED);
+  CB_TEST_CHECK(app_entropy_available() == 0);
+  CB_TEST_CHECK(app_entropy_get(buf, 1) == APP_FALSE);
+
+  CB_TEST_CHECK(app_entropy_init() == APP_TRUE);
+  CB_TEST_CHECK(app_entropy_run_kat() == APP_TRUE);
+  CB_TEST_CHECK(app_entropy_available() == APP_ENTROPY_POOL_SIZE);
+  s_katFail = APP_TRUE;
+  CB_TEST_CHECK(app_entropy_run_kat() == APP_FALSE);
+  CB_TEST_CHECK((app_entropy_get_state() == APP_ENTROPY_STATE_FAILED) && (app_entropy_available() == 0));
+  CB_TEST_CHECK(app_entropy_init() == APP_FALSE);
+  s_katFail = APP_FALSE;
+
+  CB_TEST_CHECK(app_entropy_init() == APP_TRUE);
+  s_mode = TEST_TRNG_BAD;
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    (void)app_entropy_get(buf, sizeof(buf));
+    app_entropy_process();
+  }
+  s_mode = TEST_TRNG_OK;
+  app_entropy_get_stats(&stats);
+  CB_TEST_CHECK((stats.trngErrors == APP_ENTROPY_FAIL_MAX) && (stats.state == APP_ENTROPY_STATE_FAILED));
+  app_entropy_deinit();
+  CB_TEST_CHECK(app_entropy_get_state() == APP_ENTROPY_STATE_OFF);
+}
+
+int main(void)
+{
+  test_pool();
+  test_order();
+  test_long_run();
+  test_health();
+  test_failures();
+  return cb_test_result();
+}
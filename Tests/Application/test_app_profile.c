@@ -0,0 +1,239 @@
+/**
+ * @file    test_app_profile.c
+ * @brief   Host test of the AppSysProfile interrupt, region and cycle counter accounting.
+ * @details The DWT cycle counter is g_cbTestDwt.CYCCNT of the CMSIS stub: each stub handler and
+ *          region advances it by a set number of cycles. The results are read back from the
+ *          lines printed by app_prof_dump().
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdarg.h>
+#include <string.h>
+#include "cb_test.h"
+#include "AppSysProfile.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_DUMP_SIZE      8192
+#define TEST_NAME_WIDTH     40        // %-40s of the dump
+
+//-------------------------------
+// ENUM SECTION
+//-------------------------------
+#define TEST_IRQ_ENUM(handler)  TEST_IRQ_##handler,
+enum
+{
+  APP_PROF_IRQ_LIST(TEST_IRQ_ENUM)
+  TEST_IRQ_NUM
+};
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  uint32_t calls;
+  uint32_t us;
+  uint32_t avg;
+  uint32_t min;
+  uint32_t max;
+} test_line_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static uint32_t s_cost[TEST_IRQ_NUM];              // Cycles before and after the nested handler
+static void   (*s_nested[TEST_IRQ_NUM])(void);     // Wrapper of the handler preempting this one
+static char     s_dump[TEST_DUMP_SIZE];
+static uint32_t s_dumpLen;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+void app_uart_printf(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  s_dumpLen += (uint32_t)vsnprintf(&s_dump[s_dumpLen], sizeof(s_dump) - s_dumpLen, format, args);
+  va_end(args);
+}
+
+static void test_handler(uint32_t index)
+{
+  g_cbTestDwt.CYCCNT += s_cost[index];
+  if (s_nested[index] != NULL)
+  {
+    s_nested[index]();
+    g_cbTestDwt.CYCCNT += s_cost[index];
+  }
+}
+
+#define TEST_IRQ_HANDLER(handler)  void handler(void) { test_handler(TEST_IRQ_##handler); }
+APP_PROF_IRQ_LIST(TEST_IRQ_HANDLER)
+
+static void test_region_work(uint32_t cycles)
+{
+  APP_PROF_REGION_BEGIN(work);
+  g_cbTestDwt.CYCCNT += cycles;
+  APP_PROF_REGION_END(work);
+}
+
+static void test_region_other(void)
+{
+  APP_PROF_REGION_BEGIN(other);
+  g_cbTestDwt.CYCCNT += 7;
+  APP_PROF_REGION_END(other);
+}
+
+static void test_dump(uint8_t reset)
+{
+  s_dumpLen = 0;
+  s_dump[0] = '\0';
+  app_prof_dump(reset);
+}
+
+/**
+ * @brief Finds the dump line of a handler or region.
+ *
+ * @return Number of lines with this name.
+ */
+static uint32_t test_find(const char *name, test_line_st *p_line)
+{
+  uint32_t found = 0;
+  size_t   len   = strlen(name);
+  uint32_t share;
+  uint32_t shareTenth;
+
+  for (const char *line = s_dump; (line != NULL) && (*line != '\0'); line = strchr(line, '\n'), line = (line != NULL) ? (line + 1) : NULL)
+  {
+    if ((strncmp(line, name, len) == 0) && (line[len] == ' ') &&
+        (sscanf(line + TEST_NAME_WIDTH, "%u %u %u.%u %u %u %u", &p_line->calls, &p_line->us, &share, &shareTenth,
+                &p_line->avg, &p_line->min, &p_line->max) == 7))
+    {
+      found++;
+    }
+  }
+  return found;
+}
+
+static void test_init(void)
+{
+  cb_test_case("init enables the cycle counter");
+  memset(&g_cbTestDwt, 0, sizeof(g_cbTestDwt));
+  memset(&g_cbTestCoreDebug, 0, sizeof(g_cbTestCoreDebug));
+  g_cbTestDwt.CYCCNT = 0xFFFFF000U;
+  app_prof_init();
+  CB_TEST_CHECK((g_cbTestDwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0);
+  CB_TEST_CHECK((g_cbTestCoreDebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) != 0);
+  CB_TEST_CHECK(g_cbTestDwt.CYCCNT == 0xFFFFF000U);    // Not cleared: other users take differences
+}
+
+static void test_nested_interrupts(void)
+{
+  test_line_st line;
+
+  cb_test_case("nested interrupts charged their own time");
+  app_prof_reset();
+  // gpio preempted by timer 0, itself preempted by uart 0
+  s_cost[TEST_IRQ_cb_gpio_irqhandler]    = 5;
+  s_nested[TEST_IRQ_cb_gpio_irqhandler]  = app_prof_cb_timer_0_irqhandler;
+  s_cost[TEST_IRQ_cb_timer_0_irqhandler] = 10;
+  s_nested[TEST_IRQ_cb_timer_0_irqhandler] = app_prof_cb_uart_0_irqhandler;
+  s_cost[TEST_IRQ_cb_uart_0_irqhandler]  = 50;
+  s_cost[TEST_IRQ_cb_dma_irqhandler]     = 100;
+
+  g_cbTestPrimask = 0;
+  app_prof_cb_gpio_irqhandler();
+  app_prof_cb_dma_irqhandler();
+  g_cbTestPrimask = 1;
+  app_prof_cb_dma_irqhandler();
+  CB_TEST_CHECK(g_cbTestPrimask == 1);                 // PRIMASK restored, not cleared
+  g_cbTestPrimask = 0;
+  s_cost[TEST_IRQ_cb_dma_irqhandler]     = 300;
+  app_prof_cb_dma_irqhandler();
+
+  test_dump(APP_FALSE);
+  CB_TEST_CHECK(g_cbTestPrimask == 0);
+  CB_TEST_CHECK((test_find("cb_gpio_irqhandler", &line) == 1) && (line.calls == 1) && (line.max == 10));
+  CB_TEST_CHECK((test_find("cb_timer_0_irqhandler", &line) == 1) && (line.calls == 1) && (line.max == 20));
+  CB_TEST_CHECK((test_find("cb_uart_0_irqhandler", &line) == 1) && (line.calls == 1) && (line.max == 50));
+  CB_TEST_CHECK((test_find("cb_dma_irqhandler", &line) == 1) && (line.calls == 3) &&
+                (line.min == 100) && (line.max == 300) && (line.avg == 166));
+  CB_TEST_CHECK(test_find("cb_spi_irqhandler", &line) == 0);   // Never called: not printed
+  CB_TEST_CHECK((test_find("all interrupts", &line) == 1) && (line.calls == 6) &&
+                (line.min == 10) && (line.max == 300));
+  memset(s_nested, 0, sizeof(s_nested));
+}
+
+static void test_regions(void)
+{
+  test_line_st line;
+
+  cb_test_case("regions linked once, min/avg/max");
+  for (uint32_t i = 1; i <= 4; i++)
+  {
+    test_region_work(i * 1000);
+  }
+  test_region_other();
+  test_region_other();
+  test_dump(APP_FALSE);
+  CB_TEST_CHECK((test_find("work", &line) == 1) && (line.calls == 4) &&
+                (line.avg == 2500) && (line.min == 1000) && (line.max == 4000));
+  CB_TEST_CHECK((test_find("other", &line) == 1) && (line.calls == 2) && (line.avg == 7));
+}
+
+static void test_counter_wrap(void)
+{
+  uint64_t before;
+  uint64_t after;
+
+  cb_test_case("64-bit cycle count across 32-bit wraps");
+  g_cbTestDwt.CYCCNT = 0xFFFFFF00U;
+  before = app_prof_cycles64();
+  g_cbTestDwt.CYCCNT += 0x200U;
+  after = app_prof_cycles64();
+  CB_TEST_CHECK((after - before) == 0x200U);
+  CB_TEST_CHECK(after > 0xFFFFFFFFULL);
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    g_cbTestDwt.CYCCNT += 0x80000000U;
+    (void)app_prof_cycles64();
+  }
+  CB_TEST_CHECK((app_prof_cycles64() - after) == 0x300000000ULL);
+}
+
+static void test_reset_window(void)
+{
+  test_line_st line;
+  uint32_t     windowUs = 0;
+
+  cb_test_case("reset starts a new window");
+  test_dump(APP_TRUE);
+  CB_TEST_CHECK(test_find("work", &line) == 1);
+  test_region_work(5);
+  g_cbTestDwt.CYCCNT += 64000 - 5;                     // 1 ms at 64 MHz
+  test_dump(APP_FALSE);
+  CB_TEST_CHECK(sscanf(s_dump, "profile: window %u us", &windowUs) == 1);
+  CB_TEST_CHECK(windowUs == 1000);
+  CB_TEST_CHECK((test_find("work", &line) == 1) && (line.calls == 1) && (line.min == 5) && (line.max == 5));
+  CB_TEST_CHECK(test_find("other", &line) == 0);
+  CB_TEST_CHECK(test_find("cb_dma_irqhandler", &line) == 0);
+  CB_TEST_CHECK(test_find("all interrupts", &line) == 0);
+}
+
+int main(void)
+{
+  test_init();
+  test_nested_interrupts();
+  test_regions();
+  test_counter_wrap();
+  test_reset_window();
+  return cb_test_result();
+}
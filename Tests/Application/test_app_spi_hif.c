@@ -0,0 +1,359 @@
+/**
+ * @file    test_app_spi_hif.c
+ * @brief   Host loopback test of the app_spi_hif frame exchange, record stream and registers.
+ * @details app_spi_hif.c is built into the test with the SPI slave, GPIO and cycle counter as
+ *          test variables. A host model clocks whole transactions: it copies the armed slave
+ *          frame out, its request into the receive buffer and runs the SDMA completion callback.
+ *          Its CRC is a bitwise CRC-16/CCITT-FALSE, independent of LibCRC. The record stream
+ *          must arrive complete and in order with slave frames lost and requests corrupted.
+ *          The cycle counts are those of the model, not of the chip.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+
+static uint32_t s_cycles;
+#define APP_HIF_CYCLES()        (s_cycles)
+#include "app_spi_hif.c"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_STREAM_MAX     (1 << 20)
+#define TEST_ROUNDS         1200        // 3 cycles of a ranging and an AoA record each
+#define TEST_LOSS_PCT       10
+#define TEST_XFER_CYCLES    (APP_HIF_XFER_SIZE * 8 * 4)   // 16 MHz SCK, 64 MHz CPU
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static uint32_t           s_now;
+static spi_completecallbk s_armCallback;
+static uint8_t            s_armed;
+static uint32_t           s_armErrors;
+static uint32_t           s_stops;
+static uint16_t           s_rxCount;
+static uint8_t            s_drdy;
+
+// Host model
+static uint16_t            s_hostExpected;
+static uint8_t             s_hostStream[TEST_STREAM_MAX];
+static uint32_t            s_hostLen;
+static uint8_t             s_hostSeq;
+static app_hif_slave_hdr_t s_last;
+static uint8_t             s_lastPayload[APP_HIF_PAYLOAD_SIZE];
+static uint8_t             s_lastOk;
+static uint32_t            s_frameErrors;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint32_t  cb_hal_get_tick(void)                                 { return s_now; }
+void      cb_spi_init(stSPI_InitTypeDef *InitParameters)        { }
+void      cb_spi_stop(void)                                     { s_armed = 0; s_stops++; }
+uint16_t  cb_spi_get_sdma_rx_count(void)                        { return s_rxCount; }
+void      cb_gpio_init(stGPIO_InitTypeDef* GPIO_Init)           { }
+void      cb_gpio_write_pin(enGpioPin GPIO_Pin, enGPIO_PinState PinState) { s_drdy = (PinState == EN_GPIO_PIN_SET); }
+void      cb_iomux_config(enIomuxGpioSelect enGpio, stIomuxGpioMode* GpioModeSet) { }
+void      cb_scr_gpio_module_on(void)                           { }
+
+CB_STATUS cb_spi_slave_sdma_start(uint16_t Length, uint32_t TxBufAddr, uint32_t RxBufAddr, spi_completecallbk p_CompletionCB)
+{
+  s_armErrors  += (Length != APP_HIF_XFER_SIZE) || s_armed;
+  s_armCallback = p_CompletionCB;
+  s_armed       = 1;
+  s_rxCount     = 0;
+  return CB_PASS;
+}
+
+void app_uart_printf(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+}
+
+static uint16_t test_crc(const uint8_t *data, uint32_t size)
+{
+  uint16_t crc = 0xFFFF;
+
+  while (size-- != 0)
+  {
+    crc ^= (uint16_t)(*data++ << 8);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief One transaction. The host ignores the slave frame if dropSlave, corrupts the request
+ *        CRC if badRequest.
+ */
+static void test_xfer(uint8_t cmd, uint16_t addr, uint8_t len, const void *data, uint8_t dropSlave, uint8_t badRequest)
+{
+  uint8_t             request[APP_HIF_XFER_SIZE] = {0};
+  uint8_t             response[APP_HIF_XFER_SIZE];
+  app_hif_host_hdr_t  hdr = { APP_HIF_SYNC_HOST, cmd, ++s_hostSeq, len, addr, s_hostExpected };
+  app_hif_slave_hdr_t slave;
+  uint16_t            crc;
+
+  memcpy(&request[1], &hdr, APP_HIF_HEADER_SIZE);
+  if (cmd == APP_HIF_CMD_WRITE)
+  {
+    memcpy(&request[1 + APP_HIF_HEADER_SIZE], data, len);
+  }
+  crc = test_crc(&request[1], APP_HIF_HEADER_SIZE + ((cmd == APP_HIF_CMD_WRITE) ? len : 0));
+  crc ^= badRequest;
+  memcpy(&request[1 + APP_HIF_HEADER_SIZE + APP_HIF_PAYLOAD_SIZE], &crc, sizeof(crc));
+
+  s_frameErrors += (s_armed == 0);
+  memcpy(response, s_txBuf, APP_HIF_XFER_SIZE);
+  memcpy(s_rxBuf, request, APP_HIF_XFER_SIZE);
+  s_armed = 0;
+  s_cycles += TEST_XFER_CYCLES;
+  s_armCallback(CB_PASS);
+
+  s_lastOk = 0;
+  if (dropSlave)
+  {
+    return;
+  }
+  memcpy(&slave, &response[1], APP_HIF_HEADER_SIZE);
+  memcpy(&crc, &response[1 + APP_HIF_HEADER_SIZE + APP_HIF_PAYLOAD_SIZE], sizeof(crc));
+  if ((slave.sync != APP_HIF_SYNC_SLAVE) || (slave.len > APP_HIF_PAYLOAD_SIZE) ||
+      (crc != test_crc(&response[1], APP_HIF_HEADER_SIZE + slave.len)))
+  {
+    s_frameErrors++;
+    return;
+  }
+  s_last = slave;
+  memcpy(s_lastPayload, &response[1 + APP_HIF_HEADER_SIZE], slave.len);
+  s_lastOk = 1;
+  if ((slave.kind == APP_HIF_KIND_STREAM) && (slave.offset == s_hostExpected) && ((s_hostLen + slave.len) <= TEST_STREAM_MAX))
+  {
+    memcpy(&s_hostStream[s_hostLen], &response[1 + APP_HIF_HEADER_SIZE], slave.len);
+    s_hostLen      += slave.len;
+    s_hostExpected += slave.len;
+  }
+}
+
+static void test_nop(void)
+{
+  test_xfer(APP_HIF_CMD_NOP, 0, 0, NULL, 0, 0);
+}
+
+static uint32_t test_read(uint16_t addr)
+{
+  uint32_t value = 0xDEADBEEF;
+
+  test_xfer(APP_HIF_CMD_READ, addr, 4, NULL, 0, 0);
+  test_nop();
+  if (s_lastOk && (s_last.kind == APP_HIF_KIND_REG) && (s_last.offset == addr))
+  {
+    memcpy(&value, s_lastPayload, sizeof(value));
+  }
+  return value;
+}
+
+static uint16_t test_write(uint16_t addr, const uint32_t *values, uint8_t count)
+{
+  test_xfer(APP_HIF_CMD_WRITE, addr, (uint8_t)(4 * count), values, 0, 0);
+  test_nop();
+  return s_last.status;
+}
+
+/**
+ * @brief NOP requests until the FIFO is acknowledged and the status has no more data.
+ */
+static uint8_t test_drain(int lossPct)
+{
+  for (uint32_t guard = 0; guard < 100000; guard++)
+  {
+    test_xfer(APP_HIF_CMD_NOP, 0, 0, NULL, (rand() % 100) < lossPct, (rand() % 100) < lossPct);
+    if ((s_head == s_tail) && s_lastOk && ((s_last.status & APP_HIF_STATUS_DATA) == 0))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void test_libcrc(void)
+{
+  cb_test_case("LibCRC crc_ccitt_ffff is CRC-16/CCITT-FALSE");
+  CB_TEST_CHECK(crc_ccitt_ffff((const unsigned char *)"123456789", 9) == 0x29B1);
+  CB_TEST_CHECK(test_crc((const uint8_t *)"123456789", 9) == 0x29B1);
+}
+
+static void test_stream(void)
+{
+  uint32_t cycle   = 0;
+  uint32_t records = 0;
+  uint32_t bad     = 0;
+  uint8_t  drained = 1;
+  uint16_t seq     = 0;
+
+  cb_test_case("record stream with lost frames and corrupted requests");
+  srand(1);
+  app_hif_init();
+  CB_TEST_CHECK(test_read(APP_HIF_REG_ID) == APP_HIF_REG_ID_VALUE);
+  CB_TEST_CHECK(s_drdy == 0);
+  for (uint32_t round = 0; (round < TEST_ROUNDS) && drained; round++)
+  {
+    for (uint8_t k = 0; k < 3; k++, cycle++)
+    {
+      app_hif_rec_ranging_t ranging = { cycle, (float)cycle * 1.5f, 1, {0} };
+      app_hif_rec_aoa_t     aoa     = { 1, 2, 3, 4, 5 };
+      s_cycles += 1000;
+      bad += (app_hif_push(APP_HIF_REC_RANGING, &ranging, sizeof(ranging)) != APP_TRUE);
+      bad += (app_hif_push(APP_HIF_REC_AOA, &aoa, sizeof(aoa)) != APP_TRUE);
+    }
+    bad += (s_drdy == 0);
+    drained &= test_drain(TEST_LOSS_PCT);
+  }
+  CB_TEST_CHECK((bad == 0) && drained);
+
+  for (uint32_t p = 0; (p + sizeof(app_hif_rec_hdr_t)) <= s_hostLen; records++, seq++)
+  {
+    app_hif_rec_hdr_t     rec;
+    app_hif_rec_ranging_t ranging;
+    memcpy(&rec, &s_hostStream[p], sizeof(rec));
+    bad += (rec.seq != seq);
+    if (rec.type == APP_HIF_REC_RANGING)
+    {
+      memcpy(&ranging, &s_hostStream[p + sizeof(rec)], sizeof(ranging));
+      bad += (ranging.cycle != (rec.seq / 2U)) || (ranging.distanceCm != ((float)ranging.cycle * 1.5f));
+    }
+    p += sizeof(rec) + rec.len;
+    bad += (p > s_hostLen);
+  }
+  printf("%u records, %u bytes in %u frames, %u CRC errors, %u bytes resent\n", records, s_hostLen,
+         s_stats.frames, s_stats.crcErrors, s_stats.resentBytes);
+  CB_TEST_CHECK((bad == 0) && (records == (TEST_ROUNDS * 6U)));
+  CB_TEST_CHECK((s_stats.streamBytes == s_hostLen) && (s_stats.crcErrors != 0) && (s_stats.resentBytes != 0));
+  CB_TEST_CHECK(s_hostLen > 0x10000);                  // Across the 16-bit offset wrap
+  CB_TEST_CHECK((s_frameErrors == 0) && (s_armErrors == 0));
+}
+
+static void test_registers(void)
+{
+  uint32_t values[3] = { 0x11, 0x22, 0x33 };
+  uint32_t readOnly[2] = { 0, 0x99 };
+  uint32_t mixed[2]  = { 0xFFFFFFFF, 0 };
+
+  cb_test_case("register read, write, read-only refusal, request errors");
+  CB_TEST_CHECK((test_write(APP_HIF_REG_APP, values, 3) & APP_HIF_STATUS_CMD_ERR) == 0);
+  CB_TEST_CHECK((app_hif_get_app_reg(2) == 0x33) && (app_hif_take_app_writes() == 7) && (app_hif_take_app_writes() == 0));
+  CB_TEST_CHECK((test_write(APP_HIF_REG_FIFO_USED, readOnly, 2) & APP_HIF_STATUS_CMD_ERR) != 0);
+  // RW then RO: nothing written
+  CB_TEST_CHECK((test_write(APP_HIF_REG_RECORD_MASK, mixed, 2) & APP_HIF_STATUS_CMD_ERR) != 0);
+  CB_TEST_CHECK(test_read(APP_HIF_REG_RECORD_MASK) == 0xFFFFFFFF);
+  test_xfer(APP_HIF_CMD_READ, APP_HIF_REG_MAP_SIZE - 4, 8, NULL, 0, 0);
+  test_nop();
+  CB_TEST_CHECK((s_last.status & APP_HIF_STATUS_CMD_ERR) != 0);
+  test_xfer(APP_HIF_CMD_NOP, 0, 0, NULL, 0, 1);
+  test_nop();
+  CB_TEST_CHECK((s_last.status & APP_HIF_STATUS_CRC_ERR) != 0);
+  test_nop();
+  CB_TEST_CHECK((s_last.status & (APP_HIF_STATUS_CRC_ERR | APP_HIF_STATUS_CMD_ERR)) == 0);
+}
+
+static void test_mask_and_overflow(void)
+{
+  app_hif_rec_aoa_t aoa = {0};
+  uint8_t           big[200] = {0};
+  uint32_t          mask = ~(1U << APP_HIF_REC_AOA);
+  uint32_t          control = APP_HIF_CONTROL_CLEAR | APP_HIF_CONTROL_STREAM | APP_HIF_CONTROL_DRDY;
+  uint32_t          pushed = 0;
+
+  cb_test_case("record mask, FIFO overflow and clear");
+  test_write(APP_HIF_REG_RECORD_MASK, &mask, 1);
+  CB_TEST_CHECK(app_hif_push(APP_HIF_REC_AOA, &aoa, sizeof(aoa)) == APP_FALSE);
+  mask = 0xFFFFFFFF;
+  test_write(APP_HIF_REG_RECORD_MASK, &mask, 1);
+
+  while (app_hif_push(APP_HIF_REC_APP, big, sizeof(big)) == APP_TRUE)
+  {
+    pushed++;
+  }
+  CB_TEST_CHECK(pushed == (APP_HIF_FIFO_SIZE / (sizeof(app_hif_rec_hdr_t) + sizeof(big))));
+  test_nop();
+  test_nop();
+  CB_TEST_CHECK((s_last.status & APP_HIF_STATUS_OVERFLOW) != 0);
+  CB_TEST_CHECK(test_read(APP_HIF_REG_DROPPED) == 1);
+  test_write(APP_HIF_REG_CONTROL, &control, 1);
+  CB_TEST_CHECK((s_last.status & APP_HIF_STATUS_OVERFLOW) == 0);
+  CB_TEST_CHECK(test_read(APP_HIF_REG_CONTROL) == (APP_HIF_CONTROL_STREAM | APP_HIF_CONTROL_DRDY));
+  CB_TEST_CHECK(test_drain(0));
+}
+
+static void test_cir(void)
+{
+  cb_uwbsystem_rx_cir_iqdata_st iq[200];
+  uint32_t before  = s_hostLen;
+  uint32_t chunks  = 0;
+  uint32_t samples = 0;
+  uint32_t bad     = 0;
+
+  cb_test_case("CIR split in chunks");
+  for (int16_t i = 0; i < 200; i++)
+  {
+    iq[i].I_data = i;
+    iq[i].Q_data = (int16_t)-i;
+  }
+  CB_TEST_CHECK(app_hif_push_cir(1, 100, iq, 200) == 200);
+  CB_TEST_CHECK(test_drain(0));
+  for (uint32_t p = before; p < s_hostLen; chunks++)
+  {
+    app_hif_rec_hdr_t             rec;
+    app_hif_rec_cir_t             cir;
+    cb_uwbsystem_rx_cir_iqdata_st first;
+    memcpy(&rec, &s_hostStream[p], sizeof(rec));
+    memcpy(&cir, &s_hostStream[p + sizeof(rec)], sizeof(cir));
+    memcpy(&first, &s_hostStream[p + sizeof(rec) + sizeof(cir)], sizeof(first));
+    bad += (rec.type != APP_HIF_REC_CIR) || (cir.port != 1) || (cir.firstIndex != (100 + samples)) || (first.I_data != (int16_t)samples);
+    samples += cir.count;
+    p += sizeof(rec) + rec.len;
+  }
+  CB_TEST_CHECK((bad == 0) && (samples == 200) && (chunks == ((200 + APP_HIF_CIR_CHUNK - 1) / APP_HIF_CIR_CHUNK)));
+}
+
+static void test_stall(void)
+{
+  cb_test_case("transfer stopped halfway dropped after APP_HIF_STALL_MS");
+  s_rxCount = 50;
+  app_hif_process();
+  s_now += APP_HIF_STALL_MS - 1;
+  app_hif_process();
+  CB_TEST_CHECK(s_stops == 0);
+  s_now += 1;
+  app_hif_process();
+  CB_TEST_CHECK((s_stops == 1) && s_armed && (s_stats.aborts == 1));
+  test_nop();
+  CB_TEST_CHECK(s_lastOk);
+  app_hif_dump_stats(APP_FALSE);
+}
+
+int main(void)
+{
+  test_libcrc();
+  test_stream();
+  test_registers();
+  test_mask_and_overflow();
+  test_cir();
+  test_stall();
+  return cb_test_result();
+}
@@ -0,0 +1,227 @@
+/**
+ * @file    test_app_supervisor.c
+ * @brief   Host test of the AppSysSupervisor deadlines, watchdog feeding and fault record.
+ * @details AppSysSupervisor.c is built into the test. The tick and the watchdog driver are test
+ *          variables; a reset is modelled by clearing the supervisor RAM except the no-init
+ *          record, and the watchdog NMI by calling app_sup_nmi_capture() with a stacked frame.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdarg.h>
+#include <string.h>
+#include "cb_test.h"
+
+#define APP_SUP_NOINIT          // Host: plain static, cleared by test_reset() only
+#include "AppSysSupervisor.c"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_WDT_MS         1000
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static uint32_t    s_now;
+static uint8_t     s_wdtRunning;
+static uint32_t    s_wdtInit;
+static uint32_t    s_wdtEnable;
+static uint32_t    s_wdtRefresh;
+static stWdtConfig s_wdtConfig;
+static uint32_t    s_frame[8] = { 0, 1, 2, 3, 12, 0x1111, 0x2222, 0x01000000 };
+static uint32_t    s_printed;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint32_t cb_hal_get_tick(void)                   { return s_now; }
+void     cb_wdt_init(const stWdtConfig* const Config) { s_wdtConfig = *Config; s_wdtInit++; }
+void     cb_wdt_enable(void)                     { s_wdtEnable++; }
+void     cb_wdt_refresh(void)                    { s_wdtRefresh++; }
+uint8_t  cb_wdt_is_running(void)                 { return s_wdtRunning; }
+
+void app_uart_printf(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  s_printed++;
+}
+
+/**
+ * @brief Watchdog reset: the RAM of the supervisor is lost, s_record is kept.
+ */
+static void test_reset(void)
+{
+  memset(s_client, 0xA5, sizeof(s_client));
+  memset(s_trace, 0xA5, sizeof(s_trace));
+  s_traceNext   = 77;
+  s_traceCount  = 77;
+  memset(&s_lastFault, 0, sizeof(s_lastFault));
+  s_lastFaultValid = APP_FALSE;
+  s_state       = APP_SUP_STATE_IDLE;
+  s_offender    = APP_SUP_ID_NONE;
+  s_wdtInit     = 0;
+  s_wdtEnable   = 0;
+  s_wdtRefresh  = 0;
+}
+
+static void test_register(void)
+{
+  app_sup_fault_t fault;
+
+  cb_test_case("power on, registration limits");
+  memset(&s_record, 0x5C, sizeof(s_record));         // Power-on content
+  s_now = 1000;
+  app_sup_init(TEST_WDT_MS);
+  CB_TEST_CHECK(app_sup_get_fault(&fault) == APP_FALSE);
+  CB_TEST_CHECK(app_sup_register("zero", 0) == APP_SUP_ID_NONE);
+  CB_TEST_CHECK(app_sup_register("wdt", TEST_WDT_MS) == APP_SUP_ID_NONE);
+  CB_TEST_CHECK(app_sup_register("late", TEST_WDT_MS + 1) == APP_SUP_ID_NONE);
+  for (uint8_t i = 0; i < APP_SUP_CLIENT_MAX; i++)
+  {
+    CB_TEST_CHECK(app_sup_register("c", TEST_WDT_MS - 1) == i);
+  }
+  CB_TEST_CHECK(app_sup_register("c", 10) == APP_SUP_ID_NONE);
+}
+
+static void test_expiry(void)
+{
+  app_sup_fault_t fault;
+  uint8_t         radio;
+  uint8_t         slow;
+  uint32_t        overdueMs;
+  uint32_t        refreshed;
+
+  cb_test_case("late client stops the refresh, record over the reset");
+  test_reset();
+  s_now = 1000;
+  app_sup_init(TEST_WDT_MS);
+  radio = app_sup_register("radio", 100);
+  slow  = app_sup_register("averylongname", 300);
+  CB_TEST_CHECK((radio == 0) && (slow == 1));
+
+  // RC calibration owns the watchdog; the NMI is only chained before the supervisor runs
+  s_wdtRunning = APP_TRUE;
+  CB_TEST_CHECK((app_sup_service() == APP_FALSE) && (s_wdtInit == 0));
+  app_sup_nmi_capture(s_frame);
+  CB_TEST_CHECK(s_record.magic != APP_SUP_MAGIC);
+  s_wdtRunning = APP_FALSE;
+  CB_TEST_CHECK((app_sup_service() == APP_TRUE) && (s_wdtInit == 1) && (s_wdtEnable == 1) && (s_wdtRefresh == 1));
+  CB_TEST_CHECK((s_wdtConfig.WdtMode == EN_WDT_RESET) && (s_wdtConfig.Interval == TEST_WDT_MS) &&
+                (s_wdtConfig.GraceAfterInt == APP_SUP_WDT_GRACE_MS) && (s_wdtConfig.WdtRunInSleep == 0));
+
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    s_now += 50;
+    app_sup_checkin(radio, 3);
+    app_sup_checkin(slow, 7);
+    CB_TEST_CHECK(app_sup_service() == APP_TRUE);
+  }
+  // Suspended: not supervised; resumed: its deadline restarts
+  app_sup_suspend(slow);
+  for (uint8_t i = 0; i < 10; i++)
+  {
+    s_now += 90;
+    app_sup_checkin(radio, 5);
+    CB_TEST_CHECK(app_sup_service() == APP_TRUE);
+  }
+  app_sup_resume(slow);
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    s_now += 90;
+    app_sup_checkin(radio, 5);
+    (void)app_sup_service();
+  }
+  CB_TEST_CHECK(s_offender == slow);
+  overdueMs = s_offenderOverdueMs;
+  CB_TEST_CHECK((overdueMs > 0) && (overdueMs <= 90));
+
+  // Latched: a late check-in does not restart the refresh
+  app_sup_checkin(slow, 8);
+  refreshed = s_wdtRefresh;
+  CB_TEST_CHECK((app_sup_service() == APP_FALSE) && (s_wdtRefresh == refreshed));
+  app_sup_mark(slow, 9);
+  s_now += TEST_WDT_MS;
+  app_sup_nmi_capture(s_frame);
+  CB_TEST_CHECK((s_record.magic == APP_SUP_MAGIC) && (s_state == APP_SUP_STATE_IDLE));
+
+  test_reset();
+  s_now = 5;
+  app_sup_init(TEST_WDT_MS);
+  CB_TEST_CHECK(app_sup_get_fault(&fault) == APP_TRUE);
+  CB_TEST_CHECK((fault.id == slow) && (fault.resets == 1) && (fault.overdueMs == overdueMs));
+  CB_TEST_CHECK((fault.pc == 0x2222) && (fault.lr == 0x1111) && (fault.xpsr == 0x01000000));
+  CB_TEST_CHECK(strcmp(fault.name, "averylongna") == 0);
+  CB_TEST_CHECK((fault.trace[7].id == slow) && (fault.trace[7].mark == 9) && (fault.trace[6].mark == 8));
+  CB_TEST_CHECK((fault.trace[5].id == radio) && (fault.trace[5].mark == 5) && (fault.trace[5].count == 15));
+  s_printed = 0;
+  app_sup_report();
+  CB_TEST_CHECK(s_printed == 2 + APP_SUP_TRACE_DEPTH);
+}
+
+static void test_stuck_client(void)
+{
+  app_sup_fault_t fault;
+  uint8_t         id;
+
+  cb_test_case("client stuck with the service: named, not the service");
+  // The record of test_expiry was taken: this is the second reset in a row
+  id = app_sup_register("stuck", TEST_WDT_MS - 250);
+  CB_TEST_CHECK(app_sup_service() == APP_TRUE);
+  app_sup_checkin(id, 1);
+  s_now += TEST_WDT_MS;                               // Neither check-in nor service
+  app_sup_nmi_capture(s_frame);
+  test_reset();
+  app_sup_init(TEST_WDT_MS);
+  CB_TEST_CHECK(app_sup_get_fault(&fault) == APP_TRUE);
+  CB_TEST_CHECK((fault.id == id) && (fault.resets == 2) && (fault.overdueMs == 250));
+}
+
+static void test_service_stopped(void)
+{
+  app_sup_fault_t fault;
+
+  cb_test_case("service stopped, record taken once, corrupted record");
+  CB_TEST_CHECK(app_sup_service() == APP_TRUE);
+  s_now += 700;
+  s_frame[7] = 0x01000003;                            // HardFault
+  app_sup_nmi_capture(s_frame);
+  test_reset();
+  app_sup_init(TEST_WDT_MS);
+  CB_TEST_CHECK(app_sup_get_fault(&fault) == APP_TRUE);
+  CB_TEST_CHECK((fault.id == APP_SUP_ID_NONE) && (fault.resets == 3) && (fault.overdueMs == 700));
+  CB_TEST_CHECK((fault.trace[0].id == APP_SUP_ID_NONE) && (fault.xpsr == 0x01000003));
+  s_printed = 0;
+  app_sup_report();
+  CB_TEST_CHECK(s_printed == 2);
+
+  // A plain reset after the report finds no record
+  test_reset();
+  app_sup_init(TEST_WDT_MS);
+  CB_TEST_CHECK(app_sup_get_fault(&fault) == APP_FALSE);
+
+  CB_TEST_CHECK(app_sup_service() == APP_TRUE);
+  s_now += 2000;
+  app_sup_nmi_capture(s_frame);
+  s_record.fault.pc ^= 4;
+  test_reset();
+  app_sup_init(TEST_WDT_MS);
+  CB_TEST_CHECK(app_sup_get_fault(&fault) == APP_FALSE);
+}
+
+int main(void)
+{
+  test_register();
+  test_expiry();
+  test_stuck_client();
+  test_service_stopped();
+  return cb_test_result();
+}
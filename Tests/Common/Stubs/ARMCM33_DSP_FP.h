@@ -0,0 +1,131 @@
+/**
+ * @file    ARMCM33_DSP_FP.h
+ * @brief   Host stub of the CMSIS device header, for the host unit tests.
+ * @details Same interrupt numbers as Components/ArmCore/ARMCM33_DSP_FP.h. The core intrinsics and
+ *          the NVIC functions only record their state in g_cbTest* (Common/cb_test.c).
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef ARMCM33_DSP_FP_H
+#define ARMCM33_DSP_FP_H
+
+#include <stdint.h>
+
+typedef enum IRQn
+{
+/* -------------------  Processor Exceptions Numbers  ----------------------------- */
+  NonMaskableInt_IRQn           = -14,     /*  2 Non Maskable Interrupt */
+  HardFault_IRQn                = -13,     /*  3 HardFault Interrupt */
+  MemoryManagement_IRQn         = -12,     /*  4 Memory Management Interrupt */
+  BusFault_IRQn                 = -11,     /*  5 Bus Fault Interrupt */
+  UsageFault_IRQn               = -10,     /*  6 Usage Fault Interrupt */
+  SecureFault_IRQn              =  -9,     /*  7 Secure Fault Interrupt */
+  SVCall_IRQn                   =  -5,     /* 11 SV Call Interrupt */
+  DebugMonitor_IRQn             =  -4,     /* 12 Debug Monitor Interrupt */
+  PendSV_IRQn                   =  -2,     /* 14 Pend SV Interrupt */
+  SysTick_IRQn                  =  -1,     /* 15 System Tick Interrupt */
+
+/* -------------------  Processor Interrupt Numbers  ------------------------------ */
+  Interrupt0_IRQn               =   0,
+  Interrupt1_IRQn               =   1,
+  DMA_IRQn                      =   2,
+  CRYPTO_IRQn                   =   3,
+  PKA_IRQn                      =   4,
+  TRNG_IRQn                     =   5,
+  CRC_IRQn                      =   6,
+  GPIO_IRQn                     =   7,
+  SPI_IRQn                      =   8,
+  UART0_IRQn                    =   9,
+  UART1_IRQn                    =   10,
+  I2C_IRQn                      =   11,
+  TIMER_0_IRQn                  =   12,
+  TIMER_1_IRQn                  =   13,
+  TIMER_2_IRQn                  =   14,
+  TIMER_3_IRQn                  =   15,
+  Interrupt16_IRQn              =   16,
+  Interrupt17_IRQn              =   17,
+  BLE_IRQn                      =   18,
+  Interrupt19_IRQn              =   19,  
+  Interrupt20_IRQn              =   20,
+  UWB_RX0_DONE_IRQn             =   21, //- RXMASK[0]
+  UWB_RX0_PD_DONE_IRQn          =   22, //- RXMASK[1]
+  UWB_RX0_SFD_DET_DONE_IRQn     =   23, //- RXMASK[2]
+  UWB_RX1_DONE_IRQn             =   24, //- RXMASK[3]
+  UWB_RX1_PD_DONE_IRQn          =   25, //- RXMASK[4]
+  UWB_RX1_SFD_DET_DONE_IRQn     =   26, //- RXMASK[5]
+  UWB_RX2_DONE_IRQn             =   27, //- RXMASK[6]
+  UWB_RX2_PD_DONE_IRQn          =   28, //- RXMASK[7]
+  UWB_RX2_SFD_DET_DONE_IRQn     =   29, //- RXMASK[8]
+  UWB_RX_STS_CIR_END_IRQn       =   30, //- RXMASK[9]
+  UWB_RX_PHR_DETECTED_IRQn      =   31, //- RXMASK[10]
+  UWB_RX_DONE_IRQn              =   32, //- RXMASK[11]
+  UWB_TX_DONE_IRQn              =   33, //- TXMASK[0]
+  UWB_TX_SFD_MARK_IRQn          =   34, //- TXMASK[1] 
+  Interrupt35_IRQn              =   35, 
+  Interrupt36_IRQn              =   36, 
+  Interrupt37_IRQn              =   37, 
+  Interrupt38_IRQn              =   38   
+  /* Interrupts 39 .. 480 are left out */
+} IRQn_Type;
+
+#define __NVIC_PRIO_BITS          3U
+
+#define __WEAK                    __attribute__((weak))
+#define __STATIC_INLINE           static inline
+#define __ALIGNED(x)              __attribute__((aligned(x)))
+#define __PACKED                  __attribute__((packed))
+#define __IO                      volatile
+#define __I                       volatile const
+#define __O                       volatile
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t CYCCNT;
+  __IO uint32_t CPICNT;
+  __IO uint32_t EXCCNT;
+  __IO uint32_t SLEEPCNT;
+  __IO uint32_t LSUCNT;
+  __IO uint32_t FOLDCNT;
+} DWT_Type;
+
+typedef struct
+{
+  __IO uint32_t DHCSR;
+  __O  uint32_t DCRSR;
+  __IO uint32_t DCRDR;
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk        (1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk    (1UL << 24)
+
+extern DWT_Type       g_cbTestDwt;
+extern CoreDebug_Type g_cbTestCoreDebug;
+#define DWT                       (&g_cbTestDwt)
+#define CoreDebug                 (&g_cbTestCoreDebug)
+
+extern uint32_t SystemCoreClock;          // system_ARMCM33.h, defined by the tests that use it
+extern uint32_t g_cbTestPrimask;
+extern uint32_t g_cbTestIrqEnabled[2];
+extern uint32_t g_cbTestIrqPending[2];
+extern uint8_t  g_cbTestIrqPriority[64];
+
+static inline uint32_t __get_PRIMASK(void)               { return g_cbTestPrimask; }
+static inline void     __set_PRIMASK(uint32_t priMask)   { g_cbTestPrimask = priMask & 1U; }
+static inline void     __disable_irq(void)               { g_cbTestPrimask = 1U; }
+static inline void     __enable_irq(void)                { g_cbTestPrimask = 0U; }
+static inline void     __NOP(void)                       { }
+static inline void     __DSB(void)                       { }
+static inline void     __ISB(void)                       { }
+static inline void     __DMB(void)                       { }
+static inline void     __WFI(void)                       { }
+
+static inline void NVIC_EnableIRQ(IRQn_Type IRQn)        { if ((int32_t)IRQn >= 0) { g_cbTestIrqEnabled[(uint32_t)IRQn >> 5] |=  (1UL << ((uint32_t)IRQn & 31U)); } }
+static inline void NVIC_DisableIRQ(IRQn_Type IRQn)       { if ((int32_t)IRQn >= 0) { g_cbTestIrqEnabled[(uint32_t)IRQn >> 5] &= ~(1UL << ((uint32_t)IRQn & 31U)); } }
+static inline void NVIC_SetPendingIRQ(IRQn_Type IRQn)    { if ((int32_t)IRQn >= 0) { g_cbTestIrqPending[(uint32_t)IRQn >> 5] |=  (1UL << ((uint32_t)IRQn & 31U)); } }
+static inline void NVIC_ClearPendingIRQ(IRQn_Type IRQn)  { if ((int32_t)IRQn >= 0) { g_cbTestIrqPending[(uint32_t)IRQn >> 5] &= ~(1UL << ((uint32_t)IRQn & 31U)); } }
+static inline uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn) { return ((int32_t)IRQn >= 0) ? ((g_cbTestIrqEnabled[(uint32_t)IRQn >> 5] >> ((uint32_t)IRQn & 31U)) & 1U) : 0U; }
+static inline void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority) { if ((int32_t)IRQn >= 0) { g_cbTestIrqPriority[IRQn] = (uint8_t)priority; } }
+
+#endif /* ARMCM33_DSP_FP_H */
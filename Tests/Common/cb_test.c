@@ -0,0 +1,61 @@
+/**
+ * @file    cb_test.c
+ * @brief   Checks of the host unit tests, and the state of the CMSIS stubs.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "cb_test.h"
+#include "ARMCM33_DSP_FP.h"
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t g_cbTestChecks;
+uint32_t g_cbTestFailures;
+
+uint32_t g_cbTestPrimask;
+uint32_t g_cbTestIrqEnabled[2];
+uint32_t g_cbTestIrqPending[2];
+uint8_t  g_cbTestIrqPriority[64];
+DWT_Type       g_cbTestDwt;
+CoreDebug_Type g_cbTestCoreDebug;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+void cb_test_case(const char *name)
+{
+  printf("-- %s\n", name);
+}
+
+int cb_test_result(void)
+{
+  printf("%u checks, %u failed\n", g_cbTestChecks, g_cbTestFailures);
+  return (g_cbTestFailures == 0U) ? 0 : 1;
+}
+
+uint64_t cb_test_time_ns(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+void *cb_test_alloc_32bit(uint32_t size)
+{
+  void *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+  if ((buffer == MAP_FAILED) || (((uintptr_t)buffer + size) > UINT32_MAX))
+  {
+    printf("cb_test_alloc_32bit: no memory below 4 GB\n");
+    abort();
+  }
+  return buffer;
+}
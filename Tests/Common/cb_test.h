@@ -0,0 +1,72 @@
+/**
+ * @file    cb_test.h
+ * @brief   Checks of the host unit tests.
+ * @details CB_TEST_CHECK() counts and reports the failed checks, cb_test_result() ends the test:
+ *          ctest fails the test if a check failed. Timings of the host benchmarks are printed,
+ *          never checked.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_TEST_H
+#define __CB_TEST_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include <stdio.h>
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define CB_TEST_CHECK(cond)                                                         \
+  do                                                                                \
+  {                                                                                 \
+    g_cbTestChecks++;                                                               \
+    if (!(cond))                                                                    \
+    {                                                                               \
+      g_cbTestFailures++;                                                           \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);               \
+    }                                                                               \
+  } while (0)
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+extern uint32_t g_cbTestChecks;
+extern uint32_t g_cbTestFailures;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Prints a test case name.
+ */
+void cb_test_case(const char *name);
+
+/**
+ * @brief Prints the summary of the checks.
+ *
+ * @return Exit code of the test: 0 if all checks passed.
+ */
+int cb_test_result(void);
+
+/**
+ * @brief Monotonic host time, for the benchmarks.
+ *
+ * @return ns.
+ */
+uint64_t cb_test_time_ns(void);
+
+/**
+ * @brief Allocates zeroed memory with a 32-bit address.
+ *
+ * The SDMA registers and the driver configurations hold 32-bit addresses: buffers handed to a
+ * driver under test must have an address that fits in uint32_t.
+ *
+ * @param size Bytes.
+ * @return Buffer, never NULL (the test aborts).
+ */
+void *cb_test_alloc_32bit(uint32_t size);
+
+#endif /*__CB_TEST_H*/
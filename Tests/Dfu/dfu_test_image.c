@@ -0,0 +1,132 @@
+/**
+ * @file    dfu_test_image.c
+ * @brief   Application images and CRC for the DFU host tests.
+ * @details See dfu_test_image.h.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dfu_test_image.h"
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint32_t dfu_test_get32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint8_t *dfu_test_read_file(const char *path, uint32_t *p_len)
+{
+  FILE    *f = fopen(path, "rb");
+  uint8_t *data;
+  long     len;
+
+  *p_len = 0;
+  if (f == NULL)
+  {
+    printf("cannot open %s\n", path);
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  len = ftell(f);
+  rewind(f);
+  data = malloc((size_t)len + 1U);
+  *p_len = (uint32_t)fread(data, 1, (size_t)len, f);
+  fclose(f);
+  return data;
+}
+
+uint8_t *dfu_test_load_image(const char *path, uint32_t *p_len)
+{
+  uint32_t size;
+  uint8_t *file = dfu_test_read_file(path, &size);
+
+  *p_len = size;
+  if ((file == NULL) || (size < 0x34) || (memcmp(file, "\x7f" "ELF", 4) != 0))
+  {
+    return file;
+  }
+
+  uint32_t phoff     = dfu_test_get32(&file[0x1C]);
+  uint16_t phentsize = (uint16_t)(file[0x2A] | (file[0x2B] << 8));
+  uint16_t phnum     = (uint16_t)(file[0x2C] | (file[0x2D] << 8));
+  uint8_t *image     = calloc(1, DFU_TEST_IMAGE_MAX);
+  uint32_t len       = 0;
+  uint32_t lowest    = 0xFFFFFFFFUL;
+
+  // Loadable segments in address order: ROM at its offset from the lowest address (a Python slice
+  // past the end appends), then the RAM initial data, stored after the ROM by the linker
+  for (uint8_t ram = 0; ram < 2; ram++)
+  {
+    uint32_t from = 0;
+    for (uint16_t n = 0; n < phnum; n++)
+    {
+      const uint8_t *seg  = NULL;
+      uint32_t       addr = 0xFFFFFFFFUL;
+      for (uint16_t i = 0; i < phnum; i++)
+      {
+        const uint8_t *ph    = &file[phoff + ((uint32_t)i * phentsize)];
+        uint32_t       paddr = dfu_test_get32(&ph[12]);
+        if ((dfu_test_get32(&ph[0]) == 1) && (dfu_test_get32(&ph[16]) != 0) &&
+            ((paddr >= 0x20000000UL) == ram) && (paddr >= from) && (paddr < addr))
+        {
+          addr = paddr;
+          seg  = ph;
+        }
+      }
+      if (seg == NULL)
+      {
+        break;
+      }
+      uint32_t filesz = dfu_test_get32(&seg[16]);
+      uint32_t at     = len;
+      if (lowest == 0xFFFFFFFFUL)
+      {
+        lowest = addr;
+      }
+      if ((ram == 0) && ((addr - lowest) < len))
+      {
+        at = addr - lowest;
+      }
+      if ((at + filesz) <= DFU_TEST_IMAGE_MAX)
+      {
+        memcpy(&image[at], &file[dfu_test_get32(&seg[4])], filesz);
+      }
+      len  = ((at + filesz) > len) ? (at + filesz) : len;
+      from = addr + 1U;
+    }
+  }
+  free(file);
+  *p_len = len;
+  return image;
+}
+
+uint32_t dfu_test_crc32(const uint8_t *data, uint32_t len)
+{
+  static uint32_t table[256];
+  uint32_t        crc = 0xFFFFFFFFUL;
+
+  if (table[1] == 0)
+  {
+    for (uint32_t n = 0; n < 256; n++)
+    {
+      uint32_t c = n;
+      for (uint8_t k = 0; k < 8; k++)
+      {
+        c = (c >> 1) ^ (0xEDB88320UL & (0U - (c & 1U)));
+      }
+      table[n] = c;
+    }
+  }
+  for (uint32_t i = 0; i < len; i++)
+  {
+    crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xFFU];
+  }
+  return ~crc;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file    dfu_test_image.h
+ * @brief   Application images and CRC for the DFU host tests.
+ * @details Images are read as the DFU tools do (Tools/Dfu_Delta/dfu_delta.py load_image()): a .bin
+ *          as is, or the load view of the Keil .axf.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __DFU_TEST_IMAGE_H
+#define __DFU_TEST_IMAGE_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DFU_TEST_IMAGE_MAX      0x3A800   /**< FIRMWARE_BANK_SIZE of dfu_handler.c */
+#define DFU_TEST_AXF(example)   "Examples/" example "/Keil/Objects/CBU5000V210.axf"
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Read a whole file.
+ *
+ * @param path  File, relative to the SDK root.
+ * @param p_len Size read.
+ * @return Allocated content, NULL if the file cannot be opened.
+ */
+uint8_t *dfu_test_read_file(const char *path, uint32_t *p_len);
+
+/**
+ * @brief Flat image of a .bin or .axf file.
+ *
+ * @param path  File, relative to the SDK root.
+ * @param p_len Image size.
+ * @return Allocated image, NULL if the file cannot be opened.
+ */
+uint8_t *dfu_test_load_image(const char *path, uint32_t *p_len);
+
+/**
+ * @brief CRC-32 of dfu_firmware_crc_check() and of the tools (zlib.crc32).
+ */
+uint32_t dfu_test_crc32(const uint8_t *data, uint32_t len);
+
+#endif /*__DFU_TEST_IMAGE_H*/
@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+"""Write the base and new images of the test_dfu_delta backup-head case.
+
+    make_delta_overlap.py BASE NEW
+
+BASE fills the whole application bank (0x3A800 bytes, flash 0x05000..0x3F800): its last 0x1000
+bytes share the flash of the backup bank head. NEW starts with those bytes, so the best COPY
+source of its first sector is in the backup bank, erased when the update starts.
+"""
+
+import random
+import sys
+
+BANK_SIZE = 0x3A800         # FIRMWARE_BANK_SIZE of dfu_handler.c
+HEAD = 0x1000               # APP_BANK_ADDRESS + BANK_SIZE - BACKUP_BANK_ADDRESS
+
+
+def main(argv):
+    rng = random.Random(1)
+    base = bytes(rng.getrandbits(8) for _ in range(BANK_SIZE))
+    new = base[-HEAD:] + base[:0x8000]
+    with open(argv[1], 'wb') as f:
+        f.write(base)
+    with open(argv[2], 'wb') as f:
+        f.write(new)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,266 @@
+/**
+ * @file    test_dfu_abboot.c
+ * @brief   Host test of the dfu_abboot A/B bank selection, trial boot, confirmation and rollback.
+ * @details The flash is modelled by the CRC of what each bank holds (0 for a damaged or partial
+ *          image). Scenarios check the trial / confirm / rollback sequences, damaged images, the
+ *          update target and the legacy copy. Random sequences of downloads, interrupted downloads,
+ *          confirmations, bank damage and resets check that a boot always lands on an intact image
+ *          when one is recorded, and that an unconfirmed trial never boots twice.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "dfu_abboot.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_BANK_A         DFU_BANK_A_ADDRESS
+#define TEST_BANK_B         DFU_BANK_B_ADDRESS
+#define TEST_LEGACY_BACKUP  0x3E800
+#define TEST_RANDOM_RUNS    20000
+#define TEST_RANDOM_EVENTS  12
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static bootsetting_info_t s_info;
+static uint32_t           s_bankContent[2];   // CRC of the image stored in bank A / B
+static uint32_t           s_running;          // Bank of the running image, 0 in the bootloader
+static uint32_t           s_nextCrc;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint32_t *test_content(uint32_t bank)
+{
+  return &s_bankContent[(bank == TEST_BANK_B) ? 1 : 0];
+}
+
+static uint32_t test_bank_check(const bank_info_t *p_bank)
+{
+  if ((p_bank->fw_start_addr != TEST_BANK_A) && (p_bank->fw_start_addr != TEST_BANK_B))
+  {
+    return APP_FALSE;
+  }
+  return (*test_content(p_bank->fw_start_addr) == p_bank->fw_crc) ? APP_TRUE : APP_FALSE;
+}
+
+/**
+ * @brief Reset: the bootloader selects the bank and jumps to it.
+ */
+static uint32_t test_boot(void)
+{
+  uint32_t changed;
+
+  s_running = dfu_abboot_select(&s_info, test_bank_check, &changed);
+  return s_running;
+}
+
+/**
+ * @brief Download from the running image, verified and staged when complete.
+ *
+ * @return Bank written, 0 if the update is refused.
+ */
+static uint32_t test_download(uint8_t complete)
+{
+  uint32_t bank = dfu_abboot_target(&s_info, s_running);
+
+  if (bank == 0)
+  {
+    return 0;
+  }
+  *test_content(bank) = 0;
+  if (complete)
+  {
+    uint32_t crc = s_nextCrc++;
+    *test_content(bank) = crc;
+    dfu_abboot_stage(&s_info, bank, crc, 0x1000, crc);
+  }
+  return bank;
+}
+
+/**
+ * @brief Image in bank A, confirmed, bank B empty.
+ */
+static void test_fresh(void)
+{
+  memset(&s_info, 0, sizeof(s_info));
+  s_info.app_bank = (bank_info_t){ TEST_BANK_A, TEST_BANK_A, 0x1000, 1, 1, APP_TRUE };
+  s_bankContent[0] = 1;
+  s_bankContent[1] = 0;
+  s_running        = 0;
+  s_nextCrc        = 100;
+}
+
+static void test_trial_confirm_rollback(void)
+{
+  cb_test_case("trial boot, confirmation and rollback");
+  test_fresh();
+  CB_TEST_CHECK(test_boot() == TEST_BANK_A);
+  CB_TEST_CHECK(test_download(1) == TEST_BANK_B);
+  CB_TEST_CHECK(s_info.trial_state == DFU_TRIAL_PENDING);
+  CB_TEST_CHECK(test_boot() == TEST_BANK_B);
+  CB_TEST_CHECK(s_info.trial_state == DFU_TRIAL_TESTING);
+
+  // No update from an unconfirmed trial, only the trial image confirms, once
+  CB_TEST_CHECK(dfu_abboot_target(&s_info, s_running) == 0);
+  CB_TEST_CHECK(dfu_abboot_confirm(&s_info, TEST_BANK_A) == APP_FALSE);
+  CB_TEST_CHECK(dfu_abboot_confirm(&s_info, TEST_BANK_B) == APP_TRUE);
+  CB_TEST_CHECK((s_info.app_bank.fw_start_addr == TEST_BANK_B) && (s_info.backup_bank.fw_start_addr == TEST_BANK_A));
+  CB_TEST_CHECK(s_info.backup_bank.fw_active != APP_TRUE);
+  CB_TEST_CHECK(dfu_abboot_confirm(&s_info, TEST_BANK_B) == APP_FALSE);
+  CB_TEST_CHECK(test_boot() == TEST_BANK_B);
+  CB_TEST_CHECK(dfu_abboot_target(&s_info, TEST_BANK_B) == TEST_BANK_A);
+
+  // Reset during the trial: back to the confirmed image, the trial is dropped
+  CB_TEST_CHECK(test_download(1) == TEST_BANK_A);
+  CB_TEST_CHECK(test_boot() == TEST_BANK_A);
+  CB_TEST_CHECK(test_boot() == TEST_BANK_B);
+  CB_TEST_CHECK((s_info.trial_state == DFU_TRIAL_NONE) && (s_info.backup_bank.fw_active != APP_TRUE));
+  CB_TEST_CHECK(test_boot() == TEST_BANK_B);
+}
+
+static void test_damaged_images(void)
+{
+  cb_test_case("damaged and partial images");
+  // Pending image damaged before its trial
+  test_fresh();
+  test_download(1);
+  s_bankContent[1] = 0;
+  CB_TEST_CHECK(test_boot() == TEST_BANK_A);
+  CB_TEST_CHECK(s_info.trial_state == DFU_TRIAL_NONE);
+
+  // Second download interrupted while the first is pending
+  test_fresh();
+  test_download(1);
+  s_running = TEST_BANK_A;
+  CB_TEST_CHECK(test_download(0) == TEST_BANK_B);
+  CB_TEST_CHECK(test_boot() == TEST_BANK_A);
+  CB_TEST_CHECK(s_info.backup_bank.fw_active != APP_TRUE);
+
+  // Confirmed image damaged: the previous image takes over, then nothing is left
+  test_fresh();
+  test_boot();
+  test_download(1);
+  test_boot();
+  dfu_abboot_confirm(&s_info, TEST_BANK_B);
+  s_bankContent[1] = 0;
+  CB_TEST_CHECK(test_boot() == TEST_BANK_A);
+  CB_TEST_CHECK(s_info.app_bank.fw_start_addr == TEST_BANK_A);
+  s_bankContent[0] = 0;
+  CB_TEST_CHECK(test_boot() == 0);
+}
+
+static void test_target_and_legacy(void)
+{
+  uint8_t vectors[8] = {0, 0, 0, 0, 0x01, 0x41, 0x00, 0x00};
+
+  cb_test_case("update target, legacy copy, image bank check");
+  // The bootloader never writes the confirmed bank
+  test_fresh();
+  CB_TEST_CHECK(dfu_abboot_target(&s_info, 0) == TEST_BANK_B);
+  s_info.app_bank.fw_start_addr = TEST_BANK_B;
+  CB_TEST_CHECK(dfu_abboot_target(&s_info, 0) == TEST_BANK_A);
+
+  // Image staged by an application without DFU_AB_BOOT
+  test_fresh();
+  s_info.backup_bank = (bank_info_t){ TEST_BANK_A, TEST_LEGACY_BACKUP, 0x1000, 5, 2, APP_TRUE };
+  CB_TEST_CHECK(dfu_abboot_is_legacy(&s_info) == APP_TRUE);
+  s_info.backup_bank.fw_load_addr = TEST_BANK_A;
+  CB_TEST_CHECK(dfu_abboot_is_legacy(&s_info) == APP_FALSE);
+
+  // Image copied by the legacy flow, updated: kept as a runnable fallback
+  test_fresh();
+  s_info.app_bank.fw_load_addr = TEST_LEGACY_BACKUP;
+  test_boot();
+  test_download(1);
+  test_boot();
+  dfu_abboot_confirm(&s_info, TEST_BANK_B);
+  CB_TEST_CHECK(s_info.backup_bank.fw_load_addr == TEST_BANK_A);
+  s_bankContent[1] = 0;
+  CB_TEST_CHECK(test_boot() == TEST_BANK_A);
+
+  // Reset handler 0x4101, MCU address of bank A; 0x40101 of bank B
+  CB_TEST_CHECK(dfu_abboot_image_fits(TEST_BANK_A, vectors) == APP_TRUE);
+  CB_TEST_CHECK(dfu_abboot_image_fits(TEST_BANK_B, vectors) == APP_FALSE);
+  vectors[5] = 0x01;
+  vectors[6] = 0x04;
+  CB_TEST_CHECK(dfu_abboot_image_fits(TEST_BANK_B, vectors) == APP_TRUE);
+  CB_TEST_CHECK(dfu_abboot_image_fits(TEST_BANK_A, vectors) == APP_FALSE);
+}
+
+static void test_random_sequences(void)
+{
+  long resets = 0;
+  long failed = 0;
+
+  cb_test_case("random downloads, confirmations, damage and resets");
+  srand(7);
+  for (uint32_t run = 0; run < TEST_RANDOM_RUNS; run++)
+  {
+    test_fresh();
+    test_boot();
+    for (uint8_t e = 0; e < TEST_RANDOM_EVENTS; e++)
+    {
+      switch (rand() % 6)
+      {
+        case 0:  test_download(1); break;
+        case 1:  test_download(0); break;
+        case 2:
+          if (s_running != 0)
+          {
+            dfu_abboot_confirm(&s_info, s_running);
+          }
+          break;
+        case 3:
+          if ((rand() % 8) == 0)
+          {
+            s_bankContent[rand() % 2] = 0;
+          }
+          break;
+        default: break;
+      }
+
+      bootsetting_info_t before  = s_info;
+      uint32_t           booted  = test_boot();
+      uint8_t            ok      = 1;
+      uint8_t            anyGood = (test_bank_check(&before.app_bank) == APP_TRUE) ||
+                                   ((before.backup_bank.fw_start_addr == before.backup_bank.fw_load_addr) &&
+                                    (test_bank_check(&before.backup_bank) == APP_TRUE));
+      if (booted != 0)
+      {
+        const bank_info_t *bank = (s_info.app_bank.fw_start_addr == booted) ? &s_info.app_bank : &s_info.backup_bank;
+        ok &= (test_bank_check(bank) == APP_TRUE);
+      }
+      else
+      {
+        ok &= !anyGood;
+      }
+      // A trial boots once: the reset after it boots the confirmed image or its fallback
+      if (before.trial_state == DFU_TRIAL_TESTING)
+      {
+        ok &= (s_info.trial_state == DFU_TRIAL_NONE);
+      }
+      ok &= (s_info.app_bank.fw_start_addr != s_info.backup_bank.fw_start_addr) || (s_info.backup_bank.fw_active != APP_TRUE);
+      failed += !ok;
+      resets++;
+    }
+  }
+  printf("%ld resets, %ld failed\n", resets, failed);
+  CB_TEST_CHECK(failed == 0);
+}
+
+int main(void)
+{
+  test_trial_confirm_rollback();
+  test_damaged_images();
+  test_target_and_legacy();
+  test_random_sequences();
+  return cb_test_result();
+}
@@ -0,0 +1,348 @@
+/**
+ * @file    test_dfu_bankcopy.c
+ * @brief   Host power-cut simulation of the dfu_bankcopy journaled backup-to-app bank copy.
+ * @details The flash ports of dfu_handler are replaced by a flash model that counts the erase and
+ *          program operations. The boot of dfu_boot_startup() without DFU_AB_BOOT is modelled on it:
+ *          the boot setting, its two copies, and the backup-to-app move. Power is cut at every
+ *          flash operation of an update, leaving the interrupted sector or page with random bits,
+ *          then the device boots again: the application bank must end up holding the new image and
+ *          the boot setting must record it. Random double cuts check a reset during the resumed
+ *          copy. An image reaching the backup bank overlaps the head of the backup bank.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "dfu_handler.h"
+#include "dfu_bankcopy.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_FLASH_SIZE         0x80000
+#define TEST_SECTOR_SIZE        0x1000
+#define TEST_APP_ADDR           0x05000   // APP_BANK_ADDRESS of dfu_handler.c
+#define TEST_BACKUP_ADDR        0x3E800   // BACKUP_BANK_ADDRESS
+#define TEST_BANK_SIZE          0x3A800   // FIRMWARE_BANK_SIZE
+#define TEST_BOOTSETTING_A      0x7A000
+#define TEST_BOOTSETTING_B      0x79000
+#define TEST_OLD_SIZE           0x30000
+#define TEST_DOUBLE_CUTS        200
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static uint8_t  s_flash[TEST_FLASH_SIZE];
+static uint8_t  s_oldImage[TEST_BANK_SIZE];
+static uint8_t  s_newImage[TEST_BANK_SIZE];
+static uint32_t s_newSize;
+static uint32_t s_crcTable[256];
+static long     s_flashOps;
+static long     s_cutAt = -1;
+static jmp_buf  s_powerCut;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief Count a flash operation. At the cut, part of the region is left with random bits: an
+ *        erase stops half way, a program clears random bits, then the device resets.
+ */
+static void test_flash_op(uint8_t *region, uint32_t size, uint8_t erase)
+{
+  if (s_flashOps++ == s_cutAt)
+  {
+    for (uint32_t i = 0; i < size; i++)
+    {
+      if (rand() & 1)
+      {
+        region[i] = erase ? (uint8_t)rand() : (uint8_t)(region[i] & rand());
+      }
+    }
+    longjmp(s_powerCut, 1);
+  }
+}
+
+uint32_t dfu_crc_check_port(uint8_t *p_data, uint32_t size, uint32_t prev_crc)
+{
+  uint32_t crc = ~prev_crc;
+
+  for (uint32_t i = 0; i < size; i++)
+  {
+    crc = (crc >> 8) ^ s_crcTable[(crc ^ p_data[i]) & 0xFFU];
+  }
+  return ~crc;
+}
+
+uint32_t dfu_flash_erase_port(uint32_t address, uint32_t size)
+{
+  uint32_t first = address / TEST_SECTOR_SIZE;
+
+  // As dfu_handler.c: size / sector size + 1 sectors
+  for (uint32_t i = 0; i <= (size / TEST_SECTOR_SIZE); i++)
+  {
+    uint8_t *sector = &s_flash[(first + i) * TEST_SECTOR_SIZE];
+    test_flash_op(sector, TEST_SECTOR_SIZE, 1);
+    memset(sector, 0xFF, TEST_SECTOR_SIZE);
+  }
+  return 0;
+}
+
+uint32_t dfu_flash_write_port(uint32_t address, uint8_t *p_data, uint32_t size)
+{
+  test_flash_op(&s_flash[address], size, 0);
+  for (uint32_t i = 0; i < size; i++)
+  {
+    s_flash[address + i] &= p_data[i];    // NOR flash: programming only clears bits
+  }
+  return 0;
+}
+
+uint32_t dfu_flash_read_port(uint32_t address, uint8_t *p_data, uint32_t size)
+{
+  memcpy(p_data, &s_flash[address], size);
+  return 0;
+}
+
+uint32_t dfu_firmware_crc_check(uint32_t address, uint32_t size)
+{
+  return dfu_crc_check_port(&s_flash[address], size, 0);
+}
+
+static uint32_t test_bootsetting_crc(bootsetting_info_t *info)
+{
+  return dfu_crc_check_port((uint8_t *)(&info->data_crc + 1), sizeof(bootsetting_info_t) - 4, 0);
+}
+
+/**
+ * @brief dfu_bootsetting_write(): copy B first, then copy A.
+ */
+static void test_bootsetting_write(bootsetting_info_t *info)
+{
+  info->data_crc = test_bootsetting_crc(info);
+  dfu_flash_erase_port(TEST_BOOTSETTING_B, sizeof(bootsetting_info_t));
+  dfu_flash_write_port(TEST_BOOTSETTING_B, (uint8_t *)info, sizeof(bootsetting_info_t));
+  dfu_flash_erase_port(TEST_BOOTSETTING_A, sizeof(bootsetting_info_t));
+  dfu_flash_write_port(TEST_BOOTSETTING_A, (uint8_t *)info, sizeof(bootsetting_info_t));
+}
+
+static uint8_t test_bootsetting_read(bootsetting_info_t *info)
+{
+  memcpy(info, &s_flash[TEST_BOOTSETTING_A], sizeof(bootsetting_info_t));
+  if (info->data_crc == test_bootsetting_crc(info))
+  {
+    return 1;
+  }
+  memcpy(info, &s_flash[TEST_BOOTSETTING_B], sizeof(bootsetting_info_t));
+  return (info->data_crc == test_bootsetting_crc(info)) ? 1 : 0;
+}
+
+static void test_copy_job(const bank_info_t *bank, dfu_bankcopy_job_t *job)
+{
+  job->src  = bank->fw_load_addr;
+  job->dst  = bank->fw_start_addr;
+  job->size = bank->fw_size;
+  job->crc  = bank->fw_crc;
+}
+
+/**
+ * @brief boot_backup_crc_check(): the source is not checked again once its copy has started.
+ */
+static uint32_t test_backup_crc(bootsetting_info_t *info)
+{
+  dfu_bankcopy_job_t job;
+
+  test_copy_job(&info->backup_bank, &job);
+  return (dfu_bankcopy_progress(&job) > 0) ? job.crc : dfu_firmware_crc_check(job.src, job.size);
+}
+
+/**
+ * @brief boot_move_backup_to_app().
+ */
+static uint8_t test_move_backup(bootsetting_info_t *info)
+{
+  dfu_bankcopy_job_t job;
+
+  test_copy_job(&info->backup_bank, &job);
+  if (dfu_bankcopy_run(&job) != APP_TRUE)
+  {
+    return 0;
+  }
+  info->app_bank              = info->backup_bank;
+  info->backup_bank.fw_active = APP_FALSE;
+  info->boot_mode             = APP_FALSE;
+  test_bootsetting_write(info);
+  dfu_bankcopy_clear();
+  return 1;
+}
+
+/**
+ * @brief dfu_boot_startup() without DFU_AB_BOOT, the reset after a move included.
+ *
+ * @return 1 when the application is started, 0 when the device stays in boot mode.
+ */
+static uint8_t test_boot(void)
+{
+  bootsetting_info_t info;
+
+  if ((test_bootsetting_read(&info) == 0) || (info.boot_mode == APP_TRUE))
+  {
+    return 0;
+  }
+  for (;;)
+  {
+    if ((info.backup_bank.fw_active != APP_TRUE) && (info.app_bank.fw_size != 0) &&
+        (dfu_firmware_crc_check(info.app_bank.fw_start_addr, info.app_bank.fw_size) == info.app_bank.fw_crc))
+    {
+      dfu_bankcopy_job_t job;
+      test_copy_job(&info.app_bank, &job);
+      if (dfu_bankcopy_progress(&job) > 0)
+      {
+        dfu_bankcopy_clear();
+      }
+      return 1;
+    }
+    if ((info.backup_bank.fw_size == 0) || (test_backup_crc(&info) != info.backup_bank.fw_crc) ||
+        (test_move_backup(&info) == 0))
+    {
+      return 0;
+    }
+    test_bootsetting_read(&info);
+  }
+}
+
+/**
+ * @brief Old image running, new image received in the backup bank and recorded as active.
+ */
+static void test_setup_update(void)
+{
+  bootsetting_info_t info;
+  long               cutAt = s_cutAt;
+
+  s_cutAt = -1;
+  memset(s_flash, 0xFF, sizeof(s_flash));
+  memcpy(&s_flash[TEST_APP_ADDR], s_oldImage, TEST_OLD_SIZE);
+  memcpy(&s_flash[TEST_BACKUP_ADDR], s_newImage, s_newSize);
+  memset(&info, 0, sizeof(info));
+  info.app_bank    = (bank_info_t){ TEST_APP_ADDR, TEST_APP_ADDR, TEST_OLD_SIZE, dfu_firmware_crc_check(TEST_APP_ADDR, TEST_OLD_SIZE), 1, APP_TRUE };
+  info.backup_bank = (bank_info_t){ TEST_APP_ADDR, TEST_BACKUP_ADDR, s_newSize, dfu_firmware_crc_check(TEST_BACKUP_ADDR, s_newSize), 2, APP_TRUE };
+  test_bootsetting_write(&info);
+  s_cutAt = cutAt;
+}
+
+/**
+ * @brief The new image is in the application bank and recorded there, the copy is done.
+ */
+static uint8_t test_updated(void)
+{
+  bootsetting_info_t info;
+
+  return test_bootsetting_read(&info) && (info.backup_bank.fw_active != APP_TRUE) &&
+         (info.app_bank.fw_size == s_newSize) && (info.app_bank.fw_crc == dfu_crc_check_port(s_newImage, s_newSize, 0)) &&
+         (memcmp(&s_flash[TEST_APP_ADDR], s_newImage, s_newSize) == 0);
+}
+
+/**
+ * @brief Boot until the power cut, then boot again without cut.
+ */
+static uint8_t test_cut_and_reboot(long cutAt)
+{
+  s_flashOps = 0;
+  s_cutAt    = cutAt;
+  if (setjmp(s_powerCut) == 0)
+  {
+    test_boot();
+  }
+  s_cutAt = -1;
+  return (test_boot() == 1) && test_updated();
+}
+
+static void test_power_cuts(uint32_t newSize, const char *name)
+{
+  long total;
+  long failed = 0;
+
+  cb_test_case(name);
+  s_newSize = newSize;
+
+  test_setup_update();
+  s_flashOps = 0;
+  CB_TEST_CHECK((test_boot() == 1) && test_updated());
+  total = s_flashOps;
+  CB_TEST_CHECK(total > (long)(newSize / TEST_SECTOR_SIZE));
+
+  for (long cut = 0; cut < total; cut++)
+  {
+    test_setup_update();
+    failed += (test_cut_and_reboot(cut) == 0);
+  }
+  printf("%ld flash operations, power cut after each: %ld failed\n", total, failed);
+  CB_TEST_CHECK(failed == 0);
+
+  failed = 0;
+  for (int i = 0; i < TEST_DOUBLE_CUTS; i++)
+  {
+    test_setup_update();
+    test_cut_and_reboot(rand() % total);
+    failed += (test_cut_and_reboot(rand() % total) == 0);
+  }
+  printf("%d random double power cuts: %ld failed\n", TEST_DOUBLE_CUTS, failed);
+  CB_TEST_CHECK(failed == 0);
+}
+
+static void test_invalid_jobs(void)
+{
+  dfu_bankcopy_job_t job = { TEST_BACKUP_ADDR, TEST_APP_ADDR, 0x1000, 0 };
+
+  cb_test_case("invalid jobs and corrupt source are refused");
+  memset(s_flash, 0xFF, sizeof(s_flash));
+  s_cutAt = -1;
+
+  job.size = 0;
+  CB_TEST_CHECK(dfu_bankcopy_run(&job) == APP_FALSE);
+  job.size = 0x1000;
+  job.dst  = TEST_APP_ADDR + 0x100;
+  CB_TEST_CHECK(dfu_bankcopy_run(&job) == APP_FALSE);
+  // Destination less than a sector before the source
+  job.dst = TEST_BACKUP_ADDR - 0x800;
+  CB_TEST_CHECK(dfu_bankcopy_run(&job) == APP_FALSE);
+
+  job.dst = TEST_APP_ADDR;
+  job.crc = dfu_firmware_crc_check(job.src, job.size) ^ 1U;
+  CB_TEST_CHECK(dfu_bankcopy_run(&job) == APP_FALSE);
+  CB_TEST_CHECK(dfu_bankcopy_progress(&job) == 0);
+  job.crc ^= 1U;
+  CB_TEST_CHECK(dfu_bankcopy_run(&job) == APP_TRUE);
+  CB_TEST_CHECK(dfu_bankcopy_progress(&job) == 1);
+  dfu_bankcopy_clear();
+  CB_TEST_CHECK(dfu_bankcopy_progress(&job) == 0);
+}
+
+int main(void)
+{
+  for (uint32_t n = 0; n < 256; n++)
+  {
+    uint32_t c = n;
+    for (uint8_t k = 0; k < 8; k++)
+    {
+      c = (c >> 1) ^ (0xEDB88320UL & (0U - (c & 1U)));
+    }
+    s_crcTable[n] = c;
+  }
+  srand(1);
+  for (uint32_t i = 0; i < TEST_BANK_SIZE; i++)
+  {
+    s_oldImage[i] = (uint8_t)rand();
+    s_newImage[i] = (uint8_t)rand();
+  }
+
+  test_invalid_jobs();
+  test_power_cuts(0x3A000, "power cut at every flash operation, image overlapping the backup head");
+  test_power_cuts(0x12345, "power cut at every flash operation, short image");
+  return cb_test_result();
+}
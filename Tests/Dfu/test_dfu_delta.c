@@ -0,0 +1,198 @@
+/**
+ * @file    test_dfu_delta.c
+ * @brief   Host round trip of the dfu_delta patch applier on the example images.
+ * @details Tools/Dfu_Delta/dfu_delta.py makes the patches at build time, from the Keil images
+ *          Examples/<example>/Keil/Objects/CBU5000V210.axf. The base image is put at the
+ *          application bank of a flash model and each patch is applied the way dfu_handler does
+ *          without DFU_AB_BOOT, into the backup bank, in 128-byte and random 1..128-byte packs: the
+ *          rebuilt image must be the new image. A patch for another base and corrupted patches
+ *          must not produce an accepted image. A base filling the application bank checks that no
+ *          COPY reads the backup bank head, which the update erases.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "dfu_handler.h"
+#include "dfu_delta.h"
+#include "dfu_test_image.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_FLASH_SIZE     0x80000
+#define TEST_APP_ADDR       0x05000   // APP_BANK_ADDRESS of dfu_handler.c
+#define TEST_BACKUP_ADDR    0x3E800   // BACKUP_BANK_ADDRESS
+#define TEST_BANK_SIZE      0x3A800   // FIRMWARE_BANK_SIZE
+#define TEST_OTHER_BANK     0x40000   // Update bank clear of the base
+#define TEST_PACK_MAX       128       // OTA_PACK_MAX
+#define TEST_CORRUPTIONS    200
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct {
+  const char *base;
+  const char *image;
+  const char *patch;
+} test_pair_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static const test_pair_st s_pairs[] =
+{
+  { DFU_TEST_AXF("uwb_ds_twr_initiator"), DFU_TEST_AXF("uwb_ds_twr_responder"), TEST_DELTA_DIR "/uwb_ds_twr.ddf" },
+  { DFU_TEST_AXF("uwb_simple_tx"),        DFU_TEST_AXF("uwb_simple_rx"),        TEST_DELTA_DIR "/uwb_simple.ddf" },
+  { DFU_TEST_AXF("uwb_pdoa_initiator"),   DFU_TEST_AXF("uwb_pdoa_responder"),   TEST_DELTA_DIR "/uwb_pdoa.ddf" },
+  { DFU_TEST_AXF("peripheral_uart"),      DFU_TEST_AXF("peripheral_timer"),     TEST_DELTA_DIR "/peripheral.ddf" },
+  { TEST_DELTA_DIR "/overlap_base.bin", TEST_DELTA_DIR "/overlap_new.bin", TEST_DELTA_DIR "/overlap.ddf" },
+};
+static uint8_t  s_flash[TEST_FLASH_SIZE];
+static uint8_t  s_rebuilt[TEST_BANK_SIZE];
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint32_t dfu_flash_read_port(uint32_t address, uint8_t *p_data, uint32_t size)
+{
+  if (((address % DFU_DELTA_PAGE_SIZE) != 0) || ((address + size) > TEST_FLASH_SIZE))
+  {
+    return 1;
+  }
+  memcpy(p_data, &s_flash[address], size);
+  return 0;
+}
+
+static uint32_t test_write(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+  if (((offset % DFU_DELTA_PAGE_SIZE) != 0) || ((offset + len) > TEST_BANK_SIZE))
+  {
+    return 1;
+  }
+  memcpy(&s_rebuilt[offset], data, len);
+  return 0;
+}
+
+/**
+ * @brief Apply a patch into a bank in packs of 1..packMax bytes (packMax exactly if fixed).
+ */
+static uint8_t test_apply(const uint8_t *patch, uint32_t patchLen, uint32_t baseLen, uint32_t baseCrc,
+                          uint32_t outAddr, uint32_t packMax, uint8_t fixed, uint32_t *p_size)
+{
+  dfu_delta_t ctx;
+
+  memset(s_rebuilt, 0, sizeof(s_rebuilt));
+  dfu_delta_start(&ctx, TEST_APP_ADDR, baseLen, baseCrc, outAddr, TEST_BANK_SIZE, test_write);
+  for (uint32_t i = 0; i < patchLen;)
+  {
+    uint32_t pack = fixed ? packMax : (1U + ((uint32_t)rand() % packMax));
+    if (pack > (patchLen - i))
+    {
+      pack = patchLen - i;
+    }
+    if (dfu_delta_feed(&ctx, &patch[i], pack) != APP_TRUE)
+    {
+      return 0;
+    }
+    i += pack;
+  }
+  return (dfu_delta_finish(&ctx, p_size) == APP_TRUE) ? 1 : 0;
+}
+
+static void test_pair(const test_pair_st *pair)
+{
+  uint32_t baseLen;
+  uint32_t newLen;
+  uint32_t patchLen;
+  uint32_t size;
+  uint8_t *base  = dfu_test_load_image(pair->base, &baseLen);
+  uint8_t *image = dfu_test_load_image(pair->image, &newLen);
+  uint8_t *patch = dfu_test_read_file(pair->patch, &patchLen);
+  uint32_t baseCrc;
+  uint32_t accepted = 0;
+
+  cb_test_case(pair->patch);
+  CB_TEST_CHECK((base != NULL) && (image != NULL) && (patch != NULL));
+  if ((base == NULL) || (image == NULL) || (patch == NULL))
+  {
+    return;
+  }
+  baseCrc = dfu_test_crc32(base, baseLen);
+  memset(s_flash, 0xFF, sizeof(s_flash));
+  memcpy(&s_flash[TEST_APP_ADDR], base, baseLen);
+  // The update erases the backup bank first
+  memset(&s_flash[TEST_BACKUP_ADDR], 0xFF, TEST_FLASH_SIZE - TEST_BACKUP_ADDR);
+  printf("base %u bytes, new %u bytes, patch %u bytes\n", baseLen, newLen, patchLen);
+
+  CB_TEST_CHECK(test_apply(patch, patchLen, baseLen, baseCrc, TEST_BACKUP_ADDR, TEST_PACK_MAX, 1, &size) &&
+                (size == newLen) && (memcmp(s_rebuilt, image, newLen) == 0));
+  CB_TEST_CHECK(test_apply(patch, patchLen, baseLen, baseCrc, TEST_BACKUP_ADDR, TEST_PACK_MAX, 0, &size) &&
+                (size == newLen) && (memcmp(s_rebuilt, image, newLen) == 0));
+
+  // Patch for another base
+  CB_TEST_CHECK(test_apply(patch, patchLen, baseLen, baseCrc ^ 1U, TEST_BACKUP_ADDR, TEST_PACK_MAX, 1, &size) == 0);
+
+  // A corrupted patch may be applied, but never into an image with the CRC of the new image
+  for (uint16_t t = 0; t < TEST_CORRUPTIONS; t++)
+  {
+    uint32_t pos = DFU_DELTA_HEADER_SIZE + ((uint32_t)rand() % (patchLen - DFU_DELTA_HEADER_SIZE));
+    uint8_t  bit = (uint8_t)(1U << (rand() % 8));
+    patch[pos] ^= bit;
+    if (test_apply(patch, patchLen, baseLen, baseCrc, TEST_BACKUP_ADDR, TEST_PACK_MAX, 1, &size) &&
+        (dfu_test_crc32(s_rebuilt, size) == dfu_test_crc32(image, newLen)) && (memcmp(s_rebuilt, image, newLen) != 0))
+    {
+      accepted++;
+    }
+    patch[pos] ^= bit;
+  }
+  CB_TEST_CHECK(accepted == 0);
+  free(base);
+  free(image);
+  free(patch);
+}
+
+static void test_backup_head_copy(void)
+{
+  uint8_t  patch[DFU_DELTA_HEADER_SIZE + 8];
+  uint32_t baseCrc = dfu_test_crc32(&s_flash[TEST_APP_ADDR], TEST_BANK_SIZE);
+  uint32_t offset  = TEST_BACKUP_ADDR - TEST_APP_ADDR;
+  uint32_t size;
+  uint32_t len     = 0;
+  const uint32_t header[4] = { DFU_DELTA_MAGIC, TEST_BANK_SIZE, baseCrc, 16 };
+
+  cb_test_case("COPY from the backup bank head refused");
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    for (uint8_t b = 0; b < 4; b++)
+    {
+      patch[len++] = (uint8_t)(header[i] >> (8 * b));
+    }
+  }
+  patch[len++] = DFU_DELTA_OP_COPY;
+  patch[len++] = (uint8_t)(0x80U | (offset & 0x7FU));
+  patch[len++] = (uint8_t)(0x80U | ((offset >> 7) & 0x7FU));
+  patch[len++] = (uint8_t)(offset >> 14);
+  patch[len++] = 16;
+  patch[len++] = DFU_DELTA_OP_END;
+
+  // The flash still holds the overlap_base image of the last pair
+  CB_TEST_CHECK(test_apply(patch, len, TEST_BANK_SIZE, baseCrc, TEST_BACKUP_ADDR, TEST_PACK_MAX, 1, &size) == 0);
+  CB_TEST_CHECK(test_apply(patch, len, TEST_BANK_SIZE, baseCrc, TEST_OTHER_BANK, TEST_PACK_MAX, 1, &size) && (size == 16));
+}
+
+int main(void)
+{
+  srand(1);
+  for (uint8_t i = 0; i < (sizeof(s_pairs) / sizeof(s_pairs[0])); i++)
+  {
+    test_pair(&s_pairs[i]);
+  }
+  test_backup_head_copy();
+  return cb_test_result();
+}
@@ -0,0 +1,171 @@
+/**
+ * @file    test_dfu_lz.c
+ * @brief   Host round trip of the dfu_lz decompressor on the example images.
+ * @details Tools/Dfu_Lz/dfu_lz.py compresses the Keil images Examples/<example>/Keil/Objects/
+ *          CBU5000V210.axf at build time. Each stream is decompressed in 128-byte and random
+ *          1..128-byte packs: the output must be the image, written in order in page aligned
+ *          chunks. Truncated streams, a trailing byte and an image larger than the bank are
+ *          refused; bit flips are either refused or never give an image with the CRC of the
+ *          original.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "dfu_handler.h"
+#include "dfu_lz.h"
+#include "dfu_test_image.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_PACK_MAX       128       // OTA_PACK_MAX
+#define TEST_TRUNCATIONS    200
+#define TEST_BIT_FLIPS      1000
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static const char *s_examples[] =
+{
+  "dfu_app", "peripheral_timer", "peripheral_uart", "uwb_ds_twr_initiator", "uwb_ds_twr_responder",
+  "uwb_pdoa_initiator", "uwb_pdoa_responder", "uwb_simple_rx", "uwb_simple_tx",
+};
+static uint8_t  s_output[DFU_TEST_IMAGE_MAX];
+static uint32_t s_nextOffset;
+static uint8_t  s_badWrite;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint32_t test_write(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+  if (((offset % DFU_LZ_PAGE_SIZE) != 0) || (offset != s_nextOffset) || ((offset + len) > DFU_TEST_IMAGE_MAX))
+  {
+    s_badWrite = 1;
+    return 1;
+  }
+  memcpy(&s_output[offset], data, len);
+  s_nextOffset = offset + len;
+  return 0;
+}
+
+/**
+ * @brief Decompress a stream in packs of 1..TEST_PACK_MAX bytes (TEST_PACK_MAX exactly if fixed).
+ */
+static uint8_t test_run(dfu_lz_t *ctx, const uint8_t *stream, uint32_t len, uint32_t maxSize, uint8_t fixed, uint32_t *p_size)
+{
+  memset(s_output, 0, sizeof(s_output));
+  s_nextOffset = 0;
+  s_badWrite   = 0;
+  dfu_lz_start(ctx, maxSize, test_write);
+  for (uint32_t i = 0; i < len;)
+  {
+    uint32_t pack = fixed ? TEST_PACK_MAX : (1U + ((uint32_t)rand() % TEST_PACK_MAX));
+    if (pack > (len - i))
+    {
+      pack = len - i;
+    }
+    if (dfu_lz_feed(ctx, &stream[i], pack) != APP_TRUE)
+    {
+      return 0;
+    }
+    i += pack;
+  }
+  return ((dfu_lz_finish(ctx, p_size) == APP_TRUE) && (s_badWrite == 0)) ? 1 : 0;
+}
+
+static void test_example(const char *example)
+{
+  char       axf[128];
+  char       dlz[256];
+  dfu_lz_t   ctx;
+  uint32_t   imageLen;
+  uint32_t   streamLen;
+  uint32_t   size;
+  uint32_t   truncated = 0;
+  uint32_t   refused   = 0;
+  uint32_t   wrongCrc  = 0;
+
+  snprintf(axf, sizeof(axf), "Examples/%s/Keil/Objects/CBU5000V210.axf", example);
+  snprintf(dlz, sizeof(dlz), "%s/%s.dlz", TEST_LZ_DIR, example);
+  uint8_t *image  = dfu_test_load_image(axf, &imageLen);
+  uint8_t *stream = dfu_test_read_file(dlz, &streamLen);
+  uint32_t crc;
+
+  cb_test_case(example);
+  CB_TEST_CHECK((image != NULL) && (stream != NULL));
+  if ((image == NULL) || (stream == NULL))
+  {
+    return;
+  }
+  crc = dfu_test_crc32(image, imageLen);
+  printf("image %u bytes, stream %u bytes\n", imageLen, streamLen);
+
+  for (uint8_t rep = 0; rep < 4; rep++)
+  {
+    CB_TEST_CHECK(test_run(&ctx, stream, streamLen, DFU_TEST_IMAGE_MAX, (rep == 0), &size) &&
+                  (size == imageLen) && (memcmp(s_output, image, imageLen) == 0));
+  }
+  // Finish again: nothing more is written
+  CB_TEST_CHECK((dfu_lz_finish(&ctx, &size) == APP_TRUE) && (size == imageLen));
+  // Announced size larger than the bank
+  CB_TEST_CHECK(test_run(&ctx, stream, streamLen, imageLen - 1U, 1, &size) == 0);
+
+  for (uint16_t t = 0; t < TEST_TRUNCATIONS; t++)
+  {
+    truncated += test_run(&ctx, stream, DFU_LZ_HEADER_SIZE + ((uint32_t)rand() % (streamLen - DFU_LZ_HEADER_SIZE)), DFU_TEST_IMAGE_MAX, 0, &size);
+  }
+  CB_TEST_CHECK(truncated == 0);
+  stream[streamLen] = 0;
+  CB_TEST_CHECK(test_run(&ctx, stream, streamLen + 1U, DFU_TEST_IMAGE_MAX, 1, &size) == 0);
+
+  for (uint16_t t = 0; t < TEST_BIT_FLIPS; t++)
+  {
+    uint32_t pos = (uint32_t)rand() % streamLen;
+    uint8_t  bit = (uint8_t)(1U << (rand() % 8));
+    stream[pos] ^= bit;
+    if (test_run(&ctx, stream, streamLen, DFU_TEST_IMAGE_MAX, 1, &size) == 0)
+    {
+      refused++;
+    }
+    else if ((dfu_test_crc32(s_output, size) == crc) && ((size != imageLen) || (memcmp(s_output, image, imageLen) != 0)))
+    {
+      wrongCrc++;
+    }
+    stream[pos] ^= bit;
+  }
+  printf("%u of %u bit flips refused by the decoder, %u accepted with the image CRC\n", refused, TEST_BIT_FLIPS, wrongCrc);
+  CB_TEST_CHECK(wrongCrc == 0);
+  free(image);
+  free(stream);
+}
+
+static void test_bad_distance(void)
+{
+  // Header of a 16-byte image, then a match as first item: distance before the image start
+  uint8_t  stream[] = { 0x44, 0x4C, 0x5A, 0x31, 16, 0, 0, 0, 0x00, 0x00, 0x00 };
+  dfu_lz_t ctx;
+  uint32_t size;
+
+  cb_test_case("match before the image start, bad magic");
+  CB_TEST_CHECK(test_run(&ctx, stream, sizeof(stream), DFU_TEST_IMAGE_MAX, 1, &size) == 0);
+  stream[0] ^= 1U;
+  CB_TEST_CHECK(test_run(&ctx, stream, DFU_LZ_HEADER_SIZE, DFU_TEST_IMAGE_MAX, 1, &size) == 0);
+}
+
+int main(void)
+{
+  srand(1);
+  for (uint8_t i = 0; i < (sizeof(s_examples) / sizeof(s_examples[0])); i++)
+  {
+    test_example(s_examples[i]);
+  }
+  test_bad_distance();
+  return cb_test_result();
+}
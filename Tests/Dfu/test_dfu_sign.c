@@ -0,0 +1,526 @@
+/**
+ * @file    test_dfu_sign.c
+ * @brief   Host test of the dfu_sign SHA-256, signature check and Montgomery constant cache.
+ * @details SHA-256 against FIPS 180-4 and reference digests, fed whole, byte by byte, in random
+ *          chunks and from unaligned buffers. A test image signed with "openssl dgst -sha256 -sign"
+ *          and a test RSA-1024 key (private half not kept) is accepted for any pack size and
+ *          rejected with one bit flipped in the image or the signature. The PKA is a software
+ *          model: RsaVerifyP() computes the signature power e modulo the key and is only right
+ *          with the constants of Calc*() for that key. The key cache sector (0x7B000) is checked
+ *          erased, corrupt, made for another key and failing to program.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "dfu_sign.h"
+#include "dfu_handler.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_SECTOR_SIZE    0x1000
+#define TEST_IMAGE_SIZE     3000
+#define TEST_LIMBS          (DFU_SIGN_SIZE / 4)
+#define TEST_KEYCACHE_SIZE  (12 + sizeof(stPkaPrecompVals))   // CRC, magic, key CRC, constants
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+/**
+ * @brief Little endian 1024-bit number of the PKA model.
+ */
+typedef struct {
+  uint32_t limb[TEST_LIMBS];
+} test_bignum_t;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+// Test key: modulus of an RSA-1024 key made for this test, e = 65537
+const dfu_sign_pubkey_t dfu_sign_public_key = {
+  .modulus = {
+    0xd3, 0x97, 0xbe, 0xf6, 0x52, 0x3d, 0x2b, 0x6d, 0x42, 0x9b, 0x12, 0xda, 0x82, 0xcd, 0x3f, 0xa4,
+    0xf6, 0xab, 0xcd, 0x1a, 0x5d, 0x45, 0xc7, 0xb6, 0xd9, 0xfd, 0x11, 0xcc, 0x7f, 0x1d, 0x68, 0x56,
+    0x2a, 0x96, 0x59, 0x88, 0x0c, 0x7b, 0x81, 0x26, 0x8c, 0xf2, 0xfe, 0x7f, 0x4d, 0x06, 0xca, 0xe5,
+    0x32, 0xde, 0xb4, 0xfd, 0x0a, 0x8c, 0x29, 0x2d, 0xd0, 0x4c, 0xdc, 0x34, 0x20, 0xf6, 0x9f, 0x7c,
+    0xb9, 0x22, 0x3f, 0x92, 0x3f, 0x19, 0x17, 0xda, 0x3a, 0x43, 0xea, 0x52, 0x4e, 0x62, 0x13, 0x8b,
+    0x55, 0x25, 0x64, 0x08, 0xc0, 0x07, 0xca, 0x9c, 0xd2, 0xcc, 0xd2, 0x39, 0xaf, 0xd2, 0xca, 0x50,
+    0xaf, 0x5a, 0xdb, 0x99, 0x4f, 0x7b, 0x4f, 0xbd, 0x5a, 0xbc, 0x55, 0x43, 0x03, 0x17, 0xe8, 0xa5,
+    0xe6, 0x40, 0x03, 0x56, 0xb7, 0xb4, 0x2f, 0xff, 0x80, 0xfa, 0x01, 0xb0, 0x6d, 0x01, 0x17, 0x63,
+  },
+  .exponent = { 0x00, 0x01, 0x00, 0x01 },
+};
+
+// "openssl dgst -sha256 -sign" of test_image()
+static const uint8_t s_signature[DFU_SIGN_SIZE] = {
+  0x16, 0x6c, 0x08, 0xe7, 0x41, 0x56, 0x97, 0xa6, 0x3e, 0xd0, 0xc2, 0x59, 0x37, 0xa3, 0xa4, 0x7f,
+  0x58, 0x81, 0xa2, 0x38, 0x4d, 0x3b, 0x0a, 0x51, 0x39, 0x5a, 0xa4, 0xd6, 0x74, 0xba, 0x62, 0xba,
+  0x5f, 0xa6, 0x57, 0x66, 0x38, 0x3a, 0xcd, 0xa5, 0xbe, 0x7c, 0xdb, 0xdb, 0xe6, 0x20, 0x01, 0xce,
+  0x14, 0x76, 0x70, 0x1c, 0x4f, 0xed, 0x85, 0x12, 0xe5, 0x85, 0x16, 0x32, 0x33, 0x06, 0x36, 0x8b,
+  0xb5, 0xc3, 0xce, 0x44, 0x5c, 0x2d, 0x7e, 0xa3, 0x1c, 0x2e, 0x80, 0x3d, 0xbc, 0xd5, 0xe7, 0x34,
+  0x9e, 0x85, 0x94, 0xc0, 0x02, 0xae, 0xba, 0xc2, 0xe8, 0x25, 0x2c, 0x54, 0xac, 0x20, 0x8f, 0x26,
+  0xef, 0xef, 0xee, 0x06, 0x29, 0xa0, 0x9e, 0x06, 0x14, 0x8a, 0x56, 0xa6, 0x1d, 0x47, 0xd9, 0x31,
+  0x31, 0x84, 0xe8, 0x5c, 0x80, 0xb7, 0x5f, 0x28, 0x31, 0x10, 0x11, 0xae, 0x39, 0xf6, 0x17, 0xdc,
+};
+
+static uint8_t  s_flash[TEST_SECTOR_SIZE];     // Key cache sector
+static uint8_t  s_flashFail;
+static uint32_t s_crcTable[256];
+static uint32_t s_pkaCalcs;                    // CB_PKA_CalcRSqr() calls: constants computed
+static uint32_t s_pkaOn;
+static uint8_t  s_image[TEST_IMAGE_SIZE + DFU_SIGN_SIZE + 1];
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint32_t dfu_crc_check_port(uint8_t *p_data, uint32_t size, uint32_t prev_crc)
+{
+  uint32_t crc = ~prev_crc;
+
+  for (uint32_t i = 0; i < size; i++)
+  {
+    crc = (crc >> 8) ^ s_crcTable[(crc ^ p_data[i]) & 0xFFU];
+  }
+  return ~crc;
+}
+
+uint32_t dfu_flash_erase_port(uint32_t address, uint32_t size)
+{
+  if ((address != DFU_SIGN_KEYCACHE_ADDR) || (size > TEST_SECTOR_SIZE))
+  {
+    return 1;
+  }
+  memset(s_flash, 0xFF, sizeof(s_flash));
+  return 0;
+}
+
+uint32_t dfu_flash_write_port(uint32_t address, uint8_t *p_data, uint32_t size)
+{
+  if ((s_flashFail != 0) || (address != DFU_SIGN_KEYCACHE_ADDR) || (size > TEST_SECTOR_SIZE))
+  {
+    return 1;
+  }
+  for (uint32_t i = 0; i < size; i++)
+  {
+    s_flash[i] &= p_data[i];              // NOR flash: programming only clears bits
+  }
+  return 0;
+}
+
+uint32_t dfu_flash_read_port(uint32_t address, uint8_t *p_data, uint32_t size)
+{
+  if (address != DFU_SIGN_KEYCACHE_ADDR)
+  {
+    return 1;
+  }
+  memcpy(p_data, s_flash, size);
+  return 0;
+}
+
+static void test_bn_load(test_bignum_t *x, const uint8_t *le)
+{
+  for (uint32_t i = 0; i < TEST_LIMBS; i++)
+  {
+    x->limb[i] = (uint32_t)le[i * 4] | ((uint32_t)le[i * 4 + 1] << 8) | ((uint32_t)le[i * 4 + 2] << 16) | ((uint32_t)le[i * 4 + 3] << 24);
+  }
+}
+
+static void test_bn_store(uint8_t *le, const test_bignum_t *x)
+{
+  for (uint32_t i = 0; i < DFU_SIGN_SIZE; i++)
+  {
+    le[i] = (uint8_t)(x->limb[i / 4] >> ((i % 4) * 8));
+  }
+}
+
+static int test_bn_cmp(const test_bignum_t *a, const test_bignum_t *b)
+{
+  for (int i = TEST_LIMBS - 1; i >= 0; i--)
+  {
+    if (a->limb[i] != b->limb[i])
+    {
+      return (a->limb[i] > b->limb[i]) ? 1 : -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief x = x + y mod n, with x and y below n.
+ */
+static void test_bn_addmod(test_bignum_t *x, const test_bignum_t *y, const test_bignum_t *n)
+{
+  uint64_t carry = 0;
+  uint64_t borrow = 0;
+
+  for (uint32_t i = 0; i < TEST_LIMBS; i++)
+  {
+    carry      += (uint64_t)x->limb[i] + y->limb[i];
+    x->limb[i]  = (uint32_t)carry;
+    carry     >>= 32;
+  }
+  if ((carry != 0) || (test_bn_cmp(x, n) >= 0))
+  {
+    for (uint32_t i = 0; i < TEST_LIMBS; i++)
+    {
+      uint64_t d = (uint64_t)x->limb[i] - n->limb[i] - borrow;
+      x->limb[i] = (uint32_t)d;
+      borrow     = (d >> 63) & 1U;
+    }
+  }
+}
+
+/**
+ * @brief r = a * b mod n, double and add.
+ */
+static void test_bn_mulmod(test_bignum_t *r, const test_bignum_t *a, const test_bignum_t *b, const test_bignum_t *n)
+{
+  test_bignum_t acc;
+
+  memset(&acc, 0, sizeof(acc));
+  for (int bit = (TEST_LIMBS * 32) - 1; bit >= 0; bit--)
+  {
+    test_bignum_t twice = acc;
+    test_bn_addmod(&acc, &twice, n);
+    if ((a->limb[bit / 32] >> (bit % 32)) & 1U)
+    {
+      test_bn_addmod(&acc, b, n);
+    }
+  }
+  *r = acc;
+}
+
+/**
+ * @brief 2^bits mod n.
+ */
+static void test_bn_pow2mod(test_bignum_t *r, uint32_t bits, const test_bignum_t *n)
+{
+  memset(r, 0, sizeof(*r));
+  r->limb[0] = 1;
+  for (uint32_t i = 0; i < bits; i++)
+  {
+    test_bignum_t twice = *r;
+    test_bn_addmod(r, &twice, n);
+  }
+}
+
+void CB_PKA_Init(void)   { s_pkaOn = 1; }
+void CB_PKA_Deinit(void) { s_pkaOn = 0; }
+
+/**
+ * @brief Model constants: R mod n, -1/n mod 2^32 and R^2 mod n, R = 2^1024.
+ */
+uint32_t CB_PKA_CalcRInv(const uint8_t *const Modulus, uint32_t const ModSize, uint8_t *const RInv)
+{
+  test_bignum_t n;
+  test_bignum_t r;
+
+  test_bn_load(&n, Modulus);
+  test_bn_pow2mod(&r, TEST_LIMBS * 32, &n);
+  test_bn_store(RInv, &r);
+  return 0;
+}
+
+uint32_t CB_PKA_CalcMp(const uint8_t *const Modulus, uint32_t const ModSize, const uint8_t *const RInv, uint8_t *const Mp)
+{
+  uint32_t n0  = (uint32_t)Modulus[0] | ((uint32_t)Modulus[1] << 8) | ((uint32_t)Modulus[2] << 16) | ((uint32_t)Modulus[3] << 24);
+  uint32_t inv = 1;
+
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    inv *= 2 - (n0 * inv);                // Newton: 1/n0 mod 2^32
+  }
+  memset(Mp, 0, DFU_SIGN_SIZE);
+  inv = 0U - inv;
+  memcpy(Mp, &inv, sizeof(inv));
+  return 0;
+}
+
+uint32_t CB_PKA_CalcRSqr(const uint8_t *const Modulus, uint32_t const ModSize, const uint8_t *const RInv, uint8_t *const RSqr)
+{
+  test_bignum_t n;
+  test_bignum_t r;
+
+  s_pkaCalcs++;
+  test_bn_load(&n, Modulus);
+  test_bn_pow2mod(&r, TEST_LIMBS * 64, &n);
+  test_bn_store(RSqr, &r);
+  return 0;
+}
+
+/**
+ * @brief Output = Signature ^ Exp mod Modulus, little endian. With constants that are not the
+ *        ones of the modulus the output is wrong, as the Montgomery products of the PKA would be.
+ */
+void CB_PKA_RsaVerifyP(const uint8_t *const Signature, uint32_t const SigSize, const stPkaPrecompVals *Precomputed,
+                       uint8_t *const Output, const stPkaRsaKey *const Key)
+{
+  stPkaPrecompVals expected;
+  test_bignum_t    n;
+  test_bignum_t    s;
+  test_bignum_t    r;
+  uint32_t         e = (uint32_t)Key->Exp[0] | ((uint32_t)Key->Exp[1] << 8) | ((uint32_t)Key->Exp[2] << 16) | ((uint32_t)Key->Exp[3] << 24);
+  uint32_t         calcs = s_pkaCalcs;
+
+  CB_TEST_CHECK(s_pkaOn);
+  CB_PKA_CalcRInv(Key->Modulus, Key->ModSize, expected.RInv);
+  CB_PKA_CalcMp(Key->Modulus, Key->ModSize, expected.RInv, expected.Mp);
+  CB_PKA_CalcRSqr(Key->Modulus, Key->ModSize, expected.RInv, expected.RSqr);
+  s_pkaCalcs = calcs;
+
+  test_bn_load(&n, Key->Modulus);
+  test_bn_load(&s, Signature);
+  memset(&r, 0, sizeof(r));
+  r.limb[0] = 1;
+  for (int bit = 31; bit >= 0; bit--)
+  {
+    test_bn_mulmod(&r, &r, &r, &n);
+    if ((e >> bit) & 1U)
+    {
+      test_bn_mulmod(&r, &r, &s, &n);
+    }
+  }
+  if (memcmp(&expected, Precomputed, sizeof(expected)) != 0)
+  {
+    r.limb[3] ^= 0x5A5A5A5AU;
+  }
+  test_bn_store(Output, &r);
+}
+
+static void test_crc_init(void)
+{
+  for (uint32_t i = 0; i < 256; i++)
+  {
+    uint32_t crc = i;
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 1U) ? ((crc >> 1) ^ 0xEDB88320U) : (crc >> 1);
+    }
+    s_crcTable[i] = crc;
+  }
+}
+
+/**
+ * @brief Test image at an offset of s_image: offset 1 makes every pack unaligned.
+ */
+static uint8_t *test_image(uint32_t offset)
+{
+  uint8_t *image = &s_image[offset];
+
+  for (uint32_t i = 0; i < TEST_IMAGE_SIZE; i++)
+  {
+    image[i] = (uint8_t)((i * 131) ^ (i >> 7));
+  }
+  memcpy(&image[TEST_IMAGE_SIZE], s_signature, DFU_SIGN_SIZE);
+  return image;
+}
+
+static void test_hex(uint8_t *digest, const char *hex)
+{
+  for (uint32_t i = 0; i < DFU_SIGN_HASH_SIZE; i++)
+  {
+    unsigned int byte;
+    sscanf(&hex[i * 2], "%2x", &byte);
+    digest[i] = (uint8_t)byte;
+  }
+}
+
+/**
+ * @brief SHA-256 of data fed whole, byte by byte and in random chunks: all equal to the reference.
+ */
+static uint8_t test_sha256_feeds(const uint8_t *data, uint32_t len, const char *hex)
+{
+  dfu_sign_sha256_t ctx;
+  uint8_t           expected[DFU_SIGN_HASH_SIZE];
+  uint8_t           digest[DFU_SIGN_HASH_SIZE];
+  uint8_t           same = CB_TRUE;
+
+  test_hex(expected, hex);
+  dfu_sign_sha256_init(&ctx);
+  dfu_sign_sha256_update(&ctx, data, len);
+  dfu_sign_sha256_final(&ctx, digest);
+  same &= (memcmp(digest, expected, sizeof(digest)) == 0) ? CB_TRUE : CB_FALSE;
+
+  dfu_sign_sha256_init(&ctx);
+  for (uint32_t i = 0; i < len; i++)
+  {
+    dfu_sign_sha256_update(&ctx, &data[i], 1);
+  }
+  dfu_sign_sha256_final(&ctx, digest);
+  same &= (memcmp(digest, expected, sizeof(digest)) == 0) ? CB_TRUE : CB_FALSE;
+
+  for (uint32_t run = 0; run < 20; run++)
+  {
+    dfu_sign_sha256_init(&ctx);
+    for (uint32_t pos = 0; pos < len; )
+    {
+      uint32_t chunk = (uint32_t)(rand() % 150);
+      chunk = ((pos + chunk) > len) ? (len - pos) : chunk;
+      dfu_sign_sha256_update(&ctx, &data[pos], chunk);
+      pos += chunk;
+    }
+    dfu_sign_sha256_final(&ctx, digest);
+    same &= (memcmp(digest, expected, sizeof(digest)) == 0) ? CB_TRUE : CB_FALSE;
+  }
+  return same;
+}
+
+static void test_sha256(void)
+{
+  static uint8_t s_million[1000000];
+  static const char *const s_imageDigests[][2] = {
+    { "55",   "5d05a4435b96f43e53e5a582bbb0b8d840a71c023e7468d6604d1c9ae6511c4c" },
+    { "56",   "0851bc0b733318bd14db8098dec9a591c02ee1e72295d3ba54560e56342430fb" },
+    { "63",   "3d825c09f5fe7358fe955248d4bfc207298e5e74c426ccba7c93ac3992d70143" },
+    { "64",   "949f78c7321c5fa8a90f3d236c471950df72d869abc1d36e985cfce9a3ac98b9" },
+    { "65",   "7978b7d18ecfdd9652aba9457bdd4f51dca470d6edfdd08055e2c244b5ae00cf" },
+    { "119",  "f1ae96dacae36aee55d875c7d523334473a78b3e2381a3e7cc7fde2bef3f1938" },
+    { "1000", "86348e56dc65380890f29048c71713e28908eec2fc1b9b916cb39c8ffbccb52f" },
+    { "3000", "64d8a462b2649bb2dff955e1ccade37192539a82b5740e4a5f9a9ac2854cad84" },
+  };
+  const char *const abc448 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+  cb_test_case("SHA-256: FIPS 180-4 vectors, block boundaries, chunked and unaligned feeds");
+  CB_TEST_CHECK(test_sha256_feeds((const uint8_t *)"", 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+  CB_TEST_CHECK(test_sha256_feeds((const uint8_t *)"abc", 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+  CB_TEST_CHECK(test_sha256_feeds((const uint8_t *)abc448, (uint32_t)strlen(abc448), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+  for (uint32_t i = 0; i < (sizeof(s_imageDigests) / sizeof(s_imageDigests[0])); i++)
+  {
+    uint32_t len = (uint32_t)atoi(s_imageDigests[i][0]);
+    CB_TEST_CHECK(test_sha256_feeds(test_image(0), len, s_imageDigests[i][1]));
+    CB_TEST_CHECK(test_sha256_feeds(test_image(1), len, s_imageDigests[i][1]));
+  }
+
+  dfu_sign_sha256_t ctx;
+  uint8_t           digest[DFU_SIGN_HASH_SIZE];
+  uint8_t           expected[DFU_SIGN_HASH_SIZE];
+  memset(s_million, 'a', sizeof(s_million));
+  dfu_sign_sha256_init(&ctx);
+  for (uint32_t pos = 0; pos < sizeof(s_million); pos += 1000)
+  {
+    dfu_sign_sha256_update(&ctx, &s_million[pos], 1000);
+  }
+  dfu_sign_sha256_final(&ctx, digest);
+  test_hex(expected, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+  CB_TEST_CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+}
+
+/**
+ * @brief Transfer of an image in packs of packSize (0: random sizes), then the verification.
+ */
+static uint32_t test_transfer(const uint8_t *image, uint32_t size, uint32_t packSize)
+{
+  dfu_sign_start();
+  for (uint32_t pos = 0; pos < size; )
+  {
+    uint32_t pack = (packSize != 0) ? packSize : (uint32_t)(1 + (rand() % 300));
+    pack = ((pos + pack) > size) ? (size - pos) : pack;
+    dfu_sign_update(&image[pos], pack);
+    pos += pack;
+  }
+  return dfu_sign_finish();
+}
+
+static void test_signature(void)
+{
+  static const uint32_t s_packSizes[] = { 1, 7, 64, 127, 128, 129, 244, 512, TEST_IMAGE_SIZE + DFU_SIGN_SIZE };
+  static const uint32_t s_flipBits[]  = { 0, 8 * 1000 + 3, 8 * (TEST_IMAGE_SIZE - 1) + 7,
+                                          8 * TEST_IMAGE_SIZE, 8 * (TEST_IMAGE_SIZE + 64) + 5, 8 * (TEST_IMAGE_SIZE + DFU_SIGN_SIZE) - 1 };
+  uint32_t total = TEST_IMAGE_SIZE + DFU_SIGN_SIZE;
+  uint8_t  accepted = CB_TRUE;
+  uint8_t *image;
+
+  cb_test_case("signature: accepted for any pack size and alignment");
+  memset(s_flash, 0xFF, sizeof(s_flash));
+  for (uint32_t offset = 0; offset < 2; offset++)
+  {
+    image = test_image(offset);
+    for (uint32_t i = 0; i < (sizeof(s_packSizes) / sizeof(s_packSizes[0])); i++)
+    {
+      accepted &= (test_transfer(image, total, s_packSizes[i]) == APP_TRUE) ? CB_TRUE : CB_FALSE;
+    }
+  }
+  CB_TEST_CHECK(accepted);
+  for (uint32_t run = 0; run < 20; run++)
+  {
+    accepted &= (test_transfer(test_image(run & 1U), total, 0) == APP_TRUE) ? CB_TRUE : CB_FALSE;
+  }
+  CB_TEST_CHECK(accepted);
+  CB_TEST_CHECK(dfu_sign_get_verify_cycles() == 0);             // No cycle counter on the host
+
+  cb_test_case("signature: one bit flipped in the image or the signature");
+  for (uint32_t i = 0; i < (sizeof(s_flipBits) / sizeof(s_flipBits[0])); i++)
+  {
+    image = test_image(0);
+    image[s_flipBits[i] / 8] ^= (uint8_t)(1U << (s_flipBits[i] % 8));
+    CB_TEST_CHECK(test_transfer(image, total, 244) == APP_FALSE);
+  }
+
+  cb_test_case("signature: missing or short");
+  image = test_image(0);
+  CB_TEST_CHECK(test_transfer(image, TEST_IMAGE_SIZE, 244) == APP_FALSE);      // Unsigned image
+  CB_TEST_CHECK(test_transfer(image, DFU_SIGN_SIZE - 1, 16) == APP_FALSE);
+  CB_TEST_CHECK(test_transfer(&image[TEST_IMAGE_SIZE], DFU_SIGN_SIZE, 16) == APP_FALSE);   // Signature only
+  CB_TEST_CHECK(test_transfer(image, total, 244) == APP_TRUE);
+}
+
+static void test_keycache(void)
+{
+  uint32_t total  = TEST_IMAGE_SIZE + DFU_SIGN_SIZE;
+  uint32_t record = TEST_KEYCACHE_SIZE;
+
+  cb_test_case("key cache: built once on an erased sector");
+  memset(s_flash, 0xFF, sizeof(s_flash));
+  s_pkaCalcs = 0;
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 1) && !s_pkaOn);
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 1));
+  CB_TEST_CHECK(test_transfer(test_image(0), total, 244) == APP_TRUE);
+  CB_TEST_CHECK(s_pkaCalcs == 1);
+  CB_TEST_CHECK(s_flash[record] == 0xFF);
+
+  cb_test_case("key cache: corrupt record rebuilt");
+  s_flash[record / 2] ^= 0x10;
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 2));
+  CB_TEST_CHECK(test_transfer(test_image(0), total, 244) == APP_TRUE);
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 2));
+  s_flash[0] ^= 0x01;                                        // Record CRC
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 3));
+
+  cb_test_case("key cache: record of another key rebuilt");
+  s_flash[8] ^= 0x01;                                        // Key CRC
+  uint32_t crc = dfu_crc_check_port(&s_flash[4], record - 4, 0);
+  memcpy(s_flash, &crc, sizeof(crc));                        // Record intact, for another key
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 4));
+  CB_TEST_CHECK(test_transfer(test_image(0), total, 244) == APP_TRUE);
+
+  cb_test_case("key cache: wrong constants behind a valid CRC are not detected");
+  s_flash[record - 1] ^= 0x01;                               // Last byte of RSqr
+  crc = dfu_crc_check_port(&s_flash[4], record - 4, 0);
+  memcpy(s_flash, &crc, sizeof(crc));
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 4));
+  CB_TEST_CHECK(test_transfer(test_image(0), total, 244) == APP_FALSE);
+
+  cb_test_case("key cache: program failure, constants valid in RAM");
+  memset(s_flash, 0xFF, sizeof(s_flash));
+  s_flashFail = 1;
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_FALSE) && (s_pkaCalcs == 5));
+  CB_TEST_CHECK(test_transfer(test_image(0), total, 244) == APP_TRUE);
+  s_flashFail = 0;
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 6));
+  CB_TEST_CHECK((dfu_sign_key_load() == APP_TRUE) && (s_pkaCalcs == 6));
+}
+
+int main(void)
+{
+  srand(1);
+  test_crc_init();
+  test_sha256();
+  test_signature();
+  test_keycache();
+  return cb_test_result();
+}
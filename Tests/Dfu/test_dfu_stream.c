@@ -0,0 +1,196 @@
+/**
+ * @file    test_dfu_stream.c
+ * @brief   Host test of the dfu_stream frame reassembly used by the L2CAP CoC DFU transport.
+ * @details A stream of request frames, with data lengths from 0 to 255 and marker bytes in the data,
+ *          is split into segments of every size from 1 to 600 bytes: every frame must come out once,
+ *          in order and intact. Random streams with garbage bytes and corrupted frames check the
+ *          resynchronization: the delivered frames are an in-order subset of the valid ones, apart
+ *          from the rare garbage that passes the 8-bit checksum.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "dfu_stream.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_FRAMES           20
+#define TEST_MAX_SEGMENT      600
+#define TEST_RANDOM_RUNS      2000
+#define TEST_RANDOM_FRAMES    30
+#define TEST_REQ_TYPE         0x00    // Type byte of the request frames (DEF_DFU_STREAM_REQ_TYPE)
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static uint16_t s_gotCommand[64];
+static uint8_t  s_gotLen[64];
+static uint8_t  s_gotData[64][256];
+static uint16_t s_gotCount;
+static uint8_t  s_testData[255];
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static void test_frame_cb(uint16_t command, uint8_t *data, uint8_t len, void *arg)
+{
+  s_gotCommand[s_gotCount] = command;
+  s_gotLen[s_gotCount]     = len;
+  memcpy(s_gotData[s_gotCount], data, len);
+  s_gotCount++;
+}
+
+/**
+ * @brief Build a request frame: response frame layout with the request type and its checksum.
+ */
+static uint16_t test_build_request(uint8_t *out, uint16_t command, uint8_t len)
+{
+  uint16_t frameLen = dfu_stream_build_frame(out, DEF_DFU_STREAM_FRAME_MAX, command, s_testData, len);
+  uint8_t  checksum = 0;
+
+  out[DEF_RESP_POS] = TEST_REQ_TYPE;
+  for (uint16_t i = DEF_RXMARKER_SIZE; i < (frameLen - DEF_CHECKSUM_SIZE); i++)
+  {
+    checksum += out[i];
+  }
+  out[frameLen - DEF_CHECKSUM_SIZE] = checksum;
+  return frameLen;
+}
+
+static void test_every_segment_size(void)
+{
+  static uint8_t  stream[TEST_FRAMES * DEF_DFU_STREAM_FRAME_MAX];
+  dfu_stream_rx_t rx;
+  uint8_t         lens[TEST_FRAMES];
+  uint32_t        total = 0;
+  int             ok    = 1;
+
+  cb_test_case("every segment size from 1 to 600 bytes");
+  for (uint8_t i = 0; i < TEST_FRAMES; i++)
+  {
+    lens[i] = (uint8_t)((i * 37U) % 256U);
+  }
+  lens[3] = 255;
+  lens[4] = 0;
+  for (uint8_t i = 0; i < TEST_FRAMES; i++)
+  {
+    total += test_build_request(&stream[total], (uint16_t)(0x0100U + i), lens[i]);
+  }
+
+  for (uint16_t mtu = 1; mtu <= TEST_MAX_SEGMENT; mtu++)
+  {
+    uint32_t offset = 0;
+    uint16_t segment;
+
+    dfu_stream_rx_init(&rx);
+    s_gotCount = 0;
+    while ((segment = dfu_stream_tx_segment(total, offset, mtu)) != 0U)
+    {
+      dfu_stream_rx_feed(&rx, &stream[offset], segment, test_frame_cb, NULL);
+      offset += segment;
+    }
+    ok &= (s_gotCount == TEST_FRAMES) && (rx.frames == TEST_FRAMES) && (rx.checksumErrors == 0) && (rx.resyncBytes == 0) && (rx.used == 0);
+    for (uint8_t i = 0; (i < s_gotCount) && (i < TEST_FRAMES); i++)
+    {
+      ok &= (s_gotCommand[i] == (0x0100U + i)) && (s_gotLen[i] == lens[i]) && (memcmp(s_gotData[i], s_testData, lens[i]) == 0);
+    }
+  }
+  CB_TEST_CHECK(ok);
+  CB_TEST_CHECK(dfu_stream_tx_segment(total, total, 20) == 0);
+  CB_TEST_CHECK(dfu_stream_tx_segment(total, 0, 0) == 0);
+}
+
+static void test_resync(void)
+{
+  static uint8_t  stream[TEST_RANDOM_FRAMES * (DEF_DFU_STREAM_FRAME_MAX + 10) + DEF_DFU_STREAM_FRAME_MAX];
+  dfu_stream_rx_t rx;
+  uint32_t        valid       = 0;
+  uint32_t        delivered   = 0;
+  uint32_t        falseFrames = 0;
+
+  cb_test_case("garbage and corrupted frames, random segments");
+  srand(1);
+  for (uint16_t run = 0; run < TEST_RANDOM_RUNS; run++)
+  {
+    uint16_t expected[TEST_RANDOM_FRAMES];
+    uint16_t numExpected = 0;
+    uint32_t total       = 0;
+
+    for (uint16_t f = 0; f < TEST_RANDOM_FRAMES; f++)
+    {
+      if ((rand() % 4) == 0)
+      {
+        // Garbage between frames, with markers
+        for (int k = rand() % 10; k > 0; k--)
+        {
+          stream[total++] = ((rand() % 3) == 0) ? DEF_RXMARKER_VAL : (uint8_t)rand();
+        }
+      }
+      uint8_t  len      = (uint8_t)(rand() % 256);
+      uint16_t frameLen = test_build_request(&stream[total], (uint16_t)(0x0200U + f), len);
+      if ((rand() % 8) == 0)
+      {
+        stream[total + DEF_DATA_POS + ((len > 0U) ? (uint16_t)(rand() % len) : 0U)] ^= 0x01U;   // Data or checksum bit flip
+      }
+      else
+      {
+        expected[numExpected++] = (uint16_t)(0x0200U + f);
+      }
+      total += frameLen;
+    }
+    // Trailing zeros complete a frame header swallowed by a resync
+    memset(&stream[total], 0, DEF_DFU_STREAM_FRAME_MAX);
+    total += DEF_DFU_STREAM_FRAME_MAX;
+
+    dfu_stream_rx_init(&rx);
+    s_gotCount = 0;
+    for (uint32_t offset = 0; offset < total;)
+    {
+      uint16_t segment = dfu_stream_tx_segment(total, offset, (uint16_t)(1 + (rand() % TEST_MAX_SEGMENT)));
+      dfu_stream_rx_feed(&rx, &stream[offset], segment, test_frame_cb, NULL);
+      offset += segment;
+    }
+
+    // Delivered frames are valid frames in stream order, or a rare false frame: garbage that
+    // happens to pass the 8-bit checksum
+    uint16_t next = 0;
+    for (uint16_t i = 0; i < s_gotCount; i++)
+    {
+      uint16_t j = next;
+      while ((j < numExpected) && (expected[j] != s_gotCommand[i]))
+      {
+        j++;
+      }
+      if (j < numExpected)
+      {
+        delivered++;
+        next = j + 1U;
+      }
+      else
+      {
+        falseFrames++;
+      }
+    }
+    valid += numExpected;
+  }
+  printf("%u of %u valid frames delivered, %u false frames\n", delivered, valid, falseFrames);
+  CB_TEST_CHECK(falseFrames <= (valid / 10000U));
+  CB_TEST_CHECK(delivered >= (valid - (valid / 1000U)));
+}
+
+int main(void)
+{
+  for (uint16_t i = 0; i < sizeof(s_testData); i++)
+  {
+    s_testData[i] = (uint8_t)((i * 7U) + DEF_RXMARKER_VAL);
+  }
+  test_every_segment_size();
+  test_resync();
+  return cb_test_result();
+}
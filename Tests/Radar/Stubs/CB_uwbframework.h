@@ -0,0 +1,15 @@
+/**
+ * @file    CB_uwbframework.h
+ * @brief   Host test stub: the framework functions used by the radar modules, defined by the test.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __CB_UWBFRAMEWORK_H
+#define __CB_UWBFRAMEWORK_H
+
+#include "CB_system_types.h"
+
+void cb_framework_radar_getcir(cb_uwbsystem_rx_cir_iqdata_st* destArray, cb_uwbsystem_rxport_en enRxPort, uint32_t NumCirSample);
+void cb_framework_fft(cb_uwbradar_en fft_len, float* pSrc, uint8_t ifftFlag, uint8_t doBitReverse);
+
+#endif /*__CB_UWBFRAMEWORK_H*/
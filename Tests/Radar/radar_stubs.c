@@ -0,0 +1,64 @@
+/**
+ * @file    radar_stubs.c
+ * @brief   Host versions of the framework functions used by the radar modules.
+ * @details cb_framework_fft() is a reference DFT in double precision (forward, natural order output).
+ *          cb_framework_radar_getcir() copies g_radarTestCir.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "radar_stubs.h"
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+cb_uwbsystem_rx_cir_iqdata_st g_radarTestCir[DEF_RADAR_TEST_CIR_SIZE];
+uint32_t                      g_radarTestGetcirCalls;
+
+static uint32_t s_radarTestSeed = 1;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+void cb_framework_radar_getcir(cb_uwbsystem_rx_cir_iqdata_st* destArray, cb_uwbsystem_rxport_en enRxPort, uint32_t NumCirSample)
+{
+  memcpy(destArray, g_radarTestCir, NumCirSample * sizeof(cb_uwbsystem_rx_cir_iqdata_st));
+  g_radarTestGetcirCalls++;
+}
+
+void cb_framework_fft(cb_uwbradar_en fft_len, float* pSrc, uint8_t ifftFlag, uint8_t doBitReverse)
+{
+  uint32_t numPoints = 16U << fft_len;
+  double  *out       = malloc(2 * numPoints * sizeof(double));
+  double   sign      = (ifftFlag != 0) ? 1.0 : -1.0;
+
+  for (uint32_t k = 0; k < numPoints; k++)
+  {
+    double re = 0.0;
+    double im = 0.0;
+    for (uint32_t n = 0; n < numPoints; n++)
+    {
+      double angle = sign * 2.0 * M_PI * (double)((k * n) % numPoints) / numPoints;
+      re += pSrc[2 * n] * cos(angle) - pSrc[2 * n + 1] * sin(angle);
+      im += pSrc[2 * n] * sin(angle) + pSrc[2 * n + 1] * cos(angle);
+    }
+    out[2 * k]     = re;
+    out[2 * k + 1] = im;
+  }
+  for (uint32_t i = 0; i < 2 * numPoints; i++)
+  {
+    pSrc[i] = (float)out[i];
+  }
+  free(out);
+}
+
+double radar_test_noise(double amplitude)
+{
+  s_radarTestSeed = (s_radarTestSeed * 1103515245U) + 12345U;
+  return amplitude * ((double)((s_radarTestSeed >> 8) & 0xFFFF) / 32768.0 - 1.0);
+}
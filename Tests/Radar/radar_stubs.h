@@ -0,0 +1,34 @@
+/**
+ * @file    radar_stubs.h
+ * @brief   Host versions of the framework functions used by the radar modules.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __RADAR_STUBS_H
+#define __RADAR_STUBS_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "CB_uwbframework.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_RADAR_TEST_CIR_SIZE   256
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+extern cb_uwbsystem_rx_cir_iqdata_st g_radarTestCir[DEF_RADAR_TEST_CIR_SIZE];   /**< Returned by cb_framework_radar_getcir() */
+extern uint32_t                      g_radarTestGetcirCalls;
+
+//-------------------------------
+// FUNCTION PROTOTYPE SECTION
+//-------------------------------
+/**
+ * @brief Uniform pseudo-random noise in [-amplitude, amplitude), reproducible.
+ */
+double radar_test_noise(double amplitude);
+
+#endif /*__RADAR_STUBS_H*/
@@ -0,0 +1,200 @@
+/**
+ * @file    test_radar_doppler.c
+ * @brief   Host test of the CB_radar range-Doppler processing.
+ * @details Synthetic slow-time CIR: static clutter, one or two moving targets (phase rotating from
+ *          chirp to chirp) and uniform noise. Checks the detections, the clutter removal, the bounded processing steps and the configuration limits.
+ *          The single target runs through both the float and the Q15 Doppler FFT.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "cb_test.h"
+#include "radar_stubs.h"
+#include "CB_radar.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_FIRST_BIN        4
+#define TEST_NUM_BINS         32
+#define TEST_CLUTTER_BIN      3
+#define TEST_CLUTTER_AMP      12000.0
+#define TEST_NOISE_AMP        40.0
+#define TEST_WAVELENGTH_M     0.0375f
+#define TEST_CHIRP_PERIOD_S   0.002f
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  uint16_t rangeBin;
+  int16_t  dopplerBin;
+  double   amplitude;
+} test_target_st;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static void test_config(cb_radar_config_st *config, uint8_t fixedPoint)
+{
+  memset(config, 0, sizeof(*config));
+  config->firstRangeBin      = TEST_FIRST_BIN;
+  config->numRangeBins       = TEST_NUM_BINS;
+  config->dopplerFftLen      = EN_FFT_LEN32;
+  config->clutterRemoval     = CB_TRUE;
+  config->fixedPointFft      = fixedPoint;
+  config->cfarGuardCells     = 1;
+  config->cfarTrainingCells  = 4;
+  config->cfarThresholdScale = 25.0f;
+  config->rangeBinSize_m     = 0.3f;
+  config->chirpPeriod_s      = TEST_CHIRP_PERIOD_S;
+  config->wavelength_m       = TEST_WAVELENGTH_M;
+}
+
+static void test_fill_frame(uint16_t chirp, uint16_t numChirps, const test_target_st *targets, uint8_t numTargets)
+{
+  for (uint16_t r = 0; r < DEF_RADAR_TEST_CIR_SIZE; r++)
+  {
+    double i = radar_test_noise(TEST_NOISE_AMP);
+    double q = radar_test_noise(TEST_NOISE_AMP);
+    if (r == (TEST_FIRST_BIN + TEST_CLUTTER_BIN))
+    {
+      i += TEST_CLUTTER_AMP;
+      q -= TEST_CLUTTER_AMP / 2;
+    }
+    for (uint8_t t = 0; t < numTargets; t++)
+    {
+      if (r == (TEST_FIRST_BIN + targets[t].rangeBin))
+      {
+        double phase = 2.0 * M_PI * targets[t].dopplerBin * chirp / numChirps;
+        i += targets[t].amplitude * cos(phase);
+        q += targets[t].amplitude * sin(phase);
+      }
+    }
+    g_radarTestCir[r].I_data = (int16_t)lrint(i);
+    g_radarTestCir[r].Q_data = (int16_t)lrint(q);
+  }
+}
+
+static const cb_radar_result_st *test_run_map(const test_target_st *targets, uint8_t numTargets, uint16_t binsPerCall)
+{
+  cb_radar_status_en status = EN_RADAR_STATUS_ACCUMULATING;
+  uint16_t           calls  = 0;
+
+  for (uint16_t n = 0; (n < 32) && (status == EN_RADAR_STATUS_ACCUMULATING); n++)
+  {
+    test_fill_frame(n, 32, targets, numTargets);
+    status = cb_radar_acquire_frame(EN_UWB_RX_0);
+  }
+  CB_TEST_CHECK(status == EN_RADAR_STATUS_PROCESSING);
+  while ((status = cb_radar_process(binsPerCall)) == EN_RADAR_STATUS_PROCESSING)
+  {
+    calls++;
+  }
+  CB_TEST_CHECK(status == EN_RADAR_STATUS_DONE);
+  if (binsPerCall != 0)
+  {
+    CB_TEST_CHECK(calls == ((TEST_NUM_BINS + binsPerCall - 1) / binsPerCall) - 1);
+  }
+  return cb_radar_get_result();
+}
+
+static const cb_radar_detection_st *test_find(const cb_radar_result_st *result, uint16_t rangeBin, int16_t dopplerBin)
+{
+  for (uint8_t i = 0; i < result->numDetections; i++)
+  {
+    if ((result->detections[i].rangeBin == rangeBin) && (result->detections[i].dopplerBin == dopplerBin))
+    {
+      return &result->detections[i];
+    }
+  }
+  return NULL;
+}
+
+static void test_single_target(uint8_t fixedPoint)
+{
+  static const test_target_st target = {10, 5, 600.0};
+  cb_radar_config_st          config;
+
+  cb_test_case(fixedPoint ? "one target, Q15 Doppler FFT" : "one target, float Doppler FFT");
+  test_config(&config, fixedPoint);
+  CB_TEST_CHECK(cb_radar_init(&config) == CB_PASS);
+
+  const cb_radar_result_st    *result    = test_run_map(&target, 1, 0);
+  const cb_radar_detection_st *detection = test_find(result, 10, 5);
+  CB_TEST_CHECK(detection != NULL);
+  if (detection != NULL)
+  {
+    float velocity = -5.0f * TEST_WAVELENGTH_M / (2.0f * 32 * TEST_CHIRP_PERIOD_S);
+    CB_TEST_CHECK(fabsf(detection->range_m - (TEST_FIRST_BIN + 10) * 0.3f) < 1e-4f);
+    CB_TEST_CHECK(fabsf(detection->velocity_mps - velocity) < 1e-4f);
+    CB_TEST_CHECK(detection->snr_dB > 20.0f);
+    printf("target SNR %.1f dB\n", detection->snr_dB);
+  }
+  for (uint8_t i = 0; i < result->numDetections; i++)
+  {
+    CB_TEST_CHECK((detection == NULL) || (result->detections[i].snr_dB <= detection->snr_dB));
+    CB_TEST_CHECK(result->detections[i].rangeBin != TEST_CLUTTER_BIN);   // Static clutter removed
+    CB_TEST_CHECK(result->detections[i].dopplerBin != 0);
+  }
+
+  // Static bin of the clutter range: mean removal leaves only noise
+  const float *map = cb_radar_get_power_map();
+  CB_TEST_CHECK(map[TEST_CLUTTER_BIN * DEF_RADAR_MAX_CHIRPS] < map[10 * DEF_RADAR_MAX_CHIRPS + 5] / 100.0f);
+}
+
+static void test_two_targets_stepped(void)
+{
+  static const test_target_st targets[2] = {{6, -3, 500.0}, {20, 9, 300.0}};
+  cb_radar_config_st          config;
+
+  cb_test_case("two targets, processing spread over calls");
+  test_config(&config, CB_FALSE);
+  CB_TEST_CHECK(cb_radar_init(&config) == CB_PASS);
+  const cb_radar_result_st *result = test_run_map(targets, 2, 5);
+  CB_TEST_CHECK(test_find(result, 6, -3) != NULL);
+  CB_TEST_CHECK(test_find(result, 20, 9) != NULL);
+  CB_TEST_CHECK(result->numDetections <= DEF_RADAR_MAX_DETECTIONS);
+
+  // Next map: the done state restarts the accumulation, the result stays readable meanwhile
+  uint8_t previous = result->numDetections;
+  test_fill_frame(0, 32, targets, 2);
+  CB_TEST_CHECK(cb_radar_push_frame(g_radarTestCir) == EN_RADAR_STATUS_ACCUMULATING);
+  CB_TEST_CHECK(cb_radar_get_result()->numDetections == previous);
+}
+
+static void test_limits(void)
+{
+  cb_radar_config_st config;
+
+  cb_test_case("configuration limits");
+  CB_TEST_CHECK(cb_radar_init(NULL) == CB_FAIL);
+  test_config(&config, CB_FALSE);
+  config.numRangeBins = 0;
+  CB_TEST_CHECK(cb_radar_init(&config) == CB_FAIL);
+  config.numRangeBins = DEF_RADAR_MAX_RANGE_BINS + 1;
+  CB_TEST_CHECK(cb_radar_init(&config) == CB_FAIL);
+  test_config(&config, CB_FALSE);
+  config.firstRangeBin = DEF_RADAR_MAX_CIR_SAMPLES - TEST_NUM_BINS + 1;
+  CB_TEST_CHECK(cb_radar_init(&config) == CB_FAIL);
+  test_config(&config, CB_FALSE);
+  config.dopplerFftLen = EN_FFT_LEN64;                // 64 chirps > DEF_RADAR_MAX_CHIRPS
+  CB_TEST_CHECK(cb_radar_init(&config) == CB_FAIL);
+  test_config(&config, CB_FALSE);
+  config.dopplerFftLen = EN_FFT_LEN16;
+  CB_TEST_CHECK(cb_radar_init(&config) == CB_PASS);
+}
+
+int main(void)
+{
+  test_single_target(CB_FALSE);
+  test_single_target(CB_TRUE);
+  test_two_targets_stepped();
+  test_limits();
+  return cb_test_result();
+}
@@ -0,0 +1,170 @@
+/**
+ * @file    test_radar_fft_q15.c
+ * @brief   Host test of the CB_radar Q15 block-floating-point FFT and of the FFT benchmark.
+ * @details cb_radar_fft_q15() is compared with a double-precision DFT for each supported length and
+ *          input levels from a few LSB to full scale, including -32768 samples. The sanitizers catch
+ *          shifts of negative values and signed overflows in the fixed-point path.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <complex.h>
+#include <math.h>
+#include <string.h>
+#include "cb_test.h"
+#include "radar_stubs.h"
+#include "CB_radar.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_MIN_SNR_DB       40.0    // Q15 output vs reference DFT, inputs of 30 LSB and more
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+/**
+ * @brief SNR of the Q15 FFT of x against the DFT of the same input, in dB.
+ */
+static double test_fft_snr(cb_uwbradar_en fftLen, int16_t *x)
+{
+  static double complex ref[DEF_RADAR_Q15_FFT_MAX_LEN];
+  uint16_t              numPoints = (uint16_t)(16U << fftLen);
+  int8_t                exponent  = 0;
+  double                err       = 0.0;
+  double                sig       = 0.0;
+
+  for (uint16_t k = 0; k < numPoints; k++)
+  {
+    ref[k] = 0.0;
+    for (uint16_t n = 0; n < numPoints; n++)
+    {
+      ref[k] += (x[2 * n] + I * x[2 * n + 1]) * cexp(-2.0 * I * M_PI * (double)((k * n) % numPoints) / numPoints);
+    }
+  }
+  CB_TEST_CHECK(cb_radar_fft_q15(fftLen, x, &exponent) == CB_PASS);
+  for (uint16_t k = 0; k < numPoints; k++)
+  {
+    double complex y = ldexp(x[2 * k], exponent) + I * ldexp(x[2 * k + 1], exponent);
+    err += cabs(y - ref[k]) * cabs(y - ref[k]);
+    sig += cabs(ref[k]) * cabs(ref[k]);
+  }
+  return (err > 0.0) ? (10.0 * log10(sig / err)) : 200.0;
+}
+
+static void test_accuracy(void)
+{
+  static int16_t x[2 * DEF_RADAR_Q15_FFT_MAX_LEN];
+
+  cb_test_case("Q15 FFT against the reference DFT");
+  for (cb_uwbradar_en fftLen = EN_FFT_LEN16; (16U << fftLen) <= DEF_RADAR_Q15_FFT_MAX_LEN; fftLen++)
+  {
+    uint16_t numPoints = (uint16_t)(16U << fftLen);
+    for (double amp = 30.0; amp <= 30000.0; amp *= 10.0)
+    {
+      // Off-bin tone plus noise: energy in every bin
+      for (uint16_t n = 0; n < numPoints; n++)
+      {
+        double angle = 2.0 * M_PI * 3.3 * n / numPoints;
+        x[2 * n]     = (int16_t)lrint(amp * cos(angle) + radar_test_noise(2.0));
+        x[2 * n + 1] = (int16_t)lrint(0.7 * amp * sin(1.7 * angle) + radar_test_noise(2.0));
+      }
+      double snr = test_fft_snr(fftLen, x);
+      printf("N=%4u amp=%5.0f SNR %.1f dB\n", numPoints, amp, snr);
+      CB_TEST_CHECK(snr > TEST_MIN_SNR_DB);
+    }
+  }
+}
+
+static void test_full_scale(void)
+{
+  static int16_t x[2 * 64];
+  uint32_t       power[64];
+  int8_t         exponent = 0;
+
+  cb_test_case("Q15 FFT of -32768 samples");
+  // Constant -32768 - j32768: all the energy in bin 0, no overflow in the stages
+  for (uint16_t i = 0; i < (2 * 64); i++)
+  {
+    x[i] = -32768;
+  }
+  CB_TEST_CHECK(cb_radar_fft_q15(EN_FFT_LEN64, x, &exponent) == CB_PASS);
+  CB_TEST_CHECK(fabs(ldexp(x[0], exponent) + 64.0 * 32768.0) < 64.0 * 32768.0 * 1e-3);
+  CB_TEST_CHECK(fabs(ldexp(x[1], exponent) + 64.0 * 32768.0) < 64.0 * 32768.0 * 1e-3);
+  for (uint16_t k = 1; k < 64; k++)
+  {
+    CB_TEST_CHECK((x[2 * k] == 0) && (x[2 * k + 1] == 0));
+  }
+
+  // Alternating full scale with small samples: the normalization shifts negative values up
+  for (uint16_t n = 0; n < 64; n++)
+  {
+    x[2 * n]     = (n & 1U) ? -32768 : 32767;
+    x[2 * n + 1] = (int16_t)lrint(radar_test_noise(3.0));
+  }
+  CB_TEST_CHECK(test_fft_snr(EN_FFT_LEN64, x) > TEST_MIN_SNR_DB);
+  for (uint16_t n = 0; n < 64; n++)
+  {
+    x[2 * n]     = (n & 1U) ? -3 : 2;
+    x[2 * n + 1] = (n & 2U) ? -1 : 1;
+  }
+  CB_TEST_CHECK(test_fft_snr(EN_FFT_LEN64, x) > 20.0);
+
+  // Power of a -32768, -32768 bin is 2^31: does not fit int32
+  memset(x, 0, sizeof(x));
+  x[2 * 5]     = -32768;
+  x[2 * 5 + 1] = -32768;
+  cb_radar_mag_squared_q15(x, power, 64, CB_FALSE);
+  CB_TEST_CHECK(power[5] == 0x80000000UL);
+  CB_TEST_CHECK(power[4] == 0);
+  cb_radar_mag_squared_q15(x, power, 64, CB_TRUE);
+  CB_TEST_CHECK(power[64 - 5] == 0x80000000UL);
+}
+
+static void test_unsupported(void)
+{
+  int16_t x[2];
+  int8_t  exponent = 0;
+
+  cb_test_case("Q15 FFT limits");
+  CB_TEST_CHECK(cb_radar_fft_q15(EN_FFT_LEN512, x, &exponent) == CB_FAIL);
+  CB_TEST_CHECK(cb_radar_fft_q15(EN_FFT_LEN16, NULL, &exponent) == CB_FAIL);
+  CB_TEST_CHECK(cb_radar_fft_q15(EN_FFT_LEN16, x, NULL) == CB_FAIL);
+}
+
+static void test_benchmark(void)
+{
+  cb_radar_fft_benchmark_st results[EN_FFT_LEN4096 + 1];
+
+  cb_test_case("FFT benchmark covers every cb_uwbradar_en length");
+  uint8_t count = cb_radar_fft_benchmark(results, EN_FFT_LEN4096 + 1);
+  CB_TEST_CHECK(count == (EN_FFT_LEN4096 + 1));
+  for (uint8_t i = 0; i < count; i++)
+  {
+    printf("N=%4u float %.0f dB, Q15 %.0f dB\n", results[i].fftLen, results[i].floatDynamicRange_dB, results[i].q15DynamicRange_dB);
+    CB_TEST_CHECK(results[i].fftLen == (16U << i));
+    CB_TEST_CHECK(results[i].floatBufferBytes == (8U * results[i].fftLen));
+    CB_TEST_CHECK(results[i].floatDynamicRange_dB > 40.0f);
+    if (results[i].fftLen <= DEF_RADAR_Q15_FFT_MAX_LEN)
+    {
+      CB_TEST_CHECK(results[i].q15BufferBytes == (4U * results[i].fftLen));
+      CB_TEST_CHECK(results[i].q15DynamicRange_dB > 40.0f);
+    }
+    else
+    {
+      CB_TEST_CHECK((results[i].q15BufferBytes == 0) && (results[i].q15Cycles == 0));
+    }
+  }
+  CB_TEST_CHECK(cb_radar_fft_benchmark(results, 3) == 3);
+}
+
+int main(void)
+{
+  test_accuracy();
+  test_full_scale();
+  test_unsupported();
+  test_benchmark();
+  return cb_test_result();
+}
@@ -0,0 +1,153 @@
+/**
+ * @file    test_radar_vitals.c
+ * @brief   Host test of the CB_radar_vitals presence and vital-sign detection.
+ * @details 240 s of synthetic CIR at 20 frames/s: static clutter and gaussian noise on 32 range bins,
+ *          a person at range bin 10 from 30 s to 180 s with sinusoidal breathing (5 mm) and heart
+ *          (0.3 mm) displacement, walking from 100 s to 105 s. Checks presence enter/exit, motion
+ *          start/stop and the reported rates for three breathing/heart rate pairs.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "cb_test.h"
+#include "radar_stubs.h"
+#include "CB_radar_vitals.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_FRAME_RATE_HZ    20
+#define TEST_DURATION_S       240
+#define TEST_TARGET_BIN       10
+#define TEST_ENTER_S          30.0
+#define TEST_EXIT_S           180.0
+#define TEST_WALK_START_S     100.0
+#define TEST_WALK_END_S       105.0
+#define TEST_WAVELENGTH_M     0.0375
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  double   time[8];               // Time of the first event of each type, -1 if none
+  uint32_t count[8];
+  float    breathRate_bpm;        // Last vitals report before the walk
+  float    heartRate_bpm;
+} test_vitals_log_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static double             s_now;
+static test_vitals_log_st s_log;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static void test_event(const cb_radar_vitals_event_st *event)
+{
+  if (s_log.count[event->event]++ == 0)
+  {
+    s_log.time[event->event] = s_now;
+  }
+  if ((event->event == EN_RADAR_VITALS_EVENT_VITALS) && (s_now < TEST_WALK_START_S))
+  {
+    s_log.breathRate_bpm = event->breathRate_bpm;
+    s_log.heartRate_bpm  = event->heartRate_bpm;
+    CB_TEST_CHECK(event->rangeBin == TEST_TARGET_BIN);
+  }
+}
+
+static double test_gauss(double sigma)
+{
+  double u = radar_test_noise(0.5) + 0.5 + 1e-9;
+  double v = radar_test_noise(0.5) + 0.5;
+  return sigma * sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static void test_run(double breath_Hz, double heart_Hz)
+{
+  cb_radar_vitals_config_st     config;
+  cb_uwbsystem_rx_cir_iqdata_st cir[DEF_RADAR_MAX_RANGE_BINS];
+
+  memset(&s_log, 0, sizeof(s_log));
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    s_log.time[i] = -1.0;
+  }
+  cb_radar_vitals_default_config(&config, TEST_FRAME_RATE_HZ);
+  CB_TEST_CHECK(cb_radar_vitals_init(&config, test_event) == CB_PASS);
+
+  for (uint32_t n = 0; n < (TEST_FRAME_RATE_HZ * TEST_DURATION_S); n++)
+  {
+    s_now = (double)n / TEST_FRAME_RATE_HZ;
+    for (uint16_t r = 0; r < DEF_RADAR_MAX_RANGE_BINS; r++)
+    {
+      double i = 300.0 * cos(r * 0.7) + test_gauss(15.0);
+      double q = 300.0 * sin(r * 1.3) + test_gauss(15.0);
+
+      if ((r == TEST_TARGET_BIN) && (s_now > TEST_ENTER_S) && (s_now < TEST_EXIT_S))
+      {
+        double d = 0.005 * sin(2.0 * M_PI * breath_Hz * s_now) + 0.0003 * sin(2.0 * M_PI * heart_Hz * s_now);
+        if ((s_now > TEST_WALK_START_S) && (s_now < TEST_WALK_END_S))
+        {
+          d += 0.5 * (s_now - TEST_WALK_START_S);
+        }
+        double phase = -4.0 * M_PI * (1.5 + d) / TEST_WAVELENGTH_M;
+        i += 400.0 * cos(phase);
+        q += 400.0 * sin(phase);
+      }
+      cir[r].I_data = (int16_t)lrint(i);
+      cir[r].Q_data = (int16_t)lrint(q);
+    }
+    cb_radar_vitals_process_frame(cir);
+  }
+
+  printf("breath %.1f/%.1f bpm, heart %.1f/%.1f bpm, enter %.1f s, motion %.1f-%.1f s, exit %.1f s\n",
+         s_log.breathRate_bpm, breath_Hz * 60.0, s_log.heartRate_bpm, heart_Hz * 60.0,
+         s_log.time[EN_RADAR_VITALS_EVENT_PRESENCE_ENTER], s_log.time[EN_RADAR_VITALS_EVENT_MOTION_START],
+         s_log.time[EN_RADAR_VITALS_EVENT_MOTION_STOP], s_log.time[EN_RADAR_VITALS_EVENT_PRESENCE_EXIT]);
+
+  CB_TEST_CHECK(s_log.count[EN_RADAR_VITALS_EVENT_PRESENCE_ENTER] == 1);
+  CB_TEST_CHECK((s_log.time[EN_RADAR_VITALS_EVENT_PRESENCE_ENTER] > TEST_ENTER_S) && (s_log.time[EN_RADAR_VITALS_EVENT_PRESENCE_ENTER] < (TEST_ENTER_S + 3.0)));
+  CB_TEST_CHECK(s_log.count[EN_RADAR_VITALS_EVENT_PRESENCE_EXIT] == 1);
+  // Exit: the background (10 s time constant) first absorbs the departed target, then 10 s of hold
+  CB_TEST_CHECK((s_log.time[EN_RADAR_VITALS_EVENT_PRESENCE_EXIT] > (TEST_EXIT_S + 10.0)) && (s_log.time[EN_RADAR_VITALS_EVENT_PRESENCE_EXIT] < (TEST_EXIT_S + 40.0)));
+  CB_TEST_CHECK((s_log.time[EN_RADAR_VITALS_EVENT_MOTION_START] > TEST_WALK_START_S) && (s_log.time[EN_RADAR_VITALS_EVENT_MOTION_START] < TEST_WALK_END_S));
+  CB_TEST_CHECK(s_log.time[EN_RADAR_VITALS_EVENT_MOTION_STOP] > TEST_WALK_START_S);
+  CB_TEST_CHECK(fabs(s_log.breathRate_bpm - breath_Hz * 60.0) < 1.0);
+  CB_TEST_CHECK(fabs(s_log.heartRate_bpm - heart_Hz * 60.0) < 3.0);
+  CB_TEST_CHECK(cb_radar_vitals_is_present() == CB_FALSE);
+}
+
+static void test_config_limits(void)
+{
+  cb_radar_vitals_config_st config;
+
+  cb_test_case("configuration limits");
+  cb_radar_vitals_default_config(&config, 20.0f);
+  config.numRangeBins = DEF_RADAR_MAX_RANGE_BINS + 1;
+  CB_TEST_CHECK(cb_radar_vitals_init(&config, test_event) == CB_FAIL);
+  cb_radar_vitals_default_config(&config, 3.0f);          // Below twice the heart band
+  CB_TEST_CHECK(cb_radar_vitals_init(&config, test_event) == CB_FAIL);
+  cb_radar_vitals_default_config(&config, 20.0f);
+  config.breathLow_Hz = config.breathHigh_Hz;
+  CB_TEST_CHECK(cb_radar_vitals_init(&config, test_event) == CB_FAIL);
+}
+
+int main(void)
+{
+  cb_test_case("15 breaths, 72 beats per minute");
+  test_run(0.25, 1.2);
+  cb_test_case("12 breaths, 90 beats per minute");
+  test_run(0.2, 1.5);
+  cb_test_case("18 breaths, 54 beats per minute");
+  test_run(0.3, 0.9);
+  test_config_limits();
+  return cb_test_result();
+}
@@ -0,0 +1,4 @@
+/* Host test stub of AppUwbCommTrx.h: declarations used by AppSysUartCommander.c */
+#ifndef __TEST_STUB_APPUWBCOMMTRX_H
+#define __TEST_STUB_APPUWBCOMMTRX_H
+#endif
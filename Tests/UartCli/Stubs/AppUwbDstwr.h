@@ -0,0 +1,5 @@
+/* Host test stub of AppUwbDstwr.h: declarations used by AppSysUartCommander.c */
+#ifndef __TEST_STUB_APPUWBDSTWR_H
+#define __TEST_STUB_APPUWBDSTWR_H
+void app_dstwr_suspend(void);
+#endif
@@ -0,0 +1,5 @@
+/* Host test stub of AppUwbPdoa.h: declarations used by AppSysUartCommander.c */
+#ifndef __TEST_STUB_APPUWBPDOA_H
+#define __TEST_STUB_APPUWBPDOA_H
+void app_pdoa_suspend(void);
+#endif
@@ -0,0 +1,6 @@
+/* Host test stub of AppUwbRadar.h: declarations used by AppSysUartCommander.c */
+#ifndef __TEST_STUB_APPUWBRADAR_H
+#define __TEST_STUB_APPUWBRADAR_H
+void app_radar_suspend(void);
+void app_radar_fft_benchmark(void);
+#endif
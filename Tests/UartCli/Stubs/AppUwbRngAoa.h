@@ -0,0 +1,5 @@
+/* Host test stub of AppUwbRngAoa.h: declarations used by AppSysUartCommander.c */
+#ifndef __TEST_STUB_APPUWBRNGAOA_H
+#define __TEST_STUB_APPUWBRNGAOA_H
+void app_rngaoa_suspend(void);
+#endif
@@ -0,0 +1,4 @@
+/* Host test stub of AppUwbTRXMemoryPool.h: declarations used by AppSysUartCommander.c */
+#ifndef __TEST_STUB_APPUWBTRXMEMORYPOOL_H
+#define __TEST_STUB_APPUWBTRXMEMORYPOOL_H
+#endif
@@ -0,0 +1,8 @@
+/* Host test stub of CB_Uart.h: the RX byte of the callbacks is set by the test */
+#ifndef __TEST_STUB_CB_UART_H
+#define __TEST_STUB_CB_UART_H
+#include <stdint.h>
+typedef enum { EN_UART_0 = 0, EN_UART_1 } enUartNum;
+uint8_t cb_uart_get_rx_byte(enUartNum uartNum);
+void    cb_uart_get_rx_buffer(enUartNum uartNum, uint8_t *buffer, uint16_t length);
+#endif
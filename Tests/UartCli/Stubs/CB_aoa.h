@@ -0,0 +1,4 @@
+/* Host test stub of CB_aoa.h: declarations used by AppSysUartCommander.c */
+#ifndef __TEST_STUB_CB_AOA_H
+#define __TEST_STUB_CB_AOA_H
+#endif
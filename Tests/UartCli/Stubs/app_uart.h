@@ -0,0 +1,5 @@
+/* Host test stub of app_uart.h: the prints are discarded */
+#ifndef __TEST_STUB_APP_UART_H
+#define __TEST_STUB_APP_UART_H
+#define app_uart_printf(...) ((void)0)
+#endif
@@ -0,0 +1,283 @@
+/**
+ * @file    test_uart_cli.c
+ * @brief   Host test of the uwb_CLI command assembler, hashed command table and argument parser.
+ * @details Feeds AppSysUartCommander.c byte by byte through its UART RX callback: text commands,
+ *          binary frames, malformed input and the binary frame timeout. The benchmark compares
+ *          the hashed table and single pass parser with the strtok/atoi linear scan it replaced.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "AppSysUartCommander.h"
+#include "TaskHandler.h"
+#include "CB_Uart.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_BENCH_ROUNDS     200000
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint8_t g_task_a_tx_execute;
+uint8_t g_task_a_rx_execute;
+uint8_t g_task_b_ini_execute;
+uint8_t g_task_b_resp_execute;
+uint8_t g_task_c_ini_execute;
+uint8_t g_task_c_resp_execute;
+uint8_t g_task_d_ini_execute;
+uint8_t g_task_d_resp_execute;
+uint8_t g_task_e_execute;
+uint8_t g_task_f_execute;
+uint8_t g_task_g_execute;
+
+static uint8_t  s_rxByte;
+static uint32_t s_tick;
+static uint32_t s_suspendCalls;
+static uint32_t s_benchCalls;
+static uint32_t s_benchArg;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint8_t  cb_uart_get_rx_byte(enUartNum uartNum)                                   { return s_rxByte; }
+void     cb_uart_get_rx_buffer(enUartNum uartNum, uint8_t *buffer, uint16_t len) { buffer[0] = s_rxByte; }
+uint32_t cb_hal_get_tick(void)                                                    { return s_tick; }
+void     app_dstwr_suspend(void)                                                  { s_suspendCalls++; }
+void     app_pdoa_suspend(void)                                                   { s_suspendCalls++; }
+void     app_rngaoa_suspend(void)                                                 { s_suspendCalls++; }
+void     app_radar_suspend(void)                                                  { s_suspendCalls++; }
+void     app_radar_fft_benchmark(void)                                            { }
+uint8_t  CB_GetCBLibMajorVersion(void)                                            { return 0; }
+uint8_t  CB_GetCBLibMinorVersion(void)                                            { return 0; }
+uint8_t  CB_GetCBLibPatchVersion(void)                                            { return 0; }
+void     app_uart_0_rxd_ready_callback(void);
+void     processUartRxBuffer(uint8_t *buf);
+
+static void test_send(const uint8_t *bytes, uint16_t len)
+{
+  for (uint16_t i = 0; i < len; i++)
+  {
+    s_rxByte = bytes[i];
+    app_uart_0_rxd_ready_callback();
+  }
+}
+
+static void test_send_text(const char *text)
+{
+  test_send((const uint8_t *)text, (uint16_t)strlen(text));
+}
+
+static uint16_t test_binary_frame(uint8_t *frame, char command, uint8_t argc, const uint32_t *args)
+{
+  uint16_t len = DEF_UART_CMD_BIN_HEADER_SIZE;
+  uint8_t  sum = 0;
+
+  frame[0] = DEF_UART_CMD_BIN_MARKER;
+  frame[1] = (uint8_t)command;
+  frame[2] = argc;
+  for (uint8_t i = 0; i < argc; i++)
+  {
+    for (uint8_t b = 0; b < 4; b++)
+    {
+      frame[len++] = (uint8_t)(args[i] >> (8 * b));
+    }
+  }
+  for (uint16_t i = 1; i < len; i++)
+  {
+    sum += frame[i];
+  }
+  frame[len++] = sum;
+  return len;
+}
+
+static void test_clear_tasks(void)
+{
+  g_task_a_tx_execute = g_task_a_rx_execute = 0;
+  g_task_b_ini_execute = g_task_b_resp_execute = 0;
+  g_task_c_ini_execute = g_task_c_resp_execute = 0;
+  g_task_d_ini_execute = g_task_d_resp_execute = 0;
+  g_task_g_execute = 0;
+  s_suspendCalls = 0;
+}
+
+static void test_text_commands(void)
+{
+  cb_test_case("text commands");
+  test_clear_tasks();
+  test_send_text("b,1\r");
+  CB_TEST_CHECK(g_task_b_ini_execute == 1);
+  test_send_text(" d , 2 \r");
+  CB_TEST_CHECK(g_task_d_resp_execute == 1);
+  test_send_text("g,0\r");
+  CB_TEST_CHECK(s_suspendCalls == 1);
+  test_send_text("ax\b,1\r");
+  CB_TEST_CHECK(g_task_a_tx_execute == 1);
+
+  test_clear_tasks();
+  test_send_text("b\r");            // Missing argument
+  test_send_text("b,1x\r");         // Malformed
+  test_send_text("b,\r");           // Empty
+  test_send_text("z,1\r");          // Unknown
+  test_send_text("B,1\r");          // Hash of 'b', different key
+  CB_TEST_CHECK(g_task_b_ini_execute == 0);
+  CB_TEST_CHECK(g_task_b_resp_execute == 0);
+
+  // Longer than the buffer: truncated, no overflow, and the next command is accepted
+  for (int i = 0; i < 300; i++)
+  {
+    test_send_text("9");
+  }
+  test_send_text("\r");
+  test_send_text("c,1\r");
+  CB_TEST_CHECK(g_task_c_ini_execute == 1);
+}
+
+static void test_binary_commands(void)
+{
+  uint8_t  frame[64];
+  uint32_t args[2] = {2, 0x12345678};
+  uint16_t len;
+
+  cb_test_case("binary commands");
+  test_clear_tasks();
+  len = test_binary_frame(frame, 'b', 2, args);
+  test_send(frame, len);
+  CB_TEST_CHECK(g_task_b_resp_execute == 1);
+
+  test_clear_tasks();
+  len = test_binary_frame(frame, 'd', 1, args);
+  frame[len - 1] ^= 0xFF;           // Bad checksum: dropped
+  test_send(frame, len);
+  CB_TEST_CHECK(g_task_d_resp_execute == 0);
+  test_send_text("d,1\r");          // Text accepted after the dropped frame
+  CB_TEST_CHECK(g_task_d_ini_execute == 1);
+
+  test_clear_tasks();
+  frame[0] = DEF_UART_CMD_BIN_MARKER;
+  frame[1] = 'a';
+  frame[2] = DEF_UART_CMD_MAX_ARGS + 1; // Too many arguments: dropped at the header
+  test_send(frame, 3);
+  test_send_text("a,2\r");
+  CB_TEST_CHECK(g_task_a_rx_execute == 1);
+}
+
+static void test_binary_timeout(void)
+{
+  uint8_t marker = DEF_UART_CMD_BIN_MARKER;
+
+  cb_test_case("stray binary marker");
+  test_clear_tasks();
+  s_tick = 1000;
+  test_send(&marker, 1);            // Stray marker, e.g. line noise
+  s_tick += DEF_UART_CMD_BIN_TIMEOUT_MS + 1;
+  test_send_text("c,2\r");
+  CB_TEST_CHECK(g_task_c_resp_execute == 1);
+
+  // A frame sent with gaps below the timeout is still assembled
+  uint8_t  frame[16];
+  uint32_t args[1] = {1};
+  uint16_t len = test_binary_frame(frame, 'b', 1, args);
+  test_clear_tasks();
+  for (uint16_t i = 0; i < len; i++)
+  {
+    s_tick += DEF_UART_CMD_BIN_TIMEOUT_MS;
+    test_send(&frame[i], 1);
+  }
+  CB_TEST_CHECK(g_task_b_ini_execute == 1);
+}
+
+//-------------------------------
+// Baseline: the strtok/atoi linear scan replaced by the hashed table
+//-------------------------------
+static void test_bench_handler(uint32_t const argc, uint32_t *args)
+{
+  s_benchCalls++;
+  s_benchArg += args[0];
+}
+
+typedef struct
+{
+  char        command;
+  ptrFunction handler;
+} test_linear_cmd_st;
+
+static test_linear_cmd_st s_linearTable[] =
+{
+  {'a', test_bench_handler}, {'b', test_bench_handler}, {'c', test_bench_handler}, {'d', test_bench_handler},
+  {'e', test_bench_handler}, {'g', test_bench_handler}, {'p', test_bench_handler},
+};
+
+static void test_linear_process(uint8_t *ptrUartRxBuffer)
+{
+  uint32_t args[16];
+  uint8_t  argCount = 0;
+  char    *token = strtok((char *)ptrUartRxBuffer, ",");
+
+  if (token != NULL)
+  {
+    char command = token[0];
+    while (((token = strtok(NULL, ",")) != NULL) && (argCount < 16))
+    {
+      args[argCount++] = (uint32_t)atoi(token);
+    }
+    for (uint8_t i = 0; i < (sizeof(s_linearTable) / sizeof(s_linearTable[0])); i++)
+    {
+      if (s_linearTable[i].command == command)
+      {
+        s_linearTable[i].handler(argCount, args);
+        break;
+      }
+    }
+  }
+}
+
+static void test_benchmark(void)
+{
+  static const char *commands[] = {"p,0", "g,1", "e,7", "d,1", "a,2", "b,1,2,3,4", "c,2"};
+  const uint32_t     count      = sizeof(commands) / sizeof(commands[0]);
+  uint8_t            buffer[64];
+  uint64_t           start;
+  uint64_t           linearNs;
+  uint64_t           hashedNs;
+
+  cb_test_case("benchmark: hashed table and single pass parser vs strtok/atoi linear scan");
+  s_benchCalls = 0;
+  start = cb_test_time_ns();
+  for (uint32_t i = 0; i < TEST_BENCH_ROUNDS; i++)
+  {
+    strcpy((char *)buffer, commands[i % count]);
+    test_linear_process(buffer);
+  }
+  linearNs = cb_test_time_ns() - start;
+  CB_TEST_CHECK(s_benchCalls == TEST_BENCH_ROUNDS);
+
+  // The real handlers run on 'p', 'e' and the task flags: same work per command on both sides
+  test_clear_tasks();
+  start = cb_test_time_ns();
+  for (uint32_t i = 0; i < TEST_BENCH_ROUNDS; i++)
+  {
+    strcpy((char *)buffer, commands[i % count]);
+    processUartRxBuffer(buffer);
+  }
+  hashedNs = cb_test_time_ns() - start;
+  CB_TEST_CHECK(g_task_b_ini_execute == 1);
+
+  printf("linear scan + strtok/atoi: %.1f ns/command\n", (double)linearNs / TEST_BENCH_ROUNDS);
+  printf("hashed table + one pass:   %.1f ns/command\n", (double)hashedNs / TEST_BENCH_ROUNDS);
+}
+
+int main(void)
+{
+  test_text_commands();
+  test_binary_commands();
+  test_binary_timeout();
+  test_benchmark();
+  return cb_test_result();
+}
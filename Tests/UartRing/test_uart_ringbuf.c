@@ -0,0 +1,204 @@
+/**
+ * @file    test_uart_ringbuf.c
+ * @brief   Host test of the UART RX ring buffer of CB_Uart.c.
+ * @details The UART register blocks are host variables and the SDMA is simulated: each received
+ *          byte is written at the next buffer position (wrap enabled) and the 12-bit RXB_NBYTE
+ *          field of TRX counts it, wrapping at 0x1000. Checks that a byte stream read back in
+ *          chunks of any size is intact across the buffer and counter wraps, for buffer sizes
+ *          that do and do not divide 0x1000, and that an overrun is detected, reported and
+ *          recovered from.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "cb_test.h"
+#include "CB_PeripheralPhyAddrDataBase.h"
+
+static UART_TypeDef s_fakeUart[2];
+#undef  UART0_BASE_ADDR
+#undef  UART1_BASE_ADDR
+#define UART0_BASE_ADDR (&s_fakeUart[0])
+#define UART1_BASE_ADDR (&s_fakeUart[1])
+#include "CB_Uart.c"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_STREAM_BYTES     50000
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static uint8_t  *s_rxBuffer;
+static uint16_t  s_rxSize;
+static uint32_t  s_dmaCount;          // Bytes written by the simulated SDMA
+static uint32_t  s_events[3];
+static uint16_t  s_eventAvailable;
+static uint32_t  s_seed = 1;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint32_t test_rand(uint32_t range)
+{
+  s_seed = (s_seed * 1103515245U) + 12345U;
+  return (s_seed >> 8) % range;
+}
+
+static void test_dma_push(uint32_t numBytes)
+{
+  for (uint32_t i = 0; i < numBytes; i++)
+  {
+    s_rxBuffer[s_dmaCount % s_rxSize] = (uint8_t)(s_dmaCount * 7);
+    s_dmaCount++;
+  }
+  s_fakeUart[0].TRX = (s_fakeUart[0].TRX & ~UART_RXB_NBYTE_MSK) | ((s_dmaCount << UART_RXB_NBYTE_POS) & UART_RXB_NBYTE_MSK);
+}
+
+static void test_event(enUartChannel uartChannel, enUartRingBufEvent event, uint16_t numAvailable)
+{
+  s_events[event]++;
+  s_eventAvailable = numAvailable;
+}
+
+static void test_ring_init(uint16_t size)
+{
+  stUartConfig config = {0};
+
+  memset(&s_fakeUart[0], 0, sizeof(UART_TypeDef));
+  memset(s_events, 0, sizeof(s_events));
+  s_rxBuffer         = cb_test_alloc_32bit(size);
+  s_rxSize           = size;
+  s_dmaCount         = 0;
+  config.uartChannel = EN_UART_0;
+  config.uartInt     = EN_UART_INT_RXB_FULL;
+  config.RXbuffer    = (uint32_t)(uintptr_t)s_rxBuffer;
+  cb_uart_ringbuf_init(&config, size);
+  CB_TEST_CHECK(config.uartMode == EN_UART_MODE_SDMA);
+  CB_TEST_CHECK((config.uartInt & EN_UART_INT_RXB_FULL) == 0);
+}
+
+/**
+ * Streams TEST_STREAM_BYTES through the ring, in random bursts never exceeding the free space,
+ * read back with random peek/read/skip sizes. Returns the number of corrupted bytes.
+ */
+static uint32_t test_stream(uint16_t size)
+{
+  uint8_t  chunk[512];
+  uint32_t readCount = 0;
+  uint32_t errors    = 0;
+
+  test_ring_init(size);
+  while (readCount < TEST_STREAM_BYTES)
+  {
+    uint32_t unread = s_dmaCount - readCount;
+    test_dma_push(test_rand(size - unread + 1));
+    CB_TEST_CHECK(cb_uart_ringbuf_available(EN_UART_0) == (s_dmaCount - readCount));
+
+    uint16_t numBytes = (uint16_t)test_rand(sizeof(chunk) + 1);
+    if ((readCount & 1) != 0)
+    {
+      // Peek at an offset, then consume through skip
+      uint16_t offset = (uint16_t)test_rand(8);
+      uint16_t peeked = cb_uart_ringbuf_peek(EN_UART_0, chunk, offset, numBytes);
+      for (uint16_t i = 0; i < peeked; i++)
+      {
+        errors += (chunk[i] != (uint8_t)((readCount + offset + i) * 7));
+      }
+      readCount += cb_uart_ringbuf_skip(EN_UART_0, (uint16_t)(offset + peeked));
+    }
+    else
+    {
+      uint16_t len = cb_uart_ringbuf_read(EN_UART_0, chunk, numBytes);
+      for (uint16_t i = 0; i < len; i++)
+      {
+        errors += (chunk[i] != (uint8_t)((readCount + i) * 7));
+      }
+      readCount += len;
+    }
+  }
+  CB_TEST_CHECK(cb_uart_ringbuf_get_overruns(EN_UART_0) == 0);
+  return errors;
+}
+
+static void test_wrap(void)
+{
+  cb_test_case("stream across the buffer and RXB_NBYTE wraps");
+  CB_TEST_CHECK(test_stream(256) == 0);    // Divides 0x1000
+  CB_TEST_CHECK(test_stream(1000) == 0);   // Does not divide 0x1000
+  CB_TEST_CHECK(test_stream(0xFFF) == 0);  // Largest buffer
+}
+
+static void test_full_and_overrun(void)
+{
+  uint8_t chunk[300];
+
+  cb_test_case("full buffer and overrun");
+  test_ring_init(300);
+  cb_uart_ringbuf_config_event(EN_UART_0, 0, 0, test_event);
+  test_dma_push(4000);                     // Counter close to its wrap
+  cb_uart_ringbuf_available(EN_UART_0);    // Overrun: 4000 bytes unread
+  CB_TEST_CHECK(cb_uart_ringbuf_get_overruns(EN_UART_0) == 1);
+  cb_uart_ringbuf_service(EN_UART_0);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_OVERRUN] == 1);
+  CB_TEST_CHECK(s_eventAvailable == 0);
+  cb_uart_ringbuf_service(EN_UART_0);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_OVERRUN] == 1);   // Reported once
+
+  // Exactly full is not an overrun: all bytes are intact
+  test_dma_push(300);
+  CB_TEST_CHECK(cb_uart_ringbuf_available(EN_UART_0) == 300);
+  CB_TEST_CHECK(cb_uart_ringbuf_read(EN_UART_0, chunk, sizeof(chunk)) == 300);
+  uint32_t errors = 0;
+  for (uint16_t i = 0; i < 300; i++)
+  {
+    errors += (chunk[i] != (uint8_t)((4000 + i) * 7));
+  }
+  CB_TEST_CHECK(errors == 0);
+
+  // One more byte than the buffer overruns, the stream resumes on the next bytes
+  test_dma_push(301);
+  CB_TEST_CHECK(cb_uart_ringbuf_available(EN_UART_0) == 0);
+  CB_TEST_CHECK(cb_uart_ringbuf_get_overruns(EN_UART_0) == 2);
+  test_dma_push(10);
+  CB_TEST_CHECK(cb_uart_ringbuf_read(EN_UART_0, chunk, sizeof(chunk)) == 10);
+  CB_TEST_CHECK(chunk[0] == (uint8_t)((4000 + 300 + 301) * 7));
+  CB_TEST_CHECK(chunk[9] == (uint8_t)((4000 + 300 + 301 + 9) * 7));
+}
+
+static void test_events(void)
+{
+  cb_test_case("threshold and idle events");
+  test_ring_init(256);
+  cb_uart_ringbuf_config_event(EN_UART_0, 100, 3, test_event);
+  test_dma_push(99);
+  cb_uart_ringbuf_service(EN_UART_0);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_THRESHOLD] == 0);
+  test_dma_push(1);
+  cb_uart_ringbuf_service(EN_UART_0);
+  cb_uart_ringbuf_service(EN_UART_0);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_THRESHOLD] == 1);
+  CB_TEST_CHECK(s_eventAvailable == 100);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_IDLE] == 0);
+  cb_uart_ringbuf_service(EN_UART_0);
+  cb_uart_ringbuf_service(EN_UART_0);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_IDLE] == 1);
+  cb_uart_ringbuf_service(EN_UART_0);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_IDLE] == 1);
+  cb_uart_ringbuf_skip(EN_UART_0, 100);
+  test_dma_push(100);
+  cb_uart_ringbuf_service(EN_UART_0);
+  CB_TEST_CHECK(s_events[EN_UART_RINGBUF_EVENT_THRESHOLD] == 2);
+}
+
+int main(void)
+{
+  test_wrap();
+  test_full_and_overrun();
+  test_events();
+  return cb_test_result();
+}
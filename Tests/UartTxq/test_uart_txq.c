@@ -0,0 +1,199 @@
+/**
+ * @file    test_uart_txq.c
+ * @brief   Host test of the UART SDMA TX queue of CB_Uart.c.
+ * @details The UART register blocks are host variables. A started SDMA transfer is "sent" by
+ *          the test: the bytes at TXBUF/BUF_SIZE go to a sink, TXB empty is set and the UART
+ *          IRQ handler runs if the interrupt is enabled. Checks the byte stream and completion
+ *          order of random frames, empty frames and segments, and that the IRQ handler restarts
+ *          RX on RX events only.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "cb_test.h"
+#include "CB_PeripheralPhyAddrDataBase.h"
+
+static UART_TypeDef s_fakeUart[2];
+#undef  UART0_BASE_ADDR
+#undef  UART1_BASE_ADDR
+#define UART0_BASE_ADDR (&s_fakeUart[0])
+#define UART1_BASE_ADDR (&s_fakeUart[1])
+#include "CB_Uart.c"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_TXQ_BUF_SIZE     64
+#define TEST_SINK_SIZE        262144
+#define TEST_FRAMES           2000
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static uint8_t  *s_txqBuffer;
+static uint8_t   s_sink[TEST_SINK_SIZE];
+static uint32_t  s_sinkLength;
+static uint32_t  s_transfers;
+static uint32_t  s_doneCount;
+static uint32_t  s_doneOrderErrors;
+static uint32_t  s_seed = 7;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint32_t test_rand(uint32_t range)
+{
+  s_seed = (s_seed * 1103515245U) + 12345U;
+  return (s_seed >> 8) % range;
+}
+
+static void test_done(enUartChannel uartChannel, void *context)
+{
+  s_doneOrderErrors += ((uint32_t)(uintptr_t)context != s_doneCount);
+  s_doneCount++;
+}
+
+/**
+ * Completes the transfer on the line, if any: one TXB empty interrupt.
+ */
+static uint8_t test_line_complete(void)
+{
+  UART_TypeDef *UART = &s_fakeUart[0];
+
+  if ((UART->TXCTRL & UART_TXCTRL_START) == 0)
+  {
+    return CB_FALSE;
+  }
+  uint32_t length = UART->BUF_SIZE & 0xFFF;
+  memcpy(&s_sink[s_sinkLength], (const void *)(uintptr_t)UART->TXBUF, length);
+  s_sinkLength += length;
+  s_transfers++;
+  UART->TXCTRL = 0;
+  UART->EVENT |= UART_EVENT_TXB_EMPTY;
+  if (UART->INT_EN & EN_UART_INT_TXB_EMPTY)
+  {
+    cb_uart_0_irqhandler();
+  }
+  UART->EVENT &= ~UART_EVENT_TXB_EMPTY;
+  return CB_TRUE;
+}
+
+static void test_txq_init(void)
+{
+  memset(&s_fakeUart[0], 0, sizeof(UART_TypeDef));
+  s_txqBuffer  = cb_test_alloc_32bit(TEST_TXQ_BUF_SIZE);
+  s_sinkLength = 0;
+  s_transfers  = 0;
+  s_doneCount  = 0;
+  cb_uart_txq_init(EN_UART_0, s_txqBuffer, TEST_TXQ_BUF_SIZE);
+}
+
+static void test_stream(void)
+{
+  static uint8_t  source[TEST_SINK_SIZE];
+  uint32_t        sourceLength = 0;
+  uint32_t        frames       = 0;
+
+  cb_test_case("random frames through the ping-pong buffers");
+  test_txq_init();
+  for (uint32_t i = 0; i < sizeof(source); i++)
+  {
+    source[i] = (uint8_t)test_rand(256);
+  }
+  while (frames < TEST_FRAMES)
+  {
+    stUartTxSegment segments[UART_TXQ_MAX_SEGMENTS];
+    uint8_t         numSegments = (uint8_t)(1 + test_rand(UART_TXQ_MAX_SEGMENTS));
+    uint32_t        frameLength = 0;
+
+    for (uint8_t i = 0; i < numSegments; i++)
+    {
+      segments[i].data   = &source[sourceLength + frameLength];
+      segments[i].length = (uint16_t)test_rand(40);     // Empty segments included
+      frameLength       += segments[i].length;
+    }
+    if (frameLength == 0)
+    {
+      CB_TEST_CHECK(cb_uart_txq_send(EN_UART_0, segments, numSegments, test_done, NULL) == CB_FAIL);
+      continue;
+    }
+    if (cb_uart_txq_send(EN_UART_0, segments, numSegments, test_done, (void *)(uintptr_t)frames) == CB_PASS)
+    {
+      sourceLength += frameLength;
+      frames++;
+    }
+    if (test_rand(3) == 0)
+    {
+      test_line_complete();
+    }
+  }
+  while (test_line_complete());
+  CB_TEST_CHECK(s_doneCount == TEST_FRAMES);
+  CB_TEST_CHECK(s_doneOrderErrors == 0);
+  CB_TEST_CHECK(s_sinkLength == sourceLength);
+  CB_TEST_CHECK(memcmp(s_sink, source, sourceLength) == 0);
+  CB_TEST_CHECK(cb_uart_txq_is_busy(EN_UART_0) == CB_FALSE);
+  CB_TEST_CHECK((s_fakeUart[0].INT_EN & EN_UART_INT_TXB_EMPTY) == 0);
+  printf("%u frames, %u bytes, %u SDMA transfers\n", TEST_FRAMES, sourceLength, s_transfers);
+}
+
+static void test_empty_frames(void)
+{
+  static const uint8_t data[TEST_TXQ_BUF_SIZE / 2] = {1, 2, 3};
+  stUartTxSegment      segments[3];
+
+  cb_test_case("empty frames and segments");
+  test_txq_init();
+  segments[0].data   = data;
+  segments[0].length = 0;
+  CB_TEST_CHECK(cb_uart_txq_send(EN_UART_0, segments, 1, test_done, NULL) == CB_FAIL);
+  CB_TEST_CHECK(cb_uart_txq_is_busy(EN_UART_0) == CB_FALSE);
+  CB_TEST_CHECK(cb_uart_txq_free_slots(EN_UART_0) == UART_TXQ_DEPTH);
+
+  // Frame filling one buffer exactly, with a trailing empty segment: completes with its last byte
+  segments[0].length = sizeof(data);
+  segments[1].data   = data;
+  segments[1].length = 0;
+  CB_TEST_CHECK(cb_uart_txq_send(EN_UART_0, segments, 2, test_done, (void *)0) == CB_PASS);
+  while (test_line_complete());
+  CB_TEST_CHECK(s_doneCount == 1);
+  CB_TEST_CHECK(s_sinkLength == sizeof(data));
+  CB_TEST_CHECK(cb_uart_txq_is_busy(EN_UART_0) == CB_FALSE);
+}
+
+static void test_rx_restart(void)
+{
+  static const uint8_t data[8] = {0};
+  stUartTxSegment      segment = {data, sizeof(data)};
+
+  cb_test_case("IRQ handler restarts RX on RX events only");
+  test_txq_init();
+  s_fakeUart[0].INT_EN |= EN_UART_INT_RXB_FULL;
+  s_fakeUart[0].RXCTRL  = 0;
+  cb_uart_txq_send(EN_UART_0, &segment, 1, NULL, NULL);
+  while (test_line_complete());
+  CB_TEST_CHECK(s_fakeUart[0].RXCTRL == 0);                  // TXB empty IRQs: reception untouched
+
+  s_fakeUart[0].EVENT |= UART_EVENT_RXB_FULL;
+  cb_uart_0_irqhandler();
+  CB_TEST_CHECK(s_fakeUart[0].RXCTRL == UART_RXCTRL_START);
+  s_fakeUart[0].EVENT = 0;
+
+  s_fakeUart[0].RXCTRL  = 0;
+  s_fakeUart[0].EVENT  |= UART_EVENT_FRAME_ERR;
+  cb_uart_0_irqhandler();
+  CB_TEST_CHECK(s_fakeUart[0].RXCTRL == UART_RXCTRL_START);
+  s_fakeUart[0].EVENT = 0;
+}
+
+int main(void)
+{
+  test_stream();
+  test_empty_frames();
+  test_rx_restart();
+  return cb_test_result();
+}
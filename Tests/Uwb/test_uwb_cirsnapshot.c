@@ -0,0 +1,240 @@
+/**
+ * @file    test_uwb_cirsnapshot.c
+ * @brief   Host test of the PDoA CIR snapshot engine of CB_uwbframework.
+ * @details The DMA driver is a test model: it records the descriptor chain and copies it when the
+ *          test runs the transfer. DMA addresses are 32-bit, so the model maps them back to the
+ *          test CIR memory and the slot ring. Checks the slot ready bits, the IRQ and polled
+ *          completion, the CPU copy fallbacks and that an enabled DMA module is not re-initialized.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdint.h>
+#include <string.h>
+#include "cb_test.h"
+#include "CB_uwbframework.h"
+#include "CB_dma.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_CIR_BASE       0x41000800UL
+#define TEST_CIR_STRIDE     0x800UL
+#define TEST_CIR_SAMPLES    256U
+#define TEST_CTL_IDX        100U
+#define TEST_WINDOW_START   (TEST_CTL_IDX - DEF_PDOA_CIR_DATASET_OFFSET)
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+extern cb_uwbsystem_rx_cir_iqdata_st g_stPdoaRxCirDataContainer[DEF_PDOA_NUMPKT_SUPERFRAME_MAX][DEF_PDOA_NUM_RX_USED][DEF_PDOA_NUM_CIR_DATASET];
+
+uint32_t SystemCoreClock = 64000000;
+
+static cb_uwbsystem_rx_cir_iqdata_st s_cirMem[DEF_PDOA_NUM_RX_USED][TEST_CIR_SAMPLES];
+static uint16_t     s_ctlIdx = TEST_CTL_IDX;
+static uint32_t     s_cpuCopies;             // Port windows copied by cb_system_uwb_store_rx_cir_register()
+static uint8_t      s_dmaEnabled;
+static uint32_t     s_dmaInits;
+static uint8_t      s_dmaIdle = CB_TRUE;
+static uint8_t      s_dmaChannelOn;
+static uint32_t     s_srcRequests;
+static uint32_t     s_destRequests;
+static struct stDMALinkedListHead *s_dmaHead;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint16_t cb_system_uwb_get_rx_cir_ctl_idx(void)        { return s_ctlIdx; }
+void     cb_system_delay_in_us(uint32_t microseconds)  { }
+void     cb_dma_init(void)                             { s_dmaInits++; s_dmaEnabled = CB_TRUE; }
+uint8_t  cb_dma_is_enabled(void)                       { return s_dmaEnabled; }
+void     cb_dma_enable_channel(stDMAConfig *DMAConfig) { s_dmaChannelOn = CB_TRUE; s_dmaIdle = CB_FALSE; }
+void     cb_dma_disable_channel(stDMAConfig *DMAConfig){ s_dmaChannelOn = CB_FALSE; }
+void     cb_dma_lli_init(struct stDMALinkedListHead *DMALLiConfig) { s_dmaHead = DMALLiConfig; }
+void     cb_dma_lli_setup(struct stDMALinkedListHead *DMALLiConfig, struct stDMALinkedListNode *LLiNode) { }
+void     cb_dma_set_src_request(stDMAConfig *DMAConfig)  { s_srcRequests++; }
+void     cb_dma_set_dest_request(stDMAConfig *DMAConfig) { s_destRequests++; }
+uint8_t  cb_dma_is_channel_idle(stDMAConfig *DMAConfig)  { return s_dmaIdle; }
+
+static uint32_t test_port_index(cb_uwbsystem_rxport_en enRxPort)
+{
+  return (enRxPort == EN_UWB_RX_0) ? 0 : ((enRxPort == EN_UWB_RX_1) ? 1 : 2);
+}
+
+uint32_t cb_system_uwb_get_rx_cir_register_addr(cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples)
+{
+  if ((startingPosition + numSamples) > TEST_CIR_SAMPLES)
+  {
+    return 0;
+  }
+  return TEST_CIR_BASE + (test_port_index(enRxPort) * TEST_CIR_STRIDE) + (startingPosition * sizeof(cb_uwbsystem_rx_cir_iqdata_st));
+}
+
+void cb_system_uwb_store_rx_cir_register(cb_uwbsystem_rx_cir_iqdata_st* destArray, cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples)
+{
+  s_cpuCopies++;
+  if ((startingPosition + numSamples) <= TEST_CIR_SAMPLES)
+  {
+    memcpy(destArray, &s_cirMem[test_port_index(enRxPort)][startingPosition], numSamples * sizeof(cb_uwbsystem_rx_cir_iqdata_st));
+  }
+}
+
+/**
+ * @brief Fills the CIR memory of the three ports with values tagged by the packet.
+ */
+static void test_receive(uint8_t packet)
+{
+  for (uint32_t port = 0; port < DEF_PDOA_NUM_RX_USED; port++)
+  {
+    for (uint32_t i = 0; i < TEST_CIR_SAMPLES; i++)
+    {
+      s_cirMem[port][i].I_data = (int16_t)((packet * 1000) + (port * 300) + i);
+      s_cirMem[port][i].Q_data = (int16_t)-(packet + 1);
+    }
+  }
+}
+
+/**
+ * @brief Copies one descriptor: the 32-bit destination is looked up in the slot ring.
+ */
+static uint8_t test_dma_copy(const stDMAConfig *desc)
+{
+  uint32_t port = (desc->SrcAddr - TEST_CIR_BASE) / TEST_CIR_STRIDE;
+  uint32_t pos  = ((desc->SrcAddr - TEST_CIR_BASE) % TEST_CIR_STRIDE) / sizeof(cb_uwbsystem_rx_cir_iqdata_st);
+
+  for (uint8_t slot = 0; slot < DEF_PDOA_NUMPKT_SUPERFRAME_MAX; slot++)
+  {
+    for (uint8_t p = 0; p < DEF_PDOA_NUM_RX_USED; p++)
+    {
+      if (desc->DestAddr == (uint32_t)(uintptr_t)g_stPdoaRxCirDataContainer[slot][p])
+      {
+        memcpy(g_stPdoaRxCirDataContainer[slot][p], &s_cirMem[port][pos], desc->DataLen);
+        return CB_TRUE;
+      }
+    }
+  }
+  return CB_FALSE;
+}
+
+/**
+ * @brief Runs the recorded chain to the end and leaves the channel idle.
+ *
+ * @return Number of descriptors copied.
+ */
+static uint32_t test_dma_run(void)
+{
+  uint32_t copied = test_dma_copy(&s_dmaHead->DMAConfig);
+
+  for (struct stDMALinkedListNode *node = s_dmaHead->NextNode; node != NULL; node = node->NextNode)
+  {
+    copied += test_dma_copy(&node->DMAConfig);
+  }
+  s_dmaIdle = CB_TRUE;
+  return copied;
+}
+
+/**
+ * @brief A port of a slot holds the CIR window of the packet.
+ */
+static uint8_t test_slot_holds(uint8_t slot, uint8_t port, uint8_t packet)
+{
+  test_receive(packet);
+  return (memcmp(g_stPdoaRxCirDataContainer[slot][port], &s_cirMem[port][TEST_WINDOW_START],
+                 sizeof(g_stPdoaRxCirDataContainer[slot][port])) == 0) ? CB_TRUE : CB_FALSE;
+}
+
+static void test_dma_path(void)
+{
+  cb_test_case("DMA snapshot: one chain, slot ready on completion");
+  cb_framework_uwb_pdoa_reset_cir_data_container();
+  cb_framework_uwb_pdoa_cir_snapshot_init(EN_UWB_RX_ALL);
+  CB_TEST_CHECK(s_dmaInits == 1);
+
+  test_receive(1);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(0) == CB_TRUE);
+  CB_TEST_CHECK((s_cpuCopies == 0) && s_dmaChannelOn && (s_srcRequests == 3) && (s_destRequests == 3));
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_is_ready(0) == CB_FALSE);
+  CB_TEST_CHECK(test_dma_run() == 3);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_is_ready(0) == CB_FALSE);
+  cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback();
+  CB_TEST_CHECK((cb_framework_uwb_pdoa_cir_snapshot_is_ready(0) == CB_TRUE) && !s_dmaChannelOn);
+  CB_TEST_CHECK(test_slot_holds(0, 0, 1) && test_slot_holds(0, 1, 1) && test_slot_holds(0, 2, 1));
+
+  // Completion found by polling, without the IRQ callback
+  test_receive(2);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(1) == CB_TRUE);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_wait(2) == CB_FALSE);    // Times out, slot 1 in flight
+  CB_TEST_CHECK(test_dma_run() == 3);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_wait(2) == CB_TRUE);
+  CB_TEST_CHECK(test_slot_holds(1, 2, 2) && test_slot_holds(0, 2, 1));
+
+  // Slot reuse: the ready bit is cleared when the next snapshot of the slot starts
+  test_receive(3);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(DEF_PDOA_NUMPKT_SUPERFRAME_MAX) == CB_TRUE);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_is_ready(0) == CB_FALSE);
+  (void)test_dma_run();
+  cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback();
+  CB_TEST_CHECK((cb_framework_uwb_pdoa_cir_snapshot_is_ready(0) == CB_TRUE) && test_slot_holds(0, 1, 3));
+
+  // Two ports: two descriptors, the slot still ready on completion
+  cb_framework_uwb_pdoa_cir_snapshot_deinit();
+  cb_framework_uwb_pdoa_cir_snapshot_init(EN_UWB_RX_02);
+  CB_TEST_CHECK(s_dmaInits == 1);                       // Enabled module left alone
+  test_receive(4);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(2) == CB_TRUE);
+  CB_TEST_CHECK(test_dma_run() == 2);
+  cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback();
+  CB_TEST_CHECK((cb_framework_uwb_pdoa_cir_snapshot_is_ready(2) == CB_TRUE) && test_slot_holds(2, 0, 4) && test_slot_holds(2, 2, 4));
+  CB_TEST_CHECK(s_cpuCopies == 0);
+  cb_framework_uwb_pdoa_cir_snapshot_deinit();
+}
+
+static void test_fallbacks(void)
+{
+  cb_test_case("CPU copy fallbacks: slot copied and ready");
+  // Engine not initialized
+  s_cpuCopies = 0;
+  test_receive(5);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(3) == CB_FALSE);
+  CB_TEST_CHECK((s_cpuCopies == 3) && (cb_framework_uwb_pdoa_cir_snapshot_is_ready(3) == CB_TRUE) && test_slot_holds(3, 1, 5));
+
+  // Previous snapshot stuck on the channel
+  cb_framework_uwb_pdoa_cir_snapshot_init(EN_UWB_RX_ALL);
+  test_receive(6);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(0) == CB_TRUE);
+  s_cpuCopies = 0;
+  test_receive(7);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(1) == CB_FALSE);
+  CB_TEST_CHECK((s_cpuCopies == 3) && (cb_framework_uwb_pdoa_cir_snapshot_is_ready(1) == CB_TRUE) && test_slot_holds(1, 0, 7));
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_is_ready(0) == CB_FALSE);
+  (void)test_dma_run();
+  cb_framework_uwb_pdoa_cir_snapshot_dma_irq_callback();
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_is_ready(0) == CB_TRUE);
+
+  // CIR window beyond the register memory
+  s_cpuCopies = 0;
+  s_srcRequests = 0;
+  s_ctlIdx = TEST_CIR_SAMPLES;
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(2) == CB_FALSE);
+  CB_TEST_CHECK((s_cpuCopies == 3) && (s_srcRequests == 0) && (cb_framework_uwb_pdoa_cir_snapshot_is_ready(2) == CB_TRUE));
+  s_ctlIdx = TEST_CTL_IDX;
+
+  // No RX port selected for the DMA
+  cb_framework_uwb_pdoa_cir_snapshot_deinit();
+  cb_framework_uwb_pdoa_cir_snapshot_init((cb_uwbsystem_rxport_en)0);
+  s_cpuCopies = 0;
+  test_receive(8);
+  CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(4) == CB_FALSE);
+  CB_TEST_CHECK((s_cpuCopies == 3) && (s_srcRequests == 0) && (cb_framework_uwb_pdoa_cir_snapshot_is_ready(4) == CB_TRUE) && test_slot_holds(4, 2, 8));
+  cb_framework_uwb_pdoa_cir_snapshot_deinit();
+}
+
+int main(void)
+{
+  test_dma_path();
+  test_fallbacks();
+  return cb_test_result();
+}
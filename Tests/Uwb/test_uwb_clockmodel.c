@@ -0,0 +1,166 @@
+/**
+ * @file    test_uwb_clockmodel.c
+ * @brief   Host test of the CB_uwbclockmodel sync pulse estimator.
+ * @details Pulse trains of a drifting clock with Gaussian jitter, missed pulses and spikes: the
+ *          drift estimate, the missed pulse count and the network to local translation are
+ *          checked against the true clock. Also a phase jump of the master, the pulse index and
+ *          a glitch pulse.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <stdlib.h>
+#include "cb_test.h"
+#include "CB_uwbclockmodel.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_PERIOD_NS      1000000000U
+#define TEST_LOCAL_START_NS 123456789.0
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  const char *name;
+  double      ppm;            // Drift of the local clock
+  double      sigmaNs;        // Capture jitter
+  int         missPct;
+  int         spikePct;
+  double      spikeNs;
+  int         pulses;
+} test_train_st;
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static const test_train_st s_trains[] =
+{
+  { "ideal",                      20.0,   0.0,  0, 0,     0.0,  200 },
+  { "jitter 100 ns",             -35.0, 100.0,  0, 0,     0.0, 2000 },
+  { "jitter 100 ns, 10% missed",  50.0, 100.0, 10, 0,     0.0, 2000 },
+  { "jitter 100 ns, 3% spikes",   10.0, 100.0,  0, 3, 20000.0, 2000 },
+  { "jitter 500 ns, all",        -80.0, 500.0, 10, 3, 50000.0, 2000 },
+};
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static double test_gauss(void)
+{
+  double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+  double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double test_true_local(const test_train_st *train, double pulses)
+{
+  return TEST_LOCAL_START_NS + (pulses * TEST_PERIOD_NS * (1.0 + (train->ppm * 1e-6)));
+}
+
+static void test_train(const test_train_st *train)
+{
+  cb_uwbclockmodel_st model;
+  uint32_t missed    = 0;
+  uint32_t spikes    = 0;
+  uint32_t roundTrip = 0;
+  double   maxErrNs  = 0.0;
+  double   sumSq     = 0.0;
+  uint32_t n         = 0;
+
+  cb_test_case(train->name);
+  cb_uwbclockmodel_reset(&model, TEST_PERIOD_NS);
+  for (int k = 0; k < train->pulses; k++)
+  {
+    if ((k > 0) && ((rand() % 100) < train->missPct))
+    {
+      missed++;
+      continue;
+    }
+    uint8_t spike   = (k > 10) && ((rand() % 100) < train->spikePct);
+    double  capture = test_true_local(train, k) + (train->sigmaNs * test_gauss()) + (spike ? train->spikeNs : 0.0);
+    spikes += spike;
+    (void)cb_uwbclockmodel_add_pulse(&model, (int64_t)llround(capture));
+
+    // Half a period after the pulse
+    if (model.locked && (k > 20))
+    {
+      int64_t network = (int64_t)((k + 0.5) * TEST_PERIOD_NS);
+      int64_t local   = cb_uwbclockmodel_network_to_local(&model, network);
+      double  errNs   = fabs((double)local - test_true_local(train, k + 0.5));
+      maxErrNs = (errNs > maxErrNs) ? errNs : maxErrNs;
+      sumSq   += errNs * errNs;
+      n++;
+      roundTrip += (llabs(cb_uwbclockmodel_local_to_network(&model, local) - network) > 1);
+    }
+  }
+
+  const cb_uwbclockmodel_stats_st *stats = &model.stats;
+  printf("drift %+.3f ppm, missed %u, outliers %u of %u spikes, restarts %u, jitter rms %.0f ns, "
+         "translation rms %.0f max %.0f ns\n", cb_uwbclockmodel_drift_ppm(&model), stats->missed,
+         stats->outliers, spikes, stats->restarts,
+         (stats->jitterCount != 0) ? sqrt(stats->jitterSumSq / stats->jitterCount) : 0.0,
+         (n != 0) ? sqrt(sumSq / n) : 0.0, maxErrNs);
+  CB_TEST_CHECK(fabs(cb_uwbclockmodel_drift_ppm(&model) - train->ppm) < (0.01 + (5.0 * train->sigmaNs / TEST_PERIOD_NS * 1e6)));
+  CB_TEST_CHECK(stats->missed == missed);
+  CB_TEST_CHECK(stats->outliers >= spikes);
+  CB_TEST_CHECK(stats->restarts == 0);
+  CB_TEST_CHECK((n != 0) && (roundTrip == 0));
+  CB_TEST_CHECK(maxErrNs < (10.0 + (5.0 * train->sigmaNs)));
+}
+
+static void test_phase_jump(void)
+{
+  cb_uwbclockmodel_st        model;
+  cb_uwbclockmodel_result_en result;
+  int64_t  localNs   = 0;
+  int      restartAt = 0;
+  uint32_t before;
+  int64_t  network;
+
+  cb_test_case("master phase jump, pulse index, glitch");
+  cb_uwbclockmodel_reset(&model, TEST_PERIOD_NS);
+  for (int k = 0; k < 10; k++)
+  {
+    (void)cb_uwbclockmodel_add_pulse(&model, localNs);
+    localNs += TEST_PERIOD_NS;
+  }
+  localNs += 300000000;
+  for (int k = 1; k <= 10; k++)
+  {
+    result = cb_uwbclockmodel_add_pulse(&model, localNs);
+    if ((result == EN_UWB_CLOCKMODEL_RESTARTED) && (restartAt == 0))
+    {
+      restartAt = k;
+    }
+    localNs += TEST_PERIOD_NS;
+  }
+  CB_TEST_CHECK(restartAt == DEF_UWB_CLOCKMODEL_OUTLIER_MAX);     // The last outlier restarts
+  CB_TEST_CHECK((model.stats.restarts == 1) && model.locked && (model.stats.outliers == DEF_UWB_CLOCKMODEL_OUTLIER_MAX));
+
+  before = model.index[model.newest];
+  cb_uwbclockmodel_set_pulse_index(&model, 1000);
+  network = cb_uwbclockmodel_local_to_network(&model, model.local[model.newest]);
+  CB_TEST_CHECK(before != 1000);
+  CB_TEST_CHECK(llabs(network - (1000LL * TEST_PERIOD_NS)) <= 1);
+
+  // A pulse 1 ms after the last one
+  CB_TEST_CHECK(cb_uwbclockmodel_add_pulse(&model, model.local[model.newest] + 1000000) == EN_UWB_CLOCKMODEL_OUTLIER);
+}
+
+int main(void)
+{
+  srand(7);
+  for (uint8_t i = 0; i < (sizeof(s_trains) / sizeof(s_trains[0])); i++)
+  {
+    test_train(&s_trains[i]);
+  }
+  test_phase_jump();
+  return cb_test_result();
+}
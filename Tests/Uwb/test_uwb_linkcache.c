@@ -0,0 +1,189 @@
+/**
+ * @file    test_uwb_linkcache.c
+ * @brief   Host test of the CB_uwblinkcache RX gain/CFO seeding.
+ * @details The receiver is replaced by the uwb_stubs: the test sets the gain, CFO and RSSI reported
+ *          for each frame and checks which receptions are seeded, and with which values. Checks the
+ *          periodic and RSSI-triggered re-learning, the failure and age fallbacks, and that the
+ *          CIR is only read by cb_uwblinkcache_record_fp_snr().
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <string.h>
+#include "cb_test.h"
+#include "uwb_stubs.h"
+#include "CB_uwblinkcache.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_PEER   7
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static void test_frame(uint8_t gainIdx, uint32_t cfoEst, int16_t rssi)
+{
+  g_uwbTestSignalInfo.gainIdx = gainIdx;
+  g_uwbTestSignalInfo.cfoEst  = cfoEst;
+  g_uwbTestSignalInfo.rssiRx  = rssi;
+}
+
+/**
+ * @brief One exchange with a single reception: returns CB_TRUE if it was seeded.
+ */
+static uint8_t test_exchange(uint8_t rxOk)
+{
+  cb_uwblinkcache_begin_exchange(TEST_PEER);
+  uint8_t seeded = cb_uwblinkcache_prepare_rx(TEST_PEER);
+  CB_TEST_CHECK(g_uwbTestCfoGainBypass == seeded);
+  cb_uwblinkcache_rx_done(TEST_PEER, rxOk, EN_UWB_RX_0);
+  sysTickCounter += 100;
+  return seeded;
+}
+
+static void test_off(void)
+{
+  cb_test_case("mode off never seeds");
+  cb_uwblinkcache_init(EN_UWB_LINKCACHE_MODE_OFF);
+  test_frame(20, 0x123, -70);
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+  }
+  const cb_uwblinkcache_peer_st *peer = cb_uwblinkcache_get_peer(TEST_PEER);
+  CB_TEST_CHECK((peer != NULL) && (peer->stats[EN_UWB_LINKCACHE_STATS_FREE].rxOk == 5));
+  CB_TEST_CHECK(cb_uwblinkcache_get_peer(TEST_PEER + 1) == NULL);
+}
+
+static void test_periodic_refresh(void)
+{
+  cb_test_case("seeded mode re-learns every DEF_UWB_LINKCACHE_REFRESH_INTERVAL receptions");
+  cb_uwblinkcache_init(EN_UWB_LINKCACHE_MODE_ON);
+
+  // Nothing cached: free-running, learns gain 20
+  test_frame(20, 0x123, -70);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+
+  // The peer drifts slowly: the bypassed receiver keeps reporting the seeded values
+  for (uint8_t i = 0; i < DEF_UWB_LINKCACHE_REFRESH_INTERVAL; i++)
+  {
+    test_frame(20, 0x123, -72);
+    CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+    CB_TEST_CHECK((g_uwbTestCfoGainConfig.stRxGain.gainValue == 20) && (g_uwbTestCfoGainConfig.stRxCfo.cfoValue == 0x123));
+  }
+
+  // Refresh due: free-running, the AGC/CFO converge to new values which are learned
+  test_frame(24, 0x140, -73);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+  CB_TEST_CHECK((g_uwbTestCfoGainConfig.stRxGain.gainValue == 24) && (g_uwbTestCfoGainConfig.stRxCfo.cfoValue == 0x140));
+
+  const cb_uwblinkcache_peer_st *peer = cb_uwblinkcache_get_peer(TEST_PEER);
+  CB_TEST_CHECK(peer->stats[EN_UWB_LINKCACHE_STATS_FREE].rxOk == 2);
+  CB_TEST_CHECK(peer->stats[EN_UWB_LINKCACHE_STATS_SEEDED].rxOk == (DEF_UWB_LINKCACHE_REFRESH_INTERVAL + 1));
+}
+
+static void test_rssi_refresh(void)
+{
+  cb_test_case("RSSI change of a seeded frame forces a free-running reception");
+  cb_uwblinkcache_init(EN_UWB_LINKCACHE_MODE_ON);
+  test_frame(20, 0x123, -70);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+
+  // Within the deviation, both ways
+  test_frame(20, 0x123, -70 + DEF_UWB_LINKCACHE_RSSI_DEVIATION);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+  test_frame(20, 0x123, -70 - DEF_UWB_LINKCACHE_RSSI_DEVIATION);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+
+  // Peer came closer: the next reception re-learns
+  test_frame(20, 0x123, -70 + DEF_UWB_LINKCACHE_RSSI_DEVIATION + 1);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+  test_frame(12, 0x120, -60);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+  CB_TEST_CHECK(cb_uwblinkcache_get_peer(TEST_PEER)->rssi == -60);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+  CB_TEST_CHECK(g_uwbTestCfoGainConfig.stRxGain.gainValue == 12);
+}
+
+static void test_failures_and_age(void)
+{
+  cb_test_case("failures and old state fall back to free-running");
+  cb_uwblinkcache_init(EN_UWB_LINKCACHE_MODE_ON);
+  test_frame(20, 0x123, -70);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+
+  // A seeded failure: retried free-running, the state stays valid
+  CB_TEST_CHECK(test_exchange(CB_FALSE) == CB_TRUE);
+  CB_TEST_CHECK(test_exchange(CB_FALSE) == CB_FALSE);
+  CB_TEST_CHECK(cb_uwblinkcache_get_peer(TEST_PEER)->valid == CB_TRUE);
+  CB_TEST_CHECK(test_exchange(CB_FALSE) == CB_FALSE);
+  CB_TEST_CHECK(cb_uwblinkcache_get_peer(TEST_PEER)->valid == CB_FALSE);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+
+  // Learned state too old
+  test_exchange(CB_TRUE);
+  sysTickCounter += DEF_UWB_LINKCACHE_MAX_AGE_MS;
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_FALSE);
+  CB_TEST_CHECK(test_exchange(CB_TRUE) == CB_TRUE);
+}
+
+static void test_alternate(void)
+{
+  uint8_t seeded = 0;
+
+  cb_test_case("alternate mode seeds every other exchange");
+  cb_uwblinkcache_init(EN_UWB_LINKCACHE_MODE_ALTERNATE);
+  test_frame(20, 0x123, -70);
+  for (uint8_t i = 0; i < 10; i++)
+  {
+    seeded += test_exchange(CB_TRUE);
+  }
+  CB_TEST_CHECK(seeded == 4);   // Odd exchanges, except the first one: no state yet
+}
+
+static void test_fp_snr(void)
+{
+  cb_test_case("first-path SNR read only on request");
+  cb_uwblinkcache_init(EN_UWB_LINKCACHE_MODE_OFF);
+  test_frame(20, 0x123, -70);
+  for (uint16_t n = 0; n < DEF_UWB_TEST_CIR_SIZE; n++)
+  {
+    g_uwbTestCir[n].I_data = (n & 1U) ? 10 : -10;
+    g_uwbTestCir[n].Q_data = 0;
+  }
+  g_uwbTestCirCtlIdx           = 100;
+  g_uwbTestCir[101].I_data     = 1000;   // First path within the search window
+  g_uwbTestCirReads            = 0;
+
+  test_exchange(CB_TRUE);
+  CB_TEST_CHECK(g_uwbTestCirReads == 0);
+  cb_uwblinkcache_record_fp_snr(TEST_PEER, EN_UWB_RX_0);
+  CB_TEST_CHECK(g_uwbTestCirReads == 1);
+
+  const cb_uwblinkcache_stats_st *stats = &cb_uwblinkcache_get_peer(TEST_PEER)->stats[EN_UWB_LINKCACHE_STATS_FREE];
+  CB_TEST_CHECK(stats->fpSnrCount == 1);
+  CB_TEST_CHECK(fabsf(stats->fpSnrSum_dB - 40.0f) < 0.01f);
+
+  // First path too close to the CIR start: nothing recorded
+  g_uwbTestCirCtlIdx = DEF_UWB_LINKCACHE_FP_NOISE_OFFSET - 1;
+  cb_uwblinkcache_record_fp_snr(TEST_PEER, EN_UWB_RX_0);
+  CB_TEST_CHECK(stats->fpSnrCount == 1);
+}
+
+int main(void)
+{
+  test_off();
+  test_periodic_refresh();
+  test_rssi_refresh();
+  test_failures_and_age();
+  test_alternate();
+  test_fp_snr();
+  return cb_test_result();
+}
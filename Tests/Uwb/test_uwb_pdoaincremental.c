@@ -0,0 +1,250 @@
+/**
+ * @file    test_uwb_pdoaincremental.c
+ * @brief   Host test: incremental and batch PDoA result of CB_uwbframework give the same result.
+ * @details Random CIR bursts are stored as the uwb_CLI PDoA responder does. The result of
+ *          cb_framework_uwb_pdoa_calculate_result_incremental() is compared bit for bit with
+ *          cb_framework_uwb_pdoa_calculate_result() on the same slots: 3D and 2D, shorter bursts,
+ *          per-packet processing skipped, a packet never received, a burst aborted before the
+ *          reset and a CIR snapshot still in flight on DMA. The library CIR processing and
+ *          estimation are replaced by deterministic models.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cb_test.h"
+#include "CB_uwbframework.h"
+#include "CB_dma.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_CIR_SAMPLES    256U
+#define TEST_CTL_IDX        100U
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static cb_uwbsystem_rx_cir_iqdata_st s_cirMem[DEF_PDOA_NUM_RX_USED][TEST_CIR_SAMPLES];
+static uint8_t s_dmaIdle = CB_TRUE;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint16_t cb_system_uwb_get_rx_cir_ctl_idx(void)        { return TEST_CTL_IDX; }
+void     cb_system_delay_in_us(uint32_t microseconds)  { }
+void     cb_dma_init(void)                             { }
+uint8_t  cb_dma_is_enabled(void)                       { return CB_TRUE; }
+void     cb_dma_enable_channel(stDMAConfig *DMAConfig) { s_dmaIdle = CB_FALSE; }
+void     cb_dma_disable_channel(stDMAConfig *DMAConfig){ }
+void     cb_dma_lli_init(struct stDMALinkedListHead *DMALLiConfig) { }
+void     cb_dma_lli_setup(struct stDMALinkedListHead *DMALLiConfig, struct stDMALinkedListNode *LLiNode) { }
+void     cb_dma_set_src_request(stDMAConfig *DMAConfig)  { }
+void     cb_dma_set_dest_request(stDMAConfig *DMAConfig) { }
+uint8_t  cb_dma_is_channel_idle(stDMAConfig *DMAConfig)  { return s_dmaIdle; }
+
+static uint32_t test_port_index(cb_uwbsystem_rxport_en enRxPort)
+{
+  return (enRxPort == EN_UWB_RX_0) ? 0 : ((enRxPort == EN_UWB_RX_1) ? 1 : 2);
+}
+
+uint32_t cb_system_uwb_get_rx_cir_register_addr(cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples)
+{
+  return 0x41000800UL + (test_port_index(enRxPort) * 0x800UL) + (startingPosition * 4U);
+}
+
+void cb_system_uwb_store_rx_cir_register(cb_uwbsystem_rx_cir_iqdata_st* destArray, cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples)
+{
+  memcpy(destArray, &s_cirMem[test_port_index(enRxPort)][startingPosition], numSamples * sizeof(cb_uwbsystem_rx_cir_iqdata_st));
+}
+
+/**
+ * @brief Model of the library CIR processing: phase of the summed window of each port, in degrees.
+ */
+cb_uwbalg_poa_outputperpacket_st cb_system_uwb_pdoa_cir_processing(enUwbPdoaCalType calType, uint8_t packageNum, const uint8_t numRxUsed, const cb_uwbsystem_rx_cir_iqdata_st *cirRegisterData, uint16_t cirDataSize)
+{
+  cb_uwbalg_poa_outputperpacket_st out;
+  double phase[DEF_PDOA_NUM_RX_USED];
+
+  for (uint8_t rx = 0; rx < numRxUsed; rx++)
+  {
+    const cb_uwbsystem_rx_cir_iqdata_st *pWindow = &cirRegisterData[((packageNum * numRxUsed) + rx) * cirDataSize];
+    double sumI = 0.0;
+    double sumQ = 0.0;
+    for (uint16_t i = 0; i < cirDataSize; i++)
+    {
+      sumI += pWindow[i].I_data;
+      sumQ += pWindow[i].Q_data;
+    }
+    phase[rx] = atan2(sumQ, sumI) * (180.0 / M_PI);
+  }
+  out.rx0 = phase[0];
+  out.rx1 = phase[1];
+  out.rx2 = phase[2];
+  return out;
+}
+
+/**
+ * @brief Model of the library estimation: phase difference wrapped to [-180, 180).
+ */
+double cb_system_uwb_alg_pdoa_estimation(double phase0, double phase1)
+{
+  double diff = fmod(phase0 - phase1 + 540.0, 360.0) - 180.0;
+  return diff;
+}
+
+/**
+ * @brief Receives one packet: random CIR in the register memory.
+ */
+static void test_receive(void)
+{
+  for (uint32_t port = 0; port < DEF_PDOA_NUM_RX_USED; port++)
+  {
+    for (uint32_t i = 0; i < TEST_CIR_SAMPLES; i++)
+    {
+      s_cirMem[port][i].I_data = (int16_t)((rand() % 2001) - 1000);
+      s_cirMem[port][i].Q_data = (int16_t)((rand() % 2001) - 1000);
+    }
+  }
+}
+
+/**
+ * @brief Reset between bursts, as app_pdoa_reset() of the uwb_CLI PDoA responder.
+ */
+static void test_reset(void)
+{
+  cb_framework_uwb_pdoa_reset_cir_data_container();
+  cb_framework_uwb_pdoa_incremental_reset();
+}
+
+/**
+ * @brief One burst: packets stored with the CPU, processed right after unless in skipMask.
+ *
+ * @param missMask Packets never received: slot left as reset
+ */
+static void test_burst(enUwbPdoaCalType calType, uint8_t numOfPackage, uint32_t skipMask, uint32_t missMask)
+{
+  for (uint8_t pkt = 0; pkt < numOfPackage; pkt++)
+  {
+    if ((missMask & (1UL << pkt)) != 0)
+    {
+      continue;
+    }
+    test_receive();
+    cb_framework_uwb_pdoa_store_cir_data(pkt);
+    // The responder processes every packet but the last during the next reception
+    if (((pkt + 1) < numOfPackage) && ((skipMask & (1UL << pkt)) == 0))
+    {
+      CB_TEST_CHECK(cb_framework_uwb_pdoa_process_packet(calType, pkt) == CB_TRUE);
+    }
+  }
+}
+
+static uint8_t test_same(volatile const cb_uwbsystem_pdoa_3ddata_st *a, volatile const cb_uwbsystem_pdoa_3ddata_st *b, enUwbPdoaCalType calType)
+{
+  if (a->rx0_rx2 != b->rx0_rx2)
+  {
+    return CB_FALSE;
+  }
+  if ((calType != EN_PDOA_2D_CALTYPE) && ((a->rx0_rx1 != b->rx0_rx1) || (a->rx1_rx2 != b->rx1_rx2)))
+  {
+    return CB_FALSE;
+  }
+  return CB_TRUE;
+}
+
+/**
+ * @brief Incremental result first (it leaves the slots untouched), then batch on the same slots.
+ */
+static void test_compare(const char *name, enUwbPdoaCalType calType, uint8_t numOfPackage)
+{
+  cb_uwbsystem_pdoaresult_st incremental;
+  cb_uwbsystem_pdoaresult_st batch;
+
+  memset(&incremental, 0x00, sizeof(incremental));
+  memset(&batch, 0x00, sizeof(batch));
+  cb_framework_uwb_pdoa_calculate_result_incremental(&incremental, calType, numOfPackage);
+  cb_framework_uwb_pdoa_calculate_result(&batch, calType, numOfPackage);
+  printf("%s: median PD02 %.6f / %.6f, mean PD02 %.6f / %.6f\n", name,
+         incremental.median.rx0_rx2, batch.median.rx0_rx2, incremental.mean.rx0_rx2, batch.mean.rx0_rx2);
+  CB_TEST_CHECK((incremental.stRxstatus == CB_TRUE) && (batch.stRxstatus == CB_TRUE));
+  CB_TEST_CHECK(test_same(&incremental.mean, &batch.mean, calType));
+  CB_TEST_CHECK(test_same(&incremental.median, &batch.median, calType));
+}
+
+static void test_bursts(void)
+{
+  cb_test_case("incremental and batch results match");
+  srand(7);
+  test_reset();
+  test_burst(EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX, 0, 0);
+  test_compare("3D, 5 packets", EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX);
+
+  test_reset();
+  test_burst(EN_PDOA_2D_CALTYPE, 3, 0, 0);
+  test_compare("2D, 3 packets", EN_PDOA_2D_CALTYPE, 3);
+
+  test_reset();
+  test_burst(EN_PDOA_3D_CALTYPE, 4, (1UL << 0) | (1UL << 2), 0);
+  test_compare("3D, processing skipped for packets 0 and 2", EN_PDOA_3D_CALTYPE, 4);
+
+  test_reset();
+  test_burst(EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX, 0, (1UL << 1));
+  test_compare("3D, packet 1 never received", EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX);
+
+  test_reset();
+  test_burst(EN_PDOA_3D_CALTYPE, 1, 0, 0);
+  test_compare("3D, 1 packet", EN_PDOA_3D_CALTYPE, 1);
+
+  cb_test_case("aborted burst: reset drops its processed packets");
+  test_reset();
+  test_burst(EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX, 0, 0);   // Result never calculated
+  test_reset();
+  test_burst(EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX, (1UL << 3), 0);
+  test_compare("3D after an aborted burst", EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX);
+
+  cb_test_case("error on the package count");
+  cb_uwbsystem_pdoaresult_st result;
+  cb_framework_uwb_pdoa_calculate_result_incremental(&result, EN_PDOA_3D_CALTYPE, 0);
+  CB_TEST_CHECK(result.stRxstatus == CB_FALSE);
+  cb_framework_uwb_pdoa_calculate_result_incremental(&result, EN_PDOA_3D_CALTYPE, DEF_PDOA_NUMPKT_SUPERFRAME_MAX + 1);
+  CB_TEST_CHECK(result.stRxstatus == CB_FALSE);
+}
+
+static void test_snapshot_in_flight(void)
+{
+  cb_test_case("DMA snapshot in flight: packet processed with the result");
+  test_reset();
+  cb_framework_uwb_pdoa_cir_snapshot_init(EN_UWB_RX_ALL);
+  for (uint8_t pkt = 0; pkt < 3; pkt++)
+  {
+    test_receive();
+    CB_TEST_CHECK(cb_framework_uwb_pdoa_cir_snapshot_start(pkt) == CB_TRUE);
+    cb_framework_uwb_pdoa_store_cir_data(pkt);                      // Data the DMA copies
+    if (pkt == 1)
+    {
+      // Not complete yet: left to the result calculation
+      CB_TEST_CHECK(cb_framework_uwb_pdoa_process_packet(EN_PDOA_3D_CALTYPE, pkt) == CB_FALSE);
+    }
+    s_dmaIdle = CB_TRUE;
+    if (pkt == 0)
+    {
+      CB_TEST_CHECK(cb_framework_uwb_pdoa_process_packet(EN_PDOA_3D_CALTYPE, pkt) == CB_TRUE);
+    }
+  }
+  test_compare("3D, snapshot of packet 1 late", EN_PDOA_3D_CALTYPE, 3);
+  cb_framework_uwb_pdoa_cir_snapshot_deinit();
+}
+
+int main(void)
+{
+  test_bursts();
+  test_snapshot_in_flight();
+  return cb_test_result();
+}
@@ -0,0 +1,251 @@
+/**
+ * @file    test_uwb_psr.c
+ * @brief   Host test of the uwb_psr fast scan order and dwell scheduling.
+ * @details AppUwbPsr.c of the uwb_psr example is built into the test. The tick advances 1 ms per
+ *          cb_hal_is_time_elapsed() call while the RX is on, and a transmitter model raises the RX0 IRQs of a frame
+ *          on its code every period. Checks the most recently seen ordering, the dwell doubling
+ *          and cap, the full round 0 dwell of confirmed codes and the give-up bound, which is
+ *          the time of the linear scan.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <stdarg.h>
+#include <string.h>
+#include "cb_test.h"
+#include "AppUwbPsr.c"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_SCAN_DURATION_MS   200
+#define TEST_LINEAR_SCAN_MS     (TEST_SCAN_DURATION_MS * PREAMBLE_CODE_IDX_COUNT)
+#define TEST_MAX_DWELLS         256
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+uint32_t SystemCoreClock = 64000000;
+
+static uint32_t s_now;
+static uint8_t  s_rxOn;
+static uint32_t s_rxStartTick;
+static uint8_t  s_rxFrame;                      // A frame was received since the RX start
+static uint8_t  s_txCode;                       // PREAMBLE_CODE_IDX_NONE: no transmitter
+static uint32_t s_txPeriodMs;
+static uint32_t s_dwellCount;
+static uint8_t  s_dwellCode[TEST_MAX_DWELLS];
+static uint32_t s_dwellMs[TEST_MAX_DWELLS];
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint32_t cb_hal_get_tick(void)                   { return s_now; }
+void     cb_system_delay_in_us(uint32_t us)      { }
+void     cb_framework_uwb_init(void)             { }
+void     cb_framework_uwb_off(void)              { }
+uint8_t  cb_framework_uwb_is_rx_phr_empty(void)  { return CB_FALSE; }
+void     app_uart_printf(const char *format, ...) { }
+
+cb_uwbsystem_rx_phrstatus_st cb_framework_uwb_get_rx_phr_status(void)
+{
+  cb_uwbsystem_rx_phrstatus_st phrStatus;
+
+  memset(&phrStatus, 0, sizeof(phrStatus));
+  phrStatus.rx0Ok = s_rxFrame;
+  return phrStatus;
+}
+
+void cb_framework_uwb_rx_start(cb_uwbsystem_rxport_en enRxPort, cb_uwbsystem_packetconfig_st* pstPacketConfig, cb_uwbsystem_rx_irqenable_st* pstRxIrqEnable, cb_uwbframework_trx_startmode_en trxStartMode)
+{
+  s_rxOn        = CB_TRUE;
+  s_rxFrame     = CB_FALSE;
+  s_rxStartTick = s_now;
+}
+
+void cb_framework_uwb_rx_end(cb_uwbsystem_rxport_en enRxPort)
+{
+  if ((s_rxOn == CB_TRUE) && (s_dwellCount < TEST_MAX_DWELLS))
+  {
+    s_dwellCode[s_dwellCount] = (uint8_t)cb_system_get_preamble_index();
+    s_dwellMs[s_dwellCount]   = s_now - s_rxStartTick;
+    s_dwellCount++;
+  }
+  s_rxOn = CB_FALSE;
+}
+
+/**
+ * @brief 1 ms passes while listening; a frame of the transmitter is received on its code.
+ */
+CB_STATUS cb_hal_is_time_elapsed(uint32_t start_tick, uint32_t timeout_ms)
+{
+  if (s_rxOn == CB_TRUE)
+  {
+    s_now++;
+  }
+  if ((s_rxOn == CB_TRUE) && (s_txCode != PREAMBLE_CODE_IDX_NONE) && (cb_system_get_preamble_index() == s_txCode) &&
+      ((s_now % s_txPeriodMs) == 0))
+  {
+    s_rxFrame = CB_TRUE;
+    cb_uwbapp_rx0_preamble_detected_irqcb();
+    cb_uwbapp_rx0_sfd_detected_irqcb();
+    cb_uwbapp_rx0_done_irqcb();
+  }
+  return ((s_now - start_tick) >= timeout_ms) ? CB_PASS : CB_FAIL;
+}
+
+static void test_reset(uint32_t scanDurationMs, uint8_t txCode, uint32_t txPeriodMs)
+{
+  stPreambleScanningParameters params = { .trxMode = EN_PSR_RX, .psrMode = EN_PSR_FAST_MODE, .scanDuration = scanDurationMs };
+
+  app_uwb_psr_init(params);
+  s_txCode     = txCode;
+  s_txPeriodMs = txPeriodMs;
+  s_dwellCount = 0;
+}
+
+static void test_seen(uint8_t preambleCodeIdx, uint32_t lastSeenTick)
+{
+  s_PsrCodeStatistics[preambleCodeIdx - PREAMBLE_CODE_IDX_MIN].rxOkCount    = 1;
+  s_PsrCodeStatistics[preambleCodeIdx - PREAMBLE_CODE_IDX_MIN].lastSeenTick = lastSeenTick;
+}
+
+static void test_scan_order(void)
+{
+  static const uint8_t s_expected[PREAMBLE_CODE_IDX_COUNT] = { 12, 15, 20, 9, 10, 11, 13, 14, 16, 17, 18, 19, 21, 22, 23, 24 };
+  uint8_t order = CB_TRUE;
+
+  cb_test_case("scan order: most recently seen first, others in natural order");
+  memset(s_PsrCodeStatistics, 0, sizeof(s_PsrCodeStatistics));
+  app_uwb_psr_build_scan_order();
+  for (uint8_t i = 0; i < PREAMBLE_CODE_IDX_COUNT; i++)
+  {
+    order &= (s_PsrScanOrder[i] == (PREAMBLE_CODE_IDX_MIN + i)) ? CB_TRUE : CB_FALSE;
+  }
+  CB_TEST_CHECK(order);
+
+  test_seen(20, 100);
+  test_seen(15, 500);
+  test_seen(12, 900);
+  app_uwb_psr_build_scan_order();
+  CB_TEST_CHECK(memcmp(s_PsrScanOrder, s_expected, sizeof(s_expected)) == 0);
+
+  // Ticks across the 32-bit wrap: 0x10 is more recent than 0xFFFFFFF0
+  memset(s_PsrCodeStatistics, 0, sizeof(s_PsrCodeStatistics));
+  test_seen(24, 0xFFFFFFF0UL);
+  test_seen(9, 0x10UL);
+  app_uwb_psr_build_scan_order();
+  CB_TEST_CHECK((s_PsrScanOrder[0] == 9) && (s_PsrScanOrder[1] == 24) && (s_PsrScanOrder[2] == 10));
+}
+
+/**
+ * @brief Fast scan without transmitter.
+ *
+ * @param seenCode Code confirmed before, PREAMBLE_CODE_IDX_NONE for none
+ * @return Dwell of the last round, 0 if the schedule is wrong.
+ */
+static uint32_t test_dwell_schedule(uint32_t scanDurationMs, uint8_t seenCode)
+{
+  uint8_t  schedule = CB_TRUE;
+  uint32_t startTick;
+  uint32_t expectedMs;
+
+  memset(s_PsrCodeStatistics, 0, sizeof(s_PsrCodeStatistics));
+  if (seenCode != PREAMBLE_CODE_IDX_NONE)
+  {
+    test_seen(seenCode, 1000);
+  }
+  s_now += 5000;
+  test_reset(scanDurationMs, PREAMBLE_CODE_IDX_NONE, 1);
+  startTick = s_now;
+  CB_TEST_CHECK(app_uwb_psr_fast_scan() == PREAMBLE_CODE_IDX_NONE);
+  printf("scanDuration %u ms: gave up after %u ms, %u dwells, linear scan %u ms\n", scanDurationMs, s_now - startTick,
+         s_dwellCount, scanDurationMs * PREAMBLE_CODE_IDX_COUNT);
+  CB_TEST_CHECK((s_now - startTick) >= (scanDurationMs * PREAMBLE_CODE_IDX_COUNT));
+  CB_TEST_CHECK((s_now - startTick) <= ((scanDurationMs * PREAMBLE_CODE_IDX_COUNT) + scanDurationMs));
+
+  // Round 0: the confirmed code first with the full dwell, the others with the minimum dwell
+  if (seenCode != PREAMBLE_CODE_IDX_NONE)
+  {
+    CB_TEST_CHECK((s_dwellCode[0] == seenCode) && (s_dwellMs[0] == scanDurationMs));
+  }
+  for (uint8_t i = (seenCode != PREAMBLE_CODE_IDX_NONE) ? 1 : 0; i < PREAMBLE_CODE_IDX_COUNT; i++)
+  {
+    schedule &= (s_dwellMs[i] == PSR_FAST_DWELL_MIN_MS) ? CB_TRUE : CB_FALSE;
+  }
+
+  // Later rounds: every code in the same order, doubled dwell capped at scanDuration
+  expectedMs = PSR_FAST_DWELL_MIN_MS;
+  for (uint32_t i = PREAMBLE_CODE_IDX_COUNT; i < s_dwellCount; i++)
+  {
+    if ((i % PREAMBLE_CODE_IDX_COUNT) == 0)
+    {
+      expectedMs = ((expectedMs * 2) < scanDurationMs) ? (expectedMs * 2) : scanDurationMs;
+    }
+    schedule &= (s_dwellMs[i] == expectedMs) ? CB_TRUE : CB_FALSE;
+    schedule &= (s_dwellCode[i] == s_dwellCode[i % PREAMBLE_CODE_IDX_COUNT]) ? CB_TRUE : CB_FALSE;
+  }
+  CB_TEST_CHECK(schedule);
+  return (schedule == CB_TRUE) ? s_dwellMs[s_dwellCount - 1] : 0;
+}
+
+static void test_dwell_schedules(void)
+{
+  cb_test_case("no transmitter: dwell doubling, give-up at the linear scan time");
+  CB_TEST_CHECK(test_dwell_schedule(TEST_SCAN_DURATION_MS, 17) == 128);        // Gives up before the cap
+  CB_TEST_CHECK(test_dwell_schedule(TEST_SCAN_DURATION_MS, PREAMBLE_CODE_IDX_NONE) == 128);
+  CB_TEST_CHECK(test_dwell_schedule(20, 17) == 16);
+
+  cb_test_case("no transmitter: dwell capped at scanDuration");
+  // 2 + 4 + ... + 128 ms per code is 32 ms short of the linear scan time: one capped dwell
+  CB_TEST_CHECK(test_dwell_schedule(256, PREAMBLE_CODE_IDX_NONE) == 256);
+}
+
+static void test_discovery(void)
+{
+  uint8_t  preambleCodeIdx;
+  uint32_t startTick;
+
+  cb_test_case("transmitter found, then found first");
+  memset(s_PsrCodeStatistics, 0, sizeof(s_PsrCodeStatistics));
+  s_now = 20000;
+  test_reset(TEST_SCAN_DURATION_MS, 21, 40);
+  startTick       = s_now;
+  preambleCodeIdx = app_uwb_psr_fast_scan();
+  printf("40 ms period: code %u found after %u ms, %u dwells\n", preambleCodeIdx, s_now - startTick, s_dwellCount);
+  CB_TEST_CHECK(preambleCodeIdx == 21);
+  CB_TEST_CHECK((s_now - startTick) < TEST_LINEAR_SCAN_MS);
+  CB_TEST_CHECK(s_PsrCodeStatistics[21 - PREAMBLE_CODE_IDX_MIN].rxOkCount == 1);
+  CB_TEST_CHECK(cb_system_get_preamble_index() == EN_UWB_PREAMBLE_CODE_IDX_9);   // Restored
+
+  // Next scan: code 21 first with the full dwell, found in the first dwell
+  s_now += 1000;
+  test_reset(TEST_SCAN_DURATION_MS, 21, 150);
+  preambleCodeIdx = app_uwb_psr_fast_scan();
+  CB_TEST_CHECK((preambleCodeIdx == 21) && (s_dwellCount == 1) && (s_dwellCode[0] == 21));
+}
+
+static void test_default_mode(void)
+{
+  cb_test_case("example default: full (linear) scan of a sparse transmitter");
+  memset(s_PsrCodeStatistics, 0, sizeof(s_PsrCodeStatistics));
+  s_now = 40000;
+  test_reset(TEST_SCAN_DURATION_MS, 21, 150);
+  app_psr_start();
+  CB_TEST_CHECK(s_PreambleScanningParams.psrMode == EN_PSR_FULL_MODE);
+  CB_TEST_CHECK(s_PsrCodeStatistics[0].dwellCount == 0);                         // Fast scan not run
+  CB_TEST_CHECK(s_PreambleCodeStatus[21 - PREAMBLE_CODE_IDX_MIN] == APP_TRUE);
+  CB_TEST_CHECK(s_PreambleCodeStatus[20 - PREAMBLE_CODE_IDX_MIN] == APP_FALSE);
+  CB_TEST_CHECK(s_dwellCount == PREAMBLE_CODE_IDX_COUNT);
+}
+
+int main(void)
+{
+  test_scan_order();
+  test_dwell_schedules();
+  test_discovery();
+  test_default_mode();
+  return cb_test_result();
+}
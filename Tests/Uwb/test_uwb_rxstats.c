@@ -0,0 +1,158 @@
+/**
+ * @file    test_uwb_rxstats.c
+ * @brief   Host test of the CB_uwbrxstats packet error rate and signal statistics.
+ * @details Feeds RX status registers and signal information as read after each reception, and
+ *          checks the outcome classification, the PER and its Wilson interval, the metric moments
+ *          and histograms, the snapshot sequence counter and the serialized report.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include "cb_test.h"
+#include "CB_uwbrxstats.h"
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static cb_uwbsystem_rxstatus_un test_rx_ok(void)
+{
+  cb_uwbsystem_rxstatus_un status = { .value = 0 };
+
+  status.rx0_ok   = 1;
+  status.pd0_det  = 1;
+  status.sfd0_det = 1;
+  return status;
+}
+
+static void test_classify(void)
+{
+  cb_uwbsystem_rxstatus_un status = { .value = 0 };
+
+  cb_test_case("outcome of the RX status register, per port");
+  CB_TEST_CHECK(cb_uwbrxstats_classify(EN_UWB_RX_0, test_rx_ok()) == EN_UWB_RXSTATS_OK);
+  status.pd0_det = 1;
+  CB_TEST_CHECK(cb_uwbrxstats_classify(EN_UWB_RX_0, status) == EN_UWB_RXSTATS_SFD_FAIL);
+  status.value = 0;
+  status.no0_signal = 1;
+  CB_TEST_CHECK(cb_uwbrxstats_classify(EN_UWB_RX_0, status) == EN_UWB_RXSTATS_NO_SIGNAL);
+
+  // Port 1 received, port 0 only sees that nothing was detected on its own bits
+  status.value    = 0;
+  status.rx1_ok   = 1;
+  status.pd1_det  = 1;
+  status.sfd1_det = 1;
+  CB_TEST_CHECK(cb_uwbrxstats_classify(EN_UWB_RX_1, status) == EN_UWB_RXSTATS_OK);
+  CB_TEST_CHECK(cb_uwbrxstats_classify(EN_UWB_RX_0, status) == EN_UWB_RXSTATS_PD_FAIL);
+}
+
+static void test_per_and_metrics(void)
+{
+  cb_uwbrxstats_st              stats;
+  cb_uwbrxstats_st              snapshot;
+  cb_uwbrxstats_per_st          per;
+  cb_uwbsystem_rx_signalinfo_st signalInfo = {0};
+  cb_uwbsystem_rxstatus_un      status;
+  float                         mean;
+  float                         stddev;
+
+  cb_test_case("PER, Wilson interval, moments and histograms");
+  cb_uwbrxstats_reset(&stats, EN_UWB_RX_0);
+  for (uint16_t i = 0; i < 990; i++)
+  {
+    signalInfo.rssiRx  = (int16_t)(-80 + (i % 5));
+    signalInfo.cfoEst  = (uint32_t)((i & 1U) ? -100 : 100) & 0xFFFFU;
+    signalInfo.gainIdx = (uint8_t)(10 + (i % 3));
+    CB_TEST_CHECK(cb_uwbrxstats_add_packet(&stats, test_rx_ok(), &signalInfo) == EN_UWB_RXSTATS_OK);
+  }
+  status          = test_rx_ok();
+  status.rx0_ok   = 0;
+  status.crc_fail = 1;
+  status.phr_sec  = 1;
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    CB_TEST_CHECK(cb_uwbrxstats_add_packet(&stats, status, &signalInfo) == EN_UWB_RXSTATS_CRC_FAIL);
+  }
+  status.value      = 0;
+  status.no0_signal = 1;
+  CB_TEST_CHECK(cb_uwbrxstats_add_packet(&stats, status, &signalInfo) == EN_UWB_RXSTATS_NO_SIGNAL);
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    cb_uwbrxstats_add_missed(&stats);
+  }
+  CB_TEST_CHECK((stats.seq % 2U) == 0U);
+
+  CB_TEST_CHECK(cb_uwbrxstats_snapshot(&stats, &snapshot) == CB_PASS);
+  cb_uwbrxstats_per(&snapshot, 1.96f, &per);
+  CB_TEST_CHECK((per.total == 1000) && (per.errors == 10));
+  CB_TEST_CHECK(fabsf(per.per - 0.01f) < 1e-6f);
+  // Wilson 95 % interval of 10 / 1000: [0.00544, 0.01831]
+  CB_TEST_CHECK(fabsf(per.lower - 0.00544f) < 1e-4f);
+  CB_TEST_CHECK(fabsf(per.upper - 0.01831f) < 1e-4f);
+
+  // Signal metrics of every packet with a detected preamble
+  CB_TEST_CHECK(snapshot.signalCount == 995);
+  CB_TEST_CHECK((snapshot.metric[EN_UWB_RXSTATS_RSSI].min == -80) && (snapshot.metric[EN_UWB_RXSTATS_RSSI].max == -76));
+  cb_uwbrxstats_moments(&snapshot, EN_UWB_RXSTATS_CFO, &mean, &stddev);
+  CB_TEST_CHECK(fabsf(stddev - 100.0f) < 0.5f);
+
+  // RSSI -80 is bin 20; signed cfoEst -100 is bin 14 and +100 bin 17
+  const uint32_t *bins = snapshot.metric[EN_UWB_RXSTATS_RSSI].bins;
+  CB_TEST_CHECK((bins[20] + bins[21] + bins[22]) == 995);
+  bins = snapshot.metric[EN_UWB_RXSTATS_CFO].bins;
+  CB_TEST_CHECK(((bins[14] + bins[17]) == 995) && (bins[14] > 0));
+  bins = snapshot.metric[EN_UWB_RXSTATS_GAIN].bins;
+  CB_TEST_CHECK((bins[10] + bins[11] + bins[12]) == 995);
+  CB_TEST_CHECK(cb_uwbrxstats_bin_lower_edge(EN_UWB_RXSTATS_CFO, 14) == -128);
+  CB_TEST_CHECK(cb_uwbrxstats_bin_lower_edge(EN_UWB_RXSTATS_RSSI, 20) == -80);
+
+  // Out of range values go to the first / last bin
+  signalInfo.rssiRx  = -200;
+  signalInfo.cfoEst  = 0x7FFF;
+  signalInfo.gainIdx = 200;
+  cb_uwbrxstats_add_packet(&stats, test_rx_ok(), &signalInfo);
+  CB_TEST_CHECK(stats.metric[EN_UWB_RXSTATS_RSSI].bins[0] == 1);
+  CB_TEST_CHECK(stats.metric[EN_UWB_RXSTATS_CFO].bins[DEF_UWB_RXSTATS_HIST_BINS - 1] == 1);
+  CB_TEST_CHECK(stats.metric[EN_UWB_RXSTATS_GAIN].bins[DEF_UWB_RXSTATS_HIST_BINS - 1] == 1);
+}
+
+static void test_edge_cases(void)
+{
+  cb_uwbrxstats_st     stats;
+  cb_uwbrxstats_st     snapshot;
+  cb_uwbrxstats_per_st per;
+  uint8_t              buf[DEF_UWB_RXSTATS_SERIALIZED_SIZE];
+
+  cb_test_case("empty and error-free runs, snapshot during an update, serialization");
+  cb_uwbrxstats_reset(&stats, EN_UWB_RX_0);
+  cb_uwbrxstats_per(&stats, 1.96f, &per);
+  CB_TEST_CHECK((per.total == 0) && (per.upper == 1.0f));
+
+  for (uint8_t i = 0; i < 100; i++)
+  {
+    cb_uwbrxstats_add_packet(&stats, test_rx_ok(), NULL);
+  }
+  cb_uwbrxstats_per(&stats, 1.96f, &per);
+  CB_TEST_CHECK((per.lower == 0.0f) && (fabsf(per.upper - 0.037f) < 1e-3f));
+  CB_TEST_CHECK(stats.signalCount == 0);
+
+  // Odd sequence: the update of the RX callback is in progress
+  stats.seq++;
+  CB_TEST_CHECK(cb_uwbrxstats_snapshot(&stats, &snapshot) == CB_FAIL);
+  stats.seq++;
+  CB_TEST_CHECK(cb_uwbrxstats_snapshot(&stats, &snapshot) == CB_PASS);
+
+  CB_TEST_CHECK(cb_uwbrxstats_serialize(&snapshot, buf, sizeof(buf) - 1U) == 0);
+  CB_TEST_CHECK(cb_uwbrxstats_serialize(&snapshot, buf, sizeof(buf)) == DEF_UWB_RXSTATS_SERIALIZED_SIZE);
+  CB_TEST_CHECK((buf[0] == 1) && (buf[1] == 1) && (buf[2] == DEF_UWB_RXSTATS_HIST_BINS) && (buf[8] == 100));
+}
+
+int main(void)
+{
+  test_classify();
+  test_per_and_metrics();
+  test_edge_cases();
+  return cb_test_result();
+}
@@ -0,0 +1,235 @@
+/**
+ * @file    test_uwb_sstwr.c
+ * @brief   Host test of the CB_uwbsstwr clock-offset compensated SS-TWR.
+ * @details Simulated exchanges between two devices with a clock offset: TSU timestamps with 50 ps
+ *          rms noise and a cfoEst proportional to the offset, with a slope unknown to the module.
+ *          Checks the calibration fit against DS-TWR, that the compensated SS-TWR stays within the
+ *          error model of DS-TWR over +/-20 ppm, and the responder reply time predictor.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <stdlib.h>
+#include "cb_test.h"
+#include "CB_uwbsstwr.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_PPM_PER_LSB      (-0.0123)       // Slope of the simulated CFO estimator
+#define TEST_CFO_NOISE_LSB    2.0             // cfoEst noise, rms
+#define TEST_TS_NOISE_NS      0.05            // Timestamp noise, rms
+#define TEST_TREPLY_NS        700000.0        // Reply times of both devices
+#define TEST_TOF_NS           (33.356 + 620.57)   // 10 m plus the TRX delays of DEF_UWB_SSTWR_RANGING_OFFSET_CM
+#define TEST_RUNS             2000            // Exchanges averaged per clock offset
+
+//-------------------------------
+// STRUCT/UNION SECTION
+//-------------------------------
+typedef struct
+{
+  double sstwrError_ns;     // Compensated SS-TWR - ToF
+  double dstwrError_ns;     // DS-TWR - ToF
+  double uncompError_ns;    // Plain SS-TWR - ToF
+  float  expectedBias_cm;
+} test_exchange_st;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static double test_gauss(void)
+{
+  double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+  double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/**
+ * @brief TSU interval of a duration, with timestamp noise.
+ */
+static void test_to_tsu(double ns, volatile uint32_t *intCount, volatile int16_t *fracCount)
+{
+  double ticks = (ns + (TEST_TS_NOISE_NS * test_gauss())) / DEF_UWB_SSTWR_TSU_TICK_NS;
+  double whole = floor(ticks);
+
+  *intCount  = (uint32_t)whole;
+  *fracCount = (int16_t)lround((ticks - whole) * DEF_UWB_SSTWR_TSU_FRAC_COUNTS);
+}
+
+static uint32_t test_cfo_est(double offsetPpm)
+{
+  long raw = lround((offsetPpm / TEST_PPM_PER_LSB) + (test_gauss() * TEST_CFO_NOISE_LSB));
+  return (uint32_t)raw & 0xFFFFU;
+}
+
+/**
+ * @brief One DS-TWR exchange, the first round is the SS-TWR exchange.
+ *
+ * @param offsetPpm Responder clock relative to the initiator clock.
+ * @param cal       Conversion used for SS-TWR.
+ * @param acc       Calibration accumulator, NULL to skip the calibration.
+ */
+static test_exchange_st test_exchange(double offsetPpm, cb_uwbsstwr_cfocal_st *cal, cb_uwbsstwr_calaccum_st *acc)
+{
+  cb_uwbsystem_rangingtroundtreply_st initiator = {0};
+  cb_uwbsystem_rangingtroundtreply_st responder = {0};
+  cb_uwbsstwr_result_st               result;
+  test_exchange_st                    out;
+  double                              e = offsetPpm * 1.0e-6;
+  volatile uint32_t                   intCount;
+  volatile int16_t                    fracCount;
+
+  // First round in the initiator clock, reply in the responder clock
+  test_to_tsu((2.0 * TEST_TOF_NS) + (TEST_TREPLY_NS / (1.0 + e)), &initiator.T_round_int, &initiator.T_round_frac);
+  test_to_tsu(TEST_TREPLY_NS, &responder.T_reply_int, &responder.T_reply_frac);
+  double round1 = cb_uwbsstwr_tsu_to_ns(initiator.T_round_int, initiator.T_round_frac);
+  double reply1 = cb_uwbsstwr_tsu_to_ns(responder.T_reply_int, responder.T_reply_frac);
+
+  // Second round: initiator reply, responder round
+  test_to_tsu(TEST_TREPLY_NS, &intCount, &fracCount);
+  double reply2 = cb_uwbsstwr_tsu_to_ns(intCount, fracCount);
+  test_to_tsu(((2.0 * TEST_TOF_NS) + TEST_TREPLY_NS) * (1.0 + e), &intCount, &fracCount);
+  double round2 = cb_uwbsstwr_tsu_to_ns(intCount, fracCount);
+  double dstwr  = ((round1 * round2) - (reply1 * reply2)) / (round1 + round2 + reply1 + reply2);
+
+  uint32_t cfoEst = test_cfo_est(offsetPpm);
+  if (acc != NULL)
+  {
+    cb_uwbsstwr_cal_add(acc, cal, cfoEst, &initiator, &responder, dstwr);
+  }
+  cb_uwbsstwr_calculate(cal, &initiator, &responder, cfoEst, 0, &result);
+
+  out.sstwrError_ns   = result.tof_ns - TEST_TOF_NS;
+  out.dstwrError_ns   = dstwr - TEST_TOF_NS;
+  out.uncompError_ns  = ((round1 - reply1) * 0.5) - TEST_TOF_NS;
+  out.expectedBias_cm = result.expectedBias_cm;
+  return out;
+}
+
+static void test_sign_extend(void)
+{
+  cb_test_case("cfoEst sign extension");
+  CB_TEST_CHECK(cb_uwbsstwr_sign_extend(0x7FFFU, 16) == 32767);
+  CB_TEST_CHECK(cb_uwbsstwr_sign_extend(0x8000U, 16) == -32768);
+  CB_TEST_CHECK(cb_uwbsstwr_sign_extend(0xFFFFU, 16) == -1);
+  CB_TEST_CHECK(cb_uwbsstwr_sign_extend(0xABCD0001UL, 16) == 1);       // Bits above the field ignored
+  CB_TEST_CHECK(cb_uwbsstwr_sign_extend(0x3FFU, 10) == -1);
+  CB_TEST_CHECK(cb_uwbsstwr_sign_extend(0x1U, 1) == -1);
+  CB_TEST_CHECK(cb_uwbsstwr_sign_extend(0x80000000UL, 32) == INT32_MIN);
+}
+
+static void test_calibration(cb_uwbsstwr_cfocal_st *cal)
+{
+  cb_uwbsstwr_calaccum_st acc;
+
+  cb_test_case("cfoEst conversion fitted against DS-TWR");
+  cb_uwbsstwr_default_cfo_calibration(cal);
+  CB_TEST_CHECK(cal->calibrated == CB_FALSE);
+  cb_uwbsstwr_cal_reset(&acc);
+
+  // Too few samples, then no clock offset spread
+  for (uint8_t i = 0; i < (DEF_UWB_SSTWR_CAL_MIN_SAMPLES - 1); i++)
+  {
+    test_exchange(5.0, cal, &acc);
+  }
+  CB_TEST_CHECK(cb_uwbsstwr_cal_solve(&acc, cal) == CB_FAIL);
+  cb_uwbsstwr_cal_reset(&acc);
+  for (uint8_t i = 0; i < DEF_UWB_SSTWR_CAL_MIN_SAMPLES; i++)
+  {
+    cb_uwbsystem_rangingtroundtreply_st initiator = {.T_round_int = 90000};
+    cb_uwbsystem_rangingtroundtreply_st responder = {.T_reply_int = 87360};
+    cb_uwbsstwr_cal_add(&acc, cal, 0x10, &initiator, &responder, 600.0);
+  }
+  CB_TEST_CHECK(cb_uwbsstwr_cal_solve(&acc, cal) == CB_FAIL);
+  CB_TEST_CHECK(cal->calibrated == CB_FALSE);
+
+  // Devices swept over +/-20 ppm
+  cb_uwbsstwr_cal_reset(&acc);
+  for (uint8_t i = 0; i < 64; i++)
+  {
+    test_exchange(-20.0 + ((40.0 * i) / 63.0), cal, &acc);
+  }
+  CB_TEST_CHECK(cb_uwbsstwr_cal_solve(&acc, cal) == CB_PASS);
+  printf("fit %g ppm/lsb, offset %g ppm, residual %g ppm\n", cal->ppmPerLsb, cal->ppmOffset, cal->residualPpm);
+  CB_TEST_CHECK(cal->calibrated == CB_TRUE);
+  CB_TEST_CHECK(fabs((cal->ppmPerLsb - TEST_PPM_PER_LSB) / TEST_PPM_PER_LSB) < 0.02);
+  CB_TEST_CHECK(fabsf(cal->ppmOffset) < 0.1f);
+  CB_TEST_CHECK((cal->residualPpm > 0.0f) && (cal->residualPpm < 0.1f));
+}
+
+static void test_compensation(const cb_uwbsstwr_cfocal_st *cal)
+{
+  cb_uwbsstwr_cfocal_st calCopy = *cal;
+
+  cb_test_case("compensated SS-TWR within the error model of DS-TWR");
+  for (double ppm = -20.0; ppm <= 20.0; ppm += 5.0)
+  {
+    double sumSs = 0.0, sumDs = 0.0, sumDs2 = 0.0, sumUncomp = 0.0;
+    float  bias  = 0.0f;
+
+    for (uint16_t i = 0; i < TEST_RUNS; i++)
+    {
+      test_exchange_st r = test_exchange(ppm, &calCopy, NULL);
+      sumSs     += r.sstwrError_ns;
+      sumDs     += r.dstwrError_ns;
+      sumDs2    += r.dstwrError_ns * r.dstwrError_ns;
+      sumUncomp += r.uncompError_ns;
+      bias       = r.expectedBias_cm;
+    }
+    double meanSs_cm  = (sumSs / TEST_RUNS) * DEF_UWB_SSTWR_CM_PER_NS;
+    double meanDs_cm  = (sumDs / TEST_RUNS) * DEF_UWB_SSTWR_CM_PER_NS;
+    double stdDs_cm   = sqrt((sumDs2 / TEST_RUNS) - ((sumDs / TEST_RUNS) * (sumDs / TEST_RUNS))) * DEF_UWB_SSTWR_CM_PER_NS;
+    double uncomp_cm  = (sumUncomp / TEST_RUNS) * DEF_UWB_SSTWR_CM_PER_NS;
+
+    printf("%+5.0f ppm: SS %+6.2f cm, DS %+6.2f cm (std %.2f), uncompensated %+8.1f cm, model %.2f cm\n",
+           ppm, meanSs_cm, meanDs_cm, stdDs_cm, uncomp_cm, bias);
+    CB_TEST_CHECK(fabs(meanSs_cm - meanDs_cm) <= (bias + (3.0 * stdDs_cm / sqrt(TEST_RUNS))));
+    // Uncompensated: c * Treply * e / 2, ~1 m at 10 ppm
+    CB_TEST_CHECK(fabs(uncomp_cm + cb_uwbsstwr_expected_bias_cm((float)(TEST_TREPLY_NS * 1.0e-3), (float)ppm) * ((ppm > 0.0) ? 1.0 : -1.0)) < 2.0);
+  }
+  CB_TEST_CHECK(fabsf(cb_uwbsstwr_expected_bias_cm(700.0f, 0.1f) - 1.05f) < 0.001f);
+}
+
+static void test_reply_predictor(void)
+{
+  cb_uwbsstwr_replypredictor_st predictor;
+  cb_uwbsystem_rangingtroundtreply_st treply;
+  double maxError_ns = 0.0;
+
+  cb_test_case("reply time of a scheduled RESPONSE predicted from the POLL RX timestamp");
+  cb_uwbsstwr_reply_predictor_reset(&predictor);
+  for (uint16_t i = 0; i < 200; i++)
+  {
+    // Scheduled TX: RX integer count plus a constant, and a few fractional counts of jitter
+    cb_uwbsystem_rx_tsutimestamp_st rx = {.rxTsuInt = 1000000UL + (i * 777UL), .rxTsuFrac = (uint16_t)(rand() % 512)};
+    cb_uwbsystem_tx_tsutimestamp_st tx = {.txTsuInt = rx.rxTsuInt + 87360UL, .txTsuFrac = (uint16_t)(100 + (rand() % 3))};
+
+    CB_STATUS status = cb_uwbsstwr_reply_predict(&predictor, &rx, &treply);
+    CB_TEST_CHECK((i > 0) || (status == CB_FAIL));
+    if ((status == CB_PASS) && (i > 10))
+    {
+      double predicted = cb_uwbsstwr_tsu_to_ns(treply.T_reply_int, treply.T_reply_frac);
+      double actual    = cb_uwbsstwr_tsu_to_ns(tx.txTsuInt - rx.rxTsuInt, (int16_t)tx.txTsuFrac - (int16_t)rx.rxTsuFrac);
+      maxError_ns      = fmax(maxError_ns, fabs(predicted - actual));
+    }
+    cb_uwbsstwr_reply_learn(&predictor, &rx, &tx);
+  }
+  printf("predictor max error %.3f ns, jitter %.3f ticks\n", maxError_ns, predictor.jitter_ticks);
+  CB_TEST_CHECK(predictor.count == 200);
+  CB_TEST_CHECK(maxError_ns < 0.05);     // 3 fractional counts = 0.047 ns
+}
+
+int main(void)
+{
+  cb_uwbsstwr_cfocal_st cal;
+
+  srand(1);
+  test_sign_extend();
+  test_calibration(&cal);
+  test_compensation(&cal);
+  test_reply_predictor();
+  return cb_test_result();
+}
@@ -0,0 +1,126 @@
+/**
+ * @file    test_uwb_tempcomp.c
+ * @brief   Host test of the CB_uwbtempcomp bias temperature compensation.
+ * @details The chip temperature is set through the uwb_stubs. Checks the table interpolation and
+ *          its clamping, the sampling period and smoothing of cb_uwbtempcomp_poll(), and the
+ *          rejection of invalid tables.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include "cb_test.h"
+#include "uwb_stubs.h"
+#include "CB_uwbtempcomp.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_TOLERANCE  1e-4f
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+// Unsorted on purpose: cb_uwbtempcomp_init() sorts by temperature
+static cb_uwbtempcomp_point_st s_stTestTable[3] =
+{
+  { .temperature =  60.0f, .rangeBias_cm =  4.0f, .pdoaBias_deg = { 1.0f,  2.0f,  3.0f} },
+  { .temperature = -20.0f, .rangeBias_cm = -8.0f, .pdoaBias_deg = {-1.0f, -2.0f, -3.0f} },
+  { .temperature =  20.0f, .rangeBias_cm =  0.0f, .pdoaBias_deg = { 0.0f,  0.0f,  0.0f} },
+};
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static uint8_t test_near(float value, float expected)
+{
+  return (fabsf(value - expected) < TEST_TOLERANCE) ? CB_TRUE : CB_FALSE;
+}
+
+static void test_interpolation(void)
+{
+  cb_uwbtempcomp_point_st result;
+
+  cb_test_case("linear interpolation between points, held outside the table");
+  CB_TEST_CHECK(cb_uwbtempcomp_init(s_stTestTable, 3) == CB_PASS);
+
+  cb_uwbtempcomp_interpolate(0.0f, &result);
+  CB_TEST_CHECK(test_near(result.rangeBias_cm, -4.0f));
+  CB_TEST_CHECK(test_near(result.pdoaBias_deg[EN_UWB_TEMPCOMP_PD01], -0.5f));
+  CB_TEST_CHECK(test_near(result.pdoaBias_deg[EN_UWB_TEMPCOMP_PD12], -1.5f));
+
+  cb_uwbtempcomp_interpolate(40.0f, &result);
+  CB_TEST_CHECK(test_near(result.rangeBias_cm, 2.0f));
+  CB_TEST_CHECK(test_near(result.pdoaBias_deg[EN_UWB_TEMPCOMP_PD02], 1.0f));
+
+  // Sub-cm corrections are kept
+  cb_uwbtempcomp_interpolate(21.0f, &result);
+  CB_TEST_CHECK(test_near(result.rangeBias_cm, 0.1f));
+
+  cb_uwbtempcomp_interpolate(100.0f, &result);
+  CB_TEST_CHECK(test_near(result.rangeBias_cm, 4.0f));
+  cb_uwbtempcomp_interpolate(-40.0f, &result);
+  CB_TEST_CHECK(test_near(result.rangeBias_cm, -8.0f));
+}
+
+static void test_poll(void)
+{
+  cb_test_case("sampling period and temperature smoothing");
+  CB_TEST_CHECK(cb_uwbtempcomp_init(s_stTestTable, 3) == CB_PASS);
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_range_bias_cm(), 0.0f));
+
+  // First sample is taken as is
+  g_uwbTestChipTemperature = 60.0f;
+  CB_TEST_CHECK(cb_uwbtempcomp_poll() == CB_TRUE);
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_range_bias_cm(), 4.0f));
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD12), 3.0f));
+
+  // Not before the period
+  g_uwbTestChipTemperature = 20.0f;
+  sysTickCounter += DEF_UWB_TEMPCOMP_PERIOD_MS - 1U;
+  CB_TEST_CHECK(cb_uwbtempcomp_poll() == CB_FALSE);
+
+  // 60 + (20 - 60) / 2^DEF_UWB_TEMPCOMP_FILTER_SHIFT
+  sysTickCounter += 1U;
+  CB_TEST_CHECK(cb_uwbtempcomp_poll() == CB_TRUE);
+  float filtered = 60.0f - (40.0f / (float)(1U << DEF_UWB_TEMPCOMP_FILTER_SHIFT));
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_correction()->temperature, filtered));
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_range_bias_cm(), (filtered - 20.0f) / 10.0f));
+}
+
+static void test_invalid_tables(void)
+{
+  cb_uwbtempcomp_point_st duplicate[2] = { s_stTestTable[0], s_stTestTable[0] };
+  cb_uwbtempcomp_point_st tooMany[DEF_UWB_TEMPCOMP_MAX_POINTS + 1];
+
+  cb_test_case("invalid and empty tables");
+  CB_TEST_CHECK(cb_uwbtempcomp_init(duplicate, 2) == CB_FAIL);
+  for (uint8_t i = 0; i <= DEF_UWB_TEMPCOMP_MAX_POINTS; i++)
+  {
+    tooMany[i]             = s_stTestTable[2];
+    tooMany[i].temperature = (float)i;
+  }
+  CB_TEST_CHECK(cb_uwbtempcomp_init(tooMany, DEF_UWB_TEMPCOMP_MAX_POINTS + 1) == CB_FAIL);
+  CB_TEST_CHECK(cb_uwbtempcomp_init(NULL, 1) == CB_FAIL);
+
+  // No point: no correction
+  CB_TEST_CHECK(cb_uwbtempcomp_init(NULL, 0) == CB_PASS);
+  cb_uwbtempcomp_update(50.0f);
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_range_bias_cm(), 0.0f));
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_pdoa_bias_deg(EN_UWB_TEMPCOMP_PD01), 0.0f));
+
+  // Single point: constant correction
+  CB_TEST_CHECK(cb_uwbtempcomp_init(&s_stTestTable[0], 1) == CB_PASS);
+  cb_uwbtempcomp_update(-10.0f);
+  CB_TEST_CHECK(test_near(cb_uwbtempcomp_get_range_bias_cm(), 4.0f));
+}
+
+int main(void)
+{
+  test_interpolation();
+  test_poll();
+  test_invalid_tables();
+  return cb_test_result();
+}
@@ -0,0 +1,170 @@
+/**
+ * @file    test_uwb_timesync.c
+ * @brief   Host test of the CB_uwbtimesync capture, wrap counting and network time translation.
+ * @details The true time drives a local UWB clock 25 ppm fast, wrapping at 32 bits, and the CPU
+ *          tick (sysTickCounter of the uwb_stubs). Pulses every second with 200 ns capture jitter
+ *          and two missed pulses over 30 s: the state, the drift, the translations across the
+ *          wraps and the ABS timer target are checked, then the holdover and the capture ring
+ *          overflow.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <math.h>
+#include <stdlib.h>
+#include "cb_test.h"
+#include "uwb_stubs.h"
+#include "CB_system.h"
+#include "CB_scr.h"
+#include "CB_uwbtimesync.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define TEST_DRIFT          25e-6
+#define TEST_LOCAL_OFFSET   123456789LL
+#define TEST_PULSE0_NS      5000000000LL
+#define TEST_TOLERANCE_NS   500
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+static int64_t  s_trueNs;
+static uint8_t  s_pinTriggered = 1;
+static uint32_t s_absBase;
+static uint32_t s_absTimeoutUs;
+static uint8_t  s_absOn;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+static int64_t test_local(int64_t trueNs)
+{
+  return (int64_t)llround((double)trueNs * (1.0 + TEST_DRIFT)) + TEST_LOCAL_OFFSET;
+}
+
+static void test_set_time(int64_t trueNs)
+{
+  s_trueNs       = trueNs;
+  sysTickCounter = (uint32_t)(trueNs / 1000000);
+}
+
+uint32_t cb_system_uwb_get_event_timestamp_in_ns(enUwbEventTimestampMask eventTimestampMask)
+{
+  return (uint32_t)test_local(s_trueNs);
+}
+
+uint8_t cb_gpio_is_irq_triggered(enGpioPin GPIO_Pin)                                  { return s_pinTriggered; }
+void    cb_gpio_init(stGPIO_InitTypeDef* GPIO_Init)                                   { }
+void    cb_gpio_write_pin(enGpioPin GPIO_Pin, enGPIO_PinState PinState)               { }
+void    cb_iomux_config(enIomuxGpioSelect enGpio, stIomuxGpioMode* GpioModeSet)       { }
+void    cb_scr_gpio_module_on(void)                                                   { }
+void    cb_system_uwb_configure_event_timestamp_mask(enUwbEventTimestampMask eventTimestampMask, enUwbEventIndex uwbEventIndex) { }
+void    cb_system_uwb_enable_event_timestamp(enUwbEnable enable)                      { }
+void    cb_system_uwb_insert_apb_event(enUwbEventIndex uwbEventIndex)                 { }
+void    cb_system_uwb_abs_timer_configure_event_commander(enUwbEnable control, enUwbAbsoluteTimer enAbsoluteTimer, enUwbEventControl uwbEventControl) { }
+void    cb_system_uwb_abs_timer_clear_internal_occurence(enUwbAbsoluteTimer enAbsoluteTimer) { }
+void    cb_system_uwb_abs_timer_on(enUwbAbsoluteTimer enAbsoluteTimer)                { s_absOn = 1; }
+
+void cb_system_uwb_abs_timer_configure_timeout_value(enUwbAbsoluteTimer enAbsoluteTimer, uint32_t baseTime, uint32_t targetTimeoutTime)
+{
+  s_absBase      = baseTime;
+  s_absTimeoutUs = targetTimeoutTime;
+}
+
+static uint8_t test_near(uint64_t value, int64_t expected, int64_t tolerance)
+{
+  return (llabs((long long)value - expected) < tolerance) ? CB_TRUE : CB_FALSE;
+}
+
+/**
+ * @brief Difference of two 32-bit UWB times.
+ */
+static int32_t test_local_diff(uint32_t a, int64_t b)
+{
+  return (int32_t)(a - (uint32_t)b);
+}
+
+static void test_sync(void)
+{
+  cb_uwbtimesync_stats_st stats;
+  uint64_t networkNs;
+  uint32_t localNs;
+  int64_t  nowNs;
+
+  cb_test_case("lock over 32-bit wraps, missed pulses");
+  srand(1);
+  test_set_time(TEST_PULSE0_NS);
+  cb_uwbtimesync_init(EN_UWB_TIMESYNC_SLAVE);
+  CB_TEST_CHECK(cb_uwbtimesync_now(&networkNs) == CB_FAIL);
+  CB_TEST_CHECK(cb_uwbtimesync_set_pulse_index(1000) == CB_FAIL);
+  for (int k = 0; k < 30; k++)
+  {
+    if ((k == 10) || (k == 11))
+    {
+      continue;
+    }
+    test_set_time(TEST_PULSE0_NS + ((int64_t)k * 1000000000LL) + (rand() % 200));
+    cb_uwbtimesync_gpio_irqcb();
+    test_set_time(s_trueNs + 3000000);
+    cb_uwbtimesync_process();
+  }
+  CB_TEST_CHECK(cb_uwbtimesync_get_state() == EN_UWB_TIMESYNC_SYNCED);
+  cb_uwbtimesync_get_stats(&stats);
+  printf("drift %.4f ppm, missed %u, outliers %u, jitter rms %.1f ns, residual rms %.1f ns\n",
+         stats.driftPpm, stats.model.missed, stats.model.outliers, stats.jitterRmsNs, stats.residualRmsNs);
+  CB_TEST_CHECK(fabsf(stats.driftPpm - 25.0f) < 0.2f);
+  CB_TEST_CHECK((stats.model.missed == 2) && (stats.model.outliers == 0) && (stats.captureLost == 0));
+
+  cb_test_case("translations and ABS timer target");
+  // 30 s: the 32-bit UWB time wrapped 7 times
+  CB_TEST_CHECK(cb_uwbtimesync_set_pulse_index(1000) == CB_PASS);
+  nowNs = TEST_PULSE0_NS + 29500000000LL;             // Half a period after the last pulse
+  test_set_time(nowNs);
+  CB_TEST_CHECK((cb_uwbtimesync_now(&networkNs) == CB_PASS) && test_near(networkNs, 1000500000000LL, TEST_TOLERANCE_NS));
+  CB_TEST_CHECK((cb_uwbtimesync_local_to_network((uint32_t)test_local(nowNs + 1500000000LL), &networkNs) == CB_PASS) &&
+                test_near(networkNs, 1002000000000LL, TEST_TOLERANCE_NS));
+  CB_TEST_CHECK((cb_uwbtimesync_local_to_network((uint32_t)test_local(nowNs - 1500000000LL), &networkNs) == CB_PASS) &&
+                test_near(networkNs, 999000000000LL, TEST_TOLERANCE_NS));
+  CB_TEST_CHECK(cb_uwbtimesync_network_to_local(1001000000000ULL, &localNs) == CB_PASS);
+  CB_TEST_CHECK(abs(test_local_diff(localNs, test_local(nowNs + 500000000LL))) < TEST_TOLERANCE_NS);
+
+  cb_uwbframework_trx_scheduledconfig_st config = { .absTimer = EN_UWB_ABSOLUTE_TIMER_0, .eventCtrlMask = EN_UWBCTRL_TX_START_MASK };
+  CB_TEST_CHECK((cb_uwbtimesync_configure_scheduled_trx(&config, 1001200000000ULL) == CB_PASS) && s_absOn);
+  printf("ABS timer target %d ns from the true time\n", test_local_diff(s_absBase + (s_absTimeoutUs * 1000U), test_local(nowNs + 700000000LL)));
+  CB_TEST_CHECK(abs(test_local_diff(s_absBase + (s_absTimeoutUs * 1000U), test_local(nowNs + 700000000LL))) < TEST_TOLERANCE_NS);
+  CB_TEST_CHECK(test_local_diff(s_absBase, test_local(nowNs)) <= 0);   // Base not after now
+  CB_TEST_CHECK(cb_uwbtimesync_configure_scheduled_trx(&config, 999000000000ULL) == CB_FAIL);    // Past
+  CB_TEST_CHECK(cb_uwbtimesync_configure_scheduled_trx(&config, 1004000000000ULL) == CB_FAIL);   // More than 2 s ahead
+}
+
+static void test_holdover(void)
+{
+  cb_uwbtimesync_stats_st stats;
+  uint64_t networkNs;
+
+  cb_test_case("holdover, pin not triggered, capture ring overflow");
+  test_set_time(TEST_PULSE0_NS + 33500000000LL);
+  cb_uwbtimesync_process();
+  CB_TEST_CHECK(cb_uwbtimesync_get_state() == EN_UWB_TIMESYNC_HOLDOVER);
+  CB_TEST_CHECK((cb_uwbtimesync_now(&networkNs) == CB_PASS) && test_near(networkNs, 1004500000000LL, 2000));
+
+  s_pinTriggered = 0;
+  cb_uwbtimesync_gpio_irqcb();
+  s_pinTriggered = 1;
+  for (uint8_t i = 0; i < (DEF_UWB_TIMESYNC_CAPTURE_NUM + 2); i++)
+  {
+    cb_uwbtimesync_gpio_irqcb();
+  }
+  cb_uwbtimesync_get_stats(&stats);
+  CB_TEST_CHECK(stats.captureLost == 2);
+}
+
+int main(void)
+{
+  test_sync();
+  test_holdover();
+  return cb_test_result();
+}
@@ -0,0 +1,74 @@
+/**
+ * @file    uwb_stubs.c
+ * @brief   Host versions of the system and framework functions used by the UWB midlayer modules.
+ * @details sysTickCounter is only advanced by the tests.
+ * @author  Chipsbank
+ * @date    2024
+ */
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include <string.h>
+#include "uwb_stubs.h"
+#include "CB_system.h"
+#include "CB_uwbframework.h"
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+volatile uint32_t sysTickCounter;
+
+cb_uwbsystem_rx_signalinfo_st  g_uwbTestSignalInfo;
+cb_uwbsystem_rx_cir_iqdata_st  g_uwbTestCir[DEF_UWB_TEST_CIR_SIZE];
+uint16_t                       g_uwbTestCirCtlIdx;
+uint32_t                       g_uwbTestCirReads;
+uint8_t                        g_uwbTestCfoGainBypass;
+cb_uwbsystem_rx_dbb_config_st  g_uwbTestCfoGainConfig;
+float                          g_uwbTestChipTemperature;
+
+//-------------------------------
+// FUNCTION BODY SECTION
+//-------------------------------
+uint32_t cb_hal_get_tick(void)
+{
+  return sysTickCounter;
+}
+
+CB_STATUS cb_hal_is_time_elapsed(uint32_t start_tick, uint32_t timeout_ms)
+{
+  return ((sysTickCounter - start_tick) >= timeout_ms) ? CB_PASS : CB_FAIL;
+}
+
+cb_uwbsystem_rx_signalinfo_st cb_framework_uwb_get_rx_rssi(uint8_t rssiRxPorts)
+{
+  return g_uwbTestSignalInfo;
+}
+
+void cb_framework_uwb_store_rx_cir_register(cb_uwbsystem_rx_cir_iqdata_st* destArray, cb_uwbsystem_rxport_en enRxPort, uint32_t startingPosition, uint32_t numSamples)
+{
+  memcpy(destArray, &g_uwbTestCir[startingPosition], numSamples * sizeof(cb_uwbsystem_rx_cir_iqdata_st));
+  g_uwbTestCirReads++;
+}
+
+float cb_system_get_chip_temperature(void)
+{
+  return g_uwbTestChipTemperature;
+}
+
+uint16_t cb_system_uwb_get_rx_cir_ctl_idx(void)
+{
+  return g_uwbTestCirCtlIdx;
+}
+
+void cb_framework_uwb_rxconfig_cfo_gain(cb_uwbsystem_rxconfig_cfo_gain_en enReset, cb_uwbsystem_rx_dbb_config_st* stRxCfg_CfoGainBypass)
+{
+  if (enReset == EN_UWB_CFO_GAIN_SET)
+  {
+    g_uwbTestCfoGainConfig = *stRxCfg_CfoGainBypass;
+    g_uwbTestCfoGainBypass = CB_TRUE;
+  }
+  else
+  {
+    g_uwbTestCfoGainBypass = CB_FALSE;
+  }
+}
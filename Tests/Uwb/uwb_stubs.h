@@ -0,0 +1,34 @@
+/**
+ * @file    uwb_stubs.h
+ * @brief   Host versions of the system and framework functions used by the UWB midlayer modules.
+ * @details The real SDK headers are used; the functions below only record their calls and return
+ *          the values set by the test in g_uwbTest*.
+ * @author  Chipsbank
+ * @date    2024
+ */
+#ifndef __UWB_STUBS_H
+#define __UWB_STUBS_H
+
+//-------------------------------
+// INCLUDE SECTION
+//-------------------------------
+#include "CB_system_types.h"
+#include "NonLIB_sharedUtils.h"
+
+//-------------------------------
+// DEFINE SECTION
+//-------------------------------
+#define DEF_UWB_TEST_CIR_SIZE   256
+
+//-------------------------------
+// GLOBAL VARIABLE SECTION
+//-------------------------------
+extern cb_uwbsystem_rx_signalinfo_st  g_uwbTestSignalInfo;              /**< Returned by cb_framework_uwb_get_rx_rssi() */
+extern cb_uwbsystem_rx_cir_iqdata_st  g_uwbTestCir[DEF_UWB_TEST_CIR_SIZE]; /**< Read by cb_framework_uwb_store_rx_cir_register() */
+extern uint16_t                       g_uwbTestCirCtlIdx;               /**< Returned by cb_system_uwb_get_rx_cir_ctl_idx() */
+extern uint32_t                       g_uwbTestCirReads;                /**< Calls of cb_framework_uwb_store_rx_cir_register() */
+extern uint8_t                        g_uwbTestCfoGainBypass;           /**< CB_TRUE after EN_UWB_CFO_GAIN_SET, CB_FALSE after a reset */
+extern cb_uwbsystem_rx_dbb_config_st  g_uwbTestCfoGainConfig;           /**< Last EN_UWB_CFO_GAIN_SET configuration */
+extern float                          g_uwbTestChipTemperature;         /**< Returned by cb_system_get_chip_temperature() */
+
+#endif /*__UWB_STUBS_H*/
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Delta firmware update patch tool for the DFU of Components/Midlayer/Dfu (dfu_delta.h).
+
+    dfu_delta.py diff [--ab] BASE NEW PATCH   make a patch rebuilding NEW from BASE
+    dfu_delta.py apply [--ab] BASE PATCH NEW  rebuild NEW, as the device does
+
+BASE and NEW are the application images: a .bin from fromelf, or the .axf of the Keil build
+(Objects/CBU5000V210.axf), whose load segments are laid out from the lowest address.
+BASE must be the image confirmed on the device (its CRC is in the patch and in the DFU start
+command). The diff prints the parameters of the DFU start and verify commands.
+
+Without --ab the new image is written to the backup bank, which is erased when the update starts
+and overlaps the end of the application bank: no COPY reads base bytes from it.
+With --ab (DFU_AB_BOOT) NEW must be linked for the bank BASE does not run from, the bank named in
+the DFU start response; the banks are told apart by the reset vector.
+"""
+
+import struct
+import sys
+import zlib
+
+MAGIC = 0x31464444          # "DDF1"
+OP_END = 0x00
+OP_COPY = 0x01
+OP_INSERT = 0x02
+COPY_MAX = 0x1000           # DFU_DELTA_COPY_MAX
+APP_BANK = 0x05000          # APP_BANK_ADDRESS of dfu_handler.c, flash address
+BACKUP_BANK = 0x3E800       # BACKUP_BANK_ADDRESS
+BANK_A = 0x05000            # DFU_BANK_A_ADDRESS of dfu_abboot.h
+BANK_B = 0x3F000            # DFU_BANK_B_ADDRESS
+AB_BANK_SIZE = 0x3A000      # DFU_BANK_SIZE
+MCU_OFFSET = 0x1000         # Flash address - MCU address
+INSERT_MAX = 0x1000
+BLOCK = 8                   # Match seed length
+MIN_COPY = 12               # Shorter matches cost more than the bytes
+CANDIDATES = 32             # Base positions tried per seed
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def load_image(path):
+    """Flat image of a .bin, or of the PT_LOAD segments of an ELF (.axf)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF':
+        return data
+    phoff, = struct.unpack_from('<I', data, 0x1C)
+    phentsize, phnum = struct.unpack_from('<HH', data, 0x2A)
+    segments = []
+    for i in range(phnum):
+        p_type, p_offset, _, p_paddr, p_filesz = struct.unpack_from('<IIIII', data, phoff + i * phentsize)
+        if p_type == 1 and p_filesz:
+            segments.append((p_paddr, data[p_offset:p_offset + p_filesz]))
+    # Load view: execution regions in RAM are stored after the ROM region by the linker
+    segments.sort()
+    base = segments[0][0]
+    rom = [s for s in segments if s[0] < 0x20000000]
+    ram = [s for s in segments if s[0] >= 0x20000000]
+    image = bytearray()
+    for addr, seg in rom:
+        image[addr - base:addr - base + len(seg)] = seg
+    for _, seg in ram:
+        image += seg
+    return bytes(image)
+
+
+def image_bank(image):
+    """A/B bank an image is linked for, from its reset vector."""
+    reset, = struct.unpack_from('<I', image, 4)
+    flash = (reset & ~1) + MCU_OFFSET
+    for bank in (BANK_A, BANK_B):
+        if bank <= flash < bank + AB_BANK_SIZE:
+            return bank
+    raise ValueError('reset vector 0x%08X outside both banks' % reset)
+
+
+def diff(base, new, usable):
+    """Patch rebuilding NEW; COPY only reads base[:usable]."""
+    base = base[:usable]
+    index = {}
+    for i in range(len(base) - BLOCK + 1):
+        index.setdefault(base[i:i + BLOCK], []).append(i)
+
+    ops = []
+    literal = bytearray()
+    pos = 0
+    last = 0          # Base position following the last copy: code usually moves in one piece
+
+    def flush_literal():
+        for i in range(0, len(literal), INSERT_MAX):
+            chunk = literal[i:i + INSERT_MAX]
+            ops.append(bytes([OP_INSERT]) + varint(len(chunk)) + bytes(chunk))
+        literal.clear()
+
+    while pos < len(new):
+        best_len, best_off = 0, 0
+        candidates = list(index.get(new[pos:pos + BLOCK], ())[:CANDIDATES])
+        if last < len(base):
+            candidates.insert(0, last)
+        for off in candidates:
+            n = 0
+            limit = min(len(base) - off, len(new) - pos, COPY_MAX)
+            while n < limit and base[off + n] == new[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_off = n, off
+        if best_len >= MIN_COPY:
+            flush_literal()
+            ops.append(bytes([OP_COPY]) + varint(best_off) + varint(best_len))
+            pos += best_len
+            last = best_off + best_len
+        else:
+            literal.append(new[pos])
+            pos += 1
+            last += 1
+    flush_literal()
+    return b''.join(ops) + bytes([OP_END])
+
+
+def usable_base(base, ab):
+    """Base bytes left readable while the update bank is written."""
+    if ab:
+        return len(base)        # The banks do not overlap
+    return min(len(base), BACKUP_BANK - APP_BANK)
+
+
+def make_patch(base, new, ab):
+    if ab and image_bank(new) == image_bank(base):
+        raise ValueError('NEW is linked for bank 0x%05X, the bank BASE runs from' % image_bank(base))
+    usable = usable_base(base, ab)
+    header = struct.pack('<IIII', MAGIC, len(base), zlib.crc32(base), len(new))
+    return header + diff(base, new, usable)
+
+
+def apply(base, patch, ab=False):
+    magic, base_size, base_crc, new_size = struct.unpack_from('<IIII', patch, 0)
+    if magic != MAGIC or base_size != len(base) or base_crc != zlib.crc32(base):
+        raise ValueError('patch made for another base image')
+    out = bytearray()
+    pos = 16
+    while True:
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            off, pos = read_varint(patch, pos)
+            n, pos = read_varint(patch, pos)
+            if not 0 < n <= COPY_MAX or off + n > usable_base(base, ab):
+                raise ValueError('bad copy')
+            out += base[off:off + n]
+        elif op == OP_INSERT:
+            n, pos = read_varint(patch, pos)
+            out += patch[pos:pos + n]
+            pos += n
+        else:
+            raise ValueError('bad operation 0x%02x' % op)
+    if len(out) != new_size:
+        raise ValueError('size mismatch')
+    return bytes(out)
+
+
+def main(argv):
+    ab = '--ab' in argv[2:]
+    argv = [a for a in argv if a != '--ab']
+    if len(argv) != 5 or argv[1] not in ('diff', 'apply'):
+        sys.stderr.write(__doc__)
+        return 2
+    base = load_image(argv[2])
+    if argv[1] == 'diff':
+        new = load_image(argv[3])
+        patch = make_patch(base, new, ab)
+        assert apply(base, patch, ab) == new
+        with open(argv[4], 'wb') as f:
+            f.write(patch)
+        print('base %d bytes crc 0x%08X, new %d bytes crc 0x%08X, patch %d bytes (%.1f%%)' %
+              (len(base), zlib.crc32(base), len(new), zlib.crc32(new), len(patch), 100.0 * len(patch) / len(new)))
+        print('start: version, 0x01, base crc 0x%08X; verify: crc 0x%08X' % (zlib.crc32(base), zlib.crc32(new)))
+    else:
+        with open(argv[3], 'rb') as f:
+            new = apply(base, f.read(), ab)
+        with open(argv[4], 'wb') as f:
+            f.write(new)
+        print('new %d bytes crc 0x%08X' % (len(new), zlib.crc32(new)))
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main(sys.argv))
+    except ValueError as err:
+        sys.stderr.write('error: %s\n' % err)
+        sys.exit(1)
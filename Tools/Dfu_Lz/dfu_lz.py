@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Compressed firmware image tool for the DFU of Components/Midlayer/Dfu (dfu_lz.h).
+
+    dfu_lz.py compress   IMAGE STREAM   compress an application image
+    dfu_lz.py decompress STREAM IMAGE   expand a stream, as the device does
+
+IMAGE is a .bin from fromelf, or the .axf of the Keil build (Objects/CBU5000V210.axf).
+The compression prints the parameters of the DFU start and verify commands: size and CRC
+are those of the image, not of the stream.
+"""
+
+import os
+import struct
+import sys
+import zlib
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Dfu_Delta'))
+from dfu_delta import load_image  # noqa: E402
+
+MAGIC = 0x315A4C44          # "DLZ1"
+WINDOW = 0x400              # DFU_LZ_WINDOW_SIZE
+MIN_MATCH = 3               # DFU_LZ_MIN_MATCH
+LEN_EXT = 63                # DFU_LZ_LEN_EXT
+MAX_MATCH = LEN_EXT + MIN_MATCH + 255
+CANDIDATES = 64             # Window positions tried per match
+
+
+def longest_match(data, pos, chain):
+    best_len, best_dist = 0, 0
+    limit = min(len(data) - pos, MAX_MATCH)
+    for p in reversed(chain.get(data[pos:pos + MIN_MATCH], ())[-CANDIDATES:]):
+        if pos - p > WINDOW:
+            break
+        n = 0
+        while n < limit and data[p + n] == data[pos + n]:
+            n += 1
+        if n > best_len:
+            best_len, best_dist = n, pos - p
+            if n == limit:
+                break
+    return best_len, best_dist
+
+
+def compress(data):
+    chain = {}
+    items = []
+    pos = 0
+
+    def insert(start, end):
+        for k in range(start, end):
+            chain.setdefault(data[k:k + MIN_MATCH], []).append(k)
+
+    while pos < len(data):
+        n, dist = longest_match(data, pos, chain)
+        # Lazy matching: a literal first is better if the next position matches longer
+        if n >= MIN_MATCH and n < MAX_MATCH:
+            insert(pos, pos + 1)
+            n1, _ = longest_match(data, pos + 1, chain)
+            if n1 > n + 1:
+                items.append(data[pos])
+                pos += 1
+                continue
+            insert(pos + 1, pos + n)
+        else:
+            insert(pos, pos + max(n, 1))
+        if n >= MIN_MATCH:
+            items.append((dist, n))
+            pos += n
+        else:
+            items.append(data[pos])
+            pos += 1
+
+    out = bytearray(struct.pack('<II', MAGIC, len(data)))
+    for g in range(0, len(items), 8):
+        flags = 0
+        body = bytearray()
+        for bit, item in enumerate(items[g:g + 8]):
+            if isinstance(item, int):
+                flags |= 1 << bit
+                body.append(item)
+            else:
+                dist, n = item
+                code = min(n - MIN_MATCH, LEN_EXT)
+                body += struct.pack('<H', (dist - 1) | (code << 10))
+                if code == LEN_EXT:
+                    body.append(n - MIN_MATCH - LEN_EXT)
+        out.append(flags)
+        out += body
+    return bytes(out)
+
+
+def decompress(stream):
+    magic, size = struct.unpack_from('<II', stream, 0)
+    if magic != MAGIC or size == 0:
+        raise ValueError('not a compressed image')
+    out = bytearray()
+    pos = 8
+    while len(out) < size:
+        flags = stream[pos]
+        pos += 1
+        for bit in range(8):
+            if len(out) == size:
+                break
+            if flags & (1 << bit):
+                out.append(stream[pos])
+                pos += 1
+                continue
+            code, = struct.unpack_from('<H', stream, pos)
+            pos += 2
+            dist, n = (code & 0x3FF) + 1, (code >> 10) + MIN_MATCH
+            if code >> 10 == LEN_EXT:
+                n += stream[pos]
+                pos += 1
+            if dist > len(out) or len(out) + n > size:
+                raise ValueError('bad match')
+            for _ in range(n):
+                out.append(out[-dist])
+    if pos != len(stream):
+        raise ValueError('data after the image')
+    return bytes(out)
+
+
+def main(argv):
+    if len(argv) != 4 or argv[1] not in ('compress', 'decompress'):
+        sys.stderr.write(__doc__)
+        return 2
+    if argv[1] == 'compress':
+        image = load_image(argv[2])
+        stream = compress(image)
+        assert decompress(stream) == image
+        with open(argv[3], 'wb') as f:
+            f.write(stream)
+        print('image %d bytes crc 0x%08X, stream %d bytes (%.1f%%)' %
+              (len(image), zlib.crc32(image), len(stream), 100.0 * len(stream) / len(image)))
+        print('start: version, 0x02; verify: size %d, crc 0x%08X' % (len(image), zlib.crc32(image)))
+    else:
+        with open(argv[2], 'rb') as f:
+            image = decompress(f.read())
+        with open(argv[3], 'wb') as f:
+            f.write(image)
+        print('image %d bytes crc 0x%08X' % (len(image), zlib.crc32(image)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
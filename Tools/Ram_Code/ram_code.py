@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""RAM code placement tool for the ER_RAM_CODE region of the UWB example scatter files.
+
+    ram_code.py report AXF [options]   hot set of functions and its RAM cost
+    ram_code.py check  AXF             RAM regions of a linked image
+
+AXF is the image of the Keil build (Objects/CBU5000V210.axf).
+
+The hot set starts from the seeds: functions already in ER_RAM_CODE (CB_RAM_CODE), the interrupt
+handlers and regions with calls in the profile dumps (command "p" of uwb_CLI, AppSysProfile.h),
+and --seed. It follows the direct calls of the code, B/BL decoded from the image, through the
+functions still in flash. The report lists them with their size; --out writes the scatter file
+selectors of those in flash (ram_code.sct next to ARMCM33_ac6.sct, included by ER_RAM_CODE).
+Calls through function pointers are not seen: seed their targets. C library functions (floating
+point, memcpy) have no section of their own to select and stay in flash, called through a veneer.
+
+report options:
+    --profile FILE   profile dump, may be repeated
+    --seed NAME      hot function, may be repeated
+    --placed NAME    function already given CB_RAM_CODE when AXF predates it, may be repeated
+    --stop NAME      function left in flash with its callees, e.g. waiting on the hardware (PLL
+                     lock, calibration), may be repeated; a trailing * matches a prefix
+    --max-size N     functions larger than N bytes stay in flash (default 1024)
+    --out FILE       write the selectors of the functions to move
+
+check verifies that ER_RAM_CODE and the RAM regions (RW data, UWB banks, UART SDMA buffers, heap
+and stack) do not overlap and fit in RAM, and prints the free space of each; exit status 1 if not.
+"""
+
+import re
+import struct
+import sys
+
+RAM_BASE = 0x20000000
+RAM_SIZE = 0x00018000
+RAM_CODE_REGION = 'ER_RAM_CODE'
+MAX_SIZE = 1024
+COLD = re.compile(r'printf|scanf|^_?_?assert|^_sys_|^__main$|^main$')
+CLIB = re.compile(r'^_[a-z]|^__(rt|hardfp|aeabi|ARM)_|^(mem|str)[a-z]+$|^abs$')   # no section of their own
+
+
+def load_elf(path):
+    """Sections {name: [(addr, size, offset, flags, type)]} and functions {name: (addr, size)}."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF':
+        raise ValueError('%s is not an ELF image' % path)
+    shoff, = struct.unpack_from('<I', data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2E)
+    headers = [struct.unpack_from('<IIIIIIIIII', data, shoff + i * shentsize) for i in range(shnum)]
+    strtab = headers[shstrndx]
+
+    def name_at(table, index):
+        start = table[4] + index
+        return data[start:data.index(b'\0', start)].decode()
+
+    sections = []
+    functions = {}
+    data_ranges = []
+    for sh in headers:
+        sections.append((name_at(strtab, sh[0]), sh[3], sh[5], sh[4], sh[2], sh[1]))
+    for sh in headers:
+        if sh[1] != 2:              # SHT_SYMTAB
+            continue
+        names = headers[sh[6]]
+        mapping = []
+        for i in range(sh[5] // 16):
+            st_name, st_value, st_size, st_info, _, _ = struct.unpack_from('<IIIBBH', data, sh[4] + i * 16)
+            name = name_at(names, st_name)
+            if (st_info & 0xF) == 2 and st_size:          # STT_FUNC
+                functions.setdefault(name, (st_value & ~1, st_size))
+            elif name[:2] in ('$t', '$d', '$a'):
+                mapping.append((st_value & ~1, name[1]))
+        mapping.sort()
+        for i, (addr, kind) in enumerate(mapping):
+            if kind == 'd':
+                end = mapping[i + 1][0] if i + 1 < len(mapping) else addr
+                data_ranges.append((addr, end))
+    return data, sections, functions, data_ranges
+
+
+def section_of(sections, addr):
+    for name, start, size, _, flags, kind in sections:
+        if (flags & 0x2) and start <= addr < start + size:          # SHF_ALLOC
+            return name
+    return None
+
+
+def read_code(data, sections, addr, size):
+    for _, start, length, offset, flags, kind in sections:
+        if (flags & 0x2) and kind == 1 and start <= addr and addr + size <= start + length:
+            return data[offset + addr - start:offset + addr - start + size]
+    return b''
+
+
+def calls_of(code, addr, starts, data_ranges):
+    """Targets of BL, B.W and B at function starts: calls and tail calls."""
+    targets = set()
+    i = 0
+    while i + 2 <= len(code):
+        pc = addr + i
+        if any(lo <= pc < hi for lo, hi in data_ranges):
+            i += 2
+            continue
+        hw1, = struct.unpack_from('<H', code, i)
+        if (hw1 >> 11) in (0x1D, 0x1E, 0x1F) and i + 4 <= len(code):
+            hw2, = struct.unpack_from('<H', code, i + 2)
+            if (hw1 >> 11) == 0x1E and (hw2 & 0xD000) in (0xD000, 0x9000):      # BL, B.W T4
+                s = (hw1 >> 10) & 1
+                i1 = 1 - (((hw2 >> 13) & 1) ^ s)
+                i2 = 1 - (((hw2 >> 11) & 1) ^ s)
+                offset = (s << 24) | (i1 << 23) | (i2 << 22) | ((hw1 & 0x3FF) << 12) | ((hw2 & 0x7FF) << 1)
+                if s:
+                    offset -= 1 << 25
+                target = pc + 4 + offset
+                if target in starts:
+                    targets.add(starts[target])
+            i += 4
+            continue
+        if (hw1 >> 11) == 0x1C:                                                   # B T2
+            offset = (hw1 & 0x7FF) << 1
+            if offset & 0x800:
+                offset -= 0x1000
+            target = pc + 4 + offset
+            if target in starts and not (addr <= target < addr + len(code)):
+                targets.add(starts[target])
+        i += 2
+    return targets
+
+
+def load_profile(path, functions):
+    """Handlers and regions of a profile dump with at least one call, and their time in us."""
+    seeds = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) >= 3 and fields[0] in functions and fields[1].isdigit() and int(fields[1]) > 0:
+                seeds[fields[0]] = seeds.get(fields[0], 0) + int(fields[2])
+    return seeds
+
+
+def report(path, profiles, seeds, placed, stops, max_size, out):
+    data, sections, functions, data_ranges = load_elf(path)
+    starts = {}
+    for name, (addr, _) in functions.items():
+        starts.setdefault(addr, name)
+    in_ram = set(n for n, (a, _) in functions.items() if section_of(sections, a) == RAM_CODE_REGION)
+    in_ram |= set(n for n in placed if n in functions)
+
+    hot = {}
+    for name in sorted(in_ram):
+        hot[name] = 'CB_RAM_CODE'
+    for profile in profiles:
+        for name, us in sorted(load_profile(profile, functions).items(), key=lambda x: -x[1]):
+            hot.setdefault(name, 'profile %u us' % us)
+    for name in seeds:
+        if name not in functions:
+            sys.stderr.write('warning: no function %s\n' % name)
+            continue
+        hot.setdefault(name, 'seed')
+
+    order = list(hot)
+    skipped = {}
+    i = 0
+    while i < len(order):
+        name = order[i]
+        addr, size = functions[name]
+        for callee in sorted(calls_of(read_code(data, sections, addr, size), addr, starts, data_ranges)):
+            if callee in hot or callee in skipped:
+                continue
+            callee_size = functions[callee][1]
+            stopped = any(callee == s or (s.endswith('*') and callee.startswith(s[:-1])) for s in stops)
+            if callee not in in_ram and CLIB.search(callee):
+                skipped[callee] = (name, 'C library')
+                continue
+            if callee not in in_ram and (stopped or callee_size > max_size or COLD.search(callee)):
+                skipped[callee] = (name, 'stays in flash')
+                continue
+            hot[callee] = 'from ' + name
+            order.append(callee)
+        i += 1
+
+    move = [n for n in order if n not in in_ram and section_of(sections, functions[n][0]) != RAM_CODE_REGION]
+    total_ram = sum(functions[n][1] for n in order if n in in_ram)
+    total_move = sum(functions[n][1] for n in move)
+    print('%-48s %6s  %-8s %s' % ('function', 'bytes', 'now', 'hot because'))
+    for name in order:
+        place = 'RAM' if name in in_ram else 'flash'
+        print('%-48s %6u  %-8s %s' % (name, functions[name][1], place, hot[name]))
+    for name, (caller, why) in sorted(skipped.items()):
+        print('%-48s %6u  %-8s %s (called from %s)' % (name, functions[name][1], 'flash', why, caller))
+    print('hot set: %u functions, %u bytes: %u in RAM, %u to move (%u functions)' %
+          (len(order), total_ram + total_move, total_ram, total_move, len(move)))
+    region = [s for s in sections if s[0] == RAM_CODE_REGION]
+    if region:
+        print('%s: 0x%08X, %u bytes used' % (RAM_CODE_REGION, region[0][1], region[0][2]))
+    if out:
+        with open(out, 'w') as f:
+            f.write('; Generated by Tools/Ram_Code/ram_code.py from %s\n' % path.replace('\\', '/'))
+            f.write('; %u bytes on top of the CB_RAM_CODE functions, veneers not included\n' % total_move)
+            for name in move:
+                f.write('   *(.text.%s)\n' % name)
+        print('wrote %s' % out)
+    return 0
+
+
+def check(path):
+    _, sections, _, _ = load_elf(path)
+    ram = sorted((start, size, name) for name, start, size, _, flags, _ in sections
+                 if (flags & 0x2) and RAM_BASE <= start < RAM_BASE + RAM_SIZE)
+    ok = True
+    end = RAM_BASE
+    print('%-32s %10s %10s %8s' % ('region', 'start', 'end', 'gap'))
+    for start, size, name in ram:
+        if start < end:
+            print('%-32s 0x%08X 0x%08X  overlaps the previous region' % (name, start, start + size))
+            ok = False
+        else:
+            print('%-32s 0x%08X 0x%08X %8u' % (name, start, start + size, start - end))
+        end = max(end, start + size)
+    if end > RAM_BASE + RAM_SIZE:
+        print('RAM overflow: ends at 0x%08X' % end)
+        ok = False
+    if not any(name == RAM_CODE_REGION for _, _, name in ram):
+        print('no %s: all the code runs from flash' % RAM_CODE_REGION)
+    print('ok' if ok else 'FAILED')
+    return 0 if ok else 1
+
+
+def main(argv):
+    if len(argv) < 3 or argv[1] not in ('report', 'check'):
+        sys.stderr.write(__doc__)
+        return 2
+    if argv[1] == 'check':
+        return check(argv[2])
+    profiles, seeds, placed, stops, max_size, out = [], [], [], [], MAX_SIZE, None
+    args = argv[3:]
+    while args:
+        if len(args) < 2:
+            sys.stderr.write(__doc__)
+            return 2
+        option, value = args[0], args[1]
+        if option == '--profile':
+            profiles.append(value)
+        elif option == '--seed':
+            seeds.append(value)
+        elif option == '--placed':
+            placed.append(value)
+        elif option == '--stop':
+            stops.append(value)
+        elif option == '--max-size':
+            max_size = int(value, 0)
+        elif option == '--out':
+            out = value
+        else:
+            sys.stderr.write(__doc__)
+            return 2
+        args = args[2:]
+    return report(argv[2], profiles, seeds, placed, stops, max_size, out)
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))